@@ -0,0 +1,108 @@
+#ifndef BME280_PAYLOADS_H
+#define BME280_PAYLOADS_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+/**
+ * @brief JSON documents published on the readings, status and events topics.
+ *
+ * The builders only read the structs they are given; main.cpp fills them from
+ * its globals and modules, and the host fleet simulator fills them with
+ * simulated values, so both publish the same documents.
+ */
+
+namespace Bme280Payloads {
+  struct Identity {
+    const char* device;
+    const char* chipId;
+    const char* firmwareVersion;
+  };
+
+  struct Readings {
+    unsigned long timestamp = 0;      // Uptime (s) when the sample was taken
+    unsigned long uptimeSeconds = 0;  // Uptime at publish
+    float temperatureC = 0.0f;
+    float humidityRh = 0.0f;
+    float pressurePa = 0.0f;
+    float altitudeM = 0.0f;
+    float pressureBaseline = 0.0f;    // Pa, 0 = tracking disabled
+    bool replayed = false;            // Buffered while offline, published later
+    uint32_t sampleTime = 0;          // Wall-clock time of a replayed sample, 0 = unknown
+    float batteryVoltage = 0.0f;
+    int batteryPercent = -1;          // -1 = not measured
+  };
+
+  struct Event {
+    const char* type;
+    const char* severity;
+    const char* message;              // Empty = omitted
+    unsigned long timestamp = 0;
+    unsigned long uptimeSeconds = 0;
+    uint32_t freeHeap = 0;
+  };
+
+  struct Status {
+    unsigned long timestamp = 0;
+    unsigned long uptimeSeconds = 0;
+    bool wifiConnected = false;
+    int wifiRssi = -999;
+    String ipAddress;
+    uint32_t freeHeap = 0;
+    bool sensorHealthy = false;
+    unsigned int wifiReconnects = 0;
+    unsigned int sensorReadFailures = 0;
+    int deepSleepSeconds = 0;
+    int sensorIntervalSeconds = 0;
+    float pressureBaseline = 0.0f;    // Pa, 0 = tracking disabled
+
+    // Deep-sleep wake, ms since boot; wakeToPublishMs = 0 outside a wake
+    unsigned long wakeToPublishMs = 0;
+    unsigned long wakeWifiMs = 0;
+    unsigned long wakeConversionWaitMs = 0;  // Forced measurement still running when read
+    const char* wakeFlow = "overlapped";  // "sequential" in a WAKE_SEQUENTIAL_BASELINE build
+
+    static const uint8_t LOOP_BUCKETS = 16;  // LoopProfiler::HISTOGRAM_BUCKETS
+    uint32_t loopMaxMs = 0;
+    uint32_t loopStalls = 0;
+    const char* loopLastStallRegion = "none";
+    uint32_t loopHistogram[LOOP_BUCKETS] = {};
+
+    float txPowerDbm = 0.0f;
+    uint32_t txPowerStepsDown = 0;
+    uint32_t txPowerStepsUp = 0;
+    float txEnergyPerPublishUj = 0.0f;
+    float txEnergySavedPct = 0.0f;
+
+    const char* resetReason = nullptr;  // nullptr = no ResetTracker (ESP8266)
+    uint32_t bootCount = 0;
+    uint32_t resetNvsWrites = 0;
+    float resetNvsWritesPerDay = 0.0f;
+    uint32_t bootDelaySavedMs = 0;
+
+    static const uint8_t CONFIG_SLOTS = 2;  // ConfigStore::SLOT_COUNT
+    uint32_t configCommits = 0;
+    uint32_t configSlotWrites[CONFIG_SLOTS] = {};
+    uint32_t configCommitsBoot = 0;
+    uint32_t configCoalesced = 0;
+    uint32_t configCommitFailures = 0;
+    bool configPending = false;
+
+    uint32_t mqttPayloadMaxBytes = 0;
+    uint32_t mqttPublishMaxUs = 0;
+
+    bool configPortalActive = false;
+    uint32_t configPortalSessions = 0;
+    uint32_t configPortalLastMs = 0;
+
+    unsigned int readingsBuffered = 0;
+    unsigned int readingsReplayed = 0;
+    unsigned int readingsDropped = 0;
+  };
+
+  void buildReadings(JsonDocument& doc, const Identity& id, const Readings& readings);
+  void buildEvent(JsonDocument& doc, const Identity& id, const Event& event);
+  void buildStatus(JsonDocument& doc, const Identity& id, const Status& status);
+}
+
+#endif // BME280_PAYLOADS_H
@@ -18,6 +18,14 @@
   static const int BME280_I2C_SCL = 22;  // ESP32 SCL
 #endif
 static const int BME280_I2C_ADDR = 0x76;  // I2C address (0x76 if SDO low, 0x77 if SDO high)
+static const unsigned long BME280_FORCED_MEASUREMENT_MS = 50;  // One forced measurement at T x2, P x16, H x2 (~46 ms max)
+
+// 1 = sequential wake, timed for comparison: the forced measurement is started
+// and waited for after WiFi associates instead of overlapping association.
+// Build one node with -DWAKE_SEQUENTIAL_BASELINE=1 to measure the baseline.
+#ifndef WAKE_SEQUENTIAL_BASELINE
+  #define WAKE_SEQUENTIAL_BASELINE 0
+#endif
 
 // Device board type - Auto-detected from build environment
 #if defined(ESP32S3)
@@ -31,6 +39,7 @@ static const int BME280_I2C_ADDR = 0x76;  // I2C address (0x76 if SDO low, 0x77
 // Timing constants
 static const unsigned long WIFI_CHECK_INTERVAL_MS = 15000;    // Check WiFi connection every 15s
 static const unsigned long SENSOR_READ_INTERVAL_MS = 30000;   // Read sensor every 30s
+#define NTP_SERVER "pool.ntp.org"                    // UTC clock for the sample_time of replayed readings
 #ifdef ESP8266
   static const int HTTP_TIMEOUT_MS = 5000;   // 5s timeout for ESP8266
 #else
@@ -114,9 +123,34 @@ static const float PRESSURE_SEA_LEVEL = 101325.0;
 //   - High altitude: ~98.0 kPa (980 hPa) for 200m elevation
 //   - Set to 0.0 to disable baseline tracking
 
+// =============================================================================
+// ADAPTIVE TX POWER
+// =============================================================================
+// TX power steps down while publishes succeed with RSSI to spare, up on failures
+static const int8_t TX_POWER_TARGET_RSSI = -67;                   // RSSI a reduction may bring the link down to
+static const int8_t TX_POWER_WEAK_RSSI = -75;                     // Step up below this
+static const uint8_t TX_POWER_DOWN_AFTER = 5;                     // Healthy publishes per step down
+static const uint16_t TX_POWER_FLOOR_HOLD = 200;                  // Publishes a failure blocks the weaker level
+
+// =============================================================================
+// LOOP PROFILER
+// =============================================================================
+// loop() iterations at or above the threshold are reported as "loop_stall" events
+static const unsigned long LOOP_STALL_THRESHOLD_MS = 500;         // Iteration time counted as a stall
+static const unsigned long LOOP_STALL_REPORT_INTERVAL_MS = 300000;  // Max one stall event per 5 min
+
+// =============================================================================
+// CONFIG PERSISTENCE
+// =============================================================================
+// Config changes are coalesced in RAM and committed once quiet (or before sleep/restart)
+static const uint16_t CONFIG_SCHEMA_VERSION = 1;                  // Bump when PersistentConfig changes
+static const unsigned long CONFIG_COMMIT_QUIET_MS = 5000;         // Commit after 5 s without changes
+static const unsigned long CONFIG_COMMIT_MAX_DELAY_MS = 60000;    // Commit at most 60 s after the first change
+
 // =============================================================================
 // RESET DETECTION & CRASH RECOVERY (ESP32 Only)
 // =============================================================================
+// Tracked in RTC memory; the window closes from a timer so setup() is not delayed
 #ifdef ESP32
   #define RESET_DETECT_TIMEOUT 2       // 2 second window for triple-reset
   // Allows time to press reset 3 times to trigger config portal
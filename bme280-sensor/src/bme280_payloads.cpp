@@ -0,0 +1,118 @@
+#include "bme280_payloads.h"
+
+namespace Bme280Payloads {
+  void buildReadings(JsonDocument& doc, const Identity& id, const Readings& readings) {
+    doc["device"] = id.device;
+    doc["chip_id"] = id.chipId;
+    doc["firmware_version"] = id.firmwareVersion;
+    doc["schema_version"] = 1;
+    doc["timestamp"] = readings.timestamp;
+    doc["uptime_seconds"] = readings.uptimeSeconds;
+    doc["temperature_c"] = readings.temperatureC;
+    doc["humidity_rh"] = readings.humidityRh;
+    doc["pressure_pa"] = readings.pressurePa;
+    doc["pressure_hpa"] = readings.pressurePa / 100.0;
+    doc["altitude_m"] = readings.altitudeM;
+
+    // Add pressure baseline tracking (barometer-style)
+    if (readings.pressureBaseline > 0) {
+      float pressureChange = readings.pressurePa - readings.pressureBaseline;
+      doc["pressure_change_pa"] = pressureChange;
+      doc["pressure_change_hpa"] = pressureChange / 100.0;
+      doc["pressure_trend"] = (pressureChange > 50) ? "rising" : (pressureChange < -50) ? "falling" : "steady";
+      doc["baseline_hpa"] = readings.pressureBaseline / 100.0;
+    }
+
+    if (!readings.replayed && readings.batteryPercent >= 0) {
+      doc["battery_voltage"] = readings.batteryVoltage;
+      doc["battery_percent"] = readings.batteryPercent;
+    }
+    if (readings.replayed) {
+      doc["replayed"] = true;
+      if (readings.sampleTime > 0) {
+        doc["sample_time"] = readings.sampleTime;  // Line timestamp for the MQTT → InfluxDB bridge
+      }
+    }
+  }
+
+  void buildEvent(JsonDocument& doc, const Identity& id, const Event& event) {
+    doc["device"] = id.device;
+    doc["chip_id"] = id.chipId;
+    doc["firmware_version"] = id.firmwareVersion;
+    doc["schema_version"] = 1;
+    doc["event"] = event.type;
+    doc["severity"] = event.severity;
+    doc["timestamp"] = event.timestamp;
+    doc["uptime_seconds"] = event.uptimeSeconds;
+    doc["free_heap"] = event.freeHeap;
+    if (event.message[0] != '\0') {
+      doc["message"] = event.message;
+    }
+  }
+
+  void buildStatus(JsonDocument& doc, const Identity& id, const Status& status) {
+    doc["device"] = id.device;
+    doc["chip_id"] = id.chipId;
+    doc["firmware_version"] = id.firmwareVersion;
+    doc["schema_version"] = 1;
+    doc["timestamp"] = status.timestamp;
+    doc["uptime_seconds"] = status.uptimeSeconds;
+    doc["wifi_connected"] = status.wifiConnected;
+    doc["wifi_rssi"] = status.wifiRssi;
+    doc["ip_address"] = status.ipAddress;
+    doc["free_heap"] = status.freeHeap;
+    doc["sensor_healthy"] = status.sensorHealthy;
+    doc["wifi_reconnects"] = status.wifiReconnects;
+    doc["sensor_read_failures"] = status.sensorReadFailures;
+    doc["deep_sleep_enabled"] = (status.deepSleepSeconds > 0);
+    doc["deep_sleep_seconds"] = status.deepSleepSeconds;
+    doc["sensor_interval_seconds"] = status.sensorIntervalSeconds;
+    if (status.pressureBaseline > 0) {
+      doc["pressure_baseline_hpa"] = status.pressureBaseline / 100.0;
+    }
+    if (status.wakeToPublishMs > 0) {
+      // Deep-sleep wake, ms since boot, measured on whichever flow was built
+      doc["wake_to_publish_ms"] = status.wakeToPublishMs;
+      doc["wake_wifi_ms"] = status.wakeWifiMs;
+      doc["wake_conversion_wait_ms"] = status.wakeConversionWaitMs;
+      doc["wake_flow"] = status.wakeFlow;
+    }
+    doc["loop_max_ms"] = status.loopMaxMs;
+    doc["loop_stalls"] = status.loopStalls;
+    doc["loop_last_stall_region"] = status.loopLastStallRegion;
+    JsonArray loopHistogram = doc["loop_histogram"].to<JsonArray>();
+    for (uint8_t i = 0; i < Status::LOOP_BUCKETS; i++) {
+      loopHistogram.add(status.loopHistogram[i]);
+    }
+    // Radio energy is estimated from payload airtime and TX current per level
+    doc["tx_power_dbm"] = status.txPowerDbm;
+    doc["tx_power_steps_down"] = status.txPowerStepsDown;
+    doc["tx_power_steps_up"] = status.txPowerStepsUp;
+    doc["tx_energy_per_publish_uj"] = status.txEnergyPerPublishUj;
+    doc["tx_energy_saved_pct"] = status.txEnergySavedPct;
+    if (status.resetReason != nullptr) {
+      doc["reset_reason"] = status.resetReason;
+      doc["boot_count"] = status.bootCount;
+      doc["reset_nvs_writes"] = status.resetNvsWrites;
+      doc["reset_nvs_writes_per_day"] = status.resetNvsWritesPerDay;
+      doc["boot_delay_saved_ms"] = status.bootDelaySavedMs;
+    }
+    doc["config_commits"] = status.configCommits;
+    JsonArray configSlotWrites = doc["config_slot_writes"].to<JsonArray>();
+    for (uint8_t i = 0; i < Status::CONFIG_SLOTS; i++) {
+      configSlotWrites.add(status.configSlotWrites[i]);
+    }
+    doc["config_commits_boot"] = status.configCommitsBoot;
+    doc["config_coalesced"] = status.configCoalesced;
+    doc["config_commit_failures"] = status.configCommitFailures;
+    doc["config_pending"] = status.configPending;
+    doc["mqtt_payload_max_bytes"] = status.mqttPayloadMaxBytes;
+    doc["mqtt_publish_max_us"] = status.mqttPublishMaxUs;
+    doc["config_portal_active"] = status.configPortalActive;
+    doc["config_portal_sessions"] = status.configPortalSessions;
+    doc["config_portal_last_s"] = status.configPortalLastMs / 1000;
+    doc["readings_buffered"] = status.readingsBuffered;
+    doc["readings_replayed"] = status.readingsReplayed;
+    doc["readings_dropped"] = status.readingsDropped;
+  }
+}
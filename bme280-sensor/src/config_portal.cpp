@@ -0,0 +1,104 @@
+#include "config_portal.h"
+#include <WiFiManager.h>
+
+namespace ConfigPortal {
+  static const uint8_t DEVICE_NAME_LEN = 40;
+
+  static WiFiManager* s_wm = nullptr;
+  static WiFiManagerParameter* s_nameParam = nullptr;
+  static bool s_saved = false;
+  static char s_deviceName[DEVICE_NAME_LEN] = "";
+  static uint32_t s_sessions = 0;
+  static uint32_t s_startMs = 0;
+  static uint32_t s_lastSessionMs = 0;
+
+  static void create(const Config& config) {
+    s_wm = new WiFiManager();
+    s_nameParam = new WiFiManagerParameter("device_name", "Device Name", config.deviceName, DEVICE_NAME_LEN);
+    s_wm->addParameter(s_nameParam);
+    s_wm->setConfigPortalBlocking(false);
+    s_wm->setConfigPortalTimeout(config.timeoutSeconds);
+    s_wm->setBreakAfterConfig(true);   // A name-only save also ends the session
+    s_saved = false;
+    s_wm->setSaveConfigCallback([]() { s_saved = true; });
+    s_wm->setSaveParamsCallback([]() { s_saved = true; });
+  }
+
+  static void destroy() {
+    if (s_nameParam) {
+      strncpy(s_deviceName, s_nameParam->getValue(), DEVICE_NAME_LEN - 1);
+      s_deviceName[DEVICE_NAME_LEN - 1] = '\0';
+    }
+    delete s_wm;
+    delete s_nameParam;
+    s_wm = nullptr;
+    s_nameParam = nullptr;
+  }
+
+  static void opened(const char* apName) {
+    s_sessions++;
+    s_startMs = millis();
+    Serial.printf("[WiFi] Config portal running in background - AP: %s (http://192.168.4.1)\n", apName);
+  }
+
+  bool autoConnect(const Config& config) {
+    if (s_wm) {
+      return false;
+    }
+    create(config);
+    if (s_wm->autoConnect(config.apName)) {
+      destroy();
+      return true;
+    }
+    opened(config.apName);
+    return false;
+  }
+
+  bool start(const Config& config) {
+    if (s_wm) {
+      return false;
+    }
+    create(config);
+    s_wm->startConfigPortal(config.apName);
+    opened(config.apName);
+    return true;
+  }
+
+  void stop() {
+    if (s_wm && s_wm->getConfigPortalActive()) {
+      s_wm->stopConfigPortal();
+    }
+  }
+
+  Event process() {
+    if (!s_wm) {
+      return EVENT_NONE;
+    }
+    s_wm->process();
+    if (!s_saved && s_wm->getConfigPortalActive()) {
+      return EVENT_NONE;
+    }
+    stop();
+    destroy();
+    s_lastSessionMs = millis() - s_startMs;
+    Serial.printf("[WiFi] Config portal %s after %lu s\n", s_saved ? "saved" : "closed",
+                  (unsigned long)(s_lastSessionMs / 1000));
+    return s_saved ? EVENT_SAVED : EVENT_CLOSED;
+  }
+
+  bool isActive() {
+    return s_wm != nullptr;
+  }
+
+  const char* getDeviceName() {
+    return s_deviceName;
+  }
+
+  uint32_t getSessions() {
+    return s_sessions;
+  }
+
+  uint32_t getLastSessionMs() {
+    return s_wm ? millis() - s_startMs : s_lastSessionMs;
+  }
+}
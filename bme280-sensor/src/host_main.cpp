@@ -0,0 +1,175 @@
+/**
+ * host_main.cpp
+ *
+ * Native host runner for the BME280 sensor (env:native, not part of the
+ * firmware image). Benchmarks the per-cycle hot paths (payload serialization,
+ * loop profiler, NVS and SPIFFS access) and optionally publishes the payloads
+ * to a local MQTT broker through the real PubSubClient.
+ *
+ * Usage:
+ *   pio run -e native -t exec
+ *   .pio/build/native/program [--broker host:port] [--count N]
+ *
+ * NVS and SPIFFS are backed by files under $HOST_FS_ROOT (default .host_fs).
+ */
+
+#ifdef NATIVE_HOST
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <PubSubClient.h>
+#include <Preferences.h>
+#include <SPIFFS.h>
+#include <WiFi.h>
+#include <HostBench.h>
+#include <HostCheck.h>
+
+#include "loop_profiler.h"
+
+static const char* DEVICE_NAME = "host-bme280";
+static const char* CHIP_ID = "host0000";
+
+// Same shape as publishReadings() in main.cpp
+static size_t buildReadingsPayload(char* buffer, size_t size, float temperatureC) {
+  const float pressurePa = 101325.0f;
+  const float pressureBaseline = 101200.0f;
+  JsonDocument doc;
+  doc["device"] = DEVICE_NAME;
+  doc["chip_id"] = CHIP_ID;
+  doc["firmware_version"] = "host";
+  doc["schema_version"] = 1;
+  doc["timestamp"] = millis() / 1000;
+  doc["uptime_seconds"] = millis() / 1000;
+  doc["temperature_c"] = temperatureC;
+  doc["humidity_rh"] = 45.2f;
+  doc["pressure_pa"] = pressurePa;
+  doc["pressure_hpa"] = pressurePa / 100.0;
+  doc["altitude_m"] = 110.0f;
+  float pressureChange = pressurePa - pressureBaseline;
+  doc["pressure_change_pa"] = pressureChange;
+  doc["pressure_change_hpa"] = pressureChange / 100.0;
+  doc["pressure_trend"] = (pressureChange > 50) ? "rising" : (pressureChange < -50) ? "falling" : "steady";
+  doc["baseline_hpa"] = pressureBaseline / 100.0;
+  return serializeJson(doc, buffer, size);
+}
+
+// Same shape as publishStatus() in main.cpp
+static size_t buildStatusPayload(char* buffer, size_t size) {
+  JsonDocument doc;
+  doc["device"] = DEVICE_NAME;
+  doc["chip_id"] = CHIP_ID;
+  doc["firmware_version"] = "host";
+  doc["schema_version"] = 1;
+  doc["timestamp"] = millis() / 1000;
+  doc["uptime_seconds"] = millis() / 1000;
+  doc["wifi_connected"] = (WiFi.status() == WL_CONNECTED);
+  doc["wifi_rssi"] = WiFi.RSSI();
+  doc["ip_address"] = WiFi.localIP().toString();
+  doc["free_heap"] = ESP.getFreeHeap();
+  doc["sensor_healthy"] = true;
+  doc["wifi_reconnects"] = 0;
+  doc["sensor_read_failures"] = 0;
+  doc["deep_sleep_enabled"] = false;
+  doc["deep_sleep_seconds"] = 0;
+  doc["sensor_interval_seconds"] = 30;
+  doc["loop_max_ms"] = LoopProfiler::getMaxIterationMs();
+  doc["loop_stalls"] = LoopProfiler::getStallCount();
+  doc["loop_last_stall_region"] = LoopProfiler::getLastStallRegion();
+  JsonArray loopHistogram = doc["loop_histogram"].to<JsonArray>();
+  for (uint8_t i = 0; i < LoopProfiler::HISTOGRAM_BUCKETS; i++) {
+    loopHistogram.add(LoopProfiler::getBucket(i));
+  }
+  return serializeJson(doc, buffer, size);
+}
+
+static void publishToBroker(const char* broker, int count) {
+  String host(broker);
+  int colon = host.indexOf(':');
+  uint16_t port = 1883;
+  if (colon >= 0) {
+    port = host.substring(colon + 1).toInt();
+    host = host.substring(0, colon);
+  }
+
+  WiFiClient net;
+  PubSubClient mqtt(net);
+  mqtt.setServer(host.c_str(), port);
+  mqtt.setBufferSize(2048);
+  if (!HostCheck::expect(mqtt.connect(DEVICE_NAME), "MQTT connect to --broker")) {
+    printf("[HOST] MQTT connect to %s:%u failed, state=%d\n", host.c_str(), port, mqtt.state());
+    return;
+  }
+
+  String topicReadings = String("esp-sensor-hub/") + DEVICE_NAME + "/readings";
+  String topicStatus = String("esp-sensor-hub/") + DEVICE_NAME + "/status";
+  char buffer[1024];
+  unsigned long start = micros();
+  for (int i = 0; i < count; i++) {
+    size_t len = buildReadingsPayload(buffer, sizeof(buffer), 20.0f + (i % 50) * 0.1f);
+    mqtt.publish(topicReadings.c_str(), (const uint8_t*)buffer, len, false);
+    mqtt.loop();
+  }
+  size_t len = buildStatusPayload(buffer, sizeof(buffer));
+  mqtt.publish(topicStatus.c_str(), (const uint8_t*)buffer, len, true);
+  unsigned long elapsed = micros() - start;
+  printf("[HOST] Published %d readings to %s:%u in %lu us (%lu bytes sent)\n",
+         count, host.c_str(), port, elapsed, (unsigned long)net.hostBytesSent());
+  mqtt.disconnect();
+}
+
+int main(int argc, char** argv) {
+  const char* broker = nullptr;
+  int count = 100;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (strcmp(argv[i], "--broker") == 0) broker = argv[i + 1];
+    if (strcmp(argv[i], "--count") == 0) count = atoi(argv[i + 1]);
+  }
+
+  WiFi.begin();
+  LoopProfiler::begin(500, 300000, nullptr);
+
+  char buffer[1024];
+  printf("[HOST] readings: %.*s\n", (int)buildReadingsPayload(buffer, sizeof(buffer), 21.5f), buffer);
+  printf("[HOST] status:   %.*s\n", (int)buildStatusPayload(buffer, sizeof(buffer)), buffer);
+
+  HostBench::run("readings payload serialize", 100000, [&]() {
+    HostBench::keep(buildReadingsPayload(buffer, sizeof(buffer), 21.5f));
+  });
+  HostBench::run("status payload serialize", 50000, [&]() {
+    HostBench::keep(buildStatusPayload(buffer, sizeof(buffer)));
+  });
+  HostBench::run("LoopProfiler iteration + 2 regions", 200000, []() {
+    LoopProfiler::Iteration iteration;
+    {
+      LOOP_PROFILE_REGION("outer");
+      LOOP_PROFILE_REGION("inner");
+    }
+  });
+  HostCheck::expect(LoopProfiler::getIterations() == 200000 + 200000 / 10 + 1,   // Warm-up pass included
+                    "LoopProfiler counts every iteration");
+
+  Preferences prefs;
+  prefs.begin("device", false);
+  uint32_t writesBefore = Preferences::hostWriteCount();
+  HostBench::run("Preferences putUInt + getUInt", 2000, [&]() {
+    prefs.putUInt("counter", prefs.getUInt("counter", 0) + 1);
+  });
+  printf("[HOST] NVS writes: %lu\n", (unsigned long)(Preferences::hostWriteCount() - writesBefore));
+  prefs.end();
+
+  if (SPIFFS.begin(true)) {
+    HostBench::run("SPIFFS append 64 bytes", 2000, [&]() {
+      File f = SPIFFS.open("/bench.log", FILE_APPEND);
+      f.write((const uint8_t*)buffer, 64);
+      f.close();
+    });
+    SPIFFS.remove("/bench.log");
+  }
+
+  if (broker) {
+    publishToBroker(broker, count);
+  }
+  return HostCheck::exitCode();
+}
+
+#endif // NATIVE_HOST
@@ -0,0 +1,164 @@
+#include "loop_profiler.h"
+
+namespace LoopProfiler {
+  struct RegionFrame {
+    const char* name;
+    uint32_t startUs;
+    uint32_t childUs;   // Time spent in nested regions, excluded from this one
+  };
+
+  static uint32_t s_stallThresholdMs = 500;
+  static uint32_t s_reportIntervalMs = 300000;
+  static StallHandler s_handler = nullptr;
+
+  static bool s_inIteration = false;
+  static uint32_t s_iterationStartUs = 0;
+  static RegionFrame s_stack[MAX_REGION_DEPTH];
+  static uint8_t s_depth = 0;
+  static uint8_t s_overflowDepth = 0;     // Regions opened beyond MAX_REGION_DEPTH
+
+  // Worst region of the current iteration (by exclusive time)
+  static const char* s_worstRegion = nullptr;
+  static uint32_t s_worstRegionUs = 0;
+
+  static uint32_t s_histogram[HISTOGRAM_BUCKETS] = {0};
+  static uint32_t s_iterations = 0;
+  static uint32_t s_maxIterationMs = 0;
+  static uint32_t s_stallCount = 0;
+  static uint32_t s_suppressed = 0;
+  static const char* s_lastStallRegion = "none";
+  static uint32_t s_lastStallMs = 0;
+  static unsigned long s_lastReportMs = 0;
+  static bool s_reportedOnce = false;
+
+#ifdef ESP32
+  static TaskHandle_t s_loopTask = nullptr;
+#endif
+
+  static inline bool inLoopContext() {
+#ifdef ESP32
+    // Async handlers (AsyncTCP, timers) must not touch the region stack
+    return s_inIteration && xTaskGetCurrentTaskHandle() == s_loopTask;
+#else
+    return s_inIteration;
+#endif
+  }
+
+  static inline uint8_t bucketFor(uint32_t durationUs) {
+    uint32_t ms = durationUs / 1000;
+    if (ms == 0) {
+      return 0;
+    }
+    uint8_t bucket = 32 - __builtin_clz(ms);  // floor(log2(ms)) + 1
+    return bucket < HISTOGRAM_BUCKETS ? bucket : HISTOGRAM_BUCKETS - 1;
+  }
+
+  void begin(uint32_t stallThresholdMs, uint32_t reportIntervalMs, StallHandler handler) {
+    s_stallThresholdMs = stallThresholdMs;
+    s_reportIntervalMs = reportIntervalMs;
+    s_handler = handler;
+#ifdef ESP32
+    s_loopTask = xTaskGetCurrentTaskHandle();
+#endif
+  }
+
+  Iteration::Iteration() {
+    s_inIteration = true;
+    s_depth = 0;
+    s_overflowDepth = 0;
+    s_worstRegion = nullptr;
+    s_worstRegionUs = 0;
+    s_iterationStartUs = micros();
+  }
+
+  Iteration::~Iteration() {
+    uint32_t durationUs = micros() - s_iterationStartUs;
+    s_inIteration = false;
+
+    s_iterations++;
+    s_histogram[bucketFor(durationUs)]++;
+    uint32_t durationMs = durationUs / 1000;
+    if (durationMs > s_maxIterationMs) {
+      s_maxIterationMs = durationMs;
+    }
+
+    if (durationMs < s_stallThresholdMs) {
+      return;
+    }
+
+    s_stallCount++;
+    s_lastStallRegion = s_worstRegion ? s_worstRegion : "loop";
+    s_lastStallMs = durationMs;
+
+    unsigned long now = millis();
+    if (s_reportedOnce && (now - s_lastReportMs) < s_reportIntervalMs) {
+      s_suppressed++;
+      return;
+    }
+    s_reportedOnce = true;
+    s_lastReportMs = now;
+
+    if (s_handler) {
+      StallInfo info;
+      info.region = s_lastStallRegion;
+      info.durationMs = durationMs;
+      info.regionMs = s_worstRegion ? s_worstRegionUs / 1000 : durationMs;
+      info.stallCount = s_stallCount;
+      info.suppressed = s_suppressed;
+      s_handler(info);
+    }
+    s_suppressed = 0;
+  }
+
+  Region::Region(const char* name) : _active(false) {
+    if (!inLoopContext()) {
+      return;
+    }
+    _active = true;
+    if (s_depth >= MAX_REGION_DEPTH) {
+      s_overflowDepth++;  // Too deep: time is charged to the innermost tracked region
+      return;
+    }
+    RegionFrame& frame = s_stack[s_depth++];
+    frame.name = name;
+    frame.childUs = 0;
+    frame.startUs = micros();
+  }
+
+  Region::~Region() {
+    if (!_active) {
+      return;
+    }
+    if (s_overflowDepth > 0) {
+      s_overflowDepth--;
+      return;
+    }
+    RegionFrame& frame = s_stack[--s_depth];
+    uint32_t elapsedUs = micros() - frame.startUs;
+    uint32_t exclusiveUs = elapsedUs > frame.childUs ? elapsedUs - frame.childUs : 0;
+    if (s_depth > 0) {
+      s_stack[s_depth - 1].childUs += elapsedUs;
+    }
+    if (exclusiveUs > s_worstRegionUs) {
+      s_worstRegionUs = exclusiveUs;
+      s_worstRegion = frame.name;
+    }
+  }
+
+  uint32_t getIterations() { return s_iterations; }
+  uint32_t getMaxIterationMs() { return s_maxIterationMs; }
+  uint32_t getStallCount() { return s_stallCount; }
+  const char* getLastStallRegion() { return s_lastStallRegion; }
+  uint32_t getLastStallMs() { return s_lastStallMs; }
+
+  uint32_t getBucket(uint8_t index) {
+    return index < HISTOGRAM_BUCKETS ? s_histogram[index] : 0;
+  }
+
+  uint32_t getBucketLimitMs(uint8_t index) {
+    if (index >= HISTOGRAM_BUCKETS - 1) {
+      return 0;
+    }
+    return 1UL << index;
+  }
+}
@@ -23,6 +23,7 @@
 #endif
 #include <PubSubClient.h>
 #include <ArduinoJson.h>
+#include <time.h>
 #include <Adafruit_BME280.h>
 #include <Adafruit_Sensor.h>
 #include <ArduinoOTA.h>
@@ -35,6 +36,13 @@
 #include "secrets.h"
 #include "device_config.h"
 #include "version.h"
+#include "loop_profiler.h"
+#include "reset_tracker.h"
+#include "config_store.h"
+#include "mqtt_json.h"
+#include "tx_power.h"
+#include "config_portal.h"
+#include "bme280_payloads.h"
 
 // =============================================================================
 // DEVICE CONFIGURATION
@@ -42,7 +50,6 @@
 
 // Reset detection and crash recovery state (ESP32 only)
 #ifdef ESP32
-Preferences resetPrefs;
 const char* configPortalReason = "none";  // Why portal was triggered
 #endif
 
@@ -56,6 +63,15 @@ float humidity_rh = 0.0;
 float pressure_pa = 0.0;
 float altitude_m = 0.0;
 
+// Deep-sleep wakes use forced mode: one measurement, started in
+// initializeSensor() so it runs while WiFi associates
+bool bme280Forced = false;
+bool forcedPending = false;
+unsigned long forcedStartMs = 0;
+unsigned long measurementWaitMs = 0;  // Still waited for the measurement when reading it
+unsigned long wakeWifiMs = 0;         // Deep-sleep wake: WiFi associated (ms since boot)
+unsigned long wakeToPublishMs = 0;    // Deep-sleep wake: readings published (ms since boot)
+
 // Device metrics
 struct DeviceMetrics {
     unsigned long bootTime;
@@ -73,6 +89,22 @@ struct DeviceMetrics {
 
 DeviceMetrics metrics;
 
+// Readings whose publish failed (portal reconfiguring WiFi, broker down),
+// replayed oldest first with their sample timestamps
+struct PendingReading {
+  unsigned long timestamp;
+  float temperatureC;
+  float humidityRh;
+  float pressurePa;
+  float altitudeM;
+};
+const uint8_t PENDING_READINGS_MAX = 16;
+PendingReading pendingReadings[PENDING_READINGS_MAX];
+uint8_t pendingReadingsHead = 0;
+uint8_t pendingReadingsCount = 0;
+unsigned int readingsReplayed = 0;
+unsigned int readingsDropped = 0;
+
 // Deep sleep configuration
 int deepSleepSeconds = 0;
 volatile bool otaInProgress = false;
@@ -85,6 +117,22 @@ const char* SENSOR_INTERVAL_FILE = "/sensor_interval.txt";
 // Pressure baseline tracking (barometer-style)
 float pressureBaseline = PRESSURE_BASELINE_DEFAULT;
 
+// Persisted configuration, committed through ConfigStore (the text files above
+// are only read once to migrate older firmware)
+struct PersistentConfig {
+  char deviceName[40];
+  int32_t deepSleepSeconds;
+  int32_t sensorIntervalSeconds;
+  float pressureBaseline;
+};
+PersistentConfig persistentConfig;
+
+#ifdef ESP32
+  #define CONFIG_FS SPIFFS
+#else
+  #define CONFIG_FS LittleFS
+#endif
+
 // Global instances
 Adafruit_BME280 bme280;
 WiFiClient espClient;
@@ -115,92 +163,14 @@ const int WIFI_MIN_RSSI = -85;
 
 #ifdef ESP32
 void checkResetCounter() {
-  // Check for triple-reset and crash loop conditions (ESP32 reliable via NVS)
+  // Check for triple-reset and crash loop conditions (RTC memory, non-blocking)
   // This must be called early in setup() before other initialization
-
-  // Open preferences namespace for reset tracking
-  resetPrefs.begin("reset", false);
-
-  // ===== Crash loop detection =====
-  uint32_t crashFlag = resetPrefs.getUInt("crash_flag", 0);
-  uint32_t crashCnt = resetPrefs.getUInt("crash_cnt", 0);
-
-  if (crashFlag == CRASH_LOOP_MAGIC) {
-    crashCnt++;
-    resetPrefs.putUInt("crash_cnt", crashCnt);
-    Serial.printf("[RESET] Incomplete boot detected, crash count: %lu\n", crashCnt);
-
-    if (crashCnt >= CRASH_LOOP_THRESHOLD) {
-      Serial.println("[RESET] CRASH LOOP RECOVERY - entering config portal");
-      configPortalReason = "crash_recovery";
-      resetPrefs.putUInt("crash_cnt", 0); // Reset for next time
-    }
-  } else {
-    // Fresh power-on (or flag cleared), reset crash count only.
-    // Do NOT clear triple-reset counters here; they must persist across boots.
-    resetPrefs.putUInt("crash_cnt", 0);
-  }
-
-  // Mark boot in progress (cleared in clearCrashLoop after successful boot)
-  resetPrefs.putUInt("crash_flag", CRASH_LOOP_MAGIC);
-
-  // ===== Triple-reset detection =====
-  if (strcmp(configPortalReason, "crash_recovery") != 0) {
-    uint32_t cnt = resetPrefs.getUInt("reset_cnt", 0);
-    uint32_t window = resetPrefs.getUInt("window", 0);
-
-    // Sanity check
-    if (cnt > 10) {
-      Serial.printf("[RESET] Reset counter corrupted (%lu), clearing\n", cnt);
-      cnt = 0;
-      window = 0;
-      resetPrefs.putUInt("reset_cnt", cnt);
-      resetPrefs.putUInt("window", window);
-    }
-
-    if (window == 1 && cnt > 0 && cnt < 10) {
-      // Previous boot started a detection window
-      cnt++;
-      resetPrefs.putUInt("reset_cnt", cnt);
-      Serial.printf("[RESET] Reset count: %lu/%d\n", cnt, RESET_COUNT_THRESHOLD);
-
-      if (cnt >= RESET_COUNT_THRESHOLD) {
-        Serial.println("[RESET] TRIPLE RESET DETECTED - entering config portal");
-        configPortalReason = "triple_reset";
-        // Clear for next time
-        resetPrefs.putUInt("reset_cnt", 0);
-        resetPrefs.putUInt("window", 0);
-      }
-    } else {
-      // First reset or outside window
-      cnt = 1;
-      window = 1;
-      resetPrefs.putUInt("reset_cnt", cnt);
-      resetPrefs.putUInt("window", window);
-      Serial.println("[RESET] First reset, starting detection window");
-    }
-
-    // Wait for window; if no reset occurs, clear markers
-    delay(RESET_DETECT_TIMEOUT * 1000);
-
-    if (strcmp(configPortalReason, "none") == 0) {
-      Serial.println("[RESET] Reset window expired, normal boot");
-      resetPrefs.putUInt("reset_cnt", 0);
-      resetPrefs.putUInt("window", 0);
-    }
-  }
-
-  Serial.printf("[RESET] Boot reason: %s\n", configPortalReason);
-  resetPrefs.end();  // Close NVS namespace to free resources
+  configPortalReason = ResetTracker::begin(RESET_DETECT_TIMEOUT, RESET_COUNT_THRESHOLD, CRASH_LOOP_THRESHOLD);
 }
 
 void clearCrashLoop() {
   // Called after successful boot (WiFi + sensors + web server initialized)
-  resetPrefs.begin("reset", false);  // Open NVS namespace
-  resetPrefs.putUInt("crash_flag", 0);
-  resetPrefs.putUInt("crash_cnt", 0);
-  resetPrefs.end();  // Close NVS namespace
-  Serial.println("[RESET] Crash loop flag cleared - boot successful");
+  ResetTracker::markBootComplete();
 }
 #endif
 
@@ -239,35 +209,16 @@ void loadDeviceName() {
 }
 
 void saveDeviceName(const char* name) {
-#ifdef ESP32
-  if (!SPIFFS.begin(true)) return;
-  File file = SPIFFS.open(DEVICE_NAME_FILE, "w");
-#else
-  if (!LittleFS.begin()) return;
-  File file = LittleFS.open(DEVICE_NAME_FILE, "w");
-#endif
-  
-  if (file) {
-    strncpy(deviceName, name, sizeof(deviceName) - 1);
-    deviceName[sizeof(deviceName) - 1] = '\0';
-    file.write((uint8_t*)deviceName, strlen(deviceName));
-    file.close();
-    Serial.printf("[CONFIG] Saved device name: %s\n", deviceName);
-  }
+  strncpy(deviceName, name, sizeof(deviceName) - 1);
+  deviceName[sizeof(deviceName) - 1] = '\0';
+  strlcpy(persistentConfig.deviceName, deviceName, sizeof(persistentConfig.deviceName));
+  ConfigStore::markDirty();
+  Serial.printf("[CONFIG] Device name set: %s\n", deviceName);
 }
 void savePressureBaseline(float baseline) {
-#ifdef ESP32
-  File file = SPIFFS.open(PRESSURE_BASELINE_FILE, "w");
-#else
-  File file = LittleFS.open(PRESSURE_BASELINE_FILE, "w");
-#endif
-  if (file) {
-    file.println(baseline, 2);  // Save with 2 decimal places
-    file.close();
-    Serial.printf("[CONFIG] Saved pressure baseline: %.2f Pa (%.2f hPa)\n", baseline, baseline / 100.0);
-  } else {
-    Serial.println("[CONFIG] Failed to save pressure baseline");
-  }
+  persistentConfig.pressureBaseline = baseline;
+  ConfigStore::markDirty();
+  Serial.printf("[CONFIG] Pressure baseline set: %.2f Pa (%.2f hPa)\n", baseline, baseline / 100.0);
 }
 
 float loadPressureBaseline() {
@@ -327,19 +278,9 @@ void loadDeepSleepConfig() {
 }
 
 void saveDeepSleepConfig() {
-#ifdef ESP32
-  if (!SPIFFS.begin(true)) return;
-  File file = SPIFFS.open(DEEP_SLEEP_FILE, "w");
-#else
-  if (!LittleFS.begin()) return;
-  File file = LittleFS.open(DEEP_SLEEP_FILE, "w");
-#endif
-  
-  if (file) {
-    file.println(deepSleepSeconds);
-    file.close();
-    Serial.printf("[DEEP SLEEP] Saved config: %d seconds\n", deepSleepSeconds);
-  }
+  persistentConfig.deepSleepSeconds = deepSleepSeconds;
+  ConfigStore::markDirty();
+  Serial.printf("[DEEP SLEEP] Config set: %d seconds\n", deepSleepSeconds);
 }
 
 void loadSensorIntervalConfig() {
@@ -374,18 +315,47 @@ void loadSensorIntervalConfig() {
 }
 
 void saveSensorIntervalConfig() {
-#ifdef ESP32
-  if (!SPIFFS.begin(true)) return;
-  File file = SPIFFS.open(SENSOR_INTERVAL_FILE, "w");
-#else
-  if (!LittleFS.begin()) return;
-  File file = LittleFS.open(SENSOR_INTERVAL_FILE, "w");
-#endif
-  
-  if (file) {
-    file.println(sensorIntervalSeconds);
-    file.close();
-    Serial.printf("[SENSOR] Saved interval config: %d seconds\n", sensorIntervalSeconds);
+  persistentConfig.sensorIntervalSeconds = sensorIntervalSeconds;
+  ConfigStore::markDirty();
+  Serial.printf("[SENSOR] Interval config set: %d seconds\n", sensorIntervalSeconds);
+}
+
+// =============================================================================
+// CONFIG PERSISTENCE
+// =============================================================================
+
+// Load configuration from the config store, migrating the legacy text files once
+void loadConfig() {
+  bool loaded = ConfigStore::begin(CONFIG_FS, &persistentConfig, sizeof(persistentConfig),
+                                   CONFIG_SCHEMA_VERSION, CONFIG_COMMIT_QUIET_MS, CONFIG_COMMIT_MAX_DELAY_MS);
+  if (loaded) {
+    persistentConfig.deviceName[sizeof(persistentConfig.deviceName) - 1] = '\0';
+    if (strlen(persistentConfig.deviceName) > 0) {
+      strcpy(deviceName, persistentConfig.deviceName);
+    }
+    deepSleepSeconds = persistentConfig.deepSleepSeconds;
+    sensorIntervalSeconds = max((int)persistentConfig.sensorIntervalSeconds, 5);
+    pressureBaseline = persistentConfig.pressureBaseline;
+    Serial.printf("[CONFIG] Loaded: name='%s', deep sleep %ds, interval %ds, baseline %.2f Pa\n",
+                  deviceName, deepSleepSeconds, sensorIntervalSeconds, pressureBaseline);
+    return;
+  }
+
+  loadDeviceName();
+  loadDeepSleepConfig();
+  loadSensorIntervalConfig();
+  pressureBaseline = loadPressureBaseline();
+  strlcpy(persistentConfig.deviceName, deviceName, sizeof(persistentConfig.deviceName));
+  persistentConfig.deepSleepSeconds = deepSleepSeconds;
+  persistentConfig.sensorIntervalSeconds = sensorIntervalSeconds;
+  persistentConfig.pressureBaseline = pressureBaseline;
+  ConfigStore::markDirty();
+  if (ConfigStore::flush()) {
+    CONFIG_FS.remove(DEVICE_NAME_FILE);
+    CONFIG_FS.remove(DEEP_SLEEP_FILE);
+    CONFIG_FS.remove(SENSOR_INTERVAL_FILE);
+    CONFIG_FS.remove(PRESSURE_BASELINE_FILE);
+    Serial.println("[CONFIG] Migrated legacy config files");
   }
 }
 
@@ -404,9 +374,12 @@ bool initializeSensor() {
     return false;
   }
   
-  // Configure sensor for weather monitoring
+  // Configure sensor for weather monitoring. Forced mode starts one
+  // measurement now and leaves the sensor asleep afterwards (also while the
+  // ESP is in deep sleep); normal mode measures continuously.
+  bme280Forced = deepSleepSeconds > 0;
   bme280.setSampling(
-    Adafruit_BME280::MODE_NORMAL,        // Operating Mode
+    bme280Forced ? Adafruit_BME280::MODE_FORCED : Adafruit_BME280::MODE_NORMAL,  // Operating Mode
     Adafruit_BME280::SAMPLING_X2,        // Temp. oversampling
     Adafruit_BME280::SAMPLING_X16,       // Pressure oversampling
     Adafruit_BME280::SAMPLING_X2,        // Humidity oversampling
@@ -414,12 +387,31 @@ bool initializeSensor() {
     Adafruit_BME280::STANDBY_MS_0_5      // Standby time
   );
   
-  Serial.printf("[SENSOR] BME280 initialized successfully at address 0x%02X\n", BME280_I2C_ADDR);
+  forcedPending = bme280Forced && !WAKE_SEQUENTIAL_BASELINE;
+  forcedStartMs = millis();
+
+  Serial.printf("[SENSOR] BME280 initialized successfully at address 0x%02X (%s mode)\n",
+                BME280_I2C_ADDR, bme280Forced ? "forced" : "normal");
   return true;
 }
 
 void readSensorData() {
+  LOOP_PROFILE_REGION("bme280");
   sensors_event_t temp_event, pressure_event, humidity_event;
+
+  unsigned long waitStart = millis();
+  if (forcedPending) {
+    // The wake measurement from initializeSensor(), normally done long ago
+    while (millis() - forcedStartMs < BME280_FORCED_MEASUREMENT_MS) {
+      delay(1);
+    }
+    forcedPending = false;
+  } else if (bme280Forced) {
+    // Deep sleep disabled at runtime (or the sequential baseline): the
+    // sensor stays in forced mode and each read waits for its measurement
+    bme280.takeForcedMeasurement();
+  }
+  measurementWaitMs = millis() - waitStart;
   
   // Create Adafruit Unified Sensor objects for the BME280 environmental sensor
   Adafruit_Sensor *bme_temp = bme280.getTemperatureSensor();
@@ -471,6 +463,11 @@ void enterDeepSleepIfEnabled() {
     return;
   #endif
 
+  if (deepSleepSeconds > 0 && ConfigPortal::isActive()) {
+    Serial.println("[DEEP SLEEP] Config portal running - staying awake");
+    return;
+  }
+
   if (deepSleepSeconds > 0) {
     Serial.println();
     Serial.println("========================================");
@@ -498,6 +495,9 @@ void enterDeepSleepIfEnabled() {
       delay(100);  // Give time for WiFi to power down
     #endif
 
+    // Commit pending config changes before RAM is lost
+    ConfigStore::flush();
+
     // Flush serial before sleeping
     Serial.flush();
     delay(50);
@@ -560,10 +560,8 @@ bool publishJson(const String& topic, JsonDocument& doc, bool retain = false) {
     return false;
   }
   
-  String payload;
-  serializeJson(doc, payload);
-  
-  if (!mqttClient.publish(topic.c_str(), payload.c_str(), retain)) {
+  LOOP_PROFILE_REGION("mqtt_publish");
+  if (!MqttJson::publish(mqttClient, topic.c_str(), doc, retain)) {
     metrics.mqttPublishFailures++;
     return false;
   }
@@ -572,57 +570,58 @@ bool publishJson(const String& topic, JsonDocument& doc, bool retain = false) {
   return true;
 }
 
+// Identity fields of every published document
+Bme280Payloads::Identity payloadIdentity(const String& firmwareVersion) {
+  Bme280Payloads::Identity id;
+  id.device = deviceName;
+  id.chipId = chipId.c_str();
+  id.firmwareVersion = firmwareVersion.c_str();
+  return id;
+}
+
 void publishEvent(const String& eventType, const String& message, const String& severity = "info") {
+  String firmwareVersion = getFirmwareVersion();
+  Bme280Payloads::Event event;
+  event.type = eventType.c_str();
+  event.severity = severity.c_str();
+  event.message = message.c_str();
+  event.timestamp = millis() / 1000;
+  event.uptimeSeconds = (millis() - metrics.bootTime) / 1000;
+  event.freeHeap = ESP.getFreeHeap();
   StaticJsonDocument<256> doc;
-  doc["device"] = deviceName;
-  doc["chip_id"] = chipId;
-  doc["firmware_version"] = getFirmwareVersion();
-  doc["schema_version"] = 1;
-  doc["event"] = eventType;
-  doc["severity"] = severity;
-  doc["timestamp"] = millis() / 1000;
-  doc["uptime_seconds"] = (millis() - metrics.bootTime) / 1000;
-  doc["free_heap"] = ESP.getFreeHeap();
-  if (message.length() > 0) {
-    doc["message"] = message;
-  }
+  Bme280Payloads::buildEvent(doc, payloadIdentity(firmwareVersion), event);
   publishJson(getTopicEvents(), doc, false);
 }
 
-bool publishReadings() {
+// Wall-clock time of a sample taken at uptime `timestamp` (s); 0 until NTP has set the clock
+uint32_t sampleTime(unsigned long timestamp) {
+  time_t now = time(nullptr);
+  return now > 1600000000 ? (uint32_t)(now - (millis() / 1000 - timestamp)) : 0;
+}
+
+bool publishReading(const PendingReading& reading, bool replay) {
   if (!mqttClient.connected()) {
-    Serial.println("[MQTT] Not connected - skipping readings publish");
+    Serial.println("[MQTT] Not connected - reading buffered");
     return false;
   }
   
-  StaticJsonDocument<512> doc;
-  doc["device"] = deviceName;
-  doc["chip_id"] = chipId;
-  doc["firmware_version"] = getFirmwareVersion();
-  doc["schema_version"] = 1;
-  doc["timestamp"] = millis() / 1000;
-  doc["uptime_seconds"] = (millis() - metrics.bootTime) / 1000;
-  doc["temperature_c"] = temperature_c;
-  doc["humidity_rh"] = humidity_rh;
-  doc["pressure_pa"] = pressure_pa;
-  doc["pressure_hpa"] = pressure_pa / 100.0;
-  doc["altitude_m"] = altitude_m;
-  
-  // Add pressure baseline tracking (barometer-style)
-  if (pressureBaseline > 0) {
-    float pressureChange = pressure_pa - pressureBaseline;
-    doc["pressure_change_pa"] = pressureChange;
-    doc["pressure_change_hpa"] = pressureChange / 100.0;
-    doc["pressure_trend"] = (pressureChange > 50) ? "rising" : (pressureChange < -50) ? "falling" : "steady";
-    doc["baseline_hpa"] = pressureBaseline / 100.0;
-  }
-  
-#ifdef BATTERY_MONITOR_ENABLED
-  if (metrics.batteryPercent >= 0) {
-    doc["battery_voltage"] = metrics.batteryVoltage;
-    doc["battery_percent"] = metrics.batteryPercent;
+  String firmwareVersion = getFirmwareVersion();
+  Bme280Payloads::Readings readings;
+  readings.timestamp = reading.timestamp;
+  readings.uptimeSeconds = (millis() - metrics.bootTime) / 1000;
+  readings.temperatureC = reading.temperatureC;
+  readings.humidityRh = reading.humidityRh;
+  readings.pressurePa = reading.pressurePa;
+  readings.altitudeM = reading.altitudeM;
+  readings.pressureBaseline = pressureBaseline;
+  readings.replayed = replay;
+  if (replay) {
+    readings.sampleTime = sampleTime(reading.timestamp);
   }
-#endif
+  readings.batteryVoltage = metrics.batteryVoltage;
+  readings.batteryPercent = metrics.batteryPercent;
+  StaticJsonDocument<512> doc;
+  Bme280Payloads::buildReadings(doc, payloadIdentity(firmwareVersion), readings);
   
   bool success = publishJson(getTopicReadings(), doc, false);
   if (success) {
@@ -631,6 +630,48 @@ bool publishReadings() {
     Serial.printf("[MQTT] ✗ Failed to publish readings (state=%d)\n", mqttClient.state());
     metrics.mqttPublishFailures++;
   }
+  if (WiFi.status() == WL_CONNECTED) {
+    TxPower::report(WiFi.RSSI(), success, measureJson(doc));
+  }
+  return success;
+}
+
+void bufferReading(const PendingReading& reading) {
+  if (pendingReadingsCount == PENDING_READINGS_MAX) {
+    // Full: the oldest reading makes room
+    pendingReadingsHead = (pendingReadingsHead + 1) % PENDING_READINGS_MAX;
+    pendingReadingsCount--;
+    readingsDropped++;
+  }
+  pendingReadings[(pendingReadingsHead + pendingReadingsCount) % PENDING_READINGS_MAX] = reading;
+  pendingReadingsCount++;
+}
+
+// Replay buffered readings oldest first; stops at the first failure
+bool publishPendingReadings() {
+  while (pendingReadingsCount > 0) {
+    if (!publishReading(pendingReadings[pendingReadingsHead], true)) {
+      return false;
+    }
+    pendingReadingsHead = (pendingReadingsHead + 1) % PENDING_READINGS_MAX;
+    pendingReadingsCount--;
+    readingsReplayed++;
+  }
+  return true;
+}
+
+bool publishReadings() {
+  PendingReading reading;
+  reading.timestamp = millis() / 1000;
+  reading.temperatureC = temperature_c;
+  reading.humidityRh = humidity_rh;
+  reading.pressurePa = pressure_pa;
+  reading.altitudeM = altitude_m;
+
+  bool success = publishPendingReadings() && publishReading(reading, false);
+  if (!success) {
+    bufferReading(reading);
+  }
   return success;
 }
 
@@ -639,30 +680,79 @@ void publishStatus() {
     return;  // Silent - published by periodic health check
   }
   
-  StaticJsonDocument<512> doc;
-  doc["device"] = deviceName;
-  doc["chip_id"] = chipId;
-  doc["firmware_version"] = getFirmwareVersion();
-  doc["schema_version"] = 1;
-  doc["timestamp"] = millis() / 1000;
-  doc["uptime_seconds"] = (millis() - metrics.bootTime) / 1000;
-  doc["wifi_connected"] = (WiFi.status() == WL_CONNECTED);
-  doc["wifi_rssi"] = (WiFi.status() == WL_CONNECTED) ? WiFi.RSSI() : -999;
-  doc["ip_address"] = WiFi.localIP().toString();
-  doc["free_heap"] = ESP.getFreeHeap();
-  doc["sensor_healthy"] = (metrics.sensorReadFailures == 0);
-  doc["wifi_reconnects"] = metrics.wifiReconnects;
-  doc["sensor_read_failures"] = metrics.sensorReadFailures;
-  doc["deep_sleep_enabled"] = (deepSleepSeconds > 0);
-  doc["deep_sleep_seconds"] = deepSleepSeconds;
-  doc["sensor_interval_seconds"] = sensorIntervalSeconds;
-  if (pressureBaseline > 0) {
-    doc["pressure_baseline_hpa"] = pressureBaseline / 100.0;
+  Bme280Payloads::Status status;
+  status.timestamp = millis() / 1000;
+  status.uptimeSeconds = (millis() - metrics.bootTime) / 1000;
+  status.wifiConnected = (WiFi.status() == WL_CONNECTED);
+  status.wifiRssi = status.wifiConnected ? WiFi.RSSI() : -999;
+  status.ipAddress = WiFi.localIP().toString();
+  status.freeHeap = ESP.getFreeHeap();
+  status.sensorHealthy = (metrics.sensorReadFailures == 0);
+  status.wifiReconnects = metrics.wifiReconnects;
+  status.sensorReadFailures = metrics.sensorReadFailures;
+  status.deepSleepSeconds = deepSleepSeconds;
+  status.sensorIntervalSeconds = sensorIntervalSeconds;
+  status.pressureBaseline = pressureBaseline;
+  if (wakeToPublishMs > 0) {
+    status.wakeToPublishMs = wakeToPublishMs;
+    status.wakeWifiMs = wakeWifiMs;
+    status.wakeConversionWaitMs = measurementWaitMs;
+    status.wakeFlow = WAKE_SEQUENTIAL_BASELINE ? "sequential" : "overlapped";
+  }
+  status.loopMaxMs = LoopProfiler::getMaxIterationMs();
+  status.loopStalls = LoopProfiler::getStallCount();
+  status.loopLastStallRegion = LoopProfiler::getLastStallRegion();
+  for (uint8_t i = 0; i < Bme280Payloads::Status::LOOP_BUCKETS; i++) {
+    status.loopHistogram[i] = LoopProfiler::getBucket(i);
+  }
+  status.txPowerDbm = TxPower::getDbm();
+  TxPower::Stats txStats;
+  TxPower::getStats(txStats);
+  status.txPowerStepsDown = txStats.stepsDown;
+  status.txPowerStepsUp = txStats.stepsUp;
+  status.txEnergyPerPublishUj = TxPower::getEnergyPerPublishUj();
+  status.txEnergySavedPct = TxPower::getSavedPercent();
+  #ifdef ESP32
+    status.resetReason = ResetTracker::getResetReason();
+    status.bootCount = ResetTracker::getBootCount();
+    status.resetNvsWrites = ResetTracker::getNvsWrites();
+    status.resetNvsWritesPerDay = ResetTracker::getNvsWritesPerDay();
+    status.bootDelaySavedMs = ResetTracker::getBootDelaySavedMs();
+  #endif
+  status.configCommits = ConfigStore::getCommits();
+  for (uint8_t i = 0; i < Bme280Payloads::Status::CONFIG_SLOTS; i++) {
+    status.configSlotWrites[i] = ConfigStore::getSlotWrites(i);
   }
+  status.configCommitsBoot = ConfigStore::getCommitsThisBoot();
+  status.configCoalesced = ConfigStore::getCoalesced();
+  status.configCommitFailures = ConfigStore::getCommitFailures();
+  status.configPending = ConfigStore::isDirty();
+  status.mqttPayloadMaxBytes = MqttJson::getMaxPayloadBytes();
+  status.mqttPublishMaxUs = MqttJson::getMaxPublishUs();
+  status.configPortalActive = ConfigPortal::isActive();
+  status.configPortalSessions = ConfigPortal::getSessions();
+  status.configPortalLastMs = ConfigPortal::getLastSessionMs();
+  status.readingsBuffered = pendingReadingsCount;
+  status.readingsReplayed = readingsReplayed;
+  status.readingsDropped = readingsDropped;
+
+  String firmwareVersion = getFirmwareVersion();
+  StaticJsonDocument<512> doc;
+  Bme280Payloads::buildStatus(doc, payloadIdentity(firmwareVersion), status);
   
   publishJson(getTopicStatus(), doc, true);
 }
 
+// Report loop() stalls through the events topic (rate-limited by the profiler)
+void onLoopStall(const LoopProfiler::StallInfo& info) {
+  char message[128];
+  snprintf(message, sizeof(message), "Loop stalled %lu ms in %s (%lu ms), stalls: %lu, suppressed: %lu",
+           (unsigned long)info.durationMs, info.region, (unsigned long)info.regionMs,
+           (unsigned long)info.stallCount, (unsigned long)info.suppressed);
+  Serial.printf("[PROFILER] %s\n", message);
+  publishEvent("loop_stall", message, "warning");
+}
+
 void mqttCallback(char* topic, byte* payload, unsigned int length) {
   String message;
   for (unsigned int i = 0; i < length; i++) {
@@ -700,6 +790,7 @@ void mqttCallback(char* topic, byte* payload, unsigned int length) {
       publishStatus();
     } else if (message == "restart") {
       publishEvent("device_restart", "Restarting device via MQTT command", "warning");
+      ConfigStore::flush();
       delay(500);
       ESP.restart();
     } else if (message == "status") {
@@ -719,6 +810,7 @@ void mqttCallback(char* topic, byte* payload, unsigned int length) {
           publishEvent("deep_sleep_config", msg, "info");
           Serial.printf("[DEEP SLEEP] Configuration updated: %d seconds\n", seconds);
           Serial.println("[DEEP SLEEP] Device will restart to apply configuration");
+          ConfigStore::flush();
           delay(1000);
           ESP.restart();
         } else {
@@ -762,7 +854,12 @@ bool ensureMqttConnected() {
   lastMqttReconnectAttempt = now;
   Serial.printf("[MQTT] Attempting connection to %s:%d\n", MQTT_SERVER, MQTT_PORT);
   
-  if (mqttClient.connect(chipId.c_str(), MQTT_USER, MQTT_PASSWORD)) {
+  bool connected;
+  {
+    LOOP_PROFILE_REGION("mqtt_connect");
+    connected = mqttClient.connect(chipId.c_str(), MQTT_USER, MQTT_PASSWORD);
+  }
+  if (connected) {
     Serial.println("[MQTT] Connected!");
     mqttClient.subscribe(getTopicCommand().c_str());
     publishEvent("mqtt_connected", "Connected to MQTT broker", "info");
@@ -775,10 +872,12 @@ bool ensureMqttConnected() {
 
 void setupMQTT() {
   mqttClient.setServer(MQTT_SERVER, MQTT_PORT);
-  mqttClient.setBufferSize(2048);
+  mqttClient.setBufferSize(512);   // Outgoing JSON is streamed (MqttJson); topics + inbound commands only
   mqttClient.setKeepAlive(30);
   mqttClient.setSocketTimeout(5);
   mqttClient.setCallback(mqttCallback);
+
+  LoopProfiler::begin(LOOP_STALL_THRESHOLD_MS, LOOP_STALL_REPORT_INTERVAL_MS, onLoopStall);
 }
 
 // =============================================================================
@@ -786,9 +885,6 @@ void setupMQTT() {
 // =============================================================================
 
 void setupWiFi() {
-  WiFiManager wifiManager;
-  wifiManager.setConfigPortalTimeout(300);
-  
   // Disable WiFi power save for stable MQTT connectivity
   #ifdef ESP32
     WiFi.setSleep(false);
@@ -798,27 +894,17 @@ void setupWiFi() {
     Serial.println("[WiFi] Power save disabled (ESP8266)");
   #endif
   
-  // Add custom parameter for device name
-  WiFiManagerParameter custom_device_name("device_name", "Device Name", deviceName, 40);
-  wifiManager.addParameter(&custom_device_name);
-  
-  // Set save config callback to capture custom parameters
-  wifiManager.setSaveConfigCallback([]() {
-    Serial.println("[WiFi] Configuration saved via portal");
-  });
-  
-  if (!wifiManager.autoConnect(deviceName)) {
-    Serial.println("[WiFi] Configuration failed, restarting...");
-    delay(3000);
-    ESP.restart();
-  }
+  // Without a connection the portal keeps running from loop() while the
+  // sensor samples into the reading buffer
+  ConfigPortal::Config portalConfig;
+  portalConfig.apName = deviceName;
+  portalConfig.deviceName = deviceName;
+  portalConfig.timeoutSeconds = 300;
   
-  // Save device name if it was changed in the portal
-  const char* newDeviceName = custom_device_name.getValue();
-  if (strlen(newDeviceName) > 0 && strcmp(newDeviceName, deviceName) != 0) {
-    saveDeviceName(newDeviceName);
-    updateTopicBase();
-    Serial.printf("[CONFIG] Device name updated to: %s\n", deviceName);
+  if (!ConfigPortal::autoConnect(portalConfig)) {
+    Serial.println("[WiFi] Not connected - configuration portal running");
+    metrics.bootTime = millis();
+    return;
   }
   
   Serial.printf("[WiFi] Connected to %s\n", WiFi.SSID().c_str());
@@ -826,12 +912,59 @@ void setupWiFi() {
   metrics.bootTime = millis();
 }
 
+// Triple reset / crash recovery: opened after setupWiFi() and served from
+// loop(), so sampling and publishing continue through the station interface
+void startConfigPortal() {
+  String apName = String(deviceName);
+  apName.replace(" ", "-");
+  apName = "BME280-" + apName + "-Setup";
+
+  ConfigPortal::Config portalConfig;
+  portalConfig.apName = apName.c_str();
+  portalConfig.deviceName = deviceName;
+  portalConfig.timeoutSeconds = 300; // 5 minute timeout
+  ConfigPortal::start(portalConfig);
+}
+
+void handleConfigPortal() {
+  ConfigPortal::Event event;
+  {
+    LOOP_PROFILE_REGION("config_portal");
+    event = ConfigPortal::process();
+  }
+  if (event == ConfigPortal::EVENT_NONE) {
+    return;
+  }
+  
+  if (event == ConfigPortal::EVENT_SAVED) {
+    // Save device name if it was changed in the portal
+    const char* newDeviceName = ConfigPortal::getDeviceName();
+    if (strlen(newDeviceName) > 0 && strcmp(newDeviceName, deviceName) != 0) {
+      saveDeviceName(newDeviceName);
+      updateTopicBase();
+      mqttClient.disconnect();  // Resubscribe on the new topics
+      Serial.printf("[CONFIG] Device name updated to: %s\n", deviceName);
+    }
+    ensureMqttConnected();
+    publishEvent("device_configured", "SSID: " + WiFi.SSID() + ", IP: " + WiFi.localIP().toString(), "info");
+  } else if (WiFi.status() != WL_CONNECTED) {
+    Serial.println("[WiFi] Configuration failed, restarting...");
+    ConfigStore::flush();
+    delay(3000);
+    ESP.restart();
+  } else {
+    Serial.println("[WiFi] Configuration portal timeout or cancelled");
+    Serial.println("[WiFi] Continuing with existing configuration...");
+  }
+}
+
 void setupOTA() {
   ArduinoOTA.setHostname(deviceName);
   ArduinoOTA.setPassword(OTA_PASSWORD);
   
   ArduinoOTA.onStart([]() {
     otaInProgress = true;
+    ConfigStore::flush();
     publishEvent("ota_start", "OTA update starting", "warning");
     Serial.println("[OTA] Update started");
   });
@@ -893,8 +1026,12 @@ void setup() {
   }
 #endif
 
+  // Load device name, deep sleep, interval and pressure baseline
+  loadConfig();
+
 #ifdef ESP32
   // Check for triple-reset or crash recovery portal trigger
+  bool startPortalAfterWiFi = false;
   if (strcmp(configPortalReason, "triple_reset") == 0 || strcmp(configPortalReason, "crash_recovery") == 0) {
     Serial.println();
     Serial.println("========================================");
@@ -903,47 +1040,12 @@ void setup() {
     } else {
       Serial.println("  CRASH LOOP RECOVERY MODE");
     }
-    Serial.println("  Starting WiFi Configuration Portal");
+    Serial.println("  WiFi Configuration Portal Requested");
     Serial.println("========================================");
     Serial.println();
 
-    // Load device name first (needed for AP name)
-    loadDeviceName();
-
-    WiFiManager wm;
-    String apName = String(deviceName);
-    apName.replace(" ", "-");
-    apName = "BME280-" + apName + "-Setup";
-
-    Serial.println("[WiFi] Connect to AP: " + apName);
-    Serial.println("[WiFi] Then open http://192.168.4.1 in browser");
-    Serial.println();
-
-    WiFiManagerParameter custom_device_name("device_name", "Device Name", deviceName, 40);
-    wm.addParameter(&custom_device_name);
-    wm.setConfigPortalTimeout(300); // 5 minute timeout
-
-    bool shouldSaveConfig = false;
-    wm.setSaveConfigCallback([&shouldSaveConfig](){
-      shouldSaveConfig = true;
-    });
-
-    if (wm.startConfigPortal(apName.c_str())) {
-      if (shouldSaveConfig) {
-        const char* newName = custom_device_name.getValue();
-        strcpy(deviceName, newName);
-        saveDeviceName(deviceName);
-        Serial.print("[Config] Device name updated: ");
-        Serial.println(newName);
-      }
-      Serial.println("[WiFi] Configuration portal completed successfully");
-      Serial.println("[WiFi] Restarting to apply new configuration...");
-      delay(1000);
-      ESP.restart();
-    } else {
-      Serial.println("[WiFi] Configuration portal timeout or cancelled");
-      Serial.println("[WiFi] Continuing with existing configuration...");
-    }
+    Serial.println("[WiFi] Portal opens after WiFi setup; sampling continues meanwhile");
+    startPortalAfterWiFi = true;
   }
 #endif
 
@@ -951,11 +1053,6 @@ void setup() {
   Serial.println("  BME280 Environmental Sensor");
   Serial.println("================================\n");
   
-  // Load configuration
-  loadDeviceName();
-  loadDeepSleepConfig();
-  loadSensorIntervalConfig();
-  
   // Initialize sensor
   if (!initializeSensor()) {
     Serial.println("[FATAL] BME280 sensor failed to initialize!");
@@ -969,10 +1066,6 @@ void setup() {
   chipId = generateChipId();
   updateTopicBase();
   
-  // Load configuration
-  loadDeviceName();
-  loadDeepSleepConfig();
-  pressureBaseline = loadPressureBaseline();
   Serial.printf("[CONFIG] Device: %s\n", deviceName);
   Serial.printf("[DEEP SLEEP] Config: %d seconds\n", deepSleepSeconds);
   
@@ -981,6 +1074,24 @@ void setup() {
   
   // Connect to WiFi
   setupWiFi();
+  if (WiFi.status() == WL_CONNECTED) {
+    wakeWifiMs = millis();
+  }
+  // UTC only: dates the readings replayed after an outage
+  configTime(0, 0, NTP_SERVER);
+#ifdef ESP32
+  if (startPortalAfterWiFi && !ConfigPortal::isActive()) {
+    startConfigPortal();
+  }
+#endif
+
+  // Learned TX power level (RTC memory across deep sleep)
+  TxPower::Config txConfig;
+  txConfig.targetRssi = TX_POWER_TARGET_RSSI;
+  txConfig.weakRssi = TX_POWER_WEAK_RSSI;
+  txConfig.downAfter = TX_POWER_DOWN_AFTER;
+  txConfig.floorHoldPublishes = TX_POWER_FLOOR_HOLD;
+  TxPower::begin(txConfig);
   
   // Setup OTA
   if (WiFi.status() == WL_CONNECTED) {
@@ -1003,6 +1114,9 @@ void setup() {
     
     // Publish data
     bool publishSuccess = publishReadings();
+    wakeToPublishMs = millis();
+    Serial.printf("[DEEP SLEEP] Wake to publish: %lu ms (WiFi %lu ms, measurement wait %lu ms)\n",
+                  wakeToPublishMs, wakeWifiMs, measurementWaitMs);
     publishStatus();
     
     if (publishSuccess) {
@@ -1053,15 +1167,25 @@ void setup() {
 }
 
 void loop() {
+  LoopProfiler::Iteration loopIteration;
+
   // Handle OTA
   if (deepSleepSeconds == 0) {
+    LOOP_PROFILE_REGION("ota");
     ArduinoOTA.handle();
   }
   
+  #ifdef ESP32
+  ResetTracker::loop();
+  #endif
+  ConfigStore::loop();
+  handleConfigPortal();
+  
   // Maintain MQTT connection
   if (!mqttClient.connected()) {
     ensureMqttConnected();
   } else {
+    LOOP_PROFILE_REGION("mqtt_loop");
     mqttClient.loop();
   }
   
@@ -1090,7 +1214,7 @@ void loop() {
         metrics.sensorReadFailures++;
       }
     } else {
-      Serial.println("[MQTT] Skipping publish - not connected to broker");
+      publishReadings();  // Buffered for replay once the broker is back
       metrics.mqttPublishFailures++;
     }
     
@@ -0,0 +1,179 @@
+#include "tx_power.h"
+#include <stddef.h>
+
+#ifndef NATIVE_HOST
+  #ifdef ESP32
+    #include <WiFi.h>
+    #include <esp_attr.h>
+  #else
+    #include <ESP8266WiFi.h>
+  #endif
+#endif
+
+namespace TxPower {
+  static const uint32_t STATE_MAGIC = 0x54585031;   // "TXP1"
+  static const uint8_t HYSTERESIS_DB = 3;           // Extra headroom loss tolerated before stepping up
+
+  // Quarter dBm, as wifi_power_t on the ESP32: 19.5, 18.5, 17, 15, 13, 11, 8.5, 7 dBm
+  static const int8_t LEVELS[LEVEL_COUNT] = {78, 74, 68, 60, 52, 44, 34, 28};
+
+  // Energy estimate: one TCP segment with the MQTT publish and its ACK
+  static const uint16_t OVERHEAD_BYTES = 120;      // 802.11 + IP + TCP + MQTT headers
+  static const float PHY_RATE_MBPS = 6.0f;         // Conservative; retries are not counted
+  static const float SUPPLY_V = 3.3f;
+
+  struct State {
+    uint32_t magic;
+    uint8_t level;
+    uint8_t maxLevel;            // Weakest level allowed (lowered by failures)
+    uint16_t floorHold;          // Publishes left before maxLevel is released
+    uint8_t streak;              // Healthy publishes since the last change
+    uint32_t crc;
+  };
+
+#if defined(ESP32) && !defined(NATIVE_HOST)
+  RTC_NOINIT_ATTR static State s_state;
+#else
+  static State s_state;
+#endif
+
+  static Config s_config;
+  static Stats s_stats;
+
+  static uint32_t crc32(const uint8_t* data, size_t length) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < length; i++) {
+      crc ^= data[i];
+      for (uint8_t bit = 0; bit < 8; bit++) {
+        crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+      }
+    }
+    return ~crc;
+  }
+
+  static void save() {
+    s_state.crc = crc32((const uint8_t*)&s_state, offsetof(State, crc));
+#if defined(ESP8266) && !defined(NATIVE_HOST)
+    ESP.rtcUserMemoryWrite(0, (uint32_t*)&s_state, sizeof(s_state));
+#endif
+  }
+
+  static bool load() {
+#if defined(ESP8266) && !defined(NATIVE_HOST)
+    ESP.rtcUserMemoryRead(0, (uint32_t*)&s_state, sizeof(s_state));
+#endif
+    return s_state.magic == STATE_MAGIC
+        && s_state.crc == crc32((const uint8_t*)&s_state, offsetof(State, crc))
+        && s_state.level < LEVEL_COUNT && s_state.maxLevel < LEVEL_COUNT;
+  }
+
+  // TX current (mA) at a level, linear in dBm between datasheet typicals
+  static float txCurrentMa(uint8_t level) {
+    float dbm = LEVELS[level] / 4.0f;
+#ifdef ESP8266
+    return 30.0f + 8.2f * dbm;           // ~170 mA at 17 dBm, ~137 mA at 13 dBm
+#else
+    return 130.0f + 5.6f * dbm;          // ~240 mA at 19.5 dBm, ~170 mA at 7 dBm
+#endif
+  }
+
+  static void initState() {
+    s_state = State();
+    s_state.magic = STATE_MAGIC;
+    s_state.maxLevel = LEVEL_COUNT - 1;
+    save();
+  }
+
+  void begin(const Config& config) {
+    s_config = config;
+    s_stats = Stats();
+    if (!load()) {
+      initState();
+    }
+    apply();
+    Serial.printf("[TXPOWER] Level %u (%.1f dBm)\n", s_state.level, getDbm());
+  }
+
+  void apply() {
+#ifndef NATIVE_HOST
+  #ifdef ESP32
+    WiFi.setTxPower((wifi_power_t)LEVELS[s_state.level]);
+  #else
+    WiFi.setOutputPower(getDbm());
+  #endif
+#endif
+  }
+
+  void reset() {
+    initState();
+    apply();
+  }
+
+  static void change(uint8_t level) {
+    if (level < s_state.level) {
+      s_stats.stepsUp++;
+    } else {
+      s_stats.stepsDown++;
+    }
+    s_state.level = level;
+    s_state.streak = 0;
+    apply();
+  }
+
+  void report(int rssi, bool published, size_t bytes) {
+    s_stats.publishes++;
+    s_stats.energyUj += estimateEnergyUj(s_state.level, bytes);
+    s_stats.fullPowerEnergyUj += estimateEnergyUj(0, bytes);
+
+    int reductionQdbm = LEVELS[0] - LEVELS[s_state.level];
+    int headroomQdbm = (rssi - s_config.targetRssi) * 4;
+    bool overReduced = reductionQdbm > headroomQdbm + HYSTERESIS_DB * 4;
+
+    if (!published) {
+      s_stats.failures++;
+      uint8_t level = s_state.level > 0 ? s_state.level - 1 : 0;
+      s_state.maxLevel = level;
+      s_state.floorHold = s_config.floorHoldPublishes;
+      change(level);
+    } else if (rssi < s_config.weakRssi || overReduced) {
+      if (s_state.level > 0) {
+        change(s_state.level - 1);
+      }
+    } else {
+      if (s_state.floorHold > 0 && --s_state.floorHold == 0) {
+        s_state.maxLevel = LEVEL_COUNT - 1;
+      }
+      if (++s_state.streak >= s_config.downAfter) {
+        s_state.streak = 0;
+        uint8_t next = s_state.level + 1;
+        if (next <= s_state.maxLevel && LEVELS[0] - LEVELS[next] <= headroomQdbm) {
+          change(next);
+        }
+      }
+    }
+    save();
+  }
+
+  uint8_t getLevel() { return s_state.level; }
+  float getDbm() { return LEVELS[s_state.level] / 4.0f; }
+
+  void getStats(Stats& stats) {
+    stats = s_stats;
+  }
+
+  float estimateEnergyUj(uint8_t level, size_t bytes) {
+    float airtimeUs = (bytes + OVERHEAD_BYTES) * 8.0f / PHY_RATE_MBPS;
+    return SUPPLY_V * txCurrentMa(level) * airtimeUs / 1000.0f;
+  }
+
+  float getEnergyPerPublishUj() {
+    return s_stats.publishes ? s_stats.energyUj / s_stats.publishes : 0.0f;
+  }
+
+  float getSavedPercent() {
+    if (s_stats.fullPowerEnergyUj <= 0.0f) {
+      return 0.0f;
+    }
+    return 100.0f * (1.0f - s_stats.energyUj / s_stats.fullPowerEnergyUj);
+  }
+}
@@ -0,0 +1,98 @@
+/**
+ * Arduino.cpp (host shim)
+ *
+ * Timing, GPIO and helper implementations for the host build.
+ */
+
+#include "Arduino.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <random>
+#include <map>
+
+static const std::chrono::steady_clock::time_point s_startTime = std::chrono::steady_clock::now();
+static std::map<uint8_t, int> s_pinLevels;
+static std::map<uint8_t, int> s_analogValues;
+static std::mt19937 s_random(0x5EED);
+static std::atomic<int64_t> s_advancedUs(0);    // hostAdvanceClock() total
+
+static int64_t elapsedUs() {
+    auto elapsed = std::chrono::steady_clock::now() - s_startTime;
+    return std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() + s_advancedUs.load();
+}
+
+unsigned long millis() {
+    return (uint32_t)(elapsedUs() / 1000);
+}
+
+unsigned long micros() {
+    return (uint32_t)elapsedUs();
+}
+
+void hostAdvanceClock(unsigned long ms) {
+    s_advancedUs += (int64_t)ms * 1000;
+}
+
+void delay(unsigned long ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(unsigned int us) {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void yield() {
+    std::this_thread::yield();
+}
+
+void pinMode(uint8_t, uint8_t) {
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    s_pinLevels[pin] = value ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin) {
+    auto it = s_pinLevels.find(pin);
+    return it == s_pinLevels.end() ? LOW : it->second;
+}
+
+int analogRead(uint8_t pin) {
+    auto it = s_analogValues.find(pin);
+    return it == s_analogValues.end() ? 0 : it->second;
+}
+
+void analogReadResolution(uint8_t) {
+}
+
+void attachInterrupt(uint8_t, void (*)(), int) {
+}
+
+void detachInterrupt(uint8_t) {
+}
+
+void hostSetPinLevel(uint8_t pin, int level) {
+    s_pinLevels[pin] = level ? HIGH : LOW;
+}
+
+void hostSetAnalogValue(uint8_t pin, int value) {
+    s_analogValues[pin] = value;
+}
+
+long random(long max) {
+    return max > 0 ? (long)(s_random() % (unsigned long)max) : 0;
+}
+
+long random(long min, long max) {
+    return max > min ? min + random(max - min) : min;
+}
+
+void randomSeed(unsigned long seed) {
+    s_random.seed((uint32_t)seed);
+}
+
+char* dtostrf(double value, signed char width, unsigned char precision, char* buffer) {
+    sprintf(buffer, "%*.*f", width, precision, value);
+    return buffer;
+}
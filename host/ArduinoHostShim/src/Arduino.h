@@ -0,0 +1,99 @@
+/**
+ * Arduino.h (host shim)
+ *
+ * Minimal Arduino/ESP32 core API for building firmware modules on the host.
+ * Only what the portable modules use is provided: timing, GPIO no-ops,
+ * String, Print/Stream, Serial and the ESP object.
+ *
+ * Timing mirrors the ESP32: millis()/micros() are 32-bit and wrap.
+ */
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+#ifndef NATIVE_HOST
+#define NATIVE_HOST 1
+#endif
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+// Attributes and flash helpers compile away on the host
+#define PROGMEM
+#define IRAM_ATTR
+#define RTC_NOINIT_ATTR
+#define RTC_DATA_ATTR
+#define F(s) (s)
+#define PSTR(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define pgm_read_word(addr) (*(const uint16_t*)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t*)(addr))
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define INPUT_PULLDOWN 0x09
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+using std::min;
+using std::max;
+
+template <typename T, typename L, typename H>
+inline T constrain(T value, L low, H high) {
+    return value < (T)low ? (T)low : (value > (T)high ? (T)high : value);
+}
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax) {
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// Timing (host monotonic clock, truncated to 32 bits like the ESP32 core)
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+// Host-only: move millis()/micros() forward without sleeping, for simulated
+// timelines longer than the run may take
+void hostAdvanceClock(unsigned long ms);
+
+// GPIO: recorded so simulations can inspect pin levels, otherwise no-ops
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void analogReadResolution(uint8_t bits);
+inline uint8_t digitalPinToInterrupt(uint8_t pin) { return pin; }
+void attachInterrupt(uint8_t interrupt, void (*handler)(), int mode);
+void detachInterrupt(uint8_t interrupt);
+
+// Host-only GPIO helpers for simulations
+void hostSetPinLevel(uint8_t pin, int level);
+void hostSetAnalogValue(uint8_t pin, int value);
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+char* dtostrf(double value, signed char width, unsigned char precision, char* buffer);
+
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+#include "HardwareSerial.h"
+#include "Esp.h"
+
+#endif // HOST_ARDUINO_H
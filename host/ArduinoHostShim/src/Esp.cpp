@@ -0,0 +1,19 @@
+/**
+ * Esp.cpp (host shim)
+ */
+
+#include "Esp.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+EspClass ESP;
+
+void EspClass::restart() {
+    fflush(stdout);
+    exit(0);
+}
+
+void EspClass::deepSleep(uint64_t) {
+    fflush(stdout);
+    exit(0);
+}
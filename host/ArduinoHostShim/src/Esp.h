@@ -0,0 +1,40 @@
+/**
+ * Esp.h (host shim)
+ *
+ * ESP object: heap figures come from the host configuration (defaults to an
+ * ESP32 after WiFi start), restart() terminates the process.
+ */
+
+#ifndef HOST_ESP_H
+#define HOST_ESP_H
+
+#include <stdint.h>
+
+class EspClass {
+public:
+    uint32_t getFreeHeap() const { return _freeHeap; }
+    uint32_t getMinFreeHeap() const { return _freeHeap; }
+    uint32_t getMaxAllocHeap() const { return _freeHeap; }
+    uint32_t getFreePsram() const { return _freePsram; }
+    uint32_t getPsramSize() const { return _freePsram; }
+    uint64_t getEfuseMac() const { return _efuseMac; }
+    uint32_t getChipId() const { return (uint32_t)(_efuseMac & 0xFFFFFF); }
+    uint32_t getCpuFreqMHz() const { return 240; }
+    const char* getSdkVersion() const { return "host"; }
+    void restart();
+    void deepSleep(uint64_t timeUs);
+
+    // Host-only configuration for simulations
+    void hostSetFreeHeap(uint32_t bytes) { _freeHeap = bytes; }
+    void hostSetFreePsram(uint32_t bytes) { _freePsram = bytes; }
+    void hostSetEfuseMac(uint64_t mac) { _efuseMac = mac; }
+
+private:
+    uint32_t _freeHeap = 180000;
+    uint32_t _freePsram = 0;
+    uint64_t _efuseMac = 0x0000A1B2C3D4E5F6ULL;
+};
+
+extern EspClass ESP;
+
+#endif // HOST_ESP_H
@@ -0,0 +1,241 @@
+/**
+ * FS.cpp (host shim)
+ */
+
+#include "FS.h"
+#include "HostStorage.h"
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <ftw.h>
+#include <string.h>
+
+namespace fs {
+
+class FileImpl {
+public:
+    FS* owner = nullptr;
+    FILE* handle = nullptr;
+    DIR* dir = nullptr;
+    std::string hostPath;
+    std::string path;
+    std::string name;
+    bool writable = false;
+
+    ~FileImpl() {
+        if (handle) fclose(handle);
+        if (dir) closedir(dir);
+    }
+};
+
+size_t File::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t File::write(const uint8_t* buffer, size_t size) {
+    if (!_impl || !_impl->handle || !_impl->writable) {
+        return 0;
+    }
+    size_t n = fwrite(buffer, 1, size, _impl->handle);
+    _impl->owner->hostAddBytesWritten(n);
+    return n;
+}
+
+int File::available() {
+    if (!_impl || !_impl->handle) {
+        return 0;
+    }
+    long remaining = (long)size() - (long)position();
+    return remaining > 0 ? (int)remaining : 0;
+}
+
+int File::read() {
+    if (!_impl || !_impl->handle) {
+        return -1;
+    }
+    int c = fgetc(_impl->handle);
+    return c == EOF ? -1 : c;
+}
+
+size_t File::read(uint8_t* buffer, size_t size) {
+    if (!_impl || !_impl->handle) {
+        return 0;
+    }
+    return fread(buffer, 1, size, _impl->handle);
+}
+
+int File::peek() {
+    int c = read();
+    if (c >= 0) {
+        ungetc(c, _impl->handle);
+    }
+    return c;
+}
+
+void File::flush() {
+    if (_impl && _impl->handle) {
+        fflush(_impl->handle);
+    }
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+    if (!_impl || !_impl->handle) {
+        return false;
+    }
+    int whence = mode == SeekCur ? SEEK_CUR : (mode == SeekEnd ? SEEK_END : SEEK_SET);
+    return fseek(_impl->handle, (long)pos, whence) == 0;
+}
+
+size_t File::position() const {
+    if (!_impl || !_impl->handle) {
+        return 0;
+    }
+    long pos = ftell(_impl->handle);
+    return pos < 0 ? 0 : (size_t)pos;
+}
+
+size_t File::size() const {
+    if (!_impl) {
+        return 0;
+    }
+    if (_impl->handle) {
+        fflush(_impl->handle);
+    }
+    struct stat st;
+    return stat(_impl->hostPath.c_str(), &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+void File::close() {
+    _impl.reset();
+}
+
+File::operator bool() const {
+    return _impl && (_impl->handle || _impl->dir);
+}
+
+const char* File::name() const {
+    return _impl ? _impl->name.c_str() : "";
+}
+
+const char* File::path() const {
+    return _impl ? _impl->path.c_str() : "";
+}
+
+bool File::isDirectory() const {
+    return _impl && _impl->dir;
+}
+
+File File::openNextFile(const char* mode) {
+    if (!_impl || !_impl->dir) {
+        return File();
+    }
+    struct dirent* entry;
+    while ((entry = readdir(_impl->dir)) != nullptr) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        std::string childPath = _impl->path;
+        if (childPath.empty() || childPath.back() != '/') {
+            childPath += "/";
+        }
+        childPath += entry->d_name;
+        return _impl->owner->open(childPath.c_str(), mode);
+    }
+    return File();
+}
+
+void File::rewindDirectory() {
+    if (_impl && _impl->dir) {
+        rewinddir(_impl->dir);
+    }
+}
+
+std::string FS::hostPath(const char* path) const {
+    std::string p = path ? path : "/";
+    if (p.empty() || p[0] != '/') {
+        p = "/" + p;
+    }
+    return HostStorage::root() + "/" + _mountName + p;
+}
+
+bool FS::begin(bool, const char*, uint8_t, const char*) {
+    _mounted = HostStorage::makeDirs(hostPath("/"));
+    return _mounted;
+}
+
+static int removeEntry(const char* path, const struct stat*, int, struct FTW*) {
+    return ::remove(path);
+}
+
+bool FS::format() {
+    std::string root = hostPath("/");
+    nftw(root.c_str(), removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+    return HostStorage::makeDirs(root);
+}
+
+File FS::open(const char* path, const char* mode, bool create) {
+    if (!_mounted || !path) {
+        return File();
+    }
+    auto impl = std::make_shared<FileImpl>();
+    impl->owner = this;
+    impl->hostPath = hostPath(path);
+    impl->path = path;
+    const char* slash = strrchr(path, '/');
+    impl->name = slash ? slash + 1 : path;
+
+    struct stat st;
+    if (stat(impl->hostPath.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+        impl->dir = opendir(impl->hostPath.c_str());
+        return impl->dir ? File(impl) : File();
+    }
+
+    bool writing = mode && (mode[0] == 'w' || mode[0] == 'a' || strchr(mode, '+'));
+    if (writing || create) {
+        std::string parent = impl->hostPath.substr(0, impl->hostPath.rfind('/'));
+        HostStorage::makeDirs(parent);
+    }
+    std::string fopenMode = std::string(mode ? mode : "r") + "b";
+    impl->handle = fopen(impl->hostPath.c_str(), fopenMode.c_str());
+    impl->writable = writing;
+    return impl->handle ? File(impl) : File();
+}
+
+bool FS::exists(const char* path) {
+    struct stat st;
+    return _mounted && stat(hostPath(path).c_str(), &st) == 0;
+}
+
+bool FS::remove(const char* path) {
+    return _mounted && unlink(hostPath(path).c_str()) == 0;
+}
+
+bool FS::rename(const char* from, const char* to) {
+    return _mounted && ::rename(hostPath(from).c_str(), hostPath(to).c_str()) == 0;
+}
+
+bool FS::mkdir(const char* path) {
+    return _mounted && HostStorage::makeDirs(hostPath(path));
+}
+
+bool FS::rmdir(const char* path) {
+    return _mounted && ::rmdir(hostPath(path).c_str()) == 0;
+}
+
+static size_t s_usedBytes = 0;
+
+static int sumEntry(const char*, const struct stat* st, int type, struct FTW*) {
+    if (type == FTW_F) {
+        s_usedBytes += (size_t)st->st_size;
+    }
+    return 0;
+}
+
+size_t FS::usedBytes() {
+    s_usedBytes = 0;
+    std::string root = hostPath("/");
+    nftw(root.c_str(), sumEntry, 16, FTW_PHYS);
+    return s_usedBytes;
+}
+
+} // namespace fs
@@ -0,0 +1,109 @@
+/**
+ * FS.h (host shim)
+ *
+ * File-backed filesystem: paths map to <HOST_FS_ROOT>/<mount>/<path>.
+ * Implements the fs::FS / fs::File API used by SPIFFS and LittleFS.
+ */
+
+#ifndef HOST_FS_H
+#define HOST_FS_H
+
+#include <stdio.h>
+#include <memory>
+#include <string>
+#include "Stream.h"
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+enum SeekMode {
+    SeekSet = 0,
+    SeekCur = 1,
+    SeekEnd = 2
+};
+
+class FileImpl;
+
+class File : public Stream {
+public:
+    File() {}
+    explicit File(std::shared_ptr<FileImpl> impl) : _impl(impl) {}
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    int available() override;
+    int read() override;
+    int peek() override;
+    void flush() override;
+    size_t read(uint8_t* buffer, size_t size);
+
+    bool seek(uint32_t pos, SeekMode mode = SeekSet);
+    size_t position() const;
+    size_t size() const;
+    void close();
+    operator bool() const;
+    const char* name() const;
+    const char* path() const;
+    bool isDirectory() const;
+    File openNextFile(const char* mode = FILE_READ);
+    void rewindDirectory();
+
+private:
+    std::shared_ptr<FileImpl> _impl;
+};
+
+class FS {
+public:
+    explicit FS(const char* mountName) : _mountName(mountName) {}
+    virtual ~FS() {}
+
+    bool begin(bool formatOnFail = false, const char* basePath = nullptr, uint8_t maxOpenFiles = 10,
+               const char* partitionLabel = nullptr);
+    void end() { _mounted = false; }
+    bool format();
+
+    File open(const char* path, const char* mode = FILE_READ, bool create = false);
+    File open(const String& path, const char* mode = FILE_READ, bool create = false) {
+        return open(path.c_str(), mode, create);
+    }
+    bool exists(const char* path);
+    bool exists(const String& path) { return exists(path.c_str()); }
+    bool remove(const char* path);
+    bool remove(const String& path) { return remove(path.c_str()); }
+    bool rename(const char* from, const char* to);
+    bool rename(const String& from, const String& to) { return rename(from.c_str(), to.c_str()); }
+    bool mkdir(const char* path);
+    bool mkdir(const String& path) { return mkdir(path.c_str()); }
+    bool rmdir(const char* path);
+
+    size_t totalBytes() const { return _totalBytes; }
+    size_t usedBytes();
+
+    // Host-only: bytes written through this filesystem since process start
+    uint64_t hostBytesWritten() const { return _bytesWritten; }
+    void hostSetTotalBytes(size_t bytes) { _totalBytes = bytes; }
+    void hostAddBytesWritten(size_t bytes) { _bytesWritten += bytes; }
+
+private:
+    std::string hostPath(const char* path) const;
+
+    std::string _mountName;
+    bool _mounted = false;
+    size_t _totalBytes = 1441792;   // Default 1.375 MB data partition
+    uint64_t _bytesWritten = 0;
+};
+
+} // namespace fs
+
+using fs::File;
+using fs::FS;
+using fs::SeekMode;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
+
+#endif // HOST_FS_H
@@ -0,0 +1,27 @@
+/**
+ * HardwareSerial.cpp (host shim)
+ */
+
+#include "HardwareSerial.h"
+#include <stdio.h>
+
+HardwareSerial Serial(0);
+
+void HardwareSerial::begin(unsigned long baud, uint32_t, int8_t, int8_t, bool, unsigned long) {
+    _baud = baud;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    if (_uartNum == 0) {
+        fputc(c, stdout);
+        return 1;
+    }
+    return HostStream::write(c);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    if (_uartNum == 0) {
+        return fwrite(buffer, 1, size, stdout);
+    }
+    return HostStream::write(buffer, size);
+}
@@ -0,0 +1,37 @@
+/**
+ * HardwareSerial.h (host shim)
+ *
+ * Serial (UART0) writes to stdout. Other ports are HostStreams: feed() them
+ * with captured bytes to drive UART-based drivers on the host.
+ */
+
+#ifndef HOST_HARDWARE_SERIAL_H
+#define HOST_HARDWARE_SERIAL_H
+
+#include "HostStream.h"
+
+#define SERIAL_8N1 0x800001c
+
+class HardwareSerial : public HostStream {
+public:
+    explicit HardwareSerial(int uartNum) : _uartNum(uartNum) {}
+
+    void begin(unsigned long baud, uint32_t config = SERIAL_8N1, int8_t rxPin = -1, int8_t txPin = -1,
+               bool invert = false, unsigned long timeoutMs = 20000UL);
+    void end() {}
+    void setRxBufferSize(size_t) {}
+    unsigned long baudRate() const { return _baud; }
+    operator bool() const { return true; }
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+
+private:
+    int _uartNum;
+    unsigned long _baud = 0;
+};
+
+extern HardwareSerial Serial;
+
+#endif // HOST_HARDWARE_SERIAL_H
@@ -0,0 +1,40 @@
+/**
+ * HostBench.h (host shim)
+ *
+ * Minimal timing harness for the native host runners: runs a callable for a
+ * fixed number of iterations and prints ns/op. Not a test framework; the
+ * numbers are for comparing changes on the same machine.
+ */
+
+#ifndef HOST_BENCH_H
+#define HOST_BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <chrono>
+
+namespace HostBench {
+    // Prevent the optimizer from discarding benchmark results
+    template <typename T>
+    inline void keep(const T& value) {
+        asm volatile("" : : "g"(&value) : "memory");
+    }
+
+    template <typename Fn>
+    double run(const char* name, uint32_t iterations, Fn&& fn) {
+        // Warm-up pass so first-touch allocations don't skew the result
+        for (uint32_t i = 0; i < iterations / 10 + 1; i++) {
+            fn();
+        }
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < iterations; i++) {
+            fn();
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        double nsPerOp = std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+        printf("[BENCH] %-40s %12.1f ns/op  (%u iterations)\n", name, nsPerOp, iterations);
+        return nsPerOp;
+    }
+}
+
+#endif // HOST_BENCH_H
@@ -0,0 +1,46 @@
+/**
+ * HostCheck.h (host shim)
+ *
+ * Pass/fail bookkeeping for the native host runners. A check that does not
+ * hold prints a FAIL line next to the runner's own output and makes the
+ * runner exit with status 2 (the same code the host tools use for "ran, but
+ * the result is wrong"), so `pio run -e native -t exec` and CI catch a
+ * regression instead of leaving it in the log.
+ */
+
+#ifndef HOST_CHECK_H
+#define HOST_CHECK_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+namespace HostCheck {
+    inline uint32_t& passed() {
+        static uint32_t count = 0;
+        return count;
+    }
+
+    inline uint32_t& failed() {
+        static uint32_t count = 0;
+        return count;
+    }
+
+    // Record one check; returns ok so callers can branch on it
+    inline bool expect(bool ok, const char* what) {
+        if (ok) {
+            passed()++;
+        } else {
+            failed()++;
+            printf("[CHECK] FAIL: %s\n", what);
+        }
+        return ok;
+    }
+
+    // Summary line and exit status for main(): 0 if every check held, 2 otherwise
+    inline int exitCode() {
+        printf("[CHECK] %u passed, %u failed\n", passed(), failed());
+        return failed() == 0 ? 0 : 2;
+    }
+}
+
+#endif // HOST_CHECK_H
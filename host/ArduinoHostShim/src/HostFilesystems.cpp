@@ -0,0 +1,12 @@
+/**
+ * HostFilesystems.cpp (host shim)
+ *
+ * Global SPIFFS and LittleFS instances, each in its own directory under
+ * HOST_FS_ROOT.
+ */
+
+#include "SPIFFS.h"
+#include "LittleFS.h"
+
+fs::FS SPIFFS("spiffs");
+fs::FS LittleFS("littlefs");
@@ -0,0 +1,105 @@
+/**
+ * HostHeap.cpp (host shim)
+ */
+
+#include "HostHeap.h"
+#include <stdlib.h>   // Defines __GLIBC__
+
+#if defined(__GLIBC__)
+
+#include <errno.h>
+#include <malloc.h>
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+}
+
+static size_t s_current = 0;
+static size_t s_peak = 0;
+
+static inline void track(void* ptr) {
+    if (ptr) {
+        size_t now = __atomic_add_fetch(&s_current, malloc_usable_size(ptr), __ATOMIC_RELAXED);
+        if (now > s_peak) {
+            s_peak = now;
+        }
+    }
+}
+
+static inline void untrack(void* ptr) {
+    if (ptr) {
+        __atomic_sub_fetch(&s_current, malloc_usable_size(ptr), __ATOMIC_RELAXED);
+    }
+}
+
+extern "C" {
+
+void* malloc(size_t size) {
+    void* ptr = __libc_malloc(size);
+    track(ptr);
+    return ptr;
+}
+
+void* calloc(size_t count, size_t size) {
+    void* ptr = __libc_calloc(count, size);
+    track(ptr);
+    return ptr;
+}
+
+void* realloc(void* ptr, size_t size) {
+    size_t before = ptr ? malloc_usable_size(ptr) : 0;
+    void* result = __libc_realloc(ptr, size);
+    if (result || size == 0) {
+        __atomic_sub_fetch(&s_current, before, __ATOMIC_RELAXED);
+        track(result);
+    }
+    return result;
+}
+
+void* memalign(size_t alignment, size_t size) {
+    void* ptr = __libc_memalign(alignment, size);
+    track(ptr);
+    return ptr;
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    return memalign(alignment, size);
+}
+
+int posix_memalign(void** out, size_t alignment, size_t size) {
+    void* ptr = memalign(alignment, size);
+    if (!ptr) {
+        return ENOMEM;
+    }
+    *out = ptr;
+    return 0;
+}
+
+void free(void* ptr) {
+    untrack(ptr);
+    __libc_free(ptr);
+}
+
+} // extern "C"
+
+namespace HostHeap {
+    bool available() { return true; }
+    size_t current() { return __atomic_load_n(&s_current, __ATOMIC_RELAXED); }
+    size_t peak() { return s_peak; }
+    void resetPeak() { s_peak = current(); }
+}
+
+#else
+
+namespace HostHeap {
+    bool available() { return false; }
+    size_t current() { return 0; }
+    size_t peak() { return 0; }
+    void resetPeak() {}
+}
+
+#endif
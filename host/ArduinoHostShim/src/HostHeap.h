@@ -0,0 +1,31 @@
+/**
+ * HostHeap.h (host shim)
+ *
+ * Heap accounting for the native runners: malloc/calloc/realloc/free are
+ * interposed (glibc only) to track live bytes and the high-water mark, so a
+ * runner can report peak RAM of a code path. On other C libraries
+ * available() is false and all values read 0.
+ */
+
+#ifndef HOST_HEAP_H
+#define HOST_HEAP_H
+
+#include <stddef.h>
+
+namespace HostHeap {
+    bool available();
+    size_t current();           // Live heap bytes (usable size of each block)
+    size_t peak();              // High-water mark since the last resetPeak()
+    void resetPeak();
+
+    // Peak heap bytes above the starting level while fn() runs
+    template <typename Fn>
+    size_t measurePeak(Fn&& fn) {
+        size_t base = current();
+        resetPeak();
+        fn();
+        return peak() - base;
+    }
+}
+
+#endif // HOST_HEAP_H
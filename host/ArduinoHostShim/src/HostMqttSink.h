@@ -0,0 +1,75 @@
+/**
+ * HostMqttSink.h (host shim)
+ *
+ * In-memory Client for benchmarking the publish path without a broker:
+ * answers every CONNECT with a CONNACK and swallows everything else,
+ * counting bytes and write() calls (each write() is a socket send on the
+ * device, so fewer is better).
+ */
+
+#ifndef HOST_MQTT_SINK_H
+#define HOST_MQTT_SINK_H
+
+#include "Client.h"
+
+class HostMqttSink : public Client {
+public:
+    int connect(IPAddress, uint16_t) override { return open(); }
+    int connect(const char*, uint16_t) override { return open(); }
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override {
+        if (!_connected) {
+            return 0;
+        }
+        // MQTT CONNECT (packet type 1) -> queue CONNACK, session accepted
+        if (!_acked && size > 0 && (buffer[0] >> 4) == 1) {
+            _acked = true;
+            _pending = 4;
+        }
+        _bytesSent += size;
+        _writes++;
+        return size;
+    }
+
+    int available() override { return _pending; }
+    int read() override {
+        static const uint8_t CONNACK[4] = {0x20, 0x02, 0x00, 0x00};
+        return _pending > 0 ? CONNACK[4 - _pending--] : -1;
+    }
+    int read(uint8_t* buffer, size_t size) override {
+        size_t n = 0;
+        while (n < size && _pending > 0) {
+            buffer[n++] = (uint8_t)read();
+        }
+        return (int)n;
+    }
+    int peek() override { return _pending > 0 ? 0x20 : -1; }
+    void flush() override {}
+    void stop() override { _connected = false; }
+    uint8_t connected() override { return _connected; }
+    operator bool() override { return _connected; }
+    using Print::write;
+
+    uint64_t hostBytesSent() const { return _bytesSent; }
+    uint64_t hostWrites() const { return _writes; }
+    void hostResetCounters() { _writes = 0; _bytesSent = 0; }
+
+private:
+    int open() {
+        _connected = true;
+        _acked = false;
+        _bytesSent = 0;
+        _writes = 0;
+        _pending = 0;
+        return 1;
+    }
+
+    bool _connected = false;
+    bool _acked = false;
+    uint64_t _bytesSent = 0;
+    uint64_t _writes = 0;
+    int _pending = 0;
+};
+
+#endif // HOST_MQTT_SINK_H
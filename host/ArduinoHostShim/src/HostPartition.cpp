@@ -0,0 +1,146 @@
+/**
+ * HostPartition.cpp (host shim)
+ */
+
+#include "esp_partition.h"
+#include "HostStorage.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+struct HostPartition {
+    esp_partition_t info;
+    std::string path;
+};
+
+// Pointers into this vector are handed out, so it is never resized after reservation
+static std::vector<HostPartition>& partitions() {
+    static std::vector<HostPartition> s_partitions;
+    if (s_partitions.capacity() == 0) {
+        s_partitions.reserve(16);
+    }
+    return s_partitions;
+}
+
+static const HostPartition* lookup(const esp_partition_t* partition) {
+    for (const HostPartition& entry : partitions()) {
+        if (&entry.info == partition) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+const esp_partition_t* hostDefinePartition(const char* label, esp_partition_type_t type,
+                                           esp_partition_subtype_t subtype, uint32_t size) {
+    if (size == 0 || size % SPI_FLASH_SEC_SIZE != 0 || partitions().size() == partitions().capacity()) {
+        return nullptr;
+    }
+    for (HostPartition& entry : partitions()) {
+        if (strcmp(entry.info.label, label) == 0) {
+            return &entry.info;
+        }
+    }
+
+    std::string dir = HostStorage::root() + "/partitions";
+    HostStorage::makeDirs(dir);
+    HostPartition entry = {};
+    entry.info.type = type;
+    entry.info.subtype = subtype;
+    entry.info.size = size;
+    strncpy(entry.info.label, label, sizeof(entry.info.label) - 1);
+    entry.path = dir + "/" + label + ".bin";
+
+    // Fresh, erased flash unless an image of the right size is already there
+    FILE* f = fopen(entry.path.c_str(), "rb");
+    long existing = -1;
+    if (f) {
+        fseek(f, 0, SEEK_END);
+        existing = ftell(f);
+        fclose(f);
+    }
+    if (existing != (long)size) {
+        f = fopen(entry.path.c_str(), "wb");
+        if (!f) {
+            return nullptr;
+        }
+        std::vector<uint8_t> erased(size, 0xFF);
+        fwrite(erased.data(), 1, size, f);
+        fclose(f);
+    }
+
+    partitions().push_back(entry);
+    return &partitions().back().info;
+}
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char* label) {
+    for (const HostPartition& entry : partitions()) {
+        if (entry.info.type == type
+            && (subtype == ESP_PARTITION_SUBTYPE_ANY || entry.info.subtype == subtype)
+            && (!label || strcmp(entry.info.label, label) == 0)) {
+            return &entry.info;
+        }
+    }
+    return nullptr;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t srcOffset, void* dst, size_t size) {
+    const HostPartition* entry = lookup(partition);
+    if (!entry || srcOffset + size > partition->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    FILE* f = fopen(entry->path.c_str(), "rb");
+    if (!f) {
+        return ESP_FAIL;
+    }
+    fseek(f, (long)srcOffset, SEEK_SET);
+    size_t n = fread(dst, 1, size, f);
+    fclose(f);
+    return n == size ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t dstOffset, const void* src, size_t size) {
+    const HostPartition* entry = lookup(partition);
+    if (!entry || dstOffset + size > partition->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // NOR semantics: programming can only clear bits
+    std::vector<uint8_t> current(size);
+    if (esp_partition_read(partition, dstOffset, current.data(), size) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    const uint8_t* data = (const uint8_t*)src;
+    for (size_t i = 0; i < size; i++) {
+        current[i] &= data[i];
+    }
+    FILE* f = fopen(entry->path.c_str(), "r+b");
+    if (!f) {
+        return ESP_FAIL;
+    }
+    fseek(f, (long)dstOffset, SEEK_SET);
+    size_t n = fwrite(current.data(), 1, size, f);
+    fclose(f);
+    return n == size ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size) {
+    if (offset % SPI_FLASH_SEC_SIZE != 0 || size % SPI_FLASH_SEC_SIZE != 0) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    const HostPartition* entry = lookup(partition);
+    if (!entry || offset + size > partition->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    FILE* f = fopen(entry->path.c_str(), "r+b");
+    if (!f) {
+        return ESP_FAIL;
+    }
+    std::vector<uint8_t> erased(size, 0xFF);
+    fseek(f, (long)offset, SEEK_SET);
+    size_t n = fwrite(erased.data(), 1, size, f);
+    fclose(f);
+    return n == size ? ESP_OK : ESP_FAIL;
+}
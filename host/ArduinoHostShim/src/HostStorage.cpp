@@ -0,0 +1,41 @@
+/**
+ * HostStorage.cpp (host shim)
+ */
+
+#include "HostStorage.h"
+#include <stdlib.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+namespace HostStorage {
+    static std::string s_root;
+
+    void setRoot(const std::string& path) {
+        s_root = path;
+        makeDirs(s_root);
+    }
+
+    const std::string& root() {
+        if (s_root.empty()) {
+            const char* env = getenv("HOST_FS_ROOT");
+            setRoot(env && *env ? env : ".host_fs");
+        }
+        return s_root;
+    }
+
+    bool makeDirs(const std::string& path) {
+        std::string current;
+        for (size_t i = 0; i <= path.size(); i++) {
+            if (i == path.size() || path[i] == '/') {
+                if (!current.empty() && mkdir(current.c_str(), 0755) != 0 && errno != EEXIST) {
+                    return false;
+                }
+            }
+            if (i < path.size()) {
+                current += path[i];
+            }
+        }
+        struct stat st;
+        return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+    }
+}
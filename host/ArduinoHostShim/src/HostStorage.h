@@ -0,0 +1,22 @@
+/**
+ * HostStorage.h (host shim)
+ *
+ * Root directory for file-backed NVS and filesystems. Defaults to ./.host_fs
+ * and can be overridden with the HOST_FS_ROOT environment variable so each
+ * simulated node gets its own flash.
+ */
+
+#ifndef HOST_STORAGE_H
+#define HOST_STORAGE_H
+
+#include <string>
+
+namespace HostStorage {
+    void setRoot(const std::string& path);
+    const std::string& root();
+
+    // Create a directory and its parents (mkdir -p); returns true if it exists afterwards
+    bool makeDirs(const std::string& path);
+}
+
+#endif // HOST_STORAGE_H
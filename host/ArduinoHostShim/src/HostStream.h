@@ -0,0 +1,48 @@
+/**
+ * HostStream.h (host shim)
+ *
+ * In-memory Stream used to inject bytes into drivers on the host (e.g. a
+ * recorded VE.Direct capture). Bytes written by the driver are kept in a
+ * separate output buffer so simulations can inspect them.
+ */
+
+#ifndef HOST_STREAM_BUFFER_H
+#define HOST_STREAM_BUFFER_H
+
+#include <deque>
+#include <string>
+#include "Stream.h"
+
+class HostStream : public Stream {
+public:
+    void feed(const uint8_t* data, size_t length) { _input.insert(_input.end(), data, data + length); }
+    void feed(const char* str) { feed((const uint8_t*)str, strlen(str)); }
+    void clearInput() { _input.clear(); }
+
+    const std::string& output() const { return _output; }
+    void clearOutput() { _output.clear(); }
+
+    int available() override { return (int)_input.size(); }
+    int read() override {
+        if (_input.empty()) {
+            return -1;
+        }
+        uint8_t c = _input.front();
+        _input.pop_front();
+        return c;
+    }
+    int peek() override { return _input.empty() ? -1 : _input.front(); }
+
+    size_t write(uint8_t c) override { _output += (char)c; return 1; }
+    size_t write(const uint8_t* buffer, size_t size) override {
+        _output.append((const char*)buffer, size);
+        return size;
+    }
+    using Print::write;
+
+private:
+    std::deque<uint8_t> _input;
+    std::string _output;
+};
+
+#endif // HOST_STREAM_BUFFER_H
@@ -0,0 +1,34 @@
+/**
+ * IPAddress.h (host shim)
+ */
+
+#ifndef HOST_IPADDRESS_H
+#define HOST_IPADDRESS_H
+
+#include <stdint.h>
+#include "WString.h"
+
+class IPAddress {
+public:
+    IPAddress() : IPAddress(0, 0, 0, 0) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _bytes{a, b, c, d} {}
+    explicit IPAddress(uint32_t address) {
+        for (int i = 0; i < 4; i++) _bytes[i] = (uint8_t)(address >> (8 * i));
+    }
+
+    uint8_t operator[](int index) const { return _bytes[index]; }
+    uint8_t& operator[](int index) { return _bytes[index]; }
+    operator uint32_t() const {
+        return (uint32_t)_bytes[0] | ((uint32_t)_bytes[1] << 8) | ((uint32_t)_bytes[2] << 16) | ((uint32_t)_bytes[3] << 24);
+    }
+    bool operator==(const IPAddress& other) const { return (uint32_t)*this == (uint32_t)other; }
+    bool operator!=(const IPAddress& other) const { return !(*this == other); }
+
+    bool fromString(const char* address);
+    String toString() const;
+
+private:
+    uint8_t _bytes[4];
+};
+
+#endif // HOST_IPADDRESS_H
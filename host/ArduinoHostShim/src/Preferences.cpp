@@ -0,0 +1,145 @@
+/**
+ * Preferences.cpp (host shim)
+ */
+
+#include "Preferences.h"
+#include "HostStorage.h"
+#include <stdio.h>
+#include <string.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <vector>
+
+static uint32_t s_writeCount = 0;
+
+uint32_t Preferences::hostWriteCount() {
+    return s_writeCount;
+}
+
+bool Preferences::begin(const char* name, bool readOnly, const char*) {
+    if (!name || strlen(name) > 15) {
+        return false;  // NVS namespace names are limited to 15 characters
+    }
+    _dir = HostStorage::root() + "/nvs/" + name;
+    _open = HostStorage::makeDirs(_dir);
+    _readOnly = readOnly;
+    return _open;
+}
+
+void Preferences::end() {
+    _open = false;
+}
+
+std::string Preferences::keyPath(const char* key) const {
+    return _dir + "/" + (key ? key : "");
+}
+
+bool Preferences::clear() {
+    if (!_open || _readOnly) {
+        return false;
+    }
+    DIR* dir = opendir(_dir.c_str());
+    if (!dir) {
+        return false;
+    }
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (entry->d_name[0] != '.') {
+            unlink((_dir + "/" + entry->d_name).c_str());
+        }
+    }
+    closedir(dir);
+    s_writeCount++;
+    return true;
+}
+
+bool Preferences::remove(const char* key) {
+    if (!_open || _readOnly) {
+        return false;
+    }
+    s_writeCount++;
+    return unlink(keyPath(key).c_str()) == 0;
+}
+
+bool Preferences::isKey(const char* key) {
+    struct stat st;
+    return _open && stat(keyPath(key).c_str(), &st) == 0;
+}
+
+size_t Preferences::putRaw(const char* key, const void* value, size_t length) {
+    if (!_open || _readOnly || !key || strlen(key) > 15) {
+        return 0;
+    }
+    std::string path = keyPath(key);
+    std::string tmp = path + ".tmp";
+    FILE* f = fopen(tmp.c_str(), "wb");
+    if (!f) {
+        return 0;
+    }
+    size_t written = length ? fwrite(value, 1, length, f) : 0;
+    fclose(f);
+    if (written != length || rename(tmp.c_str(), path.c_str()) != 0) {
+        unlink(tmp.c_str());
+        return 0;
+    }
+    s_writeCount++;
+    return length;
+}
+
+bool Preferences::getRaw(const char* key, void* value, size_t length) {
+    if (!_open) {
+        return false;
+    }
+    FILE* f = fopen(keyPath(key).c_str(), "rb");
+    if (!f) {
+        return false;
+    }
+    size_t n = fread(value, 1, length, f);
+    fclose(f);
+    return n == length;
+}
+
+size_t Preferences::putString(const char* key, const char* value) {
+    return putRaw(key, value ? value : "", value ? strlen(value) : 0);
+}
+
+String Preferences::getString(const char* key, const String& defaultValue) {
+    size_t length = getBytesLength(key);
+    if (!isKey(key)) {
+        return defaultValue;
+    }
+    std::vector<char> buffer(length + 1, 0);
+    getBytes(key, buffer.data(), length);
+    return String(buffer.data(), length);
+}
+
+size_t Preferences::getString(const char* key, char* value, size_t maxLength) {
+    if (!value || maxLength == 0 || !isKey(key)) {
+        return 0;
+    }
+    size_t n = getBytes(key, value, maxLength - 1);
+    value[n] = '\0';
+    return n + 1;
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+    struct stat st;
+    if (!_open || stat(keyPath(key).c_str(), &st) != 0) {
+        return 0;
+    }
+    return (size_t)st.st_size;
+}
+
+size_t Preferences::getBytes(const char* key, void* buffer, size_t maxLength) {
+    if (!_open) {
+        return 0;
+    }
+    FILE* f = fopen(keyPath(key).c_str(), "rb");
+    if (!f) {
+        return 0;
+    }
+    size_t n = fread(buffer, 1, maxLength, f);
+    fclose(f);
+    return n;
+}
@@ -0,0 +1,79 @@
+/**
+ * Preferences.h (host shim)
+ *
+ * NVS emulation: one file per key under <HOST_FS_ROOT>/nvs/<namespace>/.
+ * Values are stored as raw bytes, like the ESP32 blob API. Write counts are
+ * tracked so flash-wear work can be measured on the host.
+ */
+
+#ifndef HOST_PREFERENCES_H
+#define HOST_PREFERENCES_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include "WString.h"
+
+class Preferences {
+public:
+    bool begin(const char* name, bool readOnly = false, const char* partitionLabel = nullptr);
+    void end();
+    bool clear();
+    bool remove(const char* key);
+    bool isKey(const char* key);
+
+    size_t putChar(const char* key, int8_t value) { return putRaw(key, &value, sizeof(value)); }
+    size_t putUChar(const char* key, uint8_t value) { return putRaw(key, &value, sizeof(value)); }
+    size_t putShort(const char* key, int16_t value) { return putRaw(key, &value, sizeof(value)); }
+    size_t putUShort(const char* key, uint16_t value) { return putRaw(key, &value, sizeof(value)); }
+    size_t putInt(const char* key, int32_t value) { return putRaw(key, &value, sizeof(value)); }
+    size_t putUInt(const char* key, uint32_t value) { return putRaw(key, &value, sizeof(value)); }
+    size_t putLong(const char* key, int32_t value) { return putInt(key, value); }
+    size_t putULong(const char* key, uint32_t value) { return putUInt(key, value); }
+    size_t putLong64(const char* key, int64_t value) { return putRaw(key, &value, sizeof(value)); }
+    size_t putULong64(const char* key, uint64_t value) { return putRaw(key, &value, sizeof(value)); }
+    size_t putFloat(const char* key, float value) { return putRaw(key, &value, sizeof(value)); }
+    size_t putDouble(const char* key, double value) { return putRaw(key, &value, sizeof(value)); }
+    size_t putBool(const char* key, bool value) { return putUChar(key, value ? 1 : 0); }
+    size_t putString(const char* key, const char* value);
+    size_t putString(const char* key, const String& value) { return putString(key, value.c_str()); }
+    size_t putBytes(const char* key, const void* value, size_t length) { return putRaw(key, value, length); }
+
+    int8_t getChar(const char* key, int8_t defaultValue = 0) { return getValue(key, defaultValue); }
+    uint8_t getUChar(const char* key, uint8_t defaultValue = 0) { return getValue(key, defaultValue); }
+    int16_t getShort(const char* key, int16_t defaultValue = 0) { return getValue(key, defaultValue); }
+    uint16_t getUShort(const char* key, uint16_t defaultValue = 0) { return getValue(key, defaultValue); }
+    int32_t getInt(const char* key, int32_t defaultValue = 0) { return getValue(key, defaultValue); }
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0) { return getValue(key, defaultValue); }
+    int32_t getLong(const char* key, int32_t defaultValue = 0) { return getInt(key, defaultValue); }
+    uint32_t getULong(const char* key, uint32_t defaultValue = 0) { return getUInt(key, defaultValue); }
+    int64_t getLong64(const char* key, int64_t defaultValue = 0) { return getValue(key, defaultValue); }
+    uint64_t getULong64(const char* key, uint64_t defaultValue = 0) { return getValue(key, defaultValue); }
+    float getFloat(const char* key, float defaultValue = 0) { return getValue(key, defaultValue); }
+    double getDouble(const char* key, double defaultValue = 0) { return getValue(key, defaultValue); }
+    bool getBool(const char* key, bool defaultValue = false) { return getUChar(key, defaultValue ? 1 : 0) != 0; }
+    String getString(const char* key, const String& defaultValue = String());
+    size_t getString(const char* key, char* value, size_t maxLength);
+    size_t getBytesLength(const char* key);
+    size_t getBytes(const char* key, void* buffer, size_t maxLength);
+
+    // Host-only: number of put*() calls that reached "flash" since process start
+    static uint32_t hostWriteCount();
+
+private:
+    std::string keyPath(const char* key) const;
+    size_t putRaw(const char* key, const void* value, size_t length);
+    bool getRaw(const char* key, void* value, size_t length);
+
+    template <typename T>
+    T getValue(const char* key, T defaultValue) {
+        T value;
+        return getRaw(key, &value, sizeof(value)) ? value : defaultValue;
+    }
+
+    std::string _dir;
+    bool _open = false;
+    bool _readOnly = false;
+};
+
+#endif // HOST_PREFERENCES_H
@@ -0,0 +1,61 @@
+/**
+ * Print.cpp (host shim)
+ */
+
+#include "Print.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <vector>
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size--) {
+        if (!write(*buffer++)) {
+            break;
+        }
+        n++;
+    }
+    return n;
+}
+
+size_t Print::printf(const char* format, ...) {
+    char stackBuffer[128];
+    va_list args;
+    va_start(args, format);
+    va_list copy;
+    va_copy(copy, args);
+    int len = vsnprintf(stackBuffer, sizeof(stackBuffer), format, copy);
+    va_end(copy);
+    if (len < 0) {
+        va_end(args);
+        return 0;
+    }
+    if ((size_t)len < sizeof(stackBuffer)) {
+        va_end(args);
+        return write((const uint8_t*)stackBuffer, len);
+    }
+    std::vector<char> heapBuffer(len + 1);
+    vsnprintf(heapBuffer.data(), heapBuffer.size(), format, args);
+    va_end(args);
+    return write((const uint8_t*)heapBuffer.data(), len);
+}
+
+size_t Print::print(long value, int base) {
+    return print(String(value, (unsigned char)base));
+}
+
+size_t Print::print(unsigned long value, int base) {
+    return print(String(value, (unsigned char)base));
+}
+
+size_t Print::print(long long value, int base) {
+    return print(String(value, (unsigned char)base));
+}
+
+size_t Print::print(unsigned long long value, int base) {
+    return print(String(value, (unsigned char)base));
+}
+
+size_t Print::print(double value, int digits) {
+    return print(String(value, (unsigned int)digits));
+}
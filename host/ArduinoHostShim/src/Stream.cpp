@@ -0,0 +1,48 @@
+/**
+ * Stream.cpp (host shim)
+ */
+
+#include "Arduino.h"
+#include "Stream.h"
+
+int Stream::timedRead() {
+    unsigned long start = millis();
+    do {
+        int c = read();
+        if (c >= 0) {
+            return c;
+        }
+        yield();
+    } while (millis() - start < _timeoutMs);
+    return -1;
+}
+
+size_t Stream::readBytes(char* buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+        int c = timedRead();
+        if (c < 0) {
+            break;
+        }
+        buffer[count++] = (char)c;
+    }
+    return count;
+}
+
+String Stream::readString() {
+    String result;
+    int c;
+    while ((c = timedRead()) >= 0) {
+        result += (char)c;
+    }
+    return result;
+}
+
+String Stream::readStringUntil(char terminator) {
+    String result;
+    int c;
+    while ((c = timedRead()) >= 0 && c != terminator) {
+        result += (char)c;
+    }
+    return result;
+}
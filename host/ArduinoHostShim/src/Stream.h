@@ -0,0 +1,30 @@
+/**
+ * Stream.h (host shim)
+ */
+
+#ifndef HOST_STREAM_H
+#define HOST_STREAM_H
+
+#include "Print.h"
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    void setTimeout(unsigned long timeoutMs) { _timeoutMs = timeoutMs; }
+    unsigned long getTimeout() const { return _timeoutMs; }
+
+    size_t readBytes(char* buffer, size_t length);
+    size_t readBytes(uint8_t* buffer, size_t length) { return readBytes((char*)buffer, length); }
+    String readString();
+    String readStringUntil(char terminator);
+
+protected:
+    int timedRead();
+
+    unsigned long _timeoutMs = 1000;
+};
+
+#endif // HOST_STREAM_H
@@ -0,0 +1,224 @@
+/**
+ * WString.cpp (host shim)
+ */
+
+#include "WString.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <string.h>
+#include <algorithm>
+
+static std::string formatInteger(unsigned long long value, bool negative, unsigned char base) {
+    if (base < 2 || base > 36) {
+        base = 10;
+    }
+    char buffer[72];
+    int pos = sizeof(buffer) - 1;
+    buffer[pos] = '\0';
+    do {
+        unsigned digit = (unsigned)(value % base);
+        buffer[--pos] = (char)(digit < 10 ? '0' + digit : 'a' + digit - 10);
+        value /= base;
+    } while (value > 0 && pos > 1);
+    if (negative) {
+        buffer[--pos] = '-';
+    }
+    return std::string(&buffer[pos]);
+}
+
+static std::string formatSigned(long long value, unsigned char base) {
+    if (base == 10 && value < 0) {
+        return formatInteger((unsigned long long)(-(value + 1)) + 1, true, base);
+    }
+    return formatInteger((unsigned long long)value, false, base);
+}
+
+static std::string formatFloat(double value, unsigned int decimalPlaces) {
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.*f", (int)decimalPlaces, value);
+    return std::string(buffer);
+}
+
+String::String(const char* str) : _str(str ? str : "") {}
+String::String(const char* str, size_t length) : _str(str ? std::string(str, length) : std::string()) {}
+String::String(const std::string& str) : _str(str) {}
+String::String(char c) : _str(1, c) {}
+String::String(unsigned char value, unsigned char base) : _str(formatInteger(value, false, base)) {}
+String::String(int value, unsigned char base) : _str(formatSigned(value, base)) {}
+String::String(unsigned int value, unsigned char base) : _str(formatInteger(value, false, base)) {}
+String::String(long value, unsigned char base) : _str(formatSigned(value, base)) {}
+String::String(unsigned long value, unsigned char base) : _str(formatInteger(value, false, base)) {}
+String::String(long long value, unsigned char base) : _str(formatSigned(value, base)) {}
+String::String(unsigned long long value, unsigned char base) : _str(formatInteger(value, false, base)) {}
+String::String(float value, unsigned int decimalPlaces) : _str(formatFloat(value, decimalPlaces)) {}
+String::String(double value, unsigned int decimalPlaces) : _str(formatFloat(value, decimalPlaces)) {}
+
+String& String::operator=(const char* str) {
+    _str = str ? str : "";
+    return *this;
+}
+
+bool String::equalsIgnoreCase(const String& other) const {
+    if (_str.size() != other._str.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < _str.size(); i++) {
+        if (tolower((unsigned char)_str[i]) != tolower((unsigned char)other._str[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool String::startsWith(const String& prefix) const {
+    return _str.compare(0, prefix._str.size(), prefix._str) == 0;
+}
+
+bool String::startsWith(const String& prefix, unsigned int offset) const {
+    return offset <= _str.size() && _str.compare(offset, prefix._str.size(), prefix._str) == 0;
+}
+
+bool String::endsWith(const String& suffix) const {
+    return _str.size() >= suffix._str.size() &&
+           _str.compare(_str.size() - suffix._str.size(), suffix._str.size(), suffix._str) == 0;
+}
+
+void String::toCharArray(char* buf, unsigned int bufsize, unsigned int index) const {
+    getBytes((unsigned char*)buf, bufsize, index);
+}
+
+void String::getBytes(unsigned char* buf, unsigned int bufsize, unsigned int index) const {
+    if (!buf || bufsize == 0) {
+        return;
+    }
+    if (index >= _str.size()) {
+        buf[0] = 0;
+        return;
+    }
+    size_t n = std::min((size_t)bufsize - 1, _str.size() - index);
+    memcpy(buf, _str.data() + index, n);
+    buf[n] = 0;
+}
+
+int String::indexOf(char c, unsigned int fromIndex) const {
+    size_t pos = _str.find(c, fromIndex);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::indexOf(const String& str, unsigned int fromIndex) const {
+    size_t pos = _str.find(str._str, fromIndex);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::lastIndexOf(char c) const {
+    size_t pos = _str.rfind(c);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::lastIndexOf(const String& str) const {
+    size_t pos = _str.rfind(str._str);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+String String::substring(unsigned int beginIndex) const {
+    return beginIndex >= _str.size() ? String() : String(_str.substr(beginIndex));
+}
+
+String String::substring(unsigned int beginIndex, unsigned int endIndex) const {
+    if (beginIndex > endIndex) {
+        std::swap(beginIndex, endIndex);
+    }
+    if (beginIndex >= _str.size()) {
+        return String();
+    }
+    endIndex = std::min(endIndex, (unsigned int)_str.size());
+    return String(_str.substr(beginIndex, endIndex - beginIndex));
+}
+
+void String::replace(char find, char replacement) {
+    std::replace(_str.begin(), _str.end(), find, replacement);
+}
+
+void String::replace(const String& find, const String& replacement) {
+    if (find._str.empty()) {
+        return;
+    }
+    size_t pos = 0;
+    while ((pos = _str.find(find._str, pos)) != std::string::npos) {
+        _str.replace(pos, find._str.size(), replacement._str);
+        pos += replacement._str.size();
+    }
+}
+
+void String::remove(unsigned int index) {
+    if (index < _str.size()) {
+        _str.erase(index);
+    }
+}
+
+void String::remove(unsigned int index, unsigned int count) {
+    if (index < _str.size()) {
+        _str.erase(index, count);
+    }
+}
+
+void String::toLowerCase() {
+    for (char& c : _str) c = (char)tolower((unsigned char)c);
+}
+
+void String::toUpperCase() {
+    for (char& c : _str) c = (char)toupper((unsigned char)c);
+}
+
+void String::trim() {
+    size_t begin = _str.find_first_not_of(" \t\r\n\f\v");
+    if (begin == std::string::npos) {
+        _str.clear();
+        return;
+    }
+    size_t end = _str.find_last_not_of(" \t\r\n\f\v");
+    _str = _str.substr(begin, end - begin + 1);
+}
+
+long String::toInt() const {
+    return strtol(_str.c_str(), nullptr, 10);
+}
+
+float String::toFloat() const {
+    return (float)strtod(_str.c_str(), nullptr);
+}
+
+double String::toDouble() const {
+    return strtod(_str.c_str(), nullptr);
+}
+
+String operator+(const String& lhs, const String& rhs) {
+    String result(lhs);
+    result.concat(rhs);
+    return result;
+}
+
+String operator+(const String& lhs, const char* rhs) {
+    String result(lhs);
+    result.concat(rhs);
+    return result;
+}
+
+String operator+(const char* lhs, const String& rhs) {
+    String result(lhs);
+    result.concat(rhs);
+    return result;
+}
+
+String operator+(const String& lhs, char rhs) {
+    String result(lhs);
+    result.concat(rhs);
+    return result;
+}
+
+String operator+(char lhs, const String& rhs) {
+    String result(lhs);
+    result.concat(rhs);
+    return result;
+}
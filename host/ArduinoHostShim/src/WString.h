@@ -0,0 +1,110 @@
+/**
+ * WString.h (host shim)
+ *
+ * Arduino String backed by std::string. Implements the subset of the API the
+ * firmware uses; semantics follow the ESP32 core (indexes are int, -1 = none).
+ */
+
+#ifndef HOST_WSTRING_H
+#define HOST_WSTRING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+class String {
+public:
+    String(const char* str = "");
+    String(const char* str, size_t length);
+    String(const std::string& str);
+    String(const String& other) = default;
+    String(String&& other) = default;
+    explicit String(char c);
+    explicit String(unsigned char value, unsigned char base = 10);
+    explicit String(int value, unsigned char base = 10);
+    explicit String(unsigned int value, unsigned char base = 10);
+    explicit String(long value, unsigned char base = 10);
+    explicit String(unsigned long value, unsigned char base = 10);
+    explicit String(long long value, unsigned char base = 10);
+    explicit String(unsigned long long value, unsigned char base = 10);
+    explicit String(float value, unsigned int decimalPlaces = 2);
+    explicit String(double value, unsigned int decimalPlaces = 2);
+
+    String& operator=(const String& other) = default;
+    String& operator=(String&& other) = default;
+    String& operator=(const char* str);
+
+    bool reserve(unsigned int size) { _str.reserve(size); return true; }
+    unsigned int length() const { return (unsigned int)_str.size(); }
+    bool isEmpty() const { return _str.empty(); }
+    const char* c_str() const { return _str.c_str(); }
+    const std::string& str() const { return _str; }
+
+    bool concat(const String& other) { _str += other._str; return true; }
+    bool concat(const char* str) { if (str) _str += str; return true; }
+    bool concat(const char* str, unsigned int length) { if (str) _str.append(str, length); return true; }
+    bool concat(char c) { _str += c; return true; }
+    bool concat(unsigned char value) { return concat(String(value)); }
+    bool concat(int value) { return concat(String(value)); }
+    bool concat(unsigned int value) { return concat(String(value)); }
+    bool concat(long value) { return concat(String(value)); }
+    bool concat(unsigned long value) { return concat(String(value)); }
+    bool concat(float value) { return concat(String(value)); }
+    bool concat(double value) { return concat(String(value)); }
+
+    template <typename T>
+    String& operator+=(const T& value) { concat(value); return *this; }
+
+    bool equals(const String& other) const { return _str == other._str; }
+    bool equals(const char* str) const { return _str == (str ? str : ""); }
+    bool equalsIgnoreCase(const String& other) const;
+    bool operator==(const String& other) const { return equals(other); }
+    bool operator==(const char* str) const { return equals(str); }
+    bool operator!=(const String& other) const { return !equals(other); }
+    bool operator!=(const char* str) const { return !equals(str); }
+    bool operator<(const String& other) const { return _str < other._str; }
+    int compareTo(const String& other) const { return _str.compare(other._str); }
+
+    bool startsWith(const String& prefix) const;
+    bool startsWith(const String& prefix, unsigned int offset) const;
+    bool endsWith(const String& suffix) const;
+
+    char charAt(unsigned int index) const { return index < _str.size() ? _str[index] : 0; }
+    void setCharAt(unsigned int index, char c) { if (index < _str.size()) _str[index] = c; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    char& operator[](unsigned int index) { return _str[index]; }
+    void toCharArray(char* buf, unsigned int bufsize, unsigned int index = 0) const;
+    void getBytes(unsigned char* buf, unsigned int bufsize, unsigned int index = 0) const;
+
+    int indexOf(char c, unsigned int fromIndex = 0) const;
+    int indexOf(const String& str, unsigned int fromIndex = 0) const;
+    int lastIndexOf(char c) const;
+    int lastIndexOf(const String& str) const;
+    String substring(unsigned int beginIndex) const;
+    String substring(unsigned int beginIndex, unsigned int endIndex) const;
+
+    void replace(char find, char replacement);
+    void replace(const String& find, const String& replacement);
+    void remove(unsigned int index);
+    void remove(unsigned int index, unsigned int count);
+    void toLowerCase();
+    void toUpperCase();
+    void trim();
+
+    long toInt() const;
+    float toFloat() const;
+    double toDouble() const;
+
+private:
+    std::string _str;
+};
+
+String operator+(const String& lhs, const String& rhs);
+String operator+(const String& lhs, const char* rhs);
+String operator+(const char* lhs, const String& rhs);
+String operator+(const String& lhs, char rhs);
+String operator+(char lhs, const String& rhs);
+inline bool operator==(const char* lhs, const String& rhs) { return rhs == lhs; }
+inline bool operator!=(const char* lhs, const String& rhs) { return rhs != lhs; }
+
+#endif // HOST_WSTRING_H
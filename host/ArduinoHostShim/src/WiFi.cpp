@@ -0,0 +1,248 @@
+/**
+ * WiFi.cpp (host shim)
+ */
+
+#include "WiFi.h"
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+WiFiClass WiFi;
+
+// ============================================================================
+// IPAddress
+// ============================================================================
+
+bool IPAddress::fromString(const char* address) {
+    struct in_addr parsed;
+    if (!address || inet_pton(AF_INET, address, &parsed) != 1) {
+        return false;
+    }
+    *this = IPAddress((uint32_t)parsed.s_addr);
+    return true;
+}
+
+String IPAddress::toString() const {
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", _bytes[0], _bytes[1], _bytes[2], _bytes[3]);
+    return String(buffer);
+}
+
+// ============================================================================
+// WiFiClass
+// ============================================================================
+
+wl_status_t WiFiClass::begin(const char* ssid, const char*) {
+    if (ssid && *ssid) {
+        _ssid = ssid;
+    }
+    if (_mode == WIFI_OFF) {
+        _mode = WIFI_STA;
+    }
+    if (_associationDelayMs > 0) {
+        delay(_associationDelayMs);
+    }
+    _status = WL_CONNECTED;
+    return _status;
+}
+
+bool WiFiClass::disconnect(bool wifiOff, bool) {
+    _status = WL_DISCONNECTED;
+    if (wifiOff) {
+        _mode = WIFI_OFF;
+    }
+    return true;
+}
+
+bool WiFiClass::reconnect() {
+    return begin() == WL_CONNECTED;
+}
+
+uint8_t* WiFiClass::macAddress(uint8_t* mac) const {
+    uint64_t efuse = ESP.getEfuseMac();
+    for (int i = 0; i < 6; i++) {
+        mac[i] = (uint8_t)(efuse >> (8 * i));
+    }
+    return mac;
+}
+
+String WiFiClass::macAddress() const {
+    uint8_t mac[6];
+    macAddress(mac);
+    char buffer[18];
+    snprintf(buffer, sizeof(buffer), "%02X:%02X:%02X:%02X:%02X:%02X",
+             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    return String(buffer);
+}
+
+// ============================================================================
+// WiFiClient
+// ============================================================================
+
+int WiFiClient::connect(IPAddress ip, uint16_t port) {
+    return connect(ip.toString().c_str(), port);
+}
+
+int WiFiClient::connect(const char* host, uint16_t port) {
+    stop();
+    if (WiFi.status() != WL_CONNECTED) {
+        return 0;
+    }
+
+    struct addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* result = nullptr;
+    char portStr[8];
+    snprintf(portStr, sizeof(portStr), "%u", port);
+    if (getaddrinfo(host, portStr, &hints, &result) != 0 || !result) {
+        return 0;
+    }
+
+    int fd = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+    if (fd < 0) {
+        freeaddrinfo(result);
+        return 0;
+    }
+
+    // Non-blocking connect with timeout (mirrors the ESP32 client timeout)
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    int rc = ::connect(fd, result->ai_addr, result->ai_addrlen);
+    freeaddrinfo(result);
+    if (rc != 0 && errno != EINPROGRESS) {
+        close(fd);
+        return 0;
+    }
+    if (rc != 0) {
+        struct pollfd pfd = {fd, POLLOUT, 0};
+        int soError = 0;
+        socklen_t len = sizeof(soError);
+        if (poll(&pfd, 1, (int)_connectTimeoutMs) != 1 ||
+            getsockopt(fd, SOL_SOCKET, SO_ERROR, &soError, &len) != 0 || soError != 0) {
+            close(fd);
+            return 0;
+        }
+    }
+
+    _fd = fd;
+    _rxLength = 0;
+    _rxPos = 0;
+    setNoDelay(true);
+    return 1;
+}
+
+void WiFiClient::setNoDelay(bool noDelay) {
+    if (_fd >= 0) {
+        int flag = noDelay ? 1 : 0;
+        setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+    }
+}
+
+size_t WiFiClient::write(const uint8_t* buffer, size_t size) {
+    if (_fd < 0) {
+        return 0;
+    }
+    size_t sent = 0;
+    while (sent < size) {
+        ssize_t n = send(_fd, buffer + sent, size - sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            sent += (size_t)n;
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            struct pollfd pfd = {_fd, POLLOUT, 0};
+            if (poll(&pfd, 1, (int)_connectTimeoutMs) == 1) {
+                continue;
+            }
+        }
+        stop();
+        break;
+    }
+    _bytesSent += sent;
+    return sent;
+}
+
+bool WiFiClient::fillBuffer() {
+    if (_rxPos < _rxLength) {
+        return true;
+    }
+    if (_fd < 0) {
+        return false;
+    }
+    ssize_t n = recv(_fd, _rxBuffer, sizeof(_rxBuffer), 0);
+    if (n > 0) {
+        _rxLength = (size_t)n;
+        _rxPos = 0;
+        _bytesReceived += (uint64_t)n;
+        return true;
+    }
+    if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+        stop();  // Peer closed or hard error
+    }
+    return false;
+}
+
+int WiFiClient::available() {
+    if (!fillBuffer()) {
+        return 0;
+    }
+    return (int)(_rxLength - _rxPos);
+}
+
+int WiFiClient::read() {
+    if (!fillBuffer()) {
+        return -1;
+    }
+    return _rxBuffer[_rxPos++];
+}
+
+int WiFiClient::read(uint8_t* buffer, size_t size) {
+    size_t count = 0;
+    while (count < size && fillBuffer()) {
+        size_t chunk = std::min(size - count, _rxLength - _rxPos);
+        memcpy(buffer + count, _rxBuffer + _rxPos, chunk);
+        _rxPos += chunk;
+        count += chunk;
+    }
+    return count > 0 ? (int)count : -1;
+}
+
+int WiFiClient::peek() {
+    if (!fillBuffer()) {
+        return -1;
+    }
+    return _rxBuffer[_rxPos];
+}
+
+void WiFiClient::stop() {
+    if (_fd >= 0) {
+        close(_fd);
+        _fd = -1;
+    }
+    _rxLength = 0;
+    _rxPos = 0;
+}
+
+uint8_t WiFiClient::connected() {
+    if (_fd < 0) {
+        return 0;
+    }
+    if (_rxPos < _rxLength) {
+        return 1;
+    }
+    // Probe for an orderly shutdown without consuming data
+    uint8_t probe;
+    ssize_t n = recv(_fd, &probe, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+        stop();
+        return 0;
+    }
+    return 1;
+}
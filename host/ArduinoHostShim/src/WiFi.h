@@ -0,0 +1,71 @@
+/**
+ * WiFi.h (host shim)
+ *
+ * Fake station interface: begin() "associates" immediately using the host's
+ * network, RSSI and link state can be scripted by simulations.
+ */
+
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+#include "Arduino.h"
+#include "IPAddress.h"
+#include "WiFiClient.h"
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_SCAN_COMPLETED = 2,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum {
+    WIFI_OFF = 0,
+    WIFI_STA = 1,
+    WIFI_AP = 2,
+    WIFI_AP_STA = 3
+} wifi_mode_t;
+
+class WiFiClass {
+public:
+    bool mode(wifi_mode_t mode) { _mode = mode; return true; }
+    wifi_mode_t getMode() const { return _mode; }
+    wl_status_t begin(const char* ssid = nullptr, const char* passphrase = nullptr);
+    wl_status_t status() const { return _status; }
+    bool isConnected() const { return _status == WL_CONNECTED; }
+    bool disconnect(bool wifiOff = false, bool eraseAp = false);
+    bool reconnect();
+    bool setAutoReconnect(bool autoReconnect) { _autoReconnect = autoReconnect; return true; }
+    bool getAutoReconnect() const { return _autoReconnect; }
+    bool setSleep(bool) { return true; }
+    bool setHostname(const char* hostname) { _hostname = hostname ? hostname : ""; return true; }
+    void persistent(bool) {}
+
+    int8_t RSSI() const { return _status == WL_CONNECTED ? _rssi : 0; }
+    String SSID() const { return _ssid; }
+    String BSSIDstr() const { return "02:00:00:00:00:01"; }
+    IPAddress localIP() const { return _status == WL_CONNECTED ? IPAddress(127, 0, 0, 1) : IPAddress(); }
+    String macAddress() const;
+    uint8_t* macAddress(uint8_t* mac) const;
+
+    // Host-only scripting hooks for simulations
+    void hostSetRssi(int8_t rssi) { _rssi = rssi; }
+    void hostSetLinkUp(bool up) { _status = up ? WL_CONNECTED : WL_CONNECTION_LOST; }
+    void hostSetAssociationDelay(unsigned long ms) { _associationDelayMs = ms; }
+
+private:
+    wifi_mode_t _mode = WIFI_OFF;
+    wl_status_t _status = WL_DISCONNECTED;
+    bool _autoReconnect = true;
+    int8_t _rssi = -60;
+    String _ssid = "host";
+    String _hostname;
+    unsigned long _associationDelayMs = 0;
+};
+
+extern WiFiClass WiFi;
+
+#endif // HOST_WIFI_H
@@ -0,0 +1,53 @@
+/**
+ * WiFiClient.h (host shim)
+ *
+ * TCP client over POSIX sockets, so the real PubSubClient library can talk to
+ * a broker on the host (e.g. a local mosquitto).
+ */
+
+#ifndef HOST_WIFI_CLIENT_H
+#define HOST_WIFI_CLIENT_H
+
+#include "Client.h"
+
+class WiFiClient : public Client {
+public:
+    WiFiClient() {}
+    ~WiFiClient() override { stop(); }
+    WiFiClient(const WiFiClient&) = delete;
+    WiFiClient& operator=(const WiFiClient&) = delete;
+
+    int connect(IPAddress ip, uint16_t port) override;
+    int connect(const char* host, uint16_t port) override;
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    int available() override;
+    int read() override;
+    int read(uint8_t* buffer, size_t size) override;
+    int peek() override;
+    void flush() override {}
+    void stop() override;
+    uint8_t connected() override;
+    operator bool() override { return _fd >= 0; }
+
+    void setNoDelay(bool noDelay);
+    void setTimeout(uint32_t seconds) { _connectTimeoutMs = seconds * 1000; }
+
+    // Host-only: bytes moved through this client (airtime estimates in simulations)
+    uint64_t hostBytesSent() const { return _bytesSent; }
+    uint64_t hostBytesReceived() const { return _bytesReceived; }
+
+private:
+    bool fillBuffer();
+
+    int _fd = -1;
+    uint32_t _connectTimeoutMs = 5000;
+    uint8_t _rxBuffer[1460];
+    size_t _rxLength = 0;
+    size_t _rxPos = 0;
+    uint64_t _bytesSent = 0;
+    uint64_t _bytesReceived = 0;
+};
+
+#endif // HOST_WIFI_CLIENT_H
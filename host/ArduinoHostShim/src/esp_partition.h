@@ -0,0 +1,54 @@
+/**
+ * esp_partition.h (host shim)
+ *
+ * Raw flash partitions backed by files under $HOST_FS_ROOT/partitions/.
+ * Partitions must be declared with hostDefinePartition() before they can be
+ * found (the partition table is part of the firmware build, not the code).
+ * Writes behave like NOR flash: bits can only be cleared, so rewriting data
+ * without an erase shows up as corruption, as it would on the device.
+ */
+
+#ifndef HOST_ESP_PARTITION_H
+#define HOST_ESP_PARTITION_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef int esp_err_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_INVALID_SIZE 0x104
+
+#define SPI_FLASH_SEC_SIZE 4096
+
+typedef enum {
+    ESP_PARTITION_TYPE_APP = 0x00,
+    ESP_PARTITION_TYPE_DATA = 0x01
+} esp_partition_type_t;
+
+typedef int esp_partition_subtype_t;
+#define ESP_PARTITION_SUBTYPE_ANY 0xff
+
+typedef struct {
+    esp_partition_type_t type;
+    esp_partition_subtype_t subtype;
+    uint32_t address;
+    uint32_t size;
+    char label[17];
+    bool encrypted;
+} esp_partition_t;
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char* label);
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t srcOffset, void* dst, size_t size);
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t dstOffset, const void* src, size_t size);
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size);
+
+// Host-only: declare a partition (size in bytes, multiple of SPI_FLASH_SEC_SIZE).
+// The backing file is created erased (0xFF) if missing or of a different size.
+const esp_partition_t* hostDefinePartition(const char* label, esp_partition_type_t type,
+                                           esp_partition_subtype_t subtype, uint32_t size);
+
+#endif // HOST_ESP_PARTITION_H
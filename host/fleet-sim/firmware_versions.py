@@ -0,0 +1,26 @@
+# Firmware versions for the simulated nodes, read from the sensor projects'
+# platformio.ini (the build flags update_version.sh maintains) so status and
+# event documents carry the versions the real firmware would report.
+import os
+import re
+
+Import("env")
+
+
+def firmware_version(project):
+    ini = os.path.join(env.subst("$PROJECT_DIR"), "..", "..", project, "platformio.ini")
+    with open(ini) as f:
+        text = f.read()
+    parts = []
+    for flag in ("FIRMWARE_VERSION_MAJOR", "FIRMWARE_VERSION_MINOR", "FIRMWARE_VERSION_PATCH", "BUILD_TIMESTAMP"):
+        match = re.search(flag + r"\s*=\s*(\d+)", text)
+        if match is None:
+            raise ValueError("%s not found in %s" % (flag, ini))
+        parts.append(match.group(1))
+    return "%s.%s.%s-build%s" % tuple(parts)
+
+
+env.Append(CPPDEFINES=[
+    ("TEMPERATURE_SENSOR_VERSION", env.StringifyMacro(firmware_version("temperature-sensor"))),
+    ("BME280_SENSOR_VERSION", env.StringifyMacro(firmware_version("bme280-sensor"))),
+])
@@ -0,0 +1,79 @@
+#include "FleetStats.h"
+#include <algorithm>
+
+void LatencySamples::add(uint32_t valueUs) {
+    _seen++;
+    if (_samples.size() < _capacity) {
+        _samples.push_back(valueUs);
+        return;
+    }
+    uint64_t slot = (uint64_t)random(0x7FFFFFFF) % _seen;
+    if (slot < _capacity) {
+        _samples[(size_t)slot] = valueUs;
+    }
+}
+
+uint32_t LatencySamples::percentile(float p) const {
+    if (_samples.empty()) {
+        return 0;
+    }
+    std::vector<uint32_t> sorted(_samples);
+    size_t index = (size_t)((p / 100.0f) * (sorted.size() - 1) + 0.5f);
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    return sorted[index];
+}
+
+uint32_t LatencySamples::max() const {
+    if (_samples.empty()) {
+        return 0;
+    }
+    return *std::max_element(_samples.begin(), _samples.end());
+}
+
+void FleetStats::reportInterval(unsigned long nowMs) {
+    float seconds = (nowMs - _lastReportMs) / 1000.0f;
+    if (seconds <= 0) {
+        return;
+    }
+    uint64_t published = counters.published - _last.published;
+    uint64_t payloadBytes = counters.payloadBytes - _last.payloadBytes;
+    uint64_t connects = counters.connects - _last.connects;
+    uint64_t connectFailures = counters.connectFailures - _last.connectFailures;
+
+    printf("[FLEET] t=%5lus online=%u sleeping=%u | %7.1f msg/s %9.1f B/s | connects=%llu failed=%llu | "
+           "latency p50=%u p95=%u p99=%u us (n=%zu) lost=%llu\n",
+           nowMs / 1000, _online, _sleeping, published / seconds, payloadBytes / seconds,
+           (unsigned long long)connects, (unsigned long long)connectFailures,
+           _intervalLatency.percentile(50), _intervalLatency.percentile(95), _intervalLatency.percentile(99),
+           _intervalLatency.count(), (unsigned long long)(counters.lost - _last.lost));
+    fflush(stdout);
+
+    _last = counters;
+    _intervalLatency.clear();
+    _lastReportMs = nowMs;
+}
+
+void FleetStats::reportSummary(unsigned long elapsedMs) const {
+    float seconds = elapsedMs / 1000.0f;
+    if (seconds <= 0) {
+        seconds = 1;
+    }
+    printf("\n========== Fleet summary (%.0f s) ==========\n", seconds);
+    printf("Published:        %llu msgs (%llu failed), %.1f msg/s\n",
+           (unsigned long long)counters.published, (unsigned long long)counters.publishFailures,
+           counters.published / seconds);
+    printf("Payload:          %llu bytes, %.1f B/s\n", (unsigned long long)counters.payloadBytes,
+           counters.payloadBytes / seconds);
+    printf("On the wire:      %llu bytes, %.1f B/s\n", (unsigned long long)counters.wireBytes,
+           counters.wireBytes / seconds);
+    printf("Connects:         %llu (%llu failed), %llu disconnects, %llu deep-sleep wakes\n",
+           (unsigned long long)counters.connects, (unsigned long long)counters.connectFailures,
+           (unsigned long long)counters.disconnects, (unsigned long long)counters.wakes);
+    printf("Connect latency:  p50=%u p95=%u p99=%u max=%u us\n",
+           connectLatency.percentile(50), connectLatency.percentile(95), connectLatency.percentile(99),
+           connectLatency.max());
+    printf("Broker latency:   p50=%u p95=%u p99=%u max=%u us (%llu delivered, %llu lost)\n",
+           brokerLatency.percentile(50), brokerLatency.percentile(95), brokerLatency.percentile(99),
+           brokerLatency.max(), (unsigned long long)counters.received, (unsigned long long)counters.lost);
+    printf("============================================\n");
+}
@@ -0,0 +1,69 @@
+/**
+ * FleetStats.h
+ *
+ * Counters and latency samples shared by all virtual nodes. Reported per
+ * interval (rates since the previous report) and as a final summary.
+ */
+
+#ifndef FLEET_STATS_H
+#define FLEET_STATS_H
+
+#include <Arduino.h>
+#include <vector>
+
+class LatencySamples {
+public:
+    explicit LatencySamples(size_t capacity = 200000) : _capacity(capacity) {}
+
+    void add(uint32_t valueUs);
+    void clear() { _samples.clear(); _seen = 0; }
+    size_t count() const { return (size_t)_seen; }
+
+    // Percentile in microseconds (p in 0..100), 0 if empty. Sorts a copy.
+    uint32_t percentile(float p) const;
+    uint32_t max() const;
+
+private:
+    std::vector<uint32_t> _samples;
+    size_t _capacity;
+    uint64_t _seen = 0;   // Reservoir sampling once capacity is reached
+};
+
+struct FleetCounters {
+    uint64_t published = 0;
+    uint64_t publishFailures = 0;
+    uint64_t payloadBytes = 0;      // Topic + payload, as counted by the broker
+    uint64_t wireBytes = 0;         // TCP bytes sent (MQTT framing included)
+    uint64_t connects = 0;
+    uint64_t connectFailures = 0;
+    uint64_t disconnects = 0;
+    uint64_t wakes = 0;             // Deep-sleep wake cycles
+    uint64_t received = 0;          // Messages seen by the latency probe
+    uint64_t lost = 0;              // Expected by the probe but never delivered
+};
+
+class FleetStats {
+public:
+    FleetCounters counters;
+    LatencySamples brokerLatency;   // Publish → probe delivery
+    LatencySamples connectLatency;  // TCP connect + CONNACK
+
+    void addBrokerLatency(uint32_t latencyUs) {
+        brokerLatency.add(latencyUs);
+        _intervalLatency.add(latencyUs);
+    }
+    void setOnline(uint32_t online, uint32_t sleeping) { _online = online; _sleeping = sleeping; }
+
+    // Print rates since the previous call and reset the interval window
+    void reportInterval(unsigned long nowMs);
+    void reportSummary(unsigned long elapsedMs) const;
+
+private:
+    FleetCounters _last;
+    LatencySamples _intervalLatency{20000};
+    unsigned long _lastReportMs = 0;
+    uint32_t _online = 0;
+    uint32_t _sleeping = 0;
+};
+
+#endif // FLEET_STATS_H
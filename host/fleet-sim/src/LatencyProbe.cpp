@@ -0,0 +1,55 @@
+#include "LatencyProbe.h"
+
+LatencyProbe* LatencyProbe::s_instance = nullptr;
+
+LatencyProbe::LatencyProbe(FleetStats& stats) : _stats(stats), _mqtt(_net) {}
+
+bool LatencyProbe::begin(const char* host, uint16_t port, const char* topicFilter) {
+    s_instance = this;
+    _mqtt.setServer(host, port);
+    _mqtt.setBufferSize(4096);
+    _mqtt.setCallback(onMessage);
+    if (!_mqtt.connect("fleet-sim-probe")) {
+        printf("[PROBE] Connect to %s:%u failed, state=%d\n", host, port, _mqtt.state());
+        return false;
+    }
+    _net.setNoDelay(true);
+    return _mqtt.subscribe(topicFilter);
+}
+
+void LatencyProbe::expect(const char* topic, size_t length, uint32_t sentUs) {
+    _pending[topic].push_back({sentUs, (uint32_t)length});
+}
+
+void LatencyProbe::service() {
+    // PubSubClient handles one packet per loop() call
+    do {
+        _mqtt.loop();
+    } while (_net.available() > 0);
+}
+
+void LatencyProbe::onMessage(char* topic, uint8_t* payload, unsigned int length) {
+    (void)payload;
+    if (s_instance) {
+        s_instance->handleMessage(topic, length);
+    }
+}
+
+void LatencyProbe::handleMessage(const char* topic, unsigned int length) {
+    uint32_t now = micros();
+    auto it = _pending.find(topic);
+    if (it == _pending.end()) {
+        return;  // Retained message from an earlier run or a real device
+    }
+    std::deque<Pending>& queue = it->second;
+    while (!queue.empty()) {
+        Pending pending = queue.front();
+        queue.pop_front();
+        if (pending.length == length) {
+            _stats.counters.received++;
+            _stats.addBrokerLatency(now - pending.sentUs);
+            return;
+        }
+        _stats.counters.lost++;
+    }
+}
@@ -0,0 +1,52 @@
+/**
+ * LatencyProbe.h
+ *
+ * Subscriber that measures publish-to-delivery latency through the broker.
+ * Payloads stay byte-identical to the firmware: instead of embedding a
+ * timestamp, each publish registers (topic, length, send time) and deliveries
+ * are matched in order per topic. Every simulated topic has exactly one
+ * publisher and QoS 0 keeps per-topic order, so a length mismatch means the
+ * broker dropped the message (counted as lost).
+ */
+
+#ifndef LATENCY_PROBE_H
+#define LATENCY_PROBE_H
+
+#include <Arduino.h>
+#include <PubSubClient.h>
+#include <WiFiClient.h>
+#include <deque>
+#include <string>
+#include <unordered_map>
+
+#include "FleetStats.h"
+
+class LatencyProbe {
+public:
+    explicit LatencyProbe(FleetStats& stats);
+
+    bool begin(const char* host, uint16_t port, const char* topicFilter);
+    void expect(const char* topic, size_t length, uint32_t sentUs);
+
+    // Drain everything the broker has delivered so far
+    void service();
+    bool connected() { return _mqtt.connected(); }
+
+private:
+    struct Pending {
+        uint32_t sentUs;
+        uint32_t length;
+    };
+
+    static void onMessage(char* topic, uint8_t* payload, unsigned int length);
+    void handleMessage(const char* topic, unsigned int length);
+
+    static LatencyProbe* s_instance;
+
+    FleetStats& _stats;
+    WiFiClient _net;
+    PubSubClient _mqtt;
+    std::unordered_map<std::string, std::deque<Pending>> _pending;
+};
+
+#endif // LATENCY_PROBE_H
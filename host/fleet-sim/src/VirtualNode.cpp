@@ -0,0 +1,436 @@
+#include "VirtualNode.h"
+#include "bme280_payloads.h"
+#include "temperature_payloads.h"
+#include <string>
+#include <vector>
+
+// ==================== VirtualNode ====================
+
+VirtualNode::VirtualNode(const String& name, const SimConfig& config, FleetStats& stats, LatencyProbe* probe,
+                         bool deepSleep)
+    : _name(name), _deepSleep(deepSleep), _config(config), _stats(stats), _probe(probe), _mqtt(_net) {
+    char chipId[9];
+    snprintf(chipId, sizeof(chipId), "%08lx", (unsigned long)random(0x7FFFFFFF));
+    _chipId = chipId;
+    _mqtt.setServer(_config.brokerHost.c_str(), _config.brokerPort);
+    _mqtt.setBufferSize(2048);  // MQTT_MAX_PACKET_SIZE on ESP32 builds
+
+    // Spread power-on across one publish interval, like a fleet that was not booted together
+    _stateUntil = millis() + random(SENSOR_INTERVAL_MS);
+}
+
+String VirtualNode::topic(const char* suffix) const {
+    return String(topicBase()) + "/" + _name + suffix;
+}
+
+unsigned long VirtualNode::associationDelay() const {
+    return random(_config.associationMinMs, _config.associationMaxMs + 1);
+}
+
+void VirtualNode::service(unsigned long now) {
+    onTick(now);
+
+    switch (_state) {
+        case State::Sleeping:
+            if ((long)(now - _stateUntil) < 0) {
+                return;
+            }
+            _stats.counters.wakes++;
+            _state = State::Booting;
+            _stateUntil = now + _config.bootDelayMs;
+            return;
+
+        case State::Booting:
+            if ((long)(now - _stateUntil) < 0) {
+                return;
+            }
+            _bootTime = now;
+            _state = State::Associating;
+            _stateUntil = now + associationDelay();
+            return;
+
+        case State::Associating:
+            if ((long)(now - _stateUntil) < 0) {
+                return;
+            }
+            _state = State::Online;
+            _associatedAt = now;
+            _lastReconnectAttempt = 0;
+            _lastPublish = 0;
+            _published = false;
+            break;
+
+        case State::Online:
+            break;
+    }
+
+    if (!_mqtt.connected()) {
+        if (_lastReconnectAttempt != 0 && (now - _lastReconnectAttempt) < MQTT_RECONNECT_INTERVAL_MS) {
+            return;
+        }
+        if (!connectMqtt(now)) {
+            return;
+        }
+    }
+    _mqtt.loop();
+
+    if (_reconnectEvent) {
+        _reconnectEvent = false;
+        publishEvent("wifi_reconnected", "WiFi reconnected - SSID: sim, IP: 127.0.0.1", "info");
+    }
+
+    bool due;
+    if (_deepSleep) {
+        // Wake cycle: publish once, retry at the reconnect interval until it succeeds
+        due = !_published && (_lastPublish == 0 || (now - _lastPublish) >= MQTT_RECONNECT_INTERVAL_MS);
+    } else {
+        due = _lastPublish == 0 || (now - _lastPublish) > publishIntervalMs();
+    }
+    if (due) {
+        _published = false;
+        publishCycle(now);
+        _lastPublish = now;
+        if (_deepSleep && _published) {
+            enterDeepSleep(now);
+        }
+    }
+
+    uint64_t wireBytes = _net.hostBytesSent();
+    _stats.counters.wireBytes += wireBytes - _lastWireBytes;
+    _lastWireBytes = wireBytes;
+}
+
+bool VirtualNode::connectMqtt(unsigned long now) {
+    _lastReconnectAttempt = now;
+    String clientId = _name + "-" + _chipId;
+    uint32_t start = micros();
+    if (!_mqtt.connect(clientId.c_str())) {
+        _stats.counters.connectFailures++;
+        return false;
+    }
+    _stats.connectLatency.add(micros() - start);
+    _stats.counters.connects++;
+    _mqtt.subscribe(topic("/command").c_str());
+    return true;
+}
+
+void VirtualNode::enterDeepSleep(unsigned long now) {
+    _mqtt.disconnect();  // gracefulMqttDisconnect() before esp_deep_sleep_start()
+    _stats.counters.disconnects++;
+    _state = State::Sleeping;
+    _stateUntil = now + _config.sleepSeconds * 1000UL;
+}
+
+void VirtualNode::dropLink(unsigned long now, unsigned long outageMs) {
+    if (_state != State::Online && _state != State::Associating) {
+        return;  // Asleep or booting: the node reassociates on its own schedule
+    }
+    if (_mqtt.connected()) {
+        _net.stop();  // No DISCONNECT packet: the AP vanished
+        _stats.counters.disconnects++;
+    }
+    _state = State::Associating;
+    // The firmware only notices on its next WiFi check, then reassociates
+    _stateUntil = now + outageMs + random(WIFI_CHECK_INTERVAL_MS) + associationDelay();
+    _reconnectEvent = true;
+}
+
+bool VirtualNode::publish(const String& topic, const String& payload, bool retain) {
+    if (!_mqtt.connected()) {
+        _stats.counters.publishFailures++;
+        return false;
+    }
+    uint32_t sentUs = micros();
+    if (!_mqtt.publish(topic.c_str(), payload.c_str(), retain)) {
+        _stats.counters.publishFailures++;
+        return false;
+    }
+    if (_probe) {
+        _probe->expect(topic.c_str(), payload.length(), sentUs);
+    }
+    _stats.counters.published++;
+    _stats.counters.payloadBytes += topic.length() + payload.length();
+    _published = true;
+    return true;
+}
+
+void VirtualNode::publishEvent(const char* eventType, const String& message, const char* severity) {
+    JsonDocument doc;
+    if (!buildEvent(doc, eventType, message, severity)) {
+        return;
+    }
+    String payload;
+    serializeJson(doc, payload);
+    publish(topic("/events"), payload, false);
+}
+
+// ==================== TemperatureNode ====================
+
+bool TemperatureNode::buildEvent(JsonDocument& doc, const char* eventType, const String& message,
+                                 const char* severity) {
+    TemperaturePayloads::Event event;
+    event.type = eventType;
+    event.severity = severity;
+    event.message = message.c_str();
+    event.timestamp = millis() / 1000;
+    event.uptimeSeconds = (millis() - _bootTime) / 1000;
+    event.freeHeap = ESP.getFreeHeap();
+    TemperaturePayloads::buildEvent(doc, {_name.c_str(), _chipId.c_str(), TEMPERATURE_SENSOR_VERSION}, event);
+    return true;
+}
+
+void TemperatureNode::publishCycle(unsigned long now) {
+    _celsius += (random(21) - 10) / 100.0f;
+    const TemperaturePayloads::Identity id = {_name.c_str(), _chipId.c_str(), TEMPERATURE_SENSOR_VERSION};
+    float batteryVoltage = 3.7f + random(40) / 100.0f;
+    int batteryPercent = _deepSleep ? 60 + (int)random(40) : -1;  // Battery nodes are the sleepers
+
+    // publishTemperature()
+    TemperaturePayloads::Reading reading;
+    reading.timestamp = now / 1000;
+    reading.celsius = _celsius;
+    reading.batteryVoltage = batteryVoltage;
+    reading.batteryPercent = batteryPercent;
+    JsonDocument doc;
+    TemperaturePayloads::buildReading(doc, id, reading);
+    String payload;
+    serializeJson(doc, payload);
+    if (!publish(topic("/temperature"), payload, false)) {
+        return;
+    }
+
+    // publishStatus()
+    TemperaturePayloads::Status status;
+    status.timestamp = now / 1000;
+    status.uptimeSeconds = (now - _bootTime) / 1000;
+    status.wifiConnected = true;
+    status.wifiRssi = -50 - (int)random(35);
+    status.freeHeap = ESP.getFreeHeap();
+    status.sensorHealthy = true;
+    status.deepSleepSeconds = _deepSleep ? _config.sleepSeconds : 0;
+    status.sensorIntervalSeconds = SENSOR_INTERVAL_MS / 1000;
+    status.batteryVoltage = batteryVoltage;
+    status.batteryPercent = batteryPercent;
+    status.loopMaxMs = 40 + random(200);
+    if (_deepSleep) {
+        // The DS18B20 conversion (750 ms) finishes during association
+        status.wakeToPublishMs = _config.bootDelayMs + (now - _bootTime);
+        status.wakeWifiMs = _config.bootDelayMs + (_associatedAt - _bootTime);
+        status.wakeConversionWaitMs = 0;
+    }
+    status.txPowerDbm = 19.5f;
+    status.txEnergyPerPublishUj = 2000.0f + random(500);
+    status.resetReason = _deepSleep ? "deep_sleep" : "power_on";
+    status.bootCount = 1;
+    status.configCommits = 1;
+    status.configSlotWrites[0] = 1;
+    status.mqttPayloadMaxBytes = payload.length();
+    payload = "";
+    doc.clear();
+    TemperaturePayloads::buildStatus(doc, id, status);
+    serializeJson(doc, payload);
+    publish(topic("/status"), payload, true);
+}
+
+// ==================== Bme280Node ====================
+
+bool Bme280Node::buildEvent(JsonDocument& doc, const char* eventType, const String& message,
+                            const char* severity) {
+    Bme280Payloads::Event event;
+    event.type = eventType;
+    event.severity = severity;
+    event.message = message.c_str();
+    event.timestamp = millis() / 1000;
+    event.uptimeSeconds = (millis() - _bootTime) / 1000;
+    event.freeHeap = ESP.getFreeHeap();
+    Bme280Payloads::buildEvent(doc, {_name.c_str(), _chipId.c_str(), BME280_SENSOR_VERSION}, event);
+    return true;
+}
+
+void Bme280Node::publishCycle(unsigned long now) {
+    _temperature += (random(21) - 10) / 100.0f;
+    _humidity += (random(21) - 10) / 50.0f;
+    _pressure += random(21) - 10;
+    const float pressureBaseline = 101325.0f;
+    const Bme280Payloads::Identity id = {_name.c_str(), _chipId.c_str(), BME280_SENSOR_VERSION};
+
+    // publishReadings()
+    Bme280Payloads::Readings readings;
+    readings.timestamp = now / 1000;
+    readings.uptimeSeconds = (now - _bootTime) / 1000;
+    readings.temperatureC = _temperature;
+    readings.humidityRh = _humidity;
+    readings.pressurePa = _pressure;
+    readings.altitudeM = 44330.0f * (1.0f - powf(_pressure / 101325.0f, 0.1903f));
+    readings.pressureBaseline = pressureBaseline;
+    if (_deepSleep) {
+        readings.batteryVoltage = 3.7f + random(40) / 100.0f;
+        readings.batteryPercent = 60 + random(40);
+    }
+    JsonDocument doc;
+    Bme280Payloads::buildReadings(doc, id, readings);
+    String payload;
+    serializeJson(doc, payload);
+    if (!publish(topic("/readings"), payload, false)) {
+        return;
+    }
+
+    // publishStatus()
+    Bme280Payloads::Status status;
+    status.timestamp = now / 1000;
+    status.uptimeSeconds = (now - _bootTime) / 1000;
+    status.wifiConnected = true;
+    status.wifiRssi = -50 - (int)random(35);
+    status.ipAddress = "192.168.1." + String((int)random(2, 254));
+    status.freeHeap = ESP.getFreeHeap();
+    status.sensorHealthy = true;
+    status.deepSleepSeconds = _deepSleep ? _config.sleepSeconds : 0;
+    status.sensorIntervalSeconds = SENSOR_INTERVAL_MS / 1000;
+    status.pressureBaseline = pressureBaseline;
+    if (_deepSleep) {
+        // The forced measurement (~50 ms) finishes during association
+        status.wakeToPublishMs = _config.bootDelayMs + (now - _bootTime);
+        status.wakeWifiMs = _config.bootDelayMs + (_associatedAt - _bootTime);
+    }
+    status.loopMaxMs = 40 + random(200);
+    for (uint8_t i = 0; i < 4; i++) {
+        status.loopHistogram[i] = random(10000);
+    }
+    status.txPowerDbm = 19.5f;
+    status.txEnergyPerPublishUj = 2000.0f + random(500);
+    status.resetReason = _deepSleep ? "deep_sleep" : "power_on";
+    status.bootCount = 1;
+    status.configCommits = 1;
+    status.configSlotWrites[0] = 1;
+    status.mqttPayloadMaxBytes = payload.length();
+    payload = "";
+    doc.clear();
+    Bme280Payloads::buildStatus(doc, id, status);
+    serializeJson(doc, payload);
+    publish(topic("/status"), payload, true);
+}
+
+// ==================== SolarNode ====================
+
+// VE.Direct block with a valid checksum (all bytes sum to 0 mod 256)
+static std::string buildBlock(const std::vector<std::pair<std::string, std::string>>& fields) {
+    std::string block;
+    for (const auto& field : fields) {
+        block += "\r\n" + field.first + "\t" + field.second;
+    }
+    block += "\r\nChecksum\t";
+    uint8_t sum = 0;
+    for (char c : block) {
+        sum += (uint8_t)c;
+    }
+    block += (char)(uint8_t)(256 - sum);
+    return block;
+}
+
+SolarNode::SolarNode(const String& name, const SimConfig& config, FleetStats& stats, LatencyProbe* probe)
+    : VirtualNode(name, config, stats, probe, false),
+      _shuntPort(2), _mppt1Port(1), _mppt2Port(1),
+      _shunt(&_shuntPort), _mppt1(&_mppt1Port), _mppt2(&_mppt2Port) {}
+
+void SolarNode::onTick(unsigned long now) {
+    // The UARTs keep running whatever the network does
+    if (_lastFrame != 0 && (now - _lastFrame) < VEDIRECT_FRAME_INTERVAL_MS) {
+        return;
+    }
+    _lastFrame = now;
+
+    int batteryMv = 12800 + (int)random(600);
+    int currentMa = (int)random(-8000, 12000);
+    _soc = constrain(_soc + currentMa / 3600000.0f, 0.0f, 100.0f);
+    _yieldToday += 0.0001f;
+
+    std::string shunt = buildBlock({
+        {"PID", "0xA389"}, {"V", std::to_string(batteryMv)}, {"I", std::to_string(currentMa)},
+        {"P", std::to_string(batteryMv / 1000 * currentMa / 1000)}, {"CE", "-12500"},
+        {"SOC", std::to_string((int)(_soc * 10))}, {"TTG", "5460"}, {"Alarm", "OFF"}, {"Relay", "OFF"},
+        {"AR", "0"}, {"BMV", "SmartShunt 500A/50mV"}, {"FW", "0413"}, {"MON", "0"}
+    }) + buildBlock({
+        {"H1", "-61234"}, {"H2", "-12500"}, {"H4", "142"}, {"H7", "11020"}, {"H8", "14650"}
+    });
+    _shuntPort.feed(shunt.c_str());
+
+    HardwareSerial* ports[] = {&_mppt1Port, &_mppt2Port};
+    for (HardwareSerial* port : ports) {
+        int ppv = (int)random(0, 400);
+        std::string mppt = buildBlock({
+            {"PID", "0xA060"}, {"FW", "159"}, {"SER#", "HQ2222ABCDE"}, {"V", std::to_string(batteryMv)},
+            {"I", std::to_string(ppv * 1000 / 13)}, {"VPV", std::to_string(30000 + (int)random(8000))},
+            {"PPV", std::to_string(ppv)}, {"CS", ppv > 0 ? "3" : "0"}, {"MPPT", "2"},
+            {"OR", "0x00000000"}, {"ERR", "0"}, {"LOAD", "ON"}, {"IL", "300"},
+            {"H19", "10234"}, {"H20", std::to_string((int)(_yieldToday * 100))}, {"H21", "412"},
+            {"H22", "98"}, {"H23", "388"}, {"HSDS", "214"}
+        });
+        port->feed(mppt.c_str());
+    }
+
+    _shunt.update();
+    _mppt1.update();
+    _mppt2.update();
+}
+
+void SolarNode::appendMppt(String& data, VictronMPPT& mppt, int index) {
+    if (!mppt.isDataValid()) {
+        return;
+    }
+    String tags = "solar,device=" + _name + ",location=garage,mppt=" + String(index);
+    if (mppt.getProductID().length() > 0) {
+        tags += ",product_id=" + mppt.getProductID();
+    }
+    if (mppt.getSerialNumber().length() > 0) {
+        tags += ",serial=" + mppt.getSerialNumber();
+    }
+    data += tags + " ";
+    data += "pv_voltage=" + String(mppt.getPanelVoltage(), 3) + ",";
+    data += "pv_power=" + String(mppt.getPanelPower(), 1) + ",";
+    data += "battery_voltage=" + String(mppt.getBatteryVoltage(), 3) + ",";
+    data += "charge_current=" + String(mppt.getChargeCurrent(), 3) + ",";
+    data += "charge_state=\"" + mppt.getChargeState() + "\",";
+    data += "error_code=" + String(mppt.getErrorCode()) + ",";
+    data += "load_state=\"" + mppt.getLoadState() + "\",";
+    data += "load_current=" + String(mppt.getLoadCurrent(), 3) + ",";
+    data += "yield_today=" + String(mppt.getYieldToday(), 3) + ",";
+    data += "yield_yesterday=" + String(mppt.getYieldYesterday(), 3) + ",";
+    data += "yield_total=" + String(mppt.getYieldTotal(), 3) + ",";
+    data += "max_power_today=" + String(mppt.getMaxPowerToday()) + ",";
+    data += "max_power_yesterday=" + String(mppt.getMaxPowerYesterday());
+    data += "\n";
+}
+
+// Same body as sendDataToInfluxDB() in solar-monitor
+void SolarNode::publishCycle(unsigned long now) {
+    String data = "";
+    if (_shunt.isDataValid()) {
+        data += "battery,device=" + _name + ",location=garage ";
+        data += "voltage=" + String(_shunt.getBatteryVoltage(), 3) + ",";
+        data += "current=" + String(_shunt.getBatteryCurrent(), 3) + ",";
+        data += "soc=" + String(_shunt.getStateOfCharge(), 1) + ",";
+        data += "time_remaining=" + String(_shunt.getTimeRemaining()) + ",";
+        data += "consumed_ah=" + String(_shunt.getConsumedAh(), 3) + ",";
+        data += "alarm=" + String(_shunt.getAlarmState() ? 1 : 0) + ",";
+        data += "relay=" + String(_shunt.getRelayState() ? 1 : 0) + ",";
+        data += "min_voltage=" + String(_shunt.getMinVoltage(), 3) + ",";
+        data += "max_voltage=" + String(_shunt.getMaxVoltage(), 3) + ",";
+        data += "charge_cycles=" + String(_shunt.getChargeCycles()) + ",";
+        data += "deepest_discharge=" + String(_shunt.getDeepestDischarge(), 3) + ",";
+        data += "last_discharge=" + String(_shunt.getLastDischarge(), 3);
+        data += "\n";
+    }
+    appendMppt(data, _mppt1, 1);
+    appendMppt(data, _mppt2, 2);
+
+    data += "system,device=" + _name + ",location=garage ";
+    data += "uptime=" + String((now - _bootTime) / 1000) + ",";
+    data += "wifi_rssi=" + String(-50 - (int)random(35)) + ",";
+    data += "free_heap=" + String(ESP.getFreeHeap()) + ",";
+    data += "wifi_connected=1,";
+    data += "loop_max_ms=" + String(40 + random(200)) + ",";
+    data += "loop_stalls=0";
+    data += "\n";
+
+    publish(topic("/influx"), data, false);
+}
@@ -0,0 +1,161 @@
+/**
+ * VirtualNode.h
+ *
+ * One simulated sensor node: its own TCP connection and PubSubClient, the
+ * firmware's publish cadence and reconnect rate limit, and optionally the
+ * deep-sleep cycle (wake → boot → associate → connect → publish → sleep).
+ *
+ * Sensor payloads come from the firmware's own builders (temperature_payloads
+ * and bme280_payloads, compiled in through firmware_sources.cpp) filled with
+ * simulated values, so the broker and consumers see the firmware's documents.
+ * firmware_versions.py reads the version numbers from the sensors' platformio.ini.
+ */
+
+#ifndef VIRTUAL_NODE_H
+#define VIRTUAL_NODE_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <PubSubClient.h>
+#include <WiFiClient.h>
+
+#include "FleetStats.h"
+#include "LatencyProbe.h"
+#include "VictronMPPT.h"
+#include "VictronSmartShunt.h"
+
+// Firmware timing (temperature-sensor / bme280-sensor main.cpp and device_config.h)
+static const unsigned long MQTT_RECONNECT_INTERVAL_MS = 5000;
+static const unsigned long WIFI_CHECK_INTERVAL_MS = 15000;
+static const unsigned long SENSOR_INTERVAL_MS = 30000;
+static const unsigned long SOLAR_SEND_INTERVAL_MS = 30000;   // INFLUXDB_SEND_INTERVAL
+static const unsigned long VEDIRECT_FRAME_INTERVAL_MS = 1000;
+
+struct SimConfig {
+    String brokerHost = "127.0.0.1";
+    uint16_t brokerPort = 1883;
+    uint32_t sleepSeconds = 300;       // Deep-sleep period for sleeping nodes
+    uint32_t bootDelayMs = 2000;       // setup() time before WiFi (reset-detect window)
+    uint32_t associationMinMs = 800;   // WiFi association time on wake / after an outage
+    uint32_t associationMaxMs = 3000;
+};
+
+class VirtualNode {
+public:
+    VirtualNode(const String& name, const SimConfig& config, FleetStats& stats, LatencyProbe* probe,
+                bool deepSleep);
+    virtual ~VirtualNode() {}
+
+    // Advance the node's state machine; called round-robin from the fleet loop
+    void service(unsigned long now);
+
+    // AP reboot / roaming: drop the link now, reassociate after outageMs
+    void dropLink(unsigned long now, unsigned long outageMs);
+
+    bool isOnline() const { return _state == State::Online; }
+    bool isSleeping() const { return _state == State::Sleeping; }
+
+protected:
+    virtual void publishCycle(unsigned long now) = 0;
+    virtual const char* topicBase() const { return "esp-sensor-hub"; }
+    virtual unsigned long publishIntervalMs() const { return SENSOR_INTERVAL_MS; }
+    virtual void onTick(unsigned long now) { (void)now; }
+    // Fill doc with the firmware's event document; false = the firmware has no events topic
+    virtual bool buildEvent(JsonDocument& doc, const char* eventType, const String& message,
+                            const char* severity) {
+        (void)doc; (void)eventType; (void)message; (void)severity;
+        return false;
+    }
+
+    bool publish(const String& topic, const String& payload, bool retain);
+    void publishEvent(const char* eventType, const String& message, const char* severity);
+    String topic(const char* suffix) const;
+
+    String _name;
+    String _chipId;
+    unsigned long _bootTime = 0;       // End of the boot delay (setup() reaching WiFi)
+    unsigned long _associatedAt = 0;   // WiFi associated
+    bool _deepSleep;
+    const SimConfig& _config;
+
+private:
+    enum class State { Booting, Associating, Online, Sleeping };
+
+    bool connectMqtt(unsigned long now);
+    void enterDeepSleep(unsigned long now);
+    unsigned long associationDelay() const;
+
+    FleetStats& _stats;
+    LatencyProbe* _probe;
+    WiFiClient _net;
+    PubSubClient _mqtt;
+
+    State _state = State::Booting;
+    unsigned long _stateUntil = 0;
+    unsigned long _lastReconnectAttempt = 0;
+    unsigned long _lastPublish = 0;
+    bool _published = false;
+    bool _reconnectEvent = false;   // Publish wifi_reconnected after an outage
+    uint64_t _lastWireBytes = 0;
+};
+
+// DS18B20 node: temperature + status every cycle (publishTemperature/publishStatus)
+class TemperatureNode : public VirtualNode {
+public:
+    using VirtualNode::VirtualNode;
+
+protected:
+    void publishCycle(unsigned long now) override;
+    bool buildEvent(JsonDocument& doc, const char* eventType, const String& message,
+                    const char* severity) override;
+
+private:
+    float _celsius = 18.0f + random(600) / 100.0f;
+};
+
+// BME280 node: readings + status every cycle (publishReadings/publishStatus)
+class Bme280Node : public VirtualNode {
+public:
+    using VirtualNode::VirtualNode;
+
+protected:
+    void publishCycle(unsigned long now) override;
+    bool buildEvent(JsonDocument& doc, const char* eventType, const String& message,
+                    const char* severity) override;
+
+private:
+    float _temperature = 19.0f + random(400) / 100.0f;
+    float _humidity = 40.0f + random(2000) / 100.0f;
+    float _pressure = 100500.0f + random(2000);
+};
+
+/**
+ * Solar node: VE.Direct frames from two MPPTs and a SmartShunt are parsed by
+ * the real drivers once a second. The firmware posts its line-protocol batch
+ * to InfluxDB over HTTP; here the same body goes to <base>/<device>/influx so
+ * its size and cadence show up in the broker load.
+ */
+class SolarNode : public VirtualNode {
+public:
+    SolarNode(const String& name, const SimConfig& config, FleetStats& stats, LatencyProbe* probe);
+
+protected:
+    void publishCycle(unsigned long now) override;
+    unsigned long publishIntervalMs() const override { return SOLAR_SEND_INTERVAL_MS; }
+    void onTick(unsigned long now) override;
+
+private:
+    void appendMppt(String& data, VictronMPPT& mppt, int index);
+
+    HardwareSerial _shuntPort;
+    HardwareSerial _mppt1Port;
+    HardwareSerial _mppt2Port;
+    VictronSmartShunt _shunt;
+    VictronMPPT _mppt1;
+    VictronMPPT _mppt2;
+    unsigned long _lastFrame = 0;
+    float _soc = 60.0f + random(400) / 10.0f;
+    float _yieldToday = 0.0f;
+};
+
+#endif // VIRTUAL_NODE_H
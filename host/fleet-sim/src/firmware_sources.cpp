@@ -0,0 +1,6 @@
+// Firmware modules compiled into the simulator unchanged (PlatformIO only
+// builds sources under src/, so they are pulled in from their projects here).
+#include "../../../solar-monitor/src/VictronMPPT.cpp"
+#include "../../../solar-monitor/src/VictronSmartShunt.cpp"
+#include "../../../temperature-sensor/src/temperature_payloads.cpp"
+#include "../../../bme280-sensor/src/bme280_payloads.cpp"
@@ -0,0 +1,185 @@
+/**
+ * Fleet simulator
+ *
+ * Runs N virtual temperature, BME280 and solar nodes against a local MQTT
+ * broker, each with its own connection, firmware cadence, reconnect rate
+ * limit and (optionally) deep-sleep cycle. Reports messages/s, bytes/s,
+ * connect latency and publish-to-delivery latency percentiles.
+ *
+ * Usage:
+ *   pio run -e native
+ *   .pio/build/native/program --broker 127.0.0.1:1883 --temperature 300 --bme280 100 --solar 10 \
+ *       --sleep-fraction 0.3 --duration 600 --storm-every 120
+ */
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <memory>
+#include <vector>
+#include <sys/resource.h>
+
+#include "FleetStats.h"
+#include "LatencyProbe.h"
+#include "VirtualNode.h"
+
+struct FleetOptions {
+    uint32_t temperatureNodes = 100;
+    uint32_t bme280Nodes = 20;
+    uint32_t solarNodes = 2;
+    float sleepFraction = 0.3f;         // Share of sensor nodes on a deep-sleep cycle
+    uint32_t durationSeconds = 300;
+    uint32_t reportSeconds = 10;
+    uint32_t stormEverySeconds = 0;     // 0 = no reconnect storms
+    uint32_t stormOutageMs = 5000;      // AP down time during a storm
+    bool probe = true;
+    unsigned long seed = 1;
+};
+
+static void printUsage() {
+    printf("Usage: program [--broker host:port] [--temperature N] [--bme280 N] [--solar N]\n"
+           "               [--sleep-fraction F] [--sleep-seconds S] [--boot-ms MS]\n"
+           "               [--duration S] [--report S] [--storm-every S] [--storm-outage-ms MS]\n"
+           "               [--no-probe] [--seed N]\n");
+}
+
+static bool parseArgs(int argc, char** argv, FleetOptions& options, SimConfig& config) {
+    for (int i = 1; i < argc; i++) {
+        String arg = argv[i];
+        if (arg == "--no-probe") {
+            options.probe = false;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            printUsage();
+            return false;
+        }
+        String value = argv[++i];
+        if (arg == "--broker") {
+            int colon = value.indexOf(':');
+            config.brokerHost = colon >= 0 ? value.substring(0, colon) : value;
+            if (colon >= 0) {
+                config.brokerPort = value.substring(colon + 1).toInt();
+            }
+        } else if (arg == "--temperature") {
+            options.temperatureNodes = value.toInt();
+        } else if (arg == "--bme280") {
+            options.bme280Nodes = value.toInt();
+        } else if (arg == "--solar") {
+            options.solarNodes = value.toInt();
+        } else if (arg == "--sleep-fraction") {
+            options.sleepFraction = value.toFloat();
+        } else if (arg == "--sleep-seconds") {
+            config.sleepSeconds = value.toInt();
+        } else if (arg == "--boot-ms") {
+            config.bootDelayMs = value.toInt();
+        } else if (arg == "--duration") {
+            options.durationSeconds = value.toInt();
+        } else if (arg == "--report") {
+            options.reportSeconds = value.toInt();
+        } else if (arg == "--storm-every") {
+            options.stormEverySeconds = value.toInt();
+        } else if (arg == "--storm-outage-ms") {
+            options.stormOutageMs = value.toInt();
+        } else if (arg == "--seed") {
+            options.seed = value.toInt();
+        } else {
+            printUsage();
+            return false;
+        }
+    }
+    return true;
+}
+
+// Every node holds a socket; the default soft limit (often 1024) is too low for large fleets
+static void raiseFileLimit(size_t needed) {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < needed) {
+        limit.rlim_cur = std::min<rlim_t>(needed, limit.rlim_max);
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+int main(int argc, char** argv) {
+    FleetOptions options;
+    SimConfig config;
+    if (!parseArgs(argc, argv, options, config)) {
+        return 1;
+    }
+    randomSeed(options.seed);
+    WiFi.begin();
+
+    uint32_t total = options.temperatureNodes + options.bme280Nodes + options.solarNodes;
+    raiseFileLimit(total + 64);
+
+    FleetStats stats;
+    LatencyProbe probe(stats);
+    if (options.probe && !probe.begin(config.brokerHost.c_str(), config.brokerPort, "esp-sensor-hub/#")) {
+        return 1;
+    }
+    LatencyProbe* probePtr = options.probe ? &probe : nullptr;
+
+    std::vector<std::unique_ptr<VirtualNode>> nodes;
+    nodes.reserve(total);
+    uint32_t sleepers = 0;
+    for (uint32_t i = 0; i < options.temperatureNodes; i++) {
+        bool deepSleep = random(1000) < (long)(options.sleepFraction * 1000);
+        sleepers += deepSleep;
+        nodes.emplace_back(new TemperatureNode("sim-temp-" + String(i), config, stats, probePtr, deepSleep));
+    }
+    for (uint32_t i = 0; i < options.bme280Nodes; i++) {
+        bool deepSleep = random(1000) < (long)(options.sleepFraction * 1000);
+        sleepers += deepSleep;
+        nodes.emplace_back(new Bme280Node("sim-bme280-" + String(i), config, stats, probePtr, deepSleep));
+    }
+    for (uint32_t i = 0; i < options.solarNodes; i++) {
+        nodes.emplace_back(new SolarNode("sim-solar-" + String(i), config, stats, probePtr));
+    }
+
+    printf("[FLEET] %u nodes (%u temperature, %u bme280, %u solar; %u on %us deep sleep) -> %s:%u\n",
+           total, options.temperatureNodes, options.bme280Nodes, options.solarNodes, sleepers,
+           config.sleepSeconds, config.brokerHost.c_str(), config.brokerPort);
+
+    unsigned long start = millis();
+    unsigned long lastReport = start;
+    unsigned long lastStorm = start;
+    while (millis() - start < options.durationSeconds * 1000UL) {
+        unsigned long now = millis();
+
+        if (options.stormEverySeconds > 0 && now - lastStorm >= options.stormEverySeconds * 1000UL) {
+            lastStorm = now;
+            printf("[FLEET] Reconnect storm: dropping all links for %u ms\n", options.stormOutageMs);
+            for (auto& node : nodes) {
+                node->dropLink(now, options.stormOutageMs);
+            }
+        }
+
+        for (auto& node : nodes) {
+            node->service(millis());
+            if (probePtr) {
+                probe.service();
+            }
+        }
+
+        if (now - lastReport >= options.reportSeconds * 1000UL) {
+            lastReport = now;
+            uint32_t online = 0;
+            uint32_t sleeping = 0;
+            for (auto& node : nodes) {
+                online += node->isOnline();
+                sleeping += node->isSleeping();
+            }
+            stats.setOnline(online, sleeping);
+            stats.reportInterval(now - start);
+        }
+        delay(1);
+    }
+
+    // Let in-flight deliveries arrive before summarizing
+    unsigned long drainStart = millis();
+    while (probePtr && millis() - drainStart < 500) {
+        probe.service();
+        delay(1);
+    }
+    stats.reportSummary(millis() - start);
+    return 0;
+}
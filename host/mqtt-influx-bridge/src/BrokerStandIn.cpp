@@ -0,0 +1,218 @@
+/**
+ * BrokerStandIn.cpp
+ *
+ * Implementation of the benchmark broker stand-in
+ */
+
+#include "BrokerStandIn.h"
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static const size_t CHUNK_BYTES = 64 * 1024;
+static const int ACCEPT_TIMEOUT_MS = 10000;
+
+BrokerStandIn::~BrokerStandIn() {
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+    if (_listenFd >= 0) {
+        close(_listenFd);
+    }
+}
+
+static void appendPublish(std::string& out, const std::string& topic, const std::string& payload) {
+    size_t length = 2 + topic.size() + payload.size();
+    out += (char)0x30;
+    do {
+        uint8_t digit = length & 0x7F;
+        length >>= 7;
+        out += (char)(length > 0 ? digit | 0x80 : digit);
+    } while (length > 0);
+    out += (char)(topic.size() >> 8);
+    out += (char)(topic.size() & 0xFF);
+    out += topic;
+    out += payload;
+}
+
+// Same members and order as the firmware's ArduinoJson documents
+void BrokerStandIn::buildPackets(uint32_t devices) {
+    std::string chunk;
+    uint32_t count = 0;
+    char payload[1024];
+    for (uint32_t i = 0; i < 4096; i++) {
+        uint32_t device = random(devices);
+        char chipId[9];
+        snprintf(chipId, sizeof(chipId), "%08x", device * 2654435761U);
+        uint32_t uptime = 3600 + random(86400);
+        uint32_t kind = random(100);
+        std::string topic;
+        if (kind < 55) {
+            float celsius = 15.0f + random(1500) / 100.0f;
+            topic = "esp-sensor-hub/sim-temp-" + std::to_string(device) + "/temperature";
+            // A few are readings replayed after an outage, with their wall-clock sample time
+            char replay[64] = "";
+            if (kind < 3) {
+                snprintf(replay, sizeof(replay), ",\"replayed\":true,\"sample_time\":%u",
+                         1700000000u + (uint32_t)random(86400));
+            }
+            snprintf(payload, sizeof(payload),
+                     "{\"device\":\"sim-temp-%u\",\"chip_id\":\"%s\",\"schema_version\":1,\"timestamp\":%u,"
+                     "\"celsius\":%.2f,\"fahrenheit\":%.2f%s}",
+                     device, chipId, uptime, celsius, celsius * 9 / 5 + 32, replay);
+        } else if (kind < 70) {
+            float pressure = 100500.0f + random(2000);
+            topic = "esp-sensor-hub/sim-bme280-" + std::to_string(device) + "/readings";
+            snprintf(payload, sizeof(payload),
+                     "{\"device\":\"sim-bme280-%u\",\"chip_id\":\"%s\",\"firmware_version\":\"1.0.12\","
+                     "\"schema_version\":1,\"timestamp\":%u,\"uptime_seconds\":%u,\"temperature_c\":%.2f,"
+                     "\"humidity_rh\":%.2f,\"pressure_pa\":%.1f,\"pressure_hpa\":%.2f,\"altitude_m\":%.1f,"
+                     "\"pressure_change_pa\":%.1f,\"pressure_change_hpa\":%.2f,\"pressure_trend\":\"steady\","
+                     "\"baseline_hpa\":1013.25}",
+                     device, chipId, uptime, uptime, 19.0f + random(400) / 100.0f, 40.0f + random(2000) / 100.0f,
+                     pressure, pressure / 100, 120.0f + random(50), (float)random(-40, 40), random(-40, 40) / 100.0f);
+        } else if (kind < 88) {
+            topic = "esp-sensor-hub/sim-temp-" + std::to_string(device) + "/status";
+            snprintf(payload, sizeof(payload),
+                     "{\"device\":\"sim-temp-%u\",\"chip_id\":\"%s\",\"firmware_version\":\"1.0.12\","
+                     "\"schema_version\":1,\"timestamp\":%u,\"uptime_seconds\":%u,\"wifi_connected\":true,"
+                     "\"wifi_rssi\":%d,\"free_heap\":%u,\"sensor_healthy\":true,\"wifi_reconnects\":%u,"
+                     "\"sensor_read_failures\":0,\"deep_sleep_enabled\":false,\"deep_sleep_seconds\":0,"
+                     "\"sensor_interval_seconds\":30,\"loop_max_ms\":%u,\"loop_stalls\":0,"
+                     "\"reset_reason\":\"power_on\",\"boot_count\":%u,\"reset_nvs_writes\":%u,"
+                     "\"reset_nvs_writes_per_day\":1.5,\"boot_delay_saved_ms\":2000,\"config_commits\":3,"
+                     "\"config_slot_writes\":[2,1],\"config_commits_boot\":0,\"config_coalesced\":0,"
+                     "\"config_commit_failures\":0,\"config_pending\":false}",
+                     device, chipId, uptime, uptime, -50 - (int)random(35), 180000 + (uint32_t)random(20000),
+                     (uint32_t)random(5), 40 + (uint32_t)random(200), 3 + (uint32_t)random(20), 3 + (uint32_t)random(20));
+        } else if (kind < 94) {
+            topic = "esp-sensor-hub/sim-temp-" + std::to_string(device) + "/events";
+            snprintf(payload, sizeof(payload),
+                     "{\"device\":\"sim-temp-%u\",\"chip_id\":\"%s\",\"firmware_version\":\"1.0.12\","
+                     "\"schema_version\":1,\"event\":\"wifi_reconnected\",\"severity\":\"info\",\"timestamp\":%u,"
+                     "\"uptime_seconds\":%u,\"free_heap\":%u,"
+                     "\"message\":\"WiFi reconnected - SSID: sim, IP: 10.0.0.%u\"}",
+                     device, chipId, uptime, uptime, 180000 + (uint32_t)random(20000), device % 250);
+        } else if (kind < 99) {
+            topic = "surveillance/sim-cam-" + std::to_string(device) + "/metrics";
+            snprintf(payload, sizeof(payload),
+                     "{\"device\":\"sim-cam-%u\",\"chip_id\":\"%s\",\"trace_id\":\"%08x%08x\","
+                     "\"traceparent\":\"00-%08x%08x0000000000000000-0000000000000001-01\",\"seq_num\":%u,"
+                     "\"schema_version\":1,\"location\":\"surveillance\",\"timestamp\":%u,\"uptime\":%u,"
+                     "\"wifi_rssi\":%d,\"free_heap\":%u,\"free_psram\":%u,\"camera_ready\":1,\"mqtt_connected\":1,"
+                     "\"capture_count\":%u,\"camera_errors\":0,\"mqtt_publishes\":%u,\"loop_iterations\":%u,"
+                     "\"loop_max_ms\":%u,\"loop_stalls\":0,\"loop_last_stall_region\":\"\",\"loop_last_stall_ms\":0,"
+                     "\"loop_histogram\":[120,4000,800,90,12,3,1,0,0,0,0,0]}",
+                     device, chipId, (uint32_t)random(0x7FFFFFFF), i, (uint32_t)random(0x7FFFFFFF), i, i, uptime, uptime,
+                     -50 - (int)random(35), 150000 + (uint32_t)random(20000), 4000000 + (uint32_t)random(100000),
+                     (uint32_t)random(500), (uint32_t)random(10000), (uint32_t)random(1000000), 40 + (uint32_t)random(200));
+        } else {
+            topic = "esp-sensor-hub/sim-solar-" + std::to_string(device) + "/influx";
+            snprintf(payload, sizeof(payload),
+                     "battery,device=sim-solar-%u,location=garage voltage=13.120,current=-2.310,soc=87.5\n"
+                     "solar,device=sim-solar-%u,location=garage,mppt=1 pv_voltage=35.120,pv_power=212.0\n",
+                     device, device);
+        }
+        appendPublish(chunk, topic, payload);
+        count++;
+        if (chunk.size() >= CHUNK_BYTES) {
+            _chunks.push_back(chunk);
+            _chunkCounts.push_back(count);
+            chunk.clear();
+            count = 0;
+        }
+    }
+    if (count > 0) {
+        _chunks.push_back(chunk);
+        _chunkCounts.push_back(count);
+    }
+}
+
+bool BrokerStandIn::begin(uint64_t messages, uint32_t devices) {
+    _messages = messages;
+    buildPackets(max(devices, (uint32_t)1));
+
+    _listenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    int reuse = 1;
+    setsockopt(_listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    socklen_t length = sizeof(addr);
+    if (_listenFd < 0 || bind(_listenFd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(_listenFd, 1) != 0
+        || getsockname(_listenFd, (struct sockaddr*)&addr, &length) != 0) {
+        return false;
+    }
+    _port = ntohs(addr.sin_port);
+    _thread = std::thread(&BrokerStandIn::run, this);
+    return true;
+}
+
+// Reads one control packet; returns its first byte and body
+static bool readControl(int fd, uint8_t& first, std::string& body) {
+    uint8_t byte;
+    if (recv(fd, &first, 1, MSG_WAITALL) != 1) {
+        return false;
+    }
+    size_t length = 0;
+    for (int shift = 0; shift < 28; shift += 7) {
+        if (recv(fd, &byte, 1, MSG_WAITALL) != 1) {
+            return false;
+        }
+        length |= (size_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            break;
+        }
+    }
+    body.resize(length);
+    return length == 0 || recv(fd, &body[0], length, MSG_WAITALL) == (ssize_t)length;
+}
+
+void BrokerStandIn::run() {
+    struct pollfd pfd = {_listenFd, POLLIN, 0};
+    int fd = ::poll(&pfd, 1, ACCEPT_TIMEOUT_MS) == 1 ? accept(_listenFd, nullptr, nullptr) : -1;
+    if (fd < 0) {
+        _done = true;
+        return;
+    }
+    int sendBuffer = 1024 * 1024;
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sendBuffer, sizeof(sendBuffer));
+
+    uint8_t first;
+    std::string body;
+    bool subscribed = false;
+    while (!subscribed && readControl(fd, first, body)) {
+        if ((first >> 4) == 1) {
+            static const uint8_t CONNACK[] = {0x20, 0x02, 0x00, 0x00};
+            send(fd, CONNACK, sizeof(CONNACK), MSG_NOSIGNAL);
+        } else if ((first >> 4) == 8 && body.size() >= 2) {
+            // SUBACK: QoS 0 granted for every filter
+            std::string suback = {(char)0x90, 0, body[0], body[1]};
+            for (size_t pos = 2; pos + 2 <= body.size();) {
+                size_t filterLength = ((uint8_t)body[pos] << 8) | (uint8_t)body[pos + 1];
+                pos += 2 + filterLength + 1;
+                suback += (char)0;
+            }
+            suback[1] = (char)(suback.size() - 2);
+            send(fd, suback.data(), suback.size(), MSG_NOSIGNAL);
+            subscribed = true;
+        }
+    }
+
+    for (size_t i = 0; subscribed && _sent.load() < _messages; i = (i + 1) % _chunks.size()) {
+        if (send(fd, _chunks[i].data(), _chunks[i].size(), MSG_NOSIGNAL) != (ssize_t)_chunks[i].size()) {
+            break;
+        }
+        _sent += _chunkCounts[i];
+    }
+    _done = true;
+    // Everything sent arrives before the close
+    shutdown(fd, SHUT_WR);
+    char drain[256];
+    while (recv(fd, drain, sizeof(drain), 0) > 0) {
+    }
+    close(fd);
+}
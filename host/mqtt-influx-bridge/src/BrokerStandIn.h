@@ -0,0 +1,52 @@
+/**
+ * BrokerStandIn.h
+ *
+ * Local broker stand-in for benchmarks: accepts one MQTT client, answers
+ * CONNECT/SUBSCRIBE/PINGREQ, then streams PUBLISH packets as fast as TCP
+ * takes them from its own thread. Payloads follow the firmware publishers
+ * (temperature-sensor, bme280-sensor, surveillance) field for field, from a
+ * simulated fleet of devices, plus the solar nodes' line-protocol /influx
+ * batches. A real broker adds its own routing cost; this measures the bridge.
+ */
+
+#ifndef BROKER_STAND_IN_H
+#define BROKER_STAND_IN_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+class BrokerStandIn {
+public:
+    BrokerStandIn() {}
+    ~BrokerStandIn();
+
+    /**
+     * @brief Listen on 127.0.0.1 (ephemeral port) and start streaming once a
+     * client subscribes
+     * @param messages Total PUBLISH packets to send
+     * @param devices Simulated devices the payloads are spread over
+     */
+    bool begin(uint64_t messages, uint32_t devices);
+
+    uint16_t getPort() const { return _port; }
+    uint64_t getSent() const { return _sent.load(); }
+    bool isDone() const { return _done.load(); }
+
+private:
+    void run();
+    void buildPackets(uint32_t devices);
+
+    int _listenFd = -1;
+    uint16_t _port = 0;
+    uint64_t _messages = 0;
+    std::vector<std::string> _chunks;   // Pre-encoded PUBLISH packets, ~64 KB per chunk
+    std::vector<uint32_t> _chunkCounts;
+    std::thread _thread;
+    std::atomic<uint64_t> _sent{0};
+    std::atomic<bool> _done{false};
+};
+
+#endif // BROKER_STAND_IN_H
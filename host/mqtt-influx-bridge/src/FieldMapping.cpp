@@ -0,0 +1,461 @@
+/**
+ * FieldMapping.cpp
+ *
+ * Implementation of the declarative JSON → line-protocol mapping
+ */
+
+#include "FieldMapping.h"
+
+#include <memory>
+
+// ============================================================================
+// Line protocol escaping
+// ============================================================================
+
+static const char* const KEY_SPECIALS = ", =";
+static const char* const MEASUREMENT_SPECIALS = ", ";
+static const char* const STRING_SPECIALS = "\"\\";
+
+// Names and tag values end at a line break, so one is spelled out as \n (\r,
+// \t, \f likewise); string fields are quoted and keep theirs. NULs are dropped.
+static void appendEscaped(String& out, const char* text, size_t length, const char* specials) {
+    bool quoted = specials == STRING_SPECIALS;
+    const char* runStart = text;
+    for (size_t i = 0; i < length; i++) {
+        char c = text[i];
+        const char* spelled = quoted ? nullptr
+            : c == '\n' ? "\\n" : c == '\r' ? "\\r" : c == '\t' ? "\\t" : c == '\f' ? "\\f" : nullptr;
+        if (spelled || c == '\0') {
+            out.concat(runStart, (unsigned int)(text + i - runStart));
+            if (spelled) {
+                out += spelled;
+            }
+            runStart = text + i + 1;
+        } else if (strchr(specials, c)) {
+            out.concat(runStart, (unsigned int)(text + i - runStart));
+            out += '\\';
+            runStart = text + i;
+        }
+    }
+    out.concat(runStart, (unsigned int)(text + length - runStart));
+}
+
+// A JSON string span's text, escaped for line protocol. Spans without a
+// backslash (nearly all) are escaped in place.
+static void appendDecoded(String& out, const char* span, size_t length, const char* specials) {
+    if (!memchr(span, '\\', length)) {
+        appendEscaped(out, span, length, specials);
+        return;
+    }
+    char stackBuffer[256];
+    std::unique_ptr<char[]> heapBuffer;
+    char* buffer = stackBuffer;
+    if (length > sizeof(stackBuffer)) {
+        heapBuffer.reset(new char[length]);  // Decoding never grows the text
+        buffer = heapBuffer.get();
+    }
+    appendEscaped(out, buffer, JsonScan::decode(span, (uint32_t)length, buffer), specials);
+}
+
+static String escaped(const String& text, const char* specials) {
+    String out;
+    appendEscaped(out, text.c_str(), text.length(), specials);
+    return out;
+}
+
+// ============================================================================
+// Mapping file
+// ============================================================================
+
+static std::vector<String> split(const String& text, char separator) {
+    std::vector<String> parts;
+    int start = 0;
+    while (start <= (int)text.length()) {
+        int end = text.indexOf(separator, start);
+        if (end < 0) {
+            end = text.length();
+        }
+        if (end > start) {
+            parts.push_back(text.substring(start, end));
+        }
+        start = end + 1;
+    }
+    return parts;
+}
+
+static std::vector<String> tokens(const String& line) {
+    String normalized = line;
+    normalized.replace('\t', ' ');
+    return split(normalized, ' ');
+}
+
+bool FieldMapping::load(const char* path, String& error) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        error = String("cannot open ") + path;
+        return false;
+    }
+    String text;
+    char buffer[4096];
+    size_t length;
+    while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        text.concat(buffer, (unsigned int)length);
+    }
+    fclose(file);
+    return parse(text, error);
+}
+
+bool FieldMapping::parse(const String& text, String& error) {
+    std::vector<Rule> rules;
+    int lineNumber = 0;
+    int start = 0;
+    while (start < (int)text.length()) {
+        int end = text.indexOf('\n', start);
+        if (end < 0) {
+            end = text.length();
+        }
+        String line = text.substring(start, end);
+        start = end + 1;
+        lineNumber++;
+
+        // Whole-line comments only: '#' is also the multi-level wildcard
+        line.trim();
+        if (line.length() == 0 || line.startsWith("#")) {
+            continue;
+        }
+        Rule rule;
+        String message;
+        if (!parseRule(line, rule, message)) {
+            error = String(lineNumber) + ": " + message;
+            return false;
+        }
+        rules.push_back(rule);
+    }
+    if (rules.empty()) {
+        error = "no rules";
+        return false;
+    }
+    _rules = rules;
+    return true;
+}
+
+bool FieldMapping::parseRule(const String& line, Rule& rule, String& error) {
+    std::vector<String> words = tokens(line);
+    if (words.size() < 2) {
+        error = "expected '<topic filter> <measurement> ...' or '<topic filter> passthrough'";
+        return false;
+    }
+    rule.filter = words[0];
+    rule.levels = split(rule.filter + "/", '/');
+    for (size_t i = 0; i < rule.levels.size(); i++) {
+        if (rule.levels[i] == "#" && i + 1 != rule.levels.size()) {
+            error = "'#' must be the last topic level";
+            return false;
+        }
+    }
+    if (words[1] == "passthrough") {
+        rule.passthrough = true;
+        if (words.size() > 2) {
+            error = "passthrough takes no options";
+            return false;
+        }
+        return true;
+    }
+    rule.measurement = escaped(words[1], MEASUREMENT_SPECIALS);
+
+    String fieldSpec;
+    for (size_t i = 2; i < words.size(); i++) {
+        const String& word = words[i];
+        if (word.startsWith("tags=")) {
+            if (!parseColumns(word.substring(5), rule, false, error)) {
+                return false;
+            }
+        } else if (word.startsWith("fields=")) {
+            fieldSpec = word.substring(7);
+        } else if (word.startsWith("int=")) {
+            rule.integers = split(word.substring(4), ',');
+        } else if (word.startsWith("schema=")) {
+            rule.schema = word.substring(7).toInt();
+        } else if (word.startsWith("time=")) {
+            rule.timeKey = word.substring(5);
+        } else {
+            error = "unknown option '" + word + "'";
+            return false;
+        }
+    }
+    // After int= so explicit fields know their type
+    if (fieldSpec.length() == 0) {
+        fieldSpec = "*";
+    }
+    return parseColumns(fieldSpec, rule, true, error);
+}
+
+bool FieldMapping::parseColumns(const String& spec, Rule& rule, bool fields, String& error) {
+    for (const String& item : split(spec, ',')) {
+        if (fields && item == "*") {
+            rule.allFields = true;
+            continue;
+        }
+        if (fields && item.startsWith("-")) {
+            rule.excluded.push_back(item.substring(1));
+            continue;
+        }
+        Column column;
+        int equals = item.indexOf('=');
+        String name = equals >= 0 ? item.substring(0, equals) : item;
+        String source = equals >= 0 ? item.substring(equals + 1) : item;
+        if (name.length() == 0 || source.length() == 0) {
+            error = "empty name in '" + item + "'";
+            return false;
+        }
+        if (source.startsWith("@")) {
+            column.topicLevel = (int8_t)source.substring(1).toInt();
+        } else {
+            column.key = source;
+        }
+        for (const String& integer : rule.integers) {
+            column.integer = column.integer || integer == name;
+        }
+        column.name = escaped(name, KEY_SPECIALS);
+        (fields ? rule.fields : rule.tags).push_back(column);
+    }
+    return true;
+}
+
+bool FieldMapping::topicMatches(const Rule& rule, const char* topic, size_t topicLength) {
+    const char* pos = topic;
+    const char* end = topic + topicLength;
+    for (size_t i = 0; i < rule.levels.size(); i++) {
+        const String& level = rule.levels[i];
+        if (level == "#") {
+            return true;
+        }
+        if (pos > end) {
+            return false;
+        }
+        const char* slash = (const char*)memchr(pos, '/', end - pos);
+        const char* levelEnd = slash ? slash : end;
+        if (level != "+" && (level.length() != (size_t)(levelEnd - pos) || memcmp(level.c_str(), pos, levelEnd - pos) != 0)) {
+            return false;
+        }
+        pos = levelEnd + 1;
+    }
+    return pos > end;
+}
+
+// ============================================================================
+// Mapping a message
+// ============================================================================
+
+static const unsigned long long MIN_SAMPLE_TIME = 1600000000;  // Sep 2020: older values are unset clocks
+
+static bool topicLevel(const char* topic, size_t topicLength, int8_t level, const char*& start, size_t& length) {
+    const char* pos = topic;
+    const char* end = topic + topicLength;
+    for (int8_t i = 0; pos <= end; i++) {
+        const char* slash = (const char*)memchr(pos, '/', end - pos);
+        const char* levelEnd = slash ? slash : end;
+        if (i == level) {
+            start = pos;
+            length = levelEnd - pos;
+            return length > 0;
+        }
+        pos = levelEnd + 1;
+    }
+    return false;
+}
+
+static const JsonScan::Member* findMember(const JsonScan::Member* members, uint8_t count, const String& key) {
+    for (uint8_t i = 0; i < count; i++) {
+        if (members[i].keyIs(key.c_str(), key.length())) {
+            return &members[i];
+        }
+    }
+    return nullptr;
+}
+
+static bool isScalar(const JsonScan::Member& member) {
+    return member.type == JsonScan::Type::String || member.type == JsonScan::Type::Number
+        || member.type == JsonScan::Type::Bool;
+}
+
+static void appendFieldValue(String& out, const JsonScan::Member& member, bool integer) {
+    switch (member.type) {
+        case JsonScan::Type::String:
+            out += '"';
+            appendDecoded(out, member.value, member.valueLength, STRING_SPECIALS);
+            out += '"';
+            break;
+        case JsonScan::Type::Number:
+            if (integer) {
+                // Integer part only: a float where an integer field is declared would conflict
+                uint32_t length = 0;
+                while (length < member.valueLength && member.value[length] != '.' && member.value[length] != 'e'
+                       && member.value[length] != 'E') {
+                    length++;
+                }
+                out.concat(member.value, length);
+                out += 'i';
+            } else {
+                out.concat(member.value, member.valueLength);
+            }
+            break;
+        default:
+            out.concat(member.value, member.valueLength);
+            break;
+    }
+}
+
+FieldMapping::Result FieldMapping::apply(const char* topic, size_t topicLength, const char* payload,
+                                         size_t payloadLength, uint64_t timestampMs, String& out) {
+    Rule* rule = nullptr;
+    for (Rule& candidate : _rules) {
+        if (topicMatches(candidate, topic, topicLength)) {
+            rule = &candidate;
+            break;
+        }
+    }
+    if (!rule) {
+        return Result::Unmatched;
+    }
+    rule->matched++;
+
+    if (rule->passthrough) {
+        out.concat(payload, (unsigned int)payloadLength);
+        if (payloadLength > 0 && payload[payloadLength - 1] != '\n') {
+            out += '\n';
+        }
+        return Result::Mapped;
+    }
+
+    JsonScan::Member members[MAX_MEMBERS];
+    uint8_t count = 0;
+    JsonScan scan(payload, payloadLength);
+    JsonScan::Member member;
+    while (scan.next(member)) {
+        if (count < MAX_MEMBERS) {
+            members[count++] = member;
+        }
+    }
+    if (scan.failed()) {
+        return Result::BadPayload;
+    }
+
+    if (rule->schema > 0) {
+        const JsonScan::Member* schema = findMember(members, count, "schema_version");
+        // Spans end at ',' or '}', so strtol stops inside the payload
+        if (!schema || schema->type != JsonScan::Type::Number || strtol(schema->value, nullptr, 10) != rule->schema) {
+            return Result::SchemaMismatch;
+        }
+    }
+
+    if (rule->timeKey.length() > 0) {
+        const JsonScan::Member* sampleTime = findMember(members, count, rule->timeKey);
+        // Before the device clock is set there is no sample time (0 or missing): keep the receive time
+        unsigned long long seconds = sampleTime && sampleTime->type == JsonScan::Type::Number
+            ? strtoull(sampleTime->value, nullptr, 10) : 0;
+        if (seconds > MIN_SAMPLE_TIME) {
+            timestampMs = seconds * 1000;
+        }
+    }
+
+    unsigned int lineStart = out.length();
+    out += rule->measurement;
+    for (const Column& tag : rule->tags) {
+        const char* value = nullptr;
+        size_t length = 0;
+        bool json = tag.topicLevel < 0;
+        if (!json) {
+            topicLevel(topic, topicLength, tag.topicLevel, value, length);
+        } else {
+            const JsonScan::Member* source = findMember(members, count, tag.key);
+            if (source && isScalar(*source)) {
+                value = source->value;
+                length = source->valueLength;
+            }
+        }
+        if (length == 0) {
+            continue;  // Line protocol has no empty tag values
+        }
+        out += ',';
+        out += tag.name;
+        out += '=';
+        if (json) {
+            appendDecoded(out, value, length, KEY_SPECIALS);
+        } else {
+            appendEscaped(out, value, length, KEY_SPECIALS);
+        }
+    }
+
+    bool first = true;
+    auto appendField = [&](const String& name, const char* rawName, size_t rawLength,
+                           const JsonScan::Member& value, bool integer) {
+        out += first ? ' ' : ',';
+        first = false;
+        if (rawName) {
+            appendDecoded(out, rawName, rawLength, KEY_SPECIALS);
+        } else {
+            out += name;
+        }
+        out += '=';
+        appendFieldValue(out, value, integer);
+    };
+
+    for (const Column& field : rule->fields) {
+        if (field.topicLevel >= 0) {
+            const char* value;
+            size_t length;
+            if (topicLevel(topic, topicLength, field.topicLevel, value, length)) {
+                // Topic text, not JSON: escaped as it is
+                out += first ? ' ' : ',';
+                first = false;
+                out += field.name;
+                out += "=\"";
+                appendEscaped(out, value, length, STRING_SPECIALS);
+                out += '"';
+            }
+            continue;
+        }
+        const JsonScan::Member* source = findMember(members, count, field.key);
+        if (source && isScalar(*source)) {
+            appendField(field.name, nullptr, 0, *source, field.integer);
+        }
+    }
+
+    if (rule->allFields) {
+        for (uint8_t i = 0; i < count; i++) {
+            const JsonScan::Member& candidate = members[i];
+            if (!isScalar(candidate)) {
+                continue;
+            }
+            bool used = false;
+            for (const Column& tag : rule->tags) {
+                used = used || (tag.topicLevel < 0 && candidate.keyIs(tag.key.c_str(), tag.key.length()));
+            }
+            for (const Column& field : rule->fields) {
+                used = used || (field.topicLevel < 0 && candidate.keyIs(field.key.c_str(), field.key.length()));
+            }
+            for (const String& excluded : rule->excluded) {
+                used = used || candidate.keyIs(excluded.c_str(), excluded.length());
+            }
+            used = used || (rule->timeKey.length() > 0 && candidate.keyIs(rule->timeKey.c_str(), rule->timeKey.length()));
+            if (used) {
+                continue;
+            }
+            bool integer = false;
+            for (const String& name : rule->integers) {
+                integer = integer || candidate.keyIs(name.c_str(), name.length());
+            }
+            appendField(String(), candidate.key, candidate.keyLength, candidate, integer);
+        }
+    }
+
+    if (first) {
+        out.remove(lineStart);
+        return Result::NoFields;
+    }
+    out += ' ';
+    out += String((unsigned long long)timestampMs);
+    out += '\n';
+    return Result::Mapped;
+}
@@ -0,0 +1,100 @@
+/**
+ * FieldMapping.h
+ *
+ * Declarative topic → line-protocol mapping. One rule per line of the
+ * mapping file (first matching rule wins):
+ *
+ *   <topic filter> <measurement> [tags=...] [fields=...] [int=...] [schema=N] [time=key]
+ *   <topic filter> passthrough
+ *
+ * - Topic filters use MQTT wildcards (+, #); every rule's filter is also a
+ *   subscription.
+ * - tags/fields are comma lists of `name` (JSON key of the same name),
+ *   `name=key` (renamed) or `name=@N` (topic level N, 0-based). In fields,
+ *   `*` adds every remaining scalar member and `-key` leaves one out of `*`.
+ *   Missing or null members are skipped; tags from strings, numbers or bools.
+ * - JSON strings are decoded before they are escaped for line protocol. A
+ *   line break in a tag or key is written as \n (\r, \t, \f likewise); in a
+ *   string field it stays as it is, inside the quotes.
+ * - Numbers are written as floats (the firmware mixes 1 and 1.5 for the same
+ *   key), unless their field is listed in int=.
+ * - schema=N drops payloads whose schema_version is not N (counted).
+ * - time=key names a member with the sample's Unix time in seconds (readings
+ *   replayed after an outage). When present and set, it is the line's
+ *   timestamp and is not written as a field.
+ * - passthrough forwards payloads that already are line protocol (the solar
+ *   nodes' /influx topic).
+ *
+ * Payload timestamps are device uptimes, so lines carry the receive time
+ * unless the rule has time= and the payload carries that member.
+ */
+
+#ifndef FIELD_MAPPING_H
+#define FIELD_MAPPING_H
+
+#include <Arduino.h>
+#include <vector>
+
+#include "JsonScan.h"
+
+class FieldMapping {
+public:
+    static const uint8_t MAX_MEMBERS = 64;     // Members per payload considered (the rest are ignored)
+
+    enum class Result : uint8_t {
+        Mapped,
+        Unmatched,          // No rule for the topic
+        BadPayload,         // Not a JSON object
+        SchemaMismatch,
+        NoFields            // Nothing to write (line protocol needs a field)
+    };
+
+    struct Column {
+        String name;                // Escaped for line protocol
+        String key;                 // JSON key (empty for a topic level)
+        int8_t topicLevel = -1;
+        bool integer = false;
+    };
+
+    struct Rule {
+        String filter;
+        std::vector<String> levels;
+        bool passthrough = false;
+        String measurement;         // Escaped
+        std::vector<Column> tags;
+        std::vector<Column> fields;
+        bool allFields = false;
+        std::vector<String> excluded;
+        std::vector<String> integers;
+        int schema = 0;             // 0 = any
+        String timeKey;             // Member with the sample's Unix time (s), empty = receive time
+        uint64_t matched = 0;
+    };
+
+    /**
+     * @brief Load rules from a mapping file, replacing any loaded before
+     * @param error Receives "<line>: <message>" on failure
+     */
+    bool load(const char* path, String& error);
+    bool parse(const String& text, String& error);
+
+    /**
+     * @brief Map one message and append its line to out
+     * @param timestampMs Receive time, Unix ms (written with precision=ms); the
+     *        rule's time= member overrides it
+     */
+    Result apply(const char* topic, size_t topicLength, const char* payload, size_t payloadLength,
+                 uint64_t timestampMs, String& out);
+
+    const std::vector<Rule>& getRules() const { return _rules; }
+
+    static bool topicMatches(const Rule& rule, const char* topic, size_t topicLength);
+
+private:
+    bool parseRule(const String& line, Rule& rule, String& error);
+    bool parseColumns(const String& spec, Rule& rule, bool fields, String& error);
+
+    std::vector<Rule> _rules;
+};
+
+#endif // FIELD_MAPPING_H
@@ -0,0 +1,246 @@
+/**
+ * JsonScan.cpp
+ *
+ * Implementation of the zero-copy top-level JSON member scanner
+ */
+
+#include "JsonScan.h"
+
+static const uint8_t MAX_NESTING = 16;
+
+JsonScan::JsonScan(const char* data, size_t length)
+    : _pos(data), _end(data + length) {}
+
+void JsonScan::skipSpace() {
+    while (_pos < _end && (*_pos == ' ' || *_pos == '\t' || *_pos == '\n' || *_pos == '\r')) {
+        _pos++;
+    }
+}
+
+// At the opening quote; leaves _pos after the closing quote
+bool JsonScan::scanString(const char*& start, uint32_t& length) {
+    if (_pos >= _end || *_pos != '"') {
+        return fail();
+    }
+    start = ++_pos;
+    while (_pos < _end) {
+        char c = *_pos;
+        if (c == '\\') {
+            _pos += 2;
+            continue;
+        }
+        if (c == '"') {
+            length = (uint32_t)(_pos - start);
+            _pos++;
+            return true;
+        }
+        if ((uint8_t)c < 0x20) {
+            return fail();
+        }
+        _pos++;
+    }
+    return fail();
+}
+
+// At '{' or '['; leaves _pos after the matching bracket
+bool JsonScan::skipNested() {
+    char stack[MAX_NESTING];
+    uint8_t depth = 0;
+    while (_pos < _end) {
+        char c = *_pos;
+        if (c == '"') {
+            const char* start;
+            uint32_t length;
+            if (!scanString(start, length)) {
+                return false;
+            }
+            continue;
+        }
+        if (c == '{' || c == '[') {
+            if (depth == MAX_NESTING) {
+                return fail();
+            }
+            stack[depth++] = c == '{' ? '}' : ']';
+        } else if (c == '}' || c == ']') {
+            if (depth == 0 || stack[depth - 1] != c) {
+                return fail();
+            }
+            if (--depth == 0) {
+                _pos++;
+                return true;
+            }
+        }
+        _pos++;
+    }
+    return fail();
+}
+
+bool JsonScan::scanLiteral(const char* word, size_t length) {
+    if ((size_t)(_end - _pos) < length || memcmp(_pos, word, length) != 0) {
+        return fail();
+    }
+    _pos += length;
+    return true;
+}
+
+// Four hex digits at text (bounds checked by the caller); -1 if any is not hex
+static int32_t hex4(const char* text) {
+    int32_t value = 0;
+    for (uint8_t i = 0; i < 4; i++) {
+        char c = text[i];
+        int32_t digit = c >= '0' && c <= '9' ? c - '0'
+            : c >= 'a' && c <= 'f' ? c - 'a' + 10
+            : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+        if (digit < 0) {
+            return -1;
+        }
+        value = value * 16 + digit;
+    }
+    return value;
+}
+
+static char* appendUtf8(char* out, uint32_t codePoint) {
+    if (codePoint < 0x80) {
+        *out++ = (char)codePoint;
+    } else if (codePoint < 0x800) {
+        *out++ = (char)(0xC0 | (codePoint >> 6));
+        *out++ = (char)(0x80 | (codePoint & 0x3F));
+    } else if (codePoint < 0x10000) {
+        *out++ = (char)(0xE0 | (codePoint >> 12));
+        *out++ = (char)(0x80 | ((codePoint >> 6) & 0x3F));
+        *out++ = (char)(0x80 | (codePoint & 0x3F));
+    } else {
+        *out++ = (char)(0xF0 | (codePoint >> 18));
+        *out++ = (char)(0x80 | ((codePoint >> 12) & 0x3F));
+        *out++ = (char)(0x80 | ((codePoint >> 6) & 0x3F));
+        *out++ = (char)(0x80 | (codePoint & 0x3F));
+    }
+    return out;
+}
+
+uint32_t JsonScan::decode(const char* span, uint32_t length, char* out) {
+    const char* pos = span;
+    const char* end = span + length;
+    char* start = out;
+    while (pos < end) {
+        if (*pos != '\\' || pos + 1 == end) {
+            *out++ = *pos++;
+            continue;
+        }
+        char c = pos[1];
+        pos += 2;
+        switch (c) {
+            case 'b': *out++ = '\b'; break;
+            case 'f': *out++ = '\f'; break;
+            case 'n': *out++ = '\n'; break;
+            case 'r': *out++ = '\r'; break;
+            case 't': *out++ = '\t'; break;
+            case 'u': {
+                int32_t unit = end - pos >= 4 ? hex4(pos) : -1;
+                if (unit < 0) {
+                    *out++ = 'u';  // Malformed: keep the text rather than drop the member
+                    break;
+                }
+                pos += 4;
+                uint32_t codePoint = (uint32_t)unit;
+                if (unit >= 0xD800 && unit <= 0xDBFF) {
+                    // High surrogate: a \uDC00-\uDFFF low surrogate completes the pair
+                    int32_t low = end - pos >= 6 && pos[0] == '\\' && pos[1] == 'u' ? hex4(pos + 2) : -1;
+                    if (low >= 0xDC00 && low <= 0xDFFF) {
+                        codePoint = 0x10000 + (((uint32_t)unit - 0xD800) << 10) + ((uint32_t)low - 0xDC00);
+                        pos += 6;
+                    } else {
+                        codePoint = 0xFFFD;
+                    }
+                } else if (unit >= 0xDC00 && unit <= 0xDFFF) {
+                    codePoint = 0xFFFD;
+                }
+                out = appendUtf8(out, codePoint);
+                break;
+            }
+            default:
+                *out++ = c;  // \" \\ \/
+                break;
+        }
+    }
+    return (uint32_t)(out - start);
+}
+
+bool JsonScan::next(Member& member) {
+    if (_done || _failed) {
+        return false;
+    }
+    skipSpace();
+    if (!_started) {
+        _started = true;
+        if (_pos >= _end || *_pos != '{') {
+            return fail();
+        }
+        _pos++;
+        skipSpace();
+        if (_pos < _end && *_pos == '}') {
+            _done = true;
+            return false;
+        }
+    } else {
+        if (_pos < _end && *_pos == '}') {
+            _done = true;
+            return false;
+        }
+        if (_pos >= _end || *_pos != ',') {
+            return fail();
+        }
+        _pos++;
+        skipSpace();
+    }
+
+    const char* key;
+    uint32_t keyLength;
+    if (!scanString(key, keyLength) || keyLength > 0xFFFF) {
+        return fail();
+    }
+    skipSpace();
+    if (_pos >= _end || *_pos != ':') {
+        return fail();
+    }
+    _pos++;
+    skipSpace();
+    if (_pos >= _end) {
+        return fail();
+    }
+
+    member.key = key;
+    member.keyLength = (uint16_t)keyLength;
+    member.value = _pos;
+    char c = *_pos;
+    if (c == '"') {
+        member.type = Type::String;
+        return scanString(member.value, member.valueLength);
+    }
+    if (c == '{' || c == '[') {
+        member.type = c == '{' ? Type::Object : Type::Array;
+        if (!skipNested()) {
+            return false;
+        }
+    } else if (c == 't') {
+        member.type = Type::Bool;
+        if (!scanLiteral("true", 4)) return false;
+    } else if (c == 'f') {
+        member.type = Type::Bool;
+        if (!scanLiteral("false", 5)) return false;
+    } else if (c == 'n') {
+        member.type = Type::Null;
+        if (!scanLiteral("null", 4)) return false;
+    } else if (c == '-' || (c >= '0' && c <= '9')) {
+        member.type = Type::Number;
+        _pos++;
+        while (_pos < _end && ((*_pos >= '0' && *_pos <= '9') || *_pos == '.' || *_pos == 'e' || *_pos == 'E'
+                               || *_pos == '+' || *_pos == '-')) {
+            _pos++;
+        }
+    } else {
+        return fail();
+    }
+    member.valueLength = (uint32_t)(_pos - member.value);
+    return true;
+}
@@ -0,0 +1,67 @@
+/**
+ * JsonScan.h
+ *
+ * Zero-copy scanner for the fleet's flat JSON payloads: walks the members of
+ * the top-level object and reports each key and value as a span into the
+ * payload. Nothing is allocated or copied while scanning; nested objects and
+ * arrays are validated and skipped as one opaque value.
+ *
+ * String spans exclude the quotes and keep JSON escapes as written; decode()
+ * turns one into its text when it is written out.
+ */
+
+#ifndef JSON_SCAN_H
+#define JSON_SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+class JsonScan {
+public:
+    enum class Type : uint8_t { String, Number, Bool, Null, Object, Array };
+
+    struct Member {
+        const char* key;
+        uint16_t keyLength;
+        Type type;
+        const char* value;          // String: inside the quotes; Bool: "true"/"false"
+        uint32_t valueLength;
+
+        bool keyIs(const char* name, size_t length) const {
+            return keyLength == length && memcmp(key, name, length) == 0;
+        }
+    };
+
+    JsonScan(const char* data, size_t length);
+
+    /**
+     * @brief Next top-level member
+     * @return false at the end of the object or on a syntax error (see failed())
+     */
+    bool next(Member& member);
+
+    bool failed() const { return _failed; }
+
+    /**
+     * @brief Decode the escapes of a string span (\uXXXX to UTF-8)
+     * @param out At least length bytes: no escape decodes to more than it is written with
+     * @return Decoded length
+     */
+    static uint32_t decode(const char* span, uint32_t length, char* out);
+
+private:
+    bool fail() { _failed = true; return false; }
+    void skipSpace();
+    bool scanString(const char*& start, uint32_t& length);
+    bool skipNested();
+    bool scanLiteral(const char* word, size_t length);
+
+    const char* _pos;
+    const char* _end;
+    bool _started = false;
+    bool _done = false;
+    bool _failed = false;
+};
+
+#endif // JSON_SCAN_H
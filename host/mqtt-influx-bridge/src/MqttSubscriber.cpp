@@ -0,0 +1,274 @@
+/**
+ * MqttSubscriber.cpp
+ *
+ * Implementation of the chunked, zero-copy MQTT subscriber
+ */
+
+#include "MqttSubscriber.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static const uint8_t TYPE_CONNACK = 2;
+static const uint8_t TYPE_PUBLISH = 3;
+static const uint8_t TYPE_SUBACK = 9;
+
+// MQTT remaining length: 1-4 bytes, 7 bits each. 0 = incomplete, -1 = malformed
+static int decodeLength(const uint8_t* data, size_t available, size_t& length) {
+    length = 0;
+    for (int i = 0; i < 4; i++) {
+        if ((size_t)i >= available) {
+            return 0;
+        }
+        length |= (size_t)(data[i] & 0x7F) << (7 * i);
+        if ((data[i] & 0x80) == 0) {
+            return i + 1;
+        }
+    }
+    return -1;
+}
+
+static void encodeLength(std::vector<uint8_t>& out, size_t length) {
+    do {
+        uint8_t digit = length & 0x7F;
+        length >>= 7;
+        out.push_back(length > 0 ? digit | 0x80 : digit);
+    } while (length > 0);
+}
+
+static void appendString(std::vector<uint8_t>& out, const char* text) {
+    size_t length = strlen(text);
+    out.push_back(length >> 8);
+    out.push_back(length & 0xFF);
+    out.insert(out.end(), text, text + length);
+}
+
+MqttSubscriber::MqttSubscriber() : _buffer(BUFFER_SIZE) {}
+
+MqttSubscriber::~MqttSubscriber() {
+    disconnect();
+}
+
+bool MqttSubscriber::sendAll(const uint8_t* data, size_t length) {
+    size_t sent = 0;
+    while (sent < length) {
+        ssize_t n = send(_fd, data + sent, length - sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            sent += n;
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+            struct pollfd pfd = {_fd, POLLOUT, 0};
+            if (::poll(&pfd, 1, (int)CONNECT_TIMEOUT_MS) == 1) {
+                continue;
+            }
+        }
+        return false;
+    }
+    _lastSendMs = millis();
+    return true;
+}
+
+// Blocking read of one whole packet (handshake only; messages go through poll())
+bool MqttSubscriber::readPacket(uint8_t& type, std::vector<uint8_t>& body, unsigned long timeoutMs) {
+    unsigned long start = millis();
+    while (millis() - start < timeoutMs) {
+        size_t length;
+        int header = _end - _start >= 2 ? decodeLength(&_buffer[_start + 1], _end - _start - 1, length) : 0;
+        if (header < 0) {
+            return false;
+        }
+        if (header > 0 && _end - _start >= 1 + header + length) {
+            type = _buffer[_start] >> 4;
+            body.assign(_buffer.begin() + _start + 1 + header, _buffer.begin() + _start + 1 + header + length);
+            _start += 1 + header + length;
+            return true;
+        }
+        struct pollfd pfd = {_fd, POLLIN, 0};
+        if (::poll(&pfd, 1, 100) != 1) {
+            continue;
+        }
+        ssize_t n = recv(_fd, &_buffer[_end], _buffer.size() - _end, 0);
+        if (n <= 0 && !(n < 0 && errno == EAGAIN)) {
+            return false;
+        }
+        if (n > 0) {
+            _end += n;
+            _bytesReceived += n;
+        }
+    }
+    return false;
+}
+
+bool MqttSubscriber::connect(const char* host, uint16_t port, const char* clientId,
+                             const std::vector<String>& filters) {
+    disconnect();
+
+    struct addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* result = nullptr;
+    char portStr[8];
+    snprintf(portStr, sizeof(portStr), "%u", port);
+    if (getaddrinfo(host, portStr, &hints, &result) != 0 || !result) {
+        return false;
+    }
+    _fd = socket(result->ai_family, result->ai_socktype | SOCK_CLOEXEC, result->ai_protocol);
+    if (_fd < 0 || ::connect(_fd, result->ai_addr, result->ai_addrlen) != 0) {
+        freeaddrinfo(result);
+        disconnect();
+        return false;
+    }
+    freeaddrinfo(result);
+    int flag = 1;
+    setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+    int receiveBuffer = 1024 * 1024;
+    setsockopt(_fd, SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof(receiveBuffer));
+    fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL, 0) | O_NONBLOCK);
+    _start = _end = 0;
+    _skipRemaining = 0;
+
+    // CONNECT: protocol "MQTT" level 4, clean session, keepalive
+    std::vector<uint8_t> body;
+    appendString(body, "MQTT");
+    body.push_back(4);
+    body.push_back(0x02);
+    body.push_back(KEEPALIVE_S >> 8);
+    body.push_back(KEEPALIVE_S & 0xFF);
+    appendString(body, clientId);
+    std::vector<uint8_t> packet = {0x10};
+    encodeLength(packet, body.size());
+    packet.insert(packet.end(), body.begin(), body.end());
+
+    uint8_t type;
+    std::vector<uint8_t> reply;
+    if (!sendAll(packet.data(), packet.size()) || !readPacket(type, reply, CONNECT_TIMEOUT_MS)
+        || type != TYPE_CONNACK || reply.size() != 2 || reply[1] != 0) {
+        disconnect();
+        return false;
+    }
+
+    // SUBSCRIBE: all filters at QoS 0 in one packet
+    body.clear();
+    body.push_back(0);
+    body.push_back(1);                  // Packet identifier
+    for (const String& filter : filters) {
+        appendString(body, filter.c_str());
+        body.push_back(0);
+    }
+    packet = {0x82};
+    encodeLength(packet, body.size());
+    packet.insert(packet.end(), body.begin(), body.end());
+    if (!sendAll(packet.data(), packet.size()) || !readPacket(type, reply, CONNECT_TIMEOUT_MS)
+        || type != TYPE_SUBACK || reply.size() != 2 + filters.size()) {
+        disconnect();
+        return false;
+    }
+    for (size_t i = 2; i < reply.size(); i++) {
+        if (reply[i] == 0x80) {
+            printf("[BRIDGE] Subscription to %s refused\n", filters[i - 2].c_str());
+        }
+    }
+    return true;
+}
+
+void MqttSubscriber::disconnect() {
+    if (_fd >= 0) {
+        close(_fd);
+        _fd = -1;
+    }
+}
+
+void MqttSubscriber::service(unsigned long now) {
+    if (_fd >= 0 && now - _lastSendMs >= KEEPALIVE_S * 500UL) {
+        static const uint8_t PINGREQ[] = {0xC0, 0x00};
+        if (!sendAll(PINGREQ, sizeof(PINGREQ))) {
+            disconnect();
+        }
+    }
+}
+
+// Hands every complete packet in the buffer to the handler
+bool MqttSubscriber::deliver(MessageHandler handler, void* context, uint32_t& delivered) {
+    while (_start < _end) {
+        if (_skipRemaining > 0) {
+            size_t skip = min(_skipRemaining, _end - _start);
+            _start += skip;
+            _skipRemaining -= skip;
+            continue;
+        }
+        size_t length;
+        int header = _end - _start >= 2 ? decodeLength(&_buffer[_start + 1], _end - _start - 1, length) : 0;
+        if (header < 0) {
+            return false;
+        }
+        if (header == 0) {
+            break;
+        }
+        size_t total = 1 + header + length;
+        if (total > MAX_PACKET) {
+            _skippedPackets++;
+            _skipRemaining = total;
+            continue;
+        }
+        if (_end - _start < total) {
+            break;  // Incomplete (the buffer grows if it must)
+        }
+
+        uint8_t flags = _buffer[_start];
+        const uint8_t* body = &_buffer[_start + 1 + header];
+        if ((flags >> 4) == TYPE_PUBLISH && length >= 2) {
+            size_t topicLength = ((size_t)body[0] << 8) | body[1];
+            size_t offset = 2 + topicLength + (((flags >> 1) & 0x03) > 0 ? 2 : 0);
+            if (offset <= length) {
+                handler(context, (const char*)body + 2, topicLength, (const char*)body + offset, length - offset);
+                delivered++;
+            }
+        }
+        _start += total;
+    }
+    return true;
+}
+
+uint32_t MqttSubscriber::poll(MessageHandler handler, void* context, size_t maxBytes) {
+    uint32_t delivered = 0;
+    size_t received = 0;
+    // Messages that arrived with the SUBACK are already buffered
+    if (!deliver(handler, context, delivered)) {
+        disconnect();
+        return delivered;
+    }
+    while (_fd >= 0 && received < maxBytes) {
+        // Keep the partial packet at the front so the free space is contiguous
+        if (_start > 0 && (_start == _end || _buffer.size() - _end < _buffer.size() / 4)) {
+            memmove(&_buffer[0], &_buffer[_start], _end - _start);
+            _end -= _start;
+            _start = 0;
+        }
+        if (_end == _buffer.size()) {
+            _buffer.resize(min(_buffer.size() * 2, MAX_PACKET + 8));
+        }
+
+        ssize_t n = recv(_fd, &_buffer[_end], _buffer.size() - _end, 0);
+        if (n <= 0) {
+            if (n == 0 || (errno != EAGAIN && errno != EINTR)) {
+                disconnect();
+            }
+            break;
+        }
+        _end += n;
+        received += n;
+        _bytesReceived += n;
+        if (!deliver(handler, context, delivered)) {
+            disconnect();
+            break;
+        }
+    }
+    return delivered;
+}
@@ -0,0 +1,71 @@
+/**
+ * MqttSubscriber.h
+ *
+ * Minimal MQTT 3.1.1 subscriber for high message rates. PubSubClient reads
+ * one byte per call and one message per loop(); this client reads the socket
+ * in large chunks and hands every complete PUBLISH in the buffer to the
+ * handler as topic/payload spans into the receive buffer (no copies).
+ *
+ * Subscriptions are QoS 0, so the broker delivers at QoS 0 and nothing is
+ * acknowledged. While the caller does not poll, the socket is not read and
+ * TCP flow control pushes back on the broker (backpressure).
+ */
+
+#ifndef MQTT_SUBSCRIBER_H
+#define MQTT_SUBSCRIBER_H
+
+#include <Arduino.h>
+#include <vector>
+
+class MqttSubscriber {
+public:
+    static const size_t BUFFER_SIZE = 256 * 1024;
+    static const size_t MAX_PACKET = 1024 * 1024;       // Larger packets are skipped
+    static const uint16_t KEEPALIVE_S = 60;
+    static const unsigned long CONNECT_TIMEOUT_MS = 5000;
+
+    typedef void (*MessageHandler)(void* context, const char* topic, size_t topicLength,
+                                   const char* payload, size_t payloadLength);
+
+    MqttSubscriber();
+    ~MqttSubscriber();
+
+    /**
+     * @brief Connect (clean session), wait for CONNACK and subscribe to every filter
+     */
+    bool connect(const char* host, uint16_t port, const char* clientId, const std::vector<String>& filters);
+    void disconnect();
+    bool isConnected() const { return _fd >= 0; }
+    int getFd() const { return _fd; }
+
+    /**
+     * @brief Read what the socket has and deliver every complete message
+     * @param maxBytes Stop reading after this many bytes (bounds one call)
+     * @return Messages delivered; the connection is closed on error or EOF
+     */
+    uint32_t poll(MessageHandler handler, void* context, size_t maxBytes);
+
+    /**
+     * @brief Send PINGREQ when the keepalive interval is half over
+     */
+    void service(unsigned long now);
+
+    uint64_t getBytesReceived() const { return _bytesReceived; }
+    uint32_t getSkippedPackets() const { return _skippedPackets; }
+
+private:
+    bool sendAll(const uint8_t* data, size_t length);
+    bool readPacket(uint8_t& type, std::vector<uint8_t>& body, unsigned long timeoutMs);
+    bool deliver(MessageHandler handler, void* context, uint32_t& delivered);
+
+    int _fd = -1;
+    std::vector<uint8_t> _buffer;
+    size_t _start = 0;                  // First unparsed byte
+    size_t _end = 0;                    // One past the last received byte
+    size_t _skipRemaining = 0;          // Bytes of an oversized packet still to discard
+    unsigned long _lastSendMs = 0;
+    uint64_t _bytesReceived = 0;
+    uint32_t _skippedPackets = 0;
+};
+
+#endif // MQTT_SUBSCRIBER_H
@@ -0,0 +1,3 @@
+// Batching and InfluxDB writes shared with the VE.Direct gateway (PlatformIO
+// only builds sources under src/, so they are pulled in from there).
+#include "../../vedirect-gateway/src/BatchPublisher.cpp"
@@ -0,0 +1,382 @@
+/**
+ * MQTT → InfluxDB bridge
+ *
+ * Subscribes to the fleet's MQTT topics, turns each JSON payload into one
+ * line-protocol line with the rules in a mapping file (see FieldMapping.h and
+ * mapping.conf), and writes them to InfluxDB in batches with the gateway's
+ * BatchPublisher. Line-protocol payloads (the solar nodes' /influx topic) are
+ * forwarded as they are.
+ *
+ * The loop never blocks on InfluxDB: batches are sent from the publisher's
+ * queue, and while more than half of its backlog is in use the MQTT socket is
+ * not read, so TCP flow control pushes back on the broker instead of the
+ * bridge dropping lines.
+ *
+ * --bench N starts a local broker stand-in that streams N firmware-shaped
+ * messages and checks every one was received and accounted for. --check maps
+ * a few hand-written payloads (escapes, line breaks) with the mapping file and
+ * compares the lines, exiting 2 if one differs.
+ *
+ * Usage:
+ *   pio run -e native
+ *   .pio/build/native/program --broker 127.0.0.1:1883 --influx 127.0.0.1:8086 \
+ *       --org home --bucket sensors --token $INFLUX_TOKEN
+ *   .pio/build/native/program --bench 2000000 --devices 5000
+ */
+
+#include <Arduino.h>
+#include <HostCheck.h>
+#include <WiFi.h>
+#include <memory>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "BatchPublisher.h"
+#include "BrokerStandIn.h"
+#include "FieldMapping.h"
+#include "MqttSubscriber.h"
+
+static const unsigned long RECONNECT_INTERVAL_MS = 5000;   // Firmware MQTT reconnect interval
+static const size_t POLL_BYTES = 256 * 1024;                // Socket bytes per loop iteration
+
+struct BridgeOptions {
+    String brokerHost = "127.0.0.1";
+    uint16_t brokerPort = 1883;
+    String clientId;
+    String mappingPath = "mapping.conf";
+    uint64_t benchMessages = 0;         // > 0: local broker stand-in
+    uint32_t benchDevices = 1000;
+    bool check = false;                 // Map sample payloads, compare, exit
+    uint32_t durationSeconds = 0;       // 0 = until SIGINT/SIGTERM
+    uint32_t reportSeconds = 10;
+};
+
+// Handler state for one MqttSubscriber::poll() call
+struct BridgeContext {
+    FieldMapping* mapping;
+    String lines;                       // Mapped lines of this poll, added to the publisher in one go
+    uint64_t timestampMs = 0;
+    uint64_t results[5] = {};           // By FieldMapping::Result
+};
+
+static volatile sig_atomic_t s_stop = 0;
+
+static void onSignal(int) {
+    s_stop = 1;
+}
+
+static uint64_t unixTimeMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000ULL + ts.tv_nsec / 1000000;
+}
+
+static double cpuSeconds() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec
+        + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+static void onMessage(void* context, const char* topic, size_t topicLength, const char* payload,
+                      size_t payloadLength) {
+    BridgeContext& ctx = *(BridgeContext*)context;
+    FieldMapping::Result result = ctx.mapping->apply(topic, topicLength, payload, payloadLength,
+                                                     ctx.timestampMs, ctx.lines);
+    ctx.results[(int)result]++;
+}
+
+// ============================================================================
+// Mapping checks
+// ============================================================================
+
+static void checkLine(FieldMapping& mapping, const char* topic, const char* payload, const char* expected,
+                      const char* what) {
+    String line;
+    FieldMapping::Result result = mapping.apply(topic, strlen(topic), payload, strlen(payload), 1700000000000ULL, line);
+    if (!HostCheck::expect(result == FieldMapping::Result::Mapped && line == expected, what)) {
+        printf("[CHECK]   got:  %s", line.c_str());
+        printf("[CHECK]   want: %s", expected);
+    }
+}
+
+// Rules from the mapping file in use (mapping.conf for these topics)
+static int runChecks(FieldMapping& mapping) {
+    // \n stays a line break inside the quoted string field, \u00b0 and the
+    // surrogate pair become UTF-8, \" and \\ keep their line-protocol escapes
+    checkLine(mapping, "esp-sensor-hub/temp-1/events",
+              "{\"device\":\"temp-1\",\"chip_id\":\"A1B2\",\"firmware_version\":\"1.0.48\",\"schema_version\":1,"
+              "\"event\":\"sensor_fault\",\"severity\":\"warning\",\"timestamp\":42,\"uptime_seconds\":42,"
+              "\"free_heap\":31000,\"message\":\"Probe \\\"A\\\" lost\\nLast: 21.5\\u00b0C \\\\ \\ud83c\\udf21\"}",
+              "device_events,device=temp-1,chip_id=A1B2,event_type=sensor_fault,severity=warning "
+              "message=\"Probe \\\"A\\\" lost\nLast: 21.5\u00b0C \\\\ \U0001F321\",uptime_seconds=42i,free_heap=31000i "
+              "1700000000000\n",
+              "event message escapes decoded");
+    // A tag cannot hold a line break: it is spelled out, decoded spaces are escaped
+    checkLine(mapping, "esp-sensor-hub/temp-2/events",
+              "{\"device\":\"hall\\u0020sensor\\n2\",\"chip_id\":\"C3\",\"schema_version\":1,\"event\":\"boot\","
+              "\"severity\":\"info\",\"uptime_seconds\":1,\"free_heap\":1}",
+              "device_events,device=hall\\ sensor\\n2,chip_id=C3,event_type=boot,severity=info "
+              "uptime_seconds=1i,free_heap=1i 1700000000000\n",
+              "tag escapes decoded, line break spelled out");
+    return HostCheck::exitCode();
+}
+
+// ============================================================================
+// Options
+// ============================================================================
+
+static void printUsage() {
+    printf("Usage: program [--broker host:port] [--client-id ID] [--mapping FILE]\n"
+           "               [--influx host:port --org ORG --bucket BUCKET --token TOKEN] [--stdout]\n"
+           "               [--batch-bytes N] [--batch-ms MS] [--bench N [--devices N]]\n"
+           "               [--duration S] [--report S] [--check]\n");
+}
+
+static void parseHostPort(const String& value, String& host, uint16_t& port) {
+    int colon = value.indexOf(':');
+    host = colon >= 0 ? value.substring(0, colon) : value;
+    if (colon >= 0) {
+        port = value.substring(colon + 1).toInt();
+    }
+}
+
+static bool parseArgs(int argc, char** argv, BridgeOptions& options, BatchPublisher::Config& config) {
+    for (int i = 1; i < argc; i++) {
+        String arg = argv[i];
+        if (arg == "--stdout") {
+            config.target = BatchPublisher::Target::Stdout;
+            continue;
+        }
+        if (arg == "--check") {
+            options.check = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            printUsage();
+            return false;
+        }
+        String value = argv[++i];
+        if (arg == "--broker") {
+            parseHostPort(value, options.brokerHost, options.brokerPort);
+        } else if (arg == "--client-id") {
+            options.clientId = value;
+        } else if (arg == "--mapping") {
+            options.mappingPath = value;
+        } else if (arg == "--influx") {
+            config.target = BatchPublisher::Target::Influx;
+            config.port = 8086;
+            parseHostPort(value, config.host, config.port);
+        } else if (arg == "--org") {
+            config.org = value;
+        } else if (arg == "--bucket") {
+            config.bucket = value;
+        } else if (arg == "--token") {
+            config.token = value;
+        } else if (arg == "--batch-bytes") {
+            config.maxBytes = value.toInt();
+        } else if (arg == "--batch-ms") {
+            config.maxAgeMs = value.toInt();
+        } else if (arg == "--bench") {
+            options.benchMessages = strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--devices") {
+            options.benchDevices = value.toInt();
+        } else if (arg == "--duration") {
+            options.durationSeconds = value.toInt();
+        } else if (arg == "--report") {
+            options.reportSeconds = value.toInt();
+        } else {
+            printUsage();
+            return false;
+        }
+    }
+    return true;
+}
+
+// ============================================================================
+// Event loop
+// ============================================================================
+
+int main(int argc, char** argv) {
+    BridgeOptions options;
+    BatchPublisher::Config config;
+    config.maxBytes = 256 * 1024;       // InfluxDB takes large writes; fewer requests at fleet rates
+    config.maxAgeMs = 1000;
+    config.maxPendingBytes = 64 * 1024 * 1024;
+    if (!parseArgs(argc, argv, options, config)) {
+        return 1;
+    }
+    WiFi.begin();  // Shim station: sockets go straight to the host network
+
+    FieldMapping mapping;
+    String error;
+    if (!mapping.load(options.mappingPath.c_str(), error)) {
+        printf("[BRIDGE] %s: %s\n", options.mappingPath.c_str(), error.c_str());
+        return 1;
+    }
+    if (options.check) {
+        return runChecks(mapping);
+    }
+    std::vector<String> filters;
+    for (const FieldMapping::Rule& rule : mapping.getRules()) {
+        bool known = false;
+        for (const String& filter : filters) {
+            known = known || filter == rule.filter;
+        }
+        if (!known) {
+            filters.push_back(rule.filter);
+        }
+    }
+
+    std::unique_ptr<BrokerStandIn> standIn;
+    if (options.benchMessages > 0) {
+        standIn.reset(new BrokerStandIn());
+        if (!standIn->begin(options.benchMessages, options.benchDevices)) {
+            perror("[BRIDGE] stand-in broker");
+            return 1;
+        }
+        options.brokerHost = "127.0.0.1";
+        options.brokerPort = standIn->getPort();
+    }
+    if (options.clientId.length() == 0) {
+        options.clientId = String("mqtt-influx-bridge-") + String((unsigned long)getpid());
+    }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    signal(SIGPIPE, SIG_IGN);
+
+    BatchPublisher publisher(config);
+    publisher.begin();
+    size_t highWater = config.maxPendingBytes / 2;
+
+    printf("[BRIDGE] %u rules, %u subscriptions, broker %s:%u%s, batches %u B / %lu ms\n",
+           (unsigned)mapping.getRules().size(), (unsigned)filters.size(), options.brokerHost.c_str(),
+           options.brokerPort, standIn ? " (stand-in)" : "", (unsigned)config.maxBytes, config.maxAgeMs);
+
+    MqttSubscriber subscriber;
+    BridgeContext ctx;
+    ctx.mapping = &mapping;
+    ctx.lines.reserve(POLL_BYTES * 2);
+    uint64_t messages = 0;
+    uint64_t reportMessages = 0;
+    uint32_t connects = 0;
+    uint32_t throttled = 0;             // Loop iterations that left the socket unread
+    bool wasThrottled = false;
+
+    unsigned long start = millis();
+    unsigned long lastReport = start;
+    unsigned long lastConnectAttempt = 0;
+    bool attempted = false;
+    double cpuStart = cpuSeconds();
+
+    while (!s_stop) {
+        unsigned long now = millis();
+        if (options.durationSeconds > 0 && now - start >= options.durationSeconds * 1000UL) {
+            break;
+        }
+        if (!subscriber.isConnected()) {
+            if (standIn && connects > 0) {
+                break;  // Stand-in closed after its last message
+            }
+            if (!attempted || now - lastConnectAttempt >= RECONNECT_INTERVAL_MS) {
+                attempted = true;
+                lastConnectAttempt = now;
+                if (subscriber.connect(options.brokerHost.c_str(), options.brokerPort, options.clientId.c_str(),
+                                       filters)) {
+                    connects++;
+                    printf("[BRIDGE] Connected to %s:%u\n", options.brokerHost.c_str(), options.brokerPort);
+                } else {
+                    printf("[BRIDGE] Connect to %s:%u failed (retrying every %lu s)\n", options.brokerHost.c_str(),
+                           options.brokerPort, RECONNECT_INTERVAL_MS / 1000);
+                    if (standIn) {
+                        break;
+                    }
+                }
+            }
+        }
+
+        // Backpressure: leave the socket unread while InfluxDB is behind
+        bool throttle = publisher.getPendingBytes() >= highWater;
+        if (throttle && !wasThrottled) {
+            printf("[BRIDGE] %u B queued for InfluxDB, pausing MQTT reads\n", (unsigned)publisher.getPendingBytes());
+        }
+        wasThrottled = throttle;
+        throttled += throttle;
+
+        int timeout = (int)min(publisher.getWaitMs(now), 100UL);
+        struct pollfd pfd = {subscriber.getFd(), POLLIN, 0};
+        int ready = 0;
+        if (subscriber.isConnected() && !throttle) {
+            ready = ::poll(&pfd, 1, timeout);
+        } else {
+            usleep(min(timeout, 10) * 1000);
+        }
+        if (ready < 0 && errno != EINTR) {
+            perror("[BRIDGE] poll");
+            break;
+        }
+
+        now = millis();
+        if (ready > 0) {
+            ctx.timestampMs = unixTimeMs();
+            messages += subscriber.poll(onMessage, &ctx, POLL_BYTES);
+            if (ctx.lines.length() > 0) {
+                publisher.add(ctx.lines, now);
+                ctx.lines = "";
+            }
+            if (!subscriber.isConnected() && !standIn) {
+                printf("[BRIDGE] Disconnected from broker\n");
+            }
+        }
+        subscriber.service(now);
+        publisher.service(now);
+
+        if (options.reportSeconds > 0 && now - lastReport >= options.reportSeconds * 1000UL) {
+            const BatchPublisher::Stats& stats = publisher.getStats();
+            printf("[BRIDGE] %8.0f msgs/s | %llu mapped, %u batches, %llu B sent | %u B queued | %llu dropped\n",
+                   (messages - reportMessages) * 1000.0 / (now - lastReport),
+                   (unsigned long long)ctx.results[(int)FieldMapping::Result::Mapped],
+                   stats.batches, (unsigned long long)stats.bytes, (unsigned)publisher.getPendingBytes(),
+                   (unsigned long long)stats.droppedLines);
+            reportMessages = messages;
+            lastReport = now;
+        }
+    }
+
+    double elapsed = (millis() - start) / 1000.0;
+    double cpu = cpuSeconds() - cpuStart;
+    publisher.flush(millis());
+    const BatchPublisher::Stats& stats = publisher.getStats();
+
+    printf("\n[BRIDGE] Summary: %.1f s, %llu messages (%llu B), %.0f msgs/s, %.2f CPU s (%.0f msgs per CPU s)\n",
+           elapsed, (unsigned long long)messages, (unsigned long long)subscriber.getBytesReceived(),
+           messages / elapsed, cpu, cpu > 0 ? messages / cpu : 0.0);
+    printf("[BRIDGE] %llu mapped, %llu unmatched, %llu bad payloads, %llu schema mismatches, %llu without fields, "
+           "%u oversized skipped\n",
+           (unsigned long long)ctx.results[(int)FieldMapping::Result::Mapped],
+           (unsigned long long)ctx.results[(int)FieldMapping::Result::Unmatched],
+           (unsigned long long)ctx.results[(int)FieldMapping::Result::BadPayload],
+           (unsigned long long)ctx.results[(int)FieldMapping::Result::SchemaMismatch],
+           (unsigned long long)ctx.results[(int)FieldMapping::Result::NoFields], subscriber.getSkippedPackets());
+    printf("[BRIDGE] Published %llu B in %u batches, %u failed sends, %llu dropped, %u throttled loops, %u connects\n",
+           (unsigned long long)stats.bytes, stats.batches, stats.failures, (unsigned long long)stats.droppedLines,
+           throttled, connects);
+    for (const FieldMapping::Rule& rule : mapping.getRules()) {
+        printf("[BRIDGE]   %-36s %10llu\n", rule.filter.c_str(), (unsigned long long)rule.matched);
+    }
+
+    if (standIn) {
+        // Every message the stand-in sent must have been received and mapped
+        bool ok = standIn->isDone() && messages == standIn->getSent()
+            && ctx.results[(int)FieldMapping::Result::Mapped] == messages;
+        printf("[BRIDGE] Stand-in sent %llu messages%s\n", (unsigned long long)standIn->getSent(),
+               ok ? "" : "  <-- MISMATCH");
+        return ok ? 0 : 2;
+    }
+    return 0;
+}
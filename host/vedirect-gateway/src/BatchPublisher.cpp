@@ -0,0 +1,162 @@
+/**
+ * BatchPublisher.cpp
+ *
+ * Implementation of size/time batching to MQTT or InfluxDB
+ */
+
+#include "BatchPublisher.h"
+
+#include <unistd.h>
+
+BatchPublisher::BatchPublisher(const Config& config)
+    : _config(config), _mqtt(_net) {}
+
+bool BatchPublisher::begin() {
+    _pending.reserve(_config.maxBytes * 2);
+    if (_config.target == Target::Mqtt) {
+        _mqtt.setServer(_config.host.c_str(), _config.port);
+        _mqtt.setBufferSize(_config.maxBytes + _config.topic.length() + 16);
+        _clientId = "vedirect-gateway-" + String((unsigned long)getpid());
+        if (!_mqtt.connect(_clientId.c_str())) {
+            printf("[GW] MQTT connect to %s:%u failed (state %d), retrying\n",
+                   _config.host.c_str(), _config.port, _mqtt.state());
+            _failing = true;
+            _lastFailure = millis();
+        }
+    }
+    return true;
+}
+
+bool BatchPublisher::add(const String& lines, unsigned long now) {
+    if (_pending.length() + lines.length() > _config.maxPendingBytes) {
+        _stats.droppedLines++;
+        return false;
+    }
+    if (_pending.length() == 0) {
+        _oldestMs = now;
+    }
+    _pending += lines;
+    _stats.lines++;
+    return true;
+}
+
+unsigned long BatchPublisher::getWaitMs(unsigned long now) const {
+    if (_pending.length() == 0) {
+        return _config.maxAgeMs;
+    }
+    unsigned long dueAt = _failing ? _lastFailure + RETRY_INTERVAL_MS : _oldestMs + _config.maxAgeMs;
+    long wait = (long)(dueAt - now);
+    return wait > 0 ? (unsigned long)wait : 0;
+}
+
+void BatchPublisher::service(unsigned long now) {
+    if (_config.target == Target::Mqtt && _mqtt.connected()) {
+        _mqtt.loop();
+    }
+    if (_pending.length() == 0) {
+        return;
+    }
+    if (_failing && now - _lastFailure < RETRY_INTERVAL_MS) {
+        return;
+    }
+    if (_pending.length() >= _config.maxBytes || now - _oldestMs >= _config.maxAgeMs || _failing) {
+        flush(now);
+    }
+}
+
+bool BatchPublisher::flush(unsigned long now) {
+    // Whole lines, at most maxBytes per batch (a longer single line goes alone)
+    while (_pending.length() > 0) {
+        const char* data = _pending.c_str();
+        size_t length = _pending.length();
+        if (length > _config.maxBytes) {
+            size_t cut = _config.maxBytes;
+            while (cut > 0 && data[cut - 1] != '\n') {
+                cut--;
+            }
+            if (cut == 0) {
+                const char* end = strchr(data, '\n');
+                cut = end ? (size_t)(end - data) + 1 : length;
+            }
+            length = cut;
+        }
+
+        if (!send(data, length)) {
+            _stats.failures++;
+            _failing = true;
+            _lastFailure = now;
+            return false;
+        }
+        _failing = false;
+        _stats.batches++;
+        _stats.bytes += length;
+        _pending.remove(0, length);
+        _oldestMs = now;
+
+        // A partial batch waits for its own size or age
+        if (_pending.length() < _config.maxBytes) {
+            break;
+        }
+    }
+    return true;
+}
+
+bool BatchPublisher::send(const char* data, size_t length) {
+    switch (_config.target) {
+        case Target::Mqtt: return sendMqtt(data, length);
+        case Target::Influx: return sendInflux(data, length);
+        case Target::Stdout: return fwrite(data, 1, length, stdout) == length;
+        default: return true;
+    }
+}
+
+bool BatchPublisher::sendMqtt(const char* data, size_t length) {
+    if (!_mqtt.connected() && !_mqtt.connect(_clientId.c_str())) {
+        printf("[GW] MQTT reconnect failed (state %d)\n", _mqtt.state());
+        return false;
+    }
+    return _mqtt.publish(_config.topic.c_str(), (const uint8_t*)data, length, false);
+}
+
+// One request per batch; batches are seconds apart, so no keep-alive
+bool BatchPublisher::sendInflux(const char* data, size_t length) {
+    WiFiClient http;
+    if (!http.connect(_config.host.c_str(), _config.port)) {
+        printf("[GW] InfluxDB %s:%u unreachable\n", _config.host.c_str(), _config.port);
+        return false;
+    }
+    String request = "POST /api/v2/write?org=" + _config.org + "&bucket=" + _config.bucket + "&precision=ms HTTP/1.1\r\n";
+    request += "Host: " + _config.host + "\r\n";
+    request += "Authorization: Token " + _config.token + "\r\n";
+    request += "Content-Type: text/plain; charset=utf-8\r\n";
+    request += "Content-Length: " + String((unsigned long)length) + "\r\n";
+    request += "Connection: close\r\n\r\n";
+    if (http.write((const uint8_t*)request.c_str(), request.length()) != request.length()
+        || http.write((const uint8_t*)data, length) != length) {
+        return false;
+    }
+
+    // Status line only: "HTTP/1.1 204 No Content"
+    String status;
+    unsigned long start = millis();
+    while (millis() - start < HTTP_TIMEOUT_MS && http.connected()) {
+        int c = http.read();
+        if (c < 0) {
+            delay(1);
+            continue;
+        }
+        if (c == '\n') {
+            break;
+        }
+        status += (char)c;
+    }
+    http.stop();
+
+    int space = status.indexOf(' ');
+    int code = space >= 0 ? status.substring(space + 1).toInt() : 0;
+    if (code < 200 || code >= 300) {
+        printf("[GW] InfluxDB write failed: %s\n", status.length() > 0 ? status.c_str() : "no response");
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,94 @@
+/**
+ * BatchPublisher.h
+ *
+ * Batches line-protocol snapshots and sends them when the batch reaches
+ * maxBytes or its oldest line is maxAgeMs old, to one of:
+ *
+ * - MQTT: one message per batch on <base>/<device>/influx, like the solar
+ *   nodes of the fleet simulator (PubSubClient over the host WiFiClient)
+ * - InfluxDB: POST /api/v2/write with precision=ms (plain HTTP)
+ * - stdout, or nothing (benchmarks)
+ *
+ * Backpressure: a batch that fails to send is kept and retried every
+ * RETRY_INTERVAL_MS; new lines keep queueing behind it up to maxPendingBytes,
+ * after which snapshots are dropped (and counted) until the target is back.
+ */
+
+#ifndef BATCH_PUBLISHER_H
+#define BATCH_PUBLISHER_H
+
+#include <Arduino.h>
+#include <PubSubClient.h>
+#include <WiFiClient.h>
+
+class BatchPublisher {
+public:
+    enum class Target { None, Stdout, Mqtt, Influx };
+
+    static const unsigned long RETRY_INTERVAL_MS = 5000;   // Firmware MQTT reconnect interval
+    static const unsigned long HTTP_TIMEOUT_MS = 5000;
+
+    struct Config {
+        Target target = Target::None;
+        String host = "127.0.0.1";
+        uint16_t port = 1883;
+        String topic;                   // MQTT
+        String org;                     // InfluxDB
+        String bucket;
+        String token;
+        size_t maxBytes = 16384;
+        unsigned long maxAgeMs = 5000;
+        size_t maxPendingBytes = 4 * 1024 * 1024;
+    };
+
+    struct Stats {
+        uint64_t lines = 0;
+        uint64_t bytes = 0;             // Sent
+        uint32_t batches = 0;
+        uint32_t failures = 0;
+        uint64_t droppedLines = 0;
+    };
+
+    explicit BatchPublisher(const Config& config);
+
+    bool begin();
+
+    /**
+     * @brief Queue one or more complete lines ('\n' terminated)
+     * @return false if dropped because the backlog is full
+     */
+    bool add(const String& lines, unsigned long now);
+
+    /**
+     * @brief Send the batch if it is due; call from the event loop
+     */
+    void service(unsigned long now);
+
+    /**
+     * @brief Send whatever is queued (shutdown)
+     */
+    bool flush(unsigned long now);
+
+    // Longest the event loop may wait before service() has work
+    unsigned long getWaitMs(unsigned long now) const;
+
+    size_t getPendingBytes() const { return _pending.length(); }
+    const Stats& getStats() const { return _stats; }
+
+private:
+    bool send(const char* data, size_t length);
+    bool sendMqtt(const char* data, size_t length);
+    bool sendInflux(const char* data, size_t length);
+
+    Config _config;
+    WiFiClient _net;
+    PubSubClient _mqtt;
+    String _clientId;
+    String _pending;                    // Queued lines, oldest first
+    unsigned long _oldestMs = 0;        // Queue time of the first pending line
+    unsigned long _lastFailure = 0;
+    bool _failing = false;
+    Stats _stats;
+};
+
+#endif // BATCH_PUBLISHER_H
@@ -0,0 +1,150 @@
+/**
+ * GatewayPort.cpp
+ *
+ * Implementation of a VE.Direct device on a Linux serial port
+ */
+
+#include "GatewayPort.h"
+#include "serial_port.h"
+
+#include <errno.h>
+#include <unistd.h>
+
+static const size_t READ_CHUNK = 4096;
+
+GatewayPort::GatewayPort(Kind kind, const String& path, uint8_t index)
+    : _kind(kind), _path(path), _index(index) {
+    if (kind == Kind::Mppt) {
+        snprintf(_name, sizeof(_name), "mppt%u", index);
+        _mppt.reset(new VictronMPPT(&_stream));
+    } else {
+        snprintf(_name, sizeof(_name), "shunt");
+        _shunt.reset(new VictronSmartShunt(&_stream));
+    }
+}
+
+GatewayPort::~GatewayPort() {
+    close();
+}
+
+bool GatewayPort::open() {
+    _lastOpenAttempt = millis();
+    _fd = SerialPort::open(_path.c_str());
+    if (_fd < 0) {
+        _openFailures++;
+        return false;
+    }
+    return true;
+}
+
+void GatewayPort::close() {
+    if (_fd >= 0) {
+        ::close(_fd);
+        _fd = -1;
+    }
+}
+
+uint32_t GatewayPort::service() {
+    uint8_t buffer[READ_CHUNK];
+    while (_fd >= 0) {
+        ssize_t length = ::read(_fd, buffer, sizeof(buffer));
+        if (length > 0) {
+            _bytesRead += length;
+            _stream.set(buffer, length);
+            if (_mppt) {
+                _mppt->update();
+            } else {
+                _shunt->update();
+            }
+            if ((size_t)length < sizeof(buffer)) {
+                break;
+            }
+            continue;
+        }
+        if (length < 0 && (errno == EAGAIN || errno == EINTR)) {
+            break;
+        }
+        // 0 or EIO: device gone (unplugged adapter, closed pty master)
+        close();
+    }
+
+    uint32_t blocks = getBlockCount();
+    uint32_t committed = blocks - _lastBlockCount;
+    _lastBlockCount = blocks;
+    return committed;
+}
+
+const char* GatewayPort::getName() const {
+    return _name;
+}
+
+bool GatewayPort::isDataValid() const {
+    return _mppt ? _mppt->isDataValid() : _shunt->isDataValid();
+}
+
+uint32_t GatewayPort::getBlockCount() const {
+    return _mppt ? _mppt->getBlockCount() : _shunt->getBlockCount();
+}
+
+uint32_t GatewayPort::getChecksumErrors() const {
+    return _mppt ? _mppt->getChecksumErrors() : _shunt->getChecksumErrors();
+}
+
+void GatewayPort::appendSnapshot(String& data, const String& deviceTag, const String& location,
+                                 uint64_t timestampMs) const {
+    if (!isDataValid()) {
+        return;
+    }
+
+    if (_shunt) {
+        const VictronSmartShunt& shunt = *_shunt;
+        data += "battery,device=" + deviceTag + ",location=" + location + " ";
+        data += "voltage=" + String(shunt.getBatteryVoltage(), 3) + ",";
+        data += "current=" + String(shunt.getBatteryCurrent(), 3) + ",";
+        data += "soc=" + String(shunt.getStateOfCharge(), 1) + ",";
+        data += "time_remaining=" + String(shunt.getTimeRemaining()) + ",";
+        data += "consumed_ah=" + String(shunt.getConsumedAh(), 3) + ",";
+        data += "alarm=" + String(shunt.getAlarmState() ? 1 : 0) + ",";
+        data += "relay=" + String(shunt.getRelayState() ? 1 : 0) + ",";
+        data += "min_voltage=" + String(shunt.getMinVoltage(), 3) + ",";
+        data += "max_voltage=" + String(shunt.getMaxVoltage(), 3) + ",";
+        data += "charge_cycles=" + String(shunt.getChargeCycles()) + ",";
+        data += "deepest_discharge=" + String(shunt.getDeepestDischarge(), 3) + ",";
+        data += "last_discharge=" + String(shunt.getLastDischarge(), 3) + ",";
+        data += "average_discharge=" + String(shunt.getAverageDischarge(), 3) + ",";
+        data += "full_discharges=" + String(shunt.getFullDischarges()) + ",";
+        data += "cumulative_ah=" + String(shunt.getCumulativeAh(), 3) + ",";
+        data += "seconds_since_full=" + String(shunt.getSecondsSinceFullCharge()) + ",";
+        data += "syncs=" + String(shunt.getSyncCount()) + ",";
+        data += "low_voltage_alarms=" + String(shunt.getLowVoltageAlarms()) + ",";
+        data += "high_voltage_alarms=" + String(shunt.getHighVoltageAlarms()) + ",";
+        data += "discharged_energy=" + String(shunt.getDischargedEnergy(), 2) + ",";
+        data += "charged_energy=" + String(shunt.getChargedEnergy(), 2);
+    } else {
+        const VictronMPPT& mppt = *_mppt;
+        data += "solar,device=" + deviceTag + ",location=" + location + ",mppt=" + String(_index);
+        if (mppt.getProductID().length() > 0) {
+            data += ",product_id=" + mppt.getProductID();
+        }
+        if (mppt.getSerialNumber().length() > 0) {
+            String serial = mppt.getSerialNumber();
+            serial.replace(" ", "_");
+            data += ",serial=" + serial;
+        }
+        data += " ";
+        data += "pv_voltage=" + String(mppt.getPanelVoltage(), 3) + ",";
+        data += "pv_power=" + String(mppt.getPanelPower(), 1) + ",";
+        data += "battery_voltage=" + String(mppt.getBatteryVoltage(), 3) + ",";
+        data += "charge_current=" + String(mppt.getChargeCurrent(), 3) + ",";
+        data += "charge_state=\"" + mppt.getChargeState() + "\",";
+        data += "error_code=" + String(mppt.getErrorCode()) + ",";
+        data += "load_state=\"" + mppt.getLoadState() + "\",";
+        data += "load_current=" + String(mppt.getLoadCurrent(), 3) + ",";
+        data += "yield_today=" + String(mppt.getYieldToday(), 3) + ",";
+        data += "yield_yesterday=" + String(mppt.getYieldYesterday(), 3) + ",";
+        data += "yield_total=" + String(mppt.getYieldTotal(), 3) + ",";
+        data += "max_power_today=" + String(mppt.getMaxPowerToday()) + ",";
+        data += "max_power_yesterday=" + String(mppt.getMaxPowerYesterday());
+    }
+    data += " " + String((unsigned long long)timestampMs) + "\n";
+}
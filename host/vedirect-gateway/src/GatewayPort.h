@@ -0,0 +1,100 @@
+/**
+ * GatewayPort.h
+ *
+ * One VE.Direct device on a Linux serial port: the fd, the firmware driver
+ * that parses it (VictronMPPT or VictronSmartShunt, unchanged), and the
+ * line-protocol snapshot written for each committed block.
+ *
+ * Snapshots use the measurements and fields of sendDataToInfluxDB() in
+ * solar-monitor, so gateway and ESP32 data land in the same series and
+ * dashboards; keep them in sync when main.cpp changes. Fields computed on
+ * the device (BatteryAnalytics, MPPT comparison) are not included.
+ */
+
+#ifndef GATEWAY_PORT_H
+#define GATEWAY_PORT_H
+
+#include <Arduino.h>
+#include <memory>
+
+#include "VictronMPPT.h"
+#include "VictronSmartShunt.h"
+
+// Stream over the bytes of one read(); the drivers consume it in update()
+class ChunkStream : public Stream {
+public:
+    void set(const uint8_t* data, size_t length) { _data = data; _length = length; _pos = 0; }
+
+    int available() override { return (int)(_length - _pos); }
+    int read() override { return _pos < _length ? _data[_pos++] : -1; }
+    int peek() override { return _pos < _length ? _data[_pos] : -1; }
+    size_t write(uint8_t c) override { (void)c; return 1; }
+    using Print::write;
+
+private:
+    const uint8_t* _data = nullptr;
+    size_t _length = 0;
+    size_t _pos = 0;
+};
+
+class GatewayPort {
+public:
+    enum class Kind { Mppt, Shunt };
+
+    static const unsigned long REOPEN_INTERVAL_MS = 5000;
+
+    /**
+     * @param index MPPT number for the mppt= tag (1, 2, ...), ignored for a shunt
+     */
+    GatewayPort(Kind kind, const String& path, uint8_t index);
+    ~GatewayPort();
+
+    /**
+     * @brief Open the tty (raw 19200 8N1). Retried by the caller every
+     * REOPEN_INTERVAL_MS while it fails (USB adapter unplugged).
+     */
+    bool open();
+    void close();
+    bool isOpen() const { return _fd >= 0; }
+    int getFd() const { return _fd; }
+
+    /**
+     * @brief Read everything waiting on the fd and parse it
+     * @return Blocks committed by the driver (0 if none completed); the port
+     *         closes itself on hangup or a read error
+     */
+    uint32_t service();
+
+    /**
+     * @brief Append the current readings as one line-protocol line
+     * @param timestampMs Unix time in ms (written with precision=ms)
+     */
+    void appendSnapshot(String& data, const String& deviceTag, const String& location,
+                        uint64_t timestampMs) const;
+
+    Kind getKind() const { return _kind; }
+    const String& getPath() const { return _path; }
+    const char* getName() const;        // "shunt", "mppt1", ...
+    bool isDataValid() const;
+    uint32_t getBlockCount() const;
+    uint32_t getChecksumErrors() const;
+    uint64_t getBytesRead() const { return _bytesRead; }
+    uint32_t getOpenFailures() const { return _openFailures; }
+    unsigned long getLastOpenAttempt() const { return _lastOpenAttempt; }
+
+private:
+    Kind _kind;
+    String _path;
+    uint8_t _index;
+    char _name[12];
+    int _fd = -1;
+    ChunkStream _stream;
+    std::unique_ptr<VictronMPPT> _mppt;
+    std::unique_ptr<VictronSmartShunt> _shunt;
+    uint32_t _lastBlockCount = 0;
+    uint64_t _bytesRead = 0;
+    uint32_t _openFailures = 0;
+    unsigned long _lastOpenAttempt = 0;
+};
+
+#endif // GATEWAY_PORT_H
@@ -0,0 +1,4 @@
+// Firmware modules compiled into the gateway unchanged (PlatformIO only
+// builds sources under src/, so they are pulled in from their projects here).
+#include "../../../solar-monitor/src/VictronMPPT.cpp"
+#include "../../../solar-monitor/src/VictronSmartShunt.cpp"
@@ -0,0 +1,615 @@
+/**
+ * VE.Direct gateway
+ *
+ * Reads Victron MPPT chargers and SmartShunts on Linux serial ports (e.g. a
+ * Raspberry Pi with VE.Direct USB cables) with the solar-monitor drivers,
+ * multiplexes all ports in one epoll loop, and publishes a line-protocol
+ * snapshot per committed block in batches to MQTT or InfluxDB.
+ *
+ * For tests and benchmarks, --replay and --synthetic create pseudo-terminals
+ * and write captured or generated VE.Direct text into them from the same
+ * loop; the gateway reads the slave side through termios like a device and
+ * checks every intact block in the input was committed.
+ *
+ * Usage:
+ *   pio run -e native
+ *   .pio/build/native/program --device shed --port shunt:/dev/ttyUSB0 --port mppt:/dev/ttyUSB1 \
+ *       --mqtt 127.0.0.1:1883
+ *   .pio/build/native/program --replay mppt:mppt.txt --replay shunt:shunt.txt --duration 10
+ *   .pio/build/native/program --synthetic 16 --interval-ms 0 --duration 10
+ */
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include <errno.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "BatchPublisher.h"
+#include "GatewayPort.h"
+#include "serial_port.h"
+
+static const uint32_t FEEDER_FLAG = 0x80000000UL;
+static const size_t FEEDER_LOW_WATER = 16384;       // Unpaced feeders keep this much queued
+static const unsigned long DRAIN_MS = 300;          // After feeding stops, before counting
+
+struct GatewayOptions {
+    String device;
+    String location = "garage";
+    String topicBase = "esp-sensor-hub";
+    unsigned long intervalMs = 1000;    // Minimum spacing of snapshots per port (0 = every block)
+    uint32_t durationSeconds = 0;       // 0 = until SIGINT/SIGTERM (10 with --replay/--synthetic)
+    uint32_t reportSeconds = 10;
+    unsigned long rateMs = 0;           // Replay pacing: one block per port per rateMs (0 = flat out)
+    unsigned long seed = 1;
+};
+
+// Replayed input for one pty: intact blocks written round-robin into the master
+struct Feeder {
+    int masterFd = -1;
+    std::vector<std::string> blocks;
+    std::vector<bool> commits;          // Block carries enough fields for the driver to commit it
+    size_t next = 0;
+    std::string out;
+    size_t outPos = 0;
+    bool wantWrite = false;
+    uint64_t blocksQueued = 0;
+    uint64_t commitsQueued = 0;
+    unsigned long lastBlockMs = 0;
+};
+
+struct PortSpec {
+    GatewayPort::Kind kind;
+    String source;                      // Device path, capture file, or empty (synthetic)
+};
+
+static volatile sig_atomic_t s_stop = 0;
+
+static void onSignal(int) {
+    s_stop = 1;
+}
+
+static uint64_t unixTimeMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000ULL + ts.tv_nsec / 1000000;
+}
+
+static double cpuSeconds() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec
+        + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+// ============================================================================
+// Replay input
+// ============================================================================
+
+// VE.Direct block with a valid checksum (all bytes sum to 0 mod 256)
+static std::string buildBlock(const std::vector<std::pair<std::string, std::string>>& fields) {
+    std::string block;
+    for (const auto& field : fields) {
+        block += "\r\n" + field.first + "\t" + field.second;
+    }
+    block += "\r\nChecksum\t";
+    uint8_t sum = 0;
+    for (char c : block) {
+        sum += (uint8_t)c;
+    }
+    block += (char)(uint8_t)(256 - sum);
+    return block;
+}
+
+static std::vector<std::string> syntheticBlocks(GatewayPort::Kind kind, uint32_t count) {
+    std::vector<std::string> blocks;
+    float soc = 60.0f + random(400) / 10.0f;
+    for (uint32_t i = 0; i < count; i++) {
+        int batteryMv = 12800 + (int)random(600);
+        if (kind == GatewayPort::Kind::Shunt) {
+            int currentMa = (int)random(-8000, 12000);
+            soc = constrain(soc + currentMa / 3600000.0f, 0.0f, 100.0f);
+            blocks.push_back(buildBlock({
+                {"PID", "0xA389"}, {"V", std::to_string(batteryMv)}, {"I", std::to_string(currentMa)},
+                {"P", std::to_string(batteryMv / 1000 * currentMa / 1000)}, {"CE", "-12500"},
+                {"SOC", std::to_string((int)(soc * 10))}, {"TTG", "5460"}, {"Alarm", "OFF"}, {"Relay", "OFF"},
+                {"AR", "0"}, {"BMV", "SmartShunt 500A/50mV"}, {"FW", "0413"}, {"MON", "0"}
+            }));
+            blocks.push_back(buildBlock({
+                {"H1", "-61234"}, {"H2", "-12500"}, {"H4", "142"}, {"H7", "11020"}, {"H8", "14650"}
+            }));
+        } else {
+            int ppv = (int)random(0, 400);
+            blocks.push_back(buildBlock({
+                {"PID", "0xA060"}, {"FW", "159"}, {"SER#", "HQ2222ABCDE"}, {"V", std::to_string(batteryMv)},
+                {"I", std::to_string(ppv * 1000 / 13)}, {"VPV", std::to_string(30000 + (int)random(8000))},
+                {"PPV", std::to_string(ppv)}, {"CS", ppv > 0 ? "3" : "0"}, {"MPPT", "2"},
+                {"OR", "0x00000000"}, {"ERR", "0"}, {"LOAD", "ON"}, {"IL", "300"},
+                {"H19", "10234"}, {"H20", std::to_string(i % 500)}, {"H21", "412"},
+                {"H22", "98"}, {"H23", "388"}, {"HSDS", "214"}
+            }));
+        }
+    }
+    return blocks;
+}
+
+/**
+ * Split a raw capture into blocks ending at their checksum byte. Only intact
+ * blocks are kept, so the capture loops cleanly and every block written is
+ * one the driver must commit (a capture that starts mid-block loses its head).
+ */
+static std::vector<std::string> captureBlocks(const std::string& capture) {
+    std::vector<std::string> blocks;
+    static const char MARKER[] = "\r\nChecksum\t";
+    size_t start = capture.find("\r\n");
+    while (start != std::string::npos) {
+        size_t marker = capture.find(MARKER, start);
+        if (marker == std::string::npos || marker + sizeof(MARKER) - 1 >= capture.size()) {
+            break;
+        }
+        size_t end = marker + sizeof(MARKER);   // Through the checksum byte
+        uint8_t sum = 0;
+        for (size_t i = start; i < end; i++) {
+            sum += (uint8_t)capture[i];
+        }
+        if (sum == 0) {
+            blocks.push_back(capture.substr(start, end - start));
+        }
+        start = capture.find("\r\n", end);
+    }
+    return blocks;
+}
+
+// History-only blocks (SmartShunt H1..H18) update the driver without committing
+static std::vector<bool> committingBlocks(GatewayPort::Kind kind, const std::vector<std::string>& blocks) {
+    ChunkStream stream;
+    VictronMPPT mppt(&stream);
+    VictronSmartShunt shunt(&stream);
+    std::vector<bool> commits;
+    for (const std::string& block : blocks) {
+        stream.set((const uint8_t*)block.data(), block.size());
+        uint32_t before;
+        if (kind == GatewayPort::Kind::Mppt) {
+            before = mppt.getBlockCount();
+            mppt.update();
+            commits.push_back(mppt.getBlockCount() != before);
+        } else {
+            before = shunt.getBlockCount();
+            shunt.update();
+            commits.push_back(shunt.getBlockCount() != before);
+        }
+    }
+    return commits;
+}
+
+static bool readFile(const String& path, std::string& data) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    char buffer[8192];
+    size_t length;
+    while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data.append(buffer, length);
+    }
+    fclose(file);
+    return true;
+}
+
+static void queueBlock(Feeder& feeder) {
+    feeder.out += feeder.blocks[feeder.next];
+    feeder.commitsQueued += feeder.commits[feeder.next];
+    feeder.blocksQueued++;
+    feeder.next = (feeder.next + 1) % feeder.blocks.size();
+}
+
+static void refillFeeder(Feeder& feeder, unsigned long now, unsigned long rateMs) {
+    if (feeder.outPos >= FEEDER_LOW_WATER || (feeder.outPos > 0 && feeder.outPos == feeder.out.size())) {
+        feeder.out.erase(0, feeder.outPos);
+        feeder.outPos = 0;
+    }
+    if (rateMs > 0) {
+        if (now - feeder.lastBlockMs < rateMs) {
+            return;
+        }
+        feeder.lastBlockMs = now;
+        queueBlock(feeder);
+        return;
+    }
+    while (feeder.out.size() - feeder.outPos < FEEDER_LOW_WATER) {
+        queueBlock(feeder);
+    }
+}
+
+static void writeFeeder(Feeder& feeder) {
+    while (feeder.outPos < feeder.out.size()) {
+        ssize_t written = write(feeder.masterFd, feeder.out.data() + feeder.outPos, feeder.out.size() - feeder.outPos);
+        if (written <= 0) {
+            break;  // pty buffer full: EPOLLOUT resumes
+        }
+        feeder.outPos += written;
+    }
+}
+
+// Level-triggered EPOLLOUT only while there is something to write
+static void armFeeder(int epollFd, Feeder& feeder, uint32_t id) {
+    bool want = feeder.outPos < feeder.out.size();
+    if (want == feeder.wantWrite) {
+        return;
+    }
+    feeder.wantWrite = want;
+    struct epoll_event ev = {};
+    ev.events = want ? (uint32_t)EPOLLOUT : 0;
+    ev.data.u32 = id | FEEDER_FLAG;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, feeder.masterFd, &ev);
+}
+
+// ============================================================================
+// Options
+// ============================================================================
+
+static void printUsage() {
+    printf("Usage: program [--port mppt|shunt:/dev/ttyX]... [--replay mppt|shunt:capture.txt]...\n"
+           "               [--synthetic N] [--rate-ms MS] [--device NAME] [--location NAME]\n"
+           "               [--mqtt host:port] [--topic-base BASE]\n"
+           "               [--influx host:port --org ORG --bucket BUCKET --token TOKEN] [--stdout]\n"
+           "               [--interval-ms MS] [--batch-bytes N] [--batch-ms MS]\n"
+           "               [--duration S] [--report S] [--seed N]\n");
+}
+
+static bool parsePortSpec(const String& value, PortSpec& spec) {
+    int colon = value.indexOf(':');
+    String kind = colon >= 0 ? value.substring(0, colon) : "";
+    if (kind == "mppt") {
+        spec.kind = GatewayPort::Kind::Mppt;
+    } else if (kind == "shunt") {
+        spec.kind = GatewayPort::Kind::Shunt;
+    } else {
+        return false;
+    }
+    spec.source = value.substring(colon + 1);
+    return spec.source.length() > 0;
+}
+
+static void parseHostPort(const String& value, String& host, uint16_t& port) {
+    int colon = value.indexOf(':');
+    host = colon >= 0 ? value.substring(0, colon) : value;
+    if (colon >= 0) {
+        port = value.substring(colon + 1).toInt();
+    }
+}
+
+static bool parseArgs(int argc, char** argv, GatewayOptions& options, BatchPublisher::Config& config,
+                      std::vector<PortSpec>& devices, std::vector<PortSpec>& replays, uint32_t& synthetic) {
+    for (int i = 1; i < argc; i++) {
+        String arg = argv[i];
+        if (arg == "--stdout") {
+            config.target = BatchPublisher::Target::Stdout;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            printUsage();
+            return false;
+        }
+        String value = argv[++i];
+        PortSpec spec;
+        if (arg == "--port" || arg == "--replay") {
+            if (!parsePortSpec(value, spec)) {
+                printUsage();
+                return false;
+            }
+            (arg == "--port" ? devices : replays).push_back(spec);
+        } else if (arg == "--synthetic") {
+            synthetic = value.toInt();
+        } else if (arg == "--rate-ms") {
+            options.rateMs = value.toInt();
+        } else if (arg == "--device") {
+            options.device = value;
+        } else if (arg == "--location") {
+            options.location = value;
+        } else if (arg == "--mqtt") {
+            config.target = BatchPublisher::Target::Mqtt;
+            parseHostPort(value, config.host, config.port);
+        } else if (arg == "--topic-base") {
+            options.topicBase = value;
+        } else if (arg == "--influx") {
+            config.target = BatchPublisher::Target::Influx;
+            config.port = 8086;
+            parseHostPort(value, config.host, config.port);
+        } else if (arg == "--org") {
+            config.org = value;
+        } else if (arg == "--bucket") {
+            config.bucket = value;
+        } else if (arg == "--token") {
+            config.token = value;
+        } else if (arg == "--interval-ms") {
+            options.intervalMs = value.toInt();
+        } else if (arg == "--batch-bytes") {
+            config.maxBytes = value.toInt();
+        } else if (arg == "--batch-ms") {
+            config.maxAgeMs = value.toInt();
+        } else if (arg == "--duration") {
+            options.durationSeconds = value.toInt();
+        } else if (arg == "--report") {
+            options.reportSeconds = value.toInt();
+        } else if (arg == "--seed") {
+            options.seed = value.toInt();
+        } else {
+            printUsage();
+            return false;
+        }
+    }
+    if (devices.empty() && replays.empty() && synthetic == 0) {
+        printUsage();
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// Event loop
+// ============================================================================
+
+int main(int argc, char** argv) {
+    GatewayOptions options;
+    BatchPublisher::Config config;
+    std::vector<PortSpec> devices;
+    std::vector<PortSpec> replays;
+    uint32_t synthetic = 0;
+    if (!parseArgs(argc, argv, options, config, devices, replays, synthetic)) {
+        return 1;
+    }
+    randomSeed(options.seed);
+    WiFi.begin();  // Shim station: sockets go straight to the host network
+    bool replaying = !replays.empty() || synthetic > 0;
+    if (replaying && options.durationSeconds == 0) {
+        options.durationSeconds = 10;
+    }
+    if (options.device.length() == 0) {
+        char hostname[64] = "vedirect-gateway";
+        gethostname(hostname, sizeof(hostname) - 1);
+        options.device = hostname;
+    }
+    String deviceTag = options.device;
+    deviceTag.replace(" ", "_");
+    config.topic = options.topicBase + "/" + deviceTag + "/influx";
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    signal(SIGPIPE, SIG_IGN);
+
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0) {
+        perror("[GW] epoll_create1");
+        return 1;
+    }
+
+    // Ports: devices first, then a pty per replay/synthetic source
+    std::vector<std::unique_ptr<GatewayPort>> ports;
+    std::vector<Feeder> feeders;
+    std::vector<int> feederPort;
+    uint8_t mpptIndex = 0;
+    auto addPort = [&](GatewayPort::Kind kind, const String& path) {
+        uint8_t index = kind == GatewayPort::Kind::Mppt ? ++mpptIndex : 0;
+        ports.emplace_back(new GatewayPort(kind, path, index));
+    };
+    for (const PortSpec& spec : devices) {
+        addPort(spec.kind, spec.source);
+    }
+    for (uint32_t i = 0; i < replays.size() + synthetic; i++) {
+        Feeder feeder;
+        GatewayPort::Kind kind;
+        if (i < replays.size()) {
+            kind = replays[i].kind;
+            std::string capture;
+            if (!readFile(replays[i].source, capture)) {
+                printf("[GW] Cannot read %s\n", replays[i].source.c_str());
+                return 1;
+            }
+            feeder.blocks = captureBlocks(capture);
+        } else {
+            // Two chargers per shunt, like the solar-monitor hardware
+            kind = (i - replays.size()) % 3 == 0 ? GatewayPort::Kind::Shunt : GatewayPort::Kind::Mppt;
+            feeder.blocks = syntheticBlocks(kind, 64);
+        }
+        feeder.commits = committingBlocks(kind, feeder.blocks);
+        if (feeder.blocks.empty()) {
+            printf("[GW] %s: no intact VE.Direct blocks\n", replays[i].source.c_str());
+            return 1;
+        }
+        String slavePath;
+        if (!SerialPort::openPty(feeder.masterFd, slavePath)) {
+            perror("[GW] openpty");
+            return 1;
+        }
+        addPort(kind, slavePath);
+        feeders.push_back(std::move(feeder));
+        feederPort.push_back(ports.size() - 1);
+    }
+
+    // Slaves are raw (no echo) before the first byte is written to a master
+    for (uint32_t i = 0; i < ports.size(); i++) {
+        if (!ports[i]->open()) {
+            printf("[GW] %s: %s (retrying every %lu s)\n", ports[i]->getPath().c_str(), strerror(errno),
+                   GatewayPort::REOPEN_INTERVAL_MS / 1000);
+            continue;
+        }
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.u32 = i;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, ports[i]->getFd(), &ev);
+    }
+    for (uint32_t i = 0; i < feeders.size(); i++) {
+        struct epoll_event ev = {};
+        ev.events = 0;
+        ev.data.u32 = i | FEEDER_FLAG;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, feeders[i].masterFd, &ev);
+    }
+
+    BatchPublisher publisher(config);
+    publisher.begin();
+
+    printf("[GW] %u ports (%u devices, %u replayed) as device=%s, snapshots every %lu ms, batches %u B / %lu ms\n",
+           (unsigned)ports.size(), (unsigned)devices.size(), (unsigned)feeders.size(), deviceTag.c_str(),
+           options.intervalMs, (unsigned)config.maxBytes, config.maxAgeMs);
+
+    std::vector<unsigned long> lastSnapshot(ports.size(), 0);
+    std::vector<bool> snapshotted(ports.size(), false);
+    uint64_t frames = 0;
+    uint64_t reportFrames = 0;
+    String line;
+    line.reserve(1024);
+    struct epoll_event events[64];
+
+    unsigned long start = millis();
+    unsigned long lastReport = start;
+    double cpuStart = cpuSeconds();
+    bool feeding = replaying;
+    unsigned long feedingStoppedAt = 0;
+
+    while (!s_stop) {
+        unsigned long now = millis();
+        if (options.durationSeconds > 0 && feeding && now - start >= options.durationSeconds * 1000UL) {
+            feeding = false;
+            feedingStoppedAt = now;
+        }
+        if (replaying && !feeding) {
+            // Written blocks finish arriving before they are counted
+            bool drained = true;
+            for (const Feeder& feeder : feeders) {
+                drained = drained && feeder.outPos == feeder.out.size();
+            }
+            if (!drained) {
+                feedingStoppedAt = now;
+            } else if (now - feedingStoppedAt >= DRAIN_MS) {
+                break;
+            }
+        }
+        if (!replaying && options.durationSeconds > 0 && now - start >= options.durationSeconds * 1000UL) {
+            break;
+        }
+
+        for (uint32_t i = 0; i < feeders.size(); i++) {
+            if (feeding) {
+                refillFeeder(feeders[i], now, options.rateMs);
+            }
+            writeFeeder(feeders[i]);
+            armFeeder(epollFd, feeders[i], i);
+        }
+
+        int timeout = (int)min(publisher.getWaitMs(now), 100UL);
+        if (feeding && options.rateMs > 0) {
+            timeout = min(timeout, 5);
+        }
+        int count = epoll_wait(epollFd, events, 64, timeout);
+        if (count < 0 && errno != EINTR) {
+            perror("[GW] epoll_wait");
+            break;
+        }
+
+        uint64_t timestampMs = 0;
+        now = millis();
+        for (int e = 0; e < count; e++) {
+            uint32_t id = events[e].data.u32;
+            if (id & FEEDER_FLAG) {
+                writeFeeder(feeders[id & ~FEEDER_FLAG]);
+                continue;
+            }
+
+            GatewayPort& port = *ports[id];
+            uint32_t committed = port.service();
+            if (!port.isOpen()) {
+                printf("[GW] %s: closed, reopening\n", port.getPath().c_str());
+            }
+            if (committed == 0) {
+                continue;
+            }
+            frames += committed;
+            if (snapshotted[id] && options.intervalMs > 0 && now - lastSnapshot[id] < options.intervalMs) {
+                continue;
+            }
+            snapshotted[id] = true;
+            lastSnapshot[id] = now;
+            if (timestampMs == 0) {
+                timestampMs = unixTimeMs();
+            }
+            line = "";
+            port.appendSnapshot(line, deviceTag, options.location, timestampMs);
+            if (line.length() > 0) {
+                publisher.add(line, now);
+            }
+        }
+
+        publisher.service(now);
+
+        // Unplugged adapters come back as the same path
+        for (uint32_t i = 0; i < ports.size(); i++) {
+            GatewayPort& port = *ports[i];
+            if (port.isOpen() || now - port.getLastOpenAttempt() < GatewayPort::REOPEN_INTERVAL_MS) {
+                continue;
+            }
+            if (port.open()) {
+                struct epoll_event ev = {};
+                ev.events = EPOLLIN;
+                ev.data.u32 = i;
+                epoll_ctl(epollFd, EPOLL_CTL_ADD, port.getFd(), &ev);
+                printf("[GW] %s: reopened\n", port.getPath().c_str());
+            }
+        }
+
+        if (options.reportSeconds > 0 && now - lastReport >= options.reportSeconds * 1000UL) {
+            const BatchPublisher::Stats& stats = publisher.getStats();
+            printf("[GW] %6.1f frames/s | %llu lines, %u batches, %llu B sent | %u B queued | %llu dropped\n",
+                   (frames - reportFrames) * 1000.0 / (now - lastReport), (unsigned long long)stats.lines,
+                   stats.batches, (unsigned long long)stats.bytes, (unsigned)publisher.getPendingBytes(),
+                   (unsigned long long)stats.droppedLines);
+            reportFrames = frames;
+            lastReport = now;
+        }
+    }
+
+    publisher.flush(millis());
+    double elapsed = (millis() - start) / 1000.0;
+    double cpu = cpuSeconds() - cpuStart;
+    const BatchPublisher::Stats& stats = publisher.getStats();
+
+    printf("\n[GW] Summary: %.1f s, %llu frames, %.0f frames/s, %.2f CPU s (%.0f frames per CPU s, replay writes included)\n",
+           elapsed, (unsigned long long)frames, frames / elapsed, cpu, cpu > 0 ? frames / cpu : 0.0);
+    printf("[GW] Published %llu lines in %u batches (%llu B), %u failed sends, %llu dropped\n",
+           (unsigned long long)stats.lines, stats.batches, (unsigned long long)stats.bytes, stats.failures,
+           (unsigned long long)stats.droppedLines);
+
+    bool ok = true;
+    for (uint32_t i = 0; i < ports.size(); i++) {
+        GatewayPort& port = *ports[i];
+        printf("[GW]   %-6s %-14s %8llu B read, %7u blocks, %u checksum errors",
+               port.getName(), port.getPath().c_str(), (unsigned long long)port.getBytesRead(),
+               port.getBlockCount(), port.getChecksumErrors());
+        int feederIndex = -1;
+        for (uint32_t f = 0; f < feeders.size(); f++) {
+            if (feederPort[f] == (int)i) {
+                feederIndex = f;
+            }
+        }
+        if (feederIndex >= 0) {
+            // Every block written must arrive intact, and each one with data must be committed
+            const Feeder& feeder = feeders[feederIndex];
+            bool match = port.getBlockCount() == feeder.commitsQueued && port.getChecksumErrors() == 0;
+            ok = ok && match;
+            printf(", %llu written (%llu with data)%s", (unsigned long long)feeder.blocksQueued,
+                   (unsigned long long)feeder.commitsQueued, match ? "" : "  <-- MISMATCH");
+        }
+        printf("\n");
+    }
+    for (Feeder& feeder : feeders) {
+        close(feeder.masterFd);
+    }
+    close(epollFd);
+    return ok ? 0 : 2;
+}
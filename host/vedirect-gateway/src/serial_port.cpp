@@ -0,0 +1,67 @@
+/**
+ * serial_port.cpp
+ *
+ * Implementation of termios serial ports and pseudo-terminal pairs
+ */
+
+#include "serial_port.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace SerialPort {
+    static speed_t toSpeed(uint32_t baud) {
+        switch (baud) {
+            case 9600: return B9600;
+            case 38400: return B38400;
+            case 57600: return B57600;
+            case 115200: return B115200;
+            default: return B19200;
+        }
+    }
+
+    int open(const char* path, uint32_t baud) {
+        int fd = ::open(path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) {
+            return -1;
+        }
+
+        struct termios tio;
+        if (tcgetattr(fd, &tio) != 0) {
+            ::close(fd);
+            return -1;
+        }
+        // Raw bytes: VE.Direct checksums cover every byte, CRs included
+        cfmakeraw(&tio);
+        tio.c_cflag |= CLOCAL | CREAD;
+        tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+        tio.c_iflag &= ~(IXON | IXOFF | IXANY);
+        tio.c_cc[VMIN] = 1;
+        tio.c_cc[VTIME] = 0;
+        cfsetispeed(&tio, toSpeed(baud));
+        cfsetospeed(&tio, toSpeed(baud));
+        if (tcsetattr(fd, TCSANOW, &tio) != 0) {
+            ::close(fd);
+            return -1;
+        }
+        tcflush(fd, TCIFLUSH);
+        return fd;
+    }
+
+    bool openPty(int& masterFd, String& slavePath) {
+        masterFd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+        if (masterFd < 0) {
+            return false;
+        }
+        char name[64];
+        if (grantpt(masterFd) != 0 || unlockpt(masterFd) != 0 || ptsname_r(masterFd, name, sizeof(name)) != 0) {
+            ::close(masterFd);
+            masterFd = -1;
+            return false;
+        }
+        slavePath = name;
+        return true;
+    }
+}
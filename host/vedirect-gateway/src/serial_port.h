@@ -0,0 +1,33 @@
+/**
+ * serial_port.h
+ *
+ * Linux serial ports for VE.Direct: raw 19200 8N1 through termios, opened
+ * non-blocking for epoll. Pseudo-terminals stand in for devices when
+ * replaying captures; the gateway opens their slave side like any tty, so
+ * the same termios path is exercised.
+ */
+
+#ifndef SERIAL_PORT_H
+#define SERIAL_PORT_H
+
+#include <Arduino.h>
+
+namespace SerialPort {
+    static const uint32_t VEDIRECT_BAUD = 19200;
+
+    /**
+     * @brief Open a tty in raw mode, non-blocking
+     * @return File descriptor, or -1 (errno set)
+     */
+    int open(const char* path, uint32_t baud = VEDIRECT_BAUD);
+
+    /**
+     * @brief Create a pseudo-terminal pair
+     * @param masterFd Receives the master side (non-blocking); bytes written
+     *        here arrive on the slave like bytes from a device
+     * @param slavePath Receives the slave device path to pass to open()
+     */
+    bool openPty(int& masterFd, String& slavePath);
+}
+
+#endif // SERIAL_PORT_H
@@ -0,0 +1,235 @@
+/**
+ * BatteryAnalytics.cpp
+ *
+ * Implementation of the battery state-of-health and time-to-go estimator
+ */
+
+#include "BatteryAnalytics.h"
+
+static const uint32_t STATE_MAGIC = 0x31544142;     // "BAT1"
+
+static const float FULL_SOC = 99.95f;               // SmartShunt resyncs to 100.0% when full
+static const float FULL_REARM_SOC = 99.0f;          // Must drop below this before the next full event
+static const uint32_t MAX_SAMPLE_GAP_MS = 300000;   // Longer gaps are not integrated
+static const float EMPTY_CONFIRM_S = 60.0f;         // Voltage must stay at/below empty this long
+static const float MIN_EMPTY_DEPTH = 0.1f;          // Fraction of nominal before empty is believed
+static const float CAPACITY_ALPHA = 0.3f;           // Weight of a new capacity sample (steady state)
+static const float LOAD_TAU_S = 300.0f;             // Recent-load EWMA time constant
+static const float PROFILE_ALPHA = 0.25f;           // Weight of a new day in an hour bin
+static const float MIN_HOUR_COVERAGE_S = 1800.0f;   // Hour must be half observed to be learned
+static const uint32_t FORECAST_INTERVAL_MS = 60000;
+static const int FORECAST_STEP_MIN = 15;
+static const int FORECAST_HORIZON_MIN = 7 * 24 * 60;
+
+BatteryAnalytics::BatteryAnalytics(float nominalCapacityAh, float emptyVoltage)
+    : _nominalAh(nominalCapacityAh)
+    , _emptyVoltage(emptyVoltage)
+    , _stateChanged(false)
+    , _cycleTracked(false)
+    , _emptyReached(false)
+    , _wasFull(false)
+    , _depthAh(0)
+    , _maxDepthAh(0)
+    , _belowEmptySeconds(0)
+    , _soc(0)
+    , _hasSample(false)
+    , _lastTimestampMs(0)
+    , _loadCurrent(0)
+    , _profileHour(-1)
+    , _hourChargeAs(0)
+    , _hourSeconds(0)
+    , _hasForecast(false)
+    , _lastForecastMs(0)
+    , _timeToGo(-1)
+{
+    memset(&_state, 0, sizeof(_state));
+    _state.magic = STATE_MAGIC;
+    _state.capacityAh = nominalCapacityAh;
+}
+
+void BatteryAnalytics::update(uint32_t timestampMs, float voltage, float current, float soc, int32_t secondsOfDay) {
+    int8_t hour = secondsOfDay >= 0 ? (int8_t)((secondsOfDay / 3600) % PROFILE_BINS) : -1;
+    _soc = soc;
+
+    uint32_t dtMs = timestampMs - _lastTimestampMs;
+    if (!_hasSample) {
+        _loadCurrent = current;
+        _profileHour = hour;
+    } else if (dtMs > 0 && dtMs <= MAX_SAMPLE_GAP_MS) {
+        float dt = dtMs / 1000.0f;
+
+        // Coulomb counting: depth below the last full charge
+        if (_cycleTracked) {
+            _depthAh -= current * dt / 3600.0f;
+            if (_depthAh < 0) {
+                _depthAh = 0;  // Charging at full; the next full event resyncs anyway
+            }
+            _maxDepthAh = max(_maxDepthAh, _depthAh);
+        }
+
+        _loadCurrent += (current - _loadCurrent) * dt / (LOAD_TAU_S + dt);
+
+        if (hour != _profileHour) {
+            foldProfileHour();
+            _profileHour = hour;
+        }
+        if (hour >= 0) {
+            _hourChargeAs += current * dt;
+            _hourSeconds += dt;
+        }
+
+        // End of a full cycle: loaded voltage held at/below empty
+        if (_cycleTracked && !_emptyReached && current < 0 && voltage <= _emptyVoltage) {
+            _belowEmptySeconds += dt;
+            if (_belowEmptySeconds >= EMPTY_CONFIRM_S && _depthAh >= MIN_EMPTY_DEPTH * _nominalAh) {
+                addCapacitySample(_depthAh);
+                _emptyReached = true;
+            }
+        } else {
+            _belowEmptySeconds = 0;
+        }
+    }
+    _hasSample = true;
+    _lastTimestampMs = timestampMs;
+
+    // Full charge closes the cycle. A partial cycle that delivered more than
+    // the estimate proves the estimate too low.
+    bool full = soc >= FULL_SOC;
+    if (full && !_wasFull) {
+        if (_cycleTracked && !_emptyReached && _maxDepthAh > _state.capacityAh) {
+            addCapacitySample(_maxDepthAh);
+        }
+        if (_state.fullCharges < 0xFFFF) {
+            _state.fullCharges++;
+        }
+        _stateChanged = true;
+        _cycleTracked = true;
+        _emptyReached = false;
+        _depthAh = 0;
+        _maxDepthAh = 0;
+        _belowEmptySeconds = 0;
+        _wasFull = true;
+    } else if (soc < FULL_REARM_SOC) {
+        _wasFull = false;
+    }
+
+    if (!_hasForecast || timestampMs - _lastForecastMs >= FORECAST_INTERVAL_MS) {
+        _timeToGo = forecastTimeToGo(secondsOfDay);
+        _lastForecastMs = timestampMs;
+        _hasForecast = true;
+    }
+}
+
+// Running mean for the first samples (the nominal value is only a prior),
+// exponential average after that so ageing is tracked
+void BatteryAnalytics::addCapacitySample(float capacityAh) {
+    float weight = max(CAPACITY_ALPHA, 1.0f / (_state.capacitySamples + 1));
+    _state.capacityAh += weight * (capacityAh - _state.capacityAh);
+    if (_state.capacitySamples < 0xFFFF) {
+        _state.capacitySamples++;
+    }
+    _stateChanged = true;
+}
+
+// Fold the hour just finished into its profile bin
+void BatteryAnalytics::foldProfileHour() {
+    if (_profileHour >= 0 && _hourSeconds >= MIN_HOUR_COVERAGE_S) {
+        float mean = _hourChargeAs / _hourSeconds;
+        uint8_t& days = _state.profileDays[_profileHour];
+        float& bin = _state.profileCurrent[_profileHour];
+        bin = days == 0 ? mean : bin + PROFILE_ALPHA * (mean - bin);
+        if (days < 0xFF) {
+            days++;
+        }
+        _stateChanged = true;
+    }
+    _hourChargeAs = 0;
+    _hourSeconds = 0;
+}
+
+// Walk forward in 15 min steps: recent load for the first hour (fading into
+// the profile), the learned profile after that. Charging refills up to capacity.
+int BatteryAnalytics::forecastTimeToGo(int32_t secondsOfDay) const {
+    float remaining = _cycleTracked ? _state.capacityAh - _depthAh : _state.capacityAh * _soc / 100.0f;
+    if (remaining <= 0) {
+        return 0;
+    }
+
+    for (int minute = 0; minute < FORECAST_HORIZON_MIN; minute += FORECAST_STEP_MIN) {
+        float expected = _loadCurrent;
+        if (secondsOfDay >= 0) {
+            uint8_t hour = ((secondsOfDay + minute * 60) / 3600) % PROFILE_BINS;
+            if (isProfileLearned(hour)) {
+                float recentWeight = minute < 60 ? 1.0f - minute / 60.0f : 0.0f;
+                expected = recentWeight * _loadCurrent + (1.0f - recentWeight) * _state.profileCurrent[hour];
+            }
+        }
+
+        float stepAh = expected * FORECAST_STEP_MIN / 60.0f;
+        if (stepAh < 0 && -stepAh >= remaining) {
+            return minute + (int)(remaining / -expected * 60.0f);
+        }
+        remaining = min(remaining + stepAh, _state.capacityAh);
+    }
+    return -1;
+}
+
+float BatteryAnalytics::getCapacityAh() const {
+    return _state.capacityAh;
+}
+
+float BatteryAnalytics::getStateOfHealth() const {
+    return _nominalAh > 0 ? _state.capacityAh / _nominalAh * 100.0f : 0;
+}
+
+uint16_t BatteryAnalytics::getCapacitySamples() const {
+    return _state.capacitySamples;
+}
+
+uint16_t BatteryAnalytics::getFullCharges() const {
+    return _state.fullCharges;
+}
+
+float BatteryAnalytics::getDepthAh() const {
+    return _depthAh;
+}
+
+bool BatteryAnalytics::isCycleTracked() const {
+    return _cycleTracked;
+}
+
+float BatteryAnalytics::getLoadCurrent() const {
+    return _loadCurrent;
+}
+
+float BatteryAnalytics::getProfileCurrent(uint8_t hour) const {
+    return hour < PROFILE_BINS ? _state.profileCurrent[hour] : 0;
+}
+
+bool BatteryAnalytics::isProfileLearned(uint8_t hour) const {
+    return hour < PROFILE_BINS && _state.profileDays[hour] > 0;
+}
+
+int BatteryAnalytics::getTimeToGo() const {
+    return _timeToGo;
+}
+
+void BatteryAnalytics::saveState(State& state) {
+    state = _state;
+    _stateChanged = false;
+}
+
+bool BatteryAnalytics::restoreState(const State& state) {
+    // Reject foreign data and estimates far outside anything plausible
+    if (state.magic != STATE_MAGIC
+        || !(state.capacityAh >= 0.2f * _nominalAh && state.capacityAh <= 1.5f * _nominalAh)) {
+        return false;
+    }
+    _state = state;
+    _stateChanged = false;
+    return true;
+}
+
+bool BatteryAnalytics::stateChanged() const {
+    return _stateChanged;
+}
@@ -0,0 +1,113 @@
+/**
+ * BatteryAnalytics.h
+ *
+ * Battery state-of-health and time-to-go estimation from SmartShunt data
+ *
+ * Capacity: the charge removed since the last full charge is coulomb-counted
+ * from the current samples. A cycle that runs down to the empty voltage gives
+ * a direct usable-capacity sample; a partial cycle deeper than the current
+ * estimate raises it. Samples are blended into a running estimate, and
+ * state of health is that estimate relative to the nominal capacity.
+ *
+ * Time to go: discharge current is learned per hour of day (UTC) as an
+ * exponentially weighted profile, so the forecast knows that the evening
+ * load is heavier and that the sun comes back in the morning. The first hour
+ * follows the recent load; later hours follow the profile. Without a wall
+ * clock, the recent load alone is used.
+ *
+ * Pure math, no hardware or Arduino dependencies beyond types, so the same
+ * code runs on recorded traces in the native build.
+ */
+
+#ifndef BATTERY_ANALYTICS_H
+#define BATTERY_ANALYTICS_H
+
+#include <Arduino.h>
+
+class BatteryAnalytics {
+public:
+    static const uint8_t PROFILE_BINS = 24;     // One bin per hour of day
+
+    // Persistent part of the estimator (stored by the caller, e.g. in NVS)
+    struct State {
+        uint32_t magic;
+        float capacityAh;                       // Usable capacity estimate
+        uint16_t capacitySamples;               // Cycles that contributed to it
+        uint16_t fullCharges;                   // Full-charge events seen
+        float profileCurrent[PROFILE_BINS];     // Mean net current per hour (A, negative = discharge)
+        uint8_t profileDays[PROFILE_BINS];      // Hours folded into each bin (saturates)
+    };
+
+    /**
+     * Constructor
+     * @param nominalCapacityAh Rated capacity (same as the SmartShunt setting)
+     * @param emptyVoltage Loaded voltage treated as empty (end of a full cycle)
+     */
+    BatteryAnalytics(float nominalCapacityAh, float emptyVoltage);
+
+    /**
+     * Feed one SmartShunt sample
+     * @param timestampMs Monotonic time of the sample (wraps like millis())
+     * @param voltage Battery voltage (V)
+     * @param current Battery current (A, negative = discharge)
+     * @param soc SmartShunt state of charge (%), used to detect full charges
+     * @param secondsOfDay UTC seconds since midnight, -1 if the clock is not set
+     */
+    void update(uint32_t timestampMs, float voltage, float current, float soc, int32_t secondsOfDay);
+
+    // Capacity / health
+    float getCapacityAh() const;            // Usable capacity estimate
+    float getStateOfHealth() const;         // Capacity estimate vs nominal (%)
+    uint16_t getCapacitySamples() const;    // 0 = still at the nominal value
+    uint16_t getFullCharges() const;
+    float getDepthAh() const;               // Charge removed since the last full charge (Ah)
+    bool isCycleTracked() const;            // False until the first full charge is seen
+
+    // Load / time to go
+    float getLoadCurrent() const;           // Recent net current, ~5 min EWMA (A)
+    float getProfileCurrent(uint8_t hour) const;
+    bool isProfileLearned(uint8_t hour) const;
+    int getTimeToGo() const;                // Forecast minutes until empty, -1 = not within 7 days
+
+    // Persistence: stateChanged() turns true when a capacity sample or profile
+    // hour was folded in since the last saveState()
+    void saveState(State& state);
+    bool restoreState(const State& state);
+    bool stateChanged() const;
+
+private:
+    void addCapacitySample(float capacityAh);
+    void foldProfileHour();
+    int forecastTimeToGo(int32_t secondsOfDay) const;
+
+    float _nominalAh;
+    float _emptyVoltage;
+
+    // Capacity tracking
+    State _state;
+    bool _stateChanged;
+    bool _cycleTracked;
+    bool _emptyReached;
+    bool _wasFull;
+    float _depthAh;
+    float _maxDepthAh;
+    float _belowEmptySeconds;
+    float _soc;
+
+    // Sampling
+    bool _hasSample;
+    uint32_t _lastTimestampMs;
+    float _loadCurrent;
+
+    // Current hour being accumulated for the profile
+    int8_t _profileHour;
+    float _hourChargeAs;                // Ampere-seconds
+    float _hourSeconds;
+
+    // Forecast, refreshed once a minute
+    bool _hasForecast;
+    uint32_t _lastForecastMs;
+    int _timeToGo;
+};
+
+#endif // BATTERY_ANALYTICS_H
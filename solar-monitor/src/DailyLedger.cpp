@@ -0,0 +1,310 @@
+/**
+ * DailyLedger.cpp
+ *
+ * Implementation of the persistent daily energy ledger
+ */
+
+#include "DailyLedger.h"
+
+static const uint32_t LEDGER_MAGIC = 0x31594144;        // "DAY1"
+static const uint32_t MAX_SAMPLE_GAP_MS = 300000;       // Longer gaps are not integrated
+static const uint32_t ROLLOVER_GUARD_MS = 6UL * 3600000UL;  // Second charger's rollover patches the same day
+
+static uint16_t toUnits(float value, float scale) {
+    float scaled = value * scale + 0.5f;
+    if (scaled <= 0) {
+        return 0;
+    }
+    return scaled >= 65535.0f ? 65535 : (uint16_t)scaled;
+}
+
+DailyLedger::DailyLedger(fs::FS& fs, const char* path)
+    : _fs(fs)
+    , _path(path)
+    , _open(false)
+    , _lastCloseMs(0)
+    , _closedDays(0)
+{
+    memset(&_header, 0, sizeof(_header));
+    memset(&_today, 0, sizeof(_today));
+    memset(&_newest, 0, sizeof(_newest));
+}
+
+bool DailyLedger::begin() {
+    _open = false;
+    _lastCloseMs = millis();  // Pending rollovers restored below expire relative to boot
+
+    File file = _fs.open(_path, "r");
+    if (file) {
+        bool valid = file.size() == slotOffset(CAPACITY)
+            && file.read((uint8_t*)&_header, sizeof(_header)) == sizeof(_header)
+            && _header.magic == LEDGER_MAGIC
+            && _header.daySize == sizeof(Day)
+            && _header.snapshotSize == sizeof(Snapshot)
+            && _header.capacity == CAPACITY
+            && _header.head < CAPACITY
+            && _header.count <= CAPACITY
+            && file.read((uint8_t*)&_today, sizeof(_today)) == sizeof(_today);
+        if (valid && _header.count > 0) {
+            valid = file.seek(slotOffset(_header.head))
+                && file.read((uint8_t*)&_newest, sizeof(_newest)) == sizeof(_newest);
+        }
+        file.close();
+
+        if (valid) {
+            bool inProgress = false;
+            for (Accumulator& acc : _today.acc) {
+                acc.hasSample = false;
+                inProgress = inProgress || acc.seen;
+            }
+            if (inProgress) {
+                _today.flags |= FLAG_RESTARTED;
+            }
+            _open = true;
+            return true;
+        }
+    }
+
+    // Missing or another format: start an empty ledger of the full size
+    memset(&_header, 0, sizeof(_header));
+    _header.magic = LEDGER_MAGIC;
+    _header.daySize = sizeof(Day);
+    _header.snapshotSize = sizeof(Snapshot);
+    _header.capacity = CAPACITY;
+    _header.head = CAPACITY - 1;
+    _header.count = 0;
+    memset(&_today, 0, sizeof(_today));
+    memset(&_newest, 0, sizeof(_newest));
+
+    file = _fs.open(_path, "w");
+    if (!file) {
+        return false;
+    }
+    Day empty;
+    memset(&empty, 0, sizeof(empty));
+    bool ok = file.write((const uint8_t*)&_header, sizeof(_header)) == sizeof(_header)
+        && file.write((const uint8_t*)&_today, sizeof(_today)) == sizeof(_today);
+    for (uint16_t slot = 0; ok && slot < CAPACITY; slot++) {
+        ok = file.write((const uint8_t*)&empty, sizeof(empty)) == sizeof(empty);
+    }
+    file.close();
+    _open = ok;
+    return ok;
+}
+
+void DailyLedger::accumulate(Accumulator& acc, uint32_t timestampMs, float voltage, float in, float out) {
+    if (voltage > 0) {
+        if (!acc.seen || voltage < acc.minVoltage) acc.minVoltage = voltage;
+        if (!acc.seen || voltage > acc.maxVoltage) acc.maxVoltage = voltage;
+    }
+    uint32_t dtMs = timestampMs - acc.lastMs;
+    if (acc.hasSample && dtMs <= MAX_SAMPLE_GAP_MS) {
+        float hours = dtMs / 3600000.0f;
+        acc.ahIn += in * hours;
+        acc.ahOut += out * hours;
+    }
+    acc.lastMs = timestampMs;
+    acc.hasSample = true;
+    acc.seen = true;
+}
+
+void DailyLedger::updateShunt(uint32_t timestampMs, float voltage, float current) {
+    accumulate(_today.acc[0], timestampMs, voltage, max(current, 0.0f), max(-current, 0.0f));
+    _today.flags |= FLAG_SHUNT;
+}
+
+void DailyLedger::updateCharger(uint8_t index, uint32_t timestampMs, const ChargerReading& reading, uint32_t unixTime) {
+    if (index >= CHARGERS) {
+        return;
+    }
+    ChargerTrack& track = _today.track[index];
+    if (track.pending && timestampMs - _lastCloseMs >= ROLLOVER_GUARD_MS) {
+        track.pending = false;  // Its rollover never came (charger offline)
+    }
+
+    uint16_t yieldToday = toUnits(reading.yieldToday, 100.0f);
+    uint16_t maxPowerToday = (uint16_t)constrain(reading.maxPowerToday, 0, 65535);
+    uint16_t yieldYesterday = toUnits(reading.yieldYesterday, 100.0f);
+    uint16_t maxPowerYesterday = (uint16_t)constrain(reading.maxPowerYesterday, 0, 65535);
+
+    // Rollover: HSDS moves, or H22/H23 shift and H20 restarts without it
+    bool changed = false;
+    if (track.valid) {
+        bool rolled;
+        if (reading.daySequence >= 0 && track.daySequence >= 0) {
+            rolled = reading.daySequence != track.daySequence;
+        } else {
+            rolled = yieldYesterday != track.yieldYesterday
+                || maxPowerYesterday != track.maxPowerYesterday
+                || yieldToday < track.yieldToday;
+        }
+        if (rolled) {
+            if (track.pending) {
+                patchNewest(index, reading);
+                track.pending = false;
+            } else {
+                closeDay(index, reading, timestampMs, unixTime);
+            }
+            changed = true;
+        }
+    }
+
+    track.valid = true;
+    track.daySequence = (int16_t)reading.daySequence;
+    track.yieldToday = yieldToday;
+    track.maxPowerToday = maxPowerToday;
+    track.yieldYesterday = yieldYesterday;
+    track.maxPowerYesterday = maxPowerYesterday;
+
+    accumulate(_today.acc[1 + index], timestampMs, reading.batteryVoltage,
+               max(reading.chargeCurrent, 0.0f), max(reading.loadCurrent, 0.0f));
+    _today.flags |= FLAG_MPPT1 << index;
+
+    // Persist the rollover at once so a restart does not close the day twice
+    if (changed) {
+        saveToday();
+    }
+}
+
+void DailyLedger::closeDay(uint8_t index, const ChargerReading& reading, uint32_t timestampMs, uint32_t unixTime) {
+    Day day = getToday();
+    day.closedAt = unixTime;
+    int16_t sequence = _today.track[index].daySequence;
+    day.daySequence = sequence >= 0 ? (uint16_t)sequence : 0xFFFF;
+    // The rolling charger reports the closed day exactly; the others report
+    // their final H20/H21 (night, no more yield) until their own rollover
+    day.mppt[index].yield = toUnits(reading.yieldYesterday, 100.0f);
+    day.mppt[index].maxPower = (uint16_t)constrain(reading.maxPowerYesterday, 0, 65535);
+
+    uint16_t slot = (_header.head + 1) % CAPACITY;
+    File file = _fs.open(_path, "r+");
+    if (file) {
+        if (writeSlot(file, slot, day)) {
+            _header.head = slot;
+            if (_header.count < CAPACITY) {
+                _header.count++;
+            }
+            writeHeader(file);
+            _newest = day;
+        }
+        file.close();
+    }
+
+    for (uint8_t other = 0; other < CHARGERS; other++) {
+        if (other != index) {
+            _today.track[other].pending = _today.track[other].valid;
+        }
+    }
+    resetToday();
+    _lastCloseMs = timestampMs;
+    _closedDays++;
+}
+
+void DailyLedger::patchNewest(uint8_t index, const ChargerReading& reading) {
+    if (_header.count == 0) {
+        return;
+    }
+    _newest.mppt[index].yield = toUnits(reading.yieldYesterday, 100.0f);
+    _newest.mppt[index].maxPower = (uint16_t)constrain(reading.maxPowerYesterday, 0, 65535);
+    File file = _fs.open(_path, "r+");
+    if (file) {
+        writeSlot(file, _header.head, _newest);
+        file.close();
+    }
+}
+
+// New day: accumulators restart, charger tracks carry over
+void DailyLedger::resetToday() {
+    for (Accumulator& acc : _today.acc) {
+        uint32_t lastMs = acc.lastMs;
+        bool hasSample = acc.hasSample;
+        memset(&acc, 0, sizeof(acc));
+        acc.lastMs = lastMs;
+        acc.hasSample = hasSample;
+    }
+    _today.flags = 0;
+}
+
+bool DailyLedger::saveToday() {
+    if (!_open) {
+        return false;
+    }
+    File file = _fs.open(_path, "r+");
+    if (!file) {
+        return false;
+    }
+    bool ok = file.seek(sizeof(FileHeader))
+        && file.write((const uint8_t*)&_today, sizeof(_today)) == sizeof(_today);
+    file.close();
+    return ok;
+}
+
+bool DailyLedger::writeHeader(File& file) {
+    return file.seek(0) && file.write((const uint8_t*)&_header, sizeof(_header)) == sizeof(_header);
+}
+
+bool DailyLedger::writeSlot(File& file, uint16_t slot, const Day& day) {
+    return file.seek(slotOffset(slot)) && file.write((const uint8_t*)&day, sizeof(day)) == sizeof(day);
+}
+
+uint32_t DailyLedger::slotOffset(uint16_t slot) {
+    return sizeof(FileHeader) + sizeof(Snapshot) + (uint32_t)slot * sizeof(Day);
+}
+
+DailyLedger::Battery DailyLedger::roundBattery(const Accumulator& acc) {
+    Battery battery;
+    memset(&battery, 0, sizeof(battery));
+    if (acc.seen) {
+        battery.minVoltage = toUnits(acc.minVoltage, 100.0f);
+        battery.maxVoltage = toUnits(acc.maxVoltage, 100.0f);
+        battery.ahIn = toUnits(acc.ahIn, 10.0f);
+        battery.ahOut = toUnits(acc.ahOut, 10.0f);
+    }
+    return battery;
+}
+
+uint16_t DailyLedger::getStoredDays() const {
+    return _header.count;
+}
+
+bool DailyLedger::getDay(uint16_t daysAgo, Day& day) {
+    if (!_open || daysAgo >= _header.count) {
+        return false;
+    }
+    if (daysAgo == 0) {
+        day = _newest;
+        return true;
+    }
+    File file = _fs.open(_path, "r");
+    if (!file) {
+        return false;
+    }
+    uint16_t slot = (_header.head + CAPACITY - daysAgo) % CAPACITY;
+    bool ok = file.seek(slotOffset(slot)) && file.read((uint8_t*)&day, sizeof(day)) == sizeof(day);
+    file.close();
+    return ok;
+}
+
+DailyLedger::Day DailyLedger::getToday() const {
+    Day day;
+    memset(&day, 0, sizeof(day));
+    day.daySequence = 0xFFFF;
+    day.flags = _today.flags;
+    day.shunt = roundBattery(_today.acc[0]);
+    for (uint8_t i = 0; i < CHARGERS; i++) {
+        const ChargerTrack& track = _today.track[i];
+        day.mppt[i].battery = roundBattery(_today.acc[1 + i]);
+        if (track.valid && !track.pending) {
+            day.mppt[i].yield = track.yieldToday;
+            day.mppt[i].maxPower = track.maxPowerToday;
+        }
+        if (track.valid && track.daySequence >= 0 && day.daySequence == 0xFFFF) {
+            day.daySequence = (uint16_t)track.daySequence;
+        }
+    }
+    return day;
+}
+
+uint32_t DailyLedger::getClosedDays() const {
+    return _closedDays;
+}
@@ -0,0 +1,155 @@
+/**
+ * DailyLedger.h
+ *
+ * Persistent per-day energy ledger (one year of history)
+ *
+ * The MPPTs only report today and yesterday (H20-H23). The ledger closes a
+ * day record when a charger's day rolls over (HSDS day number changes, or
+ * H22/H23 shift when HSDS is not reported) and keeps the last CAPACITY days
+ * in a fixed-size binary file:
+ *
+ *   [FileHeader][Snapshot][Day 0][Day 1]...[Day CAPACITY-1]
+ *
+ * Day slots form a ring; header.head is the newest slot, so the record N
+ * days ago is one seek away. The snapshot holds the day in progress (Ah
+ * accumulators and the last H20-H23 seen) and is rewritten periodically, so
+ * a restart mid-day only loses the samples since the last save.
+ *
+ * Both chargers see the same sunset, so their rollovers come minutes apart.
+ * The first one closes the day; the other one's H22/H23 are patched into
+ * the same record when its rollover arrives (within ROLLOVER_GUARD_MS).
+ */
+
+#ifndef DAILY_LEDGER_H
+#define DAILY_LEDGER_H
+
+#include <Arduino.h>
+#include <FS.h>
+
+class DailyLedger {
+public:
+    static const uint16_t CAPACITY = 366;
+    static const uint8_t CHARGERS = 2;
+
+    enum DayFlags : uint16_t {
+        FLAG_SHUNT = 0x01,          // SmartShunt data seen during the day
+        FLAG_MPPT1 = 0x02,
+        FLAG_MPPT2 = 0x04,
+        FLAG_RESTARTED = 0x08       // Device restarted during the day (samples missing)
+    };
+
+    // Battery side of one device for one day
+    struct Battery {
+        uint16_t minVoltage;        // 0.01 V, 0 = no samples
+        uint16_t maxVoltage;        // 0.01 V
+        uint16_t ahIn;              // 0.1 Ah into the battery
+        uint16_t ahOut;             // 0.1 Ah out of the battery (MPPT: load output)
+    };
+
+    struct Charger {
+        Battery battery;
+        uint16_t yield;             // 0.01 kWh (H22 after the rollover)
+        uint16_t maxPower;          // W (H23 after the rollover)
+    };
+
+    struct Day {
+        uint32_t closedAt;          // Unix time of the rollover, 0 if the clock was not set
+        uint16_t daySequence;       // HSDS of the closed day, 0xFFFF if not reported
+        uint16_t flags;             // DayFlags
+        Battery shunt;
+        Charger mppt[CHARGERS];
+    };
+
+    struct ChargerReading {
+        float batteryVoltage;       // V
+        float chargeCurrent;        // A
+        float loadCurrent;          // A (load output, 0 if none)
+        float yieldToday;           // kWh (H20)
+        int maxPowerToday;          // W (H21)
+        float yieldYesterday;       // kWh (H22)
+        int maxPowerYesterday;      // W (H23)
+        int daySequence;            // HSDS, -1 if not reported
+    };
+
+    /**
+     * Constructor
+     * @param fs Mounted filesystem (SPIFFS/LittleFS)
+     * @param path Ledger file, created on first begin()
+     */
+    DailyLedger(fs::FS& fs, const char* path);
+
+    /**
+     * Open the ledger (creating it if missing or of another format) and
+     * restore the day in progress
+     */
+    bool begin();
+
+    // Feed one block per device (only when the device produced a new block)
+    void updateShunt(uint32_t timestampMs, float voltage, float current);
+    void updateCharger(uint8_t index, uint32_t timestampMs, const ChargerReading& reading, uint32_t unixTime);
+
+    // Persist the day in progress (call every few minutes)
+    bool saveToday();
+
+    uint16_t getStoredDays() const;
+    bool getDay(uint16_t daysAgo, Day& day);    // 0 = most recent closed day
+    Day getToday() const;                       // Day in progress, rounded like a stored record
+    uint32_t getClosedDays() const;             // Days closed since boot
+
+private:
+    struct FileHeader {
+        uint32_t magic;
+        uint16_t daySize;
+        uint16_t snapshotSize;
+        uint16_t capacity;
+        uint16_t head;              // Slot of the newest day
+        uint16_t count;             // Stored days
+        uint16_t reserved;
+    };
+
+    struct Accumulator {
+        float minVoltage;
+        float maxVoltage;
+        float ahIn;
+        float ahOut;
+        uint32_t lastMs;
+        bool seen;
+        bool hasSample;             // lastMs valid (RAM only)
+    };
+
+    struct ChargerTrack {
+        bool valid;
+        bool pending;               // Day closed by the other charger, this one's rollover still due
+        int16_t daySequence;
+        uint16_t yieldToday;
+        uint16_t maxPowerToday;
+        uint16_t yieldYesterday;
+        uint16_t maxPowerYesterday;
+    };
+
+    struct Snapshot {
+        Accumulator acc[1 + CHARGERS];  // 0 = shunt, 1.. = chargers
+        ChargerTrack track[CHARGERS];
+        uint16_t flags;
+    };
+
+    void accumulate(Accumulator& acc, uint32_t timestampMs, float voltage, float in, float out);
+    void closeDay(uint8_t index, const ChargerReading& reading, uint32_t timestampMs, uint32_t unixTime);
+    void patchNewest(uint8_t index, const ChargerReading& reading);
+    void resetToday();
+    bool writeHeader(File& file);
+    bool writeSlot(File& file, uint16_t slot, const Day& day);
+    static uint32_t slotOffset(uint16_t slot);
+    static Battery roundBattery(const Accumulator& acc);
+
+    fs::FS& _fs;
+    const char* _path;
+    bool _open;
+    FileHeader _header;
+    Snapshot _today;
+    Day _newest;
+    uint32_t _lastCloseMs;
+    uint32_t _closedDays;
+};
+
+#endif // DAILY_LEDGER_H
@@ -0,0 +1,180 @@
+/**
+ * MpptComparator.cpp
+ *
+ * Implementation of the parallel MPPT comparator
+ */
+
+#include "MpptComparator.h"
+
+static const uint8_t CS_BULK = 3;                   // Only bulk is maximum power point tracking
+static const float MIN_TOTAL_POWER_W = 30.0f;       // Below this the ratios are mostly noise
+static const uint32_t MAX_FRAME_GAP_MS = 10000;     // Longer gaps count as this long
+static const float FAST_TAU_S = 300.0f;             // Fast window (~5 min)
+static const float BASE_TAU_S = 6.0f * 3600.0f;     // Baseline (~6 h of tracking time)
+static const float MIN_BASELINE_S = 3600.0f;        // Tracking time before deviations are judged
+static const float MIN_SIGMA = 0.01f;               // Floor for the baseline standard deviation
+static const float DEVIATION_Z = 3.0f;
+static const float RECOVER_Z = 1.5f;
+static const float HOLD_S = 600.0f;                 // Deviation must persist this long
+static const float MIN_POWER_SHARE_DEVIATION = 0.08f;
+static const float MIN_VOLTAGE_RATIO_DEVIATION = 0.05f;
+
+MpptComparator::MpptComparator()
+    : _handler(nullptr)
+    , _hasSample(false)
+    , _lastTimestampMs(0)
+    , _comparedFrames(0)
+    , _eventCount(0)
+{
+    memset(&_powerShare, 0, sizeof(_powerShare));
+    memset(&_voltageRatio, 0, sizeof(_voltageRatio));
+    for (uint8_t i = 0; i < 2; i++) {
+        _lastError[i] = 0;
+        _errorKnown[i] = false;
+    }
+}
+
+void MpptComparator::setEventHandler(EventHandler handler) {
+    _handler = handler;
+}
+
+void MpptComparator::update(uint32_t timestampMs, const Reading& mppt1, const Reading& mppt2) {
+    float dt = 0;
+    if (_hasSample) {
+        dt = min(timestampMs - _lastTimestampMs, MAX_FRAME_GAP_MS) / 1000.0f;
+    }
+    _hasSample = true;
+    _lastTimestampMs = timestampMs;
+
+    // ERR transitions (first frame only sets the reference)
+    const Reading* readings[2] = {&mppt1, &mppt2};
+    for (uint8_t i = 0; i < 2; i++) {
+        if (!readings[i]->valid) {
+            continue;
+        }
+        int code = readings[i]->errorCode;
+        if (_errorKnown[i] && code != _lastError[i]) {
+            emit(code != 0 ? ERROR_RAISED : ERROR_CLEARED, i, code, _lastError[i], 0);
+        }
+        _lastError[i] = code;
+        _errorKnown[i] = true;
+    }
+
+    // Compare only while both are tracking with meaningful power
+    float totalPower = mppt1.panelPower + mppt2.panelPower;
+    if (!mppt1.valid || !mppt2.valid
+        || mppt1.chargeState != CS_BULK || mppt2.chargeState != CS_BULK
+        || totalPower < MIN_TOTAL_POWER_W
+        || mppt1.panelVoltage <= 0 || mppt2.panelVoltage <= 0) {
+        return;
+    }
+    _comparedFrames++;
+    updateMetric(_powerShare, mppt1.panelPower / totalPower, dt,
+                 MIN_POWER_SHARE_DEVIATION, POWER_DEVIATION, POWER_RECOVERED);
+    updateMetric(_voltageRatio, mppt1.panelVoltage / mppt2.panelVoltage, dt,
+                 MIN_VOLTAGE_RATIO_DEVIATION, VOLTAGE_DEVIATION, VOLTAGE_RECOVERED);
+}
+
+void MpptComparator::updateMetric(Metric& metric, float value, float dt, float minDeviation,
+                                  EventType deviation, EventType recovered) {
+    if (!metric.primed) {
+        metric.fastMean = value;
+        metric.baseMean = value;
+        metric.baseVar = 0;
+        metric.primed = true;
+        return;
+    }
+
+    metric.fastMean += (value - metric.fastMean) * dt / (FAST_TAU_S + dt);
+
+    // Exponentially weighted mean/variance; frozen while deviating. Once the
+    // baseline is ready, samples are clipped to the deviation band so a fault
+    // building up during the hold time cannot drag the baseline towards it.
+    if (!metric.deviating) {
+        float alpha = dt / (BASE_TAU_S + dt);
+        float diff = value - metric.baseMean;
+        if (metric.baseSeconds >= MIN_BASELINE_S) {
+            float limit = DEVIATION_Z * max(sqrtf(metric.baseVar), MIN_SIGMA);
+            diff = constrain(diff, -limit, limit);
+        }
+        metric.baseMean += alpha * diff;
+        metric.baseVar = (1.0f - alpha) * (metric.baseVar + alpha * diff * diff);
+        metric.baseSeconds += dt;
+    }
+    if (metric.baseSeconds < MIN_BASELINE_S) {
+        return;
+    }
+
+    // The low side of the ratio is the underperforming charger
+    float z = zScore(metric);
+    uint8_t charger = metric.fastMean < metric.baseMean ? 0 : 1;
+    if (!metric.deviating) {
+        bool outside = fabsf(z) >= DEVIATION_Z && fabsf(metric.fastMean - metric.baseMean) >= minDeviation;
+        metric.outsideSeconds = outside ? metric.outsideSeconds + dt : 0;
+        if (metric.outsideSeconds >= HOLD_S) {
+            metric.deviating = true;
+            emit(deviation, charger, metric.fastMean, metric.baseMean, z);
+        }
+    } else if (fabsf(z) < RECOVER_Z) {
+        metric.deviating = false;
+        metric.outsideSeconds = 0;
+        emit(recovered, charger, metric.fastMean, metric.baseMean, z);
+    }
+}
+
+float MpptComparator::zScore(const Metric& metric) const {
+    float sigma = max(sqrtf(metric.baseVar), MIN_SIGMA);
+    return (metric.fastMean - metric.baseMean) / sigma;
+}
+
+void MpptComparator::emit(EventType type, uint8_t charger, float value, float baseline, float z) {
+    _eventCount++;
+    if (_handler) {
+        Event event = {type, charger, value, baseline, z};
+        _handler(event);
+    }
+}
+
+float MpptComparator::getPowerShare() const {
+    return _powerShare.fastMean;
+}
+
+float MpptComparator::getPowerShareBaseline() const {
+    return _powerShare.baseMean;
+}
+
+float MpptComparator::getPowerShareZ() const {
+    return _powerShare.primed ? zScore(_powerShare) : 0;
+}
+
+float MpptComparator::getVoltageRatio() const {
+    return _voltageRatio.fastMean;
+}
+
+float MpptComparator::getVoltageRatioBaseline() const {
+    return _voltageRatio.baseMean;
+}
+
+float MpptComparator::getVoltageRatioZ() const {
+    return _voltageRatio.primed ? zScore(_voltageRatio) : 0;
+}
+
+bool MpptComparator::isBaselineReady() const {
+    return _powerShare.baseSeconds >= MIN_BASELINE_S;
+}
+
+bool MpptComparator::isPowerDeviating() const {
+    return _powerShare.deviating;
+}
+
+bool MpptComparator::isVoltageDeviating() const {
+    return _voltageRatio.deviating;
+}
+
+uint32_t MpptComparator::getComparedFrames() const {
+    return _comparedFrames;
+}
+
+uint32_t MpptComparator::getEventCount() const {
+    return _eventCount;
+}
@@ -0,0 +1,103 @@
+/**
+ * MpptComparator.h
+ *
+ * Underperformance and fault detection for two MPPTs on the same battery
+ *
+ * Both chargers see the same sky, so while both are tracking (BULK) the
+ * share of total PV power each one produces, and the ratio of their panel
+ * voltages, are stable properties of the installation. Each metric keeps a
+ * slow exponentially weighted baseline (mean and variance) and a fast
+ * window; a fast mean that stays more than DEVIATION_Z standard deviations
+ * and MIN_DEVIATION away from the baseline for HOLD_MS raises an event
+ * (shading, failed string, loose connector). Baseline updates are clipped
+ * to the deviation band and freeze while a deviation is active, so a fault
+ * is not learned as normal.
+ *
+ * ERR code transitions on either charger are reported as events as well.
+ * Memory is constant per charger; one update per VE.Direct frame.
+ */
+
+#ifndef MPPT_COMPARATOR_H
+#define MPPT_COMPARATOR_H
+
+#include <Arduino.h>
+
+class MpptComparator {
+public:
+    enum EventType : uint8_t {
+        POWER_DEVIATION,        // Power share left the baseline band
+        POWER_RECOVERED,
+        VOLTAGE_DEVIATION,      // Panel voltage ratio left the baseline band
+        VOLTAGE_RECOVERED,
+        ERROR_RAISED,           // ERR went from 0 to a fault code (or between codes)
+        ERROR_CLEARED
+    };
+
+    struct Reading {
+        bool valid;
+        float panelVoltage;     // V
+        float panelPower;       // W
+        uint8_t chargeState;    // VE.Direct CS code
+        int errorCode;          // VE.Direct ERR code
+    };
+
+    struct Event {
+        EventType type;
+        uint8_t charger;        // 0 = MPPT1, 1 = MPPT2; for deviations the underperforming one
+        float value;            // Current fast mean (deviations) or ERR code
+        float baseline;         // Baseline mean (deviations) or previous ERR code
+        float zScore;
+    };
+
+    typedef void (*EventHandler)(const Event& event);
+
+    // Tracks one metric: slow baseline + fast window, O(1)
+    struct Metric {
+        float fastMean;
+        float baseMean;
+        float baseVar;
+        float baseSeconds;      // Time folded into the baseline
+        float outsideSeconds;   // How long the fast mean has been outside the band
+        bool deviating;
+        bool primed;
+    };
+
+    MpptComparator();
+
+    void setEventHandler(EventHandler handler);
+
+    /**
+     * Feed the latest frame of both chargers (call when either one has a new block)
+     * @param timestampMs Monotonic time (wraps like millis())
+     */
+    void update(uint32_t timestampMs, const Reading& mppt1, const Reading& mppt2);
+
+    float getPowerShare() const;            // MPPT1 share of total PV power, fast window
+    float getPowerShareBaseline() const;
+    float getPowerShareZ() const;
+    float getVoltageRatio() const;          // MPPT1 / MPPT2 panel voltage, fast window
+    float getVoltageRatioBaseline() const;
+    float getVoltageRatioZ() const;
+    bool isBaselineReady() const;
+    bool isPowerDeviating() const;
+    bool isVoltageDeviating() const;
+    uint32_t getComparedFrames() const;     // Frames where both chargers were tracking
+    uint32_t getEventCount() const;
+
+private:
+    void updateMetric(Metric& metric, float value, float dt, float minDeviation, EventType deviation, EventType recovered);
+    float zScore(const Metric& metric) const;
+    void emit(EventType type, uint8_t charger, float value, float baseline, float z);
+
+    EventHandler _handler;
+    Metric _powerShare;
+    Metric _voltageRatio;
+    int _lastError[2];
+    bool _errorKnown[2];
+    bool _hasSample;
+    uint32_t _lastTimestampMs;
+    uint32_t _comparedFrames;
+    uint32_t _eventCount;
+};
+
+#endif // MPPT_COMPARATOR_H
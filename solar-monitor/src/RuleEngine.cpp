@@ -0,0 +1,434 @@
+/**
+ * RuleEngine.cpp
+ *
+ * Implementation of the local rule engine: expression compiler and
+ * bytecode evaluator
+ */
+
+#include "RuleEngine.h"
+#include <math.h>
+
+static const char* const SIGNAL_NAMES[RuleEngine::SIGNAL_COUNT] = {
+    "battery_v", "battery_i", "battery_p", "soc", "ttg", "consumed_ah", "alarm",
+    "pv_power", "charge_current",
+    "mppt1_pv_v", "mppt1_pv_w", "mppt1_i", "mppt1_cs", "mppt1_err",
+    "mppt2_pv_v", "mppt2_pv_w", "mppt2_i", "mppt2_cs", "mppt2_err",
+    "soh", "ttg_forecast", "hour"
+};
+
+enum Opcode : uint8_t {
+    OP_CONST,
+    OP_SIGNAL,
+    OP_ADD, OP_SUB, OP_MUL, OP_DIV,
+    OP_NEG, OP_ABS, OP_NOT,
+    OP_LT, OP_LE, OP_GT, OP_GE, OP_EQ, OP_NE,
+    OP_AND, OP_OR
+};
+
+// ============================================================================
+// Compiler: recursive descent straight to stack code
+//
+//   or      := and ('||' and)*
+//   and     := not ('&&' not)*
+//   not     := '!' not | compare
+//   compare := sum (('<' | '<=' | '>' | '>=' | '==' | '!=') sum)?
+//   sum     := product (('+' | '-') product)*
+//   product := unary (('*' | '/') unary)*
+//   unary   := '-' unary | 'abs' '(' or ')' | '(' or ')' | number | signal
+// ============================================================================
+
+namespace {
+    struct Compiler {
+        const char* start;
+        const char* pos;
+        RuleEngine::Rule& rule;
+        const char* error;
+        uint8_t depth;
+        bool negated;       // Inside an odd number of '!'
+
+        Compiler(const char* expression, RuleEngine::Rule& target)
+            : start(expression), pos(expression), rule(target), error(nullptr), depth(0), negated(false) {}
+
+        void skipSpace() {
+            while (*pos == ' ' || *pos == '\t') pos++;
+        }
+
+        bool match(const char* token) {
+            skipSpace();
+            size_t length = strlen(token);
+            if (strncmp(pos, token, length) != 0) {
+                return false;
+            }
+            pos += length;
+            return true;
+        }
+
+        bool fail(const char* message) {
+            if (!error) error = message;
+            return false;
+        }
+
+        // Track the evaluation stack so run() never needs bounds checks
+        bool emit(uint8_t op, uint8_t signal = 0, float constant = 0) {
+            if (rule.length >= RuleEngine::MAX_CODE) {
+                return fail("expression too long");
+            }
+            if (op == OP_CONST || op == OP_SIGNAL) {
+                if (++depth > RuleEngine::STACK_DEPTH) {
+                    return fail("expression nested too deeply");
+                }
+            } else if (op != OP_NEG && op != OP_ABS && op != OP_NOT) {
+                depth--;
+            }
+            rule.code[rule.length++] = {op, signal, constant};
+            return true;
+        }
+
+        bool parseOr() {
+            if (!parseAnd()) return false;
+            while (match("||")) {
+                if (!parseAnd() || !emit(OP_OR)) return false;
+            }
+            return true;
+        }
+
+        bool parseAnd() {
+            if (!parseNot()) return false;
+            while (match("&&")) {
+                if (!parseNot() || !emit(OP_AND)) return false;
+            }
+            return true;
+        }
+
+        bool parseNot() {
+            skipSpace();
+            if (pos[0] == '!' && pos[1] != '=') {
+                pos++;
+                negated = !negated;
+                bool ok = parseNot() && emit(OP_NOT);
+                negated = !negated;
+                return ok;
+            }
+            return parseCompare();
+        }
+
+        bool parseCompare() {
+            if (!parseSum()) return false;
+            uint8_t op;
+            if (match("<=")) op = OP_LE;
+            else if (match(">=")) op = OP_GE;
+            else if (match("==")) op = OP_EQ;
+            else if (match("!=")) op = OP_NE;
+            else if (match("<")) op = OP_LT;
+            else if (match(">")) op = OP_GT;
+            else return true;
+            // Comparisons under '!' get the hysteresis reversed (see run())
+            return parseSum() && emit(op, negated ? 1 : 0);
+        }
+
+        bool parseSum() {
+            if (!parseProduct()) return false;
+            while (true) {
+                if (match("+")) {
+                    if (!parseProduct() || !emit(OP_ADD)) return false;
+                } else if (match("-")) {
+                    if (!parseProduct() || !emit(OP_SUB)) return false;
+                } else {
+                    return true;
+                }
+            }
+        }
+
+        bool parseProduct() {
+            if (!parseUnary()) return false;
+            while (true) {
+                if (match("*")) {
+                    if (!parseUnary() || !emit(OP_MUL)) return false;
+                } else if (match("/")) {
+                    if (!parseUnary() || !emit(OP_DIV)) return false;
+                } else {
+                    return true;
+                }
+            }
+        }
+
+        bool parseUnary() {
+            skipSpace();
+            if (match("-")) {
+                return parseUnary() && emit(OP_NEG);
+            }
+            if (match("(")) {
+                if (!parseOr()) return false;
+                return match(")") || fail("expected ')'");
+            }
+            if ((*pos >= '0' && *pos <= '9') || *pos == '.') {
+                char* end;
+                float value = strtof(pos, &end);
+                if (end == pos) return fail("bad number");
+                pos = end;
+                return emit(OP_CONST, 0, value);
+            }
+
+            const char* name = pos;
+            while ((*pos >= 'a' && *pos <= 'z') || (*pos >= '0' && *pos <= '9') || *pos == '_') pos++;
+            size_t length = pos - name;
+            if (length == 0) {
+                return fail("expected a value");
+            }
+            if (length == 3 && strncmp(name, "abs", 3) == 0) {
+                if (!match("(")) return fail("expected '('");
+                if (!parseOr()) return false;
+                if (!match(")")) return fail("expected ')'");
+                return emit(OP_ABS);
+            }
+            for (uint8_t signal = 0; signal < RuleEngine::SIGNAL_COUNT; signal++) {
+                if (strlen(SIGNAL_NAMES[signal]) == length && strncmp(name, SIGNAL_NAMES[signal], length) == 0) {
+                    rule.signalMask |= 1UL << signal;
+                    return emit(OP_SIGNAL, signal);
+                }
+            }
+            pos = name;
+            return fail("unknown signal");
+        }
+    };
+}
+
+RuleEngine::RuleEngine()
+    : _count(0)
+    , _handler(nullptr)
+    , _evaluations(0)
+{
+}
+
+void RuleEngine::setActionHandler(ActionHandler handler) {
+    _handler = handler;
+}
+
+bool RuleEngine::compile(const char* expression, Rule& rule, char* error, size_t errorSize) {
+    rule.length = 0;
+    rule.signalMask = 0;
+    if (strlen(expression) >= MAX_EXPRESSION) {
+        snprintf(error, errorSize, "expression longer than %u characters", MAX_EXPRESSION - 1);
+        return false;
+    }
+
+    Compiler compiler(expression, rule);
+    bool ok = compiler.parseOr();
+    compiler.skipSpace();
+    if (ok && *compiler.pos != '\0') {
+        ok = compiler.fail("unexpected input");
+    }
+    if (!ok) {
+        snprintf(error, errorSize, "%s at position %d", compiler.error, (int)(compiler.pos - expression));
+        return false;
+    }
+    strncpy(rule.expression, expression, MAX_EXPRESSION - 1);
+    rule.expression[MAX_EXPRESSION - 1] = '\0';
+    return true;
+}
+
+bool RuleEngine::build(Rule& rule, const char* name, const char* expression, float hysteresis,
+                       uint32_t onDelayMs, uint32_t offDelayMs, const Action& action,
+                       char* error, size_t errorSize) {
+    memset(&rule, 0, sizeof(rule));
+    if (!compile(expression, rule, error, errorSize)) {
+        return false;
+    }
+    strncpy(rule.name, name, MAX_NAME - 1);
+    rule.hysteresis = hysteresis > 0 ? hysteresis : 0;
+    rule.onDelayMs = onDelayMs;
+    rule.offDelayMs = offDelayMs;
+    rule.action = action;
+    return true;
+}
+
+bool RuleEngine::addRule(const char* name, const char* expression, float hysteresis, uint32_t onDelayMs,
+                         uint32_t offDelayMs, const Action& action, char* error, size_t errorSize) {
+    if (_count >= MAX_RULES) {
+        snprintf(error, errorSize, "more than %u rules", MAX_RULES);
+        return false;
+    }
+    if (!build(_rules[_count], name, expression, hysteresis, onDelayMs, offDelayMs, action, error, errorSize)) {
+        return false;
+    }
+    _count++;
+    return true;
+}
+
+bool RuleEngine::sameDefinition(const Rule& a, const Rule& b) {
+    return strcmp(a.name, b.name) == 0 && strcmp(a.expression, b.expression) == 0
+        && a.hysteresis == b.hysteresis && a.onDelayMs == b.onDelayMs && a.offDelayMs == b.offDelayMs
+        && a.action.type == b.action.type && a.action.pin == b.action.pin
+        && a.action.level == b.action.level && strcmp(a.action.target, b.action.target) == 0;
+}
+
+void RuleEngine::replace(const Rule* rules, uint8_t count) {
+    if (count > MAX_RULES) {
+        count = MAX_RULES;
+    }
+
+    // Pair each new rule with an unchanged old one (each old rule used once)
+    int8_t from[MAX_RULES];
+    uint32_t kept = 0;
+    for (uint8_t j = 0; j < count; j++) {
+        from[j] = -1;
+        for (uint8_t i = 0; i < _count; i++) {
+            if (!(kept & (1UL << i)) && sameDefinition(rules[j], _rules[i])) {
+                from[j] = i;
+                kept |= 1UL << i;
+                break;
+            }
+        }
+    }
+
+    // Release the others while their old action is still in the table
+    for (uint8_t i = 0; i < _count; i++) {
+        if (!(kept & (1UL << i)) && _rules[i].active) {
+            transition(_rules[i], false);
+        }
+    }
+
+    struct State {
+        bool active;
+        bool changing;
+        uint32_t changingSinceMs;
+        uint32_t activations;
+    } state[MAX_RULES];
+    for (uint8_t i = 0; i < _count; i++) {
+        state[i] = {_rules[i].active, _rules[i].changing, _rules[i].changingSinceMs, _rules[i].activations};
+    }
+
+    for (uint8_t j = 0; j < count; j++) {
+        Rule& rule = _rules[j];
+        rule = rules[j];
+        rule.active = false;
+        rule.changing = false;
+        rule.changingSinceMs = 0;
+        rule.activations = 0;
+        if (from[j] >= 0) {
+            const State& old = state[from[j]];
+            rule.active = old.active;
+            rule.changing = old.changing;
+            rule.changingSinceMs = old.changingSinceMs;
+            rule.activations = old.activations;
+        }
+    }
+    _count = count;
+}
+
+void RuleEngine::restoreActive(uint8_t index) {
+    if (index < _count && !_rules[index].active) {
+        _rules[index].active = true;
+        _rules[index].changing = false;
+        _rules[index].activations++;
+    }
+}
+
+void RuleEngine::clear() {
+    for (uint8_t i = 0; i < _count; i++) {
+        if (_rules[i].active) {
+            transition(_rules[i], false);
+        }
+    }
+    _count = 0;
+}
+
+// Compiled code is well formed (checked stack depth), so no bounds checks here
+bool RuleEngine::run(const Rule& rule, const float* signals) const {
+    float stack[STACK_DEPTH];
+    uint8_t sp = 0;
+    // Hysteresis widens the band in which the whole rule stays true. A
+    // comparison under '!' must get harder to pass for that, so its sign flips
+    // ("!(soc > 30)" with hysteresis 5 releases at 35, like "soc <= 30").
+    float h = rule.active ? rule.hysteresis : 0;
+
+    for (uint8_t i = 0; i < rule.length; i++) {
+        const Instruction& in = rule.code[i];
+        float b;
+        switch (in.op) {
+            case OP_CONST: stack[sp++] = in.constant; continue;
+            case OP_SIGNAL: stack[sp++] = signals[in.signal]; continue;
+            case OP_NEG: stack[sp - 1] = -stack[sp - 1]; continue;
+            case OP_ABS: stack[sp - 1] = fabsf(stack[sp - 1]); continue;
+            case OP_NOT: stack[sp - 1] = stack[sp - 1] == 0 ? 1.0f : 0.0f; continue;
+            default: break;
+        }
+
+        b = stack[--sp];
+        float& a = stack[sp - 1];
+        float hc = in.signal ? -h : h;      // Comparisons only: signal = negated flag
+        switch (in.op) {
+            case OP_ADD: a = a + b; break;
+            case OP_SUB: a = a - b; break;
+            case OP_MUL: a = a * b; break;
+            case OP_DIV: a = b != 0 ? a / b : 0; break;
+            case OP_LT: a = a < b + hc; break;
+            case OP_LE: a = a <= b + hc; break;
+            case OP_GT: a = a > b - hc; break;
+            case OP_GE: a = a >= b - hc; break;
+            case OP_EQ: a = a == b; break;
+            case OP_NE: a = a != b; break;
+            case OP_AND: a = (a != 0) && (b != 0); break;
+            case OP_OR: a = (a != 0) || (b != 0); break;
+        }
+    }
+    return sp == 1 && stack[0] != 0;
+}
+
+void RuleEngine::evaluate(uint32_t timestampMs, const float* signals) {
+    _evaluations++;
+    uint32_t available = 0;
+    for (uint8_t i = 0; i < SIGNAL_COUNT; i++) {
+        if (!isnan(signals[i])) {
+            available |= 1UL << i;
+        }
+    }
+
+    for (uint8_t i = 0; i < _count; i++) {
+        Rule& rule = _rules[i];
+        // Missing readings hold the current state (a silent shunt must not release load shedding)
+        if ((rule.signalMask & available) != rule.signalMask) {
+            rule.changing = false;
+            continue;
+        }
+        bool condition = run(rule, signals);
+        if (condition == rule.active) {
+            rule.changing = false;
+            continue;
+        }
+        if (!rule.changing) {
+            rule.changing = true;
+            rule.changingSinceMs = timestampMs;
+        }
+        if (timestampMs - rule.changingSinceMs >= (condition ? rule.onDelayMs : rule.offDelayMs)) {
+            rule.changing = false;
+            transition(rule, condition);
+        }
+    }
+}
+
+void RuleEngine::transition(Rule& rule, bool active) {
+    rule.active = active;
+    if (active) {
+        rule.activations++;
+    }
+    if (_handler) {
+        _handler(rule, active);
+    }
+}
+
+uint8_t RuleEngine::getRuleCount() const {
+    return _count;
+}
+
+const RuleEngine::Rule& RuleEngine::getRule(uint8_t index) const {
+    return _rules[index < _count ? index : 0];
+}
+
+uint32_t RuleEngine::getEvaluations() const {
+    return _evaluations;
+}
+
+const char* RuleEngine::signalName(uint8_t signal) {
+    return signal < SIGNAL_COUNT ? SIGNAL_NAMES[signal] : "";
+}
@@ -0,0 +1,166 @@
+/**
+ * RuleEngine.h
+ *
+ * Local threshold automations evaluated on every VE.Direct block
+ *
+ * A rule is an expression over the current readings ("soc < 30",
+ * "abs(battery_i) > 80 && battery_v < 12.2") compiled once into a short
+ * stack bytecode, plus hysteresis, debounce and an action:
+ *
+ * - Hysteresis: while a rule is active, its < / <= comparisons pass up to
+ *   `hysteresis` above the threshold and > / >= down to `hysteresis` below
+ *   it, so "soc < 30" with hysteresis 5 releases at 35. Under '!' the
+ *   direction flips, so "!(soc > 30)" also releases at 35.
+ * - Debounce: the condition must hold for onDelayMs to activate and be false
+ *   for offDelayMs to release.
+ * - Readings that are unavailable (NAN, e.g. a charger without data) freeze
+ *   the rules that use them instead of releasing them.
+ *
+ * The engine only reports transitions to the action handler; performing the
+ * action (GPIO, event, webhook) is up to the caller. No allocation: rules
+ * live in a fixed table.
+ */
+
+#ifndef RULE_ENGINE_H
+#define RULE_ENGINE_H
+
+#include <Arduino.h>
+
+class RuleEngine {
+public:
+    static const uint8_t MAX_RULES = 16;
+    static const uint8_t MAX_CODE = 32;         // Instructions per rule
+    static const uint8_t STACK_DEPTH = 12;
+    static const uint8_t MAX_NAME = 24;
+    static const uint8_t MAX_EXPRESSION = 96;
+    static const uint8_t MAX_TARGET = 96;
+
+    // Readings a rule can use; the caller fills a float[SIGNAL_COUNT] per block
+    enum Signal : uint8_t {
+        BATTERY_V,          // V
+        BATTERY_I,          // A, negative = discharge
+        BATTERY_P,          // W
+        SOC,                // %
+        TTG,                // SmartShunt time to go, min (-1 = infinite)
+        CONSUMED_AH,        // Ah
+        ALARM,              // 1 = SmartShunt alarm on
+        PV_POWER,           // W, both chargers
+        CHARGE_CURRENT,     // A, both chargers
+        MPPT1_PV_V,
+        MPPT1_PV_W,
+        MPPT1_I,
+        MPPT1_CS,           // VE.Direct CS code
+        MPPT1_ERR,          // VE.Direct ERR code
+        MPPT2_PV_V,
+        MPPT2_PV_W,
+        MPPT2_I,
+        MPPT2_CS,
+        MPPT2_ERR,
+        SOH,                // Battery state of health, %
+        TTG_FORECAST,       // Forecast minutes to empty (-1 = not within 7 days)
+        HOUR,               // UTC hour of day (NAN until the clock is set)
+        SIGNAL_COUNT
+    };
+
+    enum ActionType : uint8_t {
+        ACTION_EVENT,       // target = severity
+        ACTION_WEBHOOK,     // target = URL
+        ACTION_GPIO         // pin driven to level while active, !level when released
+    };
+
+    struct Action {
+        ActionType type;
+        int8_t pin;
+        uint8_t level;
+        char target[MAX_TARGET];
+    };
+
+    struct Instruction {
+        uint8_t op;
+        uint8_t signal;             // Signal index; for comparisons, 1 = under '!'
+        float constant;
+    };
+
+    struct Rule {
+        char name[MAX_NAME];
+        char expression[MAX_EXPRESSION];
+        Instruction code[MAX_CODE];
+        uint8_t length;
+        uint32_t signalMask;        // Signals the expression reads
+        float hysteresis;
+        uint32_t onDelayMs;
+        uint32_t offDelayMs;
+        Action action;
+
+        // Runtime state
+        bool active;
+        bool changing;              // Condition differs from state, debounce running
+        uint32_t changingSinceMs;
+        uint32_t activations;
+    };
+
+    typedef void (*ActionHandler)(const Rule& rule, bool active);
+
+    RuleEngine();
+
+    void setActionHandler(ActionHandler handler);
+
+    /**
+     * Compile an expression (and check it fits); nothing is added on failure
+     * @param error Receives a short message with the character position
+     */
+    static bool compile(const char* expression, Rule& rule, char* error, size_t errorSize);
+
+    /**
+     * Compile and append a rule
+     * @return false (with error) if the expression does not compile or the table is full
+     */
+    bool addRule(const char* name, const char* expression, float hysteresis, uint32_t onDelayMs,
+                 uint32_t offDelayMs, const Action& action, char* error, size_t errorSize);
+
+    /**
+     * Compile a rule into `rule` without adding it (runtime state cleared)
+     * @return false (with error) if the expression does not compile
+     */
+    static bool build(Rule& rule, const char* name, const char* expression, float hysteresis,
+                      uint32_t onDelayMs, uint32_t offDelayMs, const Action& action,
+                      char* error, size_t errorSize);
+
+    /**
+     * Replace the rule set with rules[0..count) (built with build()). A rule
+     * whose name, expression, hysteresis, delays and action are unchanged
+     * keeps its state without its action firing, so an active output stays
+     * on; active rules that are gone or changed are released first.
+     */
+    void replace(const Rule* rules, uint8_t count);
+
+    // Mark a rule active without firing its action (state restored after a reboot)
+    void restoreActive(uint8_t index);
+
+    // Release every active rule (actions fire), then remove all rules
+    void clear();
+
+    /**
+     * Evaluate all rules against one set of readings (NAN = unavailable)
+     * @param timestampMs Monotonic time (wraps like millis())
+     */
+    void evaluate(uint32_t timestampMs, const float* signals);
+
+    uint8_t getRuleCount() const;
+    const Rule& getRule(uint8_t index) const;
+    uint32_t getEvaluations() const;
+
+    static const char* signalName(uint8_t signal);
+
+private:
+    static bool sameDefinition(const Rule& a, const Rule& b);
+    bool run(const Rule& rule, const float* signals) const;
+    void transition(Rule& rule, bool active);
+
+    Rule _rules[MAX_RULES];
+    uint8_t _count;
+    ActionHandler _handler;
+    uint32_t _evaluations;
+};
+
+#endif // RULE_ENGINE_H
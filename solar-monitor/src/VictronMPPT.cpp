@@ -8,25 +8,15 @@
 
 VictronMPPT::VictronMPPT(Stream* serial)
     : _serial(serial)
-    , _product_id("")
-    , _serial_number("")
-    , _batt_voltage_mv(0)
-    , _charge_current_ma(0)
-    , _pv_voltage_mv(0)
-    , _pv_power_w(0)
-    , _charge_state(ChargeState::UNKNOWN)
-    , _error_code(0)
-    , _load_state("OFF")
-    , _load_current_ma(0)
-    , _yield_today(0)
-    , _yield_yesterday(0)
-    , _yield_total(0)
-    , _max_power_today(0)
-    , _max_power_yesterday(0)
     , _lineBuffer("")
     , _lastUpdate(0)
     , _dataValid(false)
+    , _blockCount(0)
     , _fieldsReceived(0)
+    , _checksum(0)
+    , _awaitingChecksum(false)
+    , _checksumSynced(false)
+    , _checksumErrors(0)
 {
 }
 
@@ -40,6 +30,19 @@ void VictronMPPT::update() {
     while (_serial->available()) {
         char c = _serial->read();
 
+        // All bytes of a block, from its leading CRLF to the checksum byte,
+        // sum to 0 mod 256
+        _checksum += (uint8_t)c;
+        if (_awaitingChecksum) {
+            // The checksum byte (any value, even '\n') ends the block; the
+            // next block's CRLF follows a second later
+            _awaitingChecksum = false;
+            endBlock(_checksum == 0);
+            _checksum = 0;
+            _lineBuffer = "";
+            continue;
+        }
+
         if (c == '\n') {
             // End of line - parse it
             if (_lineBuffer.length() > 0) {
@@ -53,6 +56,9 @@ void VictronMPPT::update() {
             if (_lineBuffer.length() < 64) {
                 _lineBuffer += c;
             }
+            if (c == '\t' && _lineBuffer == "Checksum\t") {
+                _awaitingChecksum = true;
+            }
         }
     }
 }
@@ -70,85 +76,102 @@ void VictronMPPT::parseLine(const String& line) {
     // Parse known fields
     if (key == "PID") {
         // Product ID (device identification)
-        _product_id = value;
+        _block.product_id = value;
     }
     else if (key == "SER#") {
         // Serial number (device identification)
-        _serial_number = value;
+        _block.serial_number = value;
     }
     else if (key == "V") {
         // Battery voltage in mV
-        _batt_voltage_mv = value.toInt();
+        _block.batt_voltage_mv = value.toInt();
         _fieldsReceived++;
     }
     else if (key == "I") {
         // Charge current in mA
-        _charge_current_ma = value.toInt();
+        _block.charge_current_ma = value.toInt();
         _fieldsReceived++;
     }
     else if (key == "VPV") {
         // Panel voltage in mV
-        _pv_voltage_mv = value.toInt();
+        _block.pv_voltage_mv = value.toInt();
         _fieldsReceived++;
     }
     else if (key == "PPV") {
         // Panel power in W
-        _pv_power_w = value.toInt();
+        _block.pv_power_w = value.toInt();
     }
     else if (key == "CS") {
         // Charge state
         int state = value.toInt();
         switch (state) {
-            case 0: _charge_state = ChargeState::OFF; break;
-            case 2: _charge_state = ChargeState::FAULT; break;
-            case 3: _charge_state = ChargeState::BULK; break;
-            case 4: _charge_state = ChargeState::ABSORPTION; break;
-            case 5: _charge_state = ChargeState::FLOAT; break;
-            case 6: _charge_state = ChargeState::STORAGE; break;
-            case 7: _charge_state = ChargeState::EQUALIZE; break;
-            default: _charge_state = ChargeState::UNKNOWN; break;
+            case 0: _block.charge_state = ChargeState::OFF; break;
+            case 2: _block.charge_state = ChargeState::FAULT; break;
+            case 3: _block.charge_state = ChargeState::BULK; break;
+            case 4: _block.charge_state = ChargeState::ABSORPTION; break;
+            case 5: _block.charge_state = ChargeState::FLOAT; break;
+            case 6: _block.charge_state = ChargeState::STORAGE; break;
+            case 7: _block.charge_state = ChargeState::EQUALIZE; break;
+            default: _block.charge_state = ChargeState::UNKNOWN; break;
         }
     }
     else if (key == "ERR") {
         // Error code
-        _error_code = value.toInt();
+        _block.error_code = value.toInt();
     }
     else if (key == "LOAD") {
         // Load output state (ON/OFF)
-        _load_state = value;
+        _block.load_state = value;
     }
     else if (key == "IL") {
         // Load current in mA
-        _load_current_ma = value.toInt();
+        _block.load_current_ma = value.toInt();
     }
     else if (key == "H19") {
         // Total yield in 0.01 kWh
-        _yield_total = value.toInt();
+        _block.yield_total = value.toInt();
     }
     else if (key == "H20") {
         // Yield today in 0.01 kWh
-        _yield_today = value.toInt();
+        _block.yield_today = value.toInt();
     }
     else if (key == "H21") {
         // Max power today in W
-        _max_power_today = value.toInt();
+        _block.max_power_today = value.toInt();
     }
     else if (key == "H22") {
         // Yield yesterday in 0.01 kWh
-        _yield_yesterday = value.toInt();
+        _block.yield_yesterday = value.toInt();
     }
     else if (key == "H23") {
         // Max power yesterday in W
-        _max_power_yesterday = value.toInt();
+        _block.max_power_yesterday = value.toInt();
+    }
+    else if (key == "HSDS") {
+        // Day sequence number, increments at each day rollover
+        _block.day_sequence = value.toInt();
     }
-    else if (key == "Checksum") {
-        // End of data block - mark as valid if we have enough fields
+}
+
+void VictronMPPT::endBlock(bool intact) {
+    // An intact block replaces the live values; a damaged one is dropped with
+    // everything it parsed. Mark as valid if the block had enough fields. The
+    // first block after boot starts mid-stream and only synchronises the checksum.
+    if (intact) {
+        _data = _block;
         if (_fieldsReceived >= MIN_FIELDS_FOR_VALID) {
             _dataValid = true;
             _lastUpdate = millis();
+            _blockCount++;
+        }
+    } else {
+        _block = _data;
+        if (_checksumSynced) {
+            _checksumErrors++;
         }
-        _fieldsReceived = 0;  // Reset for next block
     }
+    _checksumSynced = true;
+    _fieldsReceived = 0;  // Reset for next block
 }
 
 // Static helper: Convert charge state to string
@@ -183,71 +206,75 @@ String VictronMPPT::errorCodeToString(int code) {
 // Getters - convert raw values to user-friendly units
 
 String VictronMPPT::getProductID() const {
-    return _product_id;
+    return _data.product_id;
 }
 
 String VictronMPPT::getSerialNumber() const {
-    return _serial_number;
+    return _data.serial_number;
 }
 
 float VictronMPPT::getBatteryVoltage() const {
-    return _batt_voltage_mv / 1000.0f;  // mV to V
+    return _data.batt_voltage_mv / 1000.0f;  // mV to V
 }
 
 float VictronMPPT::getChargeCurrent() const {
-    return _charge_current_ma / 1000.0f;  // mA to A
+    return _data.charge_current_ma / 1000.0f;  // mA to A
 }
 
 float VictronMPPT::getPanelVoltage() const {
-    return _pv_voltage_mv / 1000.0f;  // mV to V
+    return _data.pv_voltage_mv / 1000.0f;  // mV to V
 }
 
 float VictronMPPT::getPanelPower() const {
-    return (float)_pv_power_w;  // Already in W
+    return (float)_data.pv_power_w;  // Already in W
 }
 
 ChargeState VictronMPPT::getChargeStateEnum() const {
-    return _charge_state;
+    return _data.charge_state;
 }
 
 String VictronMPPT::getChargeState() const {
-    return chargeStateToString(_charge_state);
+    return chargeStateToString(_data.charge_state);
 }
 
 int VictronMPPT::getErrorCode() const {
-    return _error_code;
+    return _data.error_code;
 }
 
 String VictronMPPT::getErrorString() const {
-    return errorCodeToString(_error_code);
+    return errorCodeToString(_data.error_code);
 }
 
 String VictronMPPT::getLoadState() const {
-    return _load_state;
+    return _data.load_state;
 }
 
 float VictronMPPT::getLoadCurrent() const {
-    return _load_current_ma / 1000.0f;  // mA to A
+    return _data.load_current_ma / 1000.0f;  // mA to A
 }
 
 float VictronMPPT::getYieldToday() const {
-    return _yield_today * 0.01f;  // 0.01 kWh to kWh
+    return _data.yield_today * 0.01f;  // 0.01 kWh to kWh
 }
 
 float VictronMPPT::getYieldYesterday() const {
-    return _yield_yesterday * 0.01f;  // 0.01 kWh to kWh
+    return _data.yield_yesterday * 0.01f;  // 0.01 kWh to kWh
 }
 
 float VictronMPPT::getYieldTotal() const {
-    return _yield_total * 0.01f;  // 0.01 kWh to kWh
+    return _data.yield_total * 0.01f;  // 0.01 kWh to kWh
 }
 
 int VictronMPPT::getMaxPowerToday() const {
-    return _max_power_today;
+    return _data.max_power_today;
 }
 
 int VictronMPPT::getMaxPowerYesterday() const {
-    return _max_power_yesterday;
+    return _data.max_power_yesterday;
+}
+
+int VictronMPPT::getDaySequence() const {
+    return _data.day_sequence;
 }
 
 bool VictronMPPT::isDataValid() const {
@@ -258,3 +285,11 @@ bool VictronMPPT::isDataValid() const {
 unsigned long VictronMPPT::getLastUpdate() const {
     return _lastUpdate;
 }
+
+uint32_t VictronMPPT::getBlockCount() const {
+    return _blockCount;
+}
+
+uint32_t VictronMPPT::getChecksumErrors() const {
+    return _checksumErrors;
+}
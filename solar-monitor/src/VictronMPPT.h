@@ -71,10 +71,13 @@ public:
     float getYieldTotal() const;        // Returns kWh
     int getMaxPowerToday() const;       // Returns watts
     int getMaxPowerYesterday() const;   // Returns watts
+    int getDaySequence() const;         // HSDS day number (0..364), -1 if not reported
 
     // Status
     bool isDataValid() const;           // True if receiving valid data
     unsigned long getLastUpdate() const; // millis() of last valid update
+    uint32_t getBlockCount() const;     // Valid blocks committed since boot (changes when data changes)
+    uint32_t getChecksumErrors() const; // Blocks dropped for a bad checksum (lost or corrupted bytes)
 
 private:
     Stream* _serial;
@@ -82,40 +85,55 @@ private:
     // Parse a single VE.Direct line
     void parseLine(const String& line);
 
+    // Commit the block just ended by its checksum byte
+    void endBlock(bool intact);
+
     // Convert charge state code to string
     static String chargeStateToString(ChargeState state);
 
     // Convert error code to string
     static String errorCodeToString(int code);
 
-    // Device identification (captured once)
-    String _product_id;         // PID: Product ID
-    String _serial_number;      // SER#: Serial number
-
-    // Data storage (raw values from device)
-    int32_t _batt_voltage_mv;   // Battery voltage in mV
-    int32_t _charge_current_ma; // Charge current in mA
-    int32_t _pv_voltage_mv;     // Panel voltage in mV
-    int32_t _pv_power_w;        // Panel power in W
-    ChargeState _charge_state;  // Charge state
-    int _error_code;            // Error code
-
-    // Load output data (for models with load output)
-    String _load_state;         // LOAD: ON or OFF
-    int32_t _load_current_ma;   // IL: Load current in mA
-
-    // Yield data (raw values)
-    int32_t _yield_today;       // H20: Today's yield in 0.01 kWh
-    int32_t _yield_yesterday;   // H22: Yesterday's yield in 0.01 kWh
-    int32_t _yield_total;       // H19: Total yield in 0.01 kWh
-    int32_t _max_power_today;   // H21: Max power today in W
-    int32_t _max_power_yesterday; // H23: Max power yesterday in W
+    // Raw values from the device. Lines of a block are parsed into _block and
+    // copied to _data only when the block's checksum holds.
+    struct Data {
+        // Device identification (captured once)
+        String product_id;    // PID: Product ID
+        String serial_number; // SER#: Serial number
+
+        // Live readings
+        int32_t batt_voltage_mv = 0;                     // Battery voltage in mV
+        int32_t charge_current_ma = 0;                   // Charge current in mA
+        int32_t pv_voltage_mv = 0;                       // Panel voltage in mV
+        int32_t pv_power_w = 0;                          // Panel power in W
+        ChargeState charge_state = ChargeState::UNKNOWN; // Charge state
+        int error_code = 0;                              // Error code
+
+        // Load output data (for models with load output)
+        String load_state = "OFF";   // LOAD: ON or OFF
+        int32_t load_current_ma = 0; // IL: Load current in mA
+
+        // Yield data (raw values)
+        int32_t yield_today = 0;         // H20: Today's yield in 0.01 kWh
+        int32_t yield_yesterday = 0;     // H22: Yesterday's yield in 0.01 kWh
+        int32_t yield_total = 0;         // H19: Total yield in 0.01 kWh
+        int32_t max_power_today = 0;     // H21: Max power today in W
+        int32_t max_power_yesterday = 0; // H23: Max power yesterday in W
+        int32_t day_sequence = -1;       // HSDS: Day sequence number
+    };
+    Data _data;
+    Data _block;
 
     // Parsing state
     String _lineBuffer;
     unsigned long _lastUpdate;
     bool _dataValid;
+    uint32_t _blockCount;
     uint8_t _fieldsReceived;
+    uint8_t _checksum;          // Running byte sum of the current block
+    bool _awaitingChecksum;     // Next byte is the checksum byte
+    bool _checksumSynced;       // A block boundary has been seen
+    uint32_t _checksumErrors;
 
     // Constants
     static const uint8_t MIN_FIELDS_FOR_VALID = 3;
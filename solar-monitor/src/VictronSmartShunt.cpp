@@ -6,24 +6,17 @@
 
 #include "VictronSmartShunt.h"
 
-VictronSmartShunt::VictronSmartShunt(HardwareSerial* serial)
+VictronSmartShunt::VictronSmartShunt(Stream* serial)
     : _serial(serial)
-    , _voltage_mv(0)
-    , _current_ma(0)
-    , _soc_tenth(0)
-    , _ttg_min(-1)
-    , _consumed_mah(0)
-    , _alarm(false)
-    , _relay(false)
-    , _min_voltage_mv(0)
-    , _max_voltage_mv(0)
-    , _charge_cycles(0)
-    , _deepest_discharge_mah(0)
-    , _last_discharge_mah(0)
     , _lineBuffer("")
     , _lastUpdate(0)
     , _dataValid(false)
+    , _blockCount(0)
     , _fieldsReceived(0)
+    , _checksum(0)
+    , _awaitingChecksum(false)
+    , _checksumSynced(false)
+    , _checksumErrors(0)
 {
 }
 
@@ -37,6 +30,19 @@ void VictronSmartShunt::update() {
     while (_serial->available()) {
         char c = _serial->read();
 
+        // All bytes of a block, from its leading CRLF to the checksum byte,
+        // sum to 0 mod 256
+        _checksum += (uint8_t)c;
+        if (_awaitingChecksum) {
+            // The checksum byte (any value, even '\n') ends the block; the
+            // next block's CRLF follows a second later
+            _awaitingChecksum = false;
+            endBlock(_checksum == 0);
+            _checksum = 0;
+            _lineBuffer = "";
+            continue;
+        }
+
         if (c == '\n') {
             // End of line - parse it
             if (_lineBuffer.length() > 0) {
@@ -50,6 +56,9 @@ void VictronSmartShunt::update() {
             if (_lineBuffer.length() < 64) {
                 _lineBuffer += c;
             }
+            if (c == '\t' && _lineBuffer == "Checksum\t") {
+                _awaitingChecksum = true;
+            }
         }
     }
 }
@@ -67,113 +76,222 @@ void VictronSmartShunt::parseLine(const String& line) {
     // Parse known fields
     if (key == "V") {
         // Battery voltage in mV
-        _voltage_mv = value.toInt();
+        _block.voltage_mv = value.toInt();
         _fieldsReceived++;
     }
     else if (key == "I") {
         // Battery current in mA (signed: negative = discharge)
-        _current_ma = value.toInt();
+        _block.current_ma = value.toInt();
         _fieldsReceived++;
     }
+    else if (key == "P") {
+        // Instantaneous power in W (signed)
+        _block.power_w = value.toInt();
+    }
     else if (key == "SOC") {
         // State of charge in 0.1%
-        _soc_tenth = value.toInt();
+        _block.soc_tenth = value.toInt();
         _fieldsReceived++;
     }
     else if (key == "TTG") {
         // Time to go in minutes (-1 = infinite)
-        _ttg_min = value.toInt();
+        _block.ttg_min = value.toInt();
     }
     else if (key == "CE") {
         // Consumed Ah in mAh (negative value)
-        _consumed_mah = value.toInt();
+        _block.consumed_mah = value.toInt();
     }
     else if (key == "Alarm") {
         // Alarm state: ON/OFF
-        _alarm = (value == "ON");
+        _block.alarm = (value == "ON");
     }
     else if (key == "Relay") {
         // Relay state: ON/OFF
-        _relay = (value == "ON");
+        _block.relay = (value == "ON");
     }
     else if (key == "H1") {
         // Depth of deepest discharge in mAh
-        _deepest_discharge_mah = value.toInt();
+        _block.deepest_discharge_mah = value.toInt();
     }
     else if (key == "H2") {
         // Depth of last discharge in mAh
-        _last_discharge_mah = value.toInt();
+        _block.last_discharge_mah = value.toInt();
+    }
+    else if (key == "H3") {
+        // Depth of average discharge in mAh
+        _block.average_discharge_mah = value.toInt();
     }
     else if (key == "H4") {
         // Number of charge cycles
-        _charge_cycles = value.toInt();
+        _block.charge_cycles = value.toInt();
+    }
+    else if (key == "H5") {
+        // Number of full discharges
+        _block.full_discharges = value.toInt();
+    }
+    else if (key == "H6") {
+        // Cumulative Ah drawn in mAh
+        _block.cumulative_mah = value.toInt();
     }
     else if (key == "H7") {
         // Minimum battery voltage in mV
-        _min_voltage_mv = value.toInt();
+        _block.min_voltage_mv = value.toInt();
     }
     else if (key == "H8") {
         // Maximum battery voltage in mV
-        _max_voltage_mv = value.toInt();
+        _block.max_voltage_mv = value.toInt();
+    }
+    else if (key == "H9") {
+        // Seconds since last full charge
+        _block.seconds_since_full = value.toInt();
+    }
+    else if (key == "H10") {
+        // Number of automatic synchronizations
+        _block.sync_count = value.toInt();
+    }
+    else if (key == "H11") {
+        // Number of low main voltage alarms
+        _block.low_voltage_alarms = value.toInt();
+    }
+    else if (key == "H12") {
+        // Number of high main voltage alarms
+        _block.high_voltage_alarms = value.toInt();
+    }
+    else if (key == "H15") {
+        // Minimum auxiliary (starter) voltage in mV
+        _block.min_aux_voltage_mv = value.toInt();
     }
-    else if (key == "Checksum") {
-        // End of data block - mark as valid if we have enough fields
+    else if (key == "H16") {
+        // Maximum auxiliary (starter) voltage in mV
+        _block.max_aux_voltage_mv = value.toInt();
+    }
+    else if (key == "H17") {
+        // Discharged energy in 0.01 kWh
+        _block.discharged_energy = value.toInt();
+    }
+    else if (key == "H18") {
+        // Charged energy in 0.01 kWh
+        _block.charged_energy = value.toInt();
+    }
+}
+
+void VictronSmartShunt::endBlock(bool intact) {
+    // An intact block replaces the live values; a damaged one is dropped with
+    // everything it parsed. Mark as valid if the block had enough fields. The
+    // first block after boot starts mid-stream and only synchronises the checksum.
+    if (intact) {
+        _data = _block;
         if (_fieldsReceived >= MIN_FIELDS_FOR_VALID) {
             _dataValid = true;
             _lastUpdate = millis();
+            _blockCount++;
+        }
+    } else {
+        _block = _data;
+        if (_checksumSynced) {
+            _checksumErrors++;
         }
-        _fieldsReceived = 0;  // Reset for next block
     }
+    _checksumSynced = true;
+    _fieldsReceived = 0;  // Reset for next block
 }
 
 // Getters - convert raw values to user-friendly units
 
 float VictronSmartShunt::getBatteryVoltage() const {
-    return _voltage_mv / 1000.0f;  // mV to V
+    return _data.voltage_mv / 1000.0f;  // mV to V
 }
 
 float VictronSmartShunt::getBatteryCurrent() const {
-    return _current_ma / 1000.0f;  // mA to A
+    return _data.current_ma / 1000.0f;  // mA to A
 }
 
 float VictronSmartShunt::getStateOfCharge() const {
-    return _soc_tenth / 10.0f;  // 0.1% to %
+    return _data.soc_tenth / 10.0f;  // 0.1% to %
+}
+
+int VictronSmartShunt::getPower() const {
+    return _data.power_w;
 }
 
 int VictronSmartShunt::getTimeRemaining() const {
-    return _ttg_min;
+    return _data.ttg_min;
 }
 
 float VictronSmartShunt::getConsumedAh() const {
-    return abs(_consumed_mah) / 1000.0f;  // mAh to Ah (return positive value)
+    return abs(_data.consumed_mah) / 1000.0f;  // mAh to Ah (return positive value)
 }
 
 bool VictronSmartShunt::getAlarmState() const {
-    return _alarm;
+    return _data.alarm;
 }
 
 bool VictronSmartShunt::getRelayState() const {
-    return _relay;
+    return _data.relay;
 }
 
 float VictronSmartShunt::getMinVoltage() const {
-    return _min_voltage_mv / 1000.0f;  // mV to V
+    return _data.min_voltage_mv / 1000.0f;  // mV to V
 }
 
 float VictronSmartShunt::getMaxVoltage() const {
-    return _max_voltage_mv / 1000.0f;  // mV to V
+    return _data.max_voltage_mv / 1000.0f;  // mV to V
 }
 
 int VictronSmartShunt::getChargeCycles() const {
-    return _charge_cycles;
+    return _data.charge_cycles;
 }
 
 float VictronSmartShunt::getDeepestDischarge() const {
-    return abs(_deepest_discharge_mah) / 1000.0f;  // mAh to Ah
+    return abs(_data.deepest_discharge_mah) / 1000.0f;  // mAh to Ah
 }
 
 float VictronSmartShunt::getLastDischarge() const {
-    return abs(_last_discharge_mah) / 1000.0f;  // mAh to Ah
+    return abs(_data.last_discharge_mah) / 1000.0f;  // mAh to Ah
+}
+
+float VictronSmartShunt::getAverageDischarge() const {
+    return abs(_data.average_discharge_mah) / 1000.0f;  // mAh to Ah
+}
+
+int VictronSmartShunt::getFullDischarges() const {
+    return _data.full_discharges;
+}
+
+float VictronSmartShunt::getCumulativeAh() const {
+    return abs(_data.cumulative_mah) / 1000.0f;  // mAh to Ah
+}
+
+long VictronSmartShunt::getSecondsSinceFullCharge() const {
+    return _data.seconds_since_full;
+}
+
+int VictronSmartShunt::getSyncCount() const {
+    return _data.sync_count;
+}
+
+int VictronSmartShunt::getLowVoltageAlarms() const {
+    return _data.low_voltage_alarms;
+}
+
+int VictronSmartShunt::getHighVoltageAlarms() const {
+    return _data.high_voltage_alarms;
+}
+
+float VictronSmartShunt::getMinAuxVoltage() const {
+    return _data.min_aux_voltage_mv / 1000.0f;  // mV to V
+}
+
+float VictronSmartShunt::getMaxAuxVoltage() const {
+    return _data.max_aux_voltage_mv / 1000.0f;  // mV to V
+}
+
+float VictronSmartShunt::getDischargedEnergy() const {
+    return _data.discharged_energy / 100.0f;  // 0.01 kWh to kWh
+}
+
+float VictronSmartShunt::getChargedEnergy() const {
+    return _data.charged_energy / 100.0f;  // 0.01 kWh to kWh
 }
 
 bool VictronSmartShunt::isDataValid() const {
@@ -184,3 +302,11 @@ bool VictronSmartShunt::isDataValid() const {
 unsigned long VictronSmartShunt::getLastUpdate() const {
     return _lastUpdate;
 }
+
+uint32_t VictronSmartShunt::getBlockCount() const {
+    return _blockCount;
+}
+
+uint32_t VictronSmartShunt::getChecksumErrors() const {
+    return _checksumErrors;
+}
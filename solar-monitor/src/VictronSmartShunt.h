@@ -13,15 +13,15 @@
 #define VICTRON_SMARTSHUNT_H
 
 #include <Arduino.h>
-#include <HardwareSerial.h>
+#include <Stream.h>
 
 class VictronSmartShunt {
 public:
     /**
      * Constructor
-     * @param serial Pointer to HardwareSerial instance (UART2 recommended)
+     * @param serial Pointer to Stream instance (UART2 recommended, or a recorder tap)
      */
-    VictronSmartShunt(HardwareSerial* serial);
+    VictronSmartShunt(Stream* serial);
 
     /**
      * Initialize the SmartShunt connection
@@ -38,6 +38,7 @@ public:
     // Primary data getters
     float getBatteryVoltage() const;    // Returns volts
     float getBatteryCurrent() const;    // Returns amps (negative = discharge)
+    int getPower() const;               // Returns watts (negative = discharge)
     float getStateOfCharge() const;     // Returns percentage (0-100)
     int getTimeRemaining() const;       // Returns minutes (-1 = infinite)
     float getConsumedAh() const;        // Returns amp-hours consumed
@@ -50,38 +51,77 @@ public:
     int getChargeCycles() const;        // Number of charge cycles
     float getDeepestDischarge() const;  // Deepest discharge in Ah
     float getLastDischarge() const;     // Last discharge depth in Ah
+    float getAverageDischarge() const;  // Average discharge depth in Ah
+    int getFullDischarges() const;      // Number of full discharges
+    float getCumulativeAh() const;      // Cumulative Ah drawn
+    long getSecondsSinceFullCharge() const;
+    int getSyncCount() const;           // Number of automatic synchronizations
+    int getLowVoltageAlarms() const;
+    int getHighVoltageAlarms() const;
+    float getMinAuxVoltage() const;     // Minimum starter/aux voltage recorded
+    float getMaxAuxVoltage() const;     // Maximum starter/aux voltage recorded
+    float getDischargedEnergy() const;  // Total discharged energy in kWh
+    float getChargedEnergy() const;     // Total charged energy in kWh
 
     // Status
     bool isDataValid() const;           // True if receiving valid data
     unsigned long getLastUpdate() const; // millis() of last valid update
+    uint32_t getBlockCount() const;     // Valid blocks committed since boot (changes when data changes)
+    uint32_t getChecksumErrors() const; // Blocks dropped for a bad checksum (lost or corrupted bytes)
 
 private:
-    HardwareSerial* _serial;
+    Stream* _serial;
 
     // Parse a single VE.Direct line
     void parseLine(const String& line);
 
-    // Data storage (raw values from device)
-    int32_t _voltage_mv;        // Battery voltage in mV
-    int32_t _current_ma;        // Battery current in mA (signed)
-    int16_t _soc_tenth;         // State of charge in 0.1%
-    int16_t _ttg_min;           // Time to go in minutes
-    int32_t _consumed_mah;      // Consumed energy in mAh
-    bool _alarm;                // Alarm state
-    bool _relay;                // Relay state
-
-    // Historical data (raw values)
-    int32_t _min_voltage_mv;    // H7: Minimum voltage in mV
-    int32_t _max_voltage_mv;    // H8: Maximum voltage in mV
-    int32_t _charge_cycles;     // H4: Number of charge cycles
-    int32_t _deepest_discharge_mah;  // H1: Deepest discharge in mAh
-    int32_t _last_discharge_mah;     // H2: Last discharge in mAh
+    // Commit the block just ended by its checksum byte
+    void endBlock(bool intact);
+
+    // Raw values from the device. Lines of a block are parsed into _block and
+    // copied to _data only when the block's checksum holds.
+    struct Data {
+        // Live readings
+        int32_t voltage_mv = 0;   // Battery voltage in mV
+        int32_t current_ma = 0;   // Battery current in mA (signed)
+        int32_t power_w = 0;      // Instantaneous power in W (signed)
+        int16_t soc_tenth = 0;    // State of charge in 0.1%
+        int16_t ttg_min = -1;     // Time to go in minutes
+        int32_t consumed_mah = 0; // Consumed energy in mAh
+        bool alarm = false;       // Alarm state
+        bool relay = false;       // Relay state
+
+        // Historical data (raw values)
+        int32_t min_voltage_mv = 0;        // H7: Minimum voltage in mV
+        int32_t max_voltage_mv = 0;        // H8: Maximum voltage in mV
+        int32_t charge_cycles = 0;         // H4: Number of charge cycles
+        int32_t deepest_discharge_mah = 0; // H1: Deepest discharge in mAh
+        int32_t last_discharge_mah = 0;    // H2: Last discharge in mAh
+        int32_t average_discharge_mah = 0; // H3: Average discharge in mAh
+        int32_t full_discharges = 0;       // H5: Number of full discharges
+        int32_t cumulative_mah = 0;        // H6: Cumulative Ah drawn in mAh
+        int32_t seconds_since_full = 0;    // H9: Seconds since last full charge
+        int32_t sync_count = 0;            // H10: Number of automatic synchronizations
+        int32_t low_voltage_alarms = 0;    // H11: Number of low voltage alarms
+        int32_t high_voltage_alarms = 0;   // H12: Number of high voltage alarms
+        int32_t min_aux_voltage_mv = 0;    // H15: Minimum aux voltage in mV
+        int32_t max_aux_voltage_mv = 0;    // H16: Maximum aux voltage in mV
+        int32_t discharged_energy = 0;     // H17: Discharged energy in 0.01 kWh
+        int32_t charged_energy = 0;        // H18: Charged energy in 0.01 kWh
+    };
+    Data _data;
+    Data _block;
 
     // Parsing state
     String _lineBuffer;
     unsigned long _lastUpdate;
     bool _dataValid;
+    uint32_t _blockCount;
     uint8_t _fieldsReceived;    // Track how many fields in current block
+    uint8_t _checksum;          // Running byte sum of the current block
+    bool _awaitingChecksum;     // Next byte is the checksum byte
+    bool _checksumSynced;       // A block boundary has been seen
+    uint32_t _checksumErrors;
 
     // Constants
     static const uint8_t MIN_FIELDS_FOR_VALID = 3;  // Minimum fields to consider data valid
@@ -0,0 +1,1494 @@
+/**
+ * host_main.cpp
+ *
+ * Native host runner for the solar monitor (env:native, not part of the
+ * firmware image). Replays VE.Direct captures through the real drivers,
+ * benchmarks the parsing hot path, replays multi-day battery traces through
+ * the BatteryAnalytics estimator, runs the MpptComparator on two MPPT
+ * captures and load-tests the Modbus-TCP server with
+ * concurrent host clients on localhost (port MODBUS_PORT, default 15020).
+ * The RuleEngine is checked for compile errors, hysteresis, debounce and
+ * missing-data behaviour, and its cost per block is benchmarked. Rule
+ * webhooks are queued against a dead endpoint to check post() never waits.
+ * The DailyLedger is run through 400 simulated days (ring wrap, both
+ * rollover detection paths, a restart mid-day) and checked day by day.
+ * The VE.Direct black-box recorder is checked against a file-backed flash
+ * partition (record, download, replay through the parsers), and a log
+ * downloaded from /api/vedlog can be replayed with --vedlog.
+ * The power manager's burst windows are run against ten simulated minutes
+ * of all three ports (frame loss through the parsers' checksums, time
+ * awake, estimated current).
+ * HTTP load (dashboard pollers, a /api/daily pager and a /api/vedlog
+ * download) is run against a simulated loop() twice: served inside loop()
+ * as the synchronous WebServer did, and by async handlers from HttpSnapshot
+ * bodies; the longest loop() iteration is compared.
+ *
+ * Usage:
+ *   pio run -e native -t exec
+ *   .pio/build/native/program [--mppt capture.txt] [--mppt2 capture.txt] [--shunt capture.txt]
+ *                             [--battery-trace trace.csv] [--vedlog vedlog.bin]
+ *
+ * Captures are raw VE.Direct text as read from the UART (e.g. `cat /dev/ttyUSB0`).
+ * Without arguments a synthetic block with a valid checksum is used.
+ * With --mppt and --mppt2, the two captures are split into blocks and
+ * replayed side by side (one block per second) through the comparator;
+ * without them a simulated day with shading, a failed string and an ERR
+ * transition is used.
+ *
+ * Battery traces are CSV lines "unix_seconds,voltage_v,current_a,soc_pct"
+ * (e.g. exported from the InfluxDB battery measurement); lines that do not
+ * parse are skipped. Without a trace, a 14-day simulated battery with a known
+ * capacity is used and the estimates are compared against it.
+ */
+
+#ifdef NATIVE_HOST
+
+#include <Arduino.h>
+#include <HostBench.h>
+#include <HostCheck.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "VictronMPPT.h"
+#include "VictronSmartShunt.h"
+#include "BatteryAnalytics.h"
+#include "MpptComparator.h"
+#include "DailyLedger.h"
+#include "RuleEngine.h"
+#include "loop_profiler.h"
+#include "modbus_server.h"
+#include "vedirect_recorder.h"
+#include "power_manager.h"
+#include "http_snapshot.h"
+#include "webhook_queue.h"
+#include <esp_partition.h>
+#include <SPIFFS.h>
+
+// VE.Direct checksum: all bytes of a block, including the checksum byte, sum to 0 mod 256
+static std::string buildBlock(const std::vector<std::pair<const char*, const char*>>& fields) {
+    std::string block;
+    for (const auto& field : fields) {
+        block += "\r\n";
+        block += field.first;
+        block += "\t";
+        block += field.second;
+    }
+    block += "\r\nChecksum\t";
+    uint8_t sum = 0;
+    for (char c : block) {
+        sum += (uint8_t)c;
+    }
+    block += (char)(uint8_t)(256 - sum);
+    return block;
+}
+
+static std::string sampleMpptBlock() {
+    return buildBlock({
+        {"PID", "0xA060"}, {"FW", "159"}, {"SER#", "HQ2222ABCDE"}, {"V", "13250"},
+        {"I", "4500"}, {"VPV", "36120"}, {"PPV", "62"}, {"CS", "3"}, {"MPPT", "2"},
+        {"OR", "0x00000000"}, {"ERR", "0"}, {"LOAD", "ON"}, {"IL", "300"},
+        {"H19", "10234"}, {"H20", "121"}, {"H21", "412"}, {"H22", "98"}, {"H23", "388"},
+        {"HSDS", "214"}
+    });
+}
+
+static std::string sampleShuntBlock() {
+    return buildBlock({
+        {"PID", "0xA389"}, {"V", "13250"}, {"I", "-1200"}, {"P", "-16"}, {"CE", "-12500"},
+        {"SOC", "876"}, {"TTG", "5460"}, {"Alarm", "OFF"}, {"Relay", "OFF"}, {"AR", "0"},
+        {"BMV", "SmartShunt 500A/50mV"}, {"FW", "0413"}, {"MON", "0"}
+    }) + buildBlock({
+        {"H1", "-61234"}, {"H2", "-12500"}, {"H3", "-40000"}, {"H4", "142"}, {"H5", "0"},
+        {"H6", "-5123456"}, {"H7", "11020"}, {"H8", "14650"}, {"H9", "86400"}, {"H10", "12"},
+        {"H11", "0"}, {"H12", "0"}, {"H15", "0"}, {"H16", "0"}, {"H17", "45210"}, {"H18", "51234"}
+    });
+}
+
+static bool readFile(const char* path, std::string& out) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        printf("[HOST] Cannot open %s\n", path);
+        return false;
+    }
+    char buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0) {
+        out.append(buffer, n);
+    }
+    fclose(f);
+    return true;
+}
+
+// Feed data in UART-sized chunks, calling update() in between like loop() does
+template <typename Device>
+static void replay(HostStream& port, Device& device, const std::string& data, size_t chunk = 64) {
+    for (size_t pos = 0; pos < data.size(); pos += chunk) {
+        port.feed((const uint8_t*)data.data() + pos, std::min(chunk, data.size() - pos));
+        device.update();
+    }
+}
+
+// ----------------------------------------------------------------------------
+// MPPT comparison on paired captures
+// ----------------------------------------------------------------------------
+
+// Split a raw capture into blocks ending with the checksum byte
+static std::vector<std::string> splitBlocks(const std::string& data) {
+    std::vector<std::string> blocks;
+    size_t start = 0;
+    size_t pos;
+    while ((pos = data.find("Checksum\t", start)) != std::string::npos && pos + 9 < data.size()) {
+        blocks.push_back(data.substr(start, pos + 10 - start));
+        start = pos + 10;
+    }
+    return blocks;
+}
+
+// Simulated day at 1 Hz: MPPT1 carries ~55% of the power. Hour 4 shades
+// MPPT2's array, hour 6 loses a third of MPPT1's string voltage and
+// MPPT2 reports ERR 17 for ten minutes at 6.5 h.
+static void simulateMpptCaptures(std::vector<std::string>& blocks1, std::vector<std::string>& blocks2) {
+    uint32_t noise = 12345;
+    auto jitter = [&](float amplitude) {
+        noise = noise * 1103515245u + 12345u;
+        return ((int)((noise >> 16) % 2001) - 1000) / 1000.0f * amplitude;
+    };
+    for (uint32_t t = 0; t < 8 * 3600; t++) {
+        float hours = t / 3600.0f;
+        float sun = 300.0f + 200.0f * sinf(hours / 8.0f * (float)M_PI);
+        float power1 = sun * 1.1f * (1.0f + jitter(0.03f));
+        float power2 = sun * 0.9f * (1.0f + jitter(0.03f));
+        float voltage1 = 36.0f + jitter(0.4f);
+        float voltage2 = 34.0f + jitter(0.4f);
+        int error2 = 0;
+        if (hours >= 4.0f && hours < 5.0f) power2 *= 0.6f;
+        if (hours >= 6.0f && hours < 7.0f) { voltage1 *= 0.67f; power1 *= 0.67f; }
+        if (hours >= 6.5f && hours < 6.5f + 10.0f / 60.0f) error2 = 17;
+
+        char v1[12], p1[12], v2[12], p2[12], e2[12];
+        snprintf(v1, sizeof(v1), "%d", (int)(voltage1 * 1000));
+        snprintf(p1, sizeof(p1), "%d", (int)power1);
+        snprintf(v2, sizeof(v2), "%d", (int)(voltage2 * 1000));
+        snprintf(p2, sizeof(p2), "%d", (int)power2);
+        snprintf(e2, sizeof(e2), "%d", error2);
+        blocks1.push_back(buildBlock({{"PID", "0xA060"}, {"V", "13250"}, {"I", "20000"}, {"VPV", v1},
+                                      {"PPV", p1}, {"CS", "3"}, {"ERR", "0"}}));
+        blocks2.push_back(buildBlock({{"PID", "0xA060"}, {"V", "13250"}, {"I", "16000"}, {"VPV", v2},
+                                      {"PPV", p2}, {"CS", error2 ? "2" : "3"}, {"ERR", e2}}));
+    }
+}
+
+static const char* mpptEventName(MpptComparator::EventType type) {
+    switch (type) {
+        case MpptComparator::POWER_DEVIATION: return "power deviation";
+        case MpptComparator::POWER_RECOVERED: return "power recovered";
+        case MpptComparator::VOLTAGE_DEVIATION: return "voltage deviation";
+        case MpptComparator::VOLTAGE_RECOVERED: return "voltage recovered";
+        case MpptComparator::ERROR_RAISED: return "error raised";
+        case MpptComparator::ERROR_CLEARED: return "error cleared";
+    }
+    return "?";
+}
+
+static uint32_t s_replayTimeMs = 0;
+static uint32_t s_mpptEventTypes = 0;     // Bit per EventType seen in the last comparison
+
+static void printMpptEvent(const MpptComparator::Event& event) {
+    s_mpptEventTypes |= 1u << event.type;
+    printf("[HOST] MPPT event at %5.2f h: %-17s MPPT%u value %.3f baseline %.3f z %.1f\n",
+           s_replayTimeMs / 3600000.0f, mpptEventName(event.type), event.charger + 1,
+           event.value, event.baseline, event.zScore);
+}
+
+static MpptComparator::Reading readingOf(const VictronMPPT& mppt) {
+    return {mppt.isDataValid(), mppt.getPanelVoltage(), mppt.getPanelPower(),
+            (uint8_t)mppt.getChargeStateEnum(), mppt.getErrorCode()};
+}
+
+static void checkMpptComparison(const std::vector<std::string>& blocks1, const std::vector<std::string>& blocks2) {
+    HardwareSerial port1(1);
+    HardwareSerial port2(2);
+    VictronMPPT charger1(&port1);
+    VictronMPPT charger2(&port2);
+    MpptComparator comparator;
+    comparator.setEventHandler(printMpptEvent);
+    s_mpptEventTypes = 0;
+
+    // Both chargers emit one block per second; replay them side by side through the real parsers
+    size_t frames = std::min(blocks1.size(), blocks2.size());
+    for (size_t i = 0; i < frames; i++) {
+        s_replayTimeMs = i * 1000;
+        port1.feed((const uint8_t*)blocks1[i].data(), blocks1[i].size());
+        port2.feed((const uint8_t*)blocks2[i].data(), blocks2[i].size());
+        charger1.update();
+        charger2.update();
+        comparator.update(s_replayTimeMs, readingOf(charger1), readingOf(charger2));
+    }
+    printf("[HOST] MPPT comparison: %zu frames, %u compared, share %.3f (baseline %.3f), "
+           "voltage ratio %.3f (baseline %.3f), %u events\n",
+           frames, comparator.getComparedFrames(), comparator.getPowerShare(), comparator.getPowerShareBaseline(),
+           comparator.getVoltageRatio(), comparator.getVoltageRatioBaseline(), comparator.getEventCount());
+
+    MpptComparator::Reading a = readingOf(charger1);
+    MpptComparator::Reading b = readingOf(charger2);
+    a.chargeState = b.chargeState = 3;
+    comparator.setEventHandler(nullptr);
+    HostBench::run("MpptComparator update (per frame)", 200000, [&]() {
+        s_replayTimeMs += 1000;
+        comparator.update(s_replayTimeMs, a, b);
+    });
+}
+
+// ----------------------------------------------------------------------------
+// Battery analytics on multi-day traces
+// ----------------------------------------------------------------------------
+
+static const float SIM_NOMINAL_AH = 200.0f;     // SmartShunt setting / estimator nominal
+static const float SIM_TRUE_AH = 170.0f;        // Aged battery actually holds this much
+static const float SIM_EMPTY_V = 11.8f;
+
+// Open-circuit voltage vs fraction of true capacity (12 V LiFePO4-like curve)
+static float simOcv(float fraction) {
+    static const float points[][2] = {{0.0f, 11.0f}, {0.05f, 11.8f}, {0.1f, 12.2f}, {0.9f, 13.0f}, {1.0f, 13.4f}};
+    for (size_t i = 1; i < sizeof(points) / sizeof(points[0]); i++) {
+        if (fraction <= points[i][0]) {
+            float t = (fraction - points[i - 1][0]) / (points[i][0] - points[i - 1][0]);
+            return points[i - 1][1] + t * (points[i][1] - points[i - 1][1]);
+        }
+    }
+    return points[4][1];
+}
+
+// Household load by UTC hour (A) and solar charge (A) for a sunny or cloudy day
+static float simLoad(int hour) {
+    if (hour < 6) return 4.0f;
+    if (hour < 9) return 6.0f;
+    if (hour < 17) return 3.0f;
+    return 9.0f;
+}
+
+static float simSolar(int secondsOfDay, bool sunny) {
+    float hours = secondsOfDay / 3600.0f;
+    if (hours < 7.0f || hours > 19.0f) return 0.0f;
+    return (sunny ? 25.0f : 5.0f) * sinf((hours - 7.0f) / 12.0f * (float)M_PI);
+}
+
+struct BatteryTraceSample {
+    uint32_t unixSeconds;
+    float voltage;
+    float current;
+    float soc;
+    float trueRemainingAh;  // Simulation only, -1 for recorded traces
+};
+
+// Simulated SmartShunt: counts against its nominal setting and resyncs to
+// 100% when the battery is really full, like the real one does
+static std::vector<BatteryTraceSample> simulateBatteryTrace() {
+    const char* weather = "SSCCSSSCCSSSCS";  // S = sunny, C = cloudy
+    const uint32_t start = 1735689600;        // 2025-01-01 00:00 UTC
+    std::vector<BatteryTraceSample> trace;
+    float charge = SIM_TRUE_AH;
+    float shuntConsumed = 0;
+    for (uint32_t t = 0; t < strlen(weather) * 86400u; t++) {
+        int secondsOfDay = t % 86400;
+        float current = simSolar(secondsOfDay, weather[t / 86400] == 'S') - simLoad(secondsOfDay / 3600);
+        if (charge >= SIM_TRUE_AH && current > 0) {
+            current = 0;  // Charger in float
+        }
+        if (charge <= 0 && current < 0) {
+            current = 0;  // Low-voltage disconnect
+        }
+        charge = constrain(charge + current / 3600.0f, 0.0f, SIM_TRUE_AH);
+        shuntConsumed = charge >= SIM_TRUE_AH ? 0 : shuntConsumed - current / 3600.0f;
+        float soc = constrain(100.0f - shuntConsumed / SIM_NOMINAL_AH * 100.0f, 0.0f, 100.0f);
+        float voltage = simOcv(charge / SIM_TRUE_AH) + 0.005f * current;
+        trace.push_back({start + t, voltage, current, soc, charge});
+    }
+    return trace;
+}
+
+static bool loadBatteryTrace(const char* path, std::vector<BatteryTraceSample>& trace) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        printf("[HOST] Cannot open %s\n", path);
+        return false;
+    }
+    char line[128];
+    while (fgets(line, sizeof(line), f)) {
+        BatteryTraceSample sample;
+        if (sscanf(line, "%u,%f,%f,%f", &sample.unixSeconds, &sample.voltage, &sample.current, &sample.soc) == 4) {
+            sample.trueRemainingAh = -1;
+            trace.push_back(sample);
+        }
+    }
+    fclose(f);
+    return !trace.empty();
+}
+
+static void checkBatteryAnalytics(const std::vector<BatteryTraceSample>& trace, bool simulated) {
+    BatteryAnalytics analytics(SIM_NOMINAL_AH, SIM_EMPTY_V);
+    uint32_t firstSecond = trace.front().unixSeconds;
+    uint32_t lastDay = UINT32_MAX;
+    bool wasEmpty = false;
+
+    // Forecasts issued at 18:00 UTC, scored once the battery actually runs out
+    std::vector<std::pair<uint32_t, int>> forecasts;
+
+    for (const auto& sample : trace) {
+        analytics.update((sample.unixSeconds - firstSecond) * 1000, sample.voltage, sample.current, sample.soc,
+                         sample.unixSeconds % 86400);
+
+        uint32_t day = (sample.unixSeconds - firstSecond) / 86400;
+        if (sample.unixSeconds % 86400 == 18 * 3600) {
+            forecasts.push_back({sample.unixSeconds, analytics.getTimeToGo()});
+        }
+        if (day != lastDay && sample.unixSeconds % 86400 == 0) {
+            printf("[HOST] Battery day %2u: SoC %5.1f%% capacity %.1f Ah SoH %.1f%% (%u samples) TTG %d min\n",
+                   day, sample.soc, analytics.getCapacityAh(), analytics.getStateOfHealth(),
+                   analytics.getCapacitySamples(), analytics.getTimeToGo());
+            lastDay = day;
+        }
+
+        bool empty = simulated && sample.trueRemainingAh <= 0;
+        if (empty && !wasEmpty) {
+            for (const auto& forecast : forecasts) {
+                int actual = (int)((sample.unixSeconds - forecast.first) / 60);
+                if (actual <= 36 * 60) {
+                    printf("[HOST] Battery empty: forecast at -%d min said %d min (error %+d min)\n",
+                           actual, forecast.second, forecast.second < 0 ? 0 : forecast.second - actual);
+                }
+            }
+        }
+        if (!empty && wasEmpty) {
+            forecasts.clear();
+        }
+        wasEmpty = empty;
+    }
+
+    printf("[HOST] Battery %s: %zu samples, %u full charges, capacity %.1f Ah SoH %.1f%% from %u cycle(s)",
+           simulated ? "simulation" : "trace", trace.size(), analytics.getFullCharges(),
+           analytics.getCapacityAh(), analytics.getStateOfHealth(), analytics.getCapacitySamples());
+    if (simulated) {
+        // Usable capacity ends where the loaded voltage hits empty, ~5% above true zero here
+        printf(" (true %.0f Ah, usable to %.1f V ~%.0f Ah)", SIM_TRUE_AH, SIM_EMPTY_V, SIM_TRUE_AH * 0.95f);
+    }
+    printf("\n");
+    if (simulated) {
+        HostCheck::expect(analytics.getCapacitySamples() > 0
+                              && fabsf(analytics.getCapacityAh() - SIM_TRUE_AH * 0.95f) < SIM_TRUE_AH * 0.05f,
+                          "battery capacity estimate within 5% of the usable capacity");
+    }
+
+    HostBench::run("BatteryAnalytics update (1 Hz sample)", (uint32_t)std::min<size_t>(trace.size(), 200000), [&]() {
+        static size_t i = 0;
+        const auto& sample = trace[i++ % trace.size()];
+        analytics.update(sample.unixSeconds * 1000, sample.voltage, sample.current, sample.soc, sample.unixSeconds % 86400);
+    });
+}
+
+// Modbus-TCP load test: the loop side republishes far faster than VE.Direct
+// ever would while clients read the whole map. Every data register encodes the
+// snapshot sequence, so a torn (half-updated) read is detected.
+static uint16_t patternValue(uint16_t sequence, uint16_t reg) {
+    return (uint16_t)(sequence * 7 + reg);
+}
+
+struct ModbusClientResult {
+    std::vector<uint32_t> latencyUs;
+    uint32_t torn = 0;
+    uint32_t errors = 0;
+};
+
+static int connectModbus(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    int noDelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    return fd;
+}
+
+// Send one read request and wait for the reply; returns the response length or -1
+static int modbusTransaction(int fd, uint16_t transaction, uint8_t function, uint16_t start, uint16_t count,
+                             uint8_t* response, size_t capacity) {
+    uint8_t request[12] = {
+        (uint8_t)(transaction >> 8), (uint8_t)transaction, 0, 0, 0, 6, 1, function,
+        (uint8_t)(start >> 8), (uint8_t)start, (uint8_t)(count >> 8), (uint8_t)count
+    };
+    if (send(fd, request, sizeof(request), MSG_NOSIGNAL) != (ssize_t)sizeof(request)) {
+        return -1;
+    }
+    size_t received = 0;
+    while (received < 7 || received < 6u + ((response[4] << 8) | response[5])) {
+        ssize_t n = recv(fd, response + received, capacity - received, 0);
+        if (n <= 0) {
+            return -1;
+        }
+        received += n;
+    }
+    return (int)received;
+}
+
+static void runModbusClient(uint16_t port, uint32_t requests, ModbusClientResult& result) {
+    int fd = connectModbus(port);
+    if (fd < 0) {
+        result.errors = requests;
+        return;
+    }
+    result.latencyUs.reserve(requests);
+    uint8_t response[260];
+    for (uint32_t i = 0; i < requests; i++) {
+        auto start = std::chrono::steady_clock::now();
+        int length = modbusTransaction(fd, (uint16_t)i, 0x04, 0, ModbusServer::REGISTER_COUNT, response, sizeof(response));
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        if (length != 9 + ModbusServer::REGISTER_COUNT * 2 || response[7] != 0x04) {
+            result.errors++;
+            continue;
+        }
+        result.latencyUs.push_back((uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+
+        uint16_t sequence = (response[9 + 2 * ModbusServer::REG_SEQUENCE] << 8) | response[10 + 2 * ModbusServer::REG_SEQUENCE];
+        for (uint16_t reg = ModbusServer::REG_FLAGS; reg < ModbusServer::REGISTER_COUNT; reg++) {
+            uint16_t value = (response[9 + 2 * reg] << 8) | response[10 + 2 * reg];
+            if (value != patternValue(sequence, reg)) {
+                result.torn++;
+                break;
+            }
+        }
+    }
+    close(fd);
+}
+
+static void benchModbus() {
+    const char* portEnv = getenv("MODBUS_PORT");
+    uint16_t port = portEnv ? (uint16_t)atoi(portEnv) : 15020;
+    if (!ModbusServer::begin(port)) {
+        printf("[HOST] Modbus benchmark skipped (port %u unavailable)\n", port);
+        return;
+    }
+
+    auto publishPattern = []() {
+        uint16_t regs[ModbusServer::REGISTER_COUNT];
+        uint16_t sequence = (uint16_t)(ModbusServer::getSnapshots() + 1);
+        for (uint16_t reg = 0; reg < ModbusServer::REGISTER_COUNT; reg++) {
+            regs[reg] = patternValue(sequence, reg);
+        }
+        ModbusServer::publish(regs);
+    };
+    publishPattern();
+    HostBench::run("ModbusServer publish (40 registers)", 200000, publishPattern);
+
+    // Exception path: read past the end of the map
+    int fd = connectModbus(port);
+    uint8_t response[260];
+    int length = fd >= 0 ? modbusTransaction(fd, 1, 0x04, ModbusServer::REGISTER_COUNT - 1, 2, response, sizeof(response)) : -1;
+    bool exception = length == 9 && response[7] == 0x84 && response[8] == 0x02;
+    printf("[HOST] Modbus read past end -> %s\n", exception ? "exception 02 (ok)" : "unexpected reply");
+    HostCheck::expect(exception, "Modbus read past the end answers exception 02");
+    if (fd >= 0) close(fd);
+
+    const uint32_t requestsPerClient = 5000;
+    std::vector<ModbusClientResult> results(MODBUS_MAX_CLIENTS);
+    std::vector<std::thread> clients;
+    std::atomic<bool> done(false);
+    std::thread writer([&]() {
+        // 10 kHz republish, four orders of magnitude above the VE.Direct rate
+        while (!done) {
+            publishPattern();
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    for (auto& result : results) {
+        clients.emplace_back(runModbusClient, port, requestsPerClient, std::ref(result));
+    }
+    for (auto& client : clients) {
+        client.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    done = true;
+    writer.join();
+
+    std::vector<uint32_t> latency;
+    uint32_t torn = 0;
+    uint32_t errors = 0;
+    for (const auto& result : results) {
+        latency.insert(latency.end(), result.latencyUs.begin(), result.latencyUs.end());
+        torn += result.torn;
+        errors += result.errors;
+    }
+    std::sort(latency.begin(), latency.end());
+    auto percentile = [&](double p) { return latency.empty() ? 0 : latency[(size_t)(p * (latency.size() - 1))]; };
+    printf("[HOST] Modbus %d clients x %u reads: %.0f req/s, latency p50 %u us p99 %u us max %u us, torn %u, errors %u\n",
+           MODBUS_MAX_CLIENTS, requestsPerClient, latency.size() / seconds,
+           percentile(0.5), percentile(0.99), percentile(1.0), torn, errors);
+    HostCheck::expect(torn == 0 && errors == 0, "Modbus reads under load are neither torn nor failed");
+    printf("[HOST] Modbus server: %u connections, %u requests, %u exceptions, %u snapshots\n",
+           ModbusServer::getConnections(), ModbusServer::getRequests(),
+           ModbusServer::getExceptions(), ModbusServer::getSnapshots());
+}
+
+// ----------------------------------------------------------------------------
+// VE.Direct black-box recorder
+// ----------------------------------------------------------------------------
+
+// Parsers fed from a recorded log, one port each
+struct LogReplay {
+    HardwareSerial shuntPort{2};
+    HardwareSerial mppt1Port{1};
+    HardwareSerial mppt2Port{3};
+    VictronSmartShunt shunt{&shuntPort};
+    VictronMPPT mppt1{&mppt1Port};
+    VictronMPPT mppt2{&mppt2Port};
+    uint32_t records = 0;
+    uint32_t bytes = 0;
+    uint32_t boots = 0;
+    uint32_t lastBootId = 0;
+    uint32_t lastSequence = 0;
+    uint32_t sequenceGaps = 0;
+    uint32_t firstMs = 0;
+    uint32_t lastMs = 0;
+    std::vector<uint32_t> timestamps;   // Per record, in log order
+};
+
+static void replayRecord(const VeDirectRecorder::SectorHeader& sector, const VeDirectRecorder::RecordHeader& record,
+                         const uint8_t* data, void* context) {
+    LogReplay& replay = *(LogReplay*)context;
+    if (replay.records == 0 || sector.bootId != replay.lastBootId) {
+        replay.boots++;
+        replay.lastBootId = sector.bootId;
+    } else if (sector.sequence != replay.lastSequence && sector.sequence != replay.lastSequence + 1) {
+        replay.sequenceGaps++;
+    }
+    if (replay.records == 0) {
+        replay.firstMs = record.timestampMs;
+    }
+    replay.lastSequence = sector.sequence;
+    replay.lastMs = record.timestampMs;
+    replay.timestamps.push_back(record.timestampMs);
+    replay.records++;
+    replay.bytes += record.length;
+
+    switch (record.port) {
+        case VeDirectRecorder::PORT_SHUNT:
+            replay.shuntPort.feed(data, record.length);
+            replay.shunt.update();
+            break;
+        case VeDirectRecorder::PORT_MPPT1:
+            replay.mppt1Port.feed(data, record.length);
+            replay.mppt1.update();
+            break;
+        case VeDirectRecorder::PORT_MPPT2:
+            replay.mppt2Port.feed(data, record.length);
+            replay.mppt2.update();
+            break;
+    }
+}
+
+static void replayLog(const std::string& log, LogReplay& replay) {
+    VeDirectRecorder::parseLog((const uint8_t*)log.data(), log.size(), replayRecord, &replay);
+
+    printf("[HOST] VeLog replay: %u records, %u bytes, %u boot(s), %u sequence gaps, timestamps span %.1f s\n",
+           replay.records, replay.bytes, replay.boots, replay.sequenceGaps, (replay.lastMs - replay.firstMs) / 1000.0f);
+    printf("[HOST] VeLog replay blocks: shunt %u, MPPT1 %u, MPPT2 %u\n",
+           replay.shunt.getBlockCount(), replay.mppt1.getBlockCount(), replay.mppt2.getBlockCount());
+}
+
+// Whole log including the page in RAM, or the same bytes /api/vedlog serves
+// (flash only, from a cursor)
+static std::string downloadLog(bool flashOnly = false) {
+    std::string log;
+    uint8_t buffer[1024];
+    VeDirectRecorder::Cursor cursor = VeDirectRecorder::getCursor();
+    for (uint16_t sector = 0; sector < cursor.count; sector++) {
+        for (uint16_t offset = 0; offset < VeDirectRecorder::SECTOR_SIZE; offset += sizeof(buffer)) {
+            bool ok = flashOnly ? VeDirectRecorder::readFlash(cursor, sector, offset, buffer, sizeof(buffer))
+                                : VeDirectRecorder::readSector(sector, offset, buffer, sizeof(buffer));
+            if (!ok) {
+                memset(buffer, 0xFF, sizeof(buffer));
+            }
+            log.append((const char*)buffer, sizeof(buffer));
+        }
+    }
+    return log;
+}
+
+// Every record must carry the time its round of traffic was fed: records of
+// one round within CHUNK_FLUSH_MS of its start, so the gaps between them are
+// the gaps between rounds. Returns the number of rounds the log covers.
+static size_t checkRecordTimes(const LogReplay& replay, const std::vector<uint32_t>& roundStarts,
+                               uint32_t& misplaced) {
+    size_t round = 0;
+    size_t covered = 0;
+    bool roundSeen = false;
+    misplaced = 0;
+    for (uint32_t timestamp : replay.timestamps) {
+        while (round + 1 < roundStarts.size() && (int32_t)(timestamp - roundStarts[round + 1]) >= 0) {
+            round++;
+            roundSeen = false;
+        }
+        if ((int32_t)(timestamp - roundStarts[round]) < 0
+            || timestamp - roundStarts[round] > VeDirectRecorder::CHUNK_FLUSH_MS) {
+            misplaced++;
+        } else if (!roundSeen) {
+            roundSeen = true;
+            covered++;
+        }
+    }
+    return covered;
+}
+
+// Record live traffic through the taps, download, replay through fresh
+// parsers: every block must come out the same, at the times it was fed. Then
+// reboot and overrun the ring to check resume and wrap-around.
+static void checkRecorder() {
+    using namespace VeDirectRecorder;
+    const esp_partition_t* partition = hostDefinePartition(VEDLOG_PARTITION_LABEL, ESP_PARTITION_TYPE_DATA,
+                                                           VEDLOG_PARTITION_SUBTYPE, 32 * SECTOR_SIZE);
+    if (!partition) {
+        printf("[HOST] VeLog: cannot create partition\n");
+        return;
+    }
+    esp_partition_erase_range(partition, 0, partition->size);
+
+    HardwareSerial shuntPort(2);
+    HardwareSerial mppt1Port(1);
+    HardwareSerial mppt2Port(3);
+    TapStream shuntTap(&shuntPort, PORT_SHUNT);
+    TapStream mppt1Tap(&mppt1Port, PORT_MPPT1);
+    TapStream mppt2Tap(&mppt2Port, PORT_MPPT2);
+    VictronSmartShunt shunt(&shuntTap);
+    VictronMPPT mppt1(&mppt1Tap);
+    VictronMPPT mppt2(&mppt2Tap);
+
+    // The devices send a block per second: the host clock is moved on a
+    // second per round, so each round's leftover bytes are flushed as its own
+    // records before the next round starts
+    const uint32_t ROUND_MS = 1000;
+    std::string shuntData = sampleShuntBlock();
+    std::string mpptData = sampleMpptBlock();
+    std::vector<uint32_t> roundStarts;
+    auto runTraffic = [&](uint32_t rounds) {
+        roundStarts.clear();
+        for (uint32_t i = 0; i < rounds; i++) {
+            roundStarts.push_back(millis());
+            replay(shuntPort, shunt, shuntData, 32);
+            replay(mppt1Port, mppt1, mpptData, 32);
+            replay(mppt2Port, mppt2, mpptData, 32);
+            hostAdvanceClock(ROUND_MS);
+            VeDirectRecorder::loop();
+        }
+    };
+
+    begin();
+    runTraffic(100);
+    LogReplay first;
+    replayLog(downloadLog(), first);
+    uint32_t recordedMs = roundStarts.back() - roundStarts.front();
+    uint32_t replayedMs = first.lastMs - first.firstMs;
+    uint32_t misplaced;
+    size_t covered = checkRecordTimes(first, roundStarts, misplaced);
+    printf("[HOST] VeLog timing: replay spans %.1f s (recorded %.1f s), %u/%u rounds, %u records off their round\n",
+           replayedMs / 1000.0f, recordedMs / 1000.0f, (unsigned)covered, (unsigned)roundStarts.size(), misplaced);
+    HostCheck::expect(abs((int32_t)(replayedMs - recordedMs)) <= CHUNK_FLUSH_MS && covered == roundStarts.size() && misplaced == 0,
+                      "VeLog replay keeps the recorded span and the gaps between records");
+    bool match = first.shunt.getBlockCount() == shunt.getBlockCount()
+        && first.mppt1.getBlockCount() == mppt1.getBlockCount()
+        && first.mppt2.getBlockCount() == mppt2.getBlockCount()
+        && first.shunt.getStateOfCharge() == shunt.getStateOfCharge()
+        && first.mppt1.getPanelPower() == mppt1.getPanelPower();
+    printf("[HOST] VeLog live blocks:   shunt %u, MPPT1 %u, MPPT2 %u -> replay %s\n",
+           shunt.getBlockCount(), mppt1.getBlockCount(), mppt2.getBlockCount(), match ? "matches" : "MISMATCH");
+    HostCheck::expect(match && first.sequenceGaps == 0, "VeLog replay reproduces every live block");
+    LogReplay flashOnly;
+    replayLog(downloadLog(true), flashOnly);
+    printf("[HOST] VeLog flash-only download (/api/vedlog): %u of %u records (page in RAM not included)\n",
+           flashOnly.records, first.records);
+    HostCheck::expect(flashOnly.records > 0 && flashOnly.records <= first.records && flashOnly.sequenceGaps == 0,
+                      "VeLog flash-only download is a gap-free prefix of the log");
+
+    // Second boot overruns the 32-sector ring
+    begin();
+    runTraffic(200);
+    LogReplay wrapped;
+    replayLog(downloadLog(), wrapped);
+    printf("[HOST] VeLog after reboot + wrap: %u/%u sectors, %u page writes, %u erases, %u failures\n",
+           getSectorCount(), (unsigned)(getCapacityBytes() / SECTOR_SIZE), getPageWrites(), getSectorErases(),
+           getWriteFailures());
+    HostCheck::expect(getSectorCount() == getCapacityBytes() / SECTOR_SIZE && getWriteFailures() == 0
+                          && wrapped.sequenceGaps == 0,
+                      "VeLog wraps the full ring after a reboot without write failures");
+
+    // Cost of the tap on the parse path (host flash is a file, so page
+    // programs here are slower than on the device)
+    HostBench::run("VictronMPPT block parse via recorder tap", 20000, [&]() {
+        mppt1Port.feed(mpptData.c_str());
+        mppt1.update();
+    });
+}
+
+// ----------------------------------------------------------------------------
+// Rule engine
+// ----------------------------------------------------------------------------
+
+static uint32_t s_ruleTimeMs = 0;
+static uint32_t s_ruleTransitions = 0;
+
+static void printRuleAction(const RuleEngine::Rule& rule, bool active) {
+    s_ruleTransitions++;
+    printf("[HOST] Rule %-12s %-7s at %6.1f s\n", rule.name, active ? "active" : "cleared", s_ruleTimeMs / 1000.0f);
+}
+
+static void checkRuleEngine() {
+    // Compile errors point at the offending character
+    const char* bad[] = {"soc <", "soc > 1 &&", "volts < 12", "(soc > 1", "soc >> 2"};
+    RuleEngine::Rule scratch;
+    char error[96];
+    for (const char* expression : bad) {
+        bool ok = RuleEngine::compile(expression, scratch, error, sizeof(error));
+        printf("[HOST] Rule compile \"%s\": %s\n", expression, ok ? "accepted" : error);
+        HostCheck::expect(!ok, "malformed rule expression is rejected");
+    }
+
+    RuleEngine engine;
+    engine.setActionHandler(printRuleAction);
+    RuleEngine::Action action;
+    memset(&action, 0, sizeof(action));
+    action.type = RuleEngine::ACTION_GPIO;
+    engine.addRule("shed_load", "soc < 30", 5, 10000, 30000, action, error, sizeof(error));
+    engine.addRule("overcurrent", "abs(battery_i) > 80", 10, 0, 5000, action, error, sizeof(error));
+
+    // SoC falls 40 -> 25 % and recovers at 0.1 %/s, with a 100 A spike at
+    // 60 s and the shunt silent for two minutes while load is shed
+    float signals[RuleEngine::SIGNAL_COUNT];
+    float soc = 40;
+    for (uint32_t t = 0; t < 600; t++) {
+        s_ruleTimeMs = t * 1000;
+        for (float& value : signals) value = 0;
+        soc += t < 150 ? -0.1f : 0.1f;
+        signals[RuleEngine::SOC] = soc;
+        signals[RuleEngine::BATTERY_I] = t >= 60 && t < 63 ? -100.0f : -10.0f;
+        if (t >= 200 && t < 320) {
+            signals[RuleEngine::SOC] = NAN;
+            signals[RuleEngine::BATTERY_I] = NAN;
+        }
+        engine.evaluate(s_ruleTimeMs, signals);
+    }
+    // shed_load: SoC < 30 at ~100 s -> active at ~110 s. SoC passes 35 while the
+    // shunt is silent, so it holds until data returns at 320 s -> cleared at ~350 s
+    printf("[HOST] Rule transitions: %u (overcurrent on/off, shed_load on/off)\n", s_ruleTransitions);
+    HostCheck::expect(s_ruleTransitions == 4, "rules fire and clear exactly once each");
+
+    // Hysteresis under '!' widens the band like the plain comparison would
+    RuleEngine negated;
+    negated.addRule("not_charged", "!(soc > 30)", 5, 0, 0, action, error, sizeof(error));
+    float levels[] = {25, 33, 36};
+    bool states[3];
+    for (uint8_t i = 0; i < 3; i++) {
+        signals[RuleEngine::SOC] = levels[i];
+        negated.evaluate(i * 1000, signals);
+        states[i] = negated.getRule(0).active;
+    }
+    printf("[HOST] Rule !(soc > 30), hysteresis 5: 25 %% %s, 33 %% %s, 36 %% %s\n",
+           states[0] ? "on" : "off", states[1] ? "on" : "off", states[2] ? "on" : "off");
+    HostCheck::expect(states[0] && states[1] && !states[2], "negated comparison releases at 35");
+
+    // Re-posting a rule set keeps unchanged rules active without toggling them
+    RuleEngine::Rule next[2];
+    signals[RuleEngine::SOC] = 20;
+    engine.evaluate(700000, signals);
+    engine.evaluate(710000, signals);
+    uint32_t before = s_ruleTransitions;
+    RuleEngine::build(next[0], "low_pv", "pv_power < 50", 0, 0, 0, action, error, sizeof(error));
+    RuleEngine::build(next[1], "shed_load", "soc < 30", 5, 10000, 30000, action, error, sizeof(error));
+    engine.replace(next, 2);
+    bool carried = engine.getRule(1).active && s_ruleTransitions == before;
+    next[1].hysteresis = 2;
+    engine.replace(next, 2);
+    bool released = !engine.getRule(1).active && s_ruleTransitions == before + 1;
+    printf("[HOST] Rule replace: unchanged rule %s, changed rule %s\n",
+           carried ? "kept active" : "toggled", released ? "released" : "kept");
+    HostCheck::expect(carried && released, "replace keeps unchanged rules and releases changed ones");
+
+    // Cost per block: 16 rules of mixed size
+    const char* expressions[] = {
+        "soc < 30", "battery_v < 11.8 && battery_i < -5", "abs(battery_i) > 80", "pv_power > 600 && soc > 95",
+        "mppt1_err != 0 || mppt2_err != 0", "ttg_forecast >= 0 && ttg_forecast < 120", "battery_p < -1000",
+        "mppt1_pv_w - mppt2_pv_w > 200", "(hour >= 22 || hour < 6) && soc < 50", "alarm == 1",
+        "charge_current > 40", "soh < 80", "battery_v > 14.6", "consumed_ah < -150",
+        "!(mppt1_cs == 3 || mppt1_cs == 4 || mppt1_cs == 5) && mppt1_pv_v > 30", "mppt2_pv_v / mppt1_pv_v < 0.8"
+    };
+    RuleEngine bench;
+    uint16_t instructions = 0;
+    for (const char* expression : expressions) {
+        if (!bench.addRule("bench", expression, 1, 1000, 1000, action, error, sizeof(error))) {
+            printf("[HOST] Rule bench compile failed: %s\n", error);
+        }
+        instructions += bench.getRule(bench.getRuleCount() - 1).length;
+    }
+    for (uint8_t i = 0; i < RuleEngine::SIGNAL_COUNT; i++) {
+        signals[i] = 10.0f + i;
+    }
+    uint32_t now = 0;
+    printf("[HOST] Rule bench: %u rules, %u instructions, %u bytes per rule\n",
+           bench.getRuleCount(), instructions, (unsigned)sizeof(RuleEngine::Rule));
+    HostBench::run("RuleEngine evaluate (16 rules, per block)", 200000, [&]() {
+        signals[RuleEngine::SOC] = (now / 1000) % 100;
+        bench.evaluate(now += 333, signals);
+    });
+}
+
+// ----------------------------------------------------------------------------
+// Rule webhooks
+// ----------------------------------------------------------------------------
+
+static std::atomic<uint32_t> s_webhookCalls(0);
+
+// A dead endpoint: every request waits out its timeout and fails
+static int deadEndpoint(const char* url, const char* body, size_t length) {
+    (void)url; (void)body; (void)length;
+    s_webhookCalls++;
+    delay(200);
+    return -1;  // HTTPC_ERROR_CONNECTION_REFUSED
+}
+
+// A burst of rule transitions against a dead endpoint: post() must return
+// at once, the ring caps what waits and the worker sends the rest in turn
+static void checkWebhookQueue() {
+    WebhookQueue::begin(deadEndpoint);
+    const char body[] = "{\"rule\":\"shed_load\",\"state\":\"active\"}";
+    uint32_t accepted = 0;
+    uint32_t maxPostUs = 0;
+    for (uint8_t i = 0; i < WEBHOOK_QUEUE_DEPTH + 2; i++) {
+        uint32_t start = micros();
+        if (WebhookQueue::post("http://192.0.2.1/hook", body, sizeof(body) - 1)) {
+            accepted++;
+        }
+        maxPostUs = max(maxPostUs, (uint32_t)(micros() - start));
+    }
+    uint32_t waitStart = millis();
+    while (WebhookQueue::getPending() > 0 && millis() - waitStart < 5000) {
+        delay(10);
+    }
+    printf("[HOST] Webhooks to a dead endpoint: %u queued, %u dropped, post() max %u us, "
+           "worker %u requests, longest %u ms\n",
+           accepted, WebhookQueue::getDropped(), maxPostUs, s_webhookCalls.load(),
+           WebhookQueue::getMaxPostMs());
+    HostCheck::expect(maxPostUs < 1000, "webhook post() does not wait for the endpoint");
+    HostCheck::expect(accepted == WEBHOOK_QUEUE_DEPTH && WebhookQueue::getDropped() == 2,
+                      "webhooks beyond the queue depth are dropped");
+    HostCheck::expect(WebhookQueue::getFailed() == WEBHOOK_QUEUE_DEPTH && s_webhookCalls == WEBHOOK_QUEUE_DEPTH,
+                      "worker sends every queued webhook");
+}
+
+// ----------------------------------------------------------------------------
+// Daily energy ledger
+// ----------------------------------------------------------------------------
+
+struct SimDay {
+    uint16_t yield[2];      // 0.01 kWh, as the chargers report it
+    uint16_t maxPower[2];
+};
+
+// 400 days at one sample per minute. MPPT1 reports HSDS, MPPT2 does not
+// (H22/H23 shift only); MPPT1 rolls over at 20:00, MPPT2 at 20:05. The
+// device restarts at noon on day 100.
+static void checkDailyLedger() {
+    const uint32_t DAYS = 400;
+    const uint32_t RESTART_DAY = 100;
+    const char* path = "/daily_sim.bin";
+    SPIFFS.begin();
+    SPIFFS.remove(path);
+    DailyLedger* ledger = new DailyLedger(SPIFFS, path);
+    ledger->begin();
+
+    std::vector<SimDay> expected;
+    uint32_t yieldWh[2] = {0, 0};           // Today, Wh (reported in 0.01 kWh)
+    int maxPower[2] = {0, 0};
+    uint16_t yesterday[2] = {0, 0};
+    int yesterdayMax[2] = {0, 0};
+    int sequence = 0;
+    float shuntInAh = 0;
+    float shuntOutAh = 0;
+    std::vector<float> expectedIn;
+    std::vector<float> expectedOut;
+
+    for (uint32_t day = 0; day < DAYS; day++) {
+        float season = 1.0f + 0.5f * sinf(day * 2.0f * (float)M_PI / 365.0f);
+        float cloud = 0.6f + 0.4f * ((day * 37) % 11) / 10.0f;
+        for (uint32_t minute = 0; minute < 1440; minute++) {
+            uint32_t ms = (day * 1440 + minute) * 60000UL;  // Wraps every ~50 days, like millis()
+            float hour = minute / 60.0f;
+            if (day == RESTART_DAY && minute == 720) {
+                ledger->saveToday();
+                delete ledger;
+                ledger = new DailyLedger(SPIFFS, path);
+                ledger->begin();
+            }
+
+            // Rollover at nightfall: today moves to yesterday
+            for (uint8_t c = 0; c < 2; c++) {
+                if (minute == (c == 0 ? 1200u : 1205u)) {
+                    if (c == 0) {
+                        expected.push_back({});
+                        expectedIn.push_back(shuntInAh);
+                        expectedOut.push_back(shuntOutAh);
+                        shuntInAh = 0;
+                        shuntOutAh = 0;
+                        sequence++;
+                    }
+                    SimDay& closing = expected.back();
+                    closing.yield[c] = (uint16_t)(yieldWh[c] / 10);
+                    closing.maxPower[c] = (uint16_t)maxPower[c];
+                    yesterday[c] = closing.yield[c];
+                    yesterdayMax[c] = maxPower[c];
+                    yieldWh[c] = 0;
+                    maxPower[c] = 0;
+                }
+            }
+
+            float sun = hour > 6 && hour < 18 ? sinf((hour - 6) / 12.0f * (float)M_PI) : 0;
+            float chargeCurrent[2];
+            for (uint8_t c = 0; c < 2; c++) {
+                float power = sun * season * cloud * (c == 0 ? 400.0f : 320.0f);
+                chargeCurrent[c] = power / 13.2f;
+                yieldWh[c] += (uint32_t)(power / 60.0f + 0.5f);
+                maxPower[c] = max(maxPower[c], (int)power);
+
+                DailyLedger::ChargerReading reading;
+                reading.batteryVoltage = 13.2f;
+                reading.chargeCurrent = chargeCurrent[c];
+                reading.loadCurrent = 0;
+                reading.yieldToday = (yieldWh[c] / 10) / 100.0f;
+                reading.maxPowerToday = maxPower[c];
+                reading.yieldYesterday = yesterday[c] / 100.0f;
+                reading.maxPowerYesterday = yesterdayMax[c];
+                reading.daySequence = c == 0 ? sequence % 365 : -1;
+                ledger->updateCharger(c, ms, reading, 1700000000u + day * 86400 + minute * 60);
+            }
+            float current = chargeCurrent[0] + chargeCurrent[1] - 6.0f;
+            if (minute > 0 || day > 0) {
+                (current > 0 ? shuntInAh : shuntOutAh) += fabsf(current) / 60.0f;
+            }
+            ledger->updateShunt(ms, 12.6f + current * 0.01f, current);
+        }
+    }
+
+    // Compare the stored year with what the simulation produced
+    uint32_t yieldErrors = 0;
+    float maxAhError = 0;
+    float restartAhError = 0;
+    uint16_t stored = ledger->getStoredDays();
+    DailyLedger::Day day;
+    for (uint16_t ago = 0; ago < stored; ago++) {
+        size_t index = expected.size() - 1 - ago;
+        if (!ledger->getDay(ago, day)) {
+            yieldErrors++;
+            continue;
+        }
+        for (uint8_t c = 0; c < 2; c++) {
+            if (day.mppt[c].yield != expected[index].yield[c] || day.mppt[c].maxPower != expected[index].maxPower[c]) {
+                yieldErrors++;
+            }
+        }
+        float ahError = max(fabsf(day.shunt.ahIn / 10.0f - expectedIn[index]),
+                            fabsf(day.shunt.ahOut / 10.0f - expectedOut[index]));
+        // The restart drops the one sample interval spanning it
+        if (index == RESTART_DAY) {
+            restartAhError = ahError;
+        } else {
+            maxAhError = max(maxAhError, ahError);
+        }
+    }
+    DailyLedger::Day restarted;
+    bool restartFlagged = ledger->getDay(expected.size() - 1 - RESTART_DAY, restarted)
+        && (restarted.flags & DailyLedger::FLAG_RESTARTED);
+    printf("[HOST] DailyLedger: %u days simulated, %u closed, %u stored (capacity %u), "
+           "yield/peak mismatches %u, max Ah error %.2f (restart day %.2f), restart flagged %s\n",
+           DAYS, (unsigned)expected.size(), stored, DailyLedger::CAPACITY, yieldErrors, maxAhError,
+           restartAhError, restartFlagged ? "yes" : "no");
+    HostCheck::expect(yieldErrors == 0 && stored == DailyLedger::CAPACITY && maxAhError < 0.1f && restartFlagged,
+                      "DailyLedger keeps a full year of exact days and flags the restart");
+
+    uint16_t ago = 0;
+    HostBench::run("DailyLedger getDay (file seek + read)", 20000, [&]() {
+        ledger->getDay(1 + ago++ % (stored - 1), day);
+        HostBench::keep(day);
+    });
+    delete ledger;
+    SPIFFS.remove(path);
+}
+
+// ----------------------------------------------------------------------------
+// Power management
+// ----------------------------------------------------------------------------
+
+struct SimPort {
+    HardwareSerial* serial;
+    std::string block;
+    bool softwareSerial;    // Bit timing breaks below 240 MHz, not only in sleep
+    uint64_t phaseUs;       // First burst start
+    uint64_t periodUs;      // Device clock, slightly off 1 s
+    uint64_t startUs;       // Current burst
+    uint32_t burst;
+    size_t next;            // Next byte of the current burst
+};
+
+static uint64_t simArrivalUs(const SimPort& port) {
+    return port.startUs + (port.next + 1) * 521;
+}
+
+// Ten minutes of the three VE.Direct ports at 1 Hz (clock drift, +-3 ms
+// jitter) through a loop that polls, works 2 ms per iteration and waits in
+// idle(). Bytes that arrive while asleep are lost, and MPPT2
+// (SoftwareSerial) bytes outside the UART lock are garbled (80 MHz); the
+// parsers' checksums count the damaged blocks. After 30 s of learning,
+// every block must arrive intact.
+static void checkPowerManager() {
+    const uint64_t DURATION_US = 600ULL * 1000000;
+    const uint64_t WARMUP_US = 30ULL * 1000000;
+    const uint64_t WORK_US = 2000;
+
+    HardwareSerial shuntPort(2);
+    HardwareSerial mppt1Port(1);
+    HardwareSerial mppt2Port(3);
+    VictronSmartShunt shunt(&shuntPort);
+    VictronMPPT mppt1(&mppt1Port);
+    VictronMPPT mppt2(&mppt2Port);
+    SimPort ports[3] = {
+        {&shuntPort, sampleShuntBlock(), false, 120000, 1000000, 0, 0, 0},
+        {&mppt1Port, sampleMpptBlock(), false, 430000, 1000400, 0, 0, 0},
+        {&mppt2Port, sampleMpptBlock(), true, 760000, 999700, 0, 0, 0}
+    };
+    uint32_t seed = 12345;
+    for (SimPort& port : ports) {
+        port.startUs = port.phaseUs;
+    }
+
+    PowerManager::begin(PowerManager::MODE_LIGHT_SLEEP, nullptr, 0);
+
+    uint64_t t = 0;
+    uint64_t sleepFromUs = UINT64_MAX;
+    bool open = false;
+    uint64_t stateUs[3] = {0, 0, 0};    // full, low, idle (after warmup)
+    uint32_t errorsAtWarmup = 0;
+    uint32_t blocksAtWarmup = 0;
+    uint32_t burstsAtWarmup = 0;
+    bool warm = false;
+    while (t < DURATION_US) {
+        uint32_t nowMs = t / 1000;
+        if (!warm && t >= WARMUP_US) {
+            warm = true;
+            errorsAtWarmup = shunt.getChecksumErrors() + mppt1.getChecksumErrors() + mppt2.getChecksumErrors();
+            blocksAtWarmup = shunt.getBlockCount() + mppt1.getBlockCount() + mppt2.getBlockCount();
+            burstsAtWarmup = ports[0].burst + ports[1].burst + ports[2].burst;
+        }
+
+        // Poll: bytes received since the previous iteration
+        for (uint8_t i = 0; i < 3; i++) {
+            SimPort& port = ports[i];
+            int available = 0;
+            while (simArrivalUs(port) <= t) {
+                if (simArrivalUs(port) <= sleepFromUs) {
+                    uint8_t c = port.block[port.next];
+                    if (port.softwareSerial && !open) {
+                        c ^= 0x55;  // Sampled with the wrong bit time
+                    }
+                    port.serial->feed(&c, 1);
+                    available++;
+                }
+                if (++port.next == port.block.size()) {
+                    port.next = 0;
+                    port.burst++;
+                    seed = seed * 1103515245 + 12345;
+                    int32_t jitterUs = (int32_t)((seed >> 16) % 6001) - 3000;
+                    port.startUs = port.phaseUs + port.burst * port.periodUs + jitterUs;
+                }
+            }
+            PowerManager::noteRx(i, available, nowMs);
+        }
+        PowerManager::update(nowMs);
+        open = PowerManager::isBurstExpected(nowMs);
+        shunt.update();
+        mppt1.update();
+        mppt2.update();
+
+        t += WORK_US;
+        uint32_t waitMs = PowerManager::getIdleMs(t / 1000);
+        sleepFromUs = open ? UINT64_MAX : t;
+        if (warm) {
+            stateUs[open ? 0 : 1] += WORK_US;
+            stateUs[open ? 0 : 2] += waitMs * 1000ULL;
+        }
+        t += waitMs * 1000ULL;
+    }
+
+    uint32_t errors = shunt.getChecksumErrors() + mppt1.getChecksumErrors() + mppt2.getChecksumErrors();
+    uint32_t blocks = shunt.getBlockCount() + mppt1.getBlockCount() + mppt2.getBlockCount();
+    uint32_t bursts = ports[0].burst + ports[1].burst + ports[2].burst;
+    PowerManager::Stats stats;
+    PowerManager::getStats(stats);
+    printf("[HOST] Power sim learning (30 s): %u checksum errors, %u bursts outside a window in total\n",
+           errorsAtWarmup, stats.unexpectedBursts);
+    printf("[HOST] Power sim after learning: %u checksum errors, %u/%u blocks received\n",
+           errors - errorsAtWarmup, blocks - blocksAtWarmup, bursts - burstsAtWarmup);
+    HostCheck::expect(errors == errorsAtWarmup && blocks - blocksAtWarmup == bursts - burstsAtWarmup,
+                      "power management loses no VE.Direct block after learning");
+
+    uint32_t fullMs = stateUs[0] / 1000;
+    uint32_t lowMs = stateUs[1] / 1000;
+    uint32_t idleMs = stateUs[2] / 1000;
+    float total = fullMs + lowMs + idleMs;
+    printf("[HOST] Power sim time: 240 MHz %.1f%%, 80 MHz %.1f%%, idle %.1f%%\n",
+           100.0f * fullMs / total, 100.0f * lowMs / total, 100.0f * idleMs / total);
+    float lightSleepMa = PowerManager::estimateCurrentMa(PowerManager::MODE_LIGHT_SLEEP, fullMs, lowMs, idleMs);
+    float dfsMa = PowerManager::estimateCurrentMa(PowerManager::MODE_DFS, fullMs, lowMs, idleMs);
+    float baselineMa = PowerManager::estimateCurrentMa(PowerManager::MODE_OFF, fullMs, lowMs, idleMs);
+    printf("[HOST] Power sim estimate: %.1f mA light sleep, %.1f mA DFS, %.1f mA baseline (240 MHz)\n",
+           lightSleepMa, dfsMa, baselineMa);
+    HostCheck::expect(lightSleepMa < dfsMa && dfsMa < baselineMa, "light sleep < DFS < baseline current");
+}
+
+// ----------------------------------------------------------------------------
+// HTTP serving: inside loop() vs async handlers on snapshots
+// ----------------------------------------------------------------------------
+
+enum SimRequest : uint8_t {
+    SIM_JSON,               // /api/battery, /api/solar, /api/system, /api/rules
+    SIM_DAILY,              // /api/daily (rendered on demand)
+    SIM_VEDLOG              // /api/vedlog, 256 KB at ~100 KB/s
+};
+
+// Time the request spends on the wire (and, for the synchronous server, in loop())
+static uint32_t simTransferMs(SimRequest request) {
+    switch (request) {
+        case SIM_VEDLOG: return 2500;
+        case SIM_DAILY: return 150;
+        default: return 20;
+    }
+}
+
+// Stand-in for a ~2 KB JSON body that repeats its render sequence, so a body
+// modified while a client reads it shows up as inconsistent
+static String simBody(uint32_t sequence) {
+    char item[16];
+    snprintf(item, sizeof(item), "%08lu,", (unsigned long)sequence);
+    String body;
+    body.reserve(2048);
+    while (body.length() + strlen(item) <= 2048) {
+        body += item;
+    }
+    return body;
+}
+
+static bool simBodyConsistent(const String& body) {
+    const char* text = body.c_str();
+    for (size_t i = 9; i < body.length(); i++) {
+        if (text[i] != text[i % 9]) {
+            return false;
+        }
+    }
+    return body.length() > 0;
+}
+
+struct HttpSimResult {
+    uint32_t requests = 0;
+    uint32_t maxIterationMs = 0;
+    uint32_t stalls = 0;
+    uint32_t torn = 0;
+    uint32_t maxRenderWaitMs = 0;
+    uint32_t maxHandlerUs = 0;
+    uint32_t jobsRejected = 0;
+    uint32_t jobsUnanswered = 0;
+};
+
+static void runHttpSim(bool async, HttpSimResult& result) {
+    const uint32_t RUN_MS = 3000;
+    const uint32_t STALL_MS = 500;          // LOOP_STALL_THRESHOLD_MS
+    const uint32_t RENDER_MS = 100;         // HTTP_SNAPSHOT_REFRESH_MS, sped up
+    const uint32_t IDLE_MS = 20;            // PowerManager::idle() between bursts
+    std::atomic<bool> running(true);
+    std::atomic<uint32_t> requests(0);
+    std::atomic<uint32_t> torn(0);
+    std::atomic<uint32_t> maxRenderWaitMs(0);
+    std::atomic<uint32_t> maxHandlerUs(0);
+    std::atomic<uint32_t> jobsRejected(0);
+    std::atomic<uint32_t> jobsUnanswered(0);
+    std::mutex backlogMutex;
+    std::deque<SimRequest> backlog;         // Connections waiting for handleClient()
+
+    auto client = [&](SimRequest type, uint32_t startMs, uint32_t pollMs) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(startMs));
+        while (running) {
+            if (!async) {
+                std::lock_guard<std::mutex> guard(backlogMutex);
+                backlog.push_back(type);
+            } else if (type == SIM_DAILY) {
+                // Handler queues the job and returns; the response polls it
+                // like the chunked filler returning RESPONSE_TRY_AGAIN
+                uint32_t askedMs = millis();
+                uint32_t handlerStart = micros();
+                HttpSnapshot::Ticket ticket = HttpSnapshot::submit(1, "31,0");
+                uint32_t handlerUs = micros() - handlerStart;
+                if (handlerUs > maxHandlerUs) {
+                    maxHandlerUs = handlerUs;
+                }
+                if (!ticket) {
+                    jobsRejected++;
+                    std::this_thread::sleep_for(std::chrono::milliseconds(pollMs));
+                    continue;
+                }
+                HttpSnapshot::Body body;
+                while (!(body = HttpSnapshot::result(ticket)) && millis() - askedMs < 2000) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                }
+                uint32_t waitMs = millis() - askedMs;
+                if (waitMs > maxRenderWaitMs) {
+                    maxRenderWaitMs = waitMs;
+                }
+                if (!body) {
+                    jobsUnanswered++;
+                }
+                // A client that gives up at once: its job must still be finished
+                HostBench::keep(HttpSnapshot::submit(1, "31,0"));
+                std::this_thread::sleep_for(std::chrono::milliseconds(simTransferMs(type)));
+                requests++;
+            } else {
+                HttpSnapshot::Body body = HttpSnapshot::get(0);
+                if (type == SIM_JSON && body && !simBodyConsistent(*body)) {
+                    torn++;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(simTransferMs(type)));
+                requests++;
+            }
+            if (type == SIM_VEDLOG) {
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(pollMs));
+        }
+    };
+    std::vector<std::thread> clients;
+    for (uint32_t i = 0; i < 3; i++) {
+        clients.emplace_back(client, SIM_JSON, i * 70, 200);
+    }
+    clients.emplace_back(client, SIM_DAILY, 100, 300);
+    clients.emplace_back(client, SIM_VEDLOG, 500, 0);
+
+    uint32_t sequence = 0;
+    uint32_t lastRender = 0;
+    uint32_t maxUs = 0;
+    uint32_t stalls = 0;
+    uint32_t start = millis();
+    while (millis() - start < RUN_MS) {
+        uint32_t iterationStart = micros();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));   // VE.Direct, rules, uploads
+        if (async) {
+            if (millis() - lastRender >= RENDER_MS) {
+                HttpSnapshot::publish(0, simBody(++sequence));
+                lastRender = millis();
+            }
+            uint8_t slot;
+            String args;
+            if (HttpSnapshot::takeJob(slot, args)) {
+                HttpSnapshot::finishJob(simBody(++sequence));
+            }
+        } else {
+            // handleClient(): one connection per call, answered inline
+            bool pending = false;
+            SimRequest type = SIM_JSON;
+            {
+                std::lock_guard<std::mutex> guard(backlogMutex);
+                if (!backlog.empty()) {
+                    type = backlog.front();
+                    backlog.pop_front();
+                    pending = true;
+                }
+            }
+            if (pending) {
+                String body = simBody(++sequence);
+                HostBench::keep(body);
+                std::this_thread::sleep_for(std::chrono::milliseconds(simTransferMs(type)));
+                requests++;
+            }
+        }
+        uint32_t us = micros() - iterationStart;
+        maxUs = std::max(maxUs, us);
+        if (us >= STALL_MS * 1000) {
+            stalls++;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(IDLE_MS));
+    }
+    running = false;
+    for (std::thread& thread : clients) {
+        thread.join();
+    }
+    result.requests = requests;
+    result.maxIterationMs = maxUs / 1000;
+    result.stalls = stalls;
+    result.torn = torn;
+    result.maxRenderWaitMs = maxRenderWaitMs;
+    result.maxHandlerUs = maxHandlerUs;
+    result.jobsRejected = jobsRejected;
+    result.jobsUnanswered = jobsUnanswered;
+}
+
+static void checkHttpServing() {
+    HttpSimResult inlineResult;
+    HttpSimResult asyncResult;
+    runHttpSim(false, inlineResult);
+    runHttpSim(true, asyncResult);
+    printf("[HOST] HTTP sim 3 s, served in loop(): %u requests, loop max %u ms, %u stalls\n",
+           inlineResult.requests, inlineResult.maxIterationMs, inlineResult.stalls);
+    printf("[HOST] HTTP sim 3 s, async snapshots:  %u requests, loop max %u ms, %u stalls, "
+           "%u inconsistent bodies\n",
+           asyncResult.requests, asyncResult.maxIterationMs, asyncResult.stalls, asyncResult.torn);
+    printf("[HOST] HTTP sim /api/daily on demand: handler max %u us, body after max %u ms, "
+           "%u rejected, %u unanswered\n",
+           asyncResult.maxHandlerUs, asyncResult.maxRenderWaitMs, asyncResult.jobsRejected,
+           asyncResult.jobsUnanswered);
+    HostCheck::expect(inlineResult.stalls > 0, "HTTP served inside loop() stalls it (simulation premise)");
+    HostCheck::expect(asyncResult.stalls == 0 && asyncResult.torn == 0,
+                      "async HTTP never stalls loop() or serves an inconsistent body");
+    HostCheck::expect(asyncResult.jobsRejected == 0 && asyncResult.jobsUnanswered == 0,
+                      "on-demand jobs are all answered, including after abandoned ones");
+
+    String body = simBody(1);
+    HostBench::run("HttpSnapshot publish (2 KB)", 200000, [&]() {
+        HttpSnapshot::publish(2, String(body));
+    });
+    HostBench::run("HttpSnapshot get", 1000000, []() {
+        HostBench::keep(HttpSnapshot::get(2));
+    });
+}
+
+int main(int argc, char** argv) {
+    HardwareSerial mpptPort(1);
+    HardwareSerial shuntPort(2);
+    VictronMPPT mppt(&mpptPort);
+    VictronSmartShunt shunt(&shuntPort);
+    mppt.begin();
+    shunt.begin();
+
+    std::string mpptData;
+    std::string mppt2Data;
+    std::string shuntData;
+    std::vector<BatteryTraceSample> batteryTrace;
+    std::string vedlog;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--mppt") == 0 && !readFile(argv[i + 1], mpptData)) return 1;
+        if (strcmp(argv[i], "--mppt2") == 0 && !readFile(argv[i + 1], mppt2Data)) return 1;
+        if (strcmp(argv[i], "--shunt") == 0 && !readFile(argv[i + 1], shuntData)) return 1;
+        if (strcmp(argv[i], "--battery-trace") == 0 && !loadBatteryTrace(argv[i + 1], batteryTrace)) return 1;
+        if (strcmp(argv[i], "--vedlog") == 0 && !readFile(argv[i + 1], vedlog)) return 1;
+    }
+    if (!vedlog.empty()) {
+        LogReplay replay;
+        replayLog(vedlog, replay);
+        printf("[HOST] VeLog final: shunt V=%.2f I=%.2f SOC=%.1f%% | MPPT1 PPV=%.0f ERR=%d | MPPT2 PPV=%.0f ERR=%d\n",
+               replay.shunt.getBatteryVoltage(), replay.shunt.getBatteryCurrent(), replay.shunt.getStateOfCharge(),
+               replay.mppt1.getPanelPower(), replay.mppt1.getErrorCode(),
+               replay.mppt2.getPanelPower(), replay.mppt2.getErrorCode());
+        return 0;
+    }
+    if (!batteryTrace.empty()) {
+        checkBatteryAnalytics(batteryTrace, false);
+        if (mpptData.empty() && shuntData.empty()) {
+            return 0;
+        }
+    }
+    bool synthetic = mpptData.empty() && shuntData.empty();
+    if (synthetic) {
+        mpptData = sampleMpptBlock();
+        shuntData = sampleShuntBlock();
+    }
+
+    // Replay
+    replay(mpptPort, mppt, mpptData);
+    replay(shuntPort, shunt, shuntData);
+
+    printf("[HOST] MPPT  valid=%d V=%.2f I=%.2f VPV=%.2f PPV=%.0f CS=%s ERR=%d yield=%.2f kWh\n",
+           mppt.isDataValid(), mppt.getBatteryVoltage(), mppt.getChargeCurrent(), mppt.getPanelVoltage(),
+           mppt.getPanelPower(), mppt.getChargeState().c_str(), mppt.getErrorCode(), mppt.getYieldToday());
+    printf("[HOST] Shunt valid=%d V=%.2f I=%.2f SOC=%.1f%% TTG=%d min cycles=%d\n",
+           shunt.isDataValid(), shunt.getBatteryVoltage(), shunt.getBatteryCurrent(),
+           shunt.getStateOfCharge(), shunt.getTimeRemaining(), shunt.getChargeCycles());
+    printf("[HOST] Shunt history H3=%.1f Ah H5=%d H6=%.1f Ah H9=%ld s H10=%d H17=%.2f kWh H18=%.2f kWh\n",
+           shunt.getAverageDischarge(), shunt.getFullDischarges(), shunt.getCumulativeAh(),
+           shunt.getSecondsSinceFullCharge(), shunt.getSyncCount(), shunt.getDischargedEnergy(), shunt.getChargedEnergy());
+
+    if (!mpptData.empty() && !mppt2Data.empty()) {
+        checkMpptComparison(splitBlocks(mpptData), splitBlocks(mppt2Data));
+    }
+    if (!synthetic) {
+        return HostCheck::exitCode();
+    }
+    HostCheck::expect(mppt.isDataValid() && shunt.isDataValid() && mppt.getChecksumErrors() == 0
+                          && shunt.getChecksumErrors() == 0,
+                      "synthetic MPPT and SmartShunt blocks parse without checksum errors");
+
+    // A block with a damaged byte leaves the previous values in place
+    std::string damaged = buildBlock({{"V", "12800"}, {"I", "-1500"}, {"SOC", "640"}});
+    damaged[damaged.find("12800")] = '9';
+    float voltageBefore = shunt.getBatteryVoltage();
+    shuntPort.feed(damaged.c_str());
+    shunt.update();
+    printf("[HOST] Damaged shunt block: V=%.2f (was %.2f), checksum errors %u\n",
+           shunt.getBatteryVoltage(), voltageBefore, shunt.getChecksumErrors());
+    HostCheck::expect(shunt.getBatteryVoltage() == voltageBefore && shunt.getChecksumErrors() == 1,
+                      "fields of a block with a bad checksum are dropped");
+
+    // Benchmarks: one full block per iteration
+    HostBench::run("VictronMPPT block parse", 20000, [&]() {
+        mpptPort.feed(mpptData.c_str());
+        mppt.update();
+    });
+    HostBench::run("VictronSmartShunt block parse (main + H)", 20000, [&]() {
+        shuntPort.feed(shuntData.c_str());
+        shunt.update();
+    });
+
+    LoopProfiler::begin(500, 300000, nullptr);
+    HostBench::run("LoopProfiler iteration + 2 regions", 200000, []() {
+        LoopProfiler::Iteration iteration;
+        {
+            LOOP_PROFILE_REGION("outer");
+            LOOP_PROFILE_REGION("inner");
+        }
+    });
+
+    std::vector<std::string> blocks1;
+    std::vector<std::string> blocks2;
+    simulateMpptCaptures(blocks1, blocks2);
+    checkMpptComparison(blocks1, blocks2);
+    HostCheck::expect(s_mpptEventTypes == 0x3F, "every injected MPPT fault is raised and recovered");
+
+    checkBatteryAnalytics(simulateBatteryTrace(), true);
+    benchModbus();
+    checkRuleEngine();
+    checkWebhookQueue();
+    checkDailyLedger();
+    checkRecorder();
+    checkPowerManager();
+    checkHttpServing();
+    return HostCheck::exitCode();
+}
+
+#endif // NATIVE_HOST
@@ -0,0 +1,103 @@
+#include "http_snapshot.h"
+#include <mutex>
+
+namespace HttpSnapshot {
+    struct Job {
+        uint8_t slot;
+        String args;
+        Body body;                  // Set by finishJob()
+    };
+
+    static std::mutex s_mutex;
+    static Body s_bodies[MAX_SLOTS];
+    static uint32_t s_published = 0;
+    static uint32_t s_served = 0;
+    static uint32_t s_jobsRejected = 0;
+
+    // Submitted jobs, oldest first, and the one loop() is rendering
+    static Ticket s_jobs[MAX_JOBS];
+    static uint8_t s_jobCount = 0;
+    static Ticket s_current;
+
+    void publish(uint8_t slot, String&& body) {
+        if (slot >= MAX_SLOTS) {
+            return;
+        }
+        // Allocate outside the lock; the old body is freed here or by its last reader
+        Body next = std::make_shared<const String>(std::move(body));
+        std::lock_guard<std::mutex> guard(s_mutex);
+        s_bodies[slot].swap(next);
+        s_published++;
+    }
+
+    Body get(uint8_t slot) {
+        if (slot >= MAX_SLOTS) {
+            return Body();
+        }
+        std::lock_guard<std::mutex> guard(s_mutex);
+        if (s_bodies[slot]) {
+            s_served++;
+        }
+        return s_bodies[slot];
+    }
+
+    Ticket submit(uint8_t slot, const String& args) {
+        Ticket job = std::make_shared<Job>();
+        job->slot = slot;
+        job->args = args;
+        std::lock_guard<std::mutex> guard(s_mutex);
+        if (s_jobCount >= MAX_JOBS) {
+            s_jobsRejected++;
+            return Ticket();
+        }
+        s_jobs[s_jobCount++] = job;
+        return job;
+    }
+
+    Body result(const Ticket& ticket) {
+        if (!ticket) {
+            return Body();
+        }
+        std::lock_guard<std::mutex> guard(s_mutex);
+        return ticket->body;
+    }
+
+    bool takeJob(uint8_t& slot, String& args) {
+        std::lock_guard<std::mutex> guard(s_mutex);
+        if (s_current || s_jobCount == 0) {
+            return false;
+        }
+        s_current.swap(s_jobs[0]);
+        for (uint8_t i = 1; i < s_jobCount; i++) {
+            s_jobs[i - 1].swap(s_jobs[i]);
+        }
+        s_jobCount--;
+        slot = s_current->slot;
+        args = s_current->args;
+        return true;
+    }
+
+    void finishJob(String&& body) {
+        Body done = std::make_shared<const String>(std::move(body));
+        Ticket finished;
+        std::lock_guard<std::mutex> guard(s_mutex);
+        if (!s_current) {
+            return;
+        }
+        s_current->body.swap(done);
+        s_served++;
+        finished.swap(s_current);       // Freed after the lock if the client is gone
+    }
+
+    uint32_t getPublished() {
+        return s_published;
+    }
+
+    uint32_t getServed() {
+        return s_served;
+    }
+
+    uint32_t getJobsRejected() {
+        return s_jobsRejected;
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef HTTP_SNAPSHOT_H
+#define HTTP_SNAPSHOT_H
+
+#include <Arduino.h>
+#include <memory>
+
+/**
+ * @brief Immutable response bodies shared between loop() and the async web server.
+ *
+ * ESPAsyncWebServer runs request handlers in the async_tcp task, not in
+ * loop(), so they must not read the VE.Direct drivers, analytics or rule
+ * engine while loop() is updating them. Instead loop() renders each
+ * endpoint's body into a slot with publish() and handlers send whatever
+ * get() returns. A published body is never modified: publish() swaps in a
+ * new one, and a response still streaming the old one keeps it alive
+ * through its shared_ptr.
+ *
+ * Endpoints whose body depends on query arguments (e.g. /api/daily) are
+ * rendered on demand instead: the handler queues a job with submit() and
+ * answers with a chunked response whose filler polls result() (returning
+ * RESPONSE_TRY_AGAIN until there is a body); loop() picks the job up with
+ * takeJob() and answers it with finishJob(). Nothing waits: a client that
+ * disconnects just drops its ticket, and its job still runs to completion.
+ *
+ * Slot numbers are chosen by the firmware (0 to MAX_SLOTS - 1).
+ */
+
+namespace HttpSnapshot {
+    static const uint8_t MAX_SLOTS = 8;
+
+    typedef std::shared_ptr<const String> Body;
+
+    /**
+     * @brief Replace a slot's body (loop() only).
+     */
+    void publish(uint8_t slot, String&& body);
+
+    /**
+     * @brief Current body of a slot (any task).
+     * @return empty pointer until the slot is first published
+     */
+    Body get(uint8_t slot);
+
+    static const uint8_t MAX_JOBS = 4;
+
+    struct Job;
+    typedef std::shared_ptr<Job> Ticket;
+
+    /**
+     * @brief Queue a body for loop() to render for these arguments (handler side).
+     * @return empty ticket if MAX_JOBS are already waiting
+     */
+    Ticket submit(uint8_t slot, const String& args);
+
+    /**
+     * @brief Body of a submitted job (any task, never blocks).
+     * @return empty pointer until loop() has finished the job
+     */
+    Body result(const Ticket& ticket);
+
+    /**
+     * @brief Pick up the oldest submitted job (loop() only).
+     * @return true if a job was taken; finishJob() must follow
+     */
+    bool takeJob(uint8_t& slot, String& args);
+    void finishJob(String&& body);
+
+    uint32_t getPublished();        // Bodies published since boot
+    uint32_t getServed();           // get() calls and finished jobs that returned a body
+    uint32_t getJobsRejected();     // submit() calls refused with a full queue
+}
+
+#endif // HTTP_SNAPSHOT_H
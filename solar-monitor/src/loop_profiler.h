@@ -0,0 +1,80 @@
+#ifndef LOOP_PROFILER_H
+#define LOOP_PROFILER_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Lightweight loop() latency profiler with stall attribution.
+ *
+ * Each loop() iteration is timed and binned into a log2 histogram. Code that
+ * may block (sensor conversions, MQTT connects, HTTP posts, portals) is wrapped
+ * in LOOP_PROFILE_REGION() markers; when an iteration exceeds the stall
+ * threshold, the region with the largest exclusive time is reported as the
+ * culprit through the registered stall handler. Cost is two micros() calls per
+ * region and a few integer ops per iteration, so it stays enabled in production.
+ */
+
+namespace LoopProfiler {
+    // Histogram bucket 0 holds iterations under 1 ms; bucket n (n >= 1) holds
+    // [2^(n-1), 2^n) ms. The last bucket collects everything above ~16 s.
+    static const uint8_t HISTOGRAM_BUCKETS = 16;
+    static const uint8_t MAX_REGION_DEPTH = 6;
+
+    struct StallInfo {
+        const char* region;        // Culprit region (exclusive time), "loop" if unmarked
+        uint32_t durationMs;       // Total iteration duration
+        uint32_t regionMs;         // Exclusive time spent in the culprit region
+        uint32_t stallCount;       // Total stalls since boot
+        uint32_t suppressed;       // Stalls not reported since the previous event
+    };
+
+    typedef void (*StallHandler)(const StallInfo& info);
+
+    /**
+     * @brief Configure stall detection. Call once from setup().
+     * @param stallThresholdMs Iterations at or above this duration count as stalls
+     * @param reportIntervalMs Minimum time between two stall reports (rate limit)
+     * @param handler Called from loop context when a stall should be reported
+     */
+    void begin(uint32_t stallThresholdMs, uint32_t reportIntervalMs, StallHandler handler);
+
+    /**
+     * @brief RAII iteration marker. Declare at the top of loop() so early
+     * returns still close the iteration.
+     */
+    class Iteration {
+    public:
+        Iteration();
+        ~Iteration();
+    };
+
+    /**
+     * @brief RAII region marker. The name must be a string literal (stored by pointer).
+     * Regions may nest up to MAX_REGION_DEPTH; child time is excluded from the parent.
+     */
+    class Region {
+    public:
+        explicit Region(const char* name);
+        ~Region();
+    private:
+        bool _active;
+    };
+
+    uint32_t getIterations();
+    uint32_t getMaxIterationMs();
+    uint32_t getStallCount();
+    const char* getLastStallRegion();
+    uint32_t getLastStallMs();
+    uint32_t getBucket(uint8_t index);
+
+    /**
+     * @brief Upper bound of a histogram bucket in ms (0 for the overflow bucket).
+     */
+    uint32_t getBucketLimitMs(uint8_t index);
+}
+
+#define LOOP_PROFILE_CONCAT_INNER(a, b) a##b
+#define LOOP_PROFILE_CONCAT(a, b) LOOP_PROFILE_CONCAT_INNER(a, b)
+#define LOOP_PROFILE_REGION(name) LoopProfiler::Region LOOP_PROFILE_CONCAT(_loopRegion, __LINE__)(name)
+
+#endif // LOOP_PROFILER_H
@@ -12,21 +12,29 @@
  * - GPIO 18 (SoftwareSerial RX) <- MPPT2 TX
  * - VE.Direct: 19200 baud, 3.3V TTL
  *
- * API Endpoints:
+ * API Endpoints (ESPAsyncWebServer, answered from loop()-rendered snapshots):
  * - GET /           - HTML dashboard
  * - GET /api/battery - SmartShunt data (JSON)
  * - GET /api/solar   - Both MPPTs data (JSON)
  * - GET /api/system  - Combined system data (JSON)
+ * - GET /api/vedlog  - Raw VE.Direct black-box log (binary, see README)
+ * - GET /api/daily   - Per-day energy ledger, up to a year in pages of 62 days (JSON)
+ * - GET/POST /api/rules - Local threshold rules (JSON, see README)
+ * - Modbus-TCP :502  - Latest VE.Direct snapshot as registers (see README)
  */
 
 #include <Arduino.h>
 #include <WiFi.h>
-#include <WebServer.h>
+#include <AsyncTCP.h>
 #include <ArduinoJson.h>
 #include <HTTPClient.h>
 #include <SoftwareSerial.h>
 #include <WiFiManager.h>
+#include <ESPAsyncWebServer.h>   // After WiFiManager: reuses WebServer's HTTP method enum
 #include <ESP_DoubleResetDetector.h>
+#include <Preferences.h>
+#include <time.h>
+#include <atomic>
 
 // Filesystem for device name storage
 #ifdef ESP32
@@ -39,8 +47,19 @@
 
 #include "VictronSmartShunt.h"
 #include "VictronMPPT.h"
+#include "BatteryAnalytics.h"
+#include "MpptComparator.h"
+#include "DailyLedger.h"
+#include "RuleEngine.h"
+#include "webhook_queue.h"
 #include "secrets.h"
 #include "display.h"
+#include "loop_profiler.h"
+#include "modbus_server.h"
+#include "vedirect_recorder.h"
+#include "power_manager.h"
+#include "config_portal.h"
+#include "http_snapshot.h"
 
 // Double Reset Detector configuration
 #define DRD_TIMEOUT 3           // Seconds to wait for second reset
@@ -64,13 +83,49 @@ const char* DEVICE_NAME_FILE = "/device_name.txt";
 
 // VE.Direct baud rate
 #define VEDIRECT_BAUD 19200
+// RX buffer per port: ~1 s of continuous text at 19200 baud (default 256 B UART, 64 B SoftwareSerial),
+// so a slow loop() iteration (InfluxDB post, flash write) does not drop frame bytes
+#define VEDIRECT_RX_BUFFER_SIZE 2048
 
-// Web server port
+// Web server port. Requests are answered by ESPAsyncWebServer in the
+// async_tcp task from bodies rendered in loop() (http_snapshot.h)
 #define HTTP_PORT 80
+#define HTTP_SNAPSHOT_REFRESH_MS 1000   // Live JSON re-rendered this often
+
+// Modbus-TCP server (register map in README.md)
+#define MODBUS_TCP_PORT 502
+#define MODBUS_SNAPSHOT_REFRESH_MS 1000  // Republish without new blocks so flags/validity stay current
 
 // Status update interval (ms)
 #define STATUS_INTERVAL 10000
 
+// Battery analytics (capacity/SoH and time-to-go forecast)
+#define BATTERY_NOMINAL_CAPACITY_AH 200.0f         // Match the SmartShunt "battery capacity" setting
+#define BATTERY_EMPTY_VOLTAGE 11.8f                // Loaded voltage that ends a full discharge cycle
+#define BATTERY_STATE_SAVE_INTERVAL_MS 21600000UL  // Profile saved to NVS at most every 6 h
+#define NTP_SERVER "pool.ntp.org"                  // UTC clock for the hour-of-day load profile
+
+// Daily energy ledger (366 days on the filesystem)
+#define DAILY_LEDGER_FILE "/daily.bin"
+#define DAILY_LEDGER_SAVE_INTERVAL_MS 900000UL  // Day in progress saved every 15 min
+#define DAILY_API_MAX_DAYS 31                   // Default page size for /api/daily
+#define DAILY_API_PAGE_LIMIT 62                 // Largest page (rendered in RAM, ~22 KB)
+
+// Local rule engine (rule set format in README.md)
+#define RULES_FILE "/rules.json"
+#define RULES_JSON_CAPACITY 6144        // Parsed rule set (16 rules with actions)
+#define RULE_WEBHOOK_TIMEOUT_MS 5000    // Connect/response timeout on the webhook worker (webhook_queue.h)
+
+// Power management: 0 = off (240 MHz, baseline), 1 = DFS 80-240 MHz, 2 = DFS + automatic light sleep.
+// Override with -DSOLAR_POWER_MODE=n in platformio.ini to compare current draw between modes.
+#ifndef SOLAR_POWER_MODE
+#define SOLAR_POWER_MODE 2
+#endif
+
+// Loop profiler: iterations at or above the threshold are logged as "loop_stall" events
+#define LOOP_STALL_THRESHOLD_MS 500           // Iteration time counted as a stall
+#define LOOP_STALL_REPORT_INTERVAL_MS 300000  // Max one stall event per 5 min
+
 // ============================================================================
 // Global Objects
 // ============================================================================
@@ -82,13 +137,44 @@ HardwareSerial mppt1Serial(1);  // UART1 for MPPT1
 // SoftwareSerial for MPPT2 (RX only, TX pin -1)
 SoftwareSerial mppt2Serial;
 
+// Recorder taps: every byte the parsers read also goes to the flash black box
+VeDirectRecorder::TapStream shuntTap(&shuntSerial, VeDirectRecorder::PORT_SHUNT);
+VeDirectRecorder::TapStream mppt1Tap(&mppt1Serial, VeDirectRecorder::PORT_MPPT1);
+VeDirectRecorder::TapStream mppt2Tap(&mppt2Serial, VeDirectRecorder::PORT_MPPT2);
+
 // Victron device instances
-VictronSmartShunt smartShunt(&shuntSerial);
-VictronMPPT mppt1(&mppt1Serial);
-VictronMPPT mppt2(&mppt2Serial);
+VictronSmartShunt smartShunt(&shuntTap);
+VictronMPPT mppt1(&mppt1Tap);
+VictronMPPT mppt2(&mppt2Tap);
+
+// Battery health and time-to-go estimator, fed from SmartShunt blocks
+BatteryAnalytics batteryAnalytics(BATTERY_NOMINAL_CAPACITY_AH, BATTERY_EMPTY_VOLTAGE);
+Preferences batteryPrefs;
+Preferences rulePrefs;
+
+// Detects one MPPT falling behind the other (shading, failed string, wiring)
+MpptComparator mpptComparator;
+
+// Per-day yield, peak power, voltage range and Ah for the last year
+DailyLedger dailyLedger(FILESYSTEM, DAILY_LEDGER_FILE);
+
+// Threshold automations evaluated on every VE.Direct block
+RuleEngine ruleEngine;
 
 // Web server
-WebServer server(HTTP_PORT);
+AsyncWebServer server(HTTP_PORT);
+
+enum HttpSlot : uint8_t {
+    SLOT_ROOT = 0,
+    SLOT_BATTERY,
+    SLOT_SOLAR,
+    SLOT_SYSTEM,
+    SLOT_RULES,
+    SLOT_DAILY,         // On demand
+    SLOT_RULES_POST     // On demand
+};
+bool rootPageStale = true;                  // Device name changed
+std::atomic<uint32_t> vedlogCursor(0);      // VeDirectRecorder::Cursor, first << 16 | count
 
 // Status tracking
 unsigned long lastStatusPrint = 0;
@@ -103,13 +189,42 @@ void loadDeviceName();
 void saveDeviceName(const char* name);
 void sendEventToInfluxDB(const String& eventType, const String& message, const String& severity = "info");
 void setupWiFi();
+void handleConfigPortal();
 void setupWebServer();
-void handleRoot();
-void handleBatteryData();
-void handleSolarData();
-void handleSystemData();
+void updateHttpLock();
+void updateHttpSnapshots();
+void serveHttpJob();
+String renderRootPage();
+String renderBatteryJson();
+String renderSolarJson();
+String renderSystemJson();
+String renderDailyJson(const String& args);
+String renderRulesJson();
+bool postRules(const String& json);
+void handleRoot(AsyncWebServerRequest* request);
+void handleBatteryData(AsyncWebServerRequest* request);
+void handleSolarData(AsyncWebServerRequest* request);
+void handleSystemData(AsyncWebServerRequest* request);
+void handleVeDirectLog(AsyncWebServerRequest* request);
+void handleDailyData(AsyncWebServerRequest* request);
+void handleRulesGet(AsyncWebServerRequest* request);
+void handleRulesPost(AsyncWebServerRequest* request);
+void handleRulesBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total);
 void printStatus();
 void sendDataToInfluxDB();
+void onLoopStall(const LoopProfiler::StallInfo& info);
+void sendLoopStallEvent();
+void updateModbusSnapshot();
+void loadBatteryState();
+void updateBatteryAnalytics();
+void updateMpptComparison();
+void updateDailyLedger();
+void loadRules();
+void updateRules();
+void updateWebhookLock();
+void onRuleAction(const RuleEngine::Rule& rule, bool active);
+int sendRuleWebhook(const char* url, const char* body, size_t length);
+void onMpptEvent(const MpptComparator::Event& event);
 
 // ============================================================================
 // InfluxDB Configuration
@@ -177,6 +292,8 @@ void sendEventToInfluxDB(const String& eventType, const String& message, const S
         return;  // Skip if WiFi not connected
     }
 
+    LOOP_PROFILE_REGION("influxdb_event");
+    PowerManager::Busy busy(PowerManager::LOCK_UPLOAD);
     HTTPClient http;
     http.setTimeout(HTTP_TIMEOUT_MS);
 
@@ -209,6 +326,28 @@ void sendEventToInfluxDB(const String& eventType, const String& message, const S
     http.end();
 }
 
+// Report loop() stalls as device events (rate-limited by the profiler).
+// Runs from the Iteration destructor, so the blocking InfluxDB post is left
+// to sendLoopStallEvent() on the next iteration.
+char pendingStallMessage[128];
+bool stallEventPending = false;
+
+void onLoopStall(const LoopProfiler::StallInfo& info) {
+    snprintf(pendingStallMessage, sizeof(pendingStallMessage), "Loop stalled %lu ms in %s (%lu ms), stalls: %lu, suppressed: %lu",
+             (unsigned long)info.durationMs, info.region, (unsigned long)info.regionMs,
+             (unsigned long)info.stallCount, (unsigned long)info.suppressed);
+    Serial.printf("[Profiler] %s\n", pendingStallMessage);
+    stallEventPending = true;
+}
+
+void sendLoopStallEvent() {
+    if (!stallEventPending) {
+        return;
+    }
+    stallEventPending = false;
+    sendEventToInfluxDB("loop_stall", pendingStallMessage, "warning");
+}
+
 // ============================================================================
 // Setup
 // ============================================================================
@@ -229,30 +368,66 @@ void setup() {
     // Load device name from filesystem
     loadDeviceName();
 
+    // Daily ledger lives on the filesystem mounted above
+    if (dailyLedger.begin()) {
+        Serial.printf("[Daily] Ledger open, %u days stored\n", dailyLedger.getStoredDays());
+    } else {
+        Serial.println("[Daily] Failed to open ledger");
+    }
+
+    // Local rules from the filesystem (GPIO outputs are set to their idle level)
+    ruleEngine.setActionHandler(onRuleAction);
+    WebhookQueue::begin(sendRuleWebhook);
+    loadRules();
+
+    // Raw VE.Direct black box; starts a new sector for this boot
+    VeDirectRecorder::begin();
+
     // Initialize VE.Direct serial ports (RX only, TX pin = -1)
     Serial.println("[UART] Initializing SmartShunt on GPIO 16...");
+    shuntSerial.setRxBufferSize(VEDIRECT_RX_BUFFER_SIZE);  // Before begin()
     shuntSerial.begin(VEDIRECT_BAUD, SERIAL_8N1, SMARTSHUNT_RX_PIN, -1);
 
     Serial.println("[UART] Initializing MPPT1 on GPIO 19...");
+    mppt1Serial.setRxBufferSize(VEDIRECT_RX_BUFFER_SIZE);
     mppt1Serial.begin(VEDIRECT_BAUD, SERIAL_8N1, MPPT1_RX_PIN, -1);
 
     Serial.println("[UART] Initializing MPPT2 on GPIO 18 (SoftwareSerial)...");
-    mppt2Serial.begin(VEDIRECT_BAUD, SWSERIAL_8N1, MPPT2_RX_PIN, -1, false);
+    mppt2Serial.begin(VEDIRECT_BAUD, SWSERIAL_8N1, MPPT2_RX_PIN, -1, false, VEDIRECT_RX_BUFFER_SIZE);
 
     // Initialize device drivers
     smartShunt.begin();
     mppt1.begin();
     mppt2.begin();
 
+    mpptComparator.setEventHandler(onMpptEvent);
+
+    // Clock scaling and light sleep between VE.Direct bursts. Only the
+    // hardware UART pins wake the chip (MPPT2's SoftwareSerial pin keeps
+    // its edge interrupt and relies on the learned burst windows).
+    static const uint8_t wakePins[] = {SMARTSHUNT_RX_PIN, MPPT1_RX_PIN};
+    PowerManager::begin((PowerManager::Mode)SOLAR_POWER_MODE, wakePins, sizeof(wakePins));
+
     // Initialize OLED display
     initDisplay();
 
+    LoopProfiler::begin(LOOP_STALL_THRESHOLD_MS, LOOP_STALL_REPORT_INTERVAL_MS, onLoopStall);
+
+    // Restore learned capacity and load profile
+    loadBatteryState();
+
     // Connect to WiFi
     setupWiFi();
 
+    // UTC only: the load profile is binned by hour of day
+    configTime(0, 0, NTP_SERVER);
+
     // Setup web server
     setupWebServer();
 
+    // Modbus-TCP server runs in its own task from published snapshots
+    ModbusServer::begin(MODBUS_TCP_PORT);
+
     // Log device boot event
     String resetReason = "Unknown";
     #ifdef ESP32
@@ -287,6 +462,8 @@ void setup() {
 // ============================================================================
 
 void loop() {
+    LoopProfiler::Iteration loopIteration;
+
     // Must call drd->loop() to keep double reset detection working
     drd->loop();
 
@@ -317,9 +494,25 @@ void loop() {
     static bool mppt1ErrorLogged = false;
     static bool mppt2ErrorLogged = false;
     
-    smartShunt.update();
-    mppt1.update();
-    mppt2.update();
+    {
+        LOOP_PROFILE_REGION("vedirect");
+        uint32_t rxMs = millis();
+        PowerManager::noteRx(VeDirectRecorder::PORT_SHUNT, shuntSerial.available(), rxMs);
+        PowerManager::noteRx(VeDirectRecorder::PORT_MPPT1, mppt1Serial.available(), rxMs);
+        PowerManager::noteRx(VeDirectRecorder::PORT_MPPT2, mppt2Serial.available(), rxMs);
+        PowerManager::update(rxMs);
+        smartShunt.update();
+        mppt1.update();
+        mppt2.update();
+        VeDirectRecorder::loop();
+    }
+
+    updateModbusSnapshot();
+    updateRules();
+    updateWebhookLock();
+    updateBatteryAnalytics();
+    updateMpptComparison();
+    updateDailyLedger();
     
     // Log sensor errors after 60 seconds of no data (log once until recovered)
     unsigned long now = millis();
@@ -347,8 +540,11 @@ void loop() {
         mppt2ErrorLogged = true;
     }
 
-    // Handle web requests
-    server.handleClient();
+    // Web requests are answered by the async server from bodies rendered here
+    updateHttpLock();
+    updateHttpSnapshots();
+    serveHttpJob();
+    handleConfigPortal();
 
     // Periodic status output
     if (millis() - lastStatusPrint >= STATUS_INTERVAL) {
@@ -361,9 +557,11 @@ void loop() {
         sendDataToInfluxDB();
         lastInfluxDBSend = millis();
     }
+    sendLoopStallEvent();
 
     // Update OLED display periodically
     if (millis() - lastDisplayUpdate >= DISPLAY_UPDATE_INTERVAL) {
+        LOOP_PROFILE_REGION("display");
         // Get current data from SmartShunt
         float batteryPercent = smartShunt.getStateOfCharge();
         float batteryVoltage = smartShunt.getBatteryVoltage();
@@ -395,8 +593,9 @@ void loop() {
         lastDisplayUpdate = millis();
     }
 
-    // Small delay to prevent watchdog issues
-    delay(1);
+    // Wait for the next VE.Direct burst (light sleep / 80 MHz in between);
+    // also keeps the watchdog fed like the former delay(1)
+    PowerManager::idle();
 }
 
 // ============================================================================
@@ -407,31 +606,17 @@ void setupWiFi() {
     // Initialize Double Reset Detector
     drd = new DoubleResetDetector(DRD_TIMEOUT, DRD_ADDRESS);
 
-    // Create WiFiManager instance
-    WiFiManager wm;
-
-    // Set custom AP name for config portal
+    // Set custom AP name for config portal. The portal runs in the
+    // background (handleConfigPortal() from loop()), so VE.Direct parsing and
+    // uploads continue while it is open.
     const char* apName = "SolarMonitor-Setup";
-    
-    // Add device name parameter
-    WiFiManagerParameter customDeviceName("device_name", "Device Name", deviceName, sizeof(deviceName));
-    wm.addParameter(&customDeviceName);
-    
-    // Track if we need to save config
-    bool shouldSaveConfig = false;
-    String oldDeviceName = String(deviceName);
-    
-    // Set save config callback for both modes
-    wm.setSaveConfigCallback([&shouldSaveConfig]() {
-        shouldSaveConfig = true;
-    });
-    wm.setSaveParamsCallback([&shouldSaveConfig]() {
-        shouldSaveConfig = true;
-    });
+    ConfigPortal::Config portalConfig;
+    portalConfig.apName = apName;
+    portalConfig.deviceName = deviceName;
 
     // Don't use timeout - we want to keep retrying forever in weak WiFi zones
     // User must double-reset to enter config mode
-    wm.setConnectTimeout(0);
+    portalConfig.timeoutSeconds = 0;
 
     WiFi.mode(WIFI_STA);
 
@@ -448,31 +633,9 @@ void setupWiFi() {
         Serial.println("[WiFi] Then open http://192.168.4.1 in browser");
         Serial.println();
 
-        // Start config portal (blocking - waits until configured)
-        if (!wm.startConfigPortal(apName)) {
-            Serial.println("[WiFi] Failed to connect after config portal");
-            Serial.println("[WiFi] Restarting...");
-            delay(3000);
-            ESP.restart();
-        }
-        
-        // Save device name and log configuration event
-        if (shouldSaveConfig) {
-            String newName = customDeviceName.getValue();
-            if (newName.length() > 0 && newName != oldDeviceName) {
-                strncpy(deviceName, newName.c_str(), sizeof(deviceName) - 1);
-                deviceName[sizeof(deviceName) - 1] = '\0';
-                saveDeviceName(deviceName);
-                
-                String msg = "Name: '" + oldDeviceName + "' -> '" + String(deviceName) + "', SSID: " + 
-                            WiFi.SSID() + ", IP: " + WiFi.localIP().toString();
-                sendEventToInfluxDB("device_configured", msg, "info");
-            } else {
-                String msg = "WiFi reconfigured - SSID: " + WiFi.SSID() + ", IP: " + 
-                            WiFi.localIP().toString() + ", Name unchanged: " + String(deviceName);
-                sendEventToInfluxDB("device_configured", msg, "info");
-            }
-        }
+        // Stored credentials keep the station up next to the portal's AP
+        WiFi.begin();
+        ConfigPortal::start(portalConfig);
     } else {
         // Normal boot - try to connect with saved credentials
         Serial.println("[WiFi] Normal boot - attempting connection...");
@@ -480,30 +643,15 @@ void setupWiFi() {
         Serial.println();
 
         // Try to auto-connect with saved credentials
-        // If no saved credentials, will start config portal
-        if (!wm.autoConnect(apName)) {
+        // If no saved credentials, the config portal stays open in the background
+        if (!ConfigPortal::autoConnect(portalConfig)) {
             Serial.println("[WiFi] Failed to connect");
-            Serial.println("[WiFi] Running in offline mode - double-reset to configure");
-        }
-        
-        // Save device name and log configuration event if config was saved
-        if (shouldSaveConfig) {
-            String newName = customDeviceName.getValue();
-            if (newName.length() > 0 && newName != oldDeviceName) {
-                strncpy(deviceName, newName.c_str(), sizeof(deviceName) - 1);
-                deviceName[sizeof(deviceName) - 1] = '\0';
-                saveDeviceName(deviceName);
-                
-                String msg = "Name: '" + oldDeviceName + "' -> '" + String(deviceName) + "', SSID: " + 
-                            WiFi.SSID() + ", IP: " + WiFi.localIP().toString();
-                sendEventToInfluxDB("device_configured", msg, "info");
-            } else if (WiFi.status() == WL_CONNECTED) {
-                String msg = "WiFi reconfigured - SSID: " + WiFi.SSID() + ", IP: " + 
-                            WiFi.localIP().toString() + ", Name unchanged: " + String(deviceName);
-                sendEventToInfluxDB("device_configured", msg, "info");
-            }
+            Serial.println("[WiFi] Running in offline mode - config portal open");
         }
     }
+    if (ConfigPortal::isActive()) {
+        PowerManager::acquire(PowerManager::LOCK_HTTP);   // AP + portal need the chip awake
+    }
 
     // Print connection status
     if (WiFi.status() == WL_CONNECTED) {
@@ -528,6 +676,42 @@ void setupWiFi() {
     }
 }
 
+void handleConfigPortal() {
+    ConfigPortal::Event event;
+    {
+        LOOP_PROFILE_REGION("config_portal");
+        event = ConfigPortal::process();
+    }
+    if (event == ConfigPortal::EVENT_NONE) {
+        return;
+    }
+    PowerManager::release(PowerManager::LOCK_HTTP);
+    server.begin();
+    rootPageStale = true;
+
+    if (event != ConfigPortal::EVENT_SAVED) {
+        Serial.println("[WiFi] Configuration portal closed");
+        return;
+    }
+
+    // Save device name and log configuration event
+    String oldDeviceName = String(deviceName);
+    String newName = ConfigPortal::getDeviceName();
+    if (newName.length() > 0 && newName != oldDeviceName) {
+        strncpy(deviceName, newName.c_str(), sizeof(deviceName) - 1);
+        deviceName[sizeof(deviceName) - 1] = '\0';
+        saveDeviceName(deviceName);
+        
+        String msg = "Name: '" + oldDeviceName + "' -> '" + String(deviceName) + "', SSID: " + 
+                    WiFi.SSID() + ", IP: " + WiFi.localIP().toString();
+        sendEventToInfluxDB("device_configured", msg, "info");
+    } else if (WiFi.status() == WL_CONNECTED) {
+        String msg = "WiFi reconfigured - SSID: " + WiFi.SSID() + ", IP: " + 
+                    WiFi.localIP().toString() + ", Name unchanged: " + String(deviceName);
+        sendEventToInfluxDB("device_configured", msg, "info");
+    }
+}
+
 // ============================================================================
 // Web Server Setup
 // ============================================================================
@@ -538,8 +722,17 @@ void setupWebServer() {
     server.on("/api/battery", HTTP_GET, handleBatteryData);
     server.on("/api/solar", HTTP_GET, handleSolarData);
     server.on("/api/system", HTTP_GET, handleSystemData);
-
-    // Start server
+    server.on("/api/vedlog", HTTP_GET, handleVeDirectLog);
+    server.on("/api/daily", HTTP_GET, handleDailyData);
+    server.on("/api/rules", HTTP_GET, handleRulesGet);
+    server.on("/api/rules", HTTP_POST, handleRulesPost, nullptr, handleRulesBody);
+    updateHttpSnapshots();
+
+    // Start server (the config portal holds port 80 while it is open)
+    if (ConfigPortal::isActive()) {
+        Serial.println("[HTTP] Web server starts when the config portal closes");
+        return;
+    }
     server.begin();
     Serial.println("[HTTP] Web server started on port 80");
 }
@@ -547,8 +740,147 @@ void setupWebServer() {
 // ============================================================================
 // Web Request Handlers
 // ============================================================================
+// These run in the async_tcp task. They send bodies rendered by loop()
+// (updateHttpSnapshots, serveHttpJob) and never read the drivers themselves.
+
+// Requests the async server has open (handler run, response not yet sent);
+// loop() holds LOCK_HTTP only while there are any
+static std::atomic<uint16_t> httpRequestsOpen(0);
+
+static void trackRequest(AsyncWebServerRequest* request) {
+    httpRequestsOpen++;
+    request->onDisconnect([]() { httpRequestsOpen--; });
+}
+
+// Stream an immutable body; the response holds a reference, so loop() can
+// publish a newer one while this one is still being sent
+static void sendBody(AsyncWebServerRequest* request, int code, const char* contentType, HttpSnapshot::Body body) {
+    if (!body) {
+        AsyncWebServerResponse* response = request->beginResponse(503, "text/plain", "Busy, retry");
+        response->addHeader("Retry-After", "1");
+        request->send(response);
+        return;
+    }
+    AsyncWebServerResponse* response = request->beginResponse(contentType, body->length(),
+        [body](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+            size_t length = min(maxLen, (size_t)body->length() - index);
+            memcpy(buffer, body->c_str() + index, length);
+            return length;
+        });
+    response->setCode(code);
+    request->send(response);
+}
+
+// Answer with a body loop() renders on demand. The chunked response polls
+// the job (RESPONSE_TRY_AGAIN until it is done), so the handler returns at
+// once; a full job queue is answered like a missing snapshot.
+static void sendJob(AsyncWebServerRequest* request, const char* contentType, HttpSnapshot::Ticket ticket) {
+    if (!ticket) {
+        sendBody(request, 503, contentType, HttpSnapshot::Body());
+        return;
+    }
+    AsyncWebServerResponse* response = request->beginChunkedResponse(contentType,
+        [ticket](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+            HttpSnapshot::Body body = HttpSnapshot::result(ticket);
+            if (!body) {
+                return RESPONSE_TRY_AGAIN;
+            }
+            size_t length = min(maxLen, (size_t)body->length() - index);
+            memcpy(buffer, body->c_str() + index, length);
+            return length;
+        });
+    request->send(response);
+}
+
+void handleRoot(AsyncWebServerRequest* request) {
+    trackRequest(request);
+    sendBody(request, 200, "text/html", HttpSnapshot::get(SLOT_ROOT));
+}
+
+void handleBatteryData(AsyncWebServerRequest* request) {
+    trackRequest(request);
+    sendBody(request, 200, "application/json", HttpSnapshot::get(SLOT_BATTERY));
+}
 
-void handleRoot() {
+void handleSolarData(AsyncWebServerRequest* request) {
+    trackRequest(request);
+    sendBody(request, 200, "application/json", HttpSnapshot::get(SLOT_SOLAR));
+}
+
+void handleSystemData(AsyncWebServerRequest* request) {
+    trackRequest(request);
+    sendBody(request, 200, "application/json", HttpSnapshot::get(SLOT_SYSTEM));
+}
+
+void handleRulesGet(AsyncWebServerRequest* request) {
+    trackRequest(request);
+    sendBody(request, 200, "application/json", HttpSnapshot::get(SLOT_RULES));
+}
+
+// ============================================================================
+// HTTP Snapshots (rendered in loop() for the async handlers)
+// ============================================================================
+
+// No light sleep (and, with esp_pm, full clock) while a request is open, so
+// its job is rendered and its response sent promptly; loop iterations
+// without requests stay free to clock down
+void updateHttpLock() {
+    static bool held = false;
+    bool open = httpRequestsOpen.load() > 0;
+    if (open == held) {
+        return;
+    }
+    held = open;
+    if (open) {
+        PowerManager::acquire(PowerManager::LOCK_HTTP);
+    } else {
+        PowerManager::release(PowerManager::LOCK_HTTP);
+    }
+}
+
+// Live endpoints every HTTP_SNAPSHOT_REFRESH_MS; the page when the device
+// name changed
+void updateHttpSnapshots() {
+    static unsigned long lastRender = 0;
+    if (rootPageStale) {
+        rootPageStale = false;
+        HttpSnapshot::publish(SLOT_ROOT, renderRootPage());
+    }
+    if (lastRender != 0 && millis() - lastRender < HTTP_SNAPSHOT_REFRESH_MS) {
+        return;
+    }
+    LOOP_PROFILE_REGION("http_snapshot");
+    lastRender = millis();
+
+    VeDirectRecorder::Cursor cursor = VeDirectRecorder::getCursor();
+    vedlogCursor.store((uint32_t)cursor.first << 16 | cursor.count);
+    HttpSnapshot::publish(SLOT_BATTERY, renderBatteryJson());
+    HttpSnapshot::publish(SLOT_SOLAR, renderSolarJson());
+    HttpSnapshot::publish(SLOT_SYSTEM, renderSystemJson());
+    HttpSnapshot::publish(SLOT_RULES, renderRulesJson());
+}
+
+// Bodies that depend on request arguments, rendered when a handler asks
+void serveHttpJob() {
+    uint8_t slot;
+    String args;
+    if (!HttpSnapshot::takeJob(slot, args)) {
+        return;
+    }
+    LOOP_PROFILE_REGION("http_job");
+    if (slot == SLOT_DAILY) {
+        HttpSnapshot::finishJob(renderDailyJson(args));
+        return;
+    }
+    bool applied = postRules(args);
+    HttpSnapshot::finishJob(String());
+    if (applied) {
+        // The handler has answered already; the upload can take up to HTTP_TIMEOUT_MS
+        sendEventToInfluxDB("rules_updated", "Loaded " + String(ruleEngine.getRuleCount()) + " rules", "info");
+    }
+}
+
+String renderRootPage() {
     String html = "<!DOCTYPE html><html><head><meta charset=\"UTF-8\"><meta name=\"viewport\" content=\"width=device-width, initial-scale=1.0\"><title>";
     html += String(deviceName);
     html += R"rawliteral(</title>
@@ -677,14 +1009,15 @@ void handleRoot() {
 </html>
 )rawliteral";
 
-    server.send(200, "text/html", html);
+    return html;
 }
 
-void handleBatteryData() {
-    StaticJsonDocument<512> doc;
+String renderBatteryJson() {
+    StaticJsonDocument<1024> doc;
 
     doc["voltage"] = smartShunt.getBatteryVoltage();
     doc["current"] = smartShunt.getBatteryCurrent();
+    doc["power"] = smartShunt.getPower();
     doc["soc"] = smartShunt.getStateOfCharge();
     doc["time_remaining"] = smartShunt.getTimeRemaining();
     doc["consumed_ah"] = smartShunt.getConsumedAh();
@@ -696,13 +1029,37 @@ void handleBatteryData() {
     doc["last_update"] = smartShunt.getLastUpdate();
     doc["valid"] = smartShunt.isDataValid();
 
+    // SmartShunt history (H fields)
+    JsonObject history = doc.createNestedObject("history");
+    history["deepest_discharge"] = smartShunt.getDeepestDischarge();
+    history["last_discharge"] = smartShunt.getLastDischarge();
+    history["average_discharge"] = smartShunt.getAverageDischarge();
+    history["full_discharges"] = smartShunt.getFullDischarges();
+    history["cumulative_ah"] = smartShunt.getCumulativeAh();
+    history["seconds_since_full"] = smartShunt.getSecondsSinceFullCharge();
+    history["syncs"] = smartShunt.getSyncCount();
+    history["low_voltage_alarms"] = smartShunt.getLowVoltageAlarms();
+    history["high_voltage_alarms"] = smartShunt.getHighVoltageAlarms();
+    history["discharged_kwh"] = smartShunt.getDischargedEnergy();
+    history["charged_kwh"] = smartShunt.getChargedEnergy();
+
+    // On-device estimates
+    JsonObject analytics = doc.createNestedObject("analytics");
+    analytics["capacity_ah"] = batteryAnalytics.getCapacityAh();
+    analytics["soh"] = batteryAnalytics.getStateOfHealth();
+    analytics["capacity_samples"] = batteryAnalytics.getCapacitySamples();
+    analytics["full_charges"] = batteryAnalytics.getFullCharges();
+    analytics["depth_ah"] = batteryAnalytics.getDepthAh();
+    analytics["load_current"] = batteryAnalytics.getLoadCurrent();
+    analytics["ttg_forecast"] = batteryAnalytics.getTimeToGo();
+
     String response;
     serializeJson(doc, response);
-    server.send(200, "application/json", response);
+    return response;
 }
 
-void handleSolarData() {
-    StaticJsonDocument<1024> doc;
+String renderSolarJson() {
+    StaticJsonDocument<1536> doc;
 
     // MPPT1 data
     JsonObject mppt1Data = doc.createNestedObject("mppt1");
@@ -754,13 +1111,26 @@ void handleSolarData() {
     totals["yield_today"] = mppt1.getYieldToday() + mppt2.getYieldToday();
     totals["yield_yesterday"] = mppt1.getYieldYesterday() + mppt2.getYieldYesterday();
 
+    // Parallel charger comparison (MPPT1 share of PV power, panel voltage ratio)
+    JsonObject comparison = doc.createNestedObject("comparison");
+    comparison["baseline_ready"] = mpptComparator.isBaselineReady();
+    comparison["power_share"] = mpptComparator.getPowerShare();
+    comparison["power_share_baseline"] = mpptComparator.getPowerShareBaseline();
+    comparison["power_share_z"] = mpptComparator.getPowerShareZ();
+    comparison["voltage_ratio"] = mpptComparator.getVoltageRatio();
+    comparison["voltage_ratio_baseline"] = mpptComparator.getVoltageRatioBaseline();
+    comparison["voltage_ratio_z"] = mpptComparator.getVoltageRatioZ();
+    comparison["power_deviating"] = mpptComparator.isPowerDeviating();
+    comparison["voltage_deviating"] = mpptComparator.isVoltageDeviating();
+    comparison["events"] = mpptComparator.getEventCount();
+
     String response;
     serializeJson(doc, response);
-    server.send(200, "application/json", response);
+    return response;
 }
 
-void handleSystemData() {
-    StaticJsonDocument<2048> doc;
+String renderSystemJson() {
+    StaticJsonDocument<2304> doc;
 
     // Battery subsystem
     JsonObject battery = doc.createNestedObject("battery");
@@ -769,6 +1139,8 @@ void handleSystemData() {
     battery["soc"] = smartShunt.getStateOfCharge();
     battery["time_remaining"] = smartShunt.getTimeRemaining();
     battery["consumed_ah"] = smartShunt.getConsumedAh();
+    battery["soh"] = batteryAnalytics.getStateOfHealth();
+    battery["ttg_forecast"] = batteryAnalytics.getTimeToGo();
     battery["valid"] = smartShunt.isDataValid();
 
     // Solar subsystem - combined totals for backward compatibility
@@ -810,9 +1182,786 @@ void handleSystemData() {
     system["ip_address"] = WiFi.localIP().toString();
     system["free_heap"] = ESP.getFreeHeap();
 
+    // Loop latency histogram: bucket n counts iterations shorter than 2^n ms
+    JsonObject loopStats = system.createNestedObject("loop");
+    loopStats["iterations"] = LoopProfiler::getIterations();
+    loopStats["max_ms"] = LoopProfiler::getMaxIterationMs();
+    loopStats["stalls"] = LoopProfiler::getStallCount();
+    loopStats["last_stall_region"] = LoopProfiler::getLastStallRegion();
+    loopStats["last_stall_ms"] = LoopProfiler::getLastStallMs();
+    JsonArray histogram = loopStats.createNestedArray("histogram");
+    for (uint8_t i = 0; i < LoopProfiler::HISTOGRAM_BUCKETS; i++) {
+        histogram.add(LoopProfiler::getBucket(i));
+    }
+
+    JsonObject modbus = system.createNestedObject("modbus");
+    modbus["clients"] = ModbusServer::getActiveClients();
+    modbus["connections"] = ModbusServer::getConnections();
+    modbus["rejected"] = ModbusServer::getRejected();
+    modbus["requests"] = ModbusServer::getRequests();
+    modbus["exceptions"] = ModbusServer::getExceptions();
+    modbus["snapshots"] = ModbusServer::getSnapshots();
+
+    JsonObject vedlog = system.createNestedObject("vedlog");
+    vedlog["active"] = VeDirectRecorder::isActive();
+    vedlog["capacity"] = VeDirectRecorder::getCapacityBytes();
+    vedlog["sectors"] = VeDirectRecorder::getSectorCount();
+    vedlog["bytes"] = VeDirectRecorder::getBytesRecorded();
+    vedlog["page_writes"] = VeDirectRecorder::getPageWrites();
+    vedlog["sector_erases"] = VeDirectRecorder::getSectorErases();
+    vedlog["write_failures"] = VeDirectRecorder::getWriteFailures();
+    vedlog["flash_ms"] = VeDirectRecorder::getFlashTimeMs();
+
+    // Estimated draw from time at each clock and asleep; baseline = always 240 MHz
+    PowerManager::Stats powerStats;
+    PowerManager::getStats(powerStats);
+    JsonObject power = system.createNestedObject("power");
+    power["mode"] = PowerManager::getModeName();
+    power["current_ma"] = PowerManager::getCurrentMa();
+    power["baseline_ma"] = PowerManager::getBaselineCurrentMa();
+    power["full_ms"] = powerStats.fullMs;
+    power["low_ms"] = powerStats.lowMs;
+    power["idle_ms"] = powerStats.idleMs;
+    power["uart_locks"] = powerStats.lockCount[PowerManager::LOCK_UART];
+    power["unexpected_bursts"] = powerStats.unexpectedBursts;
+    JsonObject frameErrors = power.createNestedObject("frame_errors");
+    frameErrors["shunt"] = smartShunt.getChecksumErrors();
+    frameErrors["mppt1"] = mppt1.getChecksumErrors();
+    frameErrors["mppt2"] = mppt2.getChecksumErrors();
+
+    JsonObject http = system.createNestedObject("http");
+    http["snapshots"] = HttpSnapshot::getPublished();
+    http["served"] = HttpSnapshot::getServed();
+    http["jobs_rejected"] = HttpSnapshot::getJobsRejected();
+
+    String response;
+    serializeJson(doc, response);
+    return response;
+}
+
+// Raw log download, oldest sector first (parse with the native host runner:
+// --vedlog). ?sectors=N limits it to the newest N sectors. Streams straight
+// from flash from the cursor loop() last published; the recorder keeps
+// writing meanwhile (see VeDirectRecorder::readFlash).
+void handleVeDirectLog(AsyncWebServerRequest* request) {
+    trackRequest(request);
+    using namespace VeDirectRecorder;
+    uint32_t packed = vedlogCursor.load();
+    Cursor cursor = {(uint16_t)(packed >> 16), (uint16_t)(packed & 0xFFFF)};
+    if (cursor.count == 0) {
+        request->send(503, "text/plain", "VE.Direct recorder not active");
+        return;
+    }
+    uint16_t first = 0;
+    if (request->hasArg("sectors")) {
+        long requested = request->arg("sectors").toInt();
+        if (requested > 0 && requested < cursor.count) {
+            first = cursor.count - requested;
+        }
+    }
+
+    AsyncWebServerResponse* response = request->beginResponse("application/octet-stream",
+        (size_t)(cursor.count - first) * SECTOR_SIZE,
+        [cursor, first](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+            // Never across a sector boundary; the server asks again for the rest
+            uint16_t sector = first + index / SECTOR_SIZE;
+            uint16_t offset = index % SECTOR_SIZE;
+            uint16_t length = (uint16_t)min(maxLen, (size_t)(SECTOR_SIZE - offset));
+            if (!readFlash(cursor, sector, offset, buffer, length)) {
+                memset(buffer, 0xFF, length);  // Keep the length; parser skips it
+            }
+            return length;
+        });
+    response->addHeader("Content-Disposition", "attachment; filename=\"vedlog.bin\"");
+    request->send(response);
+}
+
+// Per-day ledger, newest first: ?days=N (default 31, up to 62 per page) and
+// ?offset=M (skip the M most recent days). Each day is one seek in the
+// ledger file; loop() renders the page (renderDailyJson) while the handler waits.
+static void fillBatteryJson(JsonObject obj, const DailyLedger::Battery& battery) {
+    obj["min_v"] = battery.minVoltage / 100.0f;
+    obj["max_v"] = battery.maxVoltage / 100.0f;
+    obj["ah_in"] = battery.ahIn / 10.0f;
+    obj["ah_out"] = battery.ahOut / 10.0f;
+}
+
+static void appendDayJson(String& out, const DailyLedger::Day& day, int daysAgo, bool first) {
+    StaticJsonDocument<768> doc;
+    doc["days_ago"] = daysAgo;
+    doc["closed_at"] = day.closedAt;
+    if (day.daySequence != 0xFFFF) {
+        doc["day_seq"] = day.daySequence;
+    }
+    doc["restarted"] = (day.flags & DailyLedger::FLAG_RESTARTED) != 0;
+    if (day.flags & DailyLedger::FLAG_SHUNT) {
+        fillBatteryJson(doc.createNestedObject("shunt"), day.shunt);
+    }
+    for (uint8_t i = 0; i < DailyLedger::CHARGERS; i++) {
+        if (!(day.flags & (DailyLedger::FLAG_MPPT1 << i))) {
+            continue;
+        }
+        JsonObject mppt = doc.createNestedObject(i == 0 ? "mppt1" : "mppt2");
+        mppt["yield_kwh"] = day.mppt[i].yield / 100.0f;
+        mppt["max_power"] = day.mppt[i].maxPower;
+        fillBatteryJson(mppt, day.mppt[i].battery);
+    }
+
+    char buffer[640];
+    size_t length = 0;
+    if (!first) {
+        buffer[length++] = ',';
+    }
+    length += serializeJson(doc, buffer + length, sizeof(buffer) - length);
+    out.concat(buffer, length);
+}
+
+void handleDailyData(AsyncWebServerRequest* request) {
+    trackRequest(request);
+    long count = request->hasArg("days") ? request->arg("days").toInt() : DAILY_API_MAX_DAYS;
+    long offset = request->hasArg("offset") ? request->arg("offset").toInt() : 0;
+    count = constrain(count, 0, (long)DAILY_API_PAGE_LIMIT);
+    offset = constrain(offset, 0, (long)DailyLedger::CAPACITY);
+    String args = String(count) + "," + String(offset);
+    sendJob(request, "application/json", HttpSnapshot::submit(SLOT_DAILY, args));
+}
+
+// args: "days,offset", already range-checked by handleDailyData()
+String renderDailyJson(const String& args) {
+    long count = args.toInt();
+    long offset = args.substring(args.indexOf(',') + 1).toInt();
+
+    char header[96];
+    snprintf(header, sizeof(header), "{\"capacity\":%u,\"stored\":%u,\"today\":",
+             DailyLedger::CAPACITY, dailyLedger.getStoredDays());
+    String json;
+    json.reserve(sizeof(header) + (count + 1) * 352);
+    json += header;
+    appendDayJson(json, dailyLedger.getToday(), -1, true);
+    json += ",\"days\":[";
+
+    DailyLedger::Day day;
+    bool first = true;
+    for (long daysAgo = offset; daysAgo < offset + count && dailyLedger.getDay(daysAgo, day); daysAgo++) {
+        appendDayJson(json, day, daysAgo, first);
+        first = false;
+    }
+    json += "]}";
+    return json;
+}
+
+// ============================================================================
+// Battery Analytics
+// ============================================================================
+
+void loadBatteryState() {
+    BatteryAnalytics::State state;
+    batteryPrefs.begin("battery", true);
+    size_t length = batteryPrefs.getBytes("state", &state, sizeof(state));
+    batteryPrefs.end();
+
+    if (length == sizeof(state) && batteryAnalytics.restoreState(state)) {
+        Serial.printf("[Battery] Restored capacity %.1f Ah (SoH %.1f%%, %u samples)\n",
+            batteryAnalytics.getCapacityAh(),
+            batteryAnalytics.getStateOfHealth(),
+            batteryAnalytics.getCapacitySamples());
+    } else {
+        Serial.println("[Battery] No saved analytics, starting from nominal capacity");
+    }
+}
+
+// Feed each new SmartShunt block to the estimator and persist what it learned:
+// capacity samples right away (a few per month), the load profile every 6 h
+void updateBatteryAnalytics() {
+    static uint32_t lastBlock = 0;
+    static uint16_t savedSamples = 0;
+    static unsigned long lastSave = 0;
+
+    uint32_t block = smartShunt.getBlockCount();
+    if (block == lastBlock || !smartShunt.isDataValid()) {
+        return;
+    }
+    lastBlock = block;
+
+    // Seconds into the UTC day once NTP has set the clock
+    time_t now = time(nullptr);
+    int32_t secondsOfDay = now > 1600000000 ? (int32_t)(now % 86400) : -1;
+
+    batteryAnalytics.update(millis(), smartShunt.getBatteryVoltage(), smartShunt.getBatteryCurrent(),
+                            smartShunt.getStateOfCharge(), secondsOfDay);
+
+    if (batteryAnalytics.stateChanged()
+        && (batteryAnalytics.getCapacitySamples() != savedSamples || millis() - lastSave >= BATTERY_STATE_SAVE_INTERVAL_MS)) {
+        BatteryAnalytics::State state;
+        batteryAnalytics.saveState(state);
+        batteryPrefs.begin("battery", false);
+        batteryPrefs.putBytes("state", &state, sizeof(state));
+        batteryPrefs.end();
+        savedSamples = state.capacitySamples;
+        lastSave = millis();
+    }
+}
+
+// ============================================================================
+// MPPT Comparison
+// ============================================================================
+
+static MpptComparator::Reading mpptReading(const VictronMPPT& mppt) {
+    MpptComparator::Reading reading;
+    reading.valid = mppt.isDataValid();
+    reading.panelVoltage = mppt.getPanelVoltage();
+    reading.panelPower = mppt.getPanelPower();
+    reading.chargeState = (uint8_t)mppt.getChargeStateEnum();
+    reading.errorCode = mppt.getErrorCode();
+    return reading;
+}
+
+// Run the comparator on every new frame from either charger
+void updateMpptComparison() {
+    static uint32_t lastBlocks = 0;
+    uint32_t blocks = mppt1.getBlockCount() + mppt2.getBlockCount();
+    if (blocks == lastBlocks) {
+        return;
+    }
+    lastBlocks = blocks;
+    mpptComparator.update(millis(), mpptReading(mppt1), mpptReading(mppt2));
+}
+
+// Comparator events go to InfluxDB like the other device events
+void onMpptEvent(const MpptComparator::Event& event) {
+    char message[128];
+    const char* eventType = "mppt_deviation";
+    const char* severity = "warning";
+    uint8_t mppt = event.charger + 1;
+
+    switch (event.type) {
+        case MpptComparator::POWER_DEVIATION:
+            snprintf(message, sizeof(message), "MPPT%u underperforming: MPPT1 power share %.0f%% vs baseline %.0f%% (z=%.1f)",
+                     mppt, event.value * 100, event.baseline * 100, event.zScore);
+            break;
+        case MpptComparator::POWER_RECOVERED:
+            snprintf(message, sizeof(message), "MPPT power share back to baseline: %.0f%% vs %.0f%%",
+                     event.value * 100, event.baseline * 100);
+            severity = "info";
+            break;
+        case MpptComparator::VOLTAGE_DEVIATION:
+            snprintf(message, sizeof(message), "MPPT%u panel voltage low: MPPT1/MPPT2 ratio %.2f vs baseline %.2f (z=%.1f)",
+                     mppt, event.value, event.baseline, event.zScore);
+            break;
+        case MpptComparator::VOLTAGE_RECOVERED:
+            snprintf(message, sizeof(message), "MPPT panel voltage ratio back to baseline: %.2f vs %.2f",
+                     event.value, event.baseline);
+            severity = "info";
+            break;
+        case MpptComparator::ERROR_RAISED:
+            snprintf(message, sizeof(message), "MPPT%u error %d: %s (was %d)",
+                     mppt, (int)event.value, (mppt == 1 ? mppt1 : mppt2).getErrorString().c_str(), (int)event.baseline);
+            eventType = "mppt_error";
+            severity = "error";
+            break;
+        case MpptComparator::ERROR_CLEARED:
+            snprintf(message, sizeof(message), "MPPT%u error %d cleared", mppt, (int)event.baseline);
+            eventType = "mppt_error";
+            severity = "info";
+            break;
+    }
+    Serial.printf("[MPPT] %s\n", message);
+    sendEventToInfluxDB(eventType, message, severity);
+}
+
+// ============================================================================
+// Local Rule Engine
+// ============================================================================
+
+// Pins already used by the UARTs and the OLED; 34-39 are input only
+static bool isRuleOutputPin(int pin) {
+    return pin >= 0 && pin <= 33 && pin != SMARTSHUNT_RX_PIN && pin != MPPT1_RX_PIN
+        && pin != MPPT2_RX_PIN && pin != 21 && pin != 22 && !(pin >= 6 && pin <= 11);
+}
+
+// Active rule names, one per line, so outputs survive a reboot
+static void saveActiveRules() {
+    String names;
+    for (uint8_t i = 0; i < ruleEngine.getRuleCount(); i++) {
+        const RuleEngine::Rule& rule = ruleEngine.getRule(i);
+        if (rule.active) {
+            names += rule.name;
+            names += '\n';
+        }
+    }
+    rulePrefs.begin("rules", false);
+    rulePrefs.putString("active", names);
+    rulePrefs.end();
+}
+
+static void restoreActiveRules() {
+    rulePrefs.begin("rules", true);
+    String names = rulePrefs.getString("active", "");
+    rulePrefs.end();
+    for (uint8_t i = 0; i < ruleEngine.getRuleCount(); i++) {
+        String line = String(ruleEngine.getRule(i).name) + '\n';
+        if (names.startsWith(line) || names.indexOf(String('\n') + line) >= 0) {
+            ruleEngine.restoreActive(i);
+        }
+    }
+}
+
+/**
+ * Compile a JSON rule set into a malloc'd array (free() it) without touching
+ * the running rules. Reads no shared state, so the web handler can use it to
+ * reject a bad rule set before handing it to loop().
+ *
+ * {"rules":[{"name":"shed_load","if":"soc < 30","hysteresis":5,"for":10,"clear_for":60,
+ *            "action":"gpio","pin":25,"level":1}, ...]}
+ */
+static bool buildRules(const String& json, RuleEngine::Rule*& staged, uint8_t& count, String& error) {
+    staged = nullptr;
+    DynamicJsonDocument doc(RULES_JSON_CAPACITY);
+    DeserializationError parseError = deserializeJson(doc, json);
+    if (parseError) {
+        error = String("invalid JSON: ") + parseError.c_str();
+        return false;
+    }
+    JsonArray rules = doc["rules"].as<JsonArray>();
+    if (rules.isNull() || rules.size() > RuleEngine::MAX_RULES) {
+        error = "expected \"rules\": [...] with at most " + String(RuleEngine::MAX_RULES) + " rules";
+        return false;
+    }
+
+    staged = (RuleEngine::Rule*)malloc((rules.size() + 1) * sizeof(RuleEngine::Rule));
+    if (!staged) {
+        error = "out of memory";
+        return false;
+    }
+    char message[96];
+    uint8_t index = 0;
+    for (JsonObject rule : rules) {
+        const char* name = rule["name"] | "";
+        const char* type = rule["action"] | "event";
+        const char* url = rule["url"] | "";
+        int pin = rule["pin"] | -1;
+        RuleEngine::Action action;
+        memset(&action, 0, sizeof(action));
+        bool ok = true;
+        if (strcmp(type, "gpio") == 0) {
+            action.type = RuleEngine::ACTION_GPIO;
+            action.pin = pin;
+            action.level = (rule["level"] | 1) ? HIGH : LOW;
+            if (!isRuleOutputPin(pin)) {
+                snprintf(message, sizeof(message), "pin %d cannot be used as an output", pin);
+                ok = false;
+            }
+        } else if (strcmp(type, "webhook") == 0) {
+            action.type = RuleEngine::ACTION_WEBHOOK;
+            strncpy(action.target, url, sizeof(action.target) - 1);
+            if (strncmp(url, "http://", 7) != 0) {
+                snprintf(message, sizeof(message), "webhook needs an http:// url");
+                ok = false;
+            } else if (strlen(url) >= sizeof(action.target)) {
+                snprintf(message, sizeof(message), "webhook url longer than %u characters",
+                         (unsigned)sizeof(action.target) - 1);
+                ok = false;
+            }
+        } else if (strcmp(type, "event") == 0) {
+            action.type = RuleEngine::ACTION_EVENT;
+            strncpy(action.target, rule["severity"] | "warning", sizeof(action.target) - 1);
+        } else {
+            snprintf(message, sizeof(message), "unknown action '%s'", type);
+            ok = false;
+        }
+        ok = ok && strlen(name) > 0
+            && RuleEngine::build(staged[index], name, rule["if"] | "", rule["hysteresis"] | 0.0f,
+                                 (uint32_t)((rule["for"] | 0.0f) * 1000),
+                                 (uint32_t)((rule["clear_for"] | 0.0f) * 1000),
+                                 action, message, sizeof(message));
+        if (!ok) {
+            error = "rule " + String(index) + " (" + name + "): " + (strlen(name) ? message : "missing name");
+            free(staged);
+            staged = nullptr;
+            return false;
+        }
+        index++;
+    }
+    count = index;
+    return true;
+}
+
+/**
+ * Compile a JSON rule set and replace the running rules. Nothing changes if
+ * any rule fails to compile. Unchanged rules keep their state, so an active
+ * output is not toggled by re-posting the same rules; at boot (restore) the
+ * rules that were active before the reboot are marked active again.
+ */
+bool applyRules(const String& json, String& error, bool restore) {
+    RuleEngine::Rule* staged;
+    uint8_t count;
+    if (!buildRules(json, staged, count, error)) {
+        return false;
+    }
+    ruleEngine.replace(staged, count);
+    free(staged);
+    if (restore) {
+        restoreActiveRules();
+    }
+
+    // Outputs follow the (possibly carried over) rule state
+    for (uint8_t i = 0; i < ruleEngine.getRuleCount(); i++) {
+        const RuleEngine::Rule& rule = ruleEngine.getRule(i);
+        if (rule.action.type == RuleEngine::ACTION_GPIO) {
+            pinMode(rule.action.pin, OUTPUT);
+            digitalWrite(rule.action.pin, rule.active ? rule.action.level : !rule.action.level);
+        }
+    }
+    saveActiveRules();
+    return true;
+}
+
+void loadRules() {
+    if (!FILESYSTEM.exists(RULES_FILE)) {
+        Serial.println("[Rules] No rule set");
+        return;
+    }
+    File file = FILESYSTEM.open(RULES_FILE, "r");
+    if (!file) {
+        return;
+    }
+    String json = file.readString();
+    file.close();
+
+    String error;
+    if (applyRules(json, error, true)) {
+        Serial.printf("[Rules] Loaded %u rules\n", ruleEngine.getRuleCount());
+    } else {
+        Serial.println("[Rules] Stored rule set rejected: " + error);
+    }
+}
+
+// Readings for the rules; NAN marks a device without current data
+static void fillRuleSignals(float* signals) {
+    using RE = RuleEngine;
+    for (uint8_t i = 0; i < RE::SIGNAL_COUNT; i++) {
+        signals[i] = NAN;
+    }
+    if (smartShunt.isDataValid()) {
+        signals[RE::BATTERY_V] = smartShunt.getBatteryVoltage();
+        signals[RE::BATTERY_I] = smartShunt.getBatteryCurrent();
+        signals[RE::BATTERY_P] = smartShunt.getPower();
+        signals[RE::SOC] = smartShunt.getStateOfCharge();
+        signals[RE::TTG] = smartShunt.getTimeRemaining();
+        signals[RE::CONSUMED_AH] = smartShunt.getConsumedAh();
+        signals[RE::ALARM] = smartShunt.getAlarmState() ? 1 : 0;
+        signals[RE::SOH] = batteryAnalytics.getStateOfHealth();
+        signals[RE::TTG_FORECAST] = batteryAnalytics.getTimeToGo();
+    }
+    const VictronMPPT* chargers[2] = {&mppt1, &mppt2};
+    for (uint8_t i = 0; i < 2; i++) {
+        const VictronMPPT& mppt = *chargers[i];
+        if (!mppt.isDataValid()) {
+            continue;
+        }
+        uint8_t base = i == 0 ? RE::MPPT1_PV_V : RE::MPPT2_PV_V;
+        signals[base] = mppt.getPanelVoltage();
+        signals[base + 1] = mppt.getPanelPower();
+        signals[base + 2] = mppt.getChargeCurrent();
+        signals[base + 3] = (float)mppt.getChargeStateEnum();
+        signals[base + 4] = mppt.getErrorCode();
+        signals[RE::PV_POWER] = (isnan(signals[RE::PV_POWER]) ? 0 : signals[RE::PV_POWER]) + mppt.getPanelPower();
+        signals[RE::CHARGE_CURRENT] = (isnan(signals[RE::CHARGE_CURRENT]) ? 0 : signals[RE::CHARGE_CURRENT]) + mppt.getChargeCurrent();
+    }
+    time_t now = time(nullptr);
+    if (now > 1600000000) {
+        signals[RE::HOUR] = (now % 86400) / 3600;
+    }
+}
+
+// Evaluate on every committed block from any device
+void updateRules() {
+    static uint32_t lastBlocks = 0;
+    uint32_t blocks = smartShunt.getBlockCount() + mppt1.getBlockCount() + mppt2.getBlockCount();
+    if (blocks == lastBlocks || ruleEngine.getRuleCount() == 0) {
+        return;
+    }
+    lastBlocks = blocks;
+
+    LOOP_PROFILE_REGION("rules");
+    float signals[RuleEngine::SIGNAL_COUNT];
+    fillRuleSignals(signals);
+    ruleEngine.evaluate(millis(), signals);
+}
+
+// Runs on the webhook worker: DNS, connect and response waits stay off loop()
+int sendRuleWebhook(const char* url, const char* body, size_t length) {
+    if (WiFi.status() != WL_CONNECTED) {
+        return HTTPC_ERROR_NOT_CONNECTED;
+    }
+    HTTPClient http;
+    http.setTimeout(RULE_WEBHOOK_TIMEOUT_MS);
+    http.setConnectTimeout(RULE_WEBHOOK_TIMEOUT_MS);
+    http.begin(url);
+    http.addHeader("Content-Type", "application/json");
+    int httpCode = http.POST((uint8_t*)body, length);
+    http.end();
+    return httpCode;
+}
+
+// Hold the upload lock while the worker has webhooks queued or in flight.
+// PowerManager is not thread-safe, so the lock is taken here rather than on the worker.
+void updateWebhookLock() {
+    static bool held = false;
+    bool busy = WebhookQueue::getPending() > 0;
+    if (busy == held) {
+        return;
+    }
+    held = busy;
+    if (busy) {
+        PowerManager::acquire(PowerManager::LOCK_UPLOAD);
+    } else {
+        PowerManager::release(PowerManager::LOCK_UPLOAD);
+    }
+}
+
+static void postRuleWebhook(const RuleEngine::Rule& rule, bool active) {
+    StaticJsonDocument<384> doc;
+    doc["device"] = deviceName;
+    doc["rule"] = rule.name;
+    doc["state"] = active ? "active" : "cleared";
+    doc["condition"] = rule.expression;
+    doc["uptime"] = (millis() - bootTime) / 1000;
+    char body[WebhookQueue::MAX_BODY];
+    size_t length = serializeJson(doc, body, sizeof(body));
+    if (!WebhookQueue::post(rule.action.target, body, length)) {
+        Serial.printf("[Rules] Webhook for %s dropped (queue full)\n", rule.name);
+    }
+}
+
+void onRuleAction(const RuleEngine::Rule& rule, bool active) {
+    Serial.printf("[Rules] %s %s (%s)\n", rule.name, active ? "active" : "cleared", rule.expression);
+    switch (rule.action.type) {
+        case RuleEngine::ACTION_GPIO:
+            digitalWrite(rule.action.pin, active ? rule.action.level : !rule.action.level);
+            break;
+        case RuleEngine::ACTION_WEBHOOK:
+            postRuleWebhook(rule, active);
+            break;
+        case RuleEngine::ACTION_EVENT: {
+            String message = String("Rule ") + rule.name + (active ? " active: " : " cleared: ") + rule.expression;
+            sendEventToInfluxDB(active ? "rule_triggered" : "rule_cleared", message, active ? rule.action.target : "info");
+            break;
+        }
+    }
+    saveActiveRules();
+}
+
+String renderRulesJson() {
+    StaticJsonDocument<2816> doc;
+    doc["evaluations"] = ruleEngine.getEvaluations();
+    JsonArray rules = doc.createNestedArray("rules");
+    for (uint8_t i = 0; i < ruleEngine.getRuleCount(); i++) {
+        const RuleEngine::Rule& rule = ruleEngine.getRule(i);
+        JsonObject obj = rules.createNestedObject();
+        obj["name"] = (const char*)rule.name;
+        obj["if"] = (const char*)rule.expression;
+        obj["active"] = rule.active;
+        obj["activations"] = rule.activations;
+        obj["instructions"] = rule.length;
+    }
+    JsonObject webhooks = doc.createNestedObject("webhooks");
+    webhooks["pending"] = WebhookQueue::getPending();
+    webhooks["sent"] = WebhookQueue::getSent();
+    webhooks["failed"] = WebhookQueue::getFailed();
+    webhooks["dropped"] = WebhookQueue::getDropped();
+    webhooks["max_post_ms"] = WebhookQueue::getMaxPostMs();
+    webhooks["last_status"] = WebhookQueue::getLastStatus();
+    JsonArray signals = doc.createNestedArray("signals");
+    for (uint8_t i = 0; i < RuleEngine::SIGNAL_COUNT; i++) {
+        signals.add(RuleEngine::signalName(i));
+    }
+
+    String response;
+    serializeJson(doc, response);
+    return response;
+}
+
+// Collect the body of POST /api/rules. Only non-form bodies reach here, so
+// the rule set must be sent as Content-Type: application/json. A body over
+// RULES_JSON_CAPACITY is not buffered; handleRulesPost() answers 413.
+void handleRulesBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+    if (total > RULES_JSON_CAPACITY) {
+        return;
+    }
+    if (index == 0) {
+        request->_tempObject = malloc(total + 1);   // Freed with the request
+    }
+    if (request->_tempObject) {
+        memcpy((char*)request->_tempObject + index, data, len);
+        ((char*)request->_tempObject)[index + len] = '\0';
+    }
+}
+
+static void sendRulesError(AsyncWebServerRequest* request, int code, const String& error) {
+    StaticJsonDocument<256> doc;
+    doc["error"] = error;
     String response;
     serializeJson(doc, response);
-    server.send(200, "application/json", response);
+    request->send(code, "application/json", response);
+}
+
+// Body is the rule set; it is only stored if every rule compiles. It is
+// checked here (compiling reads no shared state) and applied by loop()
+// (postRules), which owns the rule engine, so the answer is final: an
+// accepted rule set is always applied and a rejected one never is.
+void handleRulesPost(AsyncWebServerRequest* request) {
+    trackRequest(request);
+    if (request->contentLength() > RULES_JSON_CAPACITY) {
+        sendRulesError(request, 413, "rule set larger than " + String(RULES_JSON_CAPACITY) + " bytes");
+        return;
+    }
+    if (!request->_tempObject) {
+        sendRulesError(request, 400, "expected a JSON body (Content-Type: application/json)");
+        return;
+    }
+    String json((const char*)request->_tempObject);
+    RuleEngine::Rule* staged;
+    uint8_t count;
+    String error;
+    if (!buildRules(json, staged, count, error)) {
+        sendRulesError(request, 400, error);
+        return;
+    }
+    free(staged);
+    if (!HttpSnapshot::submit(SLOT_RULES_POST, json)) {
+        sendBody(request, 503, "application/json", HttpSnapshot::Body());
+        return;
+    }
+    char response[64];
+    snprintf(response, sizeof(response), "{\"status\":\"ok\",\"rules\":%u}", (unsigned)count);
+    request->send(200, "application/json", response);
+}
+
+// Apply a rule set accepted by handleRulesPost() and store it
+bool postRules(const String& json) {
+    String error;
+    if (!applyRules(json, error, false)) {
+        Serial.println("[Rules] Accepted rule set not applied: " + error);
+        return false;
+    }
+
+    File file = FILESYSTEM.open(RULES_FILE, "w");
+    if (file) {
+        file.print(json);
+        file.close();
+    }
+    HttpSnapshot::publish(SLOT_RULES, renderRulesJson());
+    return true;
+}
+
+// ============================================================================
+// Daily Energy Ledger
+// ============================================================================
+
+static DailyLedger::ChargerReading ledgerReading(const VictronMPPT& mppt) {
+    DailyLedger::ChargerReading reading;
+    reading.batteryVoltage = mppt.getBatteryVoltage();
+    reading.chargeCurrent = mppt.getChargeCurrent();
+    reading.loadCurrent = mppt.getLoadCurrent();
+    reading.yieldToday = mppt.getYieldToday();
+    reading.maxPowerToday = mppt.getMaxPowerToday();
+    reading.yieldYesterday = mppt.getYieldYesterday();
+    reading.maxPowerYesterday = mppt.getMaxPowerYesterday();
+    reading.daySequence = mppt.getDaySequence();
+    return reading;
+}
+
+// Feed each new block; rollovers are detected inside the ledger
+void updateDailyLedger() {
+    static uint32_t lastShuntBlock = 0;
+    static uint32_t lastMpptBlock[2] = {0, 0};
+    static unsigned long lastSave = 0;
+    static uint32_t lastClosed = 0;
+
+    time_t now = time(nullptr);
+    uint32_t unixTime = now > 1600000000 ? (uint32_t)now : 0;
+
+    if (smartShunt.getBlockCount() != lastShuntBlock && smartShunt.isDataValid()) {
+        lastShuntBlock = smartShunt.getBlockCount();
+        dailyLedger.updateShunt(millis(), smartShunt.getBatteryVoltage(), smartShunt.getBatteryCurrent());
+    }
+    const VictronMPPT* chargers[2] = {&mppt1, &mppt2};
+    for (uint8_t i = 0; i < 2; i++) {
+        const VictronMPPT& mppt = *chargers[i];
+        if (mppt.getBlockCount() != lastMpptBlock[i] && mppt.isDataValid()) {
+            lastMpptBlock[i] = mppt.getBlockCount();
+            dailyLedger.updateCharger(i, millis(), ledgerReading(mppt), unixTime);
+        }
+    }
+
+    if (dailyLedger.getClosedDays() != lastClosed) {
+        lastClosed = dailyLedger.getClosedDays();
+        DailyLedger::Day day;
+        if (dailyLedger.getDay(0, day)) {
+            Serial.printf("[Daily] Day closed: %.2f + %.2f kWh, shunt %.1f Ah in / %.1f Ah out\n",
+                day.mppt[0].yield / 100.0f, day.mppt[1].yield / 100.0f, day.shunt.ahIn / 10.0f, day.shunt.ahOut / 10.0f);
+        }
+        lastSave = millis();
+    } else if (millis() - lastSave >= DAILY_LEDGER_SAVE_INTERVAL_MS) {
+        dailyLedger.saveToday();
+        lastSave = millis();
+    }
+}
+
+// ============================================================================
+// Modbus-TCP Snapshot
+// ============================================================================
+
+static void fillMpptRegisters(uint16_t* regs, uint16_t base, const VictronMPPT& mppt) {
+    using namespace ModbusServer;
+    regs[base + MPPT_BATTERY_VOLTAGE] = toUnsigned(mppt.getBatteryVoltage(), 100);
+    regs[base + MPPT_CHARGE_CURRENT] = toUnsigned(mppt.getChargeCurrent(), 10);
+    regs[base + MPPT_PANEL_VOLTAGE] = toUnsigned(mppt.getPanelVoltage(), 100);
+    regs[base + MPPT_PANEL_POWER] = toUnsigned(mppt.getPanelPower(), 1);
+    regs[base + MPPT_CHARGE_STATE] = (uint16_t)mppt.getChargeStateEnum();
+    regs[base + MPPT_ERROR_CODE] = (uint16_t)mppt.getErrorCode();
+    regs[base + MPPT_YIELD_TODAY] = toUnsigned(mppt.getYieldToday(), 100);
+    regs[base + MPPT_MAX_POWER_TODAY] = toUnsigned(mppt.getMaxPowerToday(), 1);
+}
+
+// Publish a register image whenever a parser commits a block (at most once
+// per loop), and at least every MODBUS_SNAPSHOT_REFRESH_MS
+void updateModbusSnapshot() {
+    using namespace ModbusServer;
+    static uint32_t lastBlocks = 0;
+    static unsigned long lastPublish = 0;
+
+    uint32_t blocks = smartShunt.getBlockCount() + mppt1.getBlockCount() + mppt2.getBlockCount();
+    if (blocks == lastBlocks && millis() - lastPublish < MODBUS_SNAPSHOT_REFRESH_MS) {
+        return;
+    }
+    lastBlocks = blocks;
+    lastPublish = millis();
+
+    uint16_t regs[REGISTER_COUNT] = {0};
+    uint16_t flags = 0;
+    if (smartShunt.isDataValid()) flags |= FLAG_SHUNT_VALID;
+    if (mppt1.isDataValid()) flags |= FLAG_MPPT1_VALID;
+    if (mppt2.isDataValid()) flags |= FLAG_MPPT2_VALID;
+    if (smartShunt.getAlarmState()) flags |= FLAG_ALARM;
+    if (smartShunt.getRelayState()) flags |= FLAG_RELAY;
+    regs[REG_FLAGS] = flags;
+
+    float voltage = smartShunt.getBatteryVoltage();
+    float current = smartShunt.getBatteryCurrent();
+    int ttg = smartShunt.getTimeRemaining();
+    regs[REG_BATTERY_VOLTAGE] = toUnsigned(voltage, 100);
+    regs[REG_BATTERY_CURRENT] = toSigned(current, 10);
+    regs[REG_BATTERY_POWER] = toSigned(smartShunt.getPower(), 1);  // SmartShunt P field, as in /api/battery
+    regs[REG_BATTERY_SOC] = toUnsigned(smartShunt.getStateOfCharge(), 10);
+    regs[REG_BATTERY_TTG] = ttg < 0 ? 0xFFFF : (uint16_t)min(ttg, 0xFFFE);
+    regs[REG_BATTERY_CONSUMED] = toUnsigned(smartShunt.getConsumedAh(), 10);
+
+    fillMpptRegisters(regs, REG_MPPT1_BASE, mppt1);
+    fillMpptRegisters(regs, REG_MPPT2_BASE, mppt2);
+
+    publish(regs);
 }
 
 // ============================================================================
@@ -830,6 +1979,11 @@ void printStatus() {
             smartShunt.getBatteryCurrent(),
             smartShunt.getStateOfCharge(),
             smartShunt.getTimeRemaining());
+        Serial.printf("         SoH %.1f%% (%.1f Ah, %u samples) | Forecast TTG: %d min\n",
+            batteryAnalytics.getStateOfHealth(),
+            batteryAnalytics.getCapacityAh(),
+            batteryAnalytics.getCapacitySamples(),
+            batteryAnalytics.getTimeToGo());
     } else {
         Serial.println("Battery: No data from SmartShunt");
     }
@@ -882,6 +2036,23 @@ void printStatus() {
         (millis() - bootTime) / 1000,
         WiFi.RSSI(),
         ESP.getFreeHeap());
+    Serial.printf("Modbus:  %u clients | %lu requests | %lu exceptions\n",
+        ModbusServer::getActiveClients(),
+        (unsigned long)ModbusServer::getRequests(),
+        (unsigned long)ModbusServer::getExceptions());
+    Serial.printf("Power:   %s | ~%.1f mA (240 MHz: %.1f mA) | frame errors %lu/%lu/%lu\n",
+        PowerManager::getModeName(),
+        PowerManager::getCurrentMa(),
+        PowerManager::getBaselineCurrentMa(),
+        (unsigned long)smartShunt.getChecksumErrors(),
+        (unsigned long)mppt1.getChecksumErrors(),
+        (unsigned long)mppt2.getChecksumErrors());
+    if (VeDirectRecorder::isActive()) {
+        Serial.printf("VeLog:   %lu bytes | %u sectors | %lu ms in flash\n",
+            (unsigned long)VeDirectRecorder::getBytesRecorded(),
+            VeDirectRecorder::getSectorCount(),
+            (unsigned long)VeDirectRecorder::getFlashTimeMs());
+    }
 
     Serial.println("---------------------");
 }
@@ -896,6 +2067,8 @@ void sendDataToInfluxDB() {
         return;
     }
 
+    LOOP_PROFILE_REGION("influxdb_post");
+    PowerManager::Busy busy(PowerManager::LOCK_UPLOAD);
     HTTPClient http;
     http.setTimeout(5000);  // 5 second timeout
 
@@ -926,7 +2099,20 @@ void sendDataToInfluxDB() {
         data += "max_voltage=" + String(smartShunt.getMaxVoltage(), 3) + ",";
         data += "charge_cycles=" + String(smartShunt.getChargeCycles()) + ",";
         data += "deepest_discharge=" + String(smartShunt.getDeepestDischarge(), 3) + ",";
-        data += "last_discharge=" + String(smartShunt.getLastDischarge(), 3);
+        data += "last_discharge=" + String(smartShunt.getLastDischarge(), 3) + ",";
+        data += "average_discharge=" + String(smartShunt.getAverageDischarge(), 3) + ",";
+        data += "full_discharges=" + String(smartShunt.getFullDischarges()) + ",";
+        data += "cumulative_ah=" + String(smartShunt.getCumulativeAh(), 3) + ",";
+        data += "seconds_since_full=" + String(smartShunt.getSecondsSinceFullCharge()) + ",";
+        data += "syncs=" + String(smartShunt.getSyncCount()) + ",";
+        data += "low_voltage_alarms=" + String(smartShunt.getLowVoltageAlarms()) + ",";
+        data += "high_voltage_alarms=" + String(smartShunt.getHighVoltageAlarms()) + ",";
+        data += "discharged_energy=" + String(smartShunt.getDischargedEnergy(), 2) + ",";
+        data += "charged_energy=" + String(smartShunt.getChargedEnergy(), 2) + ",";
+        data += "capacity_ah=" + String(batteryAnalytics.getCapacityAh(), 2) + ",";
+        data += "soh=" + String(batteryAnalytics.getStateOfHealth(), 1) + ",";
+        data += "ttg_forecast=" + String(batteryAnalytics.getTimeToGo()) + ",";
+        data += "load_current=" + String(batteryAnalytics.getLoadCurrent(), 3);
         data += "\n";
     }
 
@@ -996,6 +2182,23 @@ void sendDataToInfluxDB() {
         data += "\n";
     }
 
+    // MPPT comparison (once the baseline has been learned)
+    if (mpptComparator.isBaselineReady()) {
+        String deviceTag = String(deviceName);
+        deviceTag.replace(" ", "_");
+
+        data += "solar_compare,device=" + deviceTag + ",location=garage ";
+        data += "power_share=" + String(mpptComparator.getPowerShare(), 4) + ",";
+        data += "power_share_baseline=" + String(mpptComparator.getPowerShareBaseline(), 4) + ",";
+        data += "power_share_z=" + String(mpptComparator.getPowerShareZ(), 2) + ",";
+        data += "voltage_ratio=" + String(mpptComparator.getVoltageRatio(), 4) + ",";
+        data += "voltage_ratio_baseline=" + String(mpptComparator.getVoltageRatioBaseline(), 4) + ",";
+        data += "voltage_ratio_z=" + String(mpptComparator.getVoltageRatioZ(), 2) + ",";
+        data += "power_deviating=" + String(mpptComparator.isPowerDeviating() ? 1 : 0) + ",";
+        data += "voltage_deviating=" + String(mpptComparator.isVoltageDeviating() ? 1 : 0);
+        data += "\n";
+    }
+
     // System data
     String deviceTag = String(deviceName);
     deviceTag.replace(" ", "_");
@@ -1004,7 +2207,13 @@ void sendDataToInfluxDB() {
     data += "uptime=" + String((millis() - bootTime) / 1000) + ",";
     data += "wifi_rssi=" + String(WiFi.RSSI()) + ",";
     data += "free_heap=" + String(ESP.getFreeHeap()) + ",";
-    data += "wifi_connected=" + String(WiFi.status() == WL_CONNECTED ? 1 : 0);
+    data += "wifi_connected=" + String(WiFi.status() == WL_CONNECTED ? 1 : 0) + ",";
+    data += "loop_max_ms=" + String(LoopProfiler::getMaxIterationMs()) + ",";
+    data += "loop_stalls=" + String(LoopProfiler::getStallCount()) + ",";
+    data += "power_mode=\"" + String(PowerManager::getModeName()) + "\",";
+    data += "current_ma=" + String(PowerManager::sampleCurrentMa(), 1) + ",";
+    data += "baseline_ma=" + String(PowerManager::getBaselineCurrentMa(), 1) + ",";
+    data += "frame_errors=" + String(smartShunt.getChecksumErrors() + mppt1.getChecksumErrors() + mppt2.getChecksumErrors());
     data += "\n";
 
     // Send the data
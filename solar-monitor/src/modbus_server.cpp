@@ -0,0 +1,311 @@
+/**
+ * modbus_server.cpp
+ *
+ * Implementation of the Modbus-TCP snapshot server
+ */
+
+#include "modbus_server.h"
+
+#include <atomic>
+#include <math.h>
+#include <string.h>
+
+#ifdef NATIVE_HOST
+  #include <thread>
+  #include <fcntl.h>
+  #include <netinet/in.h>
+  #include <netinet/tcp.h>
+  #include <sys/select.h>
+  #include <sys/socket.h>
+  #include <unistd.h>
+#else
+  #include <lwip/sockets.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace ModbusServer {
+    // MBAP header (7 bytes) + largest PDU (253 bytes)
+    static const size_t MAX_FRAME = 260;
+    static const uint16_t MAX_READ_COUNT = 125;
+
+    // Exception codes
+    static const uint8_t EX_ILLEGAL_FUNCTION = 0x01;
+    static const uint8_t EX_ILLEGAL_ADDRESS = 0x02;
+    static const uint8_t EX_ILLEGAL_VALUE = 0x03;
+
+    // Snapshot, guarded by a sequence lock: odd while the main loop is writing.
+    // Readers copy and retry if the sequence moved, so the writer never waits.
+    static std::atomic<uint32_t> s_sequence(0);
+    static std::atomic<uint16_t> s_registers[REGISTER_COUNT];
+    static std::atomic<uint32_t> s_publishedAt(0);
+
+    static std::atomic<uint32_t> s_requests(0);
+    static std::atomic<uint32_t> s_exceptions(0);
+    static std::atomic<uint32_t> s_connections(0);
+    static std::atomic<uint32_t> s_rejected(0);
+    static std::atomic<uint8_t> s_activeClients(0);
+
+    struct Connection {
+        int fd;
+        uint8_t rx[MAX_FRAME];
+        size_t rxLength;
+        uint32_t lastActivity;
+    };
+
+    // Owned by the server task
+    static int s_listenFd = -1;
+    static Connection s_clients[MODBUS_MAX_CLIENTS];
+
+    void publish(const uint16_t* regs) {
+        uint32_t seq = s_sequence.load(std::memory_order_relaxed);
+        s_sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (uint16_t i = REG_FLAGS; i < REGISTER_COUNT; i++) {
+            s_registers[i].store(regs[i], std::memory_order_relaxed);
+        }
+        s_registers[REG_MAP_VERSION].store(MAP_VERSION, std::memory_order_relaxed);
+        s_registers[REG_SEQUENCE].store((uint16_t)((seq + 2) / 2), std::memory_order_relaxed);
+        s_publishedAt.store(millis(), std::memory_order_relaxed);
+
+        s_sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    // Copy the last complete image into out; returns false before the first publish
+    static bool readSnapshot(uint16_t* out) {
+        uint32_t before;
+        uint32_t after;
+        uint32_t publishedAt;
+        do {
+            before = s_sequence.load(std::memory_order_acquire);
+            for (uint16_t i = 0; i < REGISTER_COUNT; i++) {
+                out[i] = s_registers[i].load(std::memory_order_relaxed);
+            }
+            publishedAt = s_publishedAt.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = s_sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+
+        if (before == 0) {
+            out[REG_MAP_VERSION] = MAP_VERSION;
+            out[REG_AGE] = 0xFFFF;
+            return false;
+        }
+        uint32_t age = (millis() - publishedAt) / 100;
+        out[REG_AGE] = age > 0xFFFE ? 0xFFFE : (uint16_t)age;
+        return true;
+    }
+
+    uint16_t toUnsigned(float value, float scale) {
+        long scaled = lroundf(value * scale);
+        return (uint16_t)constrain(scaled, 0L, 65535L);
+    }
+
+    uint16_t toSigned(float value, float scale) {
+        long scaled = lroundf(value * scale);
+        return (uint16_t)(int16_t)constrain(scaled, -32768L, 32767L);
+    }
+
+    static void closeClient(Connection& client) {
+        close(client.fd);
+        client.fd = -1;
+        s_activeClients--;
+    }
+
+    static bool sendFrame(Connection& client, const uint8_t* frame, size_t length) {
+        // Non-blocking: a client that stops reading loses its connection
+        // instead of stalling everyone else
+        return send(client.fd, frame, length, MSG_DONTWAIT | MSG_NOSIGNAL) == (ssize_t)length;
+    }
+
+    // Answer one complete request frame (MBAP header + PDU)
+    static bool handleFrame(Connection& client, const uint8_t* request, size_t length) {
+        uint8_t response[MAX_FRAME];
+        memcpy(response, request, 4);  // Transaction and protocol id
+        response[6] = request[6];      // Unit id echoed
+
+        uint8_t function = request[7];
+        uint8_t exception = 0;
+        size_t pduLength;
+
+        uint16_t start = (request[8] << 8) | request[9];
+        uint16_t count = (request[10] << 8) | request[11];
+        if (function != 0x03 && function != 0x04) {
+            exception = EX_ILLEGAL_FUNCTION;
+        } else if (length != 12 || count == 0 || count > MAX_READ_COUNT) {
+            exception = EX_ILLEGAL_VALUE;
+        } else if ((uint32_t)start + count > REGISTER_COUNT) {
+            exception = EX_ILLEGAL_ADDRESS;
+        }
+
+        if (exception) {
+            response[7] = function | 0x80;
+            response[8] = exception;
+            pduLength = 2;
+            s_exceptions++;
+        } else {
+            uint16_t image[REGISTER_COUNT];
+            readSnapshot(image);
+            response[7] = function;
+            response[8] = count * 2;
+            for (uint16_t i = 0; i < count; i++) {
+                response[9 + i * 2] = image[start + i] >> 8;
+                response[10 + i * 2] = image[start + i] & 0xFF;
+            }
+            pduLength = 2 + count * 2;
+        }
+
+        uint16_t mbapLength = pduLength + 1;  // Unit id + PDU
+        response[4] = mbapLength >> 8;
+        response[5] = mbapLength & 0xFF;
+        s_requests++;
+        return sendFrame(client, response, 7 + pduLength);
+    }
+
+    // Drain the socket and answer every complete frame (clients may pipeline)
+    static void readClient(Connection& client, uint32_t now) {
+        ssize_t received = recv(client.fd, client.rx + client.rxLength, sizeof(client.rx) - client.rxLength, 0);
+        if (received <= 0) {
+            closeClient(client);
+            return;
+        }
+        client.rxLength += received;
+        client.lastActivity = now;
+
+        while (client.rxLength >= 8) {
+            uint16_t protocol = (client.rx[2] << 8) | client.rx[3];
+            uint16_t mbapLength = (client.rx[4] << 8) | client.rx[5];
+            if (protocol != 0 || mbapLength < 2 || mbapLength > MAX_FRAME - 6) {
+                closeClient(client);  // Not Modbus-TCP, resync is impossible
+                return;
+            }
+            size_t frameLength = 6 + mbapLength;
+            if (client.rxLength < frameLength) {
+                break;
+            }
+            if (!handleFrame(client, client.rx, frameLength)) {
+                closeClient(client);
+                return;
+            }
+            client.rxLength -= frameLength;
+            memmove(client.rx, client.rx + frameLength, client.rxLength);
+        }
+    }
+
+    static void acceptClient(uint32_t now) {
+        int fd = accept(s_listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            return;
+        }
+        for (Connection& client : s_clients) {
+            if (client.fd < 0) {
+                int noDelay = 1;
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+                client.fd = fd;
+                client.rxLength = 0;
+                client.lastActivity = now;
+                s_connections++;
+                s_activeClients++;
+                return;
+            }
+        }
+        close(fd);
+        s_rejected++;
+    }
+
+    static void serve() {
+        for (;;) {
+            fd_set readSet;
+            FD_ZERO(&readSet);
+            FD_SET(s_listenFd, &readSet);
+            int maxFd = s_listenFd;
+            for (const Connection& client : s_clients) {
+                if (client.fd >= 0) {
+                    FD_SET(client.fd, &readSet);
+                    maxFd = max(maxFd, client.fd);
+                }
+            }
+
+            // Timeout only bounds how late idle connections are reaped
+            struct timeval timeout = {1, 0};
+            int ready = select(maxFd + 1, &readSet, nullptr, nullptr, &timeout);
+            if (ready < 0) {
+                delay(100);
+                continue;
+            }
+
+            uint32_t now = millis();
+            if (FD_ISSET(s_listenFd, &readSet)) {
+                acceptClient(now);
+            }
+            for (Connection& client : s_clients) {
+                if (client.fd < 0) {
+                    continue;
+                }
+                if (FD_ISSET(client.fd, &readSet)) {
+                    readClient(client, now);
+                } else if (now - client.lastActivity > MODBUS_IDLE_TIMEOUT_MS) {
+                    closeClient(client);
+                }
+            }
+        }
+    }
+
+#ifndef NATIVE_HOST
+    static void serverTask(void*) {
+        serve();
+    }
+#endif
+
+    bool begin(uint16_t port) {
+        for (Connection& client : s_clients) {
+            client.fd = -1;
+        }
+
+        s_listenFd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (s_listenFd < 0) {
+            Serial.println("[Modbus] Failed to create socket");
+            return false;
+        }
+        int reuse = 1;
+        setsockopt(s_listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(port);
+        if (bind(s_listenFd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(s_listenFd, MODBUS_MAX_CLIENTS) < 0) {
+            Serial.printf("[Modbus] Failed to listen on port %u\n", port);
+            close(s_listenFd);
+            s_listenFd = -1;
+            return false;
+        }
+
+#ifdef NATIVE_HOST
+        std::thread(serve).detach();
+#else
+        // Core 0 with the network stack; loop() runs on core 1
+        if (xTaskCreatePinnedToCore(serverTask, "modbus", 4096, nullptr, 1, nullptr, 0) != pdPASS) {
+            Serial.println("[Modbus] Failed to start server task");
+            close(s_listenFd);
+            s_listenFd = -1;
+            return false;
+        }
+#endif
+
+        Serial.printf("[Modbus] Modbus-TCP server on port %u (%d clients max, map v%u)\n",
+                      port, MODBUS_MAX_CLIENTS, MAP_VERSION);
+        return true;
+    }
+
+    uint32_t getRequests() { return s_requests; }
+    uint32_t getExceptions() { return s_exceptions; }
+    uint32_t getConnections() { return s_connections; }
+    uint32_t getRejected() { return s_rejected; }
+    uint8_t getActiveClients() { return s_activeClients; }
+    uint32_t getSnapshots() { return s_sequence.load(std::memory_order_relaxed) / 2; }
+}
@@ -0,0 +1,103 @@
+/**
+ * modbus_server.h
+ *
+ * Modbus-TCP server exposing the latest VE.Direct snapshot as registers
+ *
+ * The main loop publishes a fixed-point register image whenever a new
+ * VE.Direct block has been committed; a separate task (core 0 on the ESP32,
+ * a thread on the host) serves up to MODBUS_MAX_CLIENTS connections from the
+ * last complete image. The image is guarded by a sequence lock, so neither
+ * side ever waits for the other and clients never see a half-written update.
+ *
+ * Function codes 0x04 (read input registers) and 0x03 (read holding
+ * registers) both read the same map. Unit id is ignored. The register map
+ * is documented in solar-monitor/README.md; addresses are 0-based PDU
+ * addresses (register 30001 in 1-based tools is address 0).
+ */
+
+#ifndef MODBUS_SERVER_H
+#define MODBUS_SERVER_H
+
+#include <Arduino.h>
+
+#ifndef MODBUS_MAX_CLIENTS
+#define MODBUS_MAX_CLIENTS 4
+#endif
+
+#ifndef MODBUS_IDLE_TIMEOUT_MS
+#define MODBUS_IDLE_TIMEOUT_MS 60000  // Close connections silent for this long
+#endif
+
+namespace ModbusServer {
+    // Register map version, bumped whenever an address changes meaning
+    static const uint16_t MAP_VERSION = 1;
+
+    // Register addresses. Signed values are two's complement int16.
+    enum Register : uint16_t {
+        // Header (0-2 filled by the server)
+        REG_MAP_VERSION = 0,
+        REG_SEQUENCE = 1,           // Snapshot counter, wraps at 65535
+        REG_AGE = 2,                // Time since the snapshot was published, 0.1 s (saturates)
+        REG_FLAGS = 3,              // Bit 0 shunt valid, 1 MPPT1 valid, 2 MPPT2 valid, 3 alarm, 4 relay
+
+        // Battery (SmartShunt)
+        REG_BATTERY_VOLTAGE = 10,   // 0.01 V
+        REG_BATTERY_CURRENT = 11,   // 0.1 A, int16, negative = discharge
+        REG_BATTERY_POWER = 12,     // W, int16
+        REG_BATTERY_SOC = 13,       // 0.1 %
+        REG_BATTERY_TTG = 14,       // Minutes, 0xFFFF = infinite
+        REG_BATTERY_CONSUMED = 15,  // 0.1 Ah
+
+        // MPPT blocks: REG_MPPT1_BASE / REG_MPPT2_BASE + MPPT_* offset
+        REG_MPPT1_BASE = 20,
+        REG_MPPT2_BASE = 30,
+
+        REGISTER_COUNT = 40
+    };
+
+    enum MpptOffset : uint16_t {
+        MPPT_BATTERY_VOLTAGE = 0,   // 0.01 V
+        MPPT_CHARGE_CURRENT = 1,    // 0.1 A
+        MPPT_PANEL_VOLTAGE = 2,     // 0.01 V
+        MPPT_PANEL_POWER = 3,       // W
+        MPPT_CHARGE_STATE = 4,      // VE.Direct CS code
+        MPPT_ERROR_CODE = 5,        // VE.Direct ERR code
+        MPPT_YIELD_TODAY = 6,       // 0.01 kWh
+        MPPT_MAX_POWER_TODAY = 7    // W
+    };
+
+    enum Flag : uint16_t {
+        FLAG_SHUNT_VALID = 1 << 0,
+        FLAG_MPPT1_VALID = 1 << 1,
+        FLAG_MPPT2_VALID = 1 << 2,
+        FLAG_ALARM = 1 << 3,
+        FLAG_RELAY = 1 << 4
+    };
+
+    /**
+     * @brief Open the listening socket and start the server task.
+     * Call once from setup() after WiFi is up.
+     * @return false if the socket or task could not be created
+     */
+    bool begin(uint16_t port);
+
+    /**
+     * @brief Publish a new register image (main loop only, never blocks).
+     * Registers before REG_FLAGS are ignored; the server fills them.
+     * @param regs REGISTER_COUNT values indexed by Register
+     */
+    void publish(const uint16_t* regs);
+
+    // Scaling helpers for building the image
+    uint16_t toUnsigned(float value, float scale);
+    uint16_t toSigned(float value, float scale);
+
+    uint32_t getRequests();         // Requests answered (including exceptions)
+    uint32_t getExceptions();       // Exception responses sent
+    uint32_t getConnections();      // Connections accepted since boot
+    uint32_t getRejected();         // Connections refused because all slots were busy
+    uint8_t getActiveClients();
+    uint32_t getSnapshots();        // Images published since boot
+}
+
+#endif // MODBUS_SERVER_H
@@ -0,0 +1,329 @@
+/**
+ * power_manager.cpp
+ *
+ * Implementation of frequency scaling, light sleep and VE.Direct burst
+ * windows
+ */
+
+#include "power_manager.h"
+
+#ifndef NATIVE_HOST
+  #include <esp_idf_version.h>
+  #include <esp_pm.h>
+  #include <esp_sleep.h>
+  #include <driver/gpio.h>
+#endif
+
+namespace PowerManager {
+    static const uint16_t BYTE_TIME_US = 521;   // 19200 baud 8N1
+
+    enum State : uint8_t {
+        STATE_FULL,
+        STATE_LOW,
+        STATE_IDLE,
+        STATE_COUNT
+    };
+
+    static Mode s_mode = MODE_OFF;
+    static bool s_manualDfs = false;            // No esp_pm: clock switched from loop()
+
+    static uint8_t s_held[LOCK_COUNT];
+    static uint32_t s_lockCount[LOCK_COUNT];
+    static bool s_windowOpen = false;
+
+    // Burst phase per port: last time bytes were seen in each bin of the period
+    static uint32_t s_binHitMs[MAX_PORTS][BINS];
+    static uint64_t s_binSeen[MAX_PORTS];
+    static uint32_t s_lastByteMs[MAX_PORTS];
+    static bool s_portSeen[MAX_PORTS];
+    static uint32_t s_unexpectedBursts = 0;
+
+    // Time in state, accounted at the start and end of each idle() wait
+    static uint64_t s_stateUs[STATE_COUNT];
+    static uint64_t s_sampleUs[STATE_COUNT];
+    static uint32_t s_markUs = 0;
+    static bool s_fullIteration = true;
+
+#ifndef NATIVE_HOST
+    static bool s_lowClock = false;             // Manual DFS currently at 80 MHz
+    static esp_pm_lock_handle_t s_cpuLocks[LOCK_COUNT];
+    static esp_pm_lock_handle_t s_sleepLocks[LOCK_COUNT];
+    static const char* const LOCK_NAMES[LOCK_COUNT] = {"uart", "http", "upload"};
+
+    static esp_err_t configure(bool lightSleep) {
+    #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+        esp_pm_config_t config;
+    #else
+        esp_pm_config_esp32_t config;
+    #endif
+        config.max_freq_mhz = 240;
+        config.min_freq_mhz = 80;
+        config.light_sleep_enable = lightSleep;
+        return esp_pm_configure(&config);
+    }
+#endif
+
+    static bool anyHeld() {
+        for (uint8_t i = 0; i < LOCK_COUNT; i++) {
+            if (s_held[i] > 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static void account(State state) {
+        uint32_t now = micros();
+        s_stateUs[state] += now - s_markUs;
+        s_markUs = now;
+    }
+
+    static bool binHot(uint8_t port, uint8_t bin, uint32_t nowMs) {
+        return (s_binSeen[port] & (1ULL << bin)) && nowMs - s_binHitMs[port][bin] < HOT_MS;
+    }
+
+    static uint8_t binAt(uint32_t ms) {
+        return (ms % PERIOD_MS) / BIN_MS;
+    }
+
+    Mode begin(Mode requested, const uint8_t* wakePins, uint8_t wakePinCount) {
+        s_mode = MODE_OFF;
+        s_manualDfs = false;
+        s_markUs = micros();
+
+        if (requested == MODE_OFF) {
+            Serial.println("[Power] Power management off (240 MHz)");
+            return s_mode;
+        }
+
+#ifdef NATIVE_HOST
+        (void)wakePins;
+        (void)wakePinCount;
+        s_mode = requested;
+#else
+        esp_err_t err = ESP_ERR_NOT_SUPPORTED;
+        if (requested == MODE_LIGHT_SLEEP) {
+            err = configure(true);
+            if (err == ESP_OK) {
+                s_mode = MODE_LIGHT_SLEEP;
+            } else {
+                Serial.printf("[Power] Light sleep not available (%d), DFS only\n", err);
+            }
+        }
+        if (s_mode == MODE_OFF) {
+            err = configure(false);
+            s_mode = MODE_DFS;
+            s_manualDfs = (err != ESP_OK);
+        }
+
+        if (!s_manualDfs) {
+            for (uint8_t i = 0; i < LOCK_COUNT; i++) {
+                esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, LOCK_NAMES[i], &s_cpuLocks[i]);
+                esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, LOCK_NAMES[i], &s_sleepLocks[i]);
+            }
+        }
+
+        if (s_mode == MODE_LIGHT_SLEEP) {
+            // UART lines idle high; a start bit wakes the chip
+            for (uint8_t i = 0; i < wakePinCount; i++) {
+                gpio_wakeup_enable((gpio_num_t)wakePins[i], GPIO_INTR_LOW_LEVEL);
+            }
+            esp_sleep_enable_gpio_wakeup();
+        }
+#endif
+
+        Serial.printf("[Power] Mode %s (80-240 MHz)\n", getModeName());
+        return s_mode;
+    }
+
+    Mode getMode() {
+        return s_mode;
+    }
+
+    const char* getModeName() {
+        switch (s_mode) {
+            case MODE_DFS: return s_manualDfs ? "dfs_manual" : "dfs";
+            case MODE_LIGHT_SLEEP: return "light_sleep";
+            default: return "off";
+        }
+    }
+
+    void acquire(Lock lock) {
+        s_lockCount[lock]++;
+        s_fullIteration = true;
+        if (s_held[lock]++ > 0 || s_mode == MODE_OFF) {
+            return;
+        }
+#ifndef NATIVE_HOST
+        if (s_manualDfs) {
+            // Switching the clock is slow; web polling stays at 80 MHz
+            if (lock != LOCK_HTTP && s_lowClock) {
+                setCpuFrequencyMhz(240);
+                s_lowClock = false;
+            }
+            return;
+        }
+        esp_pm_lock_acquire(s_cpuLocks[lock]);
+        esp_pm_lock_acquire(s_sleepLocks[lock]);
+#endif
+    }
+
+    void release(Lock lock) {
+        if (s_held[lock] == 0 || --s_held[lock] > 0 || s_mode == MODE_OFF) {
+            return;
+        }
+#ifndef NATIVE_HOST
+        if (!s_manualDfs) {
+            esp_pm_lock_release(s_sleepLocks[lock]);
+            esp_pm_lock_release(s_cpuLocks[lock]);
+        }
+#endif
+    }
+
+    Busy::Busy(Lock lock) : _lock(lock) {
+        acquire(lock);
+    }
+
+    Busy::~Busy() {
+        release(_lock);
+    }
+
+    void noteRx(uint8_t port, int available, uint32_t nowMs) {
+        if (port >= MAX_PORTS || available <= 0) {
+            return;
+        }
+        bool inBurst = s_portSeen[port] && nowMs - s_lastByteMs[port] < QUIET_MS;
+        if (!inBurst && !s_windowOpen) {
+            s_unexpectedBursts++;
+        }
+
+        // The buffered bytes date the start of the burst, even after a wakeup
+        uint32_t startMs = nowMs - (uint32_t)available * BYTE_TIME_US / 1000;
+        if (inBurst && (int32_t)(startMs - s_lastByteMs[port]) < 0) {
+            startMs = s_lastByteMs[port];
+        }
+        for (uint32_t ms = startMs; ; ms += BIN_MS) {
+            if ((int32_t)(ms - nowMs) > 0) {
+                ms = nowMs;
+            }
+            uint8_t bin = binAt(ms);
+            s_binHitMs[port][bin] = nowMs;
+            s_binSeen[port] |= 1ULL << bin;
+            if (ms == nowMs) {
+                break;
+            }
+        }
+        s_lastByteMs[port] = nowMs;
+        s_portSeen[port] = true;
+    }
+
+    bool isBurstExpected(uint32_t nowMs) {
+        for (uint8_t port = 0; port < MAX_PORTS; port++) {
+            if (!s_portSeen[port]) {
+                continue;
+            }
+            if (nowMs - s_lastByteMs[port] < QUIET_MS) {
+                return true;
+            }
+            for (uint32_t ms = nowMs; ; ms += BIN_MS) {
+                if (ms > nowMs + GUARD_MS) {
+                    ms = nowMs + GUARD_MS;
+                }
+                if (binHot(port, binAt(ms), nowMs)) {
+                    return true;
+                }
+                if (ms == nowMs + GUARD_MS) {
+                    break;
+                }
+            }
+        }
+        return false;
+    }
+
+    void update(uint32_t nowMs) {
+        bool open = isBurstExpected(nowMs);
+        if (open != s_windowOpen) {
+            s_windowOpen = open;
+            if (open) {
+                acquire(LOCK_UART);
+            } else {
+                release(LOCK_UART);
+            }
+        }
+    }
+
+    uint32_t getIdleMs(uint32_t nowMs) {
+        if (s_mode == MODE_OFF || s_windowOpen || anyHeld()) {
+            return 1;
+        }
+        uint32_t wait = IDLE_MAX_MS;
+        uint32_t phase = nowMs % PERIOD_MS;
+        for (uint8_t port = 0; port < MAX_PORTS; port++) {
+            for (uint8_t bin = 0; bin < BINS; bin++) {
+                if (!binHot(port, bin, nowMs)) {
+                    continue;
+                }
+                uint32_t until = ((uint32_t)bin * BIN_MS + PERIOD_MS - phase) % PERIOD_MS;
+                wait = min(wait, until > GUARD_MS ? until - GUARD_MS : 1);
+            }
+        }
+        return max(wait, (uint32_t)1);
+    }
+
+    void idle() {
+        account(s_fullIteration || s_mode == MODE_OFF ? STATE_FULL : STATE_LOW);
+
+        uint32_t waitMs = getIdleMs(millis());
+        bool locked = s_mode == MODE_OFF || anyHeld();
+#ifndef NATIVE_HOST
+        if (s_manualDfs && !locked && !s_lowClock && waitMs >= BIN_MS) {
+            setCpuFrequencyMhz(80);
+            s_lowClock = true;
+        }
+#endif
+        delay(waitMs);
+
+        account(locked ? STATE_FULL : STATE_IDLE);
+        s_fullIteration = anyHeld();
+    }
+
+    void getStats(Stats& stats) {
+        stats.fullMs = s_stateUs[STATE_FULL] / 1000;
+        stats.lowMs = s_stateUs[STATE_LOW] / 1000;
+        stats.idleMs = s_stateUs[STATE_IDLE] / 1000;
+        for (uint8_t i = 0; i < LOCK_COUNT; i++) {
+            stats.lockCount[i] = s_lockCount[i];
+        }
+        stats.unexpectedBursts = s_unexpectedBursts;
+    }
+
+    float estimateCurrentMa(Mode mode, uint32_t fullMs, uint32_t lowMs, uint32_t idleMs) {
+        uint32_t total = fullMs + lowMs + idleMs;
+        if (total == 0) {
+            return mode == MODE_OFF ? CURRENT_240_MA : CURRENT_80_MA;
+        }
+        if (mode == MODE_OFF) {
+            return CURRENT_240_MA;
+        }
+        float idleMa = mode == MODE_LIGHT_SLEEP ? CURRENT_LIGHT_SLEEP_MA : CURRENT_80_MA;
+        return (fullMs * CURRENT_240_MA + lowMs * CURRENT_80_MA + idleMs * idleMa) / total;
+    }
+
+    float getCurrentMa() {
+        return estimateCurrentMa(s_mode, s_stateUs[STATE_FULL] / 1000, s_stateUs[STATE_LOW] / 1000,
+                                 s_stateUs[STATE_IDLE] / 1000);
+    }
+
+    float getBaselineCurrentMa() {
+        return estimateCurrentMa(MODE_OFF, 0, 0, 0);
+    }
+
+    float sampleCurrentMa() {
+        uint32_t ms[STATE_COUNT];
+        for (uint8_t i = 0; i < STATE_COUNT; i++) {
+            ms[i] = (s_stateUs[i] - s_sampleUs[i]) / 1000;
+            s_sampleUs[i] = s_stateUs[i];
+        }
+        return estimateCurrentMa(s_mode, ms[STATE_FULL], ms[STATE_LOW], ms[STATE_IDLE]);
+    }
+}
@@ -0,0 +1,139 @@
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <Arduino.h>
+
+/**
+ * @brief CPU frequency scaling and light sleep between VE.Direct bursts.
+ *
+ * The monitor is powered from the battery it measures and is idle most of
+ * the time: each VE.Direct port sends one burst of text per second (~100 ms
+ * at 19200 baud). With power management on, the CPU runs at 80 MHz (APB
+ * stays at 80 MHz, so UART baud rates are unaffected) and, in
+ * MODE_LIGHT_SLEEP, the chip light-sleeps while loop() waits in idle().
+ * Work that must run at full speed and awake holds a lock:
+ *
+ * - LOCK_UART: VE.Direct bursts. The UARTs stop in light sleep, and
+ *   SoftwareSerial times bits with the CPU cycle counter, so a burst must
+ *   neither be slept through nor clocked down. Burst times are learned per
+ *   port as a phase within the 1 s period (BIN_MS bins); the lock is taken
+ *   GUARD_MS before a bin where bytes were seen within HOT_MS and released
+ *   QUIET_MS after the last byte.
+ * - LOCK_HTTP, LOCK_UPLOAD: web requests and InfluxDB/webhook posts.
+ *
+ * The hardware UART RX pins are also GPIO wakeup sources (a start bit is a
+ * low level), so a burst outside its learned phase wakes the chip. Its
+ * first bytes are lost, which shows as one VE.Direct checksum error, and
+ * the phase is learned for the next second.
+ *
+ * If the framework lacks power management (esp_pm), DFS is done directly
+ * with setCpuFrequencyMhz() and there is no light sleep; if it lacks
+ * tickless idle, MODE_LIGHT_SLEEP falls back to MODE_DFS.
+ *
+ * Current draw is an estimate from the time spent at each clock and in
+ * idle (CURRENT_*_MA, ESP32 typicals with WiFi associated in modem sleep).
+ * The baseline is the same time at 240 MHz, i.e. MODE_OFF.
+ */
+
+namespace PowerManager {
+    enum Mode : uint8_t {
+        MODE_OFF = 0,           // 240 MHz always (baseline)
+        MODE_DFS = 1,           // 80-240 MHz
+        MODE_LIGHT_SLEEP = 2    // 80-240 MHz + automatic light sleep
+    };
+
+    enum Lock : uint8_t {
+        LOCK_UART,
+        LOCK_HTTP,
+        LOCK_UPLOAD,
+        LOCK_COUNT
+    };
+
+    static const uint8_t MAX_PORTS = 3;
+    static const uint16_t PERIOD_MS = 1000;     // VE.Direct text blocks are sent once per second
+    static const uint8_t BIN_MS = 25;
+    static const uint8_t BINS = PERIOD_MS / BIN_MS;
+    static const uint16_t GUARD_MS = 40;        // Lock taken this long before an expected burst
+    static const uint16_t QUIET_MS = 20;        // Burst over after this long without bytes
+    static const uint16_t HOT_MS = 5000;        // Bytes in a bin make it expected for this long
+    static const uint16_t IDLE_MAX_MS = 50;     // Longest wait in idle(): shorter than a burst, so every burst is seen
+
+    static const float CURRENT_240_MA = 50.0f;
+    static const float CURRENT_80_MA = 30.0f;
+    static const float CURRENT_LIGHT_SLEEP_MA = 3.0f;
+
+    struct Stats {
+        uint32_t fullMs;                // Awake at 240 MHz (or any time in MODE_OFF)
+        uint32_t lowMs;                 // Awake at 80 MHz
+        uint32_t idleMs;                // Waiting in idle() without locks (asleep in MODE_LIGHT_SLEEP)
+        uint32_t lockCount[LOCK_COUNT]; // Acquisitions per lock
+        uint32_t unexpectedBursts;      // Bursts that started outside a learned window
+    };
+
+    /**
+     * @brief Configure power management. Call once from setup(), before WiFi.
+     * @param requested Mode to run in; the active mode may be lower (see getMode())
+     * @param wakePins Hardware UART RX pins that wake the chip from light sleep
+     *        (not SoftwareSerial pins: wakeup would replace their edge interrupt)
+     */
+    Mode begin(Mode requested, const uint8_t* wakePins, uint8_t wakePinCount);
+
+    Mode getMode();
+    const char* getModeName();          // "off", "dfs", "dfs_manual", "light_sleep"
+
+    void acquire(Lock lock);
+    void release(Lock lock);
+
+    /**
+     * @brief RAII lock for a block of work.
+     */
+    class Busy {
+    public:
+        explicit Busy(Lock lock);
+        ~Busy();
+    private:
+        Lock _lock;
+    };
+
+    /**
+     * @brief Report the bytes waiting on a VE.Direct port. Call for every
+     * port before its driver's update(), then call update().
+     */
+    void noteRx(uint8_t port, int available, uint32_t nowMs);
+
+    /**
+     * @brief Take or release LOCK_UART for the current and upcoming bursts.
+     */
+    void update(uint32_t nowMs);
+
+    bool isBurstExpected(uint32_t nowMs);
+
+    /**
+     * @brief How long loop() may wait before the next burst window opens
+     * (1 while a window is open, at most IDLE_MAX_MS).
+     */
+    uint32_t getIdleMs(uint32_t nowMs);
+
+    /**
+     * @brief End of loop(): wait until the next burst window (or IDLE_MAX_MS),
+     * replacing delay(1). Light sleep happens during this wait.
+     */
+    void idle();
+
+    void getStats(Stats& stats);
+
+    /**
+     * @brief Estimated average current for a split of time between states.
+     */
+    float estimateCurrentMa(Mode mode, uint32_t fullMs, uint32_t lowMs, uint32_t idleMs);
+
+    float getCurrentMa();               // Since boot
+    float getBaselineCurrentMa();       // Same period in MODE_OFF
+
+    /**
+     * @brief Average estimated current since the previous call (for periodic uploads).
+     */
+    float sampleCurrentMa();
+}
+
+#endif // POWER_MANAGER_H
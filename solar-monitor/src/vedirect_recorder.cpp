@@ -0,0 +1,270 @@
+/**
+ * vedirect_recorder.cpp
+ *
+ * Implementation of the VE.Direct black-box recorder
+ */
+
+#include "vedirect_recorder.h"
+#include <esp_partition.h>
+
+namespace VeDirectRecorder {
+    static const uint32_t SECTOR_MAGIC = 0x314C4456;  // "VDL1"
+
+    struct Chunk {
+        uint8_t data[MAX_CHUNK];
+        uint8_t length;
+        uint32_t startMs;
+    };
+
+    static const esp_partition_t* s_partition = nullptr;
+    static bool s_active = false;
+    static uint16_t s_sectorCount = 0;
+    static uint16_t s_validSectors = 0;     // Sectors holding data (ring fill level)
+
+    // Write head
+    static uint16_t s_headSector = 0;
+    static uint32_t s_sequence = 0;
+    static uint32_t s_bootId = 0;
+    static uint16_t s_sectorPos = 0;        // Next byte within the head sector
+    static uint16_t s_pageStart = 0;        // Sector offset of the page in s_page
+    static uint8_t s_page[PAGE_SIZE];
+
+    static Chunk s_chunks[PORT_COUNT];
+
+    static uint32_t s_bytesRecorded = 0;
+    static uint32_t s_pageWrites = 0;
+    static uint32_t s_sectorErases = 0;
+    static uint32_t s_writeFailures = 0;
+    static uint32_t s_flashTimeUs = 0;
+
+    static uint32_t sectorAddress(uint16_t sector) {
+        return (uint32_t)sector * SECTOR_SIZE;
+    }
+
+    // Program the staged page; the unused tail is 0xFF, which leaves flash erased
+    static void programPage() {
+        uint32_t start = micros();
+        if (esp_partition_write(s_partition, sectorAddress(s_headSector) + s_pageStart, s_page, PAGE_SIZE) != ESP_OK) {
+            s_writeFailures++;
+        }
+        s_flashTimeUs += micros() - start;
+        s_pageWrites++;
+        s_pageStart += PAGE_SIZE;
+        memset(s_page, 0xFF, sizeof(s_page));
+    }
+
+    static void openSector(uint16_t sector) {
+        uint32_t start = micros();
+        if (esp_partition_erase_range(s_partition, sectorAddress(sector), SECTOR_SIZE) != ESP_OK) {
+            s_writeFailures++;
+        }
+        s_flashTimeUs += micros() - start;
+        s_sectorErases++;
+
+        if (s_validSectors < s_sectorCount) {
+            s_validSectors++;
+        }
+        s_headSector = sector;
+        s_sequence++;
+
+        SectorHeader header = {SECTOR_MAGIC, s_sequence, s_bootId, 0};
+        memset(s_page, 0xFF, sizeof(s_page));
+        memcpy(s_page, &header, sizeof(header));
+        s_pageStart = 0;
+        s_sectorPos = sizeof(header);
+    }
+
+    static void append(const uint8_t* data, uint16_t length) {
+        while (length > 0) {
+            uint16_t pageOffset = s_sectorPos - s_pageStart;
+            uint16_t n = min<uint16_t>(length, PAGE_SIZE - pageOffset);
+            memcpy(s_page + pageOffset, data, n);
+            s_sectorPos += n;
+            data += n;
+            length -= n;
+            if (s_sectorPos - s_pageStart == PAGE_SIZE) {
+                programPage();
+            }
+        }
+    }
+
+    static void writeRecord(Port port, const Chunk& chunk) {
+        uint16_t size = sizeof(RecordHeader) + chunk.length;
+        if (s_sectorPos + size > SECTOR_SIZE) {
+            // Close the sector: flush the partial page, the rest stays erased
+            if (s_sectorPos > s_pageStart) {
+                programPage();
+            }
+            openSector((s_headSector + 1) % s_sectorCount);
+        }
+        RecordHeader header = {(uint8_t)port, chunk.length, chunk.startMs};
+        append((const uint8_t*)&header, sizeof(header));
+        append(chunk.data, chunk.length);
+        s_bytesRecorded += chunk.length;
+    }
+
+    static void emit(Port port) {
+        Chunk& chunk = s_chunks[port];
+        if (chunk.length > 0) {
+            writeRecord(port, chunk);
+            chunk.length = 0;
+        }
+    }
+
+    int TapStream::read() {
+        int c = _source->read();
+        if (c >= 0) {
+            record(_port, (uint8_t)c);
+        }
+        return c;
+    }
+
+    bool begin() {
+        s_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                               (esp_partition_subtype_t)VEDLOG_PARTITION_SUBTYPE,
+                                               VEDLOG_PARTITION_LABEL);
+        if (!s_partition || s_partition->size < 2 * SECTOR_SIZE) {
+            Serial.println("[VeLog] No \"" VEDLOG_PARTITION_LABEL "\" partition, recording disabled");
+            s_active = false;
+            return false;
+        }
+        s_sectorCount = s_partition->size / SECTOR_SIZE;
+
+        // Find the newest sector and the last boot id; the ring is contiguous
+        // from the oldest sector up to the newest
+        bool found = false;
+        uint16_t newest = 0;
+        uint32_t maxBootId = 0;
+        s_sequence = 0;
+        s_validSectors = 0;
+        for (uint16_t sector = 0; sector < s_sectorCount; sector++) {
+            SectorHeader header;
+            if (esp_partition_read(s_partition, sectorAddress(sector), &header, sizeof(header)) != ESP_OK
+                || header.magic != SECTOR_MAGIC) {
+                continue;
+            }
+            s_validSectors++;
+            if (!found || header.sequence > s_sequence) {
+                s_sequence = header.sequence;
+                newest = sector;
+                found = true;
+            }
+            maxBootId = max(maxBootId, header.bootId);
+        }
+
+        s_bootId = found ? maxBootId + 1 : 1;
+        for (Chunk& chunk : s_chunks) {
+            chunk.length = 0;
+        }
+        s_active = true;
+        openSector(found ? (newest + 1) % s_sectorCount : 0);
+
+        Serial.printf("[VeLog] Recording to %u KB ring (%u/%u sectors used), boot %lu\n",
+                      (unsigned)(s_partition->size / 1024), s_validSectors, s_sectorCount, (unsigned long)s_bootId);
+        return true;
+    }
+
+    void record(Port port, uint8_t c) {
+        if (!s_active) {
+            return;
+        }
+        Chunk& chunk = s_chunks[port];
+        if (chunk.length == 0) {
+            chunk.startMs = millis();
+        }
+        chunk.data[chunk.length++] = c;
+        if (chunk.length == MAX_CHUNK) {
+            emit(port);
+        }
+    }
+
+    void loop() {
+        if (!s_active) {
+            return;
+        }
+        uint32_t now = millis();
+        for (uint8_t port = 0; port < PORT_COUNT; port++) {
+            if (s_chunks[port].length > 0 && now - s_chunks[port].startMs >= CHUNK_FLUSH_MS) {
+                emit((Port)port);
+            }
+        }
+    }
+
+    bool isActive() {
+        return s_active;
+    }
+
+    uint16_t getSectorCount() {
+        return s_active ? s_validSectors : 0;
+    }
+
+    bool readSector(uint16_t index, uint16_t offset, uint8_t* buffer, uint16_t length) {
+        if (!s_active || index >= s_validSectors || offset + length > SECTOR_SIZE) {
+            return false;
+        }
+        uint16_t oldest = (s_headSector + 1 + s_sectorCount - s_validSectors) % s_sectorCount;
+        uint16_t sector = (oldest + index) % s_sectorCount;
+        if (esp_partition_read(s_partition, sectorAddress(sector) + offset, buffer, length) != ESP_OK) {
+            return false;
+        }
+
+        // The head sector's current page is still in RAM
+        if (sector == s_headSector && s_pageStart < SECTOR_SIZE) {
+            uint16_t from = max(offset, s_pageStart);
+            uint16_t to = min<uint16_t>(offset + length, s_pageStart + PAGE_SIZE);
+            if (from < to) {
+                memcpy(buffer + (from - offset), s_page + (from - s_pageStart), to - from);
+            }
+        }
+        return true;
+    }
+
+    Cursor getCursor() {
+        Cursor cursor = {0, 0};
+        if (s_active && s_validSectors > 0) {
+            cursor.first = (s_headSector + 1 + s_sectorCount - s_validSectors) % s_sectorCount;
+            cursor.count = s_validSectors;
+        }
+        return cursor;
+    }
+
+    bool readFlash(const Cursor& cursor, uint16_t index, uint16_t offset, uint8_t* buffer, uint16_t length) {
+        // s_partition and s_sectorCount are fixed after begin()
+        if (index >= cursor.count || offset + length > SECTOR_SIZE || s_sectorCount == 0) {
+            return false;
+        }
+        uint16_t sector = (cursor.first + index) % s_sectorCount;
+        return esp_partition_read(s_partition, sectorAddress(sector) + offset, buffer, length) == ESP_OK;
+    }
+
+    uint32_t parseLog(const uint8_t* log, size_t size, RecordHandler handler, void* context) {
+        uint32_t records = 0;
+        for (size_t base = 0; base + SECTOR_SIZE <= size; base += SECTOR_SIZE) {
+            SectorHeader sector;
+            memcpy(&sector, log + base, sizeof(sector));
+            if (sector.magic != SECTOR_MAGIC) {
+                continue;
+            }
+            size_t pos = sizeof(sector);
+            while (pos + sizeof(RecordHeader) <= SECTOR_SIZE) {
+                RecordHeader record;
+                memcpy(&record, log + base + pos, sizeof(record));
+                if (record.port >= PORT_COUNT || record.length == 0 || record.length > MAX_CHUNK
+                    || pos + sizeof(record) + record.length > SECTOR_SIZE) {
+                    break;  // END_OF_SECTOR (erased) or damaged
+                }
+                handler(sector, record, log + base + pos + sizeof(record), context);
+                pos += sizeof(record) + record.length;
+                records++;
+            }
+        }
+        return records;
+    }
+
+    uint32_t getBytesRecorded() { return s_bytesRecorded; }
+    uint32_t getPageWrites() { return s_pageWrites; }
+    uint32_t getSectorErases() { return s_sectorErases; }
+    uint32_t getWriteFailures() { return s_writeFailures; }
+    uint32_t getFlashTimeMs() { return s_flashTimeUs / 1000; }
+    uint32_t getCapacityBytes() { return s_partition ? s_partition->size : 0; }
+}
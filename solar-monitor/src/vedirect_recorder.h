@@ -0,0 +1,129 @@
+/**
+ * vedirect_recorder.h
+ *
+ * Black-box recorder for the raw VE.Direct streams
+ *
+ * Every byte the parsers read is also appended, with its arrival time, to a
+ * circular log in the "vedlog" flash partition (see partitions.csv), so odd
+ * values in InfluxDB can be traced back to the charger, the parser or the
+ * network. The log can be downloaded from /api/vedlog and replayed through
+ * the real parsers by the native host runner.
+ *
+ * Flash layout: the partition is a ring of 4 KB sectors, each starting with
+ * a SectorHeader followed by records (RecordHeader + up to MAX_CHUNK bytes of
+ * one port). A record never spans sectors; unused space at the end of a
+ * sector stays erased (0xFF). Writes are append-only in whole 256-byte
+ * pages, and a sector is erased only when the write head enters it, so
+ * every sector is erased once per lap of the ring (even wear, no rewrites).
+ * Each boot starts a new sector.
+ */
+
+#ifndef VEDIRECT_RECORDER_H
+#define VEDIRECT_RECORDER_H
+
+#include <Arduino.h>
+#include <Stream.h>
+
+#ifndef VEDLOG_PARTITION_LABEL
+#define VEDLOG_PARTITION_LABEL "vedlog"
+#endif
+
+#ifndef VEDLOG_PARTITION_SUBTYPE
+#define VEDLOG_PARTITION_SUBTYPE 0x40  // Custom data subtype (partitions.csv)
+#endif
+
+namespace VeDirectRecorder {
+    static const uint16_t SECTOR_SIZE = 4096;
+    static const uint16_t PAGE_SIZE = 256;
+    static const uint8_t MAX_CHUNK = 64;            // Payload bytes per record
+    static const uint16_t CHUNK_FLUSH_MS = 50;      // Max time bytes wait to become a record
+    static const uint8_t END_OF_SECTOR = 0xFF;      // Erased port byte: no more records
+
+    enum Port : uint8_t {
+        PORT_SHUNT = 0,
+        PORT_MPPT1 = 1,
+        PORT_MPPT2 = 2,
+        PORT_COUNT = 3
+    };
+
+    struct SectorHeader {
+        uint32_t magic;             // "VDL1"
+        uint32_t sequence;          // Increments per sector written, orders the ring
+        uint32_t bootId;            // Increments per boot; timestamps restart with it
+        uint32_t reserved;
+    };
+
+    struct __attribute__((packed)) RecordHeader {
+        uint8_t port;               // Port, END_OF_SECTOR if no record follows
+        uint8_t length;             // Payload bytes (1..MAX_CHUNK)
+        uint32_t timestampMs;       // millis() when the first byte arrived
+    };
+
+    /**
+     * @brief Stream wrapper handed to a parser: reads pass through and every
+     * byte read is recorded for the given port.
+     */
+    class TapStream : public Stream {
+    public:
+        TapStream(Stream* source, Port port) : _source(source), _port(port) {}
+
+        int available() override { return _source->available(); }
+        int read() override;
+        int peek() override { return _source->peek(); }
+        size_t write(uint8_t c) override { return _source->write(c); }
+        using Print::write;
+
+    private:
+        Stream* _source;
+        Port _port;
+    };
+
+    /**
+     * @brief Find the partition and resume after the newest sector.
+     * @return false if the partition is missing (recording stays off)
+     */
+    bool begin();
+
+    void record(Port port, uint8_t c);
+
+    /**
+     * @brief Turn waiting bytes into records after CHUNK_FLUSH_MS. Call from loop().
+     */
+    void loop();
+
+    bool isActive();
+
+    // Download: the log as whole sectors, oldest first. The current sector
+    // includes the page still being filled in RAM.
+    uint16_t getSectorCount();      // Sectors with data
+    bool readSector(uint16_t index, uint16_t offset, uint8_t* buffer, uint16_t length);
+
+    // Download from another task (async web server): loop() takes a Cursor,
+    // the reader then touches flash only. The newest sector lacks the page
+    // still in RAM (it reads as erased), and a sector the ring reuses during
+    // a long download comes back with newer data (higher sequence).
+    struct Cursor {
+        uint16_t first;             // Physical sector holding the oldest data
+        uint16_t count;             // Sectors with data
+    };
+    Cursor getCursor();             // Main loop
+    bool readFlash(const Cursor& cursor, uint16_t index, uint16_t offset, uint8_t* buffer, uint16_t length);
+
+    /**
+     * @brief Walk the records of a downloaded log (host replay, diagnostics).
+     * Sectors without a valid header are skipped.
+     * @return Number of records visited
+     */
+    typedef void (*RecordHandler)(const SectorHeader& sector, const RecordHeader& record,
+                                  const uint8_t* data, void* context);
+    uint32_t parseLog(const uint8_t* log, size_t size, RecordHandler handler, void* context);
+
+    uint32_t getBytesRecorded();    // Payload bytes since boot
+    uint32_t getPageWrites();
+    uint32_t getSectorErases();
+    uint32_t getWriteFailures();
+    uint32_t getFlashTimeMs();      // Time spent in flash erase/program since boot
+    uint32_t getCapacityBytes();
+}
+
+#endif // VEDIRECT_RECORDER_H
@@ -0,0 +1,123 @@
+/**
+ * webhook_queue.cpp
+ *
+ * Implementation of the rule webhook worker
+ */
+
+#include "webhook_queue.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string.h>
+
+#ifdef NATIVE_HOST
+  #include <thread>
+#endif
+
+namespace WebhookQueue {
+    struct Job {
+        char url[MAX_URL];
+        char body[MAX_BODY];
+        size_t length;
+    };
+
+    // Ring of queued jobs; the job at s_head stays in place while it is sent,
+    // post() only writes free slots
+    static Job s_jobs[WEBHOOK_QUEUE_DEPTH];
+    static uint8_t s_head = 0;
+    static uint8_t s_count = 0;
+    // Never destroyed: the worker is still waiting on them at exit
+    static std::mutex& s_mutex = *new std::mutex;
+    static std::condition_variable& s_ready = *new std::condition_variable;
+    static Sender s_sender = nullptr;
+
+    static std::atomic<uint8_t> s_pending(0);
+    static std::atomic<uint32_t> s_sent(0);
+    static std::atomic<uint32_t> s_failed(0);
+    static std::atomic<uint32_t> s_dropped(0);
+    static std::atomic<uint32_t> s_maxPostMs(0);
+    static std::atomic<int> s_lastStatus(0);
+
+    static void serve() {
+        for (;;) {
+            std::unique_lock<std::mutex> lock(s_mutex);
+            s_ready.wait(lock, [] { return s_count > 0; });
+            const Job& job = s_jobs[s_head];
+            lock.unlock();
+
+            uint32_t start = millis();
+            int status = s_sender(job.url, job.body, job.length);
+            uint32_t elapsed = millis() - start;
+            if (elapsed > s_maxPostMs.load(std::memory_order_relaxed)) {
+                s_maxPostMs.store(elapsed, std::memory_order_relaxed);
+            }
+            s_lastStatus.store(status, std::memory_order_relaxed);
+            if (status >= 200 && status < 300) {
+                s_sent.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                s_failed.fetch_add(1, std::memory_order_relaxed);
+                Serial.printf("[Webhook] POST %s failed: %d (%lu ms)\n", job.url, status, (unsigned long)elapsed);
+            }
+
+            lock.lock();
+            s_head = (s_head + 1) % WEBHOOK_QUEUE_DEPTH;
+            s_count--;
+            s_pending.store(s_count, std::memory_order_relaxed);
+        }
+    }
+
+#ifndef NATIVE_HOST
+    static void workerTask(void* arg) {
+        (void)arg;
+        serve();
+    }
+#endif
+
+    bool begin(Sender sender) {
+        if (s_sender != nullptr) {
+            return true;
+        }
+        s_sender = sender;
+#ifdef NATIVE_HOST
+        std::thread(serve).detach();
+#else
+        // Core 0 with the network stack; HTTPClient (and TLS) need the larger stack
+        if (xTaskCreatePinnedToCore(workerTask, "webhook", 8192, nullptr, 1, nullptr, 0) != pdPASS) {
+            Serial.println("[Webhook] Failed to start worker task");
+            s_sender = nullptr;
+            return false;
+        }
+#endif
+        return true;
+    }
+
+    bool post(const char* url, const char* body, size_t length) {
+        if (s_sender == nullptr || strlen(url) >= MAX_URL || length > MAX_BODY) {
+            s_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        {
+            std::lock_guard<std::mutex> lock(s_mutex);
+            if (s_count == WEBHOOK_QUEUE_DEPTH) {
+                s_dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            Job& job = s_jobs[(s_head + s_count) % WEBHOOK_QUEUE_DEPTH];
+            strcpy(job.url, url);
+            memcpy(job.body, body, length);
+            job.length = length;
+            s_count++;
+            s_pending.store(s_count, std::memory_order_relaxed);
+        }
+        s_ready.notify_one();
+        return true;
+    }
+
+    uint8_t getPending() { return s_pending.load(std::memory_order_relaxed); }
+    uint32_t getSent() { return s_sent.load(std::memory_order_relaxed); }
+    uint32_t getFailed() { return s_failed.load(std::memory_order_relaxed); }
+    uint32_t getDropped() { return s_dropped.load(std::memory_order_relaxed); }
+    uint32_t getMaxPostMs() { return s_maxPostMs.load(std::memory_order_relaxed); }
+    int getLastStatus() { return s_lastStatus.load(std::memory_order_relaxed); }
+}
@@ -0,0 +1,49 @@
+/**
+ * webhook_queue.h
+ *
+ * Rule webhooks posted from a worker task instead of loop()
+ *
+ * post() copies the URL and body into a fixed ring and returns at once; a
+ * separate task (core 0 on the ESP32, a thread on the host) resolves the
+ * host and sends each request through the sender given to begin(). A dead
+ * or slow endpoint (DNS lookup, connect and response timeouts) only delays
+ * the worker, so loop() keeps draining the VE.Direct UARTs. When the ring
+ * is full the new post is dropped and counted.
+ */
+
+#ifndef WEBHOOK_QUEUE_H
+#define WEBHOOK_QUEUE_H
+
+#include <Arduino.h>
+
+#ifndef WEBHOOK_QUEUE_DEPTH
+#define WEBHOOK_QUEUE_DEPTH 4
+#endif
+
+namespace WebhookQueue {
+    static const size_t MAX_URL = 96;     // RuleEngine::MAX_TARGET
+    static const size_t MAX_BODY = 384;
+
+    /**
+     * @brief Send one request; runs on the worker.
+     * @return HTTP status code, or a negative client error
+     */
+    typedef int (*Sender)(const char* url, const char* body, size_t length);
+
+    bool begin(Sender sender);
+
+    /**
+     * @brief Queue a POST without waiting for it.
+     * @return false if the URL or body does not fit or the queue is full
+     */
+    bool post(const char* url, const char* body, size_t length);
+
+    uint8_t getPending();        // Queued or in flight
+    uint32_t getSent();          // Answered with a 2xx status
+    uint32_t getFailed();        // Any other status or a client error
+    uint32_t getDropped();       // Rejected by post()
+    uint32_t getMaxPostMs();     // Longest request on the worker
+    int getLastStatus();
+}
+
+#endif // WEBHOOK_QUEUE_H
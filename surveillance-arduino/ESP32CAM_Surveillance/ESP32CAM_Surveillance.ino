@@ -45,7 +45,6 @@
 #include <ESPAsyncWebServer.h>
 #include <ArduinoOTA.h>
 #include <Update.h>
-#include <base64.h>
 #include <LittleFS.h>
 #include <SD_MMC.h>
 #include <esp_task_wdt.h>
@@ -54,17 +53,19 @@
 #include <Preferences.h>
 #include <esp_system.h>
 #include <img_converters.h>
+#include <mbedtls/base64.h>
 #include "camera_config.h"
 #include "device_config.h"
 #include "secrets.h"
 #include "trace.h"
-
-// RTC memory for reset detection and crash loop recovery
-// These survive software resets but are cleared on power loss
-RTC_NOINIT_ATTR uint32_t rtcResetCount;      // Counts rapid resets
-RTC_NOINIT_ATTR uint32_t rtcResetTimestamp;  // Timestamp of last reset
-RTC_NOINIT_ATTR uint32_t rtcCrashLoopFlag;   // Magic number if boot incomplete
-RTC_NOINIT_ATTR uint32_t rtcCrashCount;      // Consecutive crash count
+#include "loop_profiler.h"
+#include "reset_tracker.h"
+#include "mqtt_json.h"
+#include "frame_dedup.h"
+#include "frame_pool.h"
+#include "camera_power.h"
+#include "motion_tracker.h"
+#include "person_classifier.h"
 
 // Boot/recovery state
 const char* configPortalReason = "none";     // Why portal was triggered
@@ -110,7 +111,6 @@ WiFiClient espClient;
 PubSubClient mqttClient(espClient);
 AsyncWebServer server(WEB_SERVER_PORT);
 WiFiManager wifiManager;
-Preferences resetPrefs;
 
 // Timing variables
 unsigned long lastCaptureTime = 0;
@@ -138,6 +138,10 @@ volatile int activeStreamClients = 0;
 // Camera motion detection
 uint8_t* previousFrame = NULL;
 size_t previousFrameSize = 0;
+uint16_t previousFrameWidth = 0;
+MotionTracker::Result lastMotionTrack = {MotionTracker::Event::None, nullptr, 0, 0};  // Alert of the last motion check
+PersonClassifier::Result lastMotionClass = {PersonClassifier::Label::Other, 0.0f, 0};
+bool motionClassified = false;    // lastMotionClass belongs to the last alert
 
 // Function declarations
 void loadDeviceName();
@@ -152,6 +156,9 @@ void getDeviceChipId();
 void getDeviceMacAddress();
 void IRAM_ATTR motionISR();
 bool checkCameraMotion(camera_fb_t** outFrame = NULL);
+void classifyMotion(camera_fb_t* fb, const MotionTracker::Track& track);
+bool isDuplicateCapture(camera_fb_t* fb, const uint8_t* luma = NULL, bool alwaysStore = false);
+void resizeFramePool();
 void setupWiFi();
 void setupSD();
 bool deleteOldestCaptures(int count);
@@ -163,10 +170,11 @@ void setupWebServer();
 void reconnectMQTT();
 void gracefulMqttDisconnect();
 void publishStatus();
-void captureAndPublish();
+void captureAndPublish(bool periodic = false);
 void captureAndPublishWithImage();
 void publishMetricsToMQTT();
-void logEventToMQTT(const char* event, const char* severity);
+void logEventToMQTT(const char* event, const char* severity, const char* message = nullptr);
+void onLoopStall(const LoopProfiler::StallInfo& info);
 bool saveImageToSD(camera_fb_t* fb, const char* reason);
 bool uploadImageToSFTP(camera_fb_t* fb, const char* filename);
 bool saveOrUploadImage(camera_fb_t* fb, const char* reason);
@@ -259,10 +267,13 @@ void setup() {
     Serial.println("[SETUP] Loading motion config...");
     loadMotionConfig();
 
-    // PIR sensor disabled for testing
-    // pinMode(PIR_PIN, INPUT_PULLDOWN);
-    // attachInterrupt(digitalPinToInterrupt(PIR_PIN), motionISR, RISING);
-    Serial.println("[SETUP] PIR sensor disabled");
+    if (PIR_GATED_MODE) {
+        pinMode(PIR_PIN, INPUT_PULLDOWN);
+        attachInterrupt(digitalPinToInterrupt(PIR_PIN), motionISR, RISING);
+        Serial.printf("[SETUP] PIR-gated mode on GPIO%d, camera sleeps between events\n", PIR_PIN);
+    } else {
+        Serial.println("[SETUP] PIR sensor disabled");
+    }
 
     // Load flash config before GPIO init
     Serial.println("[SETUP] Loading flash config...");
@@ -307,6 +318,14 @@ void setup() {
                 Serial.printf("[Camera] cameraReady = %d\n", cameraReady);
             } else {
                 Serial.println("[Camera] Initialization complete!");
+                resizeFramePool();
+                CameraPower::Config powerConfig;
+                powerConfig.pwdnPin = PWDN_GPIO_NUM;
+                powerConfig.idleMs = PIR_CAMERA_IDLE_MS;
+                powerConfig.settleFrames = PIR_WAKE_SETTLE_FRAMES;
+                powerConfig.activeMa = CAMERA_ACTIVE_MA;
+                powerConfig.standbyMa = CAMERA_STANDBY_MA;
+                CameraPower::begin(powerConfig);
                 Serial.printf("[Camera] cameraReady = %d\n", cameraReady);
             }
             vTaskDelete(NULL);
@@ -321,6 +340,21 @@ void setup() {
     // Setup MQTT
     setupMQTT();
 
+    LoopProfiler::begin(LOOP_STALL_THRESHOLD_MS, LOOP_STALL_REPORT_INTERVAL_MS, onLoopStall);
+
+    MotionTracker::Config trackerConfig;
+    trackerConfig.cellPixels = MOTION_TRACK_CELL_PIXELS;
+    trackerConfig.maxMisses = MOTION_TRACK_MAX_MISSES;
+    trackerConfig.moveThresholdPx = MOTION_TRACK_MOVE_PX;
+    MotionTracker::begin(trackerConfig);
+    FrameDedup::Config dedupConfig;
+    dedupConfig.maxDistance = DEDUP_MAX_DISTANCE;
+    dedupConfig.refreshMs = DEDUP_REFRESH_MS;
+    FrameDedup::begin(dedupConfig);
+    if (littleFsReady && PersonClassifier::loadFile(CLASSIFIER_MODEL_FILE)) {
+        Serial.printf("[Motion] Classifier model loaded from %s\n", CLASSIFIER_MODEL_FILE);
+    }
+
     // Setup OTA updates (enabled when a secure OTA_PASSWORD is set)
     #if defined(OTA_PASSWORD)
       if (WiFi.status() == WL_CONNECTED) {
@@ -355,19 +389,24 @@ void setup() {
 }
 
 void loop() {
+    LoopProfiler::Iteration loopIteration;
     unsigned long currentMillis = millis();
 
     // Handle OTA updates (if enabled)
     if (otaEnabled) {
+      LOOP_PROFILE_REGION("ota");
       ArduinoOTA.handle();
     }
 
+    ResetTracker::loop();
+
     // Check for WiFi fallback AP mode
     checkWiFiFallback();
 
     // Handle WiFi reconnection
     if (WiFi.status() != WL_CONNECTED) {
         if (currentMillis - lastWiFiCheck >= WIFI_RECONNECT_INTERVAL) {
+            LOOP_PROFILE_REGION("wifi_reconnect");
             Serial.println("WiFi disconnected, attempting reconnection...");
             WiFi.reconnect();
             lastWiFiCheck = currentMillis;
@@ -381,6 +420,7 @@ void loop() {
             lastMqttReconnect = currentMillis;
         }
     } else {
+        LOOP_PROFILE_REGION("mqtt_loop");
         mqttClient.loop();
     }
 
@@ -393,15 +433,30 @@ void loop() {
         }
     }
 
+    // PIR-gated mode: the interrupt triggers captures, the sensor sleeps in between
+    if (PIR_GATED_MODE && motionDetected && cameraReady) {
+        LOOP_PROFILE_REGION("pir_capture");
+        handleMotionDetection();
+    }
+    if (cameraReady) {
+        CameraPower::loop(PIR_GATED_MODE || !motionEnabled);
+    }
+
     // Camera-based motion detection (throttled to every 3 seconds)
-    if (motionEnabled && cameraReady) {
+    if (motionEnabled && cameraReady && !PIR_GATED_MODE) {
         if (currentMillis - lastMotionCheck >= MOTION_CHECK_INTERVAL) {
+            LOOP_PROFILE_REGION("motion_check");
             camera_fb_t* motionFrame = NULL;
             if (checkCameraMotion(&motionFrame)) {
                 // Motion detected - reuse the frame that was already captured for detection
                 bool saved = false;
+                bool duplicate = false;
                 if (motionFrame) {
-                    saved = saveOrUploadImage(motionFrame, "motion");
+                    // previousFrame now holds this frame's luma map. A new track is always
+                    // stored: the hash barely moves for a person-sized object
+                    bool birth = lastMotionTrack.event == MotionTracker::Event::Birth;
+                    duplicate = isDuplicateCapture(motionFrame, previousFrame, birth);
+                    saved = !duplicate && saveOrUploadImage(motionFrame, "motion");
                     returnFrameBuffer(motionFrame);
                     motionFrame = NULL;
                 }
@@ -413,15 +468,23 @@ void loop() {
                     doc["motion"] = true;
                     doc["timestamp"] = currentMillis / 1000;
                     doc["count"] = motionDetectCount;
+                    const MotionTracker::Track* track = lastMotionTrack.track;
+                    doc["track_id"] = track->id;
+                    doc["track_event"] = MotionTracker::eventName(lastMotionTrack.event);
+                    doc["track_age_s"] = (millis() - track->bornMs) / 1000;
+                    doc["track_velocity_px_s"] = hypotf(track->vx, track->vy);
+                    doc["tracks"] = lastMotionTrack.tracks;
+                    if (motionClassified) {
+                        doc["class"] = PersonClassifier::labelName(lastMotionClass.label);
+                        doc["class_score"] = lastMotionClass.score;
+                    }
                     doc["storage"] = sftpEnabled ? (saved ? "sftp" : "sd_fallback") : "sd";
                     doc["saved"] = saved;
                     doc["sftp_enabled"] = sftpEnabled;
-
-                    String output;
-                    serializeJson(doc, output);
+                    doc["duplicate"] = duplicate;
 
                     String topic = String(MQTT_TOPIC_BASE) + "/" + deviceName + "/motion";
-                    mqttClient.publish(topic.c_str(), output.c_str(), false);
+                    MqttJson::publish(mqttClient, topic.c_str(), doc, false);
                     Serial.println("[Motion] Published to MQTT");
                 }
 
@@ -448,7 +511,7 @@ void loop() {
     // Periodic image capture - DISABLED (motion-only mode)
     // if (cameraReady && mqttConnected) {
     //     if (currentMillis - lastCaptureTime >= CAPTURE_INTERVAL) {
-    //         captureAndPublish();
+    //         captureAndPublish(true);
     //         lastCaptureTime = currentMillis;
     //     }
     // }
@@ -479,21 +542,36 @@ bool checkCameraMotion(camera_fb_t** outFrame) {
 
     bool motionDetected = false;
 
-    // Downsample dimensions (96x96 at 8x scale from typical SVGA 800x600)
-    const int DOWNSAMPLE_WIDTH = 96;
-    const int DOWNSAMPLE_HEIGHT = 96;
-    const int DOWNSAMPLE_SIZE = DOWNSAMPLE_WIDTH * DOWNSAMPLE_HEIGHT;
+    // Luma map: the frame decoded at 1/8 scale (100x75 at SVGA, 80x60 at VGA)
+    const uint16_t mapWidth = fb->width / 8;
+    const uint16_t mapHeight = fb->height / 8;
+    const int DOWNSAMPLE_SIZE = mapWidth * mapHeight;
+    if (mapWidth > MotionTracker::MAX_MAP_WIDTH || mapHeight > MotionTracker::MAX_MAP_HEIGHT) {
+        Serial.printf("[Motion] Frame %ux%u too large for the motion map\n", fb->width, fb->height);
+        returnFrameBuffer(fb);
+        return false;
+    }
 
-    // Allocate RGB565 buffer for decoded JPEG (first time only) - use PSRAM
-    static uint8_t* rgb565Buffer = NULL;
+    // RGB565 buffer for the decoded JPEG (frame pool, returned when this check ends)
+    FramePool::Buffer rgb565(DOWNSAMPLE_SIZE * 2); // RGB565 = 2 bytes per pixel
+    uint8_t* rgb565Buffer = rgb565.data();
     if (rgb565Buffer == NULL) {
-        rgb565Buffer = (uint8_t*)ps_malloc(DOWNSAMPLE_SIZE * 2); // RGB565 = 2 bytes per pixel
+        Serial.println("[Motion] No frame pool block for decode");
+        returnFrameBuffer(fb);
+        return false;
+    }
+
+    // A new frame size starts over with a first frame
+    if (previousFrame != NULL && (previousFrameWidth != mapWidth || previousFrameSize != (size_t)DOWNSAMPLE_SIZE)) {
+        free(previousFrame);
+        previousFrame = NULL;
+        previousFrameSize = 0;
     }
 
     if (previousFrame == NULL) {
         // First frame - allocate grayscale buffer in PSRAM (saves ~9KB heap)
         previousFrame = (uint8_t*)ps_malloc(DOWNSAMPLE_SIZE);
-        if (previousFrame && rgb565Buffer) {
+        if (previousFrame) {
             // Decode JPEG to RGB565 at downsampled resolution
             if (jpg2rgb565(fb->buf, fb->len, rgb565Buffer, JPG_SCALE_8X)) {
                 // Convert RGB565 to grayscale
@@ -507,7 +585,8 @@ bool checkCameraMotion(camera_fb_t** outFrame) {
                     previousFrame[i] = (r * 8 + g * 4 + b * 8) / 3;
                 }
                 previousFrameSize = DOWNSAMPLE_SIZE;
-                Serial.printf("[Motion] First frame decoded - %dx%d grayscale (PSRAM)\n", DOWNSAMPLE_WIDTH, DOWNSAMPLE_HEIGHT);
+                previousFrameWidth = mapWidth;
+                Serial.printf("[Motion] First frame decoded - %ux%u grayscale (PSRAM)\n", mapWidth, mapHeight);
             } else {
                 Serial.println("[Motion] JPEG decode failed");
             }
@@ -523,35 +602,48 @@ bool checkCameraMotion(camera_fb_t** outFrame) {
         return false;
     }
 
-    // Convert to grayscale and compare
+    // Convert to grayscale and compare (changed pixels also counted per 8x8 cell for the tracker)
     int changedPixels = 0;
     int totalPixels = DOWNSAMPLE_SIZE;
+    uint8_t cellCounts[MotionTracker::MAX_CELLS] = {0};
+
+    for (uint16_t y = 0, i = 0; y < mapHeight; y++) {
+        for (uint16_t x = 0; x < mapWidth; x++, i++) {
+            // Convert RGB565 pixel to grayscale
+            uint16_t pixel = ((uint16_t*)rgb565Buffer)[i];
+            uint8_t r = (pixel >> 11) & 0x1F;
+            uint8_t g = (pixel >> 5) & 0x3F;
+            uint8_t b = pixel & 0x1F;
+            uint8_t currentGray = (r * 8 + g * 4 + b * 8) / 3;
+
+            // Compare with previous frame
+            int diff = abs((int)currentGray - (int)previousFrame[i]);
+            if (diff > MOTION_THRESHOLD) {
+                changedPixels++;
+                cellCounts[MotionTracker::cellIndex(x, y, mapWidth)]++;
+            }
 
-    for (int i = 0; i < DOWNSAMPLE_SIZE; i++) {
-        // Convert RGB565 pixel to grayscale
-        uint16_t pixel = ((uint16_t*)rgb565Buffer)[i];
-        uint8_t r = (pixel >> 11) & 0x1F;
-        uint8_t g = (pixel >> 5) & 0x3F;
-        uint8_t b = pixel & 0x1F;
-        uint8_t currentGray = (r * 8 + g * 4 + b * 8) / 3;
-
-        // Compare with previous frame
-        int diff = abs((int)currentGray - (int)previousFrame[i]);
-        if (diff > MOTION_THRESHOLD) {
-            changedPixels++;
+            // Update previous frame buffer
+            previousFrame[i] = currentGray;
         }
-
-        // Update previous frame buffer
-        previousFrame[i] = currentGray;
     }
 
-    // Determine if motion detected
-    if (changedPixels >= MOTION_CHANGED_BLOCKS) {
-        motionDetected = true;
+    // Determine if motion detected; only track births and significant movement alert
+    bool changed = changedPixels >= MOTION_CHANGED_BLOCKS;
+    lastMotionTrack = MotionTracker::update(changed ? cellCounts : nullptr, mapWidth, mapHeight, millis());
+    if (changed) {
         float changePercent = (float)changedPixels / totalPixels * 100.0;
-        Serial.printf("[Motion] *** DETECTED *** %d/%d pixels changed (%.1f%%) - Count: %lu\n",
-                      changedPixels, totalPixels, changePercent, motionDetectCount + 1);
+        Serial.printf("[Motion] %d/%d pixels changed (%.1f%%), %u blobs, %u tracks\n",
+                      changedPixels, totalPixels, changePercent, lastMotionTrack.blobs, lastMotionTrack.tracks);
+    }
+    if (lastMotionTrack.event != MotionTracker::Event::None) {
+        motionDetected = true;
+        Serial.printf("[Motion] *** DETECTED *** track %u %s - Count: %lu\n", lastMotionTrack.track->id,
+                      MotionTracker::eventName(lastMotionTrack.event), motionDetectCount + 1);
         motionDetectCount++;
+        if (PersonClassifier::isReady()) {
+            classifyMotion(fb, *lastMotionTrack.track);
+        }
 
         // Return frame to caller for reuse (avoids double capture)
         if (outFrame) {
@@ -567,6 +659,89 @@ bool checkCameraMotion(camera_fb_t** outFrame) {
     return motionDetected;
 }
 
+// Classify the alerting blob on a 1/4-scale decode of the same frame
+void classifyMotion(camera_fb_t* fb, const MotionTracker::Track& track) {
+    motionClassified = false;
+    if (track.box.cells < CLASSIFIER_MIN_CELLS) {
+        PersonClassifier::countSkipped();
+        return;
+    }
+
+    uint16_t width = fb->width / 4;
+    uint16_t height = fb->height / 4;
+    FramePool::Buffer frame((size_t)width * height * 2);
+    FramePool::Buffer input(PersonClassifier::INPUT_SIZE * PersonClassifier::INPUT_SIZE);
+    uint8_t* classifierFrame = frame.data();
+    uint8_t* classifierInput = input.data();
+    if (!classifierFrame || !classifierInput || !jpg2rgb565(fb->buf, fb->len, classifierFrame, JPG_SCALE_4X)) {
+        Serial.println("[Motion] Classifier decode failed");
+        return;
+    }
+
+    PersonClassifier::cropRgb565((const uint16_t*)classifierFrame, width, height, fb->width / 8, fb->height / 8,
+                                 track.box.x0, track.box.y0, track.box.x1, track.box.y1, classifierInput);
+    lastMotionClass = PersonClassifier::classify(classifierInput);
+    motionClassified = true;
+    Serial.printf("[Motion] Track %u: %s (%.2f) in %lu us\n", track.id,
+                  PersonClassifier::labelName(lastMotionClass.label), lastMotionClass.score,
+                  (unsigned long)lastMotionClass.micros);
+}
+
+// Perceptual hash of the capture's 1/8-scale luma map: the motion check's map
+// when the frame came from it, otherwise decoded the same way. With alwaysStore
+// the capture only becomes the reference (event captures are never skipped)
+bool isDuplicateCapture(camera_fb_t* fb, const uint8_t* luma, bool alwaysStore) {
+    const uint16_t mapWidth = fb->width / 8;
+    const uint16_t mapHeight = fb->height / 8;
+    const int LUMA_SIZE = mapWidth * mapHeight;
+    FramePool::Buffer decoded(luma ? 0 : LUMA_SIZE * 2);
+    FramePool::Buffer decodedLuma(luma ? 0 : LUMA_SIZE);
+    if (luma == NULL) {
+        uint8_t* dedupRgb565 = decoded.data();
+        uint8_t* dedupLuma = decodedLuma.data();
+        if (!dedupRgb565 || !dedupLuma || !jpg2rgb565(fb->buf, fb->len, dedupRgb565, JPG_SCALE_8X)) {
+            return false;  // Store when in doubt
+        }
+        for (int i = 0; i < LUMA_SIZE; i++) {
+            uint16_t pixel = ((uint16_t*)dedupRgb565)[i];
+            dedupLuma[i] = (((pixel >> 11) & 0x1F) * 8 + ((pixel >> 5) & 0x3F) * 4 + (pixel & 0x1F) * 8) / 3;
+        }
+        luma = dedupLuma;
+    }
+
+    unsigned long start = micros();
+    uint64_t hash = FrameDedup::hash(luma, mapWidth, mapHeight);
+    if (alwaysStore) {
+        FrameDedup::setReference(hash, millis());
+        return false;
+    }
+    bool duplicate = FrameDedup::isDuplicate(hash, fb->len, millis());
+    if (duplicate) {
+        Serial.printf("[Dedup] Skipped near-duplicate capture (%u bytes, hash %08lx%08lx in %lu us), hit rate %.0f%%\n",
+                      (unsigned int)fb->len, (unsigned long)(hash >> 32), (unsigned long)hash,
+                      micros() - start, FrameDedup::getHitRate() * 100);
+    }
+    return duplicate;
+}
+
+// Size the frame pool classes for the sensor's current frame size (rebuilt once blocks are back)
+void resizeFramePool() {
+    sensor_t* s = esp_camera_sensor_get();
+    if (s == NULL) {
+        return;
+    }
+    const resolution_info_t& size = resolution[s->status.framesize];
+    static bool started = false;
+    if (!started) {
+        started = FramePool::begin(FramePool::Config(), size.width, size.height);
+        Serial.printf("[FramePool] %u bytes of PSRAM for %ux%u frames\n",
+                      (unsigned int)FramePool::getArenaBytes(), size.width, size.height);
+    } else if (!FramePool::resize(size.width, size.height)) {
+        Serial.printf("[FramePool] Resize to %ux%u deferred until in-flight frames are released\n",
+                      size.width, size.height);
+    }
+}
+
 void loadDeviceName() {
     if (!littleFsReady) {
         Serial.println("[FS] Warning: LittleFS not ready, using default device name");
@@ -816,6 +991,7 @@ bool saveImageToSD(camera_fb_t* fb, const char* reason) {
     if (!sdReady || !fb) {
         return false;
     }
+    LOOP_PROFILE_REGION("sd_write");
     
     // Check available space (keep at least 10MB free)
     uint64_t totalBytes = SD_MMC.totalBytes();
@@ -872,6 +1048,8 @@ bool uploadImageToSFTP(camera_fb_t* fb, const char* filename) {
         return false;
     }
 
+    LOOP_PROFILE_REGION("sftp_upload");
+
     // Build remote path: /camera-uploads/{device_name}/{filename}
     char remotePath[128];
     snprintf(remotePath, sizeof(remotePath), "/camera-uploads/%s/%s", deviceName, filename);
@@ -1187,89 +1365,14 @@ bool deleteAllCaptures() {
 // ==================== Reset Detection & Recovery ====================
 
 void checkResetCounter() {
-    // Check for triple-reset and crash loop conditions (ESP32-S3 reliable via NVS)
+    // Check for triple-reset and crash loop conditions (RTC memory, non-blocking)
     // This must be called early in setup() before other initialization
-
-    // Open preferences namespace for reset tracking
-    resetPrefs.begin("reset", false);
-
-    // ===== Crash loop detection =====
-    uint32_t crashFlag = resetPrefs.getUInt("crash_flag", 0);
-    uint32_t crashCnt = resetPrefs.getUInt("crash_cnt", 0);
-
-    if (crashFlag == CRASH_LOOP_MAGIC) {
-        crashCnt++;
-        resetPrefs.putUInt("crash_cnt", crashCnt);
-        Serial.printf("[RESET] Incomplete boot detected, crash count: %lu\n", crashCnt);
-
-        if (crashCnt >= CRASH_LOOP_THRESHOLD) {
-            Serial.println("[RESET] CRASH LOOP RECOVERY - entering config portal");
-            configPortalReason = "crash_recovery";
-            resetPrefs.putUInt("crash_cnt", 0); // Reset for next time
-        }
-    } else {
-        // Fresh power-on (or flag cleared), reset crash count only.
-        // Do NOT clear triple-reset counters here; they must persist across boots.
-        resetPrefs.putUInt("crash_cnt", 0);
-    }
-
-    // Mark boot in progress (cleared in clearCrashLoop after successful boot)
-    resetPrefs.putUInt("crash_flag", CRASH_LOOP_MAGIC);
-
-    // ===== Triple-reset detection =====
-    if (strcmp(configPortalReason, "crash_recovery") != 0) {
-        uint32_t cnt = resetPrefs.getUInt("reset_cnt", 0);
-        uint32_t window = resetPrefs.getUInt("window", 0);
-
-        // Sanity check
-        if (cnt > 10) {
-            Serial.printf("[RESET] Reset counter corrupted (%lu), clearing\n", cnt);
-            cnt = 0;
-            window = 0;
-            resetPrefs.putUInt("reset_cnt", cnt);
-            resetPrefs.putUInt("window", window);
-        }
-
-        if (window == 1 && cnt > 0 && cnt < 10) {
-            // Previous boot started a detection window
-            cnt++;
-            resetPrefs.putUInt("reset_cnt", cnt);
-            Serial.printf("[RESET] Reset count: %lu (within window)\n", cnt);
-
-            if (cnt >= RESET_COUNT_THRESHOLD) {
-                Serial.println("[RESET] TRIPLE RESET DETECTED - entering config portal");
-                configPortalReason = "triple_reset";
-                // Clear for next time
-                resetPrefs.putUInt("reset_cnt", 0);
-                resetPrefs.putUInt("window", 0);
-            }
-        } else {
-            // First reset or outside window
-            cnt = 1;
-            window = 1;
-            resetPrefs.putUInt("reset_cnt", cnt);
-            resetPrefs.putUInt("window", window);
-            Serial.println("[RESET] First reset, starting detection window");
-        }
-
-        // Wait for window; if no reset occurs, clear markers
-        delay(RESET_DETECT_TIMEOUT * 1000);
-
-        if (strcmp(configPortalReason, "none") == 0) {
-            Serial.println("[RESET] Reset window expired, normal boot");
-            resetPrefs.putUInt("reset_cnt", 0);
-            resetPrefs.putUInt("window", 0);
-        }
-    }
-
-    Serial.printf("[RESET] Boot reason: %s\n", configPortalReason);
+    configPortalReason = ResetTracker::begin(RESET_DETECT_TIMEOUT, RESET_COUNT_THRESHOLD, CRASH_LOOP_THRESHOLD);
 }
 
 void clearCrashLoop() {
-    // Called after successful boot (WiFi + camera + web server initialized)
-    resetPrefs.putUInt("crash_flag", 0);
-    resetPrefs.putUInt("crash_cnt", 0);
-    Serial.println("[RESET] Crash loop flag cleared - boot successful");
+    // Called after successful boot (WiFi + sensors + web server initialized)
+    ResetTracker::markBootComplete();
 }
 
 void checkWiFiFallback() {
@@ -1280,6 +1383,7 @@ void checkWiFiFallback() {
 // ==================== End Reset Detection & Recovery ====================
 
 void IRAM_ATTR motionISR() {
+    CameraPower::markTrigger();
     motionDetected = true;
 }
 
@@ -1291,6 +1395,7 @@ void handleMotionDetection() {
     
     // Debounce check
     if (currentMillis - lastMotionTime < PIR_DEBOUNCE_MS) {
+        CameraPower::clearTrigger();
         return;
     }
     
@@ -1317,9 +1422,7 @@ void handleMotionDetection() {
     motionDoc["motion_count"] = motionDetectCount;
     motionDoc["event"] = "motion_detected";
     
-    String motionOutput;
-    serializeJson(motionDoc, motionOutput);
-    mqttClient.publish(getTopicMotion().c_str(), motionOutput.c_str(), false);
+    MqttJson::publish(mqttClient, getTopicMotion().c_str(), motionDoc, false);
     
     // Log to MQTT events topic
     logEventToMQTT("pir_motion", "info");
@@ -1474,7 +1577,7 @@ void setupMQTT() {
     mqttClient.setCallback(mqttCallback);
     mqttClient.setKeepAlive(60);        // Keep-alive ping every 60s
     mqttClient.setSocketTimeout(30);    // Socket timeout 30s
-    mqttClient.setBufferSize(1024);     // Increase buffer for JSON messages
+    mqttClient.setBufferSize(1024);     // Inbound commands; outgoing JSON is streamed (MqttJson)
 
     reconnectMQTT();
 }
@@ -1712,7 +1815,7 @@ void setupWebServer() {
         
         // Reset/recovery status
         doc["boot_reason"] = configPortalReason;
-        doc["crash_count"] = rtcCrashCount;
+        doc["crash_count"] = ResetTracker::getCrashCount();
 
         if (cameraReady) {
             sensor_t *s = esp_camera_sensor_get();
@@ -1866,6 +1969,7 @@ void reconnectMQTT() {
     }
 
     // Anonymous connect if credentials are empty, otherwise authenticate
+    LOOP_PROFILE_REGION("mqtt_connect");
     bool connected;
     if (strlen(MQTT_USER) == 0) {
         connected = mqttClient.connect(clientId.c_str());
@@ -1949,16 +2053,27 @@ void publishStatus() {
     
     // Reset/recovery status
     doc["boot_reason"] = configPortalReason;
-    doc["crash_count"] = rtcCrashCount;
-
-    String output;
-    serializeJson(doc, output);
-
-    mqttClient.publish(getTopicStatus().c_str(), output.c_str(), true);
+    doc["crash_count"] = ResetTracker::getCrashCount();
+    doc["reset_reason"] = ResetTracker::getResetReason();
+    doc["boot_count"] = ResetTracker::getBootCount();
+    doc["reset_nvs_writes"] = ResetTracker::getNvsWrites();
+    doc["reset_nvs_writes_per_day"] = ResetTracker::getNvsWritesPerDay();
+    doc["boot_delay_saved_ms"] = ResetTracker::getBootDelaySavedMs();
+    doc["mqtt_payload_max_bytes"] = MqttJson::getMaxPayloadBytes();
+    doc["mqtt_publish_max_us"] = MqttJson::getMaxPublishUs();
+
+    // Loop latency
+    doc["loop_max_ms"] = LoopProfiler::getMaxIterationMs();
+    doc["loop_stalls"] = LoopProfiler::getStallCount();
+
+    MqttJson::publish(mqttClient, getTopicStatus().c_str(), doc, true);
     Serial.println("Status published to MQTT");
 }
 
-void captureAndPublish() {
+// periodic: an idle capture that may be skipped as a repeat; event captures (PIR,
+// the MQTT "capture" command) are always stored
+void captureAndPublish(bool periodic) {
+    LOOP_PROFILE_REGION("capture_publish");
     Serial.printf("[CAPTURE] Starting capture (manual=%s)...\n", 
                   flashManualOn ? "ON" : "OFF");
 
@@ -1986,8 +2101,9 @@ void captureAndPublish() {
     captureCount++;
     Serial.printf("Image captured: %d bytes\n", fb->len);
     
-    // Save or upload image
-    bool saved = saveOrUploadImage(fb, "capture");
+    // Save or upload image, unless an idle capture repeats the last stored scene
+    bool duplicate = periodic && isDuplicateCapture(fb);
+    bool saved = !duplicate && saveOrUploadImage(fb, "capture");
 
     // Publish image metadata to MQTT
     JsonDocument doc;
@@ -2004,11 +2120,9 @@ void captureAndPublish() {
     doc["storage"] = sftpEnabled ? (saved ? "sftp" : "sd_fallback") : "sd";
     doc["saved"] = saved;
     doc["sftp_enabled"] = sftpEnabled;
+    doc["duplicate"] = duplicate;
 
-    String output;
-    serializeJson(doc, output);
-
-    if (mqttClient.publish(getTopicImage().c_str(), output.c_str())) {
+    if (MqttJson::publish(mqttClient, getTopicImage().c_str(), doc)) {
         mqttPublishCount++;
     }
 
@@ -2018,6 +2132,7 @@ void captureAndPublish() {
 }
 
 void captureAndPublishWithImage() {
+    LOOP_PROFILE_REGION("capture_publish_image");
     Serial.printf("[CAPTURE] Starting image capture with base64 (manual=%s)...\n",
                   flashManualOn ? "ON" : "OFF");
 
@@ -2048,8 +2163,17 @@ void captureAndPublishWithImage() {
     // Save to SD card if available
     saveImageToSD(fb, "full");
 
-    // Encode to base64
-    String base64Image = base64::encode(fb->buf, fb->len);
+    // Encode to base64 into a frame pool block
+    size_t base64Size = (fb->len + 2) / 3 * 4 + 1;  // Including the terminator
+    size_t base64Len = 0;
+    char* base64Image = (char*)FramePool::alloc(base64Size);
+    if (!base64Image || mbedtls_base64_encode((unsigned char*)base64Image, base64Size, &base64Len,
+                                              fb->buf, fb->len) != 0) {
+        Serial.println("[CAPTURE] No frame pool block for base64 image");
+        FramePool::release(base64Image);
+        returnFrameBuffer(fb);
+        return;
+    }
     
     // Publish metadata + base64 image
     // Note: Large images may exceed MQTT packet size limits
@@ -2060,21 +2184,20 @@ void captureAndPublishWithImage() {
     doc["width"] = fb->width;
     doc["height"] = fb->height;
     doc["format"] = "JPEG";
-    doc["image"] = base64Image;
-
-    String output;
-    serializeJson(doc, output);
 
-    Serial.printf("Publishing image with base64 (%d bytes JSON)\n", output.length());
+    Serial.printf("Publishing image with base64 (%u bytes JSON + %u bytes image)\n",
+                  (unsigned int)measureJson(doc), (unsigned int)base64Len);
     
-    // Publish to separate topic for images with data
-    if (mqttClient.publish("surveillance/image/full", output.c_str())) {
+    // Publish to separate topic for images with data (streamed, not limited by the MQTT buffer).
+    // The image is appended from the pool block, not copied into the document.
+    if (MqttJson::publish(mqttClient, "surveillance/image/full", doc, "image", base64Image, base64Len)) {
         mqttPublishCount++;
         Serial.println("Full image published to MQTT");
     } else {
-        Serial.println("Failed to publish full image (likely too large)");
+        Serial.println("Failed to publish full image (broker rejected or connection lost)");
     }
 
+    FramePool::release(base64Image);
     returnFrameBuffer(fb);
 }
 
@@ -2683,7 +2806,7 @@ void handleCapture(AsyncWebServerRequest *request) {
     bool saved = saveOrUploadImage(fb, "web_capture");
 
     // Copy the frame so we can safely return the original buffer immediately
-    uint8_t *copyBuf = (uint8_t*)malloc(fb->len);
+    uint8_t *copyBuf = (uint8_t*)FramePool::alloc(fb->len);
     size_t copyLen = fb->len;
     if (!copyBuf) {
         cameraErrors++;
@@ -2704,7 +2827,7 @@ void handleCapture(AsyncWebServerRequest *request) {
     response->addHeader("X-Saved", saved ? "true" : "false");
     response->addHeader("X-Storage", sftpEnabled ? (saved ? "sftp" : "sd_fallback") : "sd");
     request->onDisconnect([copyBuf]() {
-        free(copyBuf);
+        FramePool::release(copyBuf);
     });
     request->send(response);
 }
@@ -2815,6 +2938,8 @@ void handleControl(AsyncWebServerRequest *request) {
         request->send(500, "text/plain", "Failed to get camera sensor");
         return;
     }
+    // A powered-down sensor would drop the write, and wake-up restores the old value
+    CameraPower::ensureAwake();
 
     String var = request->getParam("var")->value();
     int val = request->getParam("val")->value().toInt();
@@ -2823,6 +2948,7 @@ void handleControl(AsyncWebServerRequest *request) {
 
     if (var == "framesize") {
         res = s->set_framesize(s, (framesize_t)val);
+        resizeFramePool();
     } else if (var == "quality") {
         res = s->set_quality(s, val);
     } else if (var == "brightness") {
@@ -2877,6 +3003,7 @@ void handleControl(AsyncWebServerRequest *request) {
         return;
     } else if (var == "reset") {
         resetCameraSettings();
+        resizeFramePool();
         res = 0;
     } else {
         request->send(400, "text/plain", "Unknown control parameter");
@@ -2913,16 +3040,58 @@ void publishMetricsToMQTT() {
     doc["capture_count"] = captureCount;
     doc["camera_errors"] = cameraErrors;
     doc["mqtt_publishes"] = mqttPublishCount;
-
-    String output;
-    serializeJson(doc, output);
-
-    if (!mqttClient.publish(getTopicMetrics().c_str(), output.c_str(), true)) {
+    doc["motion_tracks_born"] = MotionTracker::getTracksBorn();
+    doc["motion_alerts"] = MotionTracker::getAlerts();
+    doc["motion_suppressed"] = MotionTracker::getSuppressed();
+    doc["dedup_checked"] = FrameDedup::getChecked();
+    doc["dedup_skipped"] = FrameDedup::getDuplicates();
+    doc["dedup_hit_rate"] = FrameDedup::getHitRate();
+    doc["dedup_bytes_saved"] = FrameDedup::getBytesSaved();
+    doc["frame_pool_bytes"] = FramePool::getArenaBytes();
+    doc["frame_pool_failures"] = FramePool::getFailures();
+    doc["frame_pool_rebuilds"] = FramePool::getRebuilds();
+    for (uint8_t k = 0; k < FramePool::KIND_COUNT; k++) {
+        FramePool::Stats pool = FramePool::getStats((FramePool::Kind)k);
+        String prefix = String("frame_pool_") + FramePool::kindName((FramePool::Kind)k);
+        doc[prefix + "_high_water"] = pool.highWater;
+        doc[prefix + "_blocks"] = pool.blocks;
+    }
+    doc["classifier_runs"] = PersonClassifier::getClassified();
+    doc["classifier_skipped"] = PersonClassifier::getSkipped();
+
+    // Camera power-down: current is estimated from time asleep, trigger latency
+    // is PIR interrupt to first valid frame (bucket n counts latencies under 2^n ms)
+    doc["camera_asleep"] = CameraPower::isAsleep();
+    doc["camera_sleeps"] = CameraPower::getSleeps();
+    doc["camera_wakes"] = CameraPower::getWakes();
+    doc["camera_last_wake_ms"] = CameraPower::getLastWakeMs();
+    doc["camera_asleep_ratio"] = CameraPower::getAsleepRatio();
+    doc["camera_est_ma"] = CameraPower::getEstimatedMa();
+    doc["camera_trigger_ms_p50"] = CameraPower::getLatencyPercentileMs(50);
+    doc["camera_trigger_ms_p95"] = CameraPower::getLatencyPercentileMs(95);
+    doc["camera_trigger_ms_max"] = CameraPower::getLatencyMaxMs();
+    JsonArray triggerHistogram = doc["camera_trigger_histogram"].to<JsonArray>();
+    for (uint8_t i = 0; i < CameraPower::LATENCY_BUCKETS; i++) {
+        triggerHistogram.add(CameraPower::getLatencyHistogram()[i]);
+    }
+
+    // Loop latency histogram: bucket n counts iterations shorter than 2^n ms
+    doc["loop_iterations"] = LoopProfiler::getIterations();
+    doc["loop_max_ms"] = LoopProfiler::getMaxIterationMs();
+    doc["loop_stalls"] = LoopProfiler::getStallCount();
+    doc["loop_last_stall_region"] = LoopProfiler::getLastStallRegion();
+    doc["loop_last_stall_ms"] = LoopProfiler::getLastStallMs();
+    JsonArray loopHistogram = doc["loop_histogram"].to<JsonArray>();
+    for (uint8_t i = 0; i < LoopProfiler::HISTOGRAM_BUCKETS; i++) {
+        loopHistogram.add(LoopProfiler::getBucket(i));
+    }
+
+    if (!MqttJson::publish(mqttClient, getTopicMetrics().c_str(), doc, true)) {
         Serial.println("Failed to publish metrics to MQTT");
     }
 }
 
-void logEventToMQTT(const char* event, const char* severity) {
+void logEventToMQTT(const char* event, const char* severity, const char* message) {
     if (WiFi.status() != WL_CONNECTED || !mqttConnected) {
         return;
     }
@@ -2938,17 +3107,27 @@ void logEventToMQTT(const char* event, const char* severity) {
     doc["timestamp"] = millis() / 1000;
     doc["event"] = event;
     doc["severity"] = severity;
+    if (message) {
+        doc["message"] = message;
+    }
     doc["uptime"] = millis() / 1000;
     doc["free_heap"] = ESP.getFreeHeap();
 
-    String output;
-    serializeJson(doc, output);
-
-    if (!mqttClient.publish(getTopicEvents().c_str(), output.c_str(), false)) {
+    if (!MqttJson::publish(mqttClient, getTopicEvents().c_str(), doc, false)) {
         Serial.println("Failed to publish event to MQTT");
     }
 }
 
+// Report loop() stalls through the events topic (rate-limited by the profiler)
+void onLoopStall(const LoopProfiler::StallInfo& info) {
+    char message[128];
+    snprintf(message, sizeof(message), "Loop stalled %lu ms in %s (%lu ms), stalls: %lu, suppressed: %lu",
+             (unsigned long)info.durationMs, info.region, (unsigned long)info.regionMs,
+             (unsigned long)info.stallCount, (unsigned long)info.suppressed);
+    Serial.printf("[PROFILER] %s\n", message);
+    logEventToMQTT("loop_stall", "warning", message);
+}
+
 void handleMotionControl(AsyncWebServerRequest *request) {
     if (!request->hasParam("enabled")) {
         request->send(400, "text/plain", "Missing 'enabled' parameter");
@@ -1,5 +1,6 @@
 #include <Arduino.h>
 #include "camera_config.h"
+#include "camera_power.h"
 
 camera_config_t getCameraConfig() {
     camera_config_t config;
@@ -147,6 +148,8 @@ void resetCameraSettings() {
 }
 
 camera_fb_t* capturePhoto() {
+    // Sensor may be powered down between PIR events
+    CameraPower::ensureAwake();
     camera_fb_t * fb = esp_camera_fb_get();
     if (!fb) {
         Serial.println("Camera capture failed");
@@ -175,6 +178,7 @@ camera_fb_t* capturePhoto() {
     
     // Give camera sensor time to settle between frames (prevents tearing)
     delayMicroseconds(100);
+    CameraPower::frameCaptured();
     return fb;
 }
 
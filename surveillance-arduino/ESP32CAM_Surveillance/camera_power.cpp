@@ -0,0 +1,223 @@
+#include "camera_power.h"
+#include <driver/ledc.h>
+#include <esp_timer.h>
+
+namespace CameraPower {
+  static const uint16_t OV2640_COM2 = 0x100 | 0x09;   // Sensor bank, bit 4: standby
+  static const uint16_t OV3660_SYSTEM_CTROL0 = 0x3008; // Bit 6: software power-down (OV3660/OV5640)
+  static const uint32_t PWDN_SETTLE_MS = 5;            // PWDN low to first SCCB write
+
+  static Config s_config;
+  static bool s_started = false;
+  static bool s_asleep = false;
+  static SemaphoreHandle_t s_lock = NULL;              // Captures and controls run on the web task too
+  static camera_status_t s_cached;
+  static uint32_t s_lastActiveMs = 0;
+  static uint32_t s_beginMs = 0;
+  static uint32_t s_sleptAtMs = 0;
+  static uint64_t s_asleepMs = 0;
+  static uint32_t s_sleeps = 0;
+  static uint32_t s_wakes = 0;
+  static uint32_t s_lastWakeMs = 0;
+
+  static volatile bool s_triggered = false;
+  static volatile uint32_t s_triggerUs = 0;            // Low 32 bits of esp_timer, enough for a delta
+  static uint32_t s_histogram[LATENCY_BUCKETS] = {0};
+  static uint32_t s_samples = 0;
+  static uint32_t s_maxLatencyMs = 0;
+
+  static uint8_t bucketFor(uint32_t ms) {
+    if (ms == 0) {
+      return 0;
+    }
+    uint8_t bucket = 32 - __builtin_clz(ms);  // floor(log2(ms)) + 1
+    return bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1;
+  }
+
+  static int setStandby(sensor_t* s, bool standby) {
+    if (s->id.PID == OV2640_PID) {
+      return s->set_reg(s, OV2640_COM2, 0x10, standby ? 0x10 : 0x00);
+    }
+    return s->set_reg(s, OV3660_SYSTEM_CTROL0, 0x40, standby ? 0x40 : 0x00);
+  }
+
+  // Power-down may drop sensor registers; the driver's status is what the user set
+  static void restore(sensor_t* s, const camera_status_t& st) {
+    if (s->set_framesize) s->set_framesize(s, st.framesize);
+    if (s->set_quality) s->set_quality(s, st.quality);
+    if (s->set_brightness) s->set_brightness(s, st.brightness);
+    if (s->set_contrast) s->set_contrast(s, st.contrast);
+    if (s->set_saturation) s->set_saturation(s, st.saturation);
+    if (s->set_sharpness) s->set_sharpness(s, st.sharpness);
+    if (s->set_denoise) s->set_denoise(s, st.denoise);
+    if (s->set_special_effect) s->set_special_effect(s, st.special_effect);
+    if (s->set_wb_mode) s->set_wb_mode(s, st.wb_mode);
+    if (s->set_whitebal) s->set_whitebal(s, st.awb);
+    if (s->set_awb_gain) s->set_awb_gain(s, st.awb_gain);
+    if (s->set_exposure_ctrl) s->set_exposure_ctrl(s, st.aec);
+    if (s->set_aec2) s->set_aec2(s, st.aec2);
+    if (s->set_ae_level) s->set_ae_level(s, st.ae_level);
+    if (s->set_aec_value) s->set_aec_value(s, st.aec_value);
+    if (s->set_gain_ctrl) s->set_gain_ctrl(s, st.agc);
+    if (s->set_agc_gain) s->set_agc_gain(s, st.agc_gain);
+    if (s->set_gainceiling) s->set_gainceiling(s, (gainceiling_t)st.gainceiling);
+    if (s->set_bpc) s->set_bpc(s, st.bpc);
+    if (s->set_wpc) s->set_wpc(s, st.wpc);
+    if (s->set_raw_gma) s->set_raw_gma(s, st.raw_gma);
+    if (s->set_lenc) s->set_lenc(s, st.lenc);
+    if (s->set_hmirror) s->set_hmirror(s, st.hmirror);
+    if (s->set_vflip) s->set_vflip(s, st.vflip);
+    if (s->set_dcw) s->set_dcw(s, st.dcw);
+    if (s->set_colorbar) s->set_colorbar(s, st.colorbar);
+  }
+
+  void begin(const Config& config) {
+    s_config = config;
+    if (!s_lock) {
+      s_lock = xSemaphoreCreateMutex();
+    }
+    s_asleep = false;
+    s_beginMs = millis();
+    s_lastActiveMs = s_beginMs;
+    s_asleepMs = 0;
+    s_started = s_lock != NULL;
+  }
+
+  void loop(bool allowSleep) {
+    if (!s_started || s_asleep || !allowSleep) {
+      return;
+    }
+    if (millis() - s_lastActiveMs >= s_config.idleMs) {
+      sleep();
+    }
+  }
+
+  bool sleep() {
+    if (!s_started) {
+      return false;
+    }
+    sensor_t* s = esp_camera_sensor_get();
+    if (!s) {
+      return false;
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    if (s_asleep) {
+      xSemaphoreGive(s_lock);
+      return true;
+    }
+    s_cached = s->status;
+    if (s_config.pwdnPin >= 0) {
+      digitalWrite(s_config.pwdnPin, HIGH);
+    } else if (setStandby(s, true) != 0) {
+      xSemaphoreGive(s_lock);
+      return false;
+    }
+    // No XCLK, no frames: the driver's DMA idles until wake()
+    ledc_timer_pause(LEDC_LOW_SPEED_MODE, s_config.xclkTimer);
+    s_asleep = true;
+    s_sleptAtMs = millis();
+    s_sleeps++;
+    xSemaphoreGive(s_lock);
+    return true;
+  }
+
+  bool ensureAwake() {
+    if (!s_started) {
+      return true;
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_lastActiveMs = millis();
+    if (!s_asleep) {
+      xSemaphoreGive(s_lock);
+      return true;
+    }
+    uint32_t startUs = (uint32_t)esp_timer_get_time();
+    sensor_t* s = esp_camera_sensor_get();
+    ledc_timer_resume(LEDC_LOW_SPEED_MODE, s_config.xclkTimer);
+    if (s_config.pwdnPin >= 0) {
+      digitalWrite(s_config.pwdnPin, LOW);
+      delay(PWDN_SETTLE_MS);
+    } else if (s) {
+      setStandby(s, false);
+    }
+    if (s) {
+      restore(s, s_cached);
+    }
+    // Frames queued before sleep() and the first exposure after wake-up are stale
+    for (uint8_t i = 0; i < s_config.settleFrames; i++) {
+      camera_fb_t* fb = esp_camera_fb_get();
+      if (fb) {
+        esp_camera_fb_return(fb);
+      }
+    }
+    uint32_t nowMs = millis();
+    s_asleepMs += nowMs - s_sleptAtMs;
+    s_asleep = false;
+    s_wakes++;
+    s_lastWakeMs = ((uint32_t)esp_timer_get_time() - startUs) / 1000;
+    s_lastActiveMs = nowMs;
+    xSemaphoreGive(s_lock);
+    Serial.printf("[Camera] Woke from power-down in %lu ms\n", s_lastWakeMs);
+    return s != NULL;
+  }
+
+  bool isAsleep() { return s_asleep; }
+
+  void IRAM_ATTR markTrigger() {
+    if (!s_triggered) {
+      s_triggerUs = (uint32_t)esp_timer_get_time();
+      s_triggered = true;
+    }
+  }
+
+  void clearTrigger() {
+    s_triggered = false;
+  }
+
+  void frameCaptured() {
+    if (!s_triggered) {
+      return;
+    }
+    uint32_t latencyMs = ((uint32_t)esp_timer_get_time() - s_triggerUs) / 1000;
+    s_triggered = false;
+    s_histogram[bucketFor(latencyMs)]++;
+    s_samples++;
+    s_maxLatencyMs = max(s_maxLatencyMs, latencyMs);
+  }
+
+  uint32_t getSleeps() { return s_sleeps; }
+  uint32_t getWakes() { return s_wakes; }
+  const uint32_t* getLatencyHistogram() { return s_histogram; }
+  uint32_t getLatencyMaxMs() { return s_maxLatencyMs; }
+  uint32_t getLastWakeMs() { return s_lastWakeMs; }
+
+  uint32_t getLatencyPercentileMs(uint8_t percentile) {
+    if (s_samples == 0) {
+      return 0;
+    }
+    uint32_t rank = ((uint64_t)s_samples * percentile + 99) / 100;
+    uint32_t seen = 0;
+    for (uint8_t i = 0; i < LATENCY_BUCKETS - 1; i++) {
+      seen += s_histogram[i];
+      if (seen >= rank) {
+        return min(1UL << i, (unsigned long)s_maxLatencyMs);
+      }
+    }
+    return s_maxLatencyMs;
+  }
+
+  float getAsleepRatio() {
+    uint32_t nowMs = millis();
+    uint32_t elapsed = nowMs - s_beginMs;
+    if (!s_started || elapsed == 0) {
+      return 0.0f;
+    }
+    uint64_t asleep = s_asleepMs + (s_asleep ? nowMs - s_sleptAtMs : 0);
+    return (float)asleep / elapsed;
+  }
+
+  float getEstimatedMa() {
+    float ratio = getAsleepRatio();
+    return s_config.standbyMa * ratio + s_config.activeMa * (1.0f - ratio);
+  }
+}
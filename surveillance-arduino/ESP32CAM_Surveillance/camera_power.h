@@ -0,0 +1,63 @@
+#ifndef CAMERA_POWER_H
+#define CAMERA_POWER_H
+
+#include <Arduino.h>
+#include "esp_camera.h"
+
+/**
+ * @brief Camera sensor power-down between events.
+ *
+ * With nothing watching (PIR-gated mode, or camera motion detection off) the
+ * sensor otherwise streams into its frame buffers at full XCLK. sleep() caches
+ * the sensor settings, puts the sensor into power-down (PWDN pin, or the
+ * standby bit over SCCB on boards without one) and pauses the XCLK timer.
+ * Every capture goes through ensureAwake(): XCLK back on, sensor out of
+ * power-down, cached settings re-applied and settleFrames frames dropped (stale
+ * DMA buffers and the first exposure after wake-up).
+ *
+ * The PIR interrupt calls markTrigger(); the first frame captured afterwards
+ * closes a trigger-to-first-frame measurement, binned like the loop profiler
+ * (bucket 0 < 1 ms, bucket n in [2^(n-1), 2^n) ms). Idle current is an
+ * estimate from time asleep and the configured active/standby currents; the
+ * board has no current sensor.
+ */
+
+namespace CameraPower {
+  static const uint8_t LATENCY_BUCKETS = 12;         // Up to ~2 s, the last bucket collects the rest
+
+  struct Config {
+    int8_t pwdnPin = -1;               // -1: standby over SCCB
+    ledc_timer_t xclkTimer = LEDC_TIMER_0;
+    uint32_t idleMs = 15000;           // Sleep after this long without a capture
+    uint8_t settleFrames = 2;          // Frames dropped after wake-up
+    float activeMa = 40.0f;            // Sensor + XCLK while streaming
+    float standbyMa = 1.0f;
+  };
+
+  void begin(const Config& config);
+
+  /**
+   * @brief Call from loop(). Sleeps the sensor once it has been idle for
+   * idleMs, if allowed (nothing else needs a continuous stream).
+   */
+  void loop(bool allowSleep);
+
+  bool sleep();
+  bool ensureAwake();                   // Wakes if asleep; counts as activity either way
+  bool isAsleep();
+
+  void IRAM_ATTR markTrigger();         // From the PIR interrupt
+  void clearTrigger();                  // Trigger ignored (debounced), nothing to measure
+  void frameCaptured();                 // From the capture path, after a valid frame
+
+  uint32_t getSleeps();
+  uint32_t getWakes();
+  const uint32_t* getLatencyHistogram();
+  uint32_t getLatencyMaxMs();
+  uint32_t getLatencyPercentileMs(uint8_t percentile);   // Upper bucket bound, 0 without samples
+  uint32_t getLastWakeMs();             // Duration of the last ensureAwake() that woke the sensor
+  float getAsleepRatio();               // Since begin()
+  float getEstimatedMa();
+}
+
+#endif // CAMERA_POWER_H
@@ -0,0 +1,59 @@
+#ifndef FRAME_DEDUP_H
+#define FRAME_DEDUP_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Perceptual-hash deduplication of stored captures.
+ *
+ * A static scene produces long runs of near-identical JPEGs. Each capture is
+ * reduced to a 64-bit difference hash (dHash) of the 1/8-scale luma map the
+ * motion check uses (100x75 at SVGA): the map is averaged into 8 rows of 9
+ * columns, and each bit says whether a column is clearly (2 levels) brighter
+ * than its right neighbour.
+ * Brightness and sensor noise move few bits, but so does a person-sized
+ * object crossing a wide scene (2-6 bits). Only periodic captures and the
+ * repeat alerts of a known track are checked; a new track, PIR and manual
+ * captures are always stored (and become the reference).
+ *
+ * A capture within maxDistance bits of the last stored one is a duplicate and
+ * is not stored or uploaded; otherwise it becomes the new reference. One
+ * reference is stored at least every refreshMs so a static scene still has a
+ * recent picture. Hashing is one pass over the map, tens of microseconds.
+ */
+
+namespace FrameDedup {
+  static const uint16_t MAX_MAP_WIDTH = 200;  // UXGA / 8
+
+  struct Config {
+    uint8_t maxDistance = 6;         // Hamming distance (of 64 bits) that still counts as the same scene
+    uint32_t refreshMs = 600000;     // Store a reference at least this often
+  };
+
+  void begin(const Config& config);
+  void reset();
+
+  // Reads width x height bytes; maps wider than MAX_MAP_WIDTH hash their left part
+  uint64_t hash(const uint8_t* luma, uint16_t width, uint16_t height);
+  uint8_t distance(uint64_t a, uint64_t b);
+
+  /**
+   * @brief Decide whether a capture needs storing. Counts hits and the bytes
+   * they saved.
+   * @return true if the capture duplicates the reference and can be skipped
+   */
+  bool isDuplicate(uint64_t hash, size_t bytes, uint32_t nowMs);
+
+  /**
+   * @brief Make a capture stored without a check (an event capture) the
+   * reference. Not counted as checked.
+   */
+  void setReference(uint64_t hash, uint32_t nowMs);
+
+  uint32_t getChecked();
+  uint32_t getDuplicates();
+  uint64_t getBytesSaved();
+  float getHitRate();                // Duplicates / checked, 0 before the first check
+}
+
+#endif // FRAME_DEDUP_H
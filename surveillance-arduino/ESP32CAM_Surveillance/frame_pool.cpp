@@ -0,0 +1,238 @@
+#include "frame_pool.h"
+
+namespace FramePool {
+  static const size_t ALIGN = 32;             // PSRAM cache line
+  static const uint16_t CLASSIFIER_INPUT = 96;  // PersonClassifier::INPUT_SIZE
+
+  struct SizeClass {
+    uint8_t* base;
+    size_t blockSize;
+    uint8_t blocks;
+    uint8_t freeStack[MAX_BLOCKS];
+    uint8_t freeCount;
+    bool used[MAX_BLOCKS];
+    Stats stats;
+  };
+
+  static Config s_config;
+  static SizeClass s_classes[KIND_COUNT];     // In Kind order
+  static uint8_t s_bySize[KIND_COUNT];        // Class indices by ascending block size
+  static uint8_t* s_arena = nullptr;
+  static size_t s_arenaBytes = 0;
+  static uint8_t s_outstanding = 0;
+  static bool s_pending = false;
+  static uint16_t s_pendingWidth = 0;
+  static uint16_t s_pendingHeight = 0;
+  static bool s_rebuilding = false;
+  static uint32_t s_rebuilds = 0;
+  static uint32_t s_unfitted = 0;              // Larger than every class, or during a rebuild
+
+  // Web handlers allocate from the async TCP task, the motion path from loop()
+  #ifndef NATIVE_HOST
+  static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+  #define POOL_LOCK() portENTER_CRITICAL(&s_lock)
+  #define POOL_UNLOCK() portEXIT_CRITICAL(&s_lock)
+  #else
+  #define POOL_LOCK()
+  #define POOL_UNLOCK()
+  #endif
+
+  static size_t aligned(size_t bytes) {
+    return (bytes + ALIGN - 1) / ALIGN * ALIGN;
+  }
+
+  // Called with s_rebuilding set and no blocks out; allocates outside the lock
+  static bool rebuild(uint16_t width, uint16_t height) {
+    size_t jpeg = (size_t)width * height / 5;
+    size_t luma = max((size_t)(width / 8) * (height / 8), (size_t)CLASSIFIER_INPUT * CLASSIFIER_INPUT);
+    size_t sizes[KIND_COUNT] = {
+      luma,
+      max(luma * 2, (size_t)(width / 4) * (height / 4) * 2),
+      jpeg,
+      (jpeg + 2) / 3 * 4 + 1,
+    };
+    uint8_t counts[KIND_COUNT] = {
+      s_config.lumaBlocks, s_config.decodeBlocks, s_config.jpegBlocks, s_config.textBlocks
+    };
+
+    size_t total = 0;
+    for (uint8_t k = 0; k < KIND_COUNT; k++) {
+      counts[k] = min(counts[k], MAX_BLOCKS);
+      total += aligned(sizes[k]) * counts[k];
+    }
+    free(s_arena);
+    #ifdef BOARD_HAS_PSRAM
+    s_arena = (uint8_t*)ps_malloc(total + ALIGN);
+    #else
+    s_arena = (uint8_t*)malloc(total + ALIGN);
+    #endif
+    s_arenaBytes = s_arena ? total : 0;
+
+    uint8_t* next = s_arena ? (uint8_t*)aligned((uintptr_t)s_arena) : nullptr;
+    for (uint8_t k = 0; k < KIND_COUNT; k++) {
+      SizeClass& sizeClass = s_classes[k];
+      Stats previous = sizeClass.stats;
+      sizeClass.base = next;
+      sizeClass.blockSize = aligned(sizes[k]);
+      sizeClass.blocks = next ? counts[k] : 0;
+      sizeClass.freeCount = sizeClass.blocks;
+      for (uint8_t b = 0; b < sizeClass.blocks; b++) {
+        sizeClass.freeStack[b] = sizeClass.blocks - 1 - b;   // Block 0 on top
+        sizeClass.used[b] = false;
+      }
+      // Counters and high-water marks survive a rebuild
+      sizeClass.stats = previous;
+      sizeClass.stats.blockSize = sizeClass.blockSize;
+      sizeClass.stats.blocks = sizeClass.blocks;
+      sizeClass.stats.inUse = 0;
+      if (next) {
+        next += sizeClass.blockSize * sizeClass.blocks;
+      }
+    }
+    // jpeg blocks are smaller than decode blocks below QVGA
+    for (uint8_t i = 0; i < KIND_COUNT; i++) {
+      uint8_t k = i;
+      while (k > 0 && s_classes[s_bySize[k - 1]].blockSize > s_classes[i].blockSize) {
+        s_bySize[k] = s_bySize[k - 1];
+        k--;
+      }
+      s_bySize[k] = i;
+    }
+
+    POOL_LOCK();
+    s_rebuilds++;
+    s_rebuilding = false;
+    // A resize() that arrived during the rebuild still applies
+    bool again = s_pending;
+    s_pending = false;
+    if (again) {
+      s_rebuilding = true;
+    }
+    POOL_UNLOCK();
+    return again ? rebuild(s_pendingWidth, s_pendingHeight) : s_arena != nullptr;
+  }
+
+  bool begin(const Config& config, uint16_t width, uint16_t height) {
+    s_config = config;
+    s_outstanding = 0;
+    s_pending = false;
+    s_rebuilding = true;
+    s_unfitted = 0;
+    for (uint8_t k = 0; k < KIND_COUNT; k++) {
+      s_classes[k].stats = Stats();
+    }
+    bool built = rebuild(width, height);
+    s_rebuilds = 0;
+    return built;
+  }
+
+  bool resize(uint16_t width, uint16_t height) {
+    POOL_LOCK();
+    if (s_outstanding > 0 || s_rebuilding) {
+      s_pending = true;
+      s_pendingWidth = width;
+      s_pendingHeight = height;
+      POOL_UNLOCK();
+      return false;
+    }
+    s_rebuilding = true;
+    POOL_UNLOCK();
+    return rebuild(width, height);
+  }
+
+  void* alloc(size_t bytes) {
+    if (bytes == 0) {
+      return nullptr;
+    }
+    POOL_LOCK();
+    if (s_rebuilding) {
+      s_unfitted++;
+      POOL_UNLOCK();
+      return nullptr;
+    }
+    SizeClass* fitting = nullptr;
+    for (uint8_t i = 0; i < KIND_COUNT; i++) {
+      SizeClass& sizeClass = s_classes[s_bySize[i]];
+      if (sizeClass.blockSize < bytes || sizeClass.blocks == 0) {
+        continue;
+      }
+      if (!fitting) {
+        fitting = &sizeClass;
+      }
+      if (sizeClass.freeCount == 0) {
+        continue;
+      }
+      uint8_t block = sizeClass.freeStack[--sizeClass.freeCount];
+      sizeClass.used[block] = true;
+      sizeClass.stats.allocs++;
+      sizeClass.stats.inUse++;
+      sizeClass.stats.highWater = max(sizeClass.stats.highWater, sizeClass.stats.inUse);
+      s_outstanding++;
+      POOL_UNLOCK();
+      return sizeClass.base + (size_t)block * sizeClass.blockSize;
+    }
+    if (fitting) {
+      fitting->stats.failures++;
+    } else {
+      s_unfitted++;
+    }
+    POOL_UNLOCK();
+    return nullptr;
+  }
+
+  void release(void* pointer) {
+    uint8_t* block = (uint8_t*)pointer;
+    if (!block) {
+      return;
+    }
+    bool rebuildNow = false;
+    POOL_LOCK();
+    for (uint8_t k = 0; k < KIND_COUNT; k++) {
+      SizeClass& sizeClass = s_classes[k];
+      if (block < sizeClass.base || block >= sizeClass.base + sizeClass.blockSize * sizeClass.blocks) {
+        continue;
+      }
+      uint8_t index = (block - sizeClass.base) / sizeClass.blockSize;
+      if (sizeClass.used[index]) {
+        sizeClass.used[index] = false;
+        sizeClass.freeStack[sizeClass.freeCount++] = index;
+        sizeClass.stats.inUse--;
+        rebuildNow = --s_outstanding == 0 && s_pending;
+      }
+      break;
+    }
+    if (rebuildNow) {
+      s_pending = false;
+      s_rebuilding = true;
+    }
+    POOL_UNLOCK();
+    if (rebuildNow) {
+      rebuild(s_pendingWidth, s_pendingHeight);
+    }
+  }
+
+  Stats getStats(Kind kind) {
+    return s_classes[(uint8_t)kind].stats;
+  }
+
+  const char* kindName(Kind kind) {
+    switch (kind) {
+      case Kind::Luma: return "luma";
+      case Kind::Decode: return "decode";
+      case Kind::Jpeg: return "jpeg";
+      default: return "text";
+    }
+  }
+
+  size_t getArenaBytes() { return s_arenaBytes; }
+  uint32_t getRebuilds() { return s_rebuilds; }
+  bool isRebuildPending() { return s_pending; }
+
+  uint32_t getFailures() {
+    uint32_t failures = s_unfitted;
+    for (uint8_t k = 0; k < KIND_COUNT; k++) {
+      failures += s_classes[k].stats.failures;
+    }
+    return failures;
+  }
+}
@@ -0,0 +1,83 @@
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Slab allocator for frame-sized buffers in PSRAM.
+ *
+ * JPEG copies, decode buffers and base64 payloads come and go on every
+ * capture; served from the general heap they fragment it over days until a
+ * capture no longer finds a contiguous block. The pool carves one PSRAM arena
+ * into fixed blocks of four size classes derived from the frame size:
+ *
+ *   luma    1/8-scale 8-bit map (motion/dedup, 100x75 at SVGA), at least the
+ *           96x96 classifier input
+ *   decode  RGB565 decode at 1/4 scale, at least the 1/8 motion decode
+ *   jpeg    width * height / 5, the camera driver's own JPEG bound
+ *   text    base64 of a jpeg block
+ *
+ * alloc() takes the smallest class that fits and has a free block (a free
+ * stack per class, O(1)); release() finds the class by address. Nothing is
+ * split or merged, so the arena cannot fragment. A frame size change rebuilds
+ * the arena; while blocks are out the rebuild waits for the last release().
+ * alloc() and release() may be called from any task.
+ */
+
+namespace FramePool {
+  enum class Kind : uint8_t { Luma, Decode, Jpeg, Text };
+  static const uint8_t KIND_COUNT = 4;
+  static const uint8_t MAX_BLOCKS = 8;       // Per class
+
+  struct Config {
+    uint8_t lumaBlocks = 4;
+    uint8_t decodeBlocks = 2;
+    uint8_t jpegBlocks = 2;          // Web captures in flight
+    uint8_t textBlocks = 1;
+  };
+
+  struct Stats {
+    size_t blockSize;
+    uint8_t blocks;
+    uint8_t inUse;
+    uint8_t highWater;               // Most blocks in use at once since begin()
+    uint32_t allocs;
+    uint32_t failures;               // Requests this class fitted but had no free block
+  };
+
+  bool begin(const Config& config, uint16_t width, uint16_t height);
+
+  /**
+   * @brief Resize the classes for a new frame size.
+   * @return true if rebuilt now, false if deferred until all blocks are back
+   * (or the arena could not be allocated)
+   */
+  bool resize(uint16_t width, uint16_t height);
+
+  void* alloc(size_t bytes);           // nullptr for 0 bytes, or if no class fits or all fitting ones are full
+  void release(void* block);           // nullptr and foreign pointers are ignored
+
+  /**
+   * @brief RAII block for buffers that live within one function.
+   */
+  class Buffer {
+  public:
+    explicit Buffer(size_t bytes) : _data((uint8_t*)alloc(bytes)) {}
+    ~Buffer() { release(_data); }
+    Buffer(const Buffer&) = delete;
+    Buffer& operator=(const Buffer&) = delete;
+    uint8_t* data() const { return _data; }
+    explicit operator bool() const { return _data != nullptr; }
+  private:
+    uint8_t* _data;
+  };
+
+  Stats getStats(Kind kind);
+  const char* kindName(Kind kind);
+  size_t getArenaBytes();
+  uint32_t getRebuilds();
+  uint32_t getFailures();              // All classes, plus requests larger than any class
+  bool isRebuildPending();
+}
+
+#endif // FRAME_POOL_H
@@ -0,0 +1,293 @@
+#include "motion_tracker.h"
+#include <math.h>
+
+namespace MotionTracker {
+  static Config s_config;
+  static Track s_tracks[MAX_TRACKS];
+  static uint8_t s_trackCount = 0;
+  static uint16_t s_nextId = 1;
+  static uint32_t s_tracksBorn = 0;
+  static uint32_t s_alerts = 0;
+  static uint32_t s_suppressed = 0;
+  static uint16_t s_mapWidth = 0;
+  static uint16_t s_mapHeight = 0;
+  static uint8_t s_gridWidth = 0;
+  static uint8_t s_gridHeight = 0;
+
+  void begin(const Config& config) {
+    s_config = config;
+    reset();
+  }
+
+  void reset() {
+    s_trackCount = 0;
+    s_nextId = 1;
+    s_tracksBorn = 0;
+    s_alerts = 0;
+    s_suppressed = 0;
+  }
+
+  // ============================================================================
+  // Blobs
+  // ============================================================================
+
+  // 8-connected components of the active cells, largest MAX_BLOBS kept
+  static uint8_t findBlobs(const uint8_t* cellCounts, Blob* blobs) {
+    bool visited[MAX_CELLS] = {};
+    uint16_t stack[MAX_CELLS];
+    uint8_t count = 0;
+    uint16_t cellCount = s_gridWidth * s_gridHeight;
+
+    for (uint16_t seed = 0; seed < cellCount; seed++) {
+      if (visited[seed] || cellCounts[seed] < s_config.cellPixels) {
+        continue;
+      }
+      Blob blob = {s_gridWidth, s_gridHeight, 0, 0, 0, 0, 0};
+      uint32_t weight = 0;
+      uint32_t sumX = 0;
+      uint32_t sumY = 0;
+      uint16_t top = 0;
+      stack[top++] = seed;
+      visited[seed] = true;
+      while (top > 0) {
+        uint16_t cell = stack[--top];
+        uint8_t x = cell % s_gridWidth;
+        uint8_t y = cell / s_gridWidth;
+        blob.x0 = min(blob.x0, x);
+        blob.y0 = min(blob.y0, y);
+        blob.x1 = max(blob.x1, x);
+        blob.y1 = max(blob.y1, y);
+        blob.cells++;
+        weight += cellCounts[cell];
+        sumX += cellCounts[cell] * (x * CELL_SIZE + CELL_SIZE / 2);
+        sumY += cellCounts[cell] * (y * CELL_SIZE + CELL_SIZE / 2);
+        for (int8_t dy = -1; dy <= 1; dy++) {
+          for (int8_t dx = -1; dx <= 1; dx++) {
+            int8_t nx = x + dx;
+            int8_t ny = y + dy;
+            if (nx < 0 || ny < 0 || nx >= s_gridWidth || ny >= s_gridHeight) {
+              continue;
+            }
+            uint16_t next = ny * s_gridWidth + nx;
+            if (!visited[next] && cellCounts[next] >= s_config.cellPixels) {
+              visited[next] = true;
+              stack[top++] = next;
+            }
+          }
+        }
+      }
+      if (blob.cells < s_config.minBlobCells) {
+        continue;
+      }
+      blob.cx = (float)sumX / weight;
+      blob.cy = (float)sumY / weight;
+      blob.x0 *= CELL_SIZE;
+      blob.y0 *= CELL_SIZE;
+      blob.x1 = min(blob.x1 * CELL_SIZE + CELL_SIZE - 1, s_mapWidth - 1);   // Last cell may be partial
+      blob.y1 = min(blob.y1 * CELL_SIZE + CELL_SIZE - 1, s_mapHeight - 1);
+
+      // Insertion by size; the smallest falls off when full
+      uint8_t pos = count < MAX_BLOBS ? count++ : MAX_BLOBS;
+      if (pos == MAX_BLOBS) {
+        if (blob.cells <= blobs[MAX_BLOBS - 1].cells) {
+          continue;
+        }
+        pos = MAX_BLOBS - 1;
+      }
+      while (pos > 0 && blobs[pos - 1].cells < blob.cells) {
+        blobs[pos] = blobs[pos - 1];
+        pos--;
+      }
+      blobs[pos] = blob;
+    }
+    return count;
+  }
+
+  static float area(const Blob& blob) {
+    return (float)(blob.x1 - blob.x0 + 1) * (blob.y1 - blob.y0 + 1);
+  }
+
+  static float intersection(const Blob& a, const Blob& b) {
+    int ix = min(a.x1, b.x1) - max(a.x0, b.x0) + 1;
+    int iy = min(a.y1, b.y1) - max(a.y0, b.y0) + 1;
+    return ix > 0 && iy > 0 ? (float)ix * iy : 0.0f;
+  }
+
+  static float iou(const Blob& a, const Blob& b) {
+    float overlap = intersection(a, b);
+    return overlap / (area(a) + area(b) - overlap);
+  }
+
+  // Share of a that lies inside b
+  static float insideFraction(const Blob& a, const Blob& b) {
+    return intersection(a, b) / area(a);
+  }
+
+  // > 1 for overlapping boxes (by IoU), (0, 1] for nearby centroids, 0 = no match
+  static float matchScore(const Track& track, const Blob& blob) {
+    float overlap = iou(track.box, blob);
+    if (overlap >= s_config.minIou) {
+      return 1.0f + overlap;
+    }
+    float distance = hypotf(track.box.cx - blob.cx, track.box.cy - blob.cy);
+    return distance <= s_config.maxMatchDistancePx ? 1.0f - distance / (s_config.maxMatchDistancePx + 1.0f) : 0.0f;
+  }
+
+  // ============================================================================
+  // Tracks
+  // ============================================================================
+
+  Result update(const uint8_t* cellCounts, uint16_t mapWidth, uint16_t mapHeight, uint32_t nowMs) {
+    mapWidth = min(mapWidth, MAX_MAP_WIDTH);
+    mapHeight = min(mapHeight, MAX_MAP_HEIGHT);
+    if (mapWidth != s_mapWidth || mapHeight != s_mapHeight) {
+      s_mapWidth = mapWidth;
+      s_mapHeight = mapHeight;
+      s_gridWidth = gridSize(mapWidth);
+      s_gridHeight = gridSize(mapHeight);
+      s_trackCount = 0;
+    }
+
+    Blob blobs[MAX_BLOBS];
+    uint8_t blobCount = cellCounts ? findBlobs(cellCounts, blobs) : 0;
+
+    // Greedy association, best pair first
+    int8_t blobTrack[MAX_BLOBS];
+    bool trackMatched[MAX_TRACKS] = {};
+    for (uint8_t b = 0; b < blobCount; b++) {
+      blobTrack[b] = -1;
+    }
+    while (true) {
+      float best = 0.0f;
+      int8_t bestBlob = -1;
+      int8_t bestTrack = -1;
+      for (uint8_t b = 0; b < blobCount; b++) {
+        if (blobTrack[b] >= 0) {
+          continue;
+        }
+        for (uint8_t t = 0; t < s_trackCount; t++) {
+          if (trackMatched[t]) {
+            continue;
+          }
+          float score = matchScore(s_tracks[t], blobs[b]);
+          if (score > best) {
+            best = score;
+            bestBlob = b;
+            bestTrack = t;
+          }
+        }
+      }
+      if (bestBlob < 0) {
+        break;
+      }
+      blobTrack[bestBlob] = bestTrack;
+      trackMatched[bestTrack] = true;
+    }
+
+    Event event = Event::None;
+    uint16_t eventTrackId = 0;
+    uint16_t eventCells = 0;
+    auto raise = [&](Event candidate, const Track& track) {
+      // Birth outranks movement; within a kind, the larger blob wins
+      if (candidate > event || (candidate == event && track.box.cells > eventCells)) {
+        event = candidate;
+        eventTrackId = track.id;
+        eventCells = track.box.cells;
+      }
+    };
+
+    for (uint8_t b = 0; b < blobCount; b++) {
+      if (blobTrack[b] < 0) {
+        continue;
+      }
+      Track& track = s_tracks[blobTrack[b]];
+      uint32_t dt = nowMs - track.lastSeenMs;
+      if (dt > 0) {
+        float vx = (blobs[b].cx - track.box.cx) * 1000.0f / dt;
+        float vy = (blobs[b].cy - track.box.cy) * 1000.0f / dt;
+        bool first = track.hits == 1;
+        track.vx = first ? vx : 0.5f * track.vx + 0.5f * vx;
+        track.vy = first ? vy : 0.5f * track.vy + 0.5f * vy;
+      }
+      track.box = blobs[b];
+      track.lastSeenMs = nowMs;
+      track.hits++;
+      track.misses = 0;
+      // Flicker at the edges of a still object shifts the centroid but stays inside its box
+      if (hypotf(track.box.cx - track.alertBox.cx, track.box.cy - track.alertBox.cy) > s_config.moveThresholdPx
+          && insideFraction(track.box, track.alertBox) < 0.5f) {
+        track.alertBox = track.box;
+        raise(Event::Moved, track);
+      }
+    }
+
+    // Age out unmatched tracks (compacting keeps the array dense)
+    uint8_t kept = 0;
+    for (uint8_t t = 0; t < s_trackCount; t++) {
+      if (!trackMatched[t] && ++s_tracks[t].misses > s_config.maxMisses) {
+        continue;
+      }
+      s_tracks[kept++] = s_tracks[t];
+    }
+    s_trackCount = kept;
+
+    for (uint8_t b = 0; b < blobCount && s_trackCount < MAX_TRACKS; b++) {
+      if (blobTrack[b] >= 0) {
+        continue;
+      }
+      // A second piece of a known object (e.g. both edges of a jittering shadow) is not a new one
+      bool absorbed = false;
+      for (uint8_t t = 0; t < s_trackCount && !absorbed; t++) {
+        if (insideFraction(blobs[b], s_tracks[t].alertBox) >= 0.5f) {
+          s_tracks[t].misses = 0;
+          absorbed = true;
+        }
+      }
+      if (absorbed) {
+        continue;
+      }
+      Track& track = s_tracks[s_trackCount++];
+      track.id = s_nextId++;
+      track.box = blobs[b];
+      track.vx = 0.0f;
+      track.vy = 0.0f;
+      track.bornMs = nowMs;
+      track.lastSeenMs = nowMs;
+      track.hits = 1;
+      track.misses = 0;
+      track.alertBox = blobs[b];
+      s_tracksBorn++;
+      raise(Event::Birth, track);
+    }
+
+    Result result = {event, nullptr, blobCount, s_trackCount};
+    for (uint8_t t = 0; t < s_trackCount && event != Event::None; t++) {
+      if (s_tracks[t].id == eventTrackId) {
+        result.track = &s_tracks[t];
+      }
+    }
+    if (event != Event::None) {
+      s_alerts++;
+    } else if (blobCount > 0) {
+      s_suppressed++;
+    }
+    return result;
+  }
+
+  const Track* getTracks(uint8_t& count) {
+    count = s_trackCount;
+    return s_tracks;
+  }
+
+  const char* eventName(Event event) {
+    switch (event) {
+      case Event::Birth: return "birth";
+      case Event::Moved: return "moved";
+      default: return "none";
+    }
+  }
+
+  uint32_t getTracksBorn() { return s_tracksBorn; }
+  uint32_t getAlerts() { return s_alerts; }
+  uint32_t getSuppressed() { return s_suppressed; }
+}
@@ -0,0 +1,101 @@
+#ifndef MOTION_TRACKER_H
+#define MOTION_TRACKER_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Multi-object tracker on top of the camera motion check.
+ *
+ * The motion check diffs a luma map (the frame decoded at 1/8 scale, e.g.
+ * 100x75 at SVGA) against the previous one. Changed pixels are counted per
+ * 8x8 cell; cells with enough changed pixels are grouped into blobs
+ * (8-connected), and blobs are associated with the tracks of the previous
+ * checks by bounding-box IoU, falling back to centroid distance. Each track carries its age, hit count and a smoothed velocity.
+ *
+ * Only two things raise an alert: a new track (birth) and a track that moved
+ * more than moveThresholdPx and mostly out of its box since its last alert.
+ * A parked car with a flickering shadow keeps matching the same track and
+ * stays quiet; tracks survive maxMisses checks without a blob so flicker does
+ * not re-birth them. Costs one pass over the cells (130 at SVGA) and at most
+ * MAX_BLOBS x MAX_TRACKS IoUs. A change of map size (a new frame size)
+ * drops the tracks, whose boxes are in the old map's pixels.
+ */
+
+namespace MotionTracker {
+  static const uint16_t MAX_MAP_WIDTH = 200;         // UXGA / 8
+  static const uint16_t MAX_MAP_HEIGHT = 150;
+  static const uint8_t CELL_SIZE = 8;
+  static const uint8_t MAX_GRID_WIDTH = (MAX_MAP_WIDTH + CELL_SIZE - 1) / CELL_SIZE;
+  static const uint8_t MAX_GRID_HEIGHT = (MAX_MAP_HEIGHT + CELL_SIZE - 1) / CELL_SIZE;
+  static const uint16_t MAX_CELLS = MAX_GRID_WIDTH * MAX_GRID_HEIGHT;
+  static const uint8_t MAX_BLOBS = 8;                // Largest blobs kept per check
+  static const uint8_t MAX_TRACKS = 8;
+
+  struct Config {
+    uint8_t cellPixels = 6;            // Changed pixels (of 64) that make a cell active
+    uint8_t minBlobCells = 2;          // Single cells are mostly rain and sensor noise
+    uint8_t maxMisses = 5;             // Checks a track survives without a matching blob
+    float minIou = 0.1f;
+    float maxMatchDistancePx = 24.0f;  // Centroid fallback when boxes do not overlap
+    float moveThresholdPx = 16.0f;     // Centroid travel since the last alert that alerts again,
+                                       // with most of the blob outside the box of that alert
+  };
+
+  // Bounding box and centroid in luma map pixels
+  struct Blob {
+    uint8_t x0, y0, x1, y1;            // Inclusive
+    uint16_t cells;
+    float cx, cy;
+  };
+
+  struct Track {
+    uint16_t id;
+    Blob box;
+    float vx, vy;                      // Smoothed centroid velocity, px/s
+    uint32_t bornMs;
+    uint32_t lastSeenMs;
+    uint16_t hits;                     // Checks with a matching blob
+    uint8_t misses;                    // Consecutive checks without one
+    Blob alertBox;                     // Box at birth or the last movement alert
+  };
+
+  enum class Event : uint8_t { None, Birth, Moved };
+
+  struct Result {
+    Event event;                       // Most significant alert of this check
+    const Track* track;                // Track that raised it (valid until the next update)
+    uint8_t blobs;
+    uint8_t tracks;
+  };
+
+  void begin(const Config& config);
+  void reset();
+
+  // Cells across a map dimension; the last one may be partial (75 rows -> 10 cells)
+  inline uint8_t gridSize(uint16_t mapPixels) {
+    return (mapPixels + CELL_SIZE - 1) / CELL_SIZE;
+  }
+
+  // Cell of luma pixel (x, y); the motion check counts changed pixels per cell
+  inline uint16_t cellIndex(uint16_t x, uint16_t y, uint16_t mapWidth) {
+    return (y / CELL_SIZE) * gridSize(mapWidth) + x / CELL_SIZE;
+  }
+
+  /**
+   * @brief Feed one motion check. Call for every check, also without motion
+   * (cellCounts all zero), so tracks age out.
+   * @param cellCounts gridSize(mapWidth) x gridSize(mapHeight) changed-pixel
+   *        counts, or nullptr for no motion
+   * @param mapWidth, mapHeight Luma map size, at most MAX_MAP_WIDTH x MAX_MAP_HEIGHT
+   */
+  Result update(const uint8_t* cellCounts, uint16_t mapWidth, uint16_t mapHeight, uint32_t nowMs);
+
+  const Track* getTracks(uint8_t& count);
+  const char* eventName(Event event);
+
+  uint32_t getTracksBorn();
+  uint32_t getAlerts();
+  uint32_t getSuppressed();           // Checks with blobs that raised no alert
+}
+
+#endif // MOTION_TRACKER_H
@@ -0,0 +1,126 @@
+#include "mqtt_json.h"
+
+namespace MqttJson {
+    static uint32_t s_maxPayloadBytes = 0;
+    static uint32_t s_lastPublishUs = 0;
+    static uint32_t s_maxPublishUs = 0;
+    static uint32_t s_failures = 0;
+
+    // ArduinoJson writes one character at a time; collect them so each
+    // client write (a TCP send on the device) carries a full chunk
+    class ChunkedPrint : public Print {
+    public:
+        explicit ChunkedPrint(PubSubClient& client) : _client(client) {}
+
+        size_t write(uint8_t c) override {
+            _buffer[_length++] = c;
+            if (_length == sizeof(_buffer)) {
+                sendChunk();
+            }
+            return 1;
+        }
+
+        size_t write(const uint8_t* data, size_t size) override {
+            if (size >= sizeof(_buffer)) {
+                // Large caller-owned buffers go to the client without copying
+                sendChunk();
+                _sent += _client.write(data, size);
+                return size;
+            }
+            for (size_t i = 0; i < size; i++) {
+                write(data[i]);
+            }
+            return size;
+        }
+
+        void sendChunk() {
+            if (_length > 0) {
+                _sent += _client.write(_buffer, _length);
+                _length = 0;
+            }
+        }
+
+        size_t sent() const { return _sent; }
+
+    private:
+        PubSubClient& _client;
+        uint8_t _buffer[MQTT_JSON_CHUNK_SIZE];
+        size_t _length = 0;
+        size_t _sent = 0;
+    };
+
+    // Serializes doc without its closing brace
+    class OpenObjectPrint : public Print {
+    public:
+        OpenObjectPrint(Print& out, size_t length) : _out(out), _remaining(length - 1) {}
+
+        size_t write(uint8_t c) override {
+            if (_remaining == 0) {
+                return 1;
+            }
+            _remaining--;
+            return _out.write(c);
+        }
+
+    private:
+        Print& _out;
+        size_t _remaining;
+    };
+
+    static bool finish(bool ok, size_t length, uint32_t start) {
+        s_lastPublishUs = micros() - start;
+        if (ok) {
+            s_maxPayloadBytes = max(s_maxPayloadBytes, (uint32_t)length);
+            s_maxPublishUs = max(s_maxPublishUs, s_lastPublishUs);
+        } else {
+            s_failures++;
+        }
+        return ok;
+    }
+
+    bool publish(PubSubClient& client, const char* topic, const JsonDocument& doc, bool retain) {
+        uint32_t start = micros();
+        size_t length = measureJson(doc);
+
+        bool ok = client.beginPublish(topic, length, retain);
+        if (ok) {
+            ChunkedPrint out(client);
+            serializeJson(doc, out);
+            out.sendChunk();
+            // A short write leaves a truncated packet on the wire; the broker drops
+            // the connection and the normal reconnect path takes over
+            ok = client.endPublish() && out.sent() == length;
+        }
+        return finish(ok, length, start);
+    }
+
+    bool publish(PubSubClient& client, const char* topic, const JsonDocument& doc,
+                 const char* key, const char* value, size_t valueLength, bool retain) {
+        uint32_t start = micros();
+        size_t docLength = measureJson(doc);
+        bool first = docLength <= 2;            // "{}": no comma before the field
+        size_t keyLength = strlen(key);
+        // {...  ,"key":"value"}
+        size_t length = docLength - 1 + (first ? 0 : 1) + keyLength + valueLength + 6;
+
+        bool ok = client.beginPublish(topic, length, retain);
+        if (ok) {
+            ChunkedPrint out(client);
+            OpenObjectPrint open(out, docLength);
+            serializeJson(doc, open);
+            out.print(first ? "\"" : ",\"");
+            out.write((const uint8_t*)key, keyLength);
+            out.print("\":\"");
+            out.write((const uint8_t*)value, valueLength);
+            out.print("\"}");
+            out.sendChunk();
+            ok = client.endPublish() && out.sent() == length;
+        }
+        return finish(ok, length, start);
+    }
+
+    uint32_t getMaxPayloadBytes() { return s_maxPayloadBytes; }
+    uint32_t getLastPublishUs() { return s_lastPublishUs; }
+    uint32_t getMaxPublishUs() { return s_maxPublishUs; }
+    uint32_t getFailures() { return s_failures; }
+}
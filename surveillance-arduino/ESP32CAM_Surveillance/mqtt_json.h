@@ -0,0 +1,47 @@
+#ifndef MQTT_JSON_H
+#define MQTT_JSON_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <PubSubClient.h>
+
+/**
+ * @brief Publish an ArduinoJson document without an intermediate String.
+ *
+ * The payload length comes from measureJson(), the MQTT header is sent with
+ * beginPublish() and the document is serialized straight into the client
+ * through a small chunk buffer. The payload never has to fit PubSubClient's
+ * buffer (setBufferSize), which only needs room for the topic and inbound
+ * commands; the size limit is the broker's.
+ */
+
+// Serializer output is handed to the socket in chunks of this size
+#ifndef MQTT_JSON_CHUNK_SIZE
+#define MQTT_JSON_CHUNK_SIZE 128
+#endif
+
+namespace MqttJson {
+    /**
+     * @brief Serialize doc and publish it on topic.
+     * @return true if the whole payload was handed to the client
+     */
+    bool publish(PubSubClient& client, const char* topic, const JsonDocument& doc, bool retain = false);
+
+    /**
+     * @brief Publish doc (an object) with one more string field appended.
+     *
+     * The value is written from the caller's buffer straight into the client
+     * and never enters the document; ArduinoJson 7.3+ copies every const char*
+     * it is given, which for a base64 image means a second ~130 KB heap block.
+     * The value is written verbatim, so it must not need JSON escaping.
+     */
+    bool publish(PubSubClient& client, const char* topic, const JsonDocument& doc,
+                 const char* key, const char* value, size_t valueLength, bool retain = false);
+
+    uint32_t getMaxPayloadBytes();    // Largest payload published since boot
+    uint32_t getLastPublishUs();      // Duration of the last publish (measure + send)
+    uint32_t getMaxPublishUs();
+    uint32_t getFailures();           // Publishes rejected or cut short by the client
+}
+
+#endif // MQTT_JSON_H
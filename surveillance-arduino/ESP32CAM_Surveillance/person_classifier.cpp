@@ -0,0 +1,333 @@
+#include "person_classifier.h"
+#include <LittleFS.h>
+#include <math.h>
+
+namespace PersonClassifier {
+  /**
+   * Model file layout (little-endian):
+   *   "PCN1", float32 logit scale
+   *   per layer, in LAYERS order:
+   *     int8 weights  (conv: [out][3][3][in], depthwise: [3][3][ch], pointwise/dense: [out][in])
+   *     int32 bias[out], int32 multiplier[out] (Q31), int8 shift[out]
+   * Input pixels are gray - 128; activations after each ReLU layer are int8 in 0..127.
+   */
+  enum class Kind : uint8_t { Conv, Depthwise, Pointwise, Dense };
+
+  struct LayerSpec {
+    Kind kind;
+    uint8_t in;
+    uint8_t out;
+    uint8_t inSize;              // Input width and height (1 for the dense head)
+  };
+
+  static constexpr LayerSpec LAYERS[] = {
+    {Kind::Conv, 1, 8, 96},
+    {Kind::Depthwise, 8, 8, 48},
+    {Kind::Pointwise, 8, 16, 24},
+    {Kind::Depthwise, 16, 16, 24},
+    {Kind::Pointwise, 16, 32, 12},
+    {Kind::Depthwise, 32, 32, 12},
+    {Kind::Pointwise, 32, 64, 6},
+    {Kind::Dense, 64, CLASS_COUNT, 1},
+  };
+  static constexpr uint8_t LAYER_COUNT = sizeof(LAYERS) / sizeof(LAYERS[0]);
+
+  static constexpr size_t weightCount(const LayerSpec& layer) {
+    return layer.kind == Kind::Conv ? (size_t)layer.out * 9 * layer.in
+         : layer.kind == Kind::Depthwise ? (size_t)layer.out * 9
+         : (size_t)layer.out * layer.in;
+  }
+
+  static constexpr size_t totalWeights(uint8_t i = 0) {
+    return i == LAYER_COUNT ? 0 : weightCount(LAYERS[i]) + totalWeights(i + 1);
+  }
+
+  static constexpr size_t totalChannels(uint8_t i = 0) {
+    return i == LAYER_COUNT ? 0 : LAYERS[i].out + totalChannels(i + 1);
+  }
+
+  static const size_t HEADER_SIZE = 8;
+  const size_t MODEL_SIZE = HEADER_SIZE + totalWeights() + totalChannels() * 9;
+
+  // Largest activations: conv output 48x48x8 and the input / first pointwise output 96x96
+  static const size_t BUFFER_A_SIZE = 48 * 48 * 8;
+  static const size_t BUFFER_B_SIZE = 96 * 96;
+
+  static int8_t s_weights[totalWeights()];
+  static int32_t s_bias[totalChannels()];
+  static int32_t s_multiplier[totalChannels()];
+  static int8_t s_shift[totalChannels()];
+  static float s_logitScale = 0.0f;
+  static int8_t* s_bufferA = nullptr;
+  static int8_t* s_bufferB = nullptr;
+  static bool s_ready = false;
+  static uint32_t s_classified = 0;
+  static uint32_t s_skipped = 0;
+
+  // ============================================================================
+  // Loading
+  // ============================================================================
+
+  static int32_t readInt32(const uint8_t* data) {
+    return (int32_t)((uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16)
+                     | ((uint32_t)data[3] << 24));
+  }
+
+  bool load(const uint8_t* model, size_t size) {
+    s_ready = false;
+    if (size != MODEL_SIZE || memcmp(model, "PCN1", 4) != 0) {
+      return false;
+    }
+    memcpy(&s_logitScale, model + 4, sizeof(float));
+
+    const uint8_t* pos = model + HEADER_SIZE;
+    size_t weightOffset = 0;
+    size_t channelOffset = 0;
+    for (uint8_t i = 0; i < LAYER_COUNT; i++) {
+      size_t weights = weightCount(LAYERS[i]);
+      memcpy(s_weights + weightOffset, pos, weights);
+      pos += weights;
+      weightOffset += weights;
+      uint8_t out = LAYERS[i].out;
+      for (uint8_t c = 0; c < out; c++) {
+        s_bias[channelOffset + c] = readInt32(pos + c * 4);
+        s_multiplier[channelOffset + c] = readInt32(pos + out * 4 + c * 4);
+        s_shift[channelOffset + c] = (int8_t)pos[out * 8 + c];
+        if (s_shift[channelOffset + c] < -31 || s_shift[channelOffset + c] > 30) {
+          return false;
+        }
+      }
+      pos += out * 9;
+      channelOffset += out;
+    }
+
+    if (!s_bufferA) {
+      #ifdef BOARD_HAS_PSRAM
+      s_bufferA = (int8_t*)ps_malloc(BUFFER_A_SIZE);
+      s_bufferB = (int8_t*)ps_malloc(BUFFER_B_SIZE);
+      #else
+      s_bufferA = (int8_t*)malloc(BUFFER_A_SIZE);
+      s_bufferB = (int8_t*)malloc(BUFFER_B_SIZE);
+      #endif
+    }
+    s_ready = s_bufferA && s_bufferB;
+    return s_ready;
+  }
+
+  bool loadFile(const char* path) {
+    File file = LittleFS.open(path, "r");
+    if (!file) {
+      return false;
+    }
+    size_t size = file.size();
+    bool loaded = false;
+    uint8_t* model = size == MODEL_SIZE ? (uint8_t*)malloc(size) : nullptr;
+    if (model && file.read(model, size) == size) {
+      loaded = load(model, size);
+    }
+    free(model);
+    file.close();
+    return loaded;
+  }
+
+  bool isReady() {
+    return s_ready;
+  }
+
+  // ============================================================================
+  // Crop
+  // ============================================================================
+
+  template <typename Pixel, typename ToGray>
+  static void crop(const Pixel* image, uint16_t width, uint16_t height, uint16_t mapWidth, uint16_t mapHeight,
+                   uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t* input, ToGray toGray) {
+    // Square around the box center with half a cell of margin, in motion map units
+    float side = max(x1 - x0, y1 - y0) + 1 + 8;
+    float left = (x0 + x1 + 1) / 2.0f - side / 2;
+    float top = (y0 + y1 + 1) / 2.0f - side / 2;
+    float scaleX = (float)width / mapWidth;
+    float scaleY = (float)height / mapHeight;
+    float step = side / INPUT_SIZE;
+    for (uint8_t y = 0; y < INPUT_SIZE; y++) {
+      int sy = constrain((int)((top + (y + 0.5f) * step) * scaleY), 0, height - 1);
+      const Pixel* row = image + (size_t)sy * width;
+      for (uint8_t x = 0; x < INPUT_SIZE; x++) {
+        int sx = constrain((int)((left + (x + 0.5f) * step) * scaleX), 0, width - 1);
+        input[y * INPUT_SIZE + x] = toGray(row[sx]);
+      }
+    }
+  }
+
+  void cropGray(const uint8_t* image, uint16_t width, uint16_t height, uint16_t mapWidth, uint16_t mapHeight,
+                uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t* input) {
+    crop(image, width, height, mapWidth, mapHeight, x0, y0, x1, y1, input, [](uint8_t pixel) { return pixel; });
+  }
+
+  void cropRgb565(const uint16_t* image, uint16_t width, uint16_t height, uint16_t mapWidth, uint16_t mapHeight,
+                  uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t* input) {
+    // Same grayscale as the motion check
+    crop(image, width, height, mapWidth, mapHeight, x0, y0, x1, y1, input, [](uint16_t pixel) {
+      return (uint8_t)((((pixel >> 11) & 0x1F) * 8 + ((pixel >> 5) & 0x3F) * 4 + (pixel & 0x1F) * 8) / 3);
+    });
+  }
+
+  // ============================================================================
+  // Kernels
+  // ============================================================================
+
+  // Contiguous int8 dot product: pointwise layers and the dense head (SIMD candidate)
+  static inline int32_t dotS8(const int8_t* a, const int8_t* b, uint16_t n) {
+    int32_t sum = 0;
+    for (uint16_t i = 0; i < n; i++) {
+      sum += a[i] * b[i];
+    }
+    return sum;
+  }
+
+  // acc * multiplier * 2^(shift - 31), rounded half up
+  static inline int32_t requantize(int32_t acc, int32_t multiplier, int8_t shift) {
+    int64_t product = (int64_t)acc * multiplier;
+    int total = 31 - shift;
+    return (int32_t)((product + ((int64_t)1 << (total - 1))) >> total);
+  }
+
+  static inline int8_t relu8(int32_t value) {
+    return (int8_t)(value < 0 ? 0 : value > 127 ? 127 : value);
+  }
+
+  // 3x3, stride 2, TF "same" padding (the extra row/column goes after)
+  static void conv3x3(const LayerSpec& layer, const int8_t* in, int8_t* out, const int8_t* weights,
+                      const int32_t* bias, const int32_t* multiplier, const int8_t* shift) {
+    uint8_t outSize = layer.inSize / 2;
+    bool depthwise = layer.kind == Kind::Depthwise;
+    for (uint8_t oy = 0; oy < outSize; oy++) {
+      for (uint8_t ox = 0; ox < outSize; ox++) {
+        // Kernel taps outside, channels inside: the depthwise inner loop is contiguous
+        int32_t acc[64];
+        for (uint8_t oc = 0; oc < layer.out; oc++) {
+          acc[oc] = bias[oc];
+        }
+        for (uint8_t ky = 0; ky < 3; ky++) {
+          uint8_t iy = oy * 2 + ky;
+          if (iy >= layer.inSize) {
+            continue;
+          }
+          for (uint8_t kx = 0; kx < 3; kx++) {
+            uint8_t ix = ox * 2 + kx;
+            if (ix >= layer.inSize) {
+              continue;
+            }
+            const int8_t* source = in + ((size_t)iy * layer.inSize + ix) * layer.in;
+            if (depthwise) {
+              const int8_t* tap = weights + (ky * 3 + kx) * layer.out;
+              for (uint8_t oc = 0; oc < layer.out; oc++) {
+                acc[oc] += source[oc] * tap[oc];
+              }
+            } else {
+              for (uint8_t oc = 0; oc < layer.out; oc++) {
+                acc[oc] += dotS8(source, weights + ((oc * 3 + ky) * 3 + kx) * layer.in, layer.in);
+              }
+            }
+          }
+        }
+        int8_t* pixel = out + ((size_t)oy * outSize + ox) * layer.out;
+        for (uint8_t oc = 0; oc < layer.out; oc++) {
+          pixel[oc] = relu8(requantize(acc[oc], multiplier[oc], shift[oc]));
+        }
+      }
+    }
+  }
+
+  static void pointwise(const LayerSpec& layer, const int8_t* in, int8_t* out, const int8_t* weights,
+                        const int32_t* bias, const int32_t* multiplier, const int8_t* shift) {
+    size_t pixels = (size_t)layer.inSize * layer.inSize;
+    for (size_t p = 0; p < pixels; p++) {
+      const int8_t* source = in + p * layer.in;
+      int8_t* target = out + p * layer.out;
+      for (uint8_t oc = 0; oc < layer.out; oc++) {
+        int32_t acc = bias[oc] + dotS8(source, weights + oc * layer.in, layer.in);
+        target[oc] = relu8(requantize(acc, multiplier[oc], shift[oc]));
+      }
+    }
+  }
+
+  // ============================================================================
+  // Inference
+  // ============================================================================
+
+  Result classify(const uint8_t* input) {
+    uint32_t start = micros();
+    for (size_t i = 0; i < (size_t)INPUT_SIZE * INPUT_SIZE; i++) {
+      s_bufferB[i] = (int8_t)(input[i] - 128);
+    }
+
+    int8_t* in = s_bufferB;
+    int8_t* out = s_bufferA;
+    const int8_t* weights = s_weights;
+    size_t channel = 0;
+    int32_t logits[CLASS_COUNT];
+    for (uint8_t i = 0; i < LAYER_COUNT; i++) {
+      const LayerSpec& layer = LAYERS[i];
+      const int32_t* bias = s_bias + channel;
+      const int32_t* multiplier = s_multiplier + channel;
+      const int8_t* shift = s_shift + channel;
+      if (layer.kind == Kind::Dense) {
+        // Global average of the last feature map (scale unchanged), then the head
+        size_t pixels = (size_t)LAYERS[i - 1].inSize * LAYERS[i - 1].inSize;
+        int8_t pooled[64];
+        for (uint8_t c = 0; c < layer.in; c++) {
+          int32_t sum = 0;
+          for (size_t p = 0; p < pixels; p++) {
+            sum += in[p * layer.in + c];
+          }
+          pooled[c] = (int8_t)((sum + (int32_t)pixels / 2) / (int32_t)pixels);
+        }
+        for (uint8_t oc = 0; oc < layer.out; oc++) {
+          int32_t acc = bias[oc] + dotS8(pooled, weights + oc * layer.in, layer.in);
+          logits[oc] = constrain(requantize(acc, multiplier[oc], shift[oc]), -128, 127);
+        }
+      } else {
+        if (layer.kind == Kind::Pointwise) {
+          pointwise(layer, in, out, weights, bias, multiplier, shift);
+        } else {
+          conv3x3(layer, in, out, weights, bias, multiplier, shift);
+        }
+        int8_t* swap = in;
+        in = out;
+        out = swap;
+      }
+      weights += weightCount(layer);
+      channel += layer.out;
+    }
+
+    // Softmax over the dequantized logits
+    Result result = {Label::Other, 0.0f, 0};
+    int32_t best = 0;
+    for (uint8_t c = 1; c < CLASS_COUNT; c++) {
+      if (logits[c] > logits[best]) {
+        best = c;
+      }
+    }
+    float total = 0.0f;
+    for (uint8_t c = 0; c < CLASS_COUNT; c++) {
+      total += expf((logits[c] - logits[best]) * s_logitScale);
+    }
+    result.label = (Label)best;
+    result.score = 1.0f / total;
+    result.micros = micros() - start;
+    s_classified++;
+    return result;
+  }
+
+  const char* labelName(Label label) {
+    switch (label) {
+      case Label::Person: return "person";
+      case Label::Vehicle: return "vehicle";
+      default: return "other";
+    }
+  }
+
+  uint32_t getClassified() { return s_classified; }
+  uint32_t getSkipped() { return s_skipped; }
+  void countSkipped() { s_skipped++; }
+}
@@ -0,0 +1,231 @@
+#include "reset_tracker.h"
+
+#ifdef ESP32
+
+#include <Preferences.h>
+#include <algorithm>
+#include <stddef.h>
+#include <string.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#if __has_include(<esp_rtc_time.h>)
+    #include <esp_rtc_time.h>
+#elif defined(CONFIG_IDF_TARGET_ESP32S3)
+    #include <esp32s3/rtc.h>
+#else
+    #include <esp32/rtc.h>
+#endif
+
+namespace ResetTracker {
+    static const uint32_t RECORD_MAGIC = 0x52535431;  // "RST1"
+    static const uint32_t BOOT_IN_PROGRESS = 0xDEADBEEF;
+
+    struct ResetRecord {
+        uint32_t magic;
+        uint32_t bootInProgress;   // BOOT_IN_PROGRESS until markBootComplete()
+        uint32_t crashCount;
+        uint32_t resetCount;       // Boots inside the current detection window
+        uint32_t windowOpen;
+        uint32_t nvsDirty;         // NVS fallback counter needs clearing
+        uint32_t bootCount;
+        uint32_t nvsWrites;
+        uint32_t bootDelaySavedMs;
+        uint64_t createdUs;        // RTC time when the record was created
+        uint32_t crc;
+    };
+
+    RTC_NOINIT_ATTR static ResetRecord s_record;
+
+    static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+    static esp_timer_handle_t s_windowTimer = nullptr;
+    static volatile bool s_windowExpired = false;
+    static esp_reset_reason_t s_resetReason = ESP_RST_UNKNOWN;
+
+    static uint32_t crc32(const uint8_t* data, size_t length) {
+        uint32_t crc = 0xFFFFFFFF;
+        for (size_t i = 0; i < length; i++) {
+            crc ^= data[i];
+            for (uint8_t bit = 0; bit < 8; bit++) {
+                crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+            }
+        }
+        return ~crc;
+    }
+
+    static uint32_t recordCrc() {
+        return crc32((const uint8_t*)&s_record, offsetof(ResetRecord, crc));
+    }
+
+    static void seal() {
+        s_record.crc = recordCrc();
+    }
+
+    static void nvsPutResetCount(uint32_t count) {
+        Preferences prefs;
+        prefs.begin("reset", false);
+        prefs.putUInt("reset_cnt", count);
+        prefs.end();
+        s_record.nvsWrites++;
+    }
+
+    // esp_timer task: close the window in RTC only, NVS is left to loop()
+    static void onWindowExpired(void*) {
+        portENTER_CRITICAL(&s_lock);
+        s_record.windowOpen = 0;
+        s_record.resetCount = 0;
+        seal();
+        portEXIT_CRITICAL(&s_lock);
+        s_windowExpired = true;
+    }
+
+    static void armWindowTimer(uint8_t windowSeconds) {
+        esp_timer_create_args_t args = {};
+        args.callback = onWindowExpired;
+        args.name = "reset_window";
+        if (esp_timer_create(&args, &s_windowTimer) == ESP_OK) {
+            esp_timer_start_once(s_windowTimer, (uint64_t)windowSeconds * 1000000ULL);
+        }
+    }
+
+    const char* begin(uint8_t windowSeconds, uint8_t resetThreshold, uint8_t crashThreshold) {
+        s_resetReason = esp_reset_reason();
+        const char* portalReason = "none";
+
+        bool rtcValid = s_record.magic == RECORD_MAGIC && s_record.crc == recordCrc();
+        if (!rtcValid) {
+            memset(&s_record, 0, sizeof(s_record));
+            s_record.magic = RECORD_MAGIC;
+            s_record.createdUs = esp_rtc_get_time_us();
+            Serial.println("[RESET] RTC record initialized (cold boot)");
+        }
+        s_record.bootCount++;
+
+        // Timer wake from deep sleep: the previous boot completed, nobody pressed reset
+        if (s_resetReason == ESP_RST_DEEPSLEEP) {
+            s_record.bootInProgress = BOOT_IN_PROGRESS;
+            s_record.windowOpen = 0;
+            s_record.resetCount = 0;
+            s_record.bootDelaySavedMs += windowSeconds * 1000UL;
+            seal();
+            return portalReason;
+        }
+
+        // ===== Crash loop detection =====
+        if (s_record.bootInProgress == BOOT_IN_PROGRESS) {
+            s_record.crashCount++;
+            Serial.printf("[RESET] Incomplete boot detected, crash count: %lu\n", (unsigned long)s_record.crashCount);
+            if (s_record.crashCount >= crashThreshold) {
+                Serial.println("[RESET] CRASH LOOP RECOVERY - entering config portal");
+                portalReason = "crash_recovery";
+                s_record.crashCount = 0;
+            }
+        } else {
+            s_record.crashCount = 0;
+        }
+        s_record.bootInProgress = BOOT_IN_PROGRESS;
+
+        // ===== Triple-reset detection =====
+        if (strcmp(portalReason, "crash_recovery") != 0) {
+            uint32_t count;
+            if (rtcValid) {
+                count = s_record.windowOpen ? s_record.resetCount + 1 : 1;
+                // Keep the fallback counter in step when RTC survived a reset it did not survive before
+                if (s_record.nvsDirty && count < resetThreshold) {
+                    nvsPutResetCount(count);
+                }
+            } else {
+                // RTC lost: the previous boot's window (if any) is only known to NVS
+                Preferences prefs;
+                prefs.begin("reset", true);
+                uint32_t stored = prefs.getUInt("reset_cnt", 0);
+                prefs.end();
+                count = (stored > 0 && stored < 10) ? stored + 1 : 1;
+                if (count < resetThreshold) {
+                    nvsPutResetCount(count);
+                    s_record.nvsDirty = 1;
+                }
+            }
+
+            if (count >= resetThreshold) {
+                Serial.println("[RESET] TRIPLE RESET DETECTED - entering config portal");
+                portalReason = "triple_reset";
+                s_record.windowOpen = 0;
+                s_record.resetCount = 0;
+                if (s_record.nvsDirty || !rtcValid) {
+                    nvsPutResetCount(0);
+                    s_record.nvsDirty = 0;
+                }
+            } else {
+                Serial.printf("[RESET] Reset count: %lu/%d, window %ds (non-blocking)\n",
+                              (unsigned long)count, resetThreshold, windowSeconds);
+                s_record.resetCount = count;
+                s_record.windowOpen = 1;
+                s_record.bootDelaySavedMs += windowSeconds * 1000UL;
+                seal();
+                armWindowTimer(windowSeconds);
+            }
+        }
+
+        seal();
+        Serial.printf("[RESET] Boot reason: %s (%s)\n", portalReason, getResetReason());
+        return portalReason;
+    }
+
+    void markBootComplete() {
+        portENTER_CRITICAL(&s_lock);
+        s_record.bootInProgress = 0;
+        s_record.crashCount = 0;
+        seal();
+        portEXIT_CRITICAL(&s_lock);
+        Serial.println("[RESET] Crash loop flag cleared - boot successful");
+    }
+
+    void loop() {
+        if (!s_windowExpired) {
+            return;
+        }
+        s_windowExpired = false;
+        Serial.println("[RESET] Reset window expired, normal boot");
+        if (s_record.nvsDirty) {
+            nvsPutResetCount(0);
+            portENTER_CRITICAL(&s_lock);
+            s_record.nvsDirty = 0;
+            seal();
+            portEXIT_CRITICAL(&s_lock);
+        }
+    }
+
+    bool isWindowOpen() { return s_record.windowOpen != 0; }
+    uint32_t getBootCount() { return s_record.bootCount; }
+    uint32_t getCrashCount() { return s_record.crashCount; }
+    uint32_t getNvsWrites() { return s_record.nvsWrites; }
+    uint32_t getBootDelaySavedMs() { return s_record.bootDelaySavedMs; }
+
+    float getNvsWritesPerDay() {
+        uint64_t now = esp_rtc_get_time_us();
+        if (now <= s_record.createdUs) {
+            return 0.0f;
+        }
+        // At least one hour of history so a fresh record does not extrapolate wildly
+        float days = std::max((now - s_record.createdUs) / 86400e6f, 1.0f / 24.0f);
+        return s_record.nvsWrites / days;
+    }
+
+    const char* getResetReason() {
+        switch (s_resetReason) {
+            case ESP_RST_POWERON:   return "power_on";
+            case ESP_RST_EXT:       return "external";
+            case ESP_RST_SW:        return "software";
+            case ESP_RST_PANIC:     return "panic";
+            case ESP_RST_INT_WDT:   return "int_wdt";
+            case ESP_RST_TASK_WDT:  return "task_wdt";
+            case ESP_RST_WDT:       return "wdt";
+            case ESP_RST_DEEPSLEEP: return "deep_sleep";
+            case ESP_RST_BROWNOUT:  return "brownout";
+            case ESP_RST_SDIO:      return "sdio";
+            default:                return "unknown";
+        }
+    }
+}
+
+#endif // ESP32
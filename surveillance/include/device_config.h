@@ -32,6 +32,19 @@
 #define MOTION_THRESHOLD 25         // Pixel difference threshold (0-255)
 #define MOTION_CHANGED_BLOCKS 25    // Number of blocks that must change to trigger motion (was 15)
 
+// Motion tracking: changed frames alert only on a new track or significant movement
+#define MOTION_TRACK_CELL_PIXELS 6  // Changed pixels (of 64) that mark an 8x8 cell of the 1/8-scale map
+#define MOTION_TRACK_MAX_MISSES 5   // Checks a track survives without motion (15 s at 3 s)
+#define MOTION_TRACK_MOVE_PX 16     // Centroid travel (96 px map) since the last alert that alerts again
+
+// Optional motion crop classifier (person/vehicle/other); off unless the model file exists
+#define CLASSIFIER_MODEL_FILE "/person_cnn.bin"  // LittleFS
+#define CLASSIFIER_MIN_CELLS 3      // Smaller blobs are published unclassified
+
+// Capture dedup: skip storing/uploading frames whose perceptual hash matches the last stored one
+#define DEDUP_MAX_DISTANCE 6        // Differing hash bits (of 64) still counted as the same scene
+#define DEDUP_REFRESH_MS 600000     // Store a reference frame at least every 10 minutes
+
 // Web server settings
 #define WEB_SERVER_PORT 80
 
@@ -55,9 +68,21 @@
 
 #define PIR_DEBOUNCE_MS 5000  // 5 seconds between motion triggers
 
+// PIR-gated mode: PIR triggers captures, camera motion checks are off and the
+// sensor is powered down (PWDN/standby, XCLK stopped) between events
+#define PIR_GATED_MODE false
+#define PIR_CAMERA_IDLE_MS 15000    // Power the sensor down after 15 s without a capture
+#define PIR_WAKE_SETTLE_FRAMES 2    // Frames dropped after wake-up (stale buffers, first exposure)
+#define CAMERA_ACTIVE_MA 40         // Sensor + XCLK while streaming, for the current estimate
+#define CAMERA_STANDBY_MA 1         // Sensor in power-down
+
+// Loop profiler: iterations at or above the threshold are reported as "loop_stall" events
+#define LOOP_STALL_THRESHOLD_MS 500           // Iteration time counted as a stall
+#define LOOP_STALL_REPORT_INTERVAL_MS 300000  // Max one stall event per 5 min
+
 // Triple-reset detector (for entering config portal)
+// Tracked in RTC memory; the window closes from a timer so setup() is not delayed
 #define RESET_DETECT_TIMEOUT 2       // 2 second window for triple-reset
-#define RESET_DETECT_ADDRESS 0x00    // RTC memory address for reset counter
 #define RESET_COUNT_THRESHOLD 3      // Number of resets to trigger config portal
 
 // Crash loop recovery
@@ -0,0 +1,70 @@
+#ifndef PERSON_CLASSIFIER_H
+#define PERSON_CLASSIFIER_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Optional person/vehicle/other classifier for motion crops.
+ *
+ * A tiny int8-quantized CNN (about 0.46 M multiply-accumulates) runs on a
+ * 96x96 grayscale crop around the blob that raised a motion alert:
+ *
+ *   conv 3x3/2 1->8 | dw 3x3/2 + pw 8->16 | dw 3x3/2 + pw 16->32 |
+ *   dw 3x3/2 + pw 32->64 | global average | fc 64->3
+ *
+ * Weights are int8 with per-channel requantization (Q31 multiplier and shift,
+ * as in TFLite Micro), activations are int8 after ReLU, HWC layout. The
+ * kernels are plain C; pointwise layers and the classifier head, about half
+ * of the work, go through one contiguous int8 dot product (dotS8), the spot
+ * for a SIMD version on the ESP32-S3.
+ *
+ * The model is a file (MODEL_SIZE bytes, layout in person_classifier.cpp),
+ * e.g. /person_cnn.bin on LittleFS; without one the stage is off and motion
+ * events are published unclassified.
+ */
+
+namespace PersonClassifier {
+  static const uint8_t INPUT_SIZE = 96;
+  static const uint8_t CLASS_COUNT = 3;
+  extern const size_t MODEL_SIZE;
+
+  enum class Label : uint8_t { Person, Vehicle, Other };
+
+  struct Result {
+    Label label;
+    float score;                 // Softmax probability of label
+    uint32_t micros;             // Inference time
+  };
+
+  /**
+   * @brief Load a model image (copied; activations are allocated here too, in
+   * PSRAM when present). Replaces a model loaded before.
+   */
+  bool load(const uint8_t* model, size_t size);
+  bool loadFile(const char* path);
+  bool isReady();
+
+  /**
+   * @brief Scale the box (x0..x1, y0..y1 inclusive, in the mapWidth x
+   * mapHeight motion map of the frame) out of a grayscale or RGB565 image
+   * into the square 96x96 input. The box is grown to a square around its
+   * center first, so shapes keep their aspect ratio.
+   */
+  void cropGray(const uint8_t* image, uint16_t width, uint16_t height, uint16_t mapWidth, uint16_t mapHeight,
+                uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t* input);
+  void cropRgb565(const uint16_t* image, uint16_t width, uint16_t height, uint16_t mapWidth, uint16_t mapHeight,
+                  uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t* input);
+
+  /**
+   * @brief Classify a 96x96 crop. isReady() must be true.
+   */
+  Result classify(const uint8_t* input);
+
+  const char* labelName(Label label);
+
+  uint32_t getClassified();
+  uint32_t getSkipped();           // Alerts whose blob was too small to classify
+  void countSkipped();
+}
+
+#endif // PERSON_CLASSIFIER_H
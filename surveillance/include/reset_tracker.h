@@ -0,0 +1,49 @@
+#ifndef RESET_TRACKER_H
+#define RESET_TRACKER_H
+
+#include <Arduino.h>
+
+#ifdef ESP32
+
+/**
+ * @brief Triple-reset and crash-loop detection kept in RTC memory.
+ *
+ * State lives in an RTC_NOINIT record guarded by a CRC, so it survives
+ * software resets, panics, watchdog resets and deep sleep without touching
+ * flash. The triple-reset window is closed by a one-shot esp_timer instead of
+ * delaying setup(). Deep-sleep wakes skip reset counting entirely.
+ *
+ * When the RTC record is lost (cold power-on, or an EN reset on boards that
+ * clear RTC memory) the window falls back to a single NVS counter: one write
+ * to open it, one write from loop() to close it.
+ */
+
+namespace ResetTracker {
+    /**
+     * @brief Evaluate the previous boot. Call first thing in setup().
+     * @return "none", "triple_reset" or "crash_recovery"
+     */
+    const char* begin(uint8_t windowSeconds, uint8_t resetThreshold, uint8_t crashThreshold);
+
+    /**
+     * @brief Mark the boot as successful (replaces the crash flag write).
+     */
+    void markBootComplete();
+
+    /**
+     * @brief Finish deferred work (NVS fallback cleanup). Call from loop().
+     */
+    void loop();
+
+    bool isWindowOpen();
+    uint32_t getBootCount();          // Boots since the RTC record was created
+    uint32_t getCrashCount();         // Consecutive incomplete boots
+    uint32_t getNvsWrites();          // Flash writes by the tracker since the RTC record was created
+    float getNvsWritesPerDay();
+    uint32_t getBootDelaySavedMs();   // Boot time no longer spent in the blocking window
+    const char* getResetReason();     // esp_reset_reason() of this boot as text
+}
+
+#endif // ESP32
+
+#endif // RESET_TRACKER_H
@@ -1,4 +1,5 @@
 #include "camera_config.h"
+#include "camera_power.h"
 #include <Arduino.h>
 
 camera_config_t getCameraConfig() {
@@ -145,6 +146,8 @@ void resetCameraSettings() {
 }
 
 camera_fb_t* capturePhoto() {
+    // Sensor may be powered down between PIR events
+    CameraPower::ensureAwake();
     camera_fb_t * fb = esp_camera_fb_get();
     if (!fb) {
         Serial.println("Camera capture failed");
@@ -174,6 +177,7 @@ camera_fb_t* capturePhoto() {
     
     // Give camera sensor time to settle between frames (prevents tearing)
     delayMicroseconds(100);
+    CameraPower::frameCaptured();
     return fb;
 }
 
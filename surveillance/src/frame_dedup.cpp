@@ -0,0 +1,93 @@
+#include "frame_dedup.h"
+
+namespace FrameDedup {
+  static const uint8_t HASH_ROWS = 8;
+  static const uint8_t HASH_COLUMNS = 9;     // 8 comparisons per row
+  static const uint8_t MARGIN = 2 * 16;      // A bit needs 2 luma levels of difference (means in 1/16)
+
+  static Config s_config;
+  static bool s_hasReference = false;
+  static uint64_t s_reference = 0;
+  static uint32_t s_referenceMs = 0;
+  static uint32_t s_checked = 0;
+  static uint32_t s_duplicates = 0;
+  static uint64_t s_bytesSaved = 0;
+
+  void begin(const Config& config) {
+    s_config = config;
+    reset();
+  }
+
+  void reset() {
+    s_hasReference = false;
+    s_checked = 0;
+    s_duplicates = 0;
+    s_bytesSaved = 0;
+  }
+
+  uint64_t hash(const uint8_t* luma, uint16_t width, uint16_t height) {
+    // Column c covers x in [c * width / 9, (c + 1) * width / 9), band b the rows
+    // [b * height / 8, (b + 1) * height / 8): 100x75 gives widths of 11 and 12
+    // and bands of 9 and 10 rows
+    uint16_t stride = width;
+    width = min(width, MAX_MAP_WIDTH);
+    if (width < HASH_COLUMNS || height < HASH_ROWS) {
+      return 0;
+    }
+    uint8_t columnOf[MAX_MAP_WIDTH];
+    uint16_t columnWidth[HASH_COLUMNS] = {0};
+    for (uint16_t x = 0; x < width; x++) {
+      columnOf[x] = x * HASH_COLUMNS / width;
+      columnWidth[columnOf[x]]++;
+    }
+
+    uint64_t bits = 0;
+    for (uint8_t band = 0; band < HASH_ROWS; band++) {
+      uint16_t y0 = (uint32_t)band * height / HASH_ROWS;
+      uint16_t y1 = (uint32_t)(band + 1) * height / HASH_ROWS;
+      uint32_t sums[HASH_COLUMNS] = {0};
+      const uint8_t* row = luma + (size_t)y0 * stride;
+      for (uint16_t y = y0; y < y1; y++, row += stride) {
+        for (uint16_t x = 0; x < width; x++) {
+          sums[columnOf[x]] += row[x];
+        }
+      }
+      // Without a margin, flat areas (sky, a wall at night) hash sensor noise
+      uint16_t means[HASH_COLUMNS];
+      for (uint8_t c = 0; c < HASH_COLUMNS; c++) {
+        means[c] = sums[c] * 16 / (columnWidth[c] * (y1 - y0));
+      }
+      for (uint8_t c = 0; c + 1 < HASH_COLUMNS; c++) {
+        bits = (bits << 1) | (means[c] > means[c + 1] + MARGIN);
+      }
+    }
+    return bits;
+  }
+
+  uint8_t distance(uint64_t a, uint64_t b) {
+    return __builtin_popcountll(a ^ b);
+  }
+
+  bool isDuplicate(uint64_t frameHash, size_t bytes, uint32_t nowMs) {
+    s_checked++;
+    if (s_hasReference && nowMs - s_referenceMs < s_config.refreshMs
+        && distance(frameHash, s_reference) <= s_config.maxDistance) {
+      s_duplicates++;
+      s_bytesSaved += bytes;
+      return true;
+    }
+    setReference(frameHash, nowMs);
+    return false;
+  }
+
+  void setReference(uint64_t frameHash, uint32_t nowMs) {
+    s_hasReference = true;
+    s_reference = frameHash;
+    s_referenceMs = nowMs;
+  }
+
+  uint32_t getChecked() { return s_checked; }
+  uint32_t getDuplicates() { return s_duplicates; }
+  uint64_t getBytesSaved() { return s_bytesSaved; }
+  float getHitRate() { return s_checked ? (float)s_duplicates / s_checked : 0.0f; }
+}
@@ -0,0 +1,542 @@
+/**
+ * host_main.cpp
+ *
+ * Native host runner for the surveillance camera (env:native, not part of the
+ * firmware image). The camera, SD_MMC and web server stay on the device; this
+ * covers the portable per-event work: trace/payload serialization, the loop
+ * profiler and a capture-sized filesystem write. Optionally publishes motion
+ * events to a local MQTT broker through the real PubSubClient.
+ *
+ * The motion tracker is replayed over luma sequences (synthetic scenes, or a
+ * recording with --luma-seq: 100x75 8-bit frames (the SVGA map) back to back,
+ * one per motion check, e.g.
+ * `ffmpeg -i clip.mp4 -vf fps=1/3,scale=100:75,format=gray -f rawvideo seq.raw`)
+ * and compared with alerting on every changed frame. The person classifier is
+ * timed with a random-weight model of the real layout (loaded from LittleFS
+ * like on the device), and counted over the replays to show how many checks
+ * actually pay for inference. Every replayed frame also goes through the
+ * perceptual-hash dedup as if it were a periodic capture (hit rate, bytes saved),
+ * and the alerts go through the sketch's capture rule (births always stored).
+ * The frame pool runs a fragmentation soak: four simulated weeks of motion
+ * checks, alerts, web captures held across checks, base64 uploads and a frame
+ * size change every day.
+ *
+ * Usage:
+ *   pio run -e native -t exec
+ *   .pio/build/native/program [--broker host:port] [--count N] [--luma-seq file]
+ *
+ * LittleFS is backed by files under $HOST_FS_ROOT (default .host_fs).
+ */
+
+#ifdef NATIVE_HOST
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <PubSubClient.h>
+#include <LittleFS.h>
+#include <WiFi.h>
+#include <HostBench.h>
+#include <HostCheck.h>
+#include <HostHeap.h>
+#include <vector>
+
+#include "frame_dedup.h"
+#include "frame_pool.h"
+#include "loop_profiler.h"
+#include "motion_tracker.h"
+#include "person_classifier.h"
+#include "trace.h"
+
+static const char* DEVICE_NAME = "host-cam";
+static const char* CHIP_ID = "host0000";
+static const size_t CAPTURE_SIZE = 40 * 1024;  // Typical SVGA JPEG
+
+// Motion check settings from device_config.h (not included: it defines DEVICE_NAME)
+static const int MOTION_THRESHOLD = 25;
+static const int MOTION_CHANGED_BLOCKS = 25;
+static const uint32_t MOTION_CHECK_INTERVAL = 3000;
+static const uint8_t CLASSIFIER_MIN_CELLS = 3;
+static const uint16_t MAP_WIDTH = 800 / 8;            // SVGA luma map
+static const uint16_t MAP_HEIGHT = 600 / 8;
+static const uint16_t LUMA_SIZE = MAP_WIDTH * MAP_HEIGHT;
+
+// Same shape as the motion document in handleMotionDetection()
+static void buildMotionPayload(String& output, unsigned long motionCount) {
+    JsonDocument motionDoc;
+    motionDoc["device"] = DEVICE_NAME;
+    motionDoc["chip_id"] = CHIP_ID;
+    motionDoc["trace_id"] = Trace::getTraceId();
+    motionDoc["traceparent"] = Trace::getTraceparent();
+    motionDoc["seq_num"] = Trace::getSequenceNumber();
+    motionDoc["timestamp"] = millis() / 1000;
+    motionDoc["motion_count"] = motionCount;
+    motionDoc["event"] = "motion_detected";
+    output = "";
+    serializeJson(motionDoc, output);
+}
+
+// Subset of publishMetricsToMQTT() that does not depend on camera state
+static void buildMetricsPayload(String& output) {
+    JsonDocument doc;
+    doc["device"] = DEVICE_NAME;
+    doc["chip_id"] = CHIP_ID;
+    doc["trace_id"] = Trace::getTraceId();
+    doc["traceparent"] = Trace::getTraceparent();
+    doc["seq_num"] = Trace::getSequenceNumber();
+    doc["schema_version"] = 1;
+    doc["location"] = "surveillance";
+    doc["timestamp"] = millis() / 1000;
+    doc["uptime"] = millis() / 1000;
+    doc["wifi_rssi"] = WiFi.RSSI();
+    doc["free_heap"] = ESP.getFreeHeap();
+    doc["free_psram"] = ESP.getFreePsram();
+    doc["loop_iterations"] = LoopProfiler::getIterations();
+    doc["loop_max_ms"] = LoopProfiler::getMaxIterationMs();
+    doc["loop_stalls"] = LoopProfiler::getStallCount();
+    doc["loop_last_stall_region"] = LoopProfiler::getLastStallRegion();
+    JsonArray loopHistogram = doc["loop_histogram"].to<JsonArray>();
+    for (uint8_t i = 0; i < LoopProfiler::HISTOGRAM_BUCKETS; i++) {
+        loopHistogram.add(LoopProfiler::getBucket(i));
+    }
+    output = "";
+    serializeJson(doc, output);
+}
+
+// ============================================================================
+// Motion tracker replay
+// ============================================================================
+
+typedef std::vector<uint8_t> LumaFrame;
+
+static uint8_t noisy(int value, int noise) {
+    return (uint8_t)constrain(value + (noise > 0 ? (int)random(-noise, noise + 1) : 0), 0, 255);
+}
+
+static void fillRect(LumaFrame& frame, int x0, int y0, int w, int h, int value) {
+    for (int y = max(y0, 0); y < min(y0 + h, (int)MAP_HEIGHT); y++) {
+        for (int x = max(x0, 0); x < min(x0 + w, (int)MAP_WIDTH); x++) {
+            frame[y * MAP_WIDTH + x] = (uint8_t)value;
+        }
+    }
+}
+
+/**
+ * Two hours of checks at night (one frame per 3 s check):
+ * - "parked car": a shadow next to a parked car flickers on half the checks
+ * - "rain": ~1.5% of pixels change at random on every check
+ * - "walkers": the parked car, plus someone crossing the frame every 10 min
+ */
+static std::vector<LumaFrame> syntheticScene(const char* scene, uint32_t frames) {
+    std::vector<LumaFrame> sequence;
+    bool shadow = strcmp(scene, "rain") != 0;
+    bool rain = strcmp(scene, "rain") == 0;
+    bool walkers = strcmp(scene, "walkers") == 0;
+    for (uint32_t f = 0; f < frames; f++) {
+        LumaFrame frame(LUMA_SIZE);
+        for (uint16_t i = 0; i < LUMA_SIZE; i++) {
+            frame[i] = noisy(60 + (i / MAP_WIDTH) / 3, 4);
+        }
+        fillRect(frame, 20, 45, 40, 20, 90);                   // Parked car
+        if (shadow && random(2) == 0) {
+            int jitter = (int)random(-2, 3);
+            fillRect(frame, 20 + jitter, 65, 40, 8, 30);       // Flickering shadow under it
+        }
+        if (rain) {
+            for (uint16_t drop = 0; drop < LUMA_SIZE * 3 / 200; drop++) {
+                frame[random(LUMA_SIZE)] = noisy(160, 30);
+            }
+        }
+        if (walkers) {
+            uint32_t phase = f % 200;                          // 200 checks = 10 min
+            if (phase < 18) {
+                fillRect(frame, (int)phase * 6 - 8, 30, 8, 24, 200);
+            }
+        }
+        sequence.push_back(frame);
+    }
+    return sequence;
+}
+
+static bool readLumaSequence(const char* path, std::vector<LumaFrame>& sequence) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        return false;
+    }
+    LumaFrame frame(LUMA_SIZE);
+    while (fread(frame.data(), 1, LUMA_SIZE, file) == LUMA_SIZE) {
+        sequence.push_back(frame);
+    }
+    fclose(file);
+    return !sequence.empty();
+}
+
+// Same diff as checkCameraMotion(): pixels over MOTION_THRESHOLD, counted per cell
+static int diffFrame(const LumaFrame& current, LumaFrame& previous, uint8_t* cellCounts) {
+    int changedPixels = 0;
+    memset(cellCounts, 0, MotionTracker::MAX_CELLS);
+    for (uint16_t y = 0, i = 0; y < MAP_HEIGHT; y++) {
+        for (uint16_t x = 0; x < MAP_WIDTH; x++, i++) {
+            if (abs((int)current[i] - (int)previous[i]) > MOTION_THRESHOLD) {
+                changedPixels++;
+                cellCounts[MotionTracker::cellIndex(x, y, MAP_WIDTH)]++;
+            }
+            previous[i] = current[i];
+        }
+    }
+    return changedPixels;
+}
+
+static void replayTracker(const char* name, const std::vector<LumaFrame>& sequence, bool synthetic) {
+    MotionTracker::reset();
+    FrameDedup::reset();
+    LumaFrame previous = sequence[0];
+    uint8_t cellCounts[MotionTracker::MAX_CELLS];
+    uint8_t input[PersonClassifier::INPUT_SIZE * PersonClassifier::INPUT_SIZE];
+    uint32_t changedFrames = 0;
+    uint32_t births = 0;
+    uint32_t moves = 0;
+    uint32_t classified = 0;
+    uint64_t classifyUs = 0;
+    std::vector<std::pair<size_t, MotionTracker::Event>> alertFrames;
+    for (size_t f = 1; f < sequence.size(); f++) {
+        FrameDedup::isDuplicate(FrameDedup::hash(sequence[f].data(), MAP_WIDTH, MAP_HEIGHT), CAPTURE_SIZE, f * MOTION_CHECK_INTERVAL);
+        bool changed = diffFrame(sequence[f], previous, cellCounts) >= MOTION_CHANGED_BLOCKS;
+        changedFrames += changed;
+        MotionTracker::Result result = MotionTracker::update(changed ? cellCounts : nullptr, MAP_WIDTH, MAP_HEIGHT,
+                                                             f * MOTION_CHECK_INTERVAL);
+        births += result.event == MotionTracker::Event::Birth;
+        moves += result.event == MotionTracker::Event::Moved;
+        if (result.event != MotionTracker::Event::None) {
+            alertFrames.push_back({f, result.event});
+        }
+        // Same gate as classifyMotion(): alerts with a blob big enough to crop
+        if (result.event != MotionTracker::Event::None && PersonClassifier::isReady()
+            && result.track->box.cells >= CLASSIFIER_MIN_CELLS) {
+            const MotionTracker::Blob& box = result.track->box;
+            PersonClassifier::cropGray(sequence[f].data(), MAP_WIDTH, MAP_HEIGHT, MAP_WIDTH, MAP_HEIGHT,
+                                       box.x0, box.y0, box.x1, box.y1, input);
+            classifyUs += PersonClassifier::classify(input).micros;
+            classified++;
+        }
+    }
+    uint32_t alerts = MotionTracker::getAlerts();
+    printf("[HOST] %-10s %5u checks: %5u changed frames -> %4u alerts (%u births, %u moves), "
+           "%.1f%% fewer events, %.1f MB -> %.1f MB stored\n",
+           name, (unsigned)sequence.size() - 1, changedFrames, alerts, births, moves,
+           changedFrames > 0 ? 100.0 * (changedFrames - alerts) / changedFrames : 0.0,
+           changedFrames * CAPTURE_SIZE / 1048576.0, alerts * CAPTURE_SIZE / 1048576.0);
+    if (PersonClassifier::isReady()) {
+        printf("[HOST] %-10s classifier ran on %u of %u checks (%.1f ms CPU in total)\n",
+               name, classified, (unsigned)sequence.size() - 1, classifyUs / 1000.0);
+    }
+    printf("[HOST] %-10s dedup as periodic captures: %.1f%% duplicates, %.1f MB of %.1f MB not stored\n",
+           name, 100.0 * FrameDedup::getHitRate(), FrameDedup::getBytesSaved() / 1048576.0,
+           FrameDedup::getChecked() * CAPTURE_SIZE / 1048576.0);
+
+    // Alert captures as in the sketch: a birth is always stored, a move only if its scene changed.
+    // A refresh longer than the 10 min between crossings leaves their storing to the birth rule
+    FrameDedup::Config alertDedup;
+    alertDedup.refreshMs = 3600000;
+    FrameDedup::begin(alertDedup);
+    int8_t crossingFirstStored[12];            // Walkers: first alert of each crossing (200 checks apart) stored
+    memset(crossingFirstStored, -1, sizeof(crossingFirstStored));
+    uint32_t stored = 0;
+    for (const auto& alert : alertFrames) {
+        uint64_t frameHash = FrameDedup::hash(sequence[alert.first].data(), MAP_WIDTH, MAP_HEIGHT);
+        uint32_t nowMs = alert.first * MOTION_CHECK_INTERVAL;
+        bool store = true;
+        if (alert.second == MotionTracker::Event::Birth) {
+            FrameDedup::setReference(frameHash, nowMs);
+        } else {
+            store = !FrameDedup::isDuplicate(frameHash, CAPTURE_SIZE, nowMs);
+        }
+        stored += store;
+        size_t crossing = alert.first / 200;
+        if (alert.first % 200 < 30 && crossing < 12 && crossingFirstStored[crossing] < 0) {
+            crossingFirstStored[crossing] = store;
+        }
+    }
+    printf("[HOST] %-10s alert captures: %u of %u stored (%u moves skipped as repeats)\n",
+           name, stored, (unsigned)alertFrames.size(), (unsigned)FrameDedup::getDuplicates());
+    FrameDedup::begin(FrameDedup::Config());
+    if (!synthetic) {
+        return;
+    }
+    HostCheck::expect(changedFrames > 0 && alerts * 10 <= changedFrames,
+                      "motion tracker cuts changed-frame events by at least 90%");
+    if (strcmp(name, "walkers") == 0) {
+        // 12 crossings in two hours; each must raise at least one alert
+        HostCheck::expect(alerts >= 12 && births > 0 && moves > 0, "every walker crossing raises an alert");
+        // The walker entering at the edge moves the hash least: that capture must still be stored
+        bool everyCrossing = true;
+        for (int8_t firstStored : crossingFirstStored) {
+            everyCrossing = everyCrossing && firstStored == 1;
+        }
+        HostCheck::expect(everyCrossing, "every walker crossing stores its first capture");
+    }
+}
+
+// Random weights in the model file layout; scales keep activations in range, not meaningful outputs
+static std::vector<uint8_t> randomModel() {
+    static const struct { uint8_t weightsPerOut; uint8_t fanIn; uint8_t out; } LAYERS[] = {
+        {9, 9, 8}, {9, 9, 8}, {8, 8, 16}, {9, 9, 16}, {16, 16, 32}, {9, 9, 32}, {32, 32, 64}, {64, 64, 3}
+    };
+    std::vector<uint8_t> model = {'P', 'C', 'N', '1'};
+    float logitScale = 0.05f;
+    model.insert(model.end(), (uint8_t*)&logitScale, (uint8_t*)&logitScale + 4);
+    auto put32 = [&](int32_t value) {
+        for (int b = 0; b < 4; b++) {
+            model.push_back((uint8_t)(value >> (8 * b)));
+        }
+    };
+    for (const auto& layer : LAYERS) {
+        for (uint32_t i = 0; i < (uint32_t)layer.weightsPerOut * layer.out; i++) {
+            model.push_back((uint8_t)(int8_t)random(-64, 65));
+        }
+        int8_t shift = -(int8_t)(ceilf(log2f(layer.fanIn)) + 5);
+        for (uint8_t c = 0; c < layer.out; c++) put32((int32_t)random(-256, 257));
+        for (uint8_t c = 0; c < layer.out; c++) put32(0x40000000 + (int32_t)random(0x20000000));
+        for (uint8_t c = 0; c < layer.out; c++) model.push_back((uint8_t)shift);
+    }
+    return model;
+}
+
+static void setupClassifier() {
+    randomSeed(7);
+    std::vector<uint8_t> model = randomModel();
+    if (!HostCheck::expect(model.size() == PersonClassifier::MODEL_SIZE && LittleFS.begin(true),
+                           "classifier model file has the expected layout")) {
+        printf("[HOST] Classifier model is %u B, expected %u\n", (unsigned)model.size(),
+               (unsigned)PersonClassifier::MODEL_SIZE);
+        return;
+    }
+    File file = LittleFS.open("/person_cnn.bin", FILE_WRITE);
+    file.write(model.data(), model.size());
+    file.close();
+    if (!HostCheck::expect(PersonClassifier::loadFile("/person_cnn.bin"), "classifier model loads")) {
+        printf("[HOST] Classifier model did not load\n");
+        return;
+    }
+    LittleFS.remove("/person_cnn.bin");
+
+    uint8_t input[PersonClassifier::INPUT_SIZE * PersonClassifier::INPUT_SIZE];
+    for (size_t i = 0; i < sizeof(input); i++) {
+        input[i] = (uint8_t)random(256);
+    }
+    PersonClassifier::Result result = PersonClassifier::classify(input);
+    printf("[HOST] Classifier (%u B model, random weights): %s %.2f\n", (unsigned)model.size(),
+           PersonClassifier::labelName(result.label), result.score);
+    HostBench::run("PersonClassifier::classify 96x96", 2000, [&]() {
+        PersonClassifier::classify(input);
+    });
+    std::vector<uint16_t> frame(200 * 150, 0x7BEF);
+    HostBench::run("PersonClassifier::cropRgb565 from 200x150", 20000, [&]() {
+        PersonClassifier::cropRgb565(frame.data(), 200, 150, MAP_WIDTH, MAP_HEIGHT, 16, 24, 47, 74, input);
+    });
+}
+
+static void runTracker(const char* lumaSequence) {
+    setupClassifier();
+    MotionTracker::begin(MotionTracker::Config());
+    FrameDedup::begin(FrameDedup::Config());
+    static const char* SCENES[] = {"parked car", "rain", "walkers"};
+    for (const char* scene : SCENES) {
+        randomSeed(1);
+        replayTracker(scene, syntheticScene(scene, 2400), true);
+    }
+    if (lumaSequence) {
+        std::vector<LumaFrame> sequence;
+        if (readLumaSequence(lumaSequence, sequence)) {
+            replayTracker("recorded", sequence, false);
+        } else {
+            printf("[HOST] Cannot read 100x75 luma frames from %s\n", lumaSequence);
+        }
+    }
+
+    // Worst case for one check: busy frame with several blobs and live tracks
+    randomSeed(1);
+    std::vector<LumaFrame> busy = syntheticScene("walkers", 2);
+    LumaFrame previous = busy[0];
+    uint8_t cellCounts[MotionTracker::MAX_CELLS];
+    diffFrame(busy[1], previous, cellCounts);
+    for (uint16_t c = 0; c < MotionTracker::gridSize(MAP_WIDTH) * MotionTracker::gridSize(MAP_HEIGHT); c += 13) {
+        cellCounts[c] = 64;
+    }
+    uint32_t now = 0;
+    HostBench::run("MotionTracker::update (busy frame)", 100000, [&]() {
+        MotionTracker::update(cellCounts, MAP_WIDTH, MAP_HEIGHT, now += MOTION_CHECK_INTERVAL);
+    });
+    volatile uint64_t frameHash = 0;
+    HostBench::run("FrameDedup::hash 100x75", 100000, [&]() {
+        frameHash = FrameDedup::hash(busy[1].data(), MAP_WIDTH, MAP_HEIGHT);
+    });
+}
+
+// ============================================================================
+// Frame pool soak
+// ============================================================================
+
+static void runFramePoolSoak() {
+    static const struct { const char* name; uint16_t width; uint16_t height; } SIZES[] = {
+        {"VGA", 640, 480}, {"SVGA", 800, 600}, {"HD", 1280, 720}, {"UXGA", 1600, 1200}
+    };
+    static const uint32_t CHECKS_PER_DAY = 86400000 / MOTION_CHECK_INTERVAL;
+    static const uint8_t DAYS = 28;
+
+    FramePool::begin(FramePool::Config(), SIZES[0].width, SIZES[0].height);
+    size_t heapBefore = HostHeap::current();
+    auto allocReleasePair = []() {
+        FramePool::release(FramePool::alloc((SIZES[0].width / 8) * (SIZES[0].height / 8) * 2));
+    };
+    HostBench::run("FramePool alloc+release (fresh)", 1000000, allocReleasePair);
+
+    randomSeed(3);
+    std::vector<void*> inFlight;               // Web capture copies still being sent
+    uint32_t deferred = 0;
+    for (uint32_t check = 0; check < DAYS * CHECKS_PER_DAY; check++) {
+        uint8_t day = check / CHECKS_PER_DAY;
+        uint16_t width = SIZES[day % 4].width;
+        uint16_t height = SIZES[day % 4].height;
+        if (check % CHECKS_PER_DAY == 0 && check > 0) {
+            deferred += !FramePool::resize(width, height);
+        }
+        // A send finishes within a check or two
+        for (size_t i = 0; i < inFlight.size();) {
+            if (random(2) == 0) {
+                FramePool::release(inFlight[i]);
+                inFlight[i] = inFlight.back();
+                inFlight.pop_back();
+            } else {
+                i++;
+            }
+        }
+
+        size_t lumaBytes = (size_t)(width / 8) * (height / 8);
+        FramePool::Buffer decode(lumaBytes * 2);
+        if (random(50) == 0) {
+            // Alert: dedup decode + luma, classifier decode at 1/4 + input
+            FramePool::Buffer dedupDecode(lumaBytes * 2);
+            FramePool::Buffer dedupLuma(lumaBytes);
+            FramePool::Buffer classifierDecode((size_t)(width / 4) * (height / 4) * 2);
+            FramePool::Buffer classifierInput(PersonClassifier::INPUT_SIZE * PersonClassifier::INPUT_SIZE);
+        }
+        size_t jpegBytes = (size_t)width * height / 5 * random(30, 101) / 100;
+        if (random(20) == 0 && inFlight.size() < FramePool::Config().jpegBlocks) {
+            inFlight.push_back(FramePool::alloc(jpegBytes));
+        }
+        if (check % 1200 == 0) {
+            FramePool::Buffer base64((jpegBytes + 2) / 3 * 4 + 1);
+        }
+    }
+    for (void* block : inFlight) {
+        FramePool::release(block);
+    }
+    FramePool::resize(SIZES[0].width, SIZES[0].height);
+
+    printf("[HOST] FramePool soak: %u days, %u checks, %u rebuilds (%u deferred), %u failed allocs, "
+           "heap change %+ld B\n", DAYS, DAYS * CHECKS_PER_DAY, (unsigned)FramePool::getRebuilds(), deferred,
+           (unsigned)FramePool::getFailures(), (long)HostHeap::current() - (long)heapBefore);
+    uint32_t classFailures = 0;
+    for (uint8_t k = 0; k < FramePool::KIND_COUNT; k++) {
+        FramePool::Stats stats = FramePool::getStats((FramePool::Kind)k);
+        classFailures += stats.failures;
+        printf("[HOST]   %-6s %7u B x %u: %9u allocs, high water %u, %u failed\n",
+               FramePool::kindName((FramePool::Kind)k), (unsigned)stats.blockSize, stats.blocks,
+               (unsigned)stats.allocs, stats.highWater, (unsigned)stats.failures);
+    }
+    HostCheck::expect(classFailures == 0 && (long)HostHeap::current() <= (long)heapBefore,
+                      "frame pool serves every fitting request and leaks nothing over 28 days");
+    HostBench::run("FramePool alloc+release (after soak)", 1000000, allocReleasePair);
+}
+
+static void publishToBroker(const char* broker, int count) {
+    String host(broker);
+    int colon = host.indexOf(':');
+    uint16_t port = 1883;
+    if (colon >= 0) {
+        port = host.substring(colon + 1).toInt();
+        host = host.substring(0, colon);
+    }
+
+    WiFiClient net;
+    PubSubClient mqtt(net);
+    mqtt.setServer(host.c_str(), port);
+    mqtt.setBufferSize(2048);
+    if (!HostCheck::expect(mqtt.connect(DEVICE_NAME), "MQTT connect to --broker")) {
+        printf("[HOST] MQTT connect to %s:%u failed, state=%d\n", host.c_str(), port, mqtt.state());
+        return;
+    }
+
+    String topicMotion = String("surveillance/") + DEVICE_NAME + "/motion";
+    String topicMetrics = String("surveillance/") + DEVICE_NAME + "/metrics";
+    String output;
+    unsigned long start = micros();
+    for (int i = 0; i < count; i++) {
+        buildMotionPayload(output, i + 1);
+        mqtt.publish(topicMotion.c_str(), output.c_str(), false);
+        mqtt.loop();
+    }
+    buildMetricsPayload(output);
+    mqtt.publish(topicMetrics.c_str(), output.c_str(), false);
+    unsigned long elapsed = micros() - start;
+    printf("[HOST] Published %d motion events to %s:%u in %lu us (%lu bytes sent)\n",
+           count, host.c_str(), port, elapsed, (unsigned long)net.hostBytesSent());
+    mqtt.disconnect();
+}
+
+int main(int argc, char** argv) {
+    const char* broker = nullptr;
+    const char* lumaSequence = nullptr;
+    int count = 100;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--broker") == 0) broker = argv[i + 1];
+        if (strcmp(argv[i], "--count") == 0) count = atoi(argv[i + 1]);
+        if (strcmp(argv[i], "--luma-seq") == 0) lumaSequence = argv[i + 1];
+    }
+
+    WiFi.begin();
+    Trace::init();
+    LoopProfiler::begin(500, 300000, nullptr);
+
+    String output;
+    buildMotionPayload(output, 1);
+    printf("[HOST] motion:  %s\n", output.c_str());
+    buildMetricsPayload(output);
+    printf("[HOST] metrics: %s\n", output.c_str());
+
+    HostBench::run("motion payload serialize", 50000, [&]() {
+        buildMotionPayload(output, 1);
+    });
+    HostBench::run("metrics payload serialize", 20000, [&]() {
+        buildMetricsPayload(output);
+    });
+    HostBench::run("LoopProfiler iteration + 2 regions", 200000, []() {
+        LoopProfiler::Iteration iteration;
+        {
+            LOOP_PROFILE_REGION("outer");
+            LOOP_PROFILE_REGION("inner");
+        }
+    });
+    HostCheck::expect(LoopProfiler::getIterations() == 200000 + 200000 / 10 + 1,   // Warm-up pass included
+                      "LoopProfiler counts every iteration");
+
+    runTracker(lumaSequence);
+    runFramePoolSoak();
+
+    if (LittleFS.begin(true)) {
+        std::vector<uint8_t> capture(CAPTURE_SIZE, 0xA5);
+        HostBench::run("LittleFS write 40 KB capture", 200, [&]() {
+            File f = LittleFS.open("/capture.jpg", FILE_WRITE);
+            f.write(capture.data(), capture.size());
+            f.close();
+        });
+        LittleFS.remove("/capture.jpg");
+    }
+
+    if (broker) {
+        publishToBroker(broker, count);
+    }
+    return HostCheck::exitCode();
+}
+
+#endif // NATIVE_HOST
@@ -0,0 +1,59 @@
+#ifndef CONFIG_PORTAL_H
+#define CONFIG_PORTAL_H
+
+#include <Arduino.h>
+
+/**
+ * @brief WiFiManager configuration portal in non-blocking mode.
+ *
+ * startConfigPortal() used to block the device for up to the portal
+ * timeout: no sampling, no publishing, no OTA. Here the portal runs with
+ * setConfigPortalBlocking(false) and process() is called from loop(), so
+ * the sensor keeps sampling and publishing through the station interface
+ * while the access point serves the portal (AP+STA).
+ *
+ * The portal owns port 80 while it is up; the firmware stops its own web
+ * server and must not switch the radio back to WIFI_STA until process()
+ * reports EVENT_SAVED or EVENT_CLOSED.
+ */
+
+namespace ConfigPortal {
+  enum Event : uint8_t {
+    EVENT_NONE = 0,     // Not running, or still running
+    EVENT_SAVED,        // Settings were saved; getDeviceName() has the field value
+    EVENT_CLOSED        // Timed out or stopped without saving
+  };
+
+  struct Config {
+    const char* apName = "";
+    const char* deviceName = "";     // Default for the device name field
+    uint16_t timeoutSeconds = 300;   // 0: no timeout
+  };
+
+  /**
+   * @brief Connect with the stored credentials; on failure leave the portal
+   * running in the background.
+   * @return true if the station connected (no portal)
+   */
+  bool autoConnect(const Config& config);
+
+  /**
+   * @brief Open the portal and return immediately.
+   * @return false if a portal is already running
+   */
+  bool start(const Config& config);
+
+  void stop();
+
+  /**
+   * @brief Serve the portal. Call every loop() iteration.
+   */
+  Event process();
+
+  bool isActive();
+  const char* getDeviceName();
+  uint32_t getSessions();
+  uint32_t getLastSessionMs();       // Duration of the last (or running) session
+}
+
+#endif // CONFIG_PORTAL_H
@@ -0,0 +1,65 @@
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <Arduino.h>
+#include <FS.h>
+
+/**
+ * @brief Coalesced, power-fail safe persistence for the device configuration.
+ *
+ * The caller owns a plain struct holding every persisted setting. Changes are
+ * only marked dirty and committed once the configuration has been quiet for
+ * a while (or on flush() before sleep/restart), so a burst of MQTT commands
+ * costs one flash write. Each commit goes to the older of two record files
+ * (sequence number + CRC32); a write torn by a brownout leaves the other
+ * record intact and it is picked up on the next boot.
+ *
+ * Wear counters (commits per slot) travel inside the record, so they survive
+ * reboots and can be used to project flash endurance.
+ */
+
+namespace ConfigStore {
+  static const uint8_t SLOT_COUNT = 2;
+
+  /**
+   * @brief Load the newest valid record into data. Call once from setup()
+   *        after the filesystem is mounted.
+   * @param fs Filesystem holding the record files (SPIFFS / LittleFS)
+   * @param data Caller-owned config struct (plain data, no pointers)
+   * @param size sizeof(*data)
+   * @param version Schema version; records with another version are ignored
+   * @param quietMs Commit once no change happened for this long
+   * @param maxDelayMs Commit at the latest this long after the first change
+   * @return true if a record was loaded, false if data was left untouched
+   */
+  bool begin(fs::FS& fs, void* data, uint16_t size, uint16_t version,
+             uint32_t quietMs, uint32_t maxDelayMs);
+
+  /**
+   * @brief Data changed in RAM; schedule a commit.
+   */
+  void markDirty();
+
+  /**
+   * @brief Commit when the quiet period or max delay has elapsed. Call from loop().
+   * After a failed commit, retries back off from the quiet period up to 10 minutes.
+   */
+  void loop();
+
+  /**
+   * @brief Commit pending changes now (before deep sleep, restart or OTA).
+   * @return true if nothing was pending or the commit succeeded
+   */
+  bool flush();
+
+  bool isDirty();
+  uint32_t getCommitDueMs();         // Until loop() commits (0 = now, UINT32_MAX = clean)
+  uint32_t getSequence();            // Sequence number of the active record
+  uint32_t getCommits();             // Record writes since the store was created
+  uint32_t getSlotWrites(uint8_t slot);
+  uint32_t getCommitsThisBoot();
+  uint32_t getCoalesced();           // Changes absorbed without a write this boot
+  uint32_t getCommitFailures();      // Failed or unverifiable writes this boot
+}
+
+#endif // CONFIG_STORE_H
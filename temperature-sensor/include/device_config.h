@@ -22,6 +22,7 @@ static const int ONE_WIRE_PIN = 4;
 // Timing constants
 static const unsigned long WIFI_CHECK_INTERVAL_MS = 15000;    // Check WiFi connection every 15s
 static const unsigned long TEMPERATURE_READ_INTERVAL_MS = 30000;  // Read temperature every 30s
+#define NTP_SERVER "pool.ntp.org"                    // UTC clock for the sample_time of replayed readings
 
 // WiFi mesh roaming configuration
 static const int WIFI_CONSECUTIVE_MQTT_FAILURE_THRESHOLD = 5;     // Force reconnect after 5 consecutive MQTT failures
@@ -123,11 +124,63 @@ static const unsigned long WIFI_PERIODIC_RECONNECT_INTERVAL_MS = 86400000;  // F
 // Disables HTML dashboard (/). Saves memory and reduces bandwidth.
 // #define API_ENDPOINTS_ONLY
 
+// Requests are answered by ESPAsyncWebServer from bodies rendered in loop()
+// (http_snapshot.h): after each reading or setting change, and at least this
+// often so /health uptime and RSSI stay current
+static const unsigned long HTTP_SNAPSHOT_INTERVAL_MS = 5000;
+
+// =============================================================================
+// LIGHT SLEEP (ESP8266 without the GPIO16 -> RST wire)
+// =============================================================================
+// DISABLE_DEEP_SLEEP nodes light-sleep between loop() tasks instead of spinning
+#if defined(ESP8266) && defined(DISABLE_DEEP_SLEEP)
+  #define LIGHT_SLEEP_ENABLED 1
+#else
+  #define LIGHT_SLEEP_ENABLED 0
+#endif
+static const unsigned long LIGHT_SLEEP_MAX_MS = 1000;             // Longest nap (HTTP/OTA/MQTT response time)
+static const uint8_t LIGHT_SLEEP_LISTEN_INTERVAL = 3;             // DTIM beacons slept through
+
+// =============================================================================
+// DEEP-SLEEP WAKE
+// =============================================================================
+// 1 = previous wake flow, timed for comparison: a blocking conversion before
+// WiFi and another after MQTT instead of one conversion overlapping association.
+// Build one node with -DWAKE_SEQUENTIAL_BASELINE=1 to measure the baseline.
+#ifndef WAKE_SEQUENTIAL_BASELINE
+  #define WAKE_SEQUENTIAL_BASELINE 0
+#endif
+
+// =============================================================================
+// ADAPTIVE TX POWER
+// =============================================================================
+// TX power steps down while publishes succeed with RSSI to spare, up on failures
+static const int8_t TX_POWER_TARGET_RSSI = -67;                   // RSSI a reduction may bring the link down to
+static const int8_t TX_POWER_WEAK_RSSI = -75;                     // Step up below this
+static const uint8_t TX_POWER_DOWN_AFTER = 5;                     // Healthy publishes per step down
+static const uint16_t TX_POWER_FLOOR_HOLD = 200;                  // Publishes a failure blocks the weaker level
+
+// =============================================================================
+// LOOP PROFILER
+// =============================================================================
+// loop() iterations at or above the threshold are reported as "loop_stall" events
+static const unsigned long LOOP_STALL_THRESHOLD_MS = 500;         // Iteration time counted as a stall
+static const unsigned long LOOP_STALL_REPORT_INTERVAL_MS = 300000;  // Max one stall event per 5 min
+
+// =============================================================================
+// CONFIG PERSISTENCE
+// =============================================================================
+// Config changes are coalesced in RAM and committed once quiet (or before sleep/restart)
+static const uint16_t CONFIG_SCHEMA_VERSION = 1;                  // Bump when PersistentConfig changes
+static const unsigned long CONFIG_COMMIT_QUIET_MS = 5000;         // Commit after 5 s without changes
+static const unsigned long CONFIG_COMMIT_MAX_DELAY_MS = 60000;    // Commit at most 60 s after the first change
+
 // =============================================================================
 // RESET DETECTION & CRASH RECOVERY (NVS-based, ESP32 only)
 // =============================================================================
 #ifdef ESP32
   // Triple-reset detector (for entering config portal)
+  // Tracked in RTC memory; the window closes from a timer so setup() is not delayed
   #define RESET_DETECT_TIMEOUT 2       // 2 second window for triple-reset
   #define RESET_COUNT_THRESHOLD 3      // Number of resets to trigger config portal
 
@@ -0,0 +1,42 @@
+#ifndef HTTP_SNAPSHOT_H
+#define HTTP_SNAPSHOT_H
+
+#include <Arduino.h>
+#include <memory>
+
+/**
+ * @brief Immutable response bodies shared between loop() and the async web server.
+ *
+ * With ESPAsyncWebServer, request handlers run from the network stack (the
+ * async_tcp task on the ESP32, lwIP callbacks between loop() yields on the
+ * ESP8266), not from loop(). They must not read the firmware's live globals,
+ * which loop() may be rewriting at that moment. Instead loop() renders each
+ * endpoint's body into a slot with publish() and handlers send whatever
+ * get() returns. A published body is never modified: publish() swaps in a
+ * new one, and a handler still sending the old one keeps it alive through
+ * its shared_ptr until the response is done.
+ *
+ * Slot numbers are chosen by the firmware (0 to MAX_SLOTS - 1).
+ */
+
+namespace HttpSnapshot {
+  static const uint8_t MAX_SLOTS = 8;
+
+  typedef std::shared_ptr<const String> Body;
+
+  /**
+   * @brief Replace a slot's body (loop() only).
+   */
+  void publish(uint8_t slot, String&& body);
+
+  /**
+   * @brief Current body of a slot (any task).
+   * @return empty pointer until the slot is first published
+   */
+  Body get(uint8_t slot);
+
+  uint32_t getPublished();          // Bodies published since boot
+  uint32_t getServed();             // get() calls that returned a body
+}
+
+#endif // HTTP_SNAPSHOT_H
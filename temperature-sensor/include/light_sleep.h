@@ -0,0 +1,89 @@
+#ifndef LIGHT_SLEEP_H
+#define LIGHT_SLEEP_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Light sleep between scheduled loop() tasks (ESP8266 without deep sleep).
+ *
+ * Nodes built with DISABLE_DEEP_SLEEP (no GPIO16 -> RST wire) otherwise spin
+ * loop() with the radio fully on between 30 s samples. Each iteration builds
+ * a Plan from the loop's own timers (publish, WiFi check, MQTT check, ...);
+ * nap() then waits until the earliest of them with the WiFi sleep type set to
+ * light sleep, so the SDK powers the CPU and modem down between DTIM beacons
+ * and wakes on its timer. The station stays associated.
+ *
+ * A nap never exceeds maxSleepMs (HTTP, OTA and inbound MQTT wait at most that
+ * long) nor half the MQTT keepalive, so PubSubClient's loop() still sends its
+ * PINGREQ in time. Waits shorter than minSleepMs are skipped.
+ *
+ * Planning is plain arithmetic on millis() values and runs on the host.
+ * Current draw is an estimate from time awake and asleep (CURRENT_*_MA,
+ * ESP8266 typicals); the baseline is the same time fully awake, which is the
+ * WIFI_NONE_SLEEP mode these nodes ran in.
+ */
+
+namespace LightSleep {
+  static const float CURRENT_AWAKE_MA = 70.0f;   // 80 MHz, radio on
+  static const float CURRENT_SLEEP_MA = 2.0f;    // Light sleep, beacon wake-ups averaged in
+
+  struct Config {
+    uint32_t minSleepMs = 10;        // Shorter waits are not worth a nap
+    uint32_t maxSleepMs = 1000;      // Longest nap
+    uint32_t keepAliveMs = 30000;    // MQTT keepalive; naps stay under half of it
+    uint8_t listenInterval = 3;      // DTIM beacons slept through (0: AP's DTIM)
+  };
+
+  struct Stats {
+    uint32_t naps;
+    uint32_t skipped;                // Iterations whose next task was too close to nap
+    uint32_t longestNapMs;
+    uint64_t awakeMs;                // Between naps
+    uint64_t sleptMs;                // In nap()
+  };
+
+  /**
+   * @brief Next-task deadline for one loop() iteration.
+   */
+  class Plan {
+  public:
+    explicit Plan(uint32_t nowMs);
+    void every(uint32_t lastMs, uint32_t intervalMs);   // Periodic task, due intervalMs after lastMs
+    void busy();                                        // Work pending now: no nap
+    uint32_t dueInMs() const { return _dueInMs; }
+  private:
+    uint32_t _nowMs;
+    uint32_t _dueInMs;
+  };
+
+  /**
+   * @brief Switch the WiFi sleep type to light sleep. Call from setup() once
+   * WiFi is up.
+   */
+  void begin(const Config& config);
+
+  /**
+   * @brief Nap length for a plan: dueInMs() capped by maxSleepMs and half the
+   * keepalive, 0 below minSleepMs.
+   */
+  uint32_t getNapMs(const Plan& plan);
+
+  /**
+   * @brief Start of loop(): wait for the next task with light sleep allowed.
+   * @return Milliseconds waited
+   */
+  uint32_t nap(const Plan& plan);
+
+  void getStats(Stats& stats);
+
+  /**
+   * @brief Estimated average current for a split of time between awake and asleep.
+   */
+  float estimateCurrentMa(uint64_t awakeMs, uint64_t sleptMs);
+
+  float getCurrentMa();                // Since begin()
+  float getBaselineCurrentMa();        // Same period without naps
+  float getSleepRatio();
+}
+
+#endif // LIGHT_SLEEP_H
@@ -0,0 +1,81 @@
+#ifndef TX_POWER_H
+#define TX_POWER_H
+
+#include <Arduino.h>
+
+/**
+ * @brief RSSI-adaptive WiFi TX power.
+ *
+ * The radio transmits at 19.5 dBm by default; a node a few meters from its
+ * access point needs far less. After each publish the controller is told the
+ * RSSI and whether the publish went through. It steps one level down after
+ * downAfter healthy publishes, as long as the total reduction stays within
+ * the RSSI headroom above targetRssi (the link is assumed symmetric), and
+ * one level up on a failed publish, an RSSI below weakRssi or a reduction
+ * the headroom no longer covers. A failure also pins the weakest allowed
+ * level for floorHoldPublishes publishes so the node does not walk straight
+ * back into it.
+ *
+ * The learned level lives in RTC memory (magic + CRC), so it survives deep
+ * sleep but not a power cycle.
+ *
+ * Radio energy per publish is an estimate: airtime of the payload plus
+ * TCP/IP/MQTT overhead at a conservative PHY rate, times the typical TX
+ * current at the active level. Savings compare against the same publishes at
+ * full power.
+ */
+
+namespace TxPower {
+  static const uint8_t LEVEL_COUNT = 8;
+
+  struct Config {
+    int8_t targetRssi = -67;           // dBm the link should keep after a reduction
+    int8_t weakRssi = -75;             // Step up below this
+    uint8_t downAfter = 5;             // Healthy publishes before a step down
+    uint16_t floorHoldPublishes = 200; // Publishes a failure keeps the level from dropping back
+  };
+
+  struct Stats {
+    uint32_t publishes;
+    uint32_t failures;
+    uint32_t stepsDown;
+    uint32_t stepsUp;
+    float energyUj;                    // Estimated TX energy of all publishes
+    float fullPowerEnergyUj;           // Same publishes at full power
+  };
+
+  /**
+   * @brief Restore the level from RTC memory (or start at full power) and
+   * apply it. Call once WiFi is started.
+   */
+  void begin(const Config& config);
+
+  /**
+   * @brief Re-apply the level, e.g. after the WiFi interface was restarted.
+   */
+  void apply();
+
+  /**
+   * @brief Back to full power with the floor released, e.g. after roaming to
+   * another access point.
+   */
+  void reset();
+
+  /**
+   * @brief Feed one publish result.
+   * @param rssi Current RSSI in dBm
+   * @param published The broker accepted the publish
+   * @param bytes Payload size, for the energy estimate
+   */
+  void report(int rssi, bool published, size_t bytes);
+
+  uint8_t getLevel();                  // 0 = full power
+  float getDbm();
+  void getStats(Stats& stats);
+
+  float estimateEnergyUj(uint8_t level, size_t bytes);
+  float getEnergyPerPublishUj();       // Average since boot
+  float getSavedPercent();             // Against full power
+}
+
+#endif // TX_POWER_H
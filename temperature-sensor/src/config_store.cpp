@@ -0,0 +1,239 @@
+#include "config_store.h"
+
+namespace ConfigStore {
+  static const uint32_t RECORD_MAGIC = 0x43464731;  // "CFG1"
+  static const uint16_t MAX_PAYLOAD = 1024;
+  static const char* SLOT_PATHS[SLOT_COUNT] = {"/config_a.bin", "/config_b.bin"};
+  static const uint32_t MAX_RETRY_DELAY_MS = 600000;  // Backoff cap after failed commits
+
+  struct RecordHeader {
+    uint32_t magic;
+    uint32_t sequence;
+    uint16_t version;
+    uint16_t size;
+    uint32_t slotWrites[SLOT_COUNT];  // Cumulative wear, carried from record to record
+    uint32_t crc;                     // Over the header up to here and the payload
+  };
+
+  static fs::FS* s_fs = nullptr;
+  static uint8_t* s_data = nullptr;
+  static uint8_t* s_committed = nullptr;   // Payload of the active record
+  static uint16_t s_size = 0;
+  static uint16_t s_version = 0;
+  static uint32_t s_quietMs = 5000;
+  static uint32_t s_maxDelayMs = 60000;
+
+  static bool s_hasRecord = false;
+  static uint8_t s_activeSlot = 0;
+  static uint32_t s_sequence = 0;
+  static uint32_t s_slotWrites[SLOT_COUNT] = {0};
+
+  static bool s_dirty = false;
+  static unsigned long s_firstChangeMs = 0;
+  static unsigned long s_lastChangeMs = 0;
+  static uint32_t s_commitsThisBoot = 0;
+  static uint32_t s_coalesced = 0;
+  static uint32_t s_failures = 0;
+  static uint32_t s_retryDelayMs = 0;              // 0 unless the last commit failed
+  static unsigned long s_failedMs = 0;
+
+  static uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t length) {
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+      crc ^= data[i];
+      for (uint8_t bit = 0; bit < 8; bit++) {
+        crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+      }
+    }
+    return ~crc;
+  }
+
+  static uint32_t recordCrc(const RecordHeader& header, const uint8_t* payload) {
+    uint32_t crc = crc32Update(0, (const uint8_t*)&header, offsetof(RecordHeader, crc));
+    return crc32Update(crc, payload, header.size);
+  }
+
+  // Read one slot; payload must hold MAX_PAYLOAD bytes. Returns false if missing or corrupt.
+  static bool readSlot(uint8_t slot, RecordHeader& header, uint8_t* payload) {
+    File file = s_fs->open(SLOT_PATHS[slot], "r");
+    if (!file) {
+      return false;
+    }
+    bool ok = file.read((uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+              header.magic == RECORD_MAGIC && header.size <= MAX_PAYLOAD &&
+              file.read(payload, header.size) == header.size &&
+              header.crc == recordCrc(header, payload);
+    file.close();
+    return ok;
+  }
+
+  bool begin(fs::FS& fs, void* data, uint16_t size, uint16_t version,
+             uint32_t quietMs, uint32_t maxDelayMs) {
+    s_fs = &fs;
+    s_data = (uint8_t*)data;
+    s_size = size;
+    s_version = version;
+    s_quietMs = quietMs;
+    s_maxDelayMs = maxDelayMs;
+    s_hasRecord = false;
+    s_sequence = 0;
+    s_dirty = false;
+    s_retryDelayMs = 0;
+    memset(s_slotWrites, 0, sizeof(s_slotWrites));
+    free(s_committed);
+    s_committed = (uint8_t*)malloc(size);
+    uint8_t* payload = (uint8_t*)malloc(MAX_PAYLOAD);
+    if (!s_committed || !payload || size > MAX_PAYLOAD) {
+      Serial.println("[CONFIG] Store unavailable (allocation failed)");
+      free(payload);
+      return false;
+    }
+
+    for (uint8_t slot = 0; slot < SLOT_COUNT; slot++) {
+      RecordHeader header;
+      if (!readSlot(slot, header, payload)) {
+        continue;
+      }
+      // Keep wear history even from records of another schema version
+      for (uint8_t i = 0; i < SLOT_COUNT; i++) {
+        s_slotWrites[i] = max(s_slotWrites[i], header.slotWrites[i]);
+      }
+      if (header.version != version || header.size != size) {
+        continue;
+      }
+      if (!s_hasRecord || (int32_t)(header.sequence - s_sequence) > 0) {
+        s_hasRecord = true;
+        s_activeSlot = slot;
+        s_sequence = header.sequence;
+        memcpy(s_data, payload, size);
+      }
+    }
+    free(payload);
+
+    if (s_hasRecord) {
+      memcpy(s_committed, s_data, size);
+      Serial.printf("[CONFIG] Loaded record #%lu from slot %u\n", (unsigned long)s_sequence, s_activeSlot);
+    } else {
+      Serial.println("[CONFIG] No valid config record");
+    }
+    return s_hasRecord;
+  }
+
+  void markDirty() {
+    unsigned long now = millis();
+    if (s_dirty) {
+      s_coalesced++;
+    } else {
+      s_firstChangeMs = now;
+    }
+    s_dirty = true;
+    s_lastChangeMs = now;
+  }
+
+  static bool commit() {
+    if (!s_fs || !s_committed) {
+      return false;
+    }
+    if (s_hasRecord && memcmp(s_data, s_committed, s_size) == 0) {
+      // Changed back to what is already stored
+      s_dirty = false;
+      s_coalesced++;
+      return true;
+    }
+
+    // Never overwrite the active record: a torn write must leave it intact
+    uint8_t slot = s_hasRecord ? (s_activeSlot + 1) % SLOT_COUNT : 0;
+    s_slotWrites[slot]++;
+
+    RecordHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = RECORD_MAGIC;
+    header.sequence = s_sequence + 1;
+    header.version = s_version;
+    header.size = s_size;
+    memcpy(header.slotWrites, s_slotWrites, sizeof(s_slotWrites));
+    header.crc = recordCrc(header, s_data);
+
+    bool written = false;
+    File file = s_fs->open(SLOT_PATHS[slot], "w");
+    if (file) {
+      written = file.write((const uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+                file.write(s_data, s_size) == s_size;
+      file.close();
+    }
+
+    // Read back before switching over
+    RecordHeader check;
+    uint8_t* payload = (uint8_t*)malloc(MAX_PAYLOAD);
+    bool verified = written && payload && readSlot(slot, check, payload) &&
+                    check.sequence == header.sequence && memcmp(payload, s_data, s_size) == 0;
+    free(payload);
+
+    if (!verified) {
+      // Back off (quiet period, doubling up to 10 min) so a full or failing
+      // filesystem is not rewritten on every loop() pass
+      s_failures++;
+      s_failedMs = millis();
+      s_retryDelayMs = s_retryDelayMs ? min(s_retryDelayMs * 2, MAX_RETRY_DELAY_MS) : max(s_quietMs, (uint32_t)1000);
+      Serial.printf("[CONFIG] Commit to slot %u failed, retry in %lu s\n", slot,
+                    (unsigned long)(s_retryDelayMs / 1000));
+      return false;
+    }
+
+    s_hasRecord = true;
+    s_activeSlot = slot;
+    s_sequence = header.sequence;
+    memcpy(s_committed, s_data, s_size);
+    s_dirty = false;
+    s_retryDelayMs = 0;
+    s_commitsThisBoot++;
+    Serial.printf("[CONFIG] Committed record #%lu to slot %u (%lu changes coalesced)\n",
+                  (unsigned long)s_sequence, slot, (unsigned long)s_coalesced);
+    return true;
+  }
+
+  static uint32_t remainingMs(unsigned long now, unsigned long sinceMs, uint32_t intervalMs) {
+    unsigned long elapsed = now - sinceMs;
+    return elapsed >= intervalMs ? 0 : intervalMs - elapsed;
+  }
+
+  uint32_t getCommitDueMs() {
+    if (!s_dirty) {
+      return UINT32_MAX;
+    }
+    unsigned long now = millis();
+    uint32_t dueMs = min(remainingMs(now, s_lastChangeMs, s_quietMs), remainingMs(now, s_firstChangeMs, s_maxDelayMs));
+    if (s_retryDelayMs) {
+      dueMs = max(dueMs, remainingMs(now, s_failedMs, s_retryDelayMs));
+    }
+    return dueMs;
+  }
+
+  void loop() {
+    if (s_dirty && getCommitDueMs() == 0) {
+      commit();
+    }
+  }
+
+  bool flush() {
+    return !s_dirty || commit();
+  }
+
+  bool isDirty() { return s_dirty; }
+  uint32_t getSequence() { return s_sequence; }
+  uint32_t getCommitsThisBoot() { return s_commitsThisBoot; }
+  uint32_t getCoalesced() { return s_coalesced; }
+  uint32_t getCommitFailures() { return s_failures; }
+
+  uint32_t getSlotWrites(uint8_t slot) {
+    return slot < SLOT_COUNT ? s_slotWrites[slot] : 0;
+  }
+
+  uint32_t getCommits() {
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < SLOT_COUNT; i++) {
+      total += s_slotWrites[i];
+    }
+    return total;
+  }
+}
@@ -0,0 +1,555 @@
+/**
+ * host_main.cpp
+ *
+ * Native host runner for the temperature sensor (env:native, not part of the
+ * firmware image). Benchmarks the per-cycle hot paths (payload serialization,
+ * loop profiler, NVS and SPIFFS access), compares String vs streamed MQTT
+ * publishing, checks config commit coalescing and torn-write recovery, and
+ * optionally publishes the payloads to a local MQTT broker through the real
+ * PubSubClient. The light-sleep planner is run against an hour of the
+ * firmware's loop() timers. HTTP serving is load-tested both ways: requests
+ * answered inside loop() (the former synchronous WebServer) and async
+ * handlers reading HttpSnapshot bodies, comparing the longest loop() iteration.
+ *
+ * Usage:
+ *   pio run -e native -t exec
+ *   .pio/build/native/program [--broker host:port] [--count N]
+ *
+ * NVS and SPIFFS are backed by files under $HOST_FS_ROOT (default .host_fs).
+ */
+
+#ifdef NATIVE_HOST
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <PubSubClient.h>
+#include <Preferences.h>
+#include <SPIFFS.h>
+#include <WiFi.h>
+#include <HostBench.h>
+#include <HostCheck.h>
+#include <HostHeap.h>
+#include <HostMqttSink.h>
+
+#include "loop_profiler.h"
+#include "config_store.h"
+#include "mqtt_json.h"
+#include "light_sleep.h"
+#include "tx_power.h"
+#include "http_snapshot.h"
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+static const char* DEVICE_NAME = "host-temp";
+static const char* CHIP_ID = "host0000";
+
+// Same shape as publishTemperature() in main.cpp
+static size_t buildTemperaturePayload(char* buffer, size_t size, float celsius) {
+  JsonDocument doc;
+  doc["device"] = DEVICE_NAME;
+  doc["chip_id"] = CHIP_ID;
+  doc["schema_version"] = 1;
+  doc["timestamp"] = millis() / 1000;
+  doc["celsius"] = celsius;
+  doc["fahrenheit"] = celsius * 9.0f / 5.0f + 32.0f;
+  return serializeJson(doc, buffer, size);
+}
+
+// Same shape as publishStatus() in main.cpp
+static void fillStatus(JsonDocument& doc) {
+  doc["device"] = DEVICE_NAME;
+  doc["chip_id"] = CHIP_ID;
+  doc["firmware_version"] = "host";
+  doc["schema_version"] = 1;
+  doc["timestamp"] = millis() / 1000;
+  doc["uptime_seconds"] = millis() / 1000;
+  doc["wifi_connected"] = (WiFi.status() == WL_CONNECTED);
+  doc["wifi_rssi"] = WiFi.RSSI();
+  doc["free_heap"] = ESP.getFreeHeap();
+  doc["sensor_healthy"] = true;
+  doc["wifi_reconnects"] = 0;
+  doc["sensor_read_failures"] = 0;
+  doc["deep_sleep_enabled"] = false;
+  doc["deep_sleep_seconds"] = 0;
+  doc["sensor_interval_seconds"] = 30;
+  doc["loop_max_ms"] = LoopProfiler::getMaxIterationMs();
+  doc["loop_stalls"] = LoopProfiler::getStallCount();
+}
+
+static size_t buildStatusPayload(char* buffer, size_t size) {
+  JsonDocument doc;
+  fillStatus(doc);
+  return serializeJson(doc, buffer, size);
+}
+
+// Previous publishJson() (String copy + PubSubClient buffer copy) vs MqttJson
+// streaming, against an in-memory broker so only the device-side cost counts
+static void comparePublishPaths() {
+  HostMqttSink sink;
+  PubSubClient mqtt(sink);
+  mqtt.setServer("sink", 1883);
+  mqtt.setBufferSize(2048);
+  mqtt.connect(DEVICE_NAME);
+
+  JsonDocument doc;
+  fillStatus(doc);
+  const char* topic = "esp-sensor-hub/host-temp/status";
+  auto legacy = [&]() {
+    String payload;
+    serializeJson(doc, payload);
+    mqtt.publish(topic, payload.c_str(), true);
+  };
+  auto streamed = [&]() {
+    MqttJson::publish(mqtt, topic, doc, true);
+  };
+
+  size_t legacyHeap = HostHeap::measurePeak(legacy);
+  size_t streamedHeap = HostHeap::measurePeak(streamed);
+  sink.hostResetCounters();
+  legacy();
+  uint64_t legacyWrites = sink.hostWrites();
+  sink.hostResetCounters();
+  streamed();
+  uint64_t streamedWrites = sink.hostWrites();
+
+  HostBench::run("status publish: String + publish()", 20000, legacy);
+  HostBench::run("status publish: MqttJson stream", 20000, streamed);
+  printf("[HOST] Status publish (%u B payload): peak heap %u B -> %u B (+%d B stack chunk), "
+         "client writes %llu -> %llu, MQTT buffer needed %u B -> topic only\n",
+         (unsigned)measureJson(doc), (unsigned)legacyHeap, (unsigned)streamedHeap, MQTT_JSON_CHUNK_SIZE,
+         (unsigned long long)legacyWrites, (unsigned long long)streamedWrites,
+         (unsigned)(measureJson(doc) + strlen(topic) + 7));
+  if (!HostHeap::available()) {
+    printf("[HOST] Heap accounting needs glibc; peak heap values above read 0\n");
+  }
+}
+
+// Same shape as PersistentConfig in main.cpp
+struct HostConfig {
+  char deviceName[40];
+  int32_t deepSleepSeconds;
+  int32_t sensorIntervalSeconds;
+};
+
+// A burst of MQTT reconfiguration commands should cost one record write, and a
+// torn write of the newest record should fall back to the previous one
+static void checkConfigStore() {
+  HostConfig config = {"host-temp", 0, 30};
+  ConfigStore::begin(SPIFFS, &config, sizeof(config), 1, 5000, 60000);
+  ConfigStore::markDirty();
+  ConfigStore::flush();
+  uint32_t commitsBefore = ConfigStore::getCommits();
+  uint64_t bytesBefore = SPIFFS.hostBytesWritten();
+
+  for (int i = 0; i < 20; i++) {
+    config.sensorIntervalSeconds = 30 + i;
+    config.deepSleepSeconds = i % 2 ? 300 : 0;
+    ConfigStore::markDirty();
+    ConfigStore::loop();
+  }
+  ConfigStore::flush();
+  uint32_t burstCommits = ConfigStore::getCommits() - commitsBefore;
+  printf("[HOST] Config burst: 20 changes -> %lu commit(s), %lu bytes written, slot writes %lu/%lu\n",
+         (unsigned long)burstCommits,
+         (unsigned long)(SPIFFS.hostBytesWritten() - bytesBefore),
+         (unsigned long)ConfigStore::getSlotWrites(0), (unsigned long)ConfigStore::getSlotWrites(1));
+  HostCheck::expect(burstCommits == 1, "config burst coalesces into one commit");
+
+  // Truncate the record just written, as a brownout mid-write would
+  uint32_t sequence = ConfigStore::getSequence();
+  const char* newest = (sequence % 2) ? "/config_a.bin" : "/config_b.bin";
+  File torn = SPIFFS.open(newest, FILE_WRITE);
+  torn.write((const uint8_t*)"CFG", 3);
+  torn.close();
+  HostConfig reloaded = {"", -1, -1};
+  bool loaded = ConfigStore::begin(SPIFFS, &reloaded, sizeof(reloaded), 1, 5000, 60000);
+  printf("[HOST] Torn write: loaded=%d record #%lu (was #%lu), interval %ld s\n",
+         loaded, (unsigned long)ConfigStore::getSequence(), (unsigned long)sequence,
+         (long)reloaded.sensorIntervalSeconds);
+  HostCheck::expect(loaded && ConfigStore::getSequence() == sequence - 1 && reloaded.sensorIntervalSeconds == 30,
+                    "torn config write falls back to the previous record");
+
+  // A filesystem that refuses every write (never mounted): past the max delay,
+  // loop() must back off instead of retrying on every pass
+  fs::FS broken("broken");
+  ConfigStore::begin(broken, &reloaded, sizeof(reloaded), 1, 0, 0);
+  uint32_t failuresBefore = ConfigStore::getCommitFailures();
+  ConfigStore::markDirty();
+  for (int i = 0; i < 100000; i++) {
+    ConfigStore::loop();
+  }
+  uint32_t failedCommits = ConfigStore::getCommitFailures() - failuresBefore;
+  printf("[HOST] Failing filesystem: 100000 loop() passes -> %lu commit attempt(s), next in %lu ms\n",
+         (unsigned long)failedCommits, (unsigned long)ConfigStore::getCommitDueMs());
+  HostCheck::expect(failedCommits == 1 && ConfigStore::getCommitDueMs() > 0,
+                    "failed config commits back off instead of retrying every loop()");
+}
+
+// One simulated hour of a DISABLE_DEEP_SLEEP node: loop() timers as in
+// main.cpp, 2 ms of work per iteration, 800 ms per 30 s sample (DS18B20
+// conversion + publish). Every task must run when due, and MQTT loop() must
+// run well within the keepalive.
+static void checkLightSleep() {
+  const uint32_t DURATION_MS = 3600UL * 1000;
+  const uint32_t WORK_MS = 2;
+  const uint32_t SAMPLE_MS = 800;
+  const uint32_t KEEPALIVE_MS = 30000;
+  const uint32_t intervals[] = {30000, 15000, 30000, 30000};   // publish, WiFi, MQTT check, status log
+  const uint8_t TASKS = sizeof(intervals) / sizeof(intervals[0]);
+
+  LightSleep::Config config;
+  config.keepAliveMs = KEEPALIVE_MS;
+  LightSleep::begin(config);
+
+  uint32_t last[TASKS] = {0, 0, 0, 0};
+  uint32_t t = 0;
+  uint64_t awakeMs = 0;
+  uint64_t sleptMs = 0;
+  uint32_t iterations = 0;
+  uint32_t maxLateMs = 0;
+  uint32_t maxLoopGapMs = 0;
+  uint32_t lastLoopMs = 0;
+  while (t < DURATION_MS) {
+    LightSleep::Plan plan(t);
+    for (uint8_t i = 0; i < TASKS; i++) {
+      plan.every(last[i], intervals[i]);
+    }
+    uint32_t napMs = LightSleep::getNapMs(plan);
+    t += napMs;
+    sleptMs += napMs;
+
+    // Iteration: mqttClient.loop() first, then the timers that are due
+    maxLoopGapMs = max(maxLoopGapMs, t - lastLoopMs);
+    lastLoopMs = t;
+    uint32_t workMs = WORK_MS;
+    for (uint8_t i = 0; i < TASKS; i++) {
+      if (t - last[i] >= intervals[i]) {
+        maxLateMs = max(maxLateMs, t - last[i] - intervals[i]);
+        last[i] = t;
+        workMs += i == 0 ? SAMPLE_MS : 1;
+      }
+    }
+    t += workMs;
+    awakeMs += workMs;
+    iterations++;
+  }
+
+  printf("[HOST] Light sleep hour: %lu iterations, %.1f%% asleep, task lateness max %lu ms, "
+         "MQTT loop gap max %lu ms (keepalive %lu ms)\n",
+         (unsigned long)iterations, 100.0f * sleptMs / (awakeMs + sleptMs), (unsigned long)maxLateMs,
+         (unsigned long)maxLoopGapMs, (unsigned long)KEEPALIVE_MS);
+  printf("[HOST] Light sleep estimate: %.1f mA vs %.1f mA awake (WIFI_NONE_SLEEP spin)\n",
+         LightSleep::estimateCurrentMa(awakeMs, sleptMs), LightSleep::getBaselineCurrentMa());
+  HostCheck::expect(maxLateMs == 0 && maxLoopGapMs < KEEPALIVE_MS / 2,
+                    "light sleep runs every task on time and MQTT well within the keepalive");
+  HostCheck::expect(LightSleep::estimateCurrentMa(awakeMs, sleptMs) < LightSleep::getBaselineCurrentMa(),
+                    "light sleep draws less than the always-awake baseline");
+  HostBench::run("LightSleep plan (5 timers) + getNapMs", 1000000, [&]() {
+    LightSleep::Plan plan(t);
+    for (uint8_t i = 0; i < TASKS; i++) {
+      plan.every(last[i], intervals[i]);
+    }
+    plan.every(t - 3000, 5000);
+    HostBench::keep(LightSleep::getNapMs(plan));
+  });
+}
+
+static void checkTxPower() {
+  // Simulated link: downlink RSSI around a base with +/-4 dB of fading; the
+  // uplink is the same path minus the TX reduction and fails below the AP's
+  // sensitivity. Publishes 800-1100 see a 20 dB drop (a door closes).
+  const int PUBLISHES = 2000;
+  const int SENSITIVITY_DBM = -82;
+  const int BASE_RSSI = -50;
+  char buffer[256];
+  size_t bytes = buildTemperaturePayload(buffer, sizeof(buffer), 21.5f);
+
+  TxPower::Config config;
+  TxPower::begin(config);
+  TxPower::reset();
+  srand(42);
+  uint32_t fixedFailures = 0;
+  uint8_t levelBeforeDrop = 0;
+  for (int i = 0; i < PUBLISHES; i++) {
+    int base = (i >= 800 && i < 1100) ? BASE_RSSI - 20 : BASE_RSSI;
+    int rssi = base + (rand() % 9) - 4;
+    float reductionDb = 19.5f - TxPower::getDbm();
+    int fade = (rand() % 9) - 4;              // Uplink fades independently
+    bool published = rssi + fade - reductionDb >= SENSITIVITY_DBM;
+    if (rssi + fade < SENSITIVITY_DBM) {
+      fixedFailures++;
+    }
+    if (i == 799) {
+      levelBeforeDrop = TxPower::getLevel();
+    }
+    TxPower::report(rssi, published, bytes);
+  }
+
+  TxPower::Stats stats;
+  TxPower::getStats(stats);
+  printf("[HOST] TX power: %u publishes, %lu failed (%lu at fixed 19.5 dBm), %lu steps down, %lu up, "
+         "level %u before the drop, %.1f dBm at the end\n",
+         PUBLISHES, (unsigned long)stats.failures, (unsigned long)fixedFailures,
+         (unsigned long)stats.stepsDown, (unsigned long)stats.stepsUp, levelBeforeDrop, TxPower::getDbm());
+  printf("[HOST] TX energy estimate: %.1f uJ per %u-byte publish vs %.1f uJ at full power (%.1f%% saved)\n",
+         TxPower::getEnergyPerPublishUj(), (unsigned)bytes, TxPower::estimateEnergyUj(0, bytes),
+         TxPower::getSavedPercent());
+  HostCheck::expect(stats.failures <= PUBLISHES / 100 && stats.stepsUp > 0 && TxPower::getSavedPercent() > 0,
+                    "adaptive TX power saves energy, backs off on the drop and loses under 1% of publishes");
+  HostBench::run("TxPower::report", 1000000, [&]() {
+    TxPower::report(-55, true, bytes);
+  });
+  TxPower::reset();
+}
+
+// Time a request held the old synchronous WebServer, which read the headers
+// and wrote the response from inside loop(): most clients are quick, a
+// weak-signal phone or a half-open browser socket is not
+static uint32_t clientTransferMs(std::mt19937& rng) {
+  if (std::uniform_int_distribution<int>(0, 99)(rng) < 10) {
+    return std::uniform_int_distribution<uint32_t>(400, 1500)(rng);
+  }
+  return std::uniform_int_distribution<uint32_t>(5, 60)(rng);
+}
+
+// Stand-in for getHealthStatus(): ~600 bytes repeating the render sequence,
+// so a body modified while a client reads it shows up as inconsistent
+static String renderTestBody(uint32_t sequence) {
+  char item[16];
+  snprintf(item, sizeof(item), "%08lu,", (unsigned long)sequence);
+  String body;
+  body.reserve(600);
+  while (body.length() + strlen(item) <= 600) {
+    body += item;
+  }
+  return body;
+}
+
+static bool bodyConsistent(const String& body) {
+  const char* text = body.c_str();
+  for (size_t i = 9; i < body.length(); i++) {
+    if (text[i] != text[i % 9]) {
+      return false;
+    }
+  }
+  return body.length() > 0;
+}
+
+struct HttpLoadResult {
+  uint32_t requests;
+  uint32_t maxIterationMs;
+  uint32_t stalls;
+  uint32_t torn;
+};
+
+static void runHttpLoad(bool async, HttpLoadResult& result) {
+  const uint32_t RUN_MS = 2000;
+  const uint32_t CLIENTS = 4;
+  const uint32_t POLL_MS = 200;
+  const uint32_t RENDER_MS = 50;             // HTTP_SNAPSHOT_INTERVAL_MS, sped up
+  const uint32_t STALL_MS = 500;             // LoopProfiler stall threshold
+  std::atomic<bool> running(true);
+  std::atomic<uint32_t> requests(0);
+  std::atomic<uint32_t> torn(0);
+  std::mutex backlogMutex;
+  std::deque<uint32_t> backlog;              // Connections waiting for handleClient()
+
+  std::vector<std::thread> clients;
+  for (uint32_t c = 0; c < CLIENTS; c++) {
+    clients.emplace_back([&, c]() {
+      std::mt19937 rng(c + 1);
+      while (running) {
+        uint32_t transferMs = clientTransferMs(rng);
+        if (async) {
+          // The transfer happens in the network task; the body is a snapshot
+          std::this_thread::sleep_for(std::chrono::milliseconds(transferMs));
+          HttpSnapshot::Body body = HttpSnapshot::get(0);
+          if (body && !bodyConsistent(*body)) {
+            torn++;
+          }
+          requests++;
+        } else {
+          std::lock_guard<std::mutex> guard(backlogMutex);
+          if (backlog.size() < 5) {          // lwIP listen backlog
+            backlog.push_back(transferMs);
+          }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(POLL_MS));
+      }
+    });
+  }
+
+  uint32_t sequence = 0;
+  uint32_t lastRender = 0;
+  uint32_t maxUs = 0;
+  uint32_t stalls = 0;
+  uint32_t start = millis();
+  while (millis() - start < RUN_MS) {
+    uint32_t iterationStart = micros();
+    std::this_thread::sleep_for(std::chrono::microseconds(500));   // Sensor, MQTT, WiFi checks
+    if (async) {
+      if (millis() - lastRender >= RENDER_MS) {
+        HttpSnapshot::publish(0, renderTestBody(++sequence));
+        lastRender = millis();
+      }
+    } else {
+      // handleClient(): one connection per call, read and answered inline
+      bool pending = false;
+      uint32_t transferMs = 0;
+      {
+        std::lock_guard<std::mutex> guard(backlogMutex);
+        if (!backlog.empty()) {
+          transferMs = backlog.front();
+          backlog.pop_front();
+          pending = true;
+        }
+      }
+      if (pending) {
+        String body = renderTestBody(++sequence);
+        HostBench::keep(body);
+        std::this_thread::sleep_for(std::chrono::milliseconds(transferMs));
+        requests++;
+      }
+    }
+    uint32_t us = micros() - iterationStart;
+    maxUs = max(maxUs, us);
+    if (us >= STALL_MS * 1000) {
+      stalls++;
+    }
+  }
+  running = false;
+  for (std::thread& client : clients) {
+    client.join();
+  }
+  result.requests = requests;
+  result.maxIterationMs = maxUs / 1000;
+  result.stalls = stalls;
+  result.torn = torn;
+}
+
+static void checkHttpServing() {
+  HttpLoadResult inlineResult;
+  HttpLoadResult asyncResult;
+  runHttpLoad(false, inlineResult);
+  runHttpLoad(true, asyncResult);
+  printf("[HOST] HTTP, 4 clients for 2 s, served in loop(): %lu requests, loop max %lu ms, %lu stalls\n",
+         (unsigned long)inlineResult.requests, (unsigned long)inlineResult.maxIterationMs,
+         (unsigned long)inlineResult.stalls);
+  printf("[HOST] HTTP, 4 clients for 2 s, async snapshots:  %lu requests, loop max %lu ms, %lu stalls, "
+         "%lu inconsistent bodies\n",
+         (unsigned long)asyncResult.requests, (unsigned long)asyncResult.maxIterationMs,
+         (unsigned long)asyncResult.stalls, (unsigned long)asyncResult.torn);
+  HostCheck::expect(inlineResult.stalls > 0, "HTTP served inside loop() stalls it (simulation premise)");
+  HostCheck::expect(asyncResult.stalls == 0 && asyncResult.torn == 0,
+                    "async HTTP never stalls loop() or serves an inconsistent body");
+
+  String body = renderTestBody(1);
+  HostBench::run("HttpSnapshot publish (600 bytes)", 200000, [&]() {
+    HttpSnapshot::publish(1, String(body));
+  });
+  HostBench::run("HttpSnapshot get", 1000000, []() {
+    HostBench::keep(HttpSnapshot::get(1));
+  });
+}
+
+static void publishToBroker(const char* broker, int count) {
+  String host(broker);
+  int colon = host.indexOf(':');
+  uint16_t port = 1883;
+  if (colon >= 0) {
+    port = host.substring(colon + 1).toInt();
+    host = host.substring(0, colon);
+  }
+
+  WiFiClient net;
+  PubSubClient mqtt(net);
+  mqtt.setServer(host.c_str(), port);
+  mqtt.setBufferSize(2048);
+  if (!HostCheck::expect(mqtt.connect(DEVICE_NAME), "MQTT connect to --broker")) {
+    printf("[HOST] MQTT connect to %s:%u failed, state=%d\n", host.c_str(), port, mqtt.state());
+    return;
+  }
+
+  String topicTemperature = String("esp-sensor-hub/") + DEVICE_NAME + "/temperature";
+  String topicStatus = String("esp-sensor-hub/") + DEVICE_NAME + "/status";
+  char buffer[512];
+  unsigned long start = micros();
+  for (int i = 0; i < count; i++) {
+    size_t len = buildTemperaturePayload(buffer, sizeof(buffer), 20.0f + (i % 50) * 0.1f);
+    mqtt.publish(topicTemperature.c_str(), (const uint8_t*)buffer, len, false);
+    mqtt.loop();
+  }
+  size_t len = buildStatusPayload(buffer, sizeof(buffer));
+  mqtt.publish(topicStatus.c_str(), (const uint8_t*)buffer, len, true);
+  unsigned long elapsed = micros() - start;
+  printf("[HOST] Published %d readings to %s:%u in %lu us (%lu bytes sent)\n",
+         count, host.c_str(), port, elapsed, (unsigned long)net.hostBytesSent());
+  mqtt.disconnect();
+}
+
+int main(int argc, char** argv) {
+  const char* broker = nullptr;
+  int count = 100;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (strcmp(argv[i], "--broker") == 0) broker = argv[i + 1];
+    if (strcmp(argv[i], "--count") == 0) count = atoi(argv[i + 1]);
+  }
+
+  WiFi.begin();
+  LoopProfiler::begin(500, 300000, nullptr);
+
+  char buffer[512];
+  printf("[HOST] temperature: %.*s\n", (int)buildTemperaturePayload(buffer, sizeof(buffer), 21.5f), buffer);
+  printf("[HOST] status:      %.*s\n", (int)buildStatusPayload(buffer, sizeof(buffer)), buffer);
+
+  HostBench::run("temperature payload serialize", 100000, [&]() {
+    HostBench::keep(buildTemperaturePayload(buffer, sizeof(buffer), 21.5f));
+  });
+  HostBench::run("status payload serialize", 50000, [&]() {
+    HostBench::keep(buildStatusPayload(buffer, sizeof(buffer)));
+  });
+  comparePublishPaths();
+  HostBench::run("LoopProfiler iteration + 2 regions", 200000, []() {
+    LoopProfiler::Iteration iteration;
+    {
+      LOOP_PROFILE_REGION("outer");
+      LOOP_PROFILE_REGION("inner");
+    }
+  });
+  HostCheck::expect(LoopProfiler::getIterations() == 200000 + 200000 / 10 + 1,   // Warm-up pass included
+                    "LoopProfiler counts every iteration");
+
+  Preferences prefs;
+  prefs.begin("device", false);
+  uint32_t writesBefore = Preferences::hostWriteCount();
+  HostBench::run("Preferences putUInt + getUInt", 2000, [&]() {
+    prefs.putUInt("counter", prefs.getUInt("counter", 0) + 1);
+  });
+  printf("[HOST] NVS writes: %lu\n", (unsigned long)(Preferences::hostWriteCount() - writesBefore));
+  prefs.end();
+
+  if (SPIFFS.begin(true)) {
+    HostBench::run("SPIFFS append 64 bytes", 2000, [&]() {
+      File f = SPIFFS.open("/bench.log", FILE_APPEND);
+      f.write((const uint8_t*)buffer, 64);
+      f.close();
+    });
+    SPIFFS.remove("/bench.log");
+    checkConfigStore();
+  }
+  checkLightSleep();
+  checkTxPower();
+  checkHttpServing();
+
+  if (broker) {
+    publishToBroker(broker, count);
+  }
+  return HostCheck::exitCode();
+}
+
+#endif // NATIVE_HOST
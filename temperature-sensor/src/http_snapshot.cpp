@@ -0,0 +1,48 @@
+#include "http_snapshot.h"
+
+#if defined(ESP8266) && !defined(NATIVE_HOST)
+  // Network callbacks run between loop() yields and never preempt it
+  #define SNAPSHOT_LOCK()
+#else
+  #include <mutex>
+  #define SNAPSHOT_LOCK() std::lock_guard<std::mutex> guard(s_mutex)
+#endif
+
+namespace HttpSnapshot {
+#if !defined(ESP8266) || defined(NATIVE_HOST)
+  static std::mutex s_mutex;
+#endif
+  static Body s_bodies[MAX_SLOTS];
+  static uint32_t s_published = 0;
+  static uint32_t s_served = 0;
+
+  void publish(uint8_t slot, String&& body) {
+    if (slot >= MAX_SLOTS) {
+      return;
+    }
+    // Allocate outside the lock; the old body is freed here or by its last reader
+    Body next = std::make_shared<const String>(std::move(body));
+    SNAPSHOT_LOCK();
+    s_bodies[slot].swap(next);
+    s_published++;
+  }
+
+  Body get(uint8_t slot) {
+    if (slot >= MAX_SLOTS) {
+      return Body();
+    }
+    SNAPSHOT_LOCK();
+    if (s_bodies[slot]) {
+      s_served++;
+    }
+    return s_bodies[slot];
+  }
+
+  uint32_t getPublished() {
+    return s_published;
+  }
+
+  uint32_t getServed() {
+    return s_served;
+  }
+}
@@ -0,0 +1,83 @@
+#include "light_sleep.h"
+
+#if defined(ESP8266) && !defined(NATIVE_HOST)
+  #include <ESP8266WiFi.h>
+#endif
+
+namespace LightSleep {
+  static Config s_config;
+  static Stats s_stats;
+  static uint32_t s_markMs = 0;          // End of the last nap (or begin())
+
+  Plan::Plan(uint32_t nowMs) : _nowMs(nowMs), _dueInMs(UINT32_MAX) {}
+
+  void Plan::every(uint32_t lastMs, uint32_t intervalMs) {
+    uint32_t elapsed = _nowMs - lastMs;
+    uint32_t dueIn = elapsed >= intervalMs ? 0 : intervalMs - elapsed;
+    _dueInMs = min(_dueInMs, dueIn);
+  }
+
+  void Plan::busy() {
+    _dueInMs = 0;
+  }
+
+  void begin(const Config& config) {
+    s_config = config;
+    s_stats = Stats();
+    s_markMs = millis();
+#if defined(ESP8266) && !defined(NATIVE_HOST)
+    // Automatic light sleep: the SDK sleeps in delay() and keeps the association
+    WiFi.setSleepMode(WIFI_LIGHT_SLEEP, config.listenInterval);
+#endif
+    Serial.printf("[POWER] Light sleep between tasks (max %lu ms per nap, listen interval %u)\n",
+                  (unsigned long)config.maxSleepMs, config.listenInterval);
+  }
+
+  uint32_t getNapMs(const Plan& plan) {
+    uint32_t napMs = min(plan.dueInMs(), min(s_config.maxSleepMs, s_config.keepAliveMs / 2));
+    return napMs < s_config.minSleepMs ? 0 : napMs;
+  }
+
+  uint32_t nap(const Plan& plan) {
+    uint32_t napMs = getNapMs(plan);
+    uint32_t startMs = millis();
+    s_stats.awakeMs += startMs - s_markMs;
+    if (napMs == 0) {
+      s_stats.skipped++;
+      s_markMs = startMs;
+      return 0;
+    }
+    delay(napMs);
+    s_markMs = millis();
+    uint32_t sleptMs = s_markMs - startMs;
+    s_stats.naps++;
+    s_stats.sleptMs += sleptMs;
+    s_stats.longestNapMs = max(s_stats.longestNapMs, sleptMs);
+    return sleptMs;
+  }
+
+  void getStats(Stats& stats) {
+    stats = s_stats;
+  }
+
+  float estimateCurrentMa(uint64_t awakeMs, uint64_t sleptMs) {
+    uint64_t total = awakeMs + sleptMs;
+    if (total == 0) {
+      return CURRENT_AWAKE_MA;
+    }
+    return (CURRENT_AWAKE_MA * awakeMs + CURRENT_SLEEP_MA * sleptMs) / total;
+  }
+
+  float getCurrentMa() {
+    return estimateCurrentMa(s_stats.awakeMs, s_stats.sleptMs);
+  }
+
+  float getBaselineCurrentMa() {
+    return CURRENT_AWAKE_MA;
+  }
+
+  float getSleepRatio() {
+    uint64_t total = s_stats.awakeMs + s_stats.sleptMs;
+    return total ? (float)s_stats.sleptMs / total : 0.0f;
+  }
+}
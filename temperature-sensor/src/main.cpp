@@ -2,20 +2,23 @@
   Temperature Sensor with WiFiManager
   Based on Rui Santos project from RandomNerdTutorials.com
 
-  Uses standard WebServer for compatibility with WiFiManager
+  Serves HTTP with ESPAsyncWebServer; WiFiManager keeps its own WebServer
+  for the config portal
 *********/
 
 #include <Arduino.h>
 #ifdef ESP32
   #include <WiFi.h>
-  #include <WebServer.h>
+  #include <AsyncTCP.h>
 #else
   #include <ESP8266WiFi.h>
-  #include <ESP8266WebServer.h>
+  #include <ESPAsyncTCP.h>
   #include <WiFiClient.h>
 #endif
 
 #include <WiFiManager.h>
+#include <ESPAsyncWebServer.h>   // After WiFiManager: reuses WebServer's HTTP method enum
+#include <atomic>
 
 // NVS-based reset detection (no filesystem dependency)
 #ifdef ESP32
@@ -26,6 +29,7 @@
 #include <DallasTemperature.h>
 #include <PubSubClient.h>
 #include <ArduinoJson.h>
+#include <time.h>
 #ifdef ESP32
   #include <SPIFFS.h>
 #else
@@ -37,10 +41,18 @@
   #include "display.h"
 #endif
 #include "version.h"
+#include "loop_profiler.h"
+#include "reset_tracker.h"
+#include "config_store.h"
+#include "mqtt_json.h"
+#include "light_sleep.h"
+#include "tx_power.h"
+#include "config_portal.h"
+#include "http_snapshot.h"
+#include "temperature_payloads.h"
 
 // Reset detection and crash recovery state (ESP32 only)
 #ifdef ESP32
-Preferences resetPrefs;
 const char* configPortalReason = "none";  // Why portal was triggered
 #endif
 
@@ -88,6 +100,19 @@ struct DeviceMetrics {
 // Global instances
 DeviceMetrics metrics;
 
+// Readings whose publish failed (portal reconfiguring WiFi, broker down),
+// replayed oldest first with their sample timestamps
+struct PendingReading {
+  unsigned long timestamp;
+  float celsius;
+};
+const uint8_t PENDING_READINGS_MAX = 16;
+PendingReading pendingReadings[PENDING_READINGS_MAX];
+uint8_t pendingReadingsHead = 0;
+uint8_t pendingReadingsCount = 0;
+unsigned int readingsReplayed = 0;
+unsigned int readingsDropped = 0;
+
 // Deep sleep configuration
 int deepSleepSeconds = 0;  // Default disabled
 volatile bool otaInProgress = false;  // Tracks active OTA upload to prevent sleep during transfer
@@ -97,6 +122,21 @@ const char* DEEP_SLEEP_FILE = "/deep_sleep_seconds.txt";
 int sensorIntervalSeconds = 30;  // Default 30 seconds
 const char* SENSOR_INTERVAL_FILE = "/sensor_interval.txt";
 
+// Persisted configuration, committed through ConfigStore (the text files above
+// are only read once to migrate older firmware)
+struct PersistentConfig {
+  char deviceName[40];
+  int32_t deepSleepSeconds;
+  int32_t sensorIntervalSeconds;
+};
+PersistentConfig persistentConfig;
+
+#ifdef ESP32
+  #define CONFIG_FS SPIFFS
+#else
+  #define CONFIG_FS LittleFS
+#endif
+
 // Data wire is connected to GPIO 4
 OneWire oneWire(ONE_WIRE_PIN);
 
@@ -107,12 +147,27 @@ DallasTemperature sensors(&oneWire);
 String temperatureF = "--";
 String temperatureC = "--";
 
-// Create WebServer object on port 80
-#ifdef ESP32
-  WebServer server(80);
-#else
-  ESP8266WebServer server(80);
-#endif
+// Boot conversion runs while WiFi associates (startTemperatureConversion)
+bool conversionPending = false;
+unsigned long conversionStartMs = 0;
+unsigned long conversionWaitMs = 0;   // Still waited for it after WiFi + MQTT
+unsigned long wakeWifiMs = 0;         // Deep-sleep wake: WiFi associated (ms since boot)
+unsigned long wakeToPublishMs = 0;    // Deep-sleep wake: temperature published
+
+// Async web server on port 80. Handlers run outside loop() and only send
+// bodies that loop() rendered into HttpSnapshot slots.
+AsyncWebServer server(80);
+
+enum HttpSlot : uint8_t {
+  SLOT_ROOT = 0,
+  SLOT_TEMPERATURE_C,
+  SLOT_TEMPERATURE_F,
+  SLOT_HEALTH,
+  SLOT_DEEP_SLEEP
+};
+bool httpSnapshotsStale = true;                      // Re-render on the next loop()
+unsigned long lastHttpSnapshot = 0;
+std::atomic<int32_t> pendingDeepSleepSeconds(-1);   // POST /deepsleep, applied by loop()
 
 // MQTT for remote logging (disabled by default)
 WiFiClient espClient;
@@ -128,6 +183,7 @@ unsigned long lastSuccessfulMqttCheck = 0;
 int lastMqttState = MQTT_DISCONNECTED;
 const unsigned long MQTT_RECONNECT_INTERVAL_MS = 5000;
 const unsigned long MQTT_CONNECTION_CHECK_INTERVAL_MS = 30000;
+const uint16_t MQTT_KEEPALIVE_SECONDS = 30;
 const unsigned long MQTT_PUBLISH_INTERVAL_MS = 30000;
 const unsigned long MQTT_STALE_CONNECTION_TIMEOUT_MS = 120000;  // Force reconnect if no activity for 2 mins
 
@@ -144,7 +200,7 @@ unsigned long lastDisplayUpdate = 0;
 // Periodic status logging
 unsigned long lastStatusLog = 0;
 
-// Load device name from filesystem
+// Load device name from the legacy text file
 void loadDeviceName() {
 #ifdef ESP32
   if (!SPIFFS.begin(true)) {
@@ -176,24 +232,15 @@ void loadDeviceName() {
   }
 }
 
-// Save device name to filesystem
+// Queue device name for the next config commit
 void saveDeviceName(const char* name) {
-#ifdef ESP32
-  File file = SPIFFS.open(DEVICE_NAME_FILE, "w");
-#else
-  File file = LittleFS.open(DEVICE_NAME_FILE, "w");
-#endif
-  if (file) {
-    file.println(name);
-    file.close();
-    Serial.print("[Config] Saved device name: ");
-    Serial.println(name);
-  } else {
-    Serial.println("[Config] Failed to save device name");
-  }
+  strlcpy(persistentConfig.deviceName, name, sizeof(persistentConfig.deviceName));
+  ConfigStore::markDirty();
+  Serial.print("[Config] Device name set: ");
+  Serial.println(name);
 }
 
-// Load deep sleep config from filesystem
+// Load deep sleep config from the legacy text file
 void loadDeepSleepConfig() {
 #ifdef ESP32
   if (!SPIFFS.begin(true)) {
@@ -230,31 +277,14 @@ void loadDeepSleepConfig() {
 #endif
 }
 
-// Save deep sleep config to filesystem
+// Queue deep sleep config for the next config commit
 void saveDeepSleepConfig() {
-#ifdef ESP32
-  if (!SPIFFS.begin(true)) {
-    Serial.println("[FS] Failed to mount SPIFFS for save");
-    return;
-  }
-  File file = SPIFFS.open(DEEP_SLEEP_FILE, "w");
-#else // ESP8266
-  if (!LittleFS.begin()) {
-    Serial.println("[FS] Failed to mount LittleFS for save");
-    return;
-  }
-  File file = LittleFS.open(DEEP_SLEEP_FILE, "w");
-#endif
-  if (file) {
-    file.println(deepSleepSeconds);
-    file.close();
-    Serial.printf("[DEEP SLEEP] Saved config: %d seconds\n", deepSleepSeconds);
-  } else {
-    Serial.println("[DEEP SLEEP] Failed to save config file");
-  }
+  persistentConfig.deepSleepSeconds = deepSleepSeconds;
+  ConfigStore::markDirty();
+  Serial.printf("[DEEP SLEEP] Config set: %d seconds\n", deepSleepSeconds);
 }
 
-// Load sensor interval config from filesystem
+// Load sensor interval config from the legacy text file
 void loadSensorIntervalConfig() {
 #ifdef ESP32
   if (!SPIFFS.exists(SENSOR_INTERVAL_FILE)) {
@@ -286,20 +316,41 @@ void loadSensorIntervalConfig() {
   file.close();
 }
 
-// Save sensor interval config to filesystem
+// Queue sensor interval config for the next config commit
 void saveSensorIntervalConfig() {
-#ifdef ESP32
-  if (!SPIFFS.begin(true)) return;
-  File file = SPIFFS.open(SENSOR_INTERVAL_FILE, "w");
-#else
-  if (!LittleFS.begin()) return;
-  File file = LittleFS.open(SENSOR_INTERVAL_FILE, "w");
-#endif
-  
-  if (file) {
-    file.println(sensorIntervalSeconds);
-    file.close();
-    Serial.printf("[SENSOR] Saved interval config: %d seconds\n", sensorIntervalSeconds);
+  persistentConfig.sensorIntervalSeconds = sensorIntervalSeconds;
+  ConfigStore::markDirty();
+  Serial.printf("[SENSOR] Interval config set: %d seconds\n", sensorIntervalSeconds);
+}
+
+// Load configuration from the config store, migrating the legacy text files once
+void loadConfig() {
+  bool loaded = ConfigStore::begin(CONFIG_FS, &persistentConfig, sizeof(persistentConfig),
+                                   CONFIG_SCHEMA_VERSION, CONFIG_COMMIT_QUIET_MS, CONFIG_COMMIT_MAX_DELAY_MS);
+  if (loaded) {
+    persistentConfig.deviceName[sizeof(persistentConfig.deviceName) - 1] = '\0';
+    if (strlen(persistentConfig.deviceName) > 0) {
+      strcpy(deviceName, persistentConfig.deviceName);
+    }
+    deepSleepSeconds = persistentConfig.deepSleepSeconds;
+    sensorIntervalSeconds = max((int)persistentConfig.sensorIntervalSeconds, 5);
+    Serial.printf("[Config] Loaded: name='%s', deep sleep %ds, interval %ds\n",
+                  deviceName, deepSleepSeconds, sensorIntervalSeconds);
+    return;
+  }
+
+  loadDeviceName();
+  loadDeepSleepConfig();
+  loadSensorIntervalConfig();
+  strlcpy(persistentConfig.deviceName, deviceName, sizeof(persistentConfig.deviceName));
+  persistentConfig.deepSleepSeconds = deepSleepSeconds;
+  persistentConfig.sensorIntervalSeconds = sensorIntervalSeconds;
+  ConfigStore::markDirty();
+  if (ConfigStore::flush()) {
+    CONFIG_FS.remove(DEVICE_NAME_FILE);
+    CONFIG_FS.remove(DEEP_SLEEP_FILE);
+    CONFIG_FS.remove(SENSOR_INTERVAL_FILE);
+    Serial.println("[Config] Migrated legacy config files");
   }
 }
 
@@ -311,6 +362,7 @@ bool ensureMqttConnected();
 void publishEvent(const String& eventType, const String& message, const String& severity = "info");
 bool publishTemperature();
 void publishStatus();
+void startConfigPortal();
 void mqttCallback(char* topic, byte* payload, unsigned int length);
 
 // Validate that temperature reading is valid
@@ -333,10 +385,8 @@ void readBattery() {
 #endif
 }
 
-// Update both temperature globals in one call
-void updateTemperatures() {
-  sensors.requestTemperatures();
-  float tC = sensors.getTempCByIndex(0);
+// Format a reading into both temperature globals
+void applyTemperature(float tC) {
   if (tC == DEVICE_DISCONNECTED_C) {
     temperatureC = "--";
     temperatureF = "--";
@@ -351,6 +401,41 @@ void updateTemperatures() {
     temperatureF = String(buf);
     metrics.updateTemperature(tC);
   }
+  httpSnapshotsStale = true;
+}
+
+// Update both temperature globals in one call
+void updateTemperatures() {
+  LOOP_PROFILE_REGION("ds18b20");
+  sensors.requestTemperatures();
+  applyTemperature(sensors.getTempCByIndex(0));
+}
+
+// Start a conversion without waiting; the DS18B20 converts on its own while
+// setup() brings WiFi and MQTT up
+void startTemperatureConversion() {
+  sensors.setWaitForConversion(false);
+  sensors.requestTemperatures();
+  sensors.setWaitForConversion(true);
+  conversionStartMs = millis();
+  conversionPending = true;
+}
+
+// Collect the conversion started by startTemperatureConversion(), waiting
+// only for what is left of it
+void finishTemperatureConversion() {
+  if (!conversionPending) {
+    return;
+  }
+  LOOP_PROFILE_REGION("ds18b20");
+  unsigned long waitStart = millis();
+  unsigned long conversionMs = sensors.millisToWaitForConversion(sensors.getResolution());
+  while (millis() - conversionStartMs < conversionMs && !sensors.isConversionComplete()) {
+    delay(1);
+  }
+  conversionWaitMs = millis() - waitStart;
+  conversionPending = false;
+  applyTemperature(sensors.getTempCByIndex(0));
 }
 
 String generateChipId() {
@@ -377,6 +462,7 @@ void setupOTA() {
       type = "filesystem";
     }
     Serial.println("[OTA] Update started: " + type);
+    ConfigStore::flush();
     publishEvent("ota_start", "OTA update starting (" + type + ")", "warning");
   });
   
@@ -486,6 +572,7 @@ bool isWifiReconnectRateLimited() {
 
 // Force WiFi reconnect to try different mesh node
 void forceWifiReconnect(const String& reason) {
+  LOOP_PROFILE_REGION("wifi_reconnect");
   unsigned long now = millis();
   
   Serial.printf("[WiFi] Forcing reconnect: %s\n", reason.c_str());
@@ -507,6 +594,7 @@ void forceWifiReconnect(const String& reason) {
     WiFi.setAutoReconnect(true);
   #endif
   WiFi.reconnect();
+  TxPower::reset();  // The learned level belongs to the previous access point
 }
 
 // Gracefully disconnect from MQTT broker with proper cleanup
@@ -578,6 +666,7 @@ bool ensureMqttConnected() {
                 MQTT_BROKER, MQTT_PORT, clientId.c_str());
 
   // Connect anonymously if no credentials provided, otherwise use authentication
+  LOOP_PROFILE_REGION("mqtt_connect");
   bool connected;
   if (strlen(MQTT_USER) == 0) {
     connected = mqttClient.connect(clientId.c_str());
@@ -606,10 +695,8 @@ bool publishJson(const String& topic, JsonDocument& doc, bool retain = false) {
     return false;
   }
 
-  String payload;
-  serializeJson(doc, payload);
-  
-  bool ok = mqttClient.publish(topic.c_str(), payload.c_str(), retain);
+  LOOP_PROFILE_REGION("mqtt_publish");
+  bool ok = MqttJson::publish(mqttClient, topic.c_str(), doc, retain);
   if (!ok) {
     metrics.mqttPublishFailures++;
   } else {
@@ -618,166 +705,186 @@ bool publishJson(const String& topic, JsonDocument& doc, bool retain = false) {
   return ok;
 }
 
+// Identity fields of every published document
+TemperaturePayloads::Identity payloadIdentity(const String& firmwareVersion) {
+  TemperaturePayloads::Identity id;
+  id.device = deviceName;
+  id.chipId = chipId.c_str();
+  id.firmwareVersion = firmwareVersion.c_str();
+  return id;
+}
+
 void publishEvent(const String& eventType, const String& message, const String& severity) {
+  String firmwareVersion = getFirmwareVersion();
+  TemperaturePayloads::Event event;
+  event.type = eventType.c_str();
+  event.severity = severity.c_str();
+  event.message = message.c_str();
+  event.timestamp = millis() / 1000;
+  event.uptimeSeconds = (millis() - metrics.bootTime) / 1000;
+  event.freeHeap = ESP.getFreeHeap();
   StaticJsonDocument<256> doc;
-  doc["device"] = deviceName;
-  doc["chip_id"] = chipId;
-  doc["firmware_version"] = getFirmwareVersion();
-  doc["schema_version"] = 1;
-  doc["event"] = eventType;
-  doc["severity"] = severity;
-  doc["timestamp"] = millis() / 1000;
-  doc["uptime_seconds"] = (millis() - metrics.bootTime) / 1000;
-  doc["free_heap"] = ESP.getFreeHeap();
-  if (message.length() > 0) {
-    doc["message"] = message;
-  }
+  TemperaturePayloads::buildEvent(doc, payloadIdentity(firmwareVersion), event);
   publishJson(getTopicEvents(), doc, false);
 }
 
+// Wall-clock time of a sample taken at uptime `timestamp` (s); 0 until NTP has set the clock
+uint32_t sampleTime(unsigned long timestamp) {
+  time_t now = time(nullptr);
+  return now > 1600000000 ? (uint32_t)(now - (millis() / 1000 - timestamp)) : 0;
+}
+
+bool publishReading(unsigned long timestamp, float celsius, bool replay) {
+  String firmwareVersion = getFirmwareVersion();
+  TemperaturePayloads::Reading reading;
+  reading.timestamp = timestamp;
+  reading.celsius = celsius;
+  reading.replayed = replay;
+  if (replay) {
+    reading.sampleTime = sampleTime(timestamp);
+  }
+  reading.batteryVoltage = metrics.batteryVoltage;
+  reading.batteryPercent = metrics.batteryPercent;
+  StaticJsonDocument<256> doc;
+  TemperaturePayloads::buildReading(doc, payloadIdentity(firmwareVersion), reading);
+  bool success = publishJson(getTopicTemperature(), doc, false);
+  if (WiFi.status() == WL_CONNECTED) {
+    TxPower::report(WiFi.RSSI(), success, measureJson(doc));
+  }
+  return success;
+}
+
+void bufferReading(unsigned long timestamp, float celsius) {
+  if (pendingReadingsCount == PENDING_READINGS_MAX) {
+    // Full: the oldest reading makes room
+    pendingReadingsHead = (pendingReadingsHead + 1) % PENDING_READINGS_MAX;
+    pendingReadingsCount--;
+    readingsDropped++;
+  }
+  uint8_t index = (pendingReadingsHead + pendingReadingsCount) % PENDING_READINGS_MAX;
+  pendingReadings[index].timestamp = timestamp;
+  pendingReadings[index].celsius = celsius;
+  pendingReadingsCount++;
+}
+
+// Replay buffered readings oldest first; stops at the first failure
+bool publishPendingReadings() {
+  while (pendingReadingsCount > 0) {
+    const PendingReading& reading = pendingReadings[pendingReadingsHead];
+    if (!publishReading(reading.timestamp, reading.celsius, true)) {
+      return false;
+    }
+    pendingReadingsHead = (pendingReadingsHead + 1) % PENDING_READINGS_MAX;
+    pendingReadingsCount--;
+    readingsReplayed++;
+  }
+  return true;
+}
+
 bool publishTemperature() {
   if (!isValidTemperature(temperatureC)) {
     return false;
   }
 
-  StaticJsonDocument<256> doc;
-  doc["device"] = deviceName;
-  doc["chip_id"] = chipId;
-  #ifdef BATTERY_MONITOR_ENABLED
-    if (metrics.batteryPercent >= 0) {
-      doc["battery_voltage"] = metrics.batteryVoltage;
-      doc["battery_percent"] = metrics.batteryPercent;
-    }
-  #endif
-  doc["schema_version"] = 1;
-  doc["timestamp"] = millis() / 1000;
-  doc["celsius"] = temperatureC.toFloat();
-  doc["fahrenheit"] = temperatureF.toFloat();
-  bool success = publishJson(getTopicTemperature(), doc, false);
+  unsigned long timestamp = millis() / 1000;
+  float celsius = temperatureC.toFloat();
+  bool success = publishPendingReadings() && publishReading(timestamp, celsius, false);
   if (success) {
     metrics.consecutiveMqttFailures = 0;  // Reset counter on success
   } else {
     metrics.consecutiveMqttFailures++;
+    bufferReading(timestamp, celsius);
   }
   return success;
 }
 
 void publishStatus() {
-  StaticJsonDocument<256> doc;
-  doc["device"] = deviceName;
-  doc["chip_id"] = chipId;
-  doc["firmware_version"] = getFirmwareVersion();
-  doc["schema_version"] = 1;
-  doc["timestamp"] = millis() / 1000;
-  doc["uptime_seconds"] = (millis() - metrics.bootTime) / 1000;
-  doc["wifi_connected"] = (WiFi.status() == WL_CONNECTED);
-  doc["wifi_rssi"] = (WiFi.status() == WL_CONNECTED) ? WiFi.RSSI() : -999;
-  doc["free_heap"] = ESP.getFreeHeap();
-  doc["sensor_healthy"] = isValidTemperature(temperatureC);
-  doc["wifi_reconnects"] = metrics.wifiReconnects;
-  doc["sensor_read_failures"] = metrics.sensorReadFailures;
-  doc["deep_sleep_enabled"] = (deepSleepSeconds > 0);
-  doc["deep_sleep_seconds"] = deepSleepSeconds;
-  doc["sensor_interval_seconds"] = sensorIntervalSeconds;
-  #ifdef BATTERY_MONITOR_ENABLED
-    if (metrics.batteryPercent >= 0) {
-      doc["battery_voltage"] = metrics.batteryVoltage;
-      doc["battery_percent"] = metrics.batteryPercent;
-    }
+  TemperaturePayloads::Status status;
+  status.timestamp = millis() / 1000;
+  status.uptimeSeconds = (millis() - metrics.bootTime) / 1000;
+  status.wifiConnected = (WiFi.status() == WL_CONNECTED);
+  status.wifiRssi = status.wifiConnected ? WiFi.RSSI() : -999;
+  status.freeHeap = ESP.getFreeHeap();
+  status.sensorHealthy = isValidTemperature(temperatureC);
+  status.wifiReconnects = metrics.wifiReconnects;
+  status.sensorReadFailures = metrics.sensorReadFailures;
+  status.deepSleepSeconds = deepSleepSeconds;
+  status.sensorIntervalSeconds = sensorIntervalSeconds;
+  status.batteryVoltage = metrics.batteryVoltage;
+  status.batteryPercent = metrics.batteryPercent;
+  status.loopMaxMs = LoopProfiler::getMaxIterationMs();
+  status.loopStalls = LoopProfiler::getStallCount();
+  if (wakeToPublishMs > 0) {
+    status.wakeToPublishMs = wakeToPublishMs;
+    status.wakeWifiMs = wakeWifiMs;
+    status.wakeConversionWaitMs = conversionWaitMs;
+    status.wakeFlow = WAKE_SEQUENTIAL_BASELINE ? "sequential" : "overlapped";
+  }
+  #if LIGHT_SLEEP_ENABLED
+    status.lightSleep = true;
+    status.lightSleepRatio = LightSleep::getSleepRatio();
+    status.lightSleepEstMa = LightSleep::getCurrentMa();
+    status.lightSleepBaselineMa = LightSleep::getBaselineCurrentMa();
   #endif
+  status.txPowerDbm = TxPower::getDbm();
+  TxPower::Stats txStats;
+  TxPower::getStats(txStats);
+  status.txPowerStepsDown = txStats.stepsDown;
+  status.txPowerStepsUp = txStats.stepsUp;
+  status.txEnergyPerPublishUj = TxPower::getEnergyPerPublishUj();
+  status.txEnergySavedPct = TxPower::getSavedPercent();
+  #ifdef ESP32
+    status.resetReason = ResetTracker::getResetReason();
+    status.bootCount = ResetTracker::getBootCount();
+    status.resetNvsWrites = ResetTracker::getNvsWrites();
+    status.resetNvsWritesPerDay = ResetTracker::getNvsWritesPerDay();
+    status.bootDelaySavedMs = ResetTracker::getBootDelaySavedMs();
+  #endif
+  status.configPortalActive = ConfigPortal::isActive();
+  status.configPortalSessions = ConfigPortal::getSessions();
+  status.configPortalLastMs = ConfigPortal::getLastSessionMs();
+  status.readingsBuffered = pendingReadingsCount;
+  status.readingsReplayed = readingsReplayed;
+  status.readingsDropped = readingsDropped;
+  status.configCommits = ConfigStore::getCommits();
+  for (uint8_t i = 0; i < TemperaturePayloads::Status::CONFIG_SLOTS; i++) {
+    status.configSlotWrites[i] = ConfigStore::getSlotWrites(i);
+  }
+  status.configCommitsBoot = ConfigStore::getCommitsThisBoot();
+  status.configCoalesced = ConfigStore::getCoalesced();
+  status.configCommitFailures = ConfigStore::getCommitFailures();
+  status.configPending = ConfigStore::isDirty();
+  status.mqttPayloadMaxBytes = MqttJson::getMaxPayloadBytes();
+  status.mqttPublishMaxUs = MqttJson::getMaxPublishUs();
+
+  String firmwareVersion = getFirmwareVersion();
+  StaticJsonDocument<256> doc;
+  TemperaturePayloads::buildStatus(doc, payloadIdentity(firmwareVersion), status);
   publishJson(getTopicStatus(), doc, true);
 }
 
-// ==================== Reset Detection & Recovery (NVS-based, ESP32 only) ====================
+// Report loop() stalls through the events topic (rate-limited by the profiler)
+void onLoopStall(const LoopProfiler::StallInfo& info) {
+  char message[128];
+  snprintf(message, sizeof(message), "Loop stalled %lu ms in %s (%lu ms), stalls: %lu, suppressed: %lu",
+           (unsigned long)info.durationMs, info.region, (unsigned long)info.regionMs,
+           (unsigned long)info.stallCount, (unsigned long)info.suppressed);
+  Serial.printf("[PROFILER] %s\n", message);
+  publishEvent("loop_stall", message, "warning");
+}
+
+// ==================== Reset Detection & Recovery (RTC-based, ESP32 only) ====================
 
 #ifdef ESP32
 void checkResetCounter() {
-  // Check for triple-reset and crash loop conditions (ESP32 reliable via NVS)
+  // Check for triple-reset and crash loop conditions (RTC memory, non-blocking)
   // This must be called early in setup() before other initialization
-
-  // Open preferences namespace for reset tracking
-  resetPrefs.begin("reset", false);
-
-  // ===== Crash loop detection =====
-  uint32_t crashFlag = resetPrefs.getUInt("crash_flag", 0);
-  uint32_t crashCnt = resetPrefs.getUInt("crash_cnt", 0);
-
-  if (crashFlag == CRASH_LOOP_MAGIC) {
-    crashCnt++;
-    resetPrefs.putUInt("crash_cnt", crashCnt);
-    Serial.printf("[RESET] Incomplete boot detected, crash count: %lu\n", crashCnt);
-
-    if (crashCnt >= CRASH_LOOP_THRESHOLD) {
-      Serial.println("[RESET] CRASH LOOP RECOVERY - entering config portal");
-      configPortalReason = "crash_recovery";
-      resetPrefs.putUInt("crash_cnt", 0); // Reset for next time
-    }
-  } else {
-    // Fresh power-on (or flag cleared), reset crash count only.
-    // Do NOT clear triple-reset counters here; they must persist across boots.
-    resetPrefs.putUInt("crash_cnt", 0);
-  }
-
-  // Mark boot in progress (cleared in clearCrashLoop after successful boot)
-  resetPrefs.putUInt("crash_flag", CRASH_LOOP_MAGIC);
-
-  // ===== Triple-reset detection =====
-  if (strcmp(configPortalReason, "crash_recovery") != 0) {
-    uint32_t cnt = resetPrefs.getUInt("reset_cnt", 0);
-    uint32_t window = resetPrefs.getUInt("window", 0);
-
-    // Sanity check
-    if (cnt > 10) {
-      Serial.printf("[RESET] Reset counter corrupted (%lu), clearing\n", cnt);
-      cnt = 0;
-      window = 0;
-      resetPrefs.putUInt("reset_cnt", cnt);
-      resetPrefs.putUInt("window", window);
-    }
-
-    if (window == 1 && cnt > 0 && cnt < 10) {
-      // Previous boot started a detection window
-      cnt++;
-      resetPrefs.putUInt("reset_cnt", cnt);
-      Serial.printf("[RESET] Reset count: %lu/%d\n", cnt, RESET_COUNT_THRESHOLD);
-
-      if (cnt >= RESET_COUNT_THRESHOLD) {
-        Serial.println("[RESET] TRIPLE RESET DETECTED - entering config portal");
-        configPortalReason = "triple_reset";
-        // Clear for next time
-        resetPrefs.putUInt("reset_cnt", 0);
-        resetPrefs.putUInt("window", 0);
-      }
-    } else {
-      // First reset or outside window
-      cnt = 1;
-      window = 1;
-      resetPrefs.putUInt("reset_cnt", cnt);
-      resetPrefs.putUInt("window", window);
-      Serial.println("[RESET] First reset, starting detection window");
-    }
-
-    // Wait for window; if no reset occurs, clear markers
-    delay(RESET_DETECT_TIMEOUT * 1000);
-
-    if (strcmp(configPortalReason, "none") == 0) {
-      Serial.println("[RESET] Reset window expired, normal boot");
-      resetPrefs.putUInt("reset_cnt", 0);
-      resetPrefs.putUInt("window", 0);
-    }
-  }
-
-  Serial.printf("[RESET] Boot reason: %s\n", configPortalReason);
-  resetPrefs.end();  // Close NVS namespace to free resources
+  configPortalReason = ResetTracker::begin(RESET_DETECT_TIMEOUT, RESET_COUNT_THRESHOLD, CRASH_LOOP_THRESHOLD);
 }
 
 void clearCrashLoop() {
   // Called after successful boot (WiFi + sensors + web server initialized)
-  resetPrefs.begin("reset", false);  // Open NVS namespace
-  resetPrefs.putUInt("crash_flag", 0);
-  resetPrefs.putUInt("crash_cnt", 0);
-  resetPrefs.end();  // Close NVS namespace
-  Serial.println("[RESET] Crash loop flag cleared - boot successful");
+  ResetTracker::markBootComplete();
 }
 #endif
 
@@ -793,6 +900,11 @@ void enterDeepSleepIfEnabled() {
     return;
   #endif
 
+  if (deepSleepSeconds > 0 && ConfigPortal::isActive()) {
+    Serial.println("[DEEP SLEEP] Config portal running - staying awake");
+    return;
+  }
+
   if (deepSleepSeconds > 0) {
     Serial.println();
     Serial.println("========================================");
@@ -818,6 +930,9 @@ void enterDeepSleepIfEnabled() {
       delay(100);  // Give time for WiFi to power down
     #endif
 
+    // Commit pending config changes before RAM is lost
+    ConfigStore::flush();
+
     // Flush serial before sleeping
     Serial.flush();
     delay(50);
@@ -886,59 +1001,112 @@ String getHealthStatus() {
     doc["last_success"]["mqtt_seconds_ago"] = (millis() - metrics.lastSuccessfulMqttPublish) / 1000;
   }
 
+  // Loop latency histogram: bucket 0 counts iterations under 1 ms, bucket n (n >= 1) those in [2^(n-1), 2^n) ms
+  JsonObject loopStats = doc["loop"].to<JsonObject>();
+  loopStats["iterations"] = LoopProfiler::getIterations();
+  loopStats["max_ms"] = LoopProfiler::getMaxIterationMs();
+  loopStats["stalls"] = LoopProfiler::getStallCount();
+  loopStats["last_stall_region"] = LoopProfiler::getLastStallRegion();
+  loopStats["last_stall_ms"] = LoopProfiler::getLastStallMs();
+  JsonArray histogram = loopStats["histogram"].to<JsonArray>();
+  for (uint8_t i = 0; i < LoopProfiler::HISTOGRAM_BUCKETS; i++) {
+    histogram.add(LoopProfiler::getBucket(i));
+  }
+
   String response;
   serializeJson(doc, response);
   return response;
 }
 
-// Web request handlers
-void handleRoot() {
-  String html = FPSTR(index_html);
-  html = processTemplate(html);
-  server.send(200, "text/html", html);
+String getDeepSleepStatus() {
+  JsonDocument doc;
+  doc["deep_sleep_seconds"] = deepSleepSeconds;
+  doc["device"] = deviceName;
+  String response;
+  serializeJson(doc, response);
+  return response;
 }
 
-void handleTemperatureC() {
-  server.send(200, "text/plain", temperatureC);
+// Render every endpoint for the async handlers: after a reading or setting
+// change, and every HTTP_SNAPSHOT_INTERVAL_MS for uptime and RSSI
+void updateHttpSnapshots() {
+  if (!httpSnapshotsStale && millis() - lastHttpSnapshot < HTTP_SNAPSHOT_INTERVAL_MS) {
+    return;
+  }
+  LOOP_PROFILE_REGION("http_snapshot");
+  httpSnapshotsStale = false;
+  lastHttpSnapshot = millis();
+  #ifndef API_ENDPOINTS_ONLY
+    HttpSnapshot::publish(SLOT_ROOT, processTemplate(FPSTR(index_html)));
+  #endif
+  HttpSnapshot::publish(SLOT_TEMPERATURE_C, String(temperatureC));
+  HttpSnapshot::publish(SLOT_TEMPERATURE_F, String(temperatureF));
+  HttpSnapshot::publish(SLOT_HEALTH, getHealthStatus());
+  HttpSnapshot::publish(SLOT_DEEP_SLEEP, getDeepSleepStatus());
 }
 
-void handleTemperatureF() {
-  server.send(200, "text/plain", temperatureF);
+// A deep sleep interval posted to /deepsleep, saved from loop()
+void applyPendingDeepSleep() {
+  int32_t newSeconds = pendingDeepSleepSeconds.exchange(-1);
+  if (newSeconds < 0) {
+    return;
+  }
+  deepSleepSeconds = newSeconds;
+  saveDeepSleepConfig();
+  httpSnapshotsStale = true;
+
+  char msg[64];
+  snprintf(msg, sizeof(msg), "Deep sleep set to %d seconds", deepSleepSeconds);
+  publishEvent("deep_sleep_config", msg, "info");
 }
 
-void handleHealth() {
-  String response = getHealthStatus();
-  server.send(200, "application/json", response);
+// Web request handlers (async_tcp task / network callbacks, not loop())
+void sendSnapshot(AsyncWebServerRequest* request, uint8_t slot, const char* contentType) {
+  HttpSnapshot::Body body = HttpSnapshot::get(slot);
+  if (!body) {
+    AsyncWebServerResponse* response = request->beginResponse(503, "text/plain", "Starting");
+    response->addHeader("Retry-After", "1");
+    request->send(response);
+    return;
+  }
+  request->send(200, contentType, *body);
 }
 
-void handleDeepSleepGet() {
-  JsonDocument doc;
-  doc["deep_sleep_seconds"] = deepSleepSeconds;
-  doc["device"] = deviceName;
-  String response;
-  serializeJson(doc, response);
-  server.send(200, "application/json", response);
+void handleRoot(AsyncWebServerRequest* request) {
+  sendSnapshot(request, SLOT_ROOT, "text/html");
 }
 
-void handleDeepSleepPost() {
-  if (server.hasArg("seconds")) {
-    int newSeconds = server.arg("seconds").toInt();
-    if (newSeconds >= 0 && newSeconds <= 3600) { // Max 1 hour
-      deepSleepSeconds = newSeconds;
-      saveDeepSleepConfig();
+void handleTemperatureC(AsyncWebServerRequest* request) {
+  sendSnapshot(request, SLOT_TEMPERATURE_C, "text/plain");
+}
+
+void handleTemperatureF(AsyncWebServerRequest* request) {
+  sendSnapshot(request, SLOT_TEMPERATURE_F, "text/plain");
+}
+
+void handleHealth(AsyncWebServerRequest* request) {
+  sendSnapshot(request, SLOT_HEALTH, "application/json");
+}
+
+void handleDeepSleepGet(AsyncWebServerRequest* request) {
+  sendSnapshot(request, SLOT_DEEP_SLEEP, "application/json");
+}
 
-      char msg[64];
-      snprintf(msg, sizeof(msg), "Deep sleep set to %d seconds", deepSleepSeconds);
-      publishEvent("deep_sleep_config", msg, "info");
+// Validated here; saving and the MQTT event happen in loop() (applyPendingDeepSleep)
+void handleDeepSleepPost(AsyncWebServerRequest* request) {
+  if (request->hasArg("seconds")) {
+    int newSeconds = request->arg("seconds").toInt();
+    if (newSeconds >= 0 && newSeconds <= 3600) { // Max 1 hour
+      pendingDeepSleepSeconds.store(newSeconds);
 
       char response[64];
-      snprintf(response, sizeof(response), "{\"status\":\"ok\",\"deep_sleep_seconds\":%d}", deepSleepSeconds);
-      server.send(200, "application/json", response);
+      snprintf(response, sizeof(response), "{\"status\":\"ok\",\"deep_sleep_seconds\":%d}", newSeconds);
+      request->send(200, "application/json", response);
     } else {
-      server.send(400, "application/json", "{\"error\":\"Invalid seconds value (0-3600)\"}");
+      request->send(400, "application/json", "{\"error\":\"Invalid seconds value (0-3600)\"}");
     }
   } else {
-    server.send(400, "application/json", "{\"error\":\"Missing 'seconds' parameter\"}");
+    request->send(400, "application/json", "{\"error\":\"Missing 'seconds' parameter\"}");
   }
 }
 
@@ -970,6 +1138,7 @@ void mqttCallback(char* topic, byte* payload, unsigned int length) {
         }
         deepSleepSeconds = newSeconds;
         saveDeepSleepConfig();
+        httpSnapshotsStale = true;
 
         char msg[64];
         snprintf(msg, sizeof(msg), "Deep sleep set to %d seconds via MQTT", deepSleepSeconds);
@@ -984,6 +1153,7 @@ void mqttCallback(char* topic, byte* payload, unsigned int length) {
       publishStatus();
     } else if (strcmp(payloadStr, "restart") == 0) {
       publishEvent("device_restart", "Restarting device via MQTT command", "warning");
+      ConfigStore::flush();
       delay(500);
       ESP.restart();
     } else if (strncmp(payloadStr, "interval ", 9) == 0) {
@@ -1014,6 +1184,7 @@ void mqttCallback(char* topic, byte* payload, unsigned int length) {
         strcpy(deviceName, newName);
         updateTopicBase();
         saveDeviceName(deviceName);
+        httpSnapshotsStale = true;
         
         // Publish event on OLD topic so subscribers see the change
         publishEvent("device_rename", "Device renamed from '" + oldName + "' to '" + String(newName) + "'", "info");
@@ -1032,14 +1203,11 @@ void mqttCallback(char* topic, byte* payload, unsigned int length) {
         publishEvent("command_error", "Invalid device name (must be 1-39 characters)", "error");
       }
     } else if (strcmp(payloadStr, "config") == 0 || strcmp(payloadStr, "portal") == 0) {
+      if (ConfigPortal::isActive()) {
+        publishEvent("config_portal", "Configuration portal already running", "info");
+        return;
+      }
       publishEvent("config_portal", "Starting WiFi configuration portal via MQTT command", "warning");
-      delay(500);
-
-      // Start WiFi configuration portal
-      WiFiManager wm;
-      String apName = String(deviceName);
-      apName.replace(" ", "-");
-      apName = "Temp-" + apName + "-Setup";
 
       Serial.println();
       Serial.println("========================================");
@@ -1047,47 +1215,75 @@ void mqttCallback(char* topic, byte* payload, unsigned int length) {
       Serial.println("  Starting WiFi Configuration Portal");
       Serial.println("========================================");
       Serial.println();
-      Serial.println("[WiFi] Connect to AP: " + apName);
-      Serial.println("[WiFi] Then open http://192.168.4.1 in browser");
-      Serial.println();
 
-      WiFiManagerParameter custom_device_name("device_name", "Device Name", deviceName, 40);
-      wm.addParameter(&custom_device_name);
-      wm.setConfigPortalTimeout(300); // 5 minute timeout
-
-      bool shouldSaveConfig = false;
-      wm.setSaveConfigCallback([&shouldSaveConfig](){
-        shouldSaveConfig = true;
-      });
-
-      if (wm.startConfigPortal(apName.c_str())) {
-        if (shouldSaveConfig) {
-          const char* newName = custom_device_name.getValue();
-          String oldName = String(deviceName);
-          strcpy(deviceName, newName);
-          updateTopicBase();
-          saveDeviceName(deviceName);
-
-          // Ensure MQTT is connected before publishing configuration events
-          ensureMqttConnected();
-          
-          if (oldName != String(newName)) {
-            publishEvent("device_configured", "Name: '" + oldName + "' -> '" + String(newName) + "', SSID: " + WiFi.SSID() + ", IP: " + WiFi.localIP().toString(), "info");
-          } else {
-            publishEvent("device_configured", "WiFi reconfigured - SSID: " + WiFi.SSID() + ", IP: " + WiFi.localIP().toString(), "info");
-          }
-        }
-        Serial.println("[WiFi] Configuration portal completed successfully");
-      } else {
-        Serial.println("[WiFi] Configuration portal timeout or cancelled");
-        // Ensure MQTT connection is valid before attempting to publish portal result
-        ensureMqttConnected();
-        publishEvent("config_portal", "Configuration portal closed (timeout or cancel)", "warning");
-      }
+      startConfigPortal();
     }
   }
 }
 
+String getConfigPortalApName() {
+  String apName = String(deviceName);
+  apName.replace(" ", "-");
+  return "Temp-" + apName + "-Setup";
+}
+
+// Runs in the background: sampling and publishing continue through the station
+// interface. The portal takes port 80 from the web server until it closes.
+void startConfigPortal() {
+  String apName = getConfigPortalApName();
+  ConfigPortal::Config portalConfig;
+  portalConfig.apName = apName.c_str();
+  portalConfig.deviceName = deviceName;
+  portalConfig.timeoutSeconds = 300; // 5 minute timeout
+  #if HTTP_SERVER_ENABLED
+    server.end();
+  #endif
+  ConfigPortal::start(portalConfig);
+}
+
+void handleConfigPortal() {
+  ConfigPortal::Event event;
+  {
+    LOOP_PROFILE_REGION("config_portal");
+    event = ConfigPortal::process();
+  }
+  if (event == ConfigPortal::EVENT_NONE) {
+    return;
+  }
+  #if HTTP_SERVER_ENABLED
+    server.begin();
+  #endif
+
+  if (event == ConfigPortal::EVENT_SAVED) {
+    const char* newName = ConfigPortal::getDeviceName();
+    String oldName = String(deviceName);
+    if (strlen(newName) > 0 && strlen(newName) < sizeof(deviceName)) {
+      strcpy(deviceName, newName);
+      updateTopicBase();
+      saveDeviceName(deviceName);
+      httpSnapshotsStale = true;
+    }
+
+    // Reconnect MQTT with the new topics
+    if (oldName != String(deviceName)) {
+      mqttClient.disconnect();
+    }
+    ensureMqttConnected();
+
+    if (oldName != String(deviceName)) {
+      publishEvent("device_configured", "Name: '" + oldName + "' -> '" + String(deviceName) + "', SSID: " + WiFi.SSID() + ", IP: " + WiFi.localIP().toString(), "info");
+    } else {
+      publishEvent("device_configured", "WiFi reconfigured - SSID: " + WiFi.SSID() + ", IP: " + WiFi.localIP().toString(), "info");
+    }
+    Serial.println("[WiFi] Configuration portal completed successfully");
+  } else {
+    Serial.println("[WiFi] Configuration portal timeout or cancelled");
+    // Ensure MQTT connection is valid before attempting to publish portal result
+    ensureMqttConnected();
+    publishEvent("config_portal", "Configuration portal closed (timeout or cancel)", "warning");
+  }
+}
+
 void setupWebServer() {
 #if HTTP_SERVER_ENABLED
   #ifndef API_ENDPOINTS_ONLY
@@ -1098,6 +1294,10 @@ void setupWebServer() {
   server.on("/health", HTTP_GET, handleHealth);
   server.on("/deepsleep", HTTP_GET, handleDeepSleepGet);
   server.on("/deepsleep", HTTP_POST, handleDeepSleepPost);
+  if (ConfigPortal::isActive()) {
+    Serial.println("[HTTP] Web server starts when the config portal closes");
+    return;
+  }
   server.begin();
   Serial.println("[HTTP] Web server started on port 80");
 #else
@@ -1176,41 +1376,20 @@ void setupWiFi() {
     return;
   }
 
-  // For non-deep-sleep devices: use WiFiManager with portal fallback
-  WiFiManager wm;
-  String apName = String(deviceName);
-  apName.replace(" ", "-");
-  apName = "Temp-" + apName + "-Setup";
+  // For non-deep-sleep devices: use WiFiManager with portal fallback.
+  // The portal runs in the background and is finished from loop().
+  String apName = getConfigPortalApName();
+  ConfigPortal::Config portalConfig;
+  portalConfig.apName = apName.c_str();
+  portalConfig.deviceName = deviceName;
+  portalConfig.timeoutSeconds = 0;   // Until configured; the sensor runs offline meanwhile
 
-  WiFiManagerParameter custom_device_name("device_name", "Device Name", deviceName, 40);
-  wm.addParameter(&custom_device_name);
-  wm.setConnectTimeout(0);
-
-  bool shouldSaveConfig = false;
-  wm.setSaveConfigCallback([&shouldSaveConfig](){
-    shouldSaveConfig = true;
-  });
-
-  if (!wm.autoConnect(apName.c_str())) {
+  if (!ConfigPortal::autoConnect(portalConfig)) {
     Serial.println("[WiFi] Failed to connect - running in offline mode");
   } else {
     Serial.printf("[WiFi] Connected to %s, IP: %s, RSSI: %d dBm\n",
                   WiFi.SSID().c_str(), WiFi.localIP().toString().c_str(), WiFi.RSSI());
     publishEvent("wifi_connected", "Connected to " + WiFi.SSID() + " with IP " + WiFi.localIP().toString(), "info");
-
-    if (shouldSaveConfig) {
-      const char* newName = custom_device_name.getValue();
-      String oldName = String(deviceName);
-      strcpy(deviceName, newName);
-      updateTopicBase();
-      saveDeviceName(deviceName);
-
-      if (oldName != String(newName)) {
-        publishEvent("device_configured", "Name: '" + oldName + "' -> '" + String(newName) + "', SSID: " + WiFi.SSID() + ", IP: " + WiFi.localIP().toString(), "info");
-      } else {
-        publishEvent("device_configured", "WiFi reconfigured - SSID: " + WiFi.SSID() + ", IP: " + WiFi.localIP().toString() + ", Name unchanged: " + oldName, "info");
-      }
-    }
   }
 }
 
@@ -1246,6 +1425,9 @@ void setup() {
   }
 #endif
 
+  // Load device name, deep sleep and sensor interval configuration
+  loadConfig();
+
   // CPU runs at full speed - power savings handled by deep sleep instead
   // Reducing CPU frequency can cause timing issues and slow OTA transfers
   Serial.println("[POWER] CPU running at full speed - using deep sleep for power management");
@@ -1258,7 +1440,8 @@ void setup() {
   }
   #endif
 
-  // Check for triple-reset IMMEDIATELY (before slow WiFi/MQTT setup)
+  // Triple reset: the portal opens once WiFi is up (see below) and runs
+  // alongside sampling instead of blocking setup()
   if (shouldStartConfigPortal) {
     Serial.println();
     Serial.println("========================================");
@@ -1267,47 +1450,9 @@ void setup() {
     #else
     Serial.println("  CONFIG PORTAL TRIGGERED");
     #endif
-    Serial.println("  Starting WiFi Configuration Portal");
+    Serial.println("  WiFi Configuration Portal starts after WiFi setup");
     Serial.println("========================================");
     Serial.println();
-
-    // Load device name first (needed for AP name)
-    loadDeviceName();
-
-    WiFiManager wm;
-    String apName = String(deviceName);
-    apName.replace(" ", "-");
-    apName = "Temp-" + apName + "-Setup";
-
-    Serial.println("[WiFi] Connect to AP: " + apName);
-    Serial.println("[WiFi] Then open http://192.168.4.1 in browser");
-    Serial.println();
-
-    WiFiManagerParameter custom_device_name("device_name", "Device Name", deviceName, 40);
-    wm.addParameter(&custom_device_name);
-    wm.setConfigPortalTimeout(300); // 5 minute timeout
-
-    bool shouldSaveConfig = false;
-    wm.setSaveConfigCallback([&shouldSaveConfig](){
-      shouldSaveConfig = true;
-    });
-
-    if (wm.startConfigPortal(apName.c_str())) {
-      if (shouldSaveConfig) {
-        const char* newName = custom_device_name.getValue();
-        strcpy(deviceName, newName);
-        saveDeviceName(deviceName);
-        Serial.print("[Config] Device name updated: ");
-        Serial.println(newName);
-      }
-      Serial.println("[WiFi] Configuration portal completed successfully");
-      Serial.println("[WiFi] Restarting to apply new configuration...");
-      delay(1000);
-      ESP.restart();
-    } else {
-      Serial.println("[WiFi] Configuration portal timeout or cancelled");
-      Serial.println("[WiFi] Continuing with existing configuration...");
-    }
   }
 
   // Print reset reason for diagnostics
@@ -1327,13 +1472,6 @@ void setup() {
   Serial.println("========================================");
   Serial.println();
 
-  // Load device name from filesystem
-  loadDeviceName();
-
-  // Load deep sleep configuration
-  loadDeepSleepConfig();
-  loadSensorIntervalConfig();
-
   // Check if this was a wake from deep sleep or a manual reset
   #ifdef ESP32
     esp_sleep_wakeup_cause_t wakeupCause = esp_sleep_get_wakeup_cause();
@@ -1381,18 +1519,23 @@ void setup() {
   Serial.printf("[SENSOR] Interval: %d seconds\n", sensorIntervalSeconds);
   
   mqttClient.setServer(MQTT_BROKER, MQTT_PORT);
-#ifdef ESP32
-  mqttClient.setBufferSize(2048);  // Larger buffer for ESP32 (recommended when battery monitoring enabled)
-#else
-  mqttClient.setBufferSize(512);   // Standard buffer for ESP8266 (512 bytes)
-#endif
-  mqttClient.setKeepAlive(30);
+  // Outgoing JSON is streamed (MqttJson), so the buffer only holds topics and inbound commands
+  mqttClient.setBufferSize(512);
+  mqttClient.setKeepAlive(MQTT_KEEPALIVE_SECONDS);
   mqttClient.setSocketTimeout(5);  // Reduced from 15s to minimize blocking during connection issues
   mqttClient.setCallback(mqttCallback);
 
-  // Start up the DS18B20 library
+  LoopProfiler::begin(LOOP_STALL_THRESHOLD_MS, LOOP_STALL_REPORT_INTERVAL_MS, onLoopStall);
+
+  // Start up the DS18B20 library; the first conversion overlaps WiFi association
   sensors.begin();
-  updateTemperatures();
+  #if WAKE_SEQUENTIAL_BASELINE
+    unsigned long baselineWaitStart = millis();
+    updateTemperatures();
+    conversionWaitMs = millis() - baselineWaitStart;
+  #else
+    startTemperatureConversion();
+  #endif
 
   #ifdef BATTERY_MONITOR_ENABLED
     // Configure ADC for battery monitoring
@@ -1405,6 +1548,19 @@ void setup() {
 
   // Connect to WiFi
   setupWiFi();
+  // UTC only: dates the readings replayed after an outage
+  configTime(0, 0, NTP_SERVER);
+  if (shouldStartConfigPortal && !ConfigPortal::isActive()) {
+    startConfigPortal();
+  }
+
+  // Learned TX power level (RTC memory across deep sleep)
+  TxPower::Config txConfig;
+  txConfig.targetRssi = TX_POWER_TARGET_RSSI;
+  txConfig.weakRssi = TX_POWER_WEAK_RSSI;
+  txConfig.downAfter = TX_POWER_DOWN_AFTER;
+  txConfig.floorHoldPublishes = TX_POWER_FLOOR_HOLD;
+  TxPower::begin(txConfig);
 
   // Setup OTA updates (after WiFi is connected) - always available regardless of deep sleep config
   // OTA will only listen when deepSleepSeconds == 0 (see loop())
@@ -1433,6 +1589,7 @@ void setup() {
       lastPublishTime = millis();
       return;
     }
+    wakeWifiMs = millis();
     Serial.printf("[DEEP SLEEP] ✓ WiFi connected to %s (IP: %s, RSSI: %d dBm)\n", 
                   WiFi.SSID().c_str(), WiFi.localIP().toString().c_str(), WiFi.RSSI());
 
@@ -1445,14 +1602,22 @@ void setup() {
     }
     Serial.println("[DEEP SLEEP] ✓ MQTT connected");
 
-    // STEP 3: Read temperature sensor
+    // STEP 3: Collect the conversion started before WiFi (normally finished by now)
     Serial.println("[DEEP SLEEP] Step 3/4: Reading temperature sensor...");
-    updateTemperatures();
-    Serial.printf("[DEEP SLEEP] ✓ Temperature: %.2f°C\n", temperatureC);
+    #if WAKE_SEQUENTIAL_BASELINE
+      baselineWaitStart = millis();
+      updateTemperatures();
+      conversionWaitMs += millis() - baselineWaitStart;
+    #else
+      finishTemperatureConversion();
+    #endif
+    Serial.printf("[DEEP SLEEP] ✓ Temperature: %s°C (waited %lu ms)\n", temperatureC.c_str(), conversionWaitMs);
 
     // STEP 4: Publish to MQTT
     Serial.println("[DEEP SLEEP] Step 4/4: Publishing to MQTT...");
     bool publishSuccess = publishTemperature();
+    wakeToPublishMs = millis();
+    Serial.printf("[DEEP SLEEP] Wake to publish: %lu ms (WiFi %lu ms)\n", wakeToPublishMs, wakeWifiMs);
     publishStatus();
     
     // Allow MQTT client to transmit the status message before entering wait loop
@@ -1495,6 +1660,9 @@ void setup() {
     // Fall through to setup web server and continue
   }
 
+  // No-op if the deep-sleep path already collected it
+  finishTemperatureConversion();
+
   // Setup web server (only if enabled)
   #if HTTP_SERVER_ENABLED
     setupWebServer();
@@ -1515,6 +1683,14 @@ void setup() {
       publishStatus();
       lastPublishTime = millis();
 
+  #if LIGHT_SLEEP_ENABLED
+    LightSleep::Config sleepConfig;
+    sleepConfig.maxSleepMs = LIGHT_SLEEP_MAX_MS;
+    sleepConfig.keepAliveMs = MQTT_KEEPALIVE_SECONDS * 1000UL;
+    sleepConfig.listenInterval = LIGHT_SLEEP_LISTEN_INTERVAL;
+    LightSleep::begin(sleepConfig);
+  #endif
+
   // Clear crash loop flag after successful boot
   #ifdef ESP32
   clearCrashLoop();
@@ -1527,14 +1703,56 @@ void setup() {
   Serial.println();
 }
 
+#if LIGHT_SLEEP_ENABLED
+// Nap until the next loop() task is due. Runs before the profiled iteration,
+// so naps do not count as stalls.
+void lightSleepUntilNextTask() {
+  uint32_t now = millis();
+  LightSleep::Plan plan(now);
+  plan.every(lastPublishTime, sensorIntervalSeconds * 1000UL);
+  plan.every(lastWiFiCheck, WIFI_CHECK_INTERVAL);
+  plan.every(lastMqttConnectionCheck, MQTT_CONNECTION_CHECK_INTERVAL_MS);
+  plan.every(lastStatusLog, 30000);
+  #ifdef OLED_ENABLED
+    plan.every(lastDisplayUpdate, 1000);
+  #endif
+  if (!mqttClient.connected()) {
+    plan.every(lastMqttReconnectAttempt, MQTT_RECONNECT_INTERVAL_MS);
+  }
+  if (ConfigStore::isDirty()) {
+    plan.every(now, ConfigStore::getCommitDueMs());  // Quiet period, or backoff after a failed write
+  }
+  if (ConfigPortal::isActive()) {
+    plan.busy();  // Portal HTTP/DNS are served from loop()
+  }
+  #if HTTP_SERVER_ENABLED
+    plan.every(lastHttpSnapshot, HTTP_SNAPSHOT_INTERVAL_MS);
+    if (httpSnapshotsStale || pendingDeepSleepSeconds.load() >= 0) {
+      plan.busy();
+    }
+  #endif
+  LightSleep::nap(plan);
+}
+#endif
+
 void loop() {
-  // Handle web requests first for responsiveness
+  #if LIGHT_SLEEP_ENABLED
+    lightSleepUntilNextTask();
+  #endif
+  LoopProfiler::Iteration loopIteration;
+
+  // Web requests are answered by the async server from these snapshots
   #if HTTP_SERVER_ENABLED
-    server.handleClient();
+    applyPendingDeepSleep();
+    updateHttpSnapshots();
   #endif
 
   // Process MQTT messages - detect connection loss early
-  bool mqttLoopResult = mqttClient.loop();
+  bool mqttLoopResult;
+  {
+    LOOP_PROFILE_REGION("mqtt_loop");
+    mqttLoopResult = mqttClient.loop();
+  }
   if (!mqttLoopResult) {
     // loop() returns false if disconnected - log state change immediately
     int currentState = mqttClient.state();
@@ -1547,6 +1765,12 @@ void loop() {
 
   unsigned long now = millis();
 
+  #ifdef ESP32
+  ResetTracker::loop();
+  #endif
+  ConfigStore::loop();
+  handleConfigPortal();
+
   // MQTT connection management
   if ((now - lastMqttConnectionCheck) > MQTT_CONNECTION_CHECK_INTERVAL_MS) {
     lastMqttConnectionCheck = now;
@@ -1558,10 +1782,13 @@ void loop() {
     ensureMqttConnected();
   }
 
-  if (now - lastWiFiCheck > WIFI_CHECK_INTERVAL) {
+  // While the portal runs, WiFiManager owns the radio (AP+STA): no
+  // reconnects or WIFI_STA restarts that would take the AP down
+  if (now - lastWiFiCheck > WIFI_CHECK_INTERVAL && !ConfigPortal::isActive()) {
     lastWiFiCheck = now;
 
     if (WiFi.status() != WL_CONNECTED) {
+      LOOP_PROFILE_REGION("wifi_reconnect");
       Serial.println("WiFi disconnected, attempting reconnection...");
       // Always attempt reconnect - WiFiManager handles credentials
       WiFi.reconnect();
@@ -1593,6 +1820,7 @@ void loop() {
       }
     } else if (wifiDisconnectedSince != 0) {
       // We were disconnected previously and now back online
+      TxPower::apply();
       publishEvent("wifi_reconnected", "WiFi reconnected - SSID: " + WiFi.SSID() + ", IP: " + WiFi.localIP().toString(), "info");
       wifiDisconnectedSince = 0;
     } else {
@@ -1698,6 +1926,7 @@ void loop() {
   // Update OLED display
   #ifdef OLED_ENABLED
     if (millis() - lastDisplayUpdate >= 1000) {
+      LOOP_PROFILE_REGION("display");
       bool wifiConnected = (WiFi.status() == WL_CONNECTED);
       String ipStr = wifiConnected ? WiFi.localIP().toString() : "";
       updateDisplay(temperatureC.c_str(), temperatureF.c_str(), wifiConnected, ipStr.c_str(), metrics.batteryPercent);
@@ -1708,6 +1937,7 @@ void loop() {
   // Handle OTA updates (only when deep sleep is disabled)
   // When deep sleep is enabled, device sleeps and OTA is unavailable
   if (deepSleepSeconds == 0) {
+    LOOP_PROFILE_REGION("ota");
     ArduinoOTA.handle();
   }
   
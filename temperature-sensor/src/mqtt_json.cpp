@@ -0,0 +1,74 @@
+#include "mqtt_json.h"
+
+namespace MqttJson {
+  static uint32_t s_maxPayloadBytes = 0;
+  static uint32_t s_lastPublishUs = 0;
+  static uint32_t s_maxPublishUs = 0;
+  static uint32_t s_failures = 0;
+
+  // ArduinoJson writes one character at a time; collect them so each
+  // client write (a TCP send on the device) carries a full chunk
+  class ChunkedPrint : public Print {
+  public:
+    explicit ChunkedPrint(PubSubClient& client) : _client(client) {}
+
+    size_t write(uint8_t c) override {
+      _buffer[_length++] = c;
+      if (_length == sizeof(_buffer)) {
+        sendChunk();
+      }
+      return 1;
+    }
+
+    size_t write(const uint8_t* data, size_t size) override {
+      for (size_t i = 0; i < size; i++) {
+        write(data[i]);
+      }
+      return size;
+    }
+
+    void sendChunk() {
+      if (_length > 0) {
+        _sent += _client.write(_buffer, _length);
+        _length = 0;
+      }
+    }
+
+    size_t sent() const { return _sent; }
+
+  private:
+    PubSubClient& _client;
+    uint8_t _buffer[MQTT_JSON_CHUNK_SIZE];
+    size_t _length = 0;
+    size_t _sent = 0;
+  };
+
+  bool publish(PubSubClient& client, const char* topic, const JsonDocument& doc, bool retain) {
+    uint32_t start = micros();
+    size_t length = measureJson(doc);
+
+    bool ok = client.beginPublish(topic, length, retain);
+    if (ok) {
+      ChunkedPrint out(client);
+      serializeJson(doc, out);
+      out.sendChunk();
+      // A short write leaves a truncated packet on the wire; the broker drops
+      // the connection and the normal reconnect path takes over
+      ok = client.endPublish() && out.sent() == length;
+    }
+
+    s_lastPublishUs = micros() - start;
+    if (ok) {
+      s_maxPayloadBytes = max(s_maxPayloadBytes, (uint32_t)length);
+      s_maxPublishUs = max(s_maxPublishUs, s_lastPublishUs);
+    } else {
+      s_failures++;
+    }
+    return ok;
+  }
+
+  uint32_t getMaxPayloadBytes() { return s_maxPayloadBytes; }
+  uint32_t getLastPublishUs() { return s_lastPublishUs; }
+  uint32_t getMaxPublishUs() { return s_maxPublishUs; }
+  uint32_t getFailures() { return s_failures; }
+}
@@ -0,0 +1,104 @@
+#include "temperature_payloads.h"
+
+namespace TemperaturePayloads {
+  void buildReading(JsonDocument& doc, const Identity& id, const Reading& reading) {
+    doc["device"] = id.device;
+    doc["chip_id"] = id.chipId;
+    if (!reading.replayed && reading.batteryPercent >= 0) {
+      doc["battery_voltage"] = reading.batteryVoltage;
+      doc["battery_percent"] = reading.batteryPercent;
+    }
+    doc["schema_version"] = 1;
+    doc["timestamp"] = reading.timestamp;
+    doc["celsius"] = reading.celsius;
+    doc["fahrenheit"] = reading.celsius * 1.8f + 32.0f;  // DallasTemperature::toFahrenheit()
+    if (reading.replayed) {
+      doc["replayed"] = true;
+      if (reading.sampleTime > 0) {
+        doc["sample_time"] = reading.sampleTime;  // Line timestamp for the MQTT → InfluxDB bridge
+      }
+    }
+  }
+
+  void buildEvent(JsonDocument& doc, const Identity& id, const Event& event) {
+    doc["device"] = id.device;
+    doc["chip_id"] = id.chipId;
+    doc["firmware_version"] = id.firmwareVersion;
+    doc["schema_version"] = 1;
+    doc["event"] = event.type;
+    doc["severity"] = event.severity;
+    doc["timestamp"] = event.timestamp;
+    doc["uptime_seconds"] = event.uptimeSeconds;
+    doc["free_heap"] = event.freeHeap;
+    if (event.message[0] != '\0') {
+      doc["message"] = event.message;
+    }
+  }
+
+  void buildStatus(JsonDocument& doc, const Identity& id, const Status& status) {
+    doc["device"] = id.device;
+    doc["chip_id"] = id.chipId;
+    doc["firmware_version"] = id.firmwareVersion;
+    doc["schema_version"] = 1;
+    doc["timestamp"] = status.timestamp;
+    doc["uptime_seconds"] = status.uptimeSeconds;
+    doc["wifi_connected"] = status.wifiConnected;
+    doc["wifi_rssi"] = status.wifiRssi;
+    doc["free_heap"] = status.freeHeap;
+    doc["sensor_healthy"] = status.sensorHealthy;
+    doc["wifi_reconnects"] = status.wifiReconnects;
+    doc["sensor_read_failures"] = status.sensorReadFailures;
+    doc["deep_sleep_enabled"] = (status.deepSleepSeconds > 0);
+    doc["deep_sleep_seconds"] = status.deepSleepSeconds;
+    doc["sensor_interval_seconds"] = status.sensorIntervalSeconds;
+    if (status.batteryPercent >= 0) {
+      doc["battery_voltage"] = status.batteryVoltage;
+      doc["battery_percent"] = status.batteryPercent;
+    }
+    doc["loop_max_ms"] = status.loopMaxMs;
+    doc["loop_stalls"] = status.loopStalls;
+    if (status.wakeToPublishMs > 0) {
+      // Deep-sleep wake, ms since boot, measured on whichever flow was built
+      doc["wake_to_publish_ms"] = status.wakeToPublishMs;
+      doc["wake_wifi_ms"] = status.wakeWifiMs;
+      doc["wake_conversion_wait_ms"] = status.wakeConversionWaitMs;
+      doc["wake_flow"] = status.wakeFlow;
+    }
+    if (status.lightSleep) {
+      // Estimated from time asleep; baseline is the same period without naps
+      doc["light_sleep_ratio"] = status.lightSleepRatio;
+      doc["light_sleep_est_ma"] = status.lightSleepEstMa;
+      doc["light_sleep_baseline_ma"] = status.lightSleepBaselineMa;
+    }
+    // Radio energy is estimated from payload airtime and TX current per level
+    doc["tx_power_dbm"] = status.txPowerDbm;
+    doc["tx_power_steps_down"] = status.txPowerStepsDown;
+    doc["tx_power_steps_up"] = status.txPowerStepsUp;
+    doc["tx_energy_per_publish_uj"] = status.txEnergyPerPublishUj;
+    doc["tx_energy_saved_pct"] = status.txEnergySavedPct;
+    if (status.resetReason != nullptr) {
+      doc["reset_reason"] = status.resetReason;
+      doc["boot_count"] = status.bootCount;
+      doc["reset_nvs_writes"] = status.resetNvsWrites;
+      doc["reset_nvs_writes_per_day"] = status.resetNvsWritesPerDay;
+      doc["boot_delay_saved_ms"] = status.bootDelaySavedMs;
+    }
+    doc["config_portal_active"] = status.configPortalActive;
+    doc["config_portal_sessions"] = status.configPortalSessions;
+    doc["config_portal_last_s"] = status.configPortalLastMs / 1000;
+    doc["readings_buffered"] = status.readingsBuffered;
+    doc["readings_replayed"] = status.readingsReplayed;
+    doc["readings_dropped"] = status.readingsDropped;
+    doc["config_commits"] = status.configCommits;
+    JsonArray configSlotWrites = doc["config_slot_writes"].to<JsonArray>();
+    for (uint8_t i = 0; i < Status::CONFIG_SLOTS; i++) {
+      configSlotWrites.add(status.configSlotWrites[i]);
+    }
+    doc["config_commits_boot"] = status.configCommitsBoot;
+    doc["config_coalesced"] = status.configCoalesced;
+    doc["config_commit_failures"] = status.configCommitFailures;
+    doc["config_pending"] = status.configPending;
+    doc["mqtt_payload_max_bytes"] = status.mqttPayloadMaxBytes;
+    doc["mqtt_publish_max_us"] = status.mqttPublishMaxUs;
+  }
+}